@@ -111,3 +111,43 @@ LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
 LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
 
 include $(BUILD_STATIC_LIBRARY)
+
+# Bluetooth bta unit tests for target
+# ========================================================
+ifeq (,$(strip $(SANITIZE_TARGET)))
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+                   $(LOCAL_PATH)/include \
+                   $(LOCAL_PATH)/sys \
+                   $(LOCAL_PATH)/gatt \
+                   $(LOCAL_PATH)/../ \
+                   $(LOCAL_PATH)/../btcore/include \
+                   $(LOCAL_PATH)/../btif/include \
+                   $(LOCAL_PATH)/../hci/include \
+                   $(LOCAL_PATH)/../include \
+                   $(LOCAL_PATH)/../stack/include \
+                   $(LOCAL_PATH)/../stack/btm \
+                   $(LOCAL_PATH)/../udrv/include \
+                   $(LOCAL_PATH)/../utils/include \
+                   $(LOCAL_PATH)/../osi/test \
+                   $(bluetooth_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ../osi/test/AllocationTestHarness.cpp \
+    ./gatt/bta_gattc_cache.c \
+    ./test/bta_test_stubs.cpp \
+    ./test/bta_gattc_cache_test.cpp
+
+LOCAL_MODULE := net_test_bta
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog libcutils
+LOCAL_STATIC_LIBRARIES := libosi
+
+LOCAL_CFLAGS += $(bluetooth_CFLAGS)
+LOCAL_CFLAGS += -DGATT_CACHE_PREFIX=\"/data/local/tmp/net_test_bta_gatt_cache_\"
+LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
+LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
+
+include $(BUILD_NATIVE_TEST)
+endif # SANITIZE_TARGET
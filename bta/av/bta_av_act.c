@@ -73,12 +73,6 @@
 extern fixed_queue_t *btu_bta_alarm_queue;
 
 static void bta_av_accept_signalling_timer_cback(void *data);
-struct blacklist_entry
-{
-    int ver;
-    char addr[3];
-};
-
 
 #ifndef AVRC_MIN_META_CMD_LEN
 #define AVRC_MIN_META_CMD_LEN 20
@@ -1853,58 +1847,6 @@ static void bta_av_accept_signalling_timer_cback(void *data)
     }
 }
 
-BOOLEAN bta_av_check_store_avrc_tg_version(BD_ADDR addr, UINT16 ver)
-{
-    BOOLEAN is_present = FALSE;
-    struct blacklist_entry data;
-    FILE *fp;
-    BOOLEAN is_file_updated = FALSE;
-
-    APPL_TRACE_DEBUG("%s target BD Addr: %x:%x:%x", __func__,\
-                        addr[0], addr[1], addr[2]);
-    fp = fopen(AVRC_PEER_VERSION_CONF_FILE, "rb");
-    if (!fp)
-    {
-      APPL_TRACE_ERROR("%s unable to open AVRC Conf file for read: error: (%s)",\
-                                                        __func__, strerror(errno));
-    }
-    else
-    {
-        while (fread(&data, sizeof(data), 1, fp) != 0)
-        {
-            APPL_TRACE_DEBUG("Entry: addr = %x:%x:%x, ver = 0x%x",\
-                    data.addr[0], data.addr[1], data.addr[2], data.ver);
-            if(!memcmp(addr, data.addr, 3))
-            {
-                is_present = TRUE;
-                APPL_TRACE_DEBUG("Entry alreday present, bailing out");
-                break;
-            }
-        }
-        fclose(fp);
-    }
-
-    if (is_present == FALSE)
-    {
-        fp = fopen(AVRC_PEER_VERSION_CONF_FILE, "ab");
-        if (!fp)
-        {
-            APPL_TRACE_ERROR("%s unable to open AVRC Conf file for write: error: (%s)",\
-                                                              __func__, strerror(errno));
-        }
-        else
-        {
-            data.ver = ver;
-            memcpy(data.addr, (const char *)addr, 3);
-            APPL_TRACE_DEBUG("Avrcp version to store = 0x%x", ver);
-            fwrite(&data, sizeof(data), 1, fp);
-            fclose(fp);
-            is_file_updated = TRUE;
-        }
-    }
-    return is_file_updated;
-}
-
 /*******************************************************************************
 **
 ** Function         bta_av_check_peer_features
@@ -2001,7 +1943,7 @@ tBTA_AV_FEAT bta_av_check_peer_features (UINT16 service_uuid)
             {
                 BOOLEAN ret = FALSE;
                 APPL_TRACE_DEBUG("peer version to update: 0x%x", peer_rc_version);
-                ret = bta_av_check_store_avrc_tg_version(p_rec->remote_bd_addr, peer_rc_version);
+                ret = SDP_StoreAvrcTgVersion(p_rec->remote_bd_addr, peer_rc_version);
                 if (ret == TRUE)
                 {
                     peer_features |= BTA_AV_FEAT_AVRC_UI_UPDATE;
@@ -464,7 +464,7 @@ void BTA_AvProtectRsp(tBTA_AV_HNDL hndl, UINT8 error_code, UINT8 *p_data, UINT16
 void BTA_AvRemoteCmd(UINT8 rc_handle, UINT8 label, tBTA_AV_RC rc_id, tBTA_AV_STATE key_state)
 {
     tBTA_AV_API_REMOTE_CMD *p_buf =
-        (tBTA_AV_API_REMOTE_CMD *)osi_malloc(sizeof(tBTA_AV_API_REMOTE_CMD));
+        (tBTA_AV_API_REMOTE_CMD *)bta_sys_msg_alloc(sizeof(tBTA_AV_API_REMOTE_CMD));
 
     p_buf->hdr.event = BTA_AV_API_REMOTE_CMD_EVT;
     p_buf->hdr.layer_specific = rc_handle;
@@ -493,8 +493,8 @@ void BTA_AvRemoteVendorUniqueCmd(UINT8 rc_handle, UINT8 label,
                                  UINT8 buf_len)
 {
     tBTA_AV_API_REMOTE_CMD *p_buf =
-      (tBTA_AV_API_REMOTE_CMD *)osi_malloc(sizeof(tBTA_AV_API_REMOTE_CMD) +
-                                           buf_len);
+      (tBTA_AV_API_REMOTE_CMD *)bta_sys_msg_alloc(sizeof(tBTA_AV_API_REMOTE_CMD) +
+                                                  buf_len);
 
     p_buf->label = label;
     p_buf->hdr.event = BTA_AV_API_REMOTE_CMD_EVT;
@@ -525,7 +525,7 @@ void BTA_AvRemoteVendorUniqueCmd(UINT8 rc_handle, UINT8 label,
 void BTA_AvVendorCmd(UINT8 rc_handle, UINT8 label, tBTA_AV_CODE cmd_code, UINT8 *p_data, UINT16 len)
 {
     tBTA_AV_API_VENDOR *p_buf =
-        (tBTA_AV_API_VENDOR *)osi_malloc(sizeof(tBTA_AV_API_VENDOR) + len);
+        (tBTA_AV_API_VENDOR *)bta_sys_msg_alloc(sizeof(tBTA_AV_API_VENDOR) + len);
 
     p_buf->hdr.event = BTA_AV_API_VENDOR_CMD_EVT;
     p_buf->hdr.layer_specific   = rc_handle;
@@ -560,7 +560,7 @@ void BTA_AvVendorCmd(UINT8 rc_handle, UINT8 label, tBTA_AV_CODE cmd_code, UINT8
 void BTA_AvVendorRsp(UINT8 rc_handle, UINT8 label, tBTA_AV_CODE rsp_code, UINT8 *p_data, UINT16 len, UINT32 company_id)
 {
     tBTA_AV_API_VENDOR *p_buf =
-        (tBTA_AV_API_VENDOR *)osi_malloc(sizeof(tBTA_AV_API_VENDOR) + len);
+        (tBTA_AV_API_VENDOR *)bta_sys_msg_alloc(sizeof(tBTA_AV_API_VENDOR) + len);
 
     p_buf->hdr.event = BTA_AV_API_VENDOR_RSP_EVT;
     p_buf->hdr.layer_specific   = rc_handle;
@@ -640,7 +640,7 @@ void BTA_AvMetaRsp(UINT8 rc_handle, UINT8 label, tBTA_AV_CODE rsp_code,
                                BT_HDR *p_pkt)
 {
     tBTA_AV_API_META_RSP  *p_buf =
-        (tBTA_AV_API_META_RSP *)osi_malloc(sizeof(tBTA_AV_API_META_RSP));
+        (tBTA_AV_API_META_RSP *)bta_sys_msg_alloc(sizeof(tBTA_AV_API_META_RSP));
 
     p_buf->hdr.event = BTA_AV_API_META_RSP_EVT;
     p_buf->hdr.layer_specific = rc_handle;
@@ -669,7 +669,7 @@ void BTA_AvMetaRsp(UINT8 rc_handle, UINT8 label, tBTA_AV_CODE rsp_code,
 void BTA_AvMetaCmd(UINT8 rc_handle, UINT8 label, tBTA_AV_CMD cmd_code, BT_HDR *p_pkt)
 {
     tBTA_AV_API_META_RSP *p_buf =
-        (tBTA_AV_API_META_RSP *)osi_malloc(sizeof(tBTA_AV_API_META_RSP));
+        (tBTA_AV_API_META_RSP *)bta_sys_msg_alloc(sizeof(tBTA_AV_API_META_RSP));
 
     p_buf->hdr.event = BTA_AV_API_META_RSP_EVT;
     p_buf->hdr.layer_specific   = rc_handle;
@@ -931,6 +931,36 @@ void bta_dm_add_device (tBTA_DM_MSG *p_data)
     }
 }
 
+/*******************************************************************************
+**
+** Function         bta_dm_add_devices
+**
+** Description      This function adds the bonded devices restored from NVRAM
+**                  at host startup to the security database.
+**
+*******************************************************************************/
+void bta_dm_add_devices (tBTA_DM_MSG *p_data)
+{
+    tBTA_DM_API_ADD_DEVICES *p_add = &p_data->add_devs;
+    UINT32  trusted_services_mask[BTM_SEC_SERVICE_ARRAY_SIZE];
+
+    memset (trusted_services_mask, 0, sizeof(trusted_services_mask));
+
+    for (UINT16 i = 0; i < p_add->num_devs; i++)
+    {
+        tBTA_DM_BONDED_DEV *p_dev = &p_add->p_devs[i];
+
+        if (!BTM_SecAddDevice (p_dev->bd_addr, p_dev->dev_class, NULL, NULL,
+                               trusted_services_mask, p_dev->link_key, p_dev->key_type,
+                               0, p_dev->pin_length))
+        {
+            APPL_TRACE_ERROR ("BTA_DM: Error adding device %08x%04x",
+                    (p_dev->bd_addr[0]<<24)+(p_dev->bd_addr[1]<<16)+(p_dev->bd_addr[2]<<8)+p_dev->bd_addr[3],
+                    (p_dev->bd_addr[4]<<8)+p_dev->bd_addr[5]);
+        }
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         bta_dm_close_acl
@@ -4839,6 +4869,22 @@ void bta_dm_ble_observe (tBTA_DM_MSG *p_data)
         BTM_BleObserve(FALSE, 0, p_data->ble_observe.period, NULL, NULL );
     }
 }
+
+/*******************************************************************************
+**
+** Function         bta_dm_ble_set_raw_scan_reports
+**
+** Description      This function turns raw advertising reports on or off for
+**                  a client.
+**
+** Parameters:
+**
+*******************************************************************************/
+void bta_dm_ble_set_raw_scan_reports (tBTA_DM_MSG *p_data)
+{
+    BTM_BleSetRawScanReports(p_data->ble_raw_scan_reports.client_if,
+                             p_data->ble_raw_scan_reports.raw);
+}
 /*******************************************************************************
 **
 ** Function         bta_dm_ble_set_adv_params
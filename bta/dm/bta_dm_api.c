@@ -564,6 +564,35 @@ void BTA_DmAddDevice(BD_ADDR bd_addr, DEV_CLASS dev_class, LINK_KEY link_key,
     bta_sys_sendmsg(p_msg);
 }
 
+/*******************************************************************************
+**
+** Function         BTA_DmAddDevices
+**
+** Description      This function adds bonded devices with their link keys to
+**                  the security database list of peer devices, all in one
+**                  message.
+**
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTA_DmAddDevices(const tBTA_DM_BONDED_DEV *p_devs, UINT16 num_devs)
+{
+    if (num_devs == 0)
+        return;
+
+    tBTA_DM_API_ADD_DEVICES *p_msg =
+        (tBTA_DM_API_ADD_DEVICES *)osi_malloc(sizeof(tBTA_DM_API_ADD_DEVICES) +
+                                              num_devs * sizeof(tBTA_DM_BONDED_DEV));
+
+    p_msg->hdr.event = BTA_DM_API_ADD_DEVICES_EVT;
+    p_msg->num_devs = num_devs;
+    p_msg->p_devs = (tBTA_DM_BONDED_DEV *)(p_msg + 1);
+    memcpy(p_msg->p_devs, p_devs, num_devs * sizeof(tBTA_DM_BONDED_DEV));
+
+    bta_sys_sendmsg(p_msg);
+}
+
 /*******************************************************************************
 **
 ** Function         BTA_DmRemoveDevice
@@ -2038,6 +2067,34 @@ extern void BTA_DmBleObserve(BOOLEAN start, UINT16 duration, UINT16 period,
     bta_sys_sendmsg(p_msg);
 }
 
+/*******************************************************************************
+**
+** Function         BTA_DmBleSetRawScanReports
+**
+** Description      This function asks for every advertising report to be
+**                  delivered to observers instead of only those that carry
+**                  new data, RSSI or a periodic refresh.
+**
+** Parameters       client_if: GATT client interface.
+**                  raw: TRUE to receive every advertising report.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTA_DmBleSetRawScanReports(tGATT_IF client_if, BOOLEAN raw)
+{
+    tBTA_DM_API_BLE_RAW_SCAN_REPORTS *p_msg =
+        (tBTA_DM_API_BLE_RAW_SCAN_REPORTS *)osi_calloc(sizeof(tBTA_DM_API_BLE_RAW_SCAN_REPORTS));
+
+    APPL_TRACE_API("%s: client_if = %d raw = %d", __func__, client_if, raw);
+
+    p_msg->hdr.event = BTA_DM_API_BLE_RAW_SCAN_REPORTS_EVT;
+    p_msg->client_if = client_if;
+    p_msg->raw = raw;
+
+    bta_sys_sendmsg(p_msg);
+}
+
 /*******************************************************************************
 **
 ** Function         BTA_VendorInit
@@ -89,6 +89,7 @@ enum
     BTA_DM_API_BLE_CONN_SCAN_PARAM_EVT,
     BTA_DM_API_BLE_SCAN_PARAM_EVT,
     BTA_DM_API_BLE_OBSERVE_EVT,
+    BTA_DM_API_BLE_RAW_SCAN_REPORTS_EVT,
     BTA_DM_API_UPDATE_CONN_PARAM_EVT,
 #if BLE_PRIVACY_SPT == TRUE
     BTA_DM_API_LOCAL_PRIVACY_EVT,
@@ -126,6 +127,7 @@ enum
     BTA_DM_API_REMOVE_DEVICE_EVT,
     BTA_DM_API_HCI_RAW_COMMAND_EVT,
     BTA_DM_API_VENDOR_SPECIFIC_COMMAND_EVT,
+    BTA_DM_API_ADD_DEVICES_EVT,
     BTA_DM_MAX_EVT
 };
 
@@ -384,6 +386,14 @@ typedef struct
     UINT8               pin_length;
 } tBTA_DM_API_ADD_DEVICE;
 
+/* data type for BTA_DM_API_ADD_DEVICES_EVT */
+typedef struct
+{
+    BT_HDR              hdr;
+    UINT16              num_devs;
+    tBTA_DM_BONDED_DEV  *p_devs;
+} tBTA_DM_API_ADD_DEVICES;
+
 /* data type for BTA_DM_API_REMOVE_ACL_EVT */
 typedef struct
 {
@@ -509,6 +519,14 @@ typedef struct
     tBTA_DM_SEARCH_CBACK * p_cback;
 }tBTA_DM_API_BLE_OBSERVE;
 
+/* Data type for raw advertising reports */
+typedef struct
+{
+    BT_HDR                  hdr;
+    tBTA_GATTC_IF           client_if;
+    BOOLEAN                 raw;
+}tBTA_DM_API_BLE_RAW_SCAN_REPORTS;
+
 typedef struct
 {
     BT_HDR      hdr;
@@ -713,6 +731,8 @@ typedef union
 
     tBTA_DM_API_ADD_DEVICE  add_dev;
 
+    tBTA_DM_API_ADD_DEVICES add_devs;
+
     tBTA_DM_API_REMOVE_DEVICE remove_dev;
 
     tBTA_DM_API_SEARCH search;
@@ -760,6 +780,7 @@ typedef union
     tBTA_DM_API_BLE_CONN_SCAN_PARAMS    ble_set_conn_scan_params;
     tBTA_DM_API_BLE_SCAN_PARAMS         ble_set_scan_params;
     tBTA_DM_API_BLE_OBSERVE             ble_observe;
+    tBTA_DM_API_BLE_RAW_SCAN_REPORTS    ble_raw_scan_reports;
     tBTA_DM_API_ENABLE_PRIVACY          ble_remote_privacy;
     tBTA_DM_API_LOCAL_PRIVACY           ble_local_privacy;
     tBTA_DM_API_BLE_ADV_PARAMS          ble_set_adv_params;
@@ -1146,6 +1167,7 @@ extern void bta_dm_bond_cancel (tBTA_DM_MSG *p_data);
 extern void bta_dm_pin_reply (tBTA_DM_MSG *p_data);
 extern void bta_dm_acl_change(tBTA_DM_MSG *p_data);
 extern void bta_dm_add_device (tBTA_DM_MSG *p_data);
+extern void bta_dm_add_devices (tBTA_DM_MSG *p_data);
 extern void bta_dm_remove_device (tBTA_DM_MSG *p_data);
 extern void bta_dm_close_acl(tBTA_DM_MSG *p_data);
 
@@ -1166,6 +1188,7 @@ extern void bta_dm_ble_set_scan_params(tBTA_DM_MSG *p_data);
 extern void bta_dm_ble_set_conn_scan_params (tBTA_DM_MSG *p_data);
 extern void bta_dm_close_gatt_conn(tBTA_DM_MSG *p_data);
 extern void bta_dm_ble_observe (tBTA_DM_MSG *p_data);
+extern void bta_dm_ble_set_raw_scan_reports (tBTA_DM_MSG *p_data);
 extern void bta_dm_ble_update_conn_params (tBTA_DM_MSG *p_data);
 extern void bta_dm_ble_config_local_privacy (tBTA_DM_MSG *p_data);
 extern void bta_dm_ble_set_adv_params (tBTA_DM_MSG *p_data);
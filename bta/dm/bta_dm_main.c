@@ -87,6 +87,7 @@ const tBTA_DM_ACTION bta_dm_action[] =
     bta_dm_ble_set_conn_scan_params,  /* BTA_DM_API_BLE_CONN_SCAN_PARAM_EVT */
     bta_dm_ble_set_scan_params,  /* BTA_DM_API_BLE_SCAN_PARAM_EVT */
     bta_dm_ble_observe,
+    bta_dm_ble_set_raw_scan_reports, /* BTA_DM_API_BLE_RAW_SCAN_REPORTS_EVT */
     bta_dm_ble_update_conn_params,   /* BTA_DM_API_UPDATE_CONN_PARAM_EVT */
 #if BLE_PRIVACY_SPT == TRUE
     bta_dm_ble_config_local_privacy,   /* BTA_DM_API_LOCAL_PRIVACY_EVT */
@@ -123,6 +124,7 @@ const tBTA_DM_ACTION bta_dm_action[] =
     bta_dm_remove_device,       /* BTA_DM_API_REMOVE_DEVICE_EVT */
     bta_dm_hci_raw_command,    /* BTA_DM_API_HCI_RAW_COMMAND_EVT */
     bta_dm_vendor_spec_command,/* BTA_DM_API_VENDOR_SPECIFIC_COMMAND_EVT */
+    bta_dm_add_devices,        /* BTA_DM_API_ADD_DEVICES_EVT */
 };
 
 
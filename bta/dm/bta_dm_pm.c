@@ -296,9 +296,10 @@ static void bta_dm_pm_start_timer(tBTA_PM_TIMER *p_timer, UINT8 timer_idx,
 
     p_timer->srvc_id[timer_idx] = srvc_id;
 
-    alarm_set_on_queue(p_timer->timer[timer_idx], timeout_ms,
-                       bta_dm_pm_timer_cback, p_timer->timer[timer_idx],
-                       btu_bta_alarm_queue);
+    /* the link only drops to a lower power mode, a late expiry is harmless */
+    alarm_set_on_queue_with_slack(p_timer->timer[timer_idx], timeout_ms,
+                                  BT_IDLE_TIMER_SLACK_MS, bta_dm_pm_timer_cback,
+                                  p_timer->timer[timer_idx], btu_bta_alarm_queue);
 }
 
 /*******************************************************************************
@@ -215,6 +215,9 @@ void bta_gattc_register(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA *p_data)
                 p_cb->cl_rcb[i].p_cback = p_data->api_reg.p_cback;
                 memcpy(&p_cb->cl_rcb[i].app_uuid, p_app_uuid, sizeof(tBT_UUID));
 
+                /* only notifications in notif_reg are forwarded, let GATT drop the rest */
+                GATTC_SetNotifyFilter(p_cb->cl_rcb[i].client_if, TRUE);
+
                 /* BTA use the same client interface as BTE GATT statck */
                 cb_data.reg_oper.client_if = p_cb->cl_rcb[i].client_if;
 
@@ -1044,10 +1047,8 @@ void bta_gattc_disc_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
     if (p_clcb->status != GATT_SUCCESS)
     {
         /* clean up cache */
-        if(p_clcb->p_srcb && p_clcb->p_srcb->p_srvc_cache) {
-            list_free(p_clcb->p_srcb->p_srvc_cache);
-            p_clcb->p_srcb->p_srvc_cache = NULL;
-        }
+        if (p_clcb->p_srcb)
+            bta_gattc_cache_release(p_clcb->p_srcb);
 
         /* used to reset cache in application */
         bta_gattc_cache_reset(p_clcb->p_srcb->server_bda);
@@ -1655,10 +1656,7 @@ void bta_gattc_process_api_refresh(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA * p_msg)
             }
         }
         /* in all other cases, mark it and delete the cache */
-        if (p_srvc_cb->p_srvc_cache != NULL) {
-            list_free(p_srvc_cb->p_srvc_cache);
-            p_srvc_cb->p_srvc_cache = NULL;
-        }
+        bta_gattc_cache_release(p_srvc_cb);
     }
     /* used to reset cache in application */
     bta_gattc_cache_reset(p_msg->api_conn.remote_bda);
@@ -1666,6 +1664,27 @@ void bta_gattc_process_api_refresh(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA * p_msg)
 }
 /*******************************************************************************
 **
+** Function         bta_gattc_process_api_notif_sub
+**
+** Description      add or remove a notification subscription in the GATT
+**                  stack on behalf of BTA_GATTC_(De)RegisterForNotifications.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void bta_gattc_process_api_notif_sub(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA * p_msg)
+{
+    tBTA_GATTC_API_NOTIF_SUB *p_sub = &p_msg->api_notif_sub;
+    UNUSED(p_cb);
+
+    if (p_sub->add)
+        GATTC_AddNotifySubscription(p_sub->client_if, p_sub->remote_bda, p_sub->handle);
+    else
+        GATTC_RemoveNotifySubscription(p_sub->client_if, p_sub->remote_bda,
+                                       p_sub->handle, p_sub->handle);
+}
+/*******************************************************************************
+**
 ** Function         bta_gattc_process_srvc_chg_ind
 **
 ** Description      process service change indication.
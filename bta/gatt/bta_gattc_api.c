@@ -577,6 +577,32 @@ void BTA_GATTC_SendIndConfirm (UINT16 conn_id, UINT16 handle)
     bta_sys_sendmsg(p_buf);
 }
 
+/*******************************************************************************
+**
+** Function         bta_gattc_send_notif_sub
+**
+** Description      Ask the BTU thread to add or remove the GATT notification
+**                  subscription for a client, so it never races the
+**                  notification dispatch in the stack.
+**
+** Returns          None
+**
+*******************************************************************************/
+static void bta_gattc_send_notif_sub(tBTA_GATTC_IF client_if, BD_ADDR bda,
+                                     UINT16 handle, BOOLEAN add)
+{
+    tBTA_GATTC_API_NOTIF_SUB *p_buf =
+        (tBTA_GATTC_API_NOTIF_SUB *)osi_malloc(sizeof(tBTA_GATTC_API_NOTIF_SUB));
+
+    p_buf->hdr.event = BTA_GATTC_API_NOTIF_SUB_EVT;
+    p_buf->client_if = client_if;
+    memcpy(p_buf->remote_bda, bda, BD_ADDR_LEN);
+    p_buf->handle = handle;
+    p_buf->add = add;
+
+    bta_sys_sendmsg(p_buf);
+}
+
 /*******************************************************************************
 **
 ** Function         BTA_GATTC_RegisterForNotifications
@@ -612,6 +638,7 @@ tBTA_GATT_STATUS BTA_GATTC_RegisterForNotifications (tBTA_GATTC_IF client_if,
                   p_clreg->notif_reg[i].handle == handle)
             {
                 APPL_TRACE_WARNING("notification already registered");
+                bta_gattc_send_notif_sub(client_if, bda, handle, TRUE);
                 status = BTA_GATT_OK;
                 break;
             }
@@ -628,6 +655,7 @@ tBTA_GATT_STATUS BTA_GATTC_RegisterForNotifications (tBTA_GATTC_IF client_if,
                     memcpy(p_clreg->notif_reg[i].remote_bda, bda, BD_ADDR_LEN);
 
                     p_clreg->notif_reg[i].handle = handle;
+                    bta_gattc_send_notif_sub(client_if, bda, handle, TRUE);
                     status = BTA_GATT_OK;
                     break;
                 }
@@ -682,6 +710,7 @@ tBTA_GATT_STATUS BTA_GATTC_DeregisterForNotifications (tBTA_GATTC_IF client_if,
             APPL_TRACE_DEBUG("%s deregistered bd_addr:%02x:%02x:%02x:%02x:%02x:%02x",
                 __func__, bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
             memset(&p_clreg->notif_reg[i], 0, sizeof(tBTA_GATTC_NOTIF_REG));
+            bta_gattc_send_notif_sub(client_if, bda, handle, FALSE);
             return BTA_GATT_OK;
         }
     }
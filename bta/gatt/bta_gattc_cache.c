@@ -30,8 +30,12 @@
 #if defined(BTA_GATT_INCLUDED) && (BTA_GATT_INCLUDED == TRUE)
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "bta_gattc_int.h"
 #include "bta_sys.h"
@@ -44,7 +48,6 @@
 #include "sdpdefs.h"
 #include "utl.h"
 
-static void bta_gattc_cache_write(BD_ADDR server_bda, UINT16 num_attr, tBTA_GATTC_NV_ATTR *attr);
 static void bta_gattc_char_dscpt_disc_cmpl(UINT16 conn_id, tBTA_GATTC_SERV *p_srvc_cb);
 static tBTA_GATT_STATUS bta_gattc_sdp_service_disc(UINT16 conn_id, tBTA_GATTC_SERV *p_server_cb);
 extern void bta_to_btif_uuid(bt_uuid_t *p_dest, tBT_UUID *p_src);
@@ -54,8 +57,10 @@ tBTA_GATTC_CHARACTERISTIC*  bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV *p
 
 #define BTA_GATT_SDP_DB_SIZE 4096
 
+#ifndef GATT_CACHE_PREFIX
 #define GATT_CACHE_PREFIX "/data/misc/bluetooth/gatt_cache_"
-#define GATT_CACHE_VERSION 2
+#endif
+#define GATT_CACHE_VERSION 3
 
 static void bta_gattc_generate_cache_file_name(char *buffer, BD_ADDR bda)
 {
@@ -73,6 +78,46 @@ typedef struct
     UINT16              sdp_conn_id;
 } tBTA_GATTC_CB_DATA;
 
+/* NV cache file, mapped read only when loaded:
+**   tBTA_GATTC_NV_HDR
+**   tBTA_GATTC_NV_ATTR        service[num_srvc]
+**   tBTA_GATTC_NV_SRVC_IDX    index[num_srvc]     attribute range of each service
+**   tBTA_GATTC_NV_ATTR        attr[num_attr]      grouped by service
+*/
+typedef struct
+{
+    UINT16      version;
+    UINT16      num_srvc;
+    UINT16      num_attr;
+    BD_ADDR     server_bda;
+    UINT32      hash;       /* FNV-1a of everything following the header */
+} tBTA_GATTC_NV_HDR;
+
+typedef struct
+{
+    UINT16      first_attr;
+    UINT16      num_attr;
+} tBTA_GATTC_NV_SRVC_IDX;
+
+#define BTA_GATTC_NV_SIZE(num_srvc, num_attr) (sizeof(tBTA_GATTC_NV_HDR) + \
+        (num_srvc) * (sizeof(tBTA_GATTC_NV_ATTR) + sizeof(tBTA_GATTC_NV_SRVC_IDX)) + \
+        (num_attr) * sizeof(tBTA_GATTC_NV_ATTR))
+#define BTA_GATTC_NV_SRVC(p_hdr)  ((tBTA_GATTC_NV_ATTR *)((p_hdr) + 1))
+#define BTA_GATTC_NV_IDX(p_hdr)   \
+        ((tBTA_GATTC_NV_SRVC_IDX *)(BTA_GATTC_NV_SRVC(p_hdr) + (p_hdr)->num_srvc))
+#define BTA_GATTC_NV_ATTRS(p_hdr) \
+        ((tBTA_GATTC_NV_ATTR *)(BTA_GATTC_NV_IDX(p_hdr) + (p_hdr)->num_srvc))
+
+static void bta_gattc_cache_write(BD_ADDR server_bda, UINT16 num_srvc,
+                                  tBTA_GATTC_NV_ATTR *p_srvc,
+                                  tBTA_GATTC_NV_SRVC_IDX *p_idx,
+                                  UINT16 num_attr, tBTA_GATTC_NV_ATTR *p_attr);
+static void bta_gattc_cache_fill_service(tBTA_GATTC_SERV *p_srvc_cb,
+                                         tBTA_GATTC_SERVICE *p_svc);
+static void bta_gattc_cache_fill_range(tBTA_GATTC_SERV *p_srvc_cb,
+                                       UINT16 start_handle, UINT16 end_handle);
+static void bta_gattc_cache_unmap(tBTA_GATTC_SERV *p_srvc_cb);
+
 #if (defined BTA_GATT_DEBUG && BTA_GATT_DEBUG == TRUE)
 static char *bta_gattc_attr_type[] =
 {
@@ -171,10 +216,7 @@ static void bta_gattc_display_explore_record(tBTA_GATTC_ATTR_REC *p_rec, UINT8 n
 *******************************************************************************/
 tBTA_GATT_STATUS bta_gattc_init_cache(tBTA_GATTC_SERV *p_srvc_cb)
 {
-    if (p_srvc_cb->p_srvc_cache != NULL) {
-        list_free(p_srvc_cb->p_srvc_cache);
-        p_srvc_cb->p_srvc_cache = NULL;
-    }
+    bta_gattc_cache_release(p_srvc_cb);
 
     osi_free(p_srvc_cb->p_srvc_list);
     p_srvc_cb->p_srvc_list =
@@ -237,11 +279,20 @@ static tBTA_GATT_STATUS bta_gattc_add_srvc_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
     return BTA_GATT_OK;
 }
 
-static tBTA_GATT_STATUS bta_gattc_add_char_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
-                                                    UINT16 attr_handle,
-                                                    UINT16 value_handle,
-                                                    tBT_UUID *p_uuid,
-                                                    UINT8 property)
+/*******************************************************************************
+**
+** Function         bta_gattc_add_char_to_service
+**
+** Description      Add a characteristic into a given service of the database
+**                  cache.
+**
+** Returns          status
+**
+*******************************************************************************/
+static tBTA_GATT_STATUS bta_gattc_add_char_to_service(tBTA_GATTC_SERVICE *service,
+                                                      UINT16 value_handle,
+                                                      tBT_UUID *p_uuid,
+                                                      UINT8 property)
 {
 #if (defined BTA_GATT_DEBUG && BTA_GATT_DEBUG == TRUE)
     APPL_TRACE_DEBUG("%s: Add a characteristic into Service", __func__);
@@ -249,12 +300,6 @@ static tBTA_GATT_STATUS bta_gattc_add_char_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
                       value_handle, p_uuid->uu.uuid16, property);
 #endif
 
-    tBTA_GATTC_SERVICE *service = bta_gattc_find_matching_service(p_srvc_cb->p_srvc_cache, attr_handle);
-    if (!service) {
-        APPL_TRACE_ERROR("Illegal action to add char/descr/incl srvc for non-existing service!");
-        return GATT_WRONG_STATE;
-    }
-
     /* TODO(jpawlowski): We should use attribute handle, not value handle to refer to characteristic.
        This is just a temporary workaround.
     */
@@ -274,21 +319,37 @@ static tBTA_GATT_STATUS bta_gattc_add_char_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
     return BTA_GATT_OK;
 }
 
+static tBTA_GATT_STATUS bta_gattc_add_char_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
+                                                    UINT16 attr_handle,
+                                                    UINT16 value_handle,
+                                                    tBT_UUID *p_uuid,
+                                                    UINT8 property)
+{
+    tBTA_GATTC_SERVICE *service = bta_gattc_find_matching_service(p_srvc_cb->p_srvc_cache, attr_handle);
+    if (!service) {
+        APPL_TRACE_ERROR("Illegal action to add char/descr/incl srvc for non-existing service!");
+        return GATT_WRONG_STATE;
+    }
+
+    return bta_gattc_add_char_to_service(service, value_handle, p_uuid, property);
+}
+
 /*******************************************************************************
 **
-** Function         bta_gattc_add_attr_to_cache
+** Function         bta_gattc_add_attr_to_service
 **
-** Description      Add an attribute into database cache buffer.
+** Description      Add an attribute into a given service of the database cache.
 **
 ** Returns          status
 **
 *******************************************************************************/
-static tBTA_GATT_STATUS bta_gattc_add_attr_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
-                                                    UINT16 handle,
-                                                    tBT_UUID *p_uuid,
-                                                    UINT8 property,
-                                                    UINT16 incl_srvc_s_handle,
-                                                    tBTA_GATTC_ATTR_TYPE type)
+static tBTA_GATT_STATUS bta_gattc_add_attr_to_service(tBTA_GATTC_SERV *p_srvc_cb,
+                                                      tBTA_GATTC_SERVICE *service,
+                                                      UINT16 handle,
+                                                      tBT_UUID *p_uuid,
+                                                      UINT8 property,
+                                                      UINT16 incl_srvc_s_handle,
+                                                      tBTA_GATTC_ATTR_TYPE type)
 {
 #if (defined BTA_GATT_DEBUG && BTA_GATT_DEBUG == TRUE)
     APPL_TRACE_DEBUG("%s: Add a [%s] into Service", __func__, bta_gattc_attr_type[type]);
@@ -296,12 +357,6 @@ static tBTA_GATT_STATUS bta_gattc_add_attr_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
                       handle, p_uuid->uu.uuid16, property, type);
 #endif
 
-    tBTA_GATTC_SERVICE *service = bta_gattc_find_matching_service(p_srvc_cb->p_srvc_cache, handle);
-    if (!service) {
-        APPL_TRACE_ERROR("Illegal action to add char/descr/incl srvc for non-existing service!");
-        return GATT_WRONG_STATE;
-    }
-
     if (type == BTA_GATTC_ATTR_TYPE_INCL_SRVC) {
         tBTA_GATTC_INCLUDED_SVC *isvc =
             osi_malloc(sizeof(tBTA_GATTC_INCLUDED_SVC));
@@ -342,6 +397,32 @@ static tBTA_GATT_STATUS bta_gattc_add_attr_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
     return BTA_GATT_OK;
 }
 
+/*******************************************************************************
+**
+** Function         bta_gattc_add_attr_to_cache
+**
+** Description      Add an attribute into database cache buffer.
+**
+** Returns          status
+**
+*******************************************************************************/
+static tBTA_GATT_STATUS bta_gattc_add_attr_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
+                                                    UINT16 handle,
+                                                    tBT_UUID *p_uuid,
+                                                    UINT8 property,
+                                                    UINT16 incl_srvc_s_handle,
+                                                    tBTA_GATTC_ATTR_TYPE type)
+{
+    tBTA_GATTC_SERVICE *service = bta_gattc_find_matching_service(p_srvc_cb->p_srvc_cache, handle);
+    if (!service) {
+        APPL_TRACE_ERROR("Illegal action to add char/descr/incl srvc for non-existing service!");
+        return GATT_WRONG_STATE;
+    }
+
+    return bta_gattc_add_attr_to_service(p_srvc_cb, service, handle, p_uuid, property,
+                                         incl_srvc_s_handle, type);
+}
+
 /*******************************************************************************
 **
 ** Function         bta_gattc_get_disc_range
@@ -1041,6 +1122,10 @@ const list_t* bta_gattc_get_services(UINT16 conn_id) {
 
     tBTA_GATTC_SERV *p_srcb = p_clcb->p_srcb;
 
+    /* the caller walks the whole database */
+    if (p_srcb)
+        bta_gattc_cache_fill_range(p_srcb, 0x0000, 0xFFFF);
+
     return bta_gattc_get_services_srcb(p_srcb);
 }
 
@@ -1061,14 +1146,21 @@ tBTA_GATTC_SERVICE*  bta_gattc_find_matching_service(const list_t *services, UIN
 
 const tBTA_GATTC_SERVICE*  bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle) {
     const list_t *services = bta_gattc_get_services_srcb(p_srcb);
+    tBTA_GATTC_SERVICE *service = bta_gattc_find_matching_service(services, handle);
+
+    if (service)
+        bta_gattc_cache_fill_service(p_srcb, service);
 
-    return bta_gattc_find_matching_service(services, handle);
+    return service;
 }
 
 const tBTA_GATTC_SERVICE*  bta_gattc_get_service_for_handle(UINT16 conn_id, UINT16 handle) {
-    const list_t *services = bta_gattc_get_services(conn_id);
+    tBTA_GATTC_CLCB *p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+
+    if (p_clcb == NULL )
+        return NULL;
 
-    return bta_gattc_find_matching_service(services, handle);
+    return bta_gattc_get_service_for_handle_srcb(p_clcb->p_srcb, handle);
 }
 
 tBTA_GATTC_CHARACTERISTIC*  bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle) {
@@ -1222,6 +1314,8 @@ static void bta_gattc_get_gatt_db_impl(tBTA_GATTC_SERV *p_srvc_cb,
         return;
     }
 
+    bta_gattc_cache_fill_range(p_srvc_cb, start_handle, end_handle);
+
     size_t db_size = bta_gattc_get_db_size(p_srvc_cb->p_srvc_cache, start_handle, end_handle);
 
     void* buffer = osi_malloc(db_size * sizeof(btgatt_db_element_t));
@@ -1364,8 +1458,7 @@ void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
     /* first attribute loading, initialize buffer */
     APPL_TRACE_ERROR("%s: bta_gattc_rebuild_cache", __func__);
 
-    list_free(p_srvc_cb->p_srvc_cache);
-    p_srvc_cb->p_srvc_cache = NULL;
+    bta_gattc_cache_release(p_srvc_cb);
 
     while (num_attr > 0 && p_attr != NULL)
     {
@@ -1441,15 +1534,24 @@ void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id)
     if (!p_srvc_cb->p_srvc_cache || list_is_empty(p_srvc_cb->p_srvc_cache))
         return;
 
-    int i = 0;
-    size_t db_size = bta_gattc_get_db_size(p_srvc_cb->p_srvc_cache, 0x0000, 0xFFFF);
-    tBTA_GATTC_NV_ATTR *nv_attr = osi_malloc(db_size * sizeof(tBTA_GATTC_NV_ATTR));
+    bta_gattc_cache_fill_range(p_srvc_cb, 0x0000, 0xFFFF);
+
+    size_t num_srvc = list_length(p_srvc_cb->p_srvc_cache);
+    size_t num_attr = bta_gattc_get_db_size(p_srvc_cb->p_srvc_cache, 0x0000, 0xFFFF) - num_srvc;
+    /* zeroed so that structure padding written to NV is deterministic */
+    tBTA_GATTC_NV_ATTR *nv_srvc = osi_calloc(num_srvc * sizeof(tBTA_GATTC_NV_ATTR));
+    tBTA_GATTC_NV_SRVC_IDX *nv_idx = osi_calloc(num_srvc * sizeof(tBTA_GATTC_NV_SRVC_IDX));
+    tBTA_GATTC_NV_ATTR *nv_attr = NULL;
+    int i = 0, j = 0;
+
+    if (num_attr > 0)
+        nv_attr = osi_calloc(num_attr * sizeof(tBTA_GATTC_NV_ATTR));
 
     for (list_node_t *sn = list_begin(p_srvc_cb->p_srvc_cache);
-         sn != list_end(p_srvc_cb->p_srvc_cache); sn = list_next(sn)) {
+         sn != list_end(p_srvc_cb->p_srvc_cache); sn = list_next(sn), i++) {
         tBTA_GATTC_SERVICE *p_cur_srvc = list_node(sn);
 
-        bta_gattc_fill_nv_attr(&nv_attr[i++],
+        bta_gattc_fill_nv_attr(&nv_srvc[i],
                                 BTA_GATTC_ATTR_TYPE_SRVC,
                                p_cur_srvc->s_handle,
                                p_cur_srvc->e_handle,
@@ -1457,73 +1559,239 @@ void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id)
                                0 /* properties */,
                                0 /* incl_srvc_handle */,
                                p_cur_srvc->is_primary);
-    }
-
-    for (list_node_t *sn = list_begin(p_srvc_cb->p_srvc_cache);
-         sn != list_end(p_srvc_cb->p_srvc_cache); sn = list_next(sn)) {
-        tBTA_GATTC_SERVICE *p_cur_srvc = list_node(sn);
 
-        if (!p_cur_srvc->characteristics || list_is_empty(p_cur_srvc->characteristics))
-            continue;
+        nv_idx[i].first_attr = j;
 
-        for (list_node_t *cn = list_begin(p_cur_srvc->characteristics);
-             cn != list_end(p_cur_srvc->characteristics); cn = list_next(cn)) {
-            tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
+        if (p_cur_srvc->characteristics) {
+            for (list_node_t *cn = list_begin(p_cur_srvc->characteristics);
+                 cn != list_end(p_cur_srvc->characteristics); cn = list_next(cn)) {
+                tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
 
-            bta_gattc_fill_nv_attr(&nv_attr[i++],
-                                   BTA_GATTC_ATTR_TYPE_CHAR,
-                                   p_char->handle,
-                                   0,
-                                   p_char->uuid,
-                                   p_char->properties,
-                                   0 /* incl_srvc_handle */,
-                                   FALSE);
+                bta_gattc_fill_nv_attr(&nv_attr[j++],
+                                       BTA_GATTC_ATTR_TYPE_CHAR,
+                                       p_char->handle,
+                                       0,
+                                       p_char->uuid,
+                                       p_char->properties,
+                                       0 /* incl_srvc_handle */,
+                                       FALSE);
 
-            if (!p_char->descriptors || list_is_empty(p_char->descriptors))
-                continue;
+                if (!p_char->descriptors || list_is_empty(p_char->descriptors))
+                    continue;
+
+                for (list_node_t *dn = list_begin(p_char->descriptors);
+                     dn != list_end(p_char->descriptors); dn = list_next(dn)) {
+                    tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
+
+                    bta_gattc_fill_nv_attr(&nv_attr[j++],
+                                           BTA_GATTC_ATTR_TYPE_CHAR_DESCR,
+                                           p_desc->handle,
+                                           0,
+                                           p_desc->uuid,
+                                           0 /* properties */,
+                                           0 /* incl_srvc_handle */,
+                                           FALSE);
+                }
+            }
+        }
 
-            for (list_node_t *dn = list_begin(p_char->descriptors);
-                 dn != list_end(p_char->descriptors); dn = list_next(dn)) {
-                tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
+        if (p_cur_srvc->included_svc) {
+            for (list_node_t *an = list_begin(p_cur_srvc->included_svc);
+                 an != list_end(p_cur_srvc->included_svc); an = list_next(an)) {
+                tBTA_GATTC_INCLUDED_SVC *p_isvc = list_node(an);
 
-                bta_gattc_fill_nv_attr(&nv_attr[i++],
-                                       BTA_GATTC_ATTR_TYPE_CHAR_DESCR,
-                                       p_desc->handle,
+                bta_gattc_fill_nv_attr(&nv_attr[j++],
+                                       BTA_GATTC_ATTR_TYPE_INCL_SRVC,
+                                       p_isvc->handle,
                                        0,
-                                       p_desc->uuid,
+                                       p_isvc->uuid,
                                        0 /* properties */,
-                                       0 /* incl_srvc_handle */,
+                                       p_isvc->included_service->s_handle,
                                        FALSE);
             }
         }
 
-        if (!p_cur_srvc->included_svc || list_is_empty(p_cur_srvc->included_svc))
+        nv_idx[i].num_attr = j - nv_idx[i].first_attr;
+    }
+
+    bta_gattc_cache_write(p_srvc_cb->server_bda, num_srvc, nv_srvc, nv_idx, num_attr, nv_attr);
+    osi_free(nv_srvc);
+    osi_free(nv_idx);
+    osi_free(nv_attr);
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_cache_hash
+**
+** Description      FNV-1a hash of the NV cache content following the header.
+**
+** Returns          hash value.
+**
+*******************************************************************************/
+static UINT32 bta_gattc_cache_hash(const UINT8 *p_data, size_t len)
+{
+    UINT32 hash = 2166136261u;
+
+    while (len--) {
+        hash ^= *p_data++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_cache_validate
+**
+** Description      Check that a mapped NV cache is complete, belongs to the
+**                  server and was not altered since it was written.
+**
+** Returns          true if the cache can be used.
+**
+*******************************************************************************/
+static bool bta_gattc_cache_validate(const void *p_map, size_t len, BD_ADDR server_bda)
+{
+    const tBTA_GATTC_NV_HDR *p_hdr = p_map;
+
+    if (len < sizeof(tBTA_GATTC_NV_HDR) || p_hdr->version != GATT_CACHE_VERSION)
+        return false;
+
+    if (len != BTA_GATTC_NV_SIZE(p_hdr->num_srvc, p_hdr->num_attr) ||
+        bdcmp(p_hdr->server_bda, server_bda) != 0)
+        return false;
+
+    if (p_hdr->hash != bta_gattc_cache_hash((const UINT8 *)(p_hdr + 1),
+                                            len - sizeof(tBTA_GATTC_NV_HDR)))
+        return false;
+
+    const tBTA_GATTC_NV_SRVC_IDX *p_idx = BTA_GATTC_NV_IDX(p_hdr);
+    for (UINT16 i = 0; i < p_hdr->num_srvc; i++) {
+        if (p_idx[i].first_attr + p_idx[i].num_attr > p_hdr->num_attr)
+            return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_cache_fill_service
+**
+** Description      Fill in characteristics, descriptors and included services
+**                  of a service loaded from the mapped NV cache.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void bta_gattc_cache_fill_service(tBTA_GATTC_SERV *p_srvc_cb,
+                                         tBTA_GATTC_SERVICE *p_svc)
+{
+    if (p_svc->characteristics != NULL || p_srvc_cb->p_nv_map == NULL)
+        return;
+
+    const tBTA_GATTC_NV_HDR *p_hdr = p_srvc_cb->p_nv_map;
+    const tBTA_GATTC_NV_ATTR *p_nv_srvc = BTA_GATTC_NV_SRVC(p_hdr);
+    const tBTA_GATTC_NV_SRVC_IDX *p_idx = BTA_GATTC_NV_IDX(p_hdr);
+    const tBTA_GATTC_NV_ATTR *p_attr = BTA_GATTC_NV_ATTRS(p_hdr);
+
+    p_svc->characteristics = list_new(characteristic_free);
+    p_svc->included_svc = list_new(osi_free);
+
+    for (UINT16 i = 0; i < p_hdr->num_srvc; i++) {
+        if (p_nv_srvc[i].s_handle != p_svc->s_handle)
             continue;
 
-        for (list_node_t *an = list_begin(p_cur_srvc->included_svc);
-             an != list_end(p_cur_srvc->included_svc); an = list_next(an)) {
-            tBTA_GATTC_INCLUDED_SVC *p_isvc = list_node(an);
-
-            bta_gattc_fill_nv_attr(&nv_attr[i++],
-                                   BTA_GATTC_ATTR_TYPE_INCL_SRVC,
-                                   p_isvc->handle,
-                                   0,
-                                   p_isvc->uuid,
-                                   0 /* properties */,
-                                   p_isvc->included_service->s_handle,
-                                   FALSE);
+        for (UINT16 j = p_idx[i].first_attr;
+             j < p_idx[i].first_attr + p_idx[i].num_attr; j++) {
+            tBT_UUID uuid = p_attr[j].uuid;
+
+            /* Add to |p_svc| itself: with overlapping ranges a lookup by
+               handle could return a service that is not filled in yet. */
+            if (p_attr[j].attr_type == BTA_GATTC_ATTR_TYPE_CHAR)
+                bta_gattc_add_char_to_service(p_svc, p_attr[j].s_handle, &uuid,
+                                              p_attr[j].prop);
+            else
+                bta_gattc_add_attr_to_service(p_srvc_cb, p_svc, p_attr[j].s_handle, &uuid,
+                                              p_attr[j].prop, p_attr[j].incl_srvc_handle,
+                                              p_attr[j].attr_type);
         }
+        break;
     }
 
-    bta_gattc_cache_write(p_srvc_cb->server_bda, db_size, nv_attr);
-    osi_free(nv_attr);
+    /* everything is in memory now, the mapping is no longer needed */
+    if (--p_srvc_cb->nv_pending == 0)
+        bta_gattc_cache_unmap(p_srvc_cb);
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_cache_fill_range
+**
+** Description      Fill in all services in a handle range that are still only
+**                  present in the mapped NV cache.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void bta_gattc_cache_fill_range(tBTA_GATTC_SERV *p_srvc_cb,
+                                       UINT16 start_handle, UINT16 end_handle)
+{
+    if (p_srvc_cb->p_nv_map == NULL || p_srvc_cb->p_srvc_cache == NULL)
+        return;
+
+    for (list_node_t *sn = list_begin(p_srvc_cb->p_srvc_cache);
+         sn != list_end(p_srvc_cb->p_srvc_cache) && p_srvc_cb->p_nv_map != NULL;
+         sn = list_next(sn)) {
+        tBTA_GATTC_SERVICE *p_svc = list_node(sn);
+
+        if (p_svc->e_handle >= start_handle && p_svc->s_handle <= end_handle)
+            bta_gattc_cache_fill_service(p_srvc_cb, p_svc);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_cache_unmap
+**
+** Description      Drop the mapped NV cache of a server.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void bta_gattc_cache_unmap(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    if (p_srvc_cb->p_nv_map != NULL)
+        munmap(p_srvc_cb->p_nv_map, p_srvc_cb->nv_map_len);
+
+    p_srvc_cb->p_nv_map = NULL;
+    p_srvc_cb->nv_map_len = 0;
+    p_srvc_cb->nv_pending = 0;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_cache_release
+**
+** Description      Free the in memory server cache and its NV cache mapping.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void bta_gattc_cache_release(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    list_free(p_srvc_cb->p_srvc_cache);
+    p_srvc_cb->p_srvc_cache = NULL;
+    bta_gattc_cache_unmap(p_srvc_cb);
 }
 
 /*******************************************************************************
 **
 ** Function         bta_gattc_cache_load
 **
-** Description      Load GATT cache from storage for server.
+** Description      Load GATT cache from storage for server. The file is mapped
+**                  and only the service list is built; the rest of a service
+**                  is filled in when it is first looked up.
 **
 ** Parameter        p_clcb: pointer to server clcb, that will
 **                          be filled from storage
@@ -1532,52 +1800,59 @@ void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id)
 *******************************************************************************/
 bool bta_gattc_cache_load(tBTA_GATTC_CLCB *p_clcb)
 {
+    tBTA_GATTC_SERV *p_srcb = p_clcb->p_srcb;
     char fname[255] = {0};
-    bta_gattc_generate_cache_file_name(fname, p_clcb->p_srcb->server_bda);
+    bta_gattc_generate_cache_file_name(fname, p_srcb->server_bda);
 
-    FILE *fd = fopen(fname, "rb");
-    if (!fd) {
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) {
         APPL_TRACE_ERROR("%s: can't open GATT cache file %s for reading, error: %s",
                          __func__, fname, strerror(errno));
         return false;
     }
 
-    UINT16 cache_ver = 0;
-    tBTA_GATTC_NV_ATTR  *attr = NULL;
-    bool success = false;
+    struct stat st;
+    void *p_map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(tBTA_GATTC_NV_HDR))
+        p_map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
 
-    if (fread(&cache_ver, sizeof(UINT16), 1, fd) != 1) {
-        APPL_TRACE_ERROR("%s: can't read GATT cache version from: %s", __func__, fname);
-        goto done;
+    if (p_map == MAP_FAILED) {
+        APPL_TRACE_ERROR("%s: can't map GATT cache file: %s", __func__, fname);
+        return false;
     }
 
-    if (cache_ver != GATT_CACHE_VERSION) {
-        APPL_TRACE_ERROR("%s: wrong GATT cache version: %s", __func__, fname);
-        goto done;
+    if (!bta_gattc_cache_validate(p_map, st.st_size, p_srcb->server_bda)) {
+        APPL_TRACE_ERROR("%s: invalid or stale GATT cache: %s", __func__, fname);
+        munmap(p_map, st.st_size);
+        return false;
     }
 
-    UINT16 num_attr = 0;
+    bta_gattc_cache_release(p_srcb);
 
-    if (fread(&num_attr, sizeof(UINT16), 1, fd) != 1) {
-        APPL_TRACE_ERROR("%s: can't read number of GATT attributes: %s", __func__, fname);
-        goto done;
-    }
+    const tBTA_GATTC_NV_HDR *p_hdr = p_map;
+    const tBTA_GATTC_NV_ATTR *p_nv_srvc = BTA_GATTC_NV_SRVC(p_hdr);
 
-    attr = osi_malloc(sizeof(tBTA_GATTC_NV_ATTR) * num_attr);
+    p_srcb->p_srvc_cache = list_new(service_free);
+    for (UINT16 i = 0; i < p_hdr->num_srvc; i++) {
+        tBTA_GATTC_SERVICE *p_svc = osi_calloc(sizeof(tBTA_GATTC_SERVICE));
 
-    if (fread(attr, sizeof(tBTA_GATTC_NV_ATTR), 0xFF, fd) != num_attr) {
-        APPL_TRACE_ERROR("%s: can't read GATT attributes: %s", __func__, fname);
-        goto done;
+        /* characteristics stay NULL until the service is filled in */
+        p_svc->s_handle = p_nv_srvc[i].s_handle;
+        p_svc->e_handle = p_nv_srvc[i].e_handle;
+        p_svc->is_primary = p_nv_srvc[i].is_primary;
+        p_svc->uuid = p_nv_srvc[i].uuid;
+        p_svc->handle = p_nv_srvc[i].s_handle;
+        list_append(p_srcb->p_srvc_cache, p_svc);
     }
 
-    bta_gattc_rebuild_cache(p_clcb->p_srcb, num_attr, attr);
-
-    success = true;
+    p_srcb->p_nv_map = p_map;
+    p_srcb->nv_map_len = st.st_size;
+    p_srcb->nv_pending = p_hdr->num_srvc;
+    if (p_srcb->nv_pending == 0)
+        bta_gattc_cache_unmap(p_srcb);
 
-done:
-    osi_free(attr);
-    fclose(fd);
-    return success;
+    return true;
 }
 
 /*******************************************************************************
@@ -1585,46 +1860,65 @@ done:
 ** Function         bta_gattc_cache_write
 **
 ** Description      This callout function is executed by GATT when a server cache
-**                  is available to save.
+**                  is available to save. The file is written under a temporary
+**                  name and renamed, so a mapping of the previous file stays
+**                  valid.
 **
 ** Parameter        server_bda: server bd address of this cache belongs to
-**                  num_attr: number of attribute to be save.
-**                  attr: pointer to the list of attributes to save.
+**                  num_srvc: number of services to be saved.
+**                  p_srvc: service attributes.
+**                  p_idx: attribute range of each service in p_attr.
+**                  num_attr: number of other attributes to be saved.
+**                  p_attr: pointer to the list of attributes to save.
 ** Returns
 **
 *******************************************************************************/
-static void bta_gattc_cache_write(BD_ADDR server_bda, UINT16 num_attr,
-                           tBTA_GATTC_NV_ATTR *attr)
+static void bta_gattc_cache_write(BD_ADDR server_bda, UINT16 num_srvc,
+                                  tBTA_GATTC_NV_ATTR *p_srvc,
+                                  tBTA_GATTC_NV_SRVC_IDX *p_idx,
+                                  UINT16 num_attr, tBTA_GATTC_NV_ATTR *p_attr)
 {
     char fname[255] = {0};
+    char tmp_fname[260] = {0};
     bta_gattc_generate_cache_file_name(fname, server_bda);
-
-    FILE *fd = fopen(fname, "wb");
+    snprintf(tmp_fname, sizeof(tmp_fname), "%s.new", fname);
+
+    size_t len = BTA_GATTC_NV_SIZE(num_srvc, num_attr);
+    UINT8 *p_buf = osi_calloc(len);
+    tBTA_GATTC_NV_HDR *p_hdr = (tBTA_GATTC_NV_HDR *)p_buf;
+
+    p_hdr->version = GATT_CACHE_VERSION;
+    p_hdr->num_srvc = num_srvc;
+    p_hdr->num_attr = num_attr;
+    bdcpy(p_hdr->server_bda, server_bda);
+    memcpy(BTA_GATTC_NV_SRVC(p_hdr), p_srvc, num_srvc * sizeof(tBTA_GATTC_NV_ATTR));
+    memcpy(BTA_GATTC_NV_IDX(p_hdr), p_idx, num_srvc * sizeof(tBTA_GATTC_NV_SRVC_IDX));
+    if (num_attr > 0)
+        memcpy(BTA_GATTC_NV_ATTRS(p_hdr), p_attr, num_attr * sizeof(tBTA_GATTC_NV_ATTR));
+    p_hdr->hash = bta_gattc_cache_hash((const UINT8 *)(p_hdr + 1),
+                                       len - sizeof(tBTA_GATTC_NV_HDR));
+
+    FILE *fd = fopen(tmp_fname, "wb");
     if (!fd) {
-        APPL_TRACE_ERROR("%s: can't open GATT cache file for writing: %s", __func__, fname);
+        APPL_TRACE_ERROR("%s: can't open GATT cache file for writing: %s", __func__, tmp_fname);
+        osi_free(p_buf);
         return;
     }
 
-    UINT16 cache_ver = GATT_CACHE_VERSION;
-    if (fwrite(&cache_ver, sizeof(UINT16), 1, fd) != 1) {
-        APPL_TRACE_ERROR("%s: can't write GATT cache version: %s", __func__, fname);
-        fclose(fd);
-        return;
-    }
+    bool written = (fwrite(p_buf, len, 1, fd) == 1);
+    osi_free(p_buf);
 
-    if (fwrite(&num_attr, sizeof(UINT16), 1, fd) != 1) {
-        APPL_TRACE_ERROR("%s: can't write GATT cache attribute count: %s", __func__, fname);
-        fclose(fd);
+    if (fclose(fd) != 0 || !written) {
+        APPL_TRACE_ERROR("%s: can't write GATT cache: %s", __func__, tmp_fname);
+        unlink(tmp_fname);
         return;
     }
 
-    if (fwrite(attr, sizeof(tBTA_GATTC_NV_ATTR), num_attr, fd) != num_attr) {
-        APPL_TRACE_ERROR("%s: can't write GATT cache attributes: %s", __func__, fname);
-        fclose(fd);
-        return;
+    if (rename(tmp_fname, fname) != 0) {
+        APPL_TRACE_ERROR("%s: can't rename GATT cache %s: %s", __func__, tmp_fname,
+                         strerror(errno));
+        unlink(tmp_fname);
     }
-
-    fclose(fd);
 }
 
 /*******************************************************************************
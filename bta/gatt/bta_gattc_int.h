@@ -66,7 +66,8 @@ enum
     BTA_GATTC_API_LISTEN_EVT,
     BTA_GATTC_API_BROADCAST_EVT,
     BTA_GATTC_API_DISABLE_EVT,
-    BTA_GATTC_ENC_CMPL_EVT
+    BTA_GATTC_ENC_CMPL_EVT,
+    BTA_GATTC_API_NOTIF_SUB_EVT
 };
 typedef UINT16 tBTA_GATTC_INT_EVT;
 
@@ -194,6 +195,15 @@ typedef struct
     UINT16              mtu;
 }tBTA_GATTC_API_CFG_MTU;
 
+typedef struct
+{
+    BT_HDR                  hdr;
+    BD_ADDR                 remote_bda;
+    tBTA_GATTC_IF           client_if;
+    UINT16                  handle;
+    BOOLEAN                 add;
+}tBTA_GATTC_API_NOTIF_SUB;
+
 typedef struct
 {
     BT_HDR                  hdr;
@@ -234,6 +244,8 @@ typedef union
     /* if peripheral role is supported */
     tBTA_GATTC_API_LISTEN       api_listen;
 
+    tBTA_GATTC_API_NOTIF_SUB    api_notif_sub;
+
 } tBTA_GATTC_DATA;
 
 
@@ -297,6 +309,10 @@ typedef struct
     UINT16              attr_index;     /* cahce NV saving/loading attribute index */
 
     UINT16              mtu;
+
+    void                *p_nv_map;      /* mapped NV cache, services are filled in on first use */
+    size_t              nv_map_len;
+    UINT16              nv_pending;     /* services not yet filled in from p_nv_map */
 } tBTA_GATTC_SERV;
 
 #ifndef BTA_GATTC_NOTIF_REG_MAX
@@ -453,6 +469,7 @@ extern void bta_gattc_cancel_bk_conn(tBTA_GATTC_API_CANCEL_OPEN *p_data);
 extern void bta_gattc_send_open_cback( tBTA_GATTC_RCB *p_clreg, tBTA_GATT_STATUS status,
                                        BD_ADDR remote_bda, UINT16 conn_id, tBTA_TRANSPORT transport,  UINT16 mtu);
 extern void bta_gattc_process_api_refresh(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA * p_msg);
+extern void bta_gattc_process_api_notif_sub(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA * p_msg);
 extern void bta_gattc_cfg_mtu(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data);
 #if BLE_INCLUDED == TRUE
 extern void bta_gattc_listen(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA * p_msg);
@@ -506,5 +523,6 @@ extern BOOLEAN bta_gattc_conn_dealloc(BD_ADDR remote_bda);
 
 extern bool bta_gattc_cache_load(tBTA_GATTC_CLCB *p_clcb);
 extern void bta_gattc_cache_reset(BD_ADDR server_bda);
+extern void bta_gattc_cache_release(tBTA_GATTC_SERV *p_srvc_cb);
 
 #endif /* BTA_GATTC_INT_H */
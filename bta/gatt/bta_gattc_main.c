@@ -381,6 +381,10 @@ BOOLEAN bta_gattc_hdl_event(BT_HDR *p_msg)
             bta_gattc_process_enc_cmpl(p_cb, (tBTA_GATTC_DATA *) p_msg);
             break;
 
+        case BTA_GATTC_API_NOTIF_SUB_EVT:
+            bta_gattc_process_api_notif_sub(p_cb, (tBTA_GATTC_DATA *) p_msg);
+            break;
+
         default:
             if (p_msg->event == BTA_GATTC_INT_CONN_EVT)
                 p_clcb = bta_gattc_find_int_conn_clcb((tBTA_GATTC_DATA *) p_msg);
@@ -470,6 +474,8 @@ static char *gattc_evt_code(tBTA_GATTC_INT_EVT evt_code)
             return "BTA_GATTC_API_DISABLE_EVT";
         case BTA_GATTC_API_CFG_MTU_EVT:
             return "BTA_GATTC_API_CFG_MTU_EVT";
+        case BTA_GATTC_API_NOTIF_SUB_EVT:
+            return "BTA_GATTC_API_NOTIF_SUB_EVT";
         default:
             return "unknown GATTC event code";
     }
@@ -304,10 +304,7 @@ void bta_gattc_clcb_dealloc(tBTA_GATTC_CLCB *p_clcb)
             p_srcb->mtu = 0;
 
             /* clean up cache */
-            if (p_srcb->p_srvc_cache) {
-                list_free(p_srcb->p_srvc_cache);
-                p_srcb->p_srvc_cache = NULL;
-            }
+            bta_gattc_cache_release(p_srcb);
         }
 
         osi_free_and_reset((void **)&p_clcb->p_q_cmd);
@@ -415,8 +412,7 @@ tBTA_GATTC_SERV * bta_gattc_srcb_alloc(BD_ADDR bda)
 
     if (p_tcb != NULL)
     {
-        if (p_tcb->p_srvc_cache != NULL)
-            list_free(p_tcb->p_srvc_cache);
+        bta_gattc_cache_release(p_tcb);
 
         osi_free_and_reset((void **)&p_tcb->p_srvc_list);
         memset(p_tcb, 0 , sizeof(tBTA_GATTC_SERV));
@@ -499,6 +495,7 @@ void bta_gattc_clear_notif_reg_on_disc(tBTA_GATTC_RCB *p_clreg, BD_ADDR bda) {
             memset(&p_clreg->notif_reg[i], 0, sizeof(tBTA_GATTC_NOTIF_REG));
         }
     }
+    GATTC_RemoveNotifySubscription(p_clreg->client_if, bda, 0x0001, 0xFFFF);
 }
 
 /*******************************************************************************
@@ -536,6 +533,7 @@ void bta_gattc_clear_notif_registration(tBTA_GATTC_SERV *p_srcb, UINT16 conn_id,
                     if (handle >= start_handle && handle <= end_handle)
                         memset(&p_clrcb->notif_reg[i], 0, sizeof(tBTA_GATTC_NOTIF_REG));
             }
+            GATTC_RemoveNotifySubscription(gatt_if, remote_bda, start_handle, end_handle);
         }
     } else {
         APPL_TRACE_ERROR("can not clear indication/notif registration for unknown app");
@@ -668,6 +668,68 @@ void bta_gatts_indicate_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
     }
 }
 
+/*******************************************************************************
+**
+** Function         bta_gatts_notify_multi_handle
+**
+** Description      GATTS send one handle value notification to a set of
+**                  connections.
+**
+** Returns          none.
+**
+*******************************************************************************/
+void bta_gatts_notify_multi_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
+{
+    tBTA_GATTS_API_NOTIFY_MULTI *p_api = &p_msg->api_notify_multi;
+    tBTA_GATTS_SRVC_CB  *p_srvc_cb;
+    tBTA_GATTS_RCB      *p_rcb;
+    tGATT_STATUS        status[GATT_MAX_PHY_CHANNEL];
+    tGATT_IF            gatt_if;
+    BD_ADDR             remote_bda;
+    tBTA_TRANSPORT      transport;
+    tBTA_GATTS          cb_data;
+    UINT8               i;
+
+    p_srvc_cb = bta_gatts_find_srvc_cb_by_attr_id (p_cb, p_api->attr_id);
+
+    if (p_srvc_cb == NULL)
+    {
+        APPL_TRACE_ERROR("Not an registered servce attribute ID: 0x%04x", p_api->attr_id);
+        return;
+    }
+
+    for (i = 0; i < p_api->num_conn; i ++)
+        status[i] = GATT_ILLEGAL_PARAMETER;
+
+    GATTS_HandleValueNotificationMulti (p_api->num_conn, p_api->conn_id, p_api->attr_id,
+                                        p_api->len, p_api->value, status);
+
+    for (i = 0; i < p_api->num_conn; i ++)
+    {
+        if (!GATT_GetConnectionInfor(p_api->conn_id[i], &gatt_if, remote_bda, &transport))
+        {
+            APPL_TRACE_ERROR("Unknown connection ID: %d fail sending notification",
+                              p_api->conn_id[i]);
+            continue;
+        }
+
+        /* if over BR_EDR, inform PM for mode change */
+        if (transport == BTA_TRANSPORT_BR_EDR)
+        {
+            bta_sys_busy(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+            bta_sys_idle(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+        }
+
+        p_rcb = bta_gatts_find_app_rcb_by_app_if(gatt_if);
+        if (p_rcb && p_cb->rcb[p_srvc_cb->rcb_idx].p_cback)
+        {
+            cb_data.req_data.status = status[i];
+            cb_data.req_data.conn_id = p_api->conn_id[i];
+
+            (*p_rcb->p_cback)(BTA_GATTS_CONF_EVT, &cb_data);
+        }
+    }
+}
 
 /*******************************************************************************
 **
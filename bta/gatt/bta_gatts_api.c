@@ -346,6 +346,52 @@ void BTA_GATTS_HandleValueIndication (UINT16 conn_id, UINT16 attr_id, UINT16 dat
     bta_sys_sendmsg(p_buf);
 }
 
+/*******************************************************************************
+**
+** Function         BTA_GATTS_HandleValueNotificationMulti
+**
+** Description      This function is called to send the same notification to
+**                  several connections at once.
+**
+** Parameters       num_conn - number of connection identifiers in p_conn_id.
+**                  p_conn_id - connection identifiers to notify.
+**                  attr_id - attribute ID to notify.
+**                  data_len - notify data length.
+**                  p_data: data to notify.
+**
+** Returns          None
+**
+*******************************************************************************/
+void BTA_GATTS_HandleValueNotificationMulti (UINT8 num_conn, UINT16 *p_conn_id,
+                                             UINT16 attr_id, UINT16 data_len,
+                                             UINT8 *p_data)
+{
+    tBTA_GATTS_API_NOTIFY_MULTI *p_buf;
+
+    if (num_conn == 0 || p_conn_id == NULL)
+        return;
+
+    if (num_conn > GATT_MAX_PHY_CHANNEL)
+    {
+        APPL_TRACE_WARNING("%s: %d connections requested, only %d notified",
+                           __func__, num_conn, GATT_MAX_PHY_CHANNEL);
+        num_conn = GATT_MAX_PHY_CHANNEL;
+    }
+
+    p_buf = (tBTA_GATTS_API_NOTIFY_MULTI *)osi_calloc(sizeof(tBTA_GATTS_API_NOTIFY_MULTI));
+
+    p_buf->hdr.event = BTA_GATTS_API_NOTIFY_MULTI_EVT;
+    p_buf->attr_id = attr_id;
+    p_buf->num_conn = num_conn;
+    memcpy(p_buf->conn_id, p_conn_id, num_conn * sizeof(UINT16));
+    if (data_len > 0 && p_data != NULL) {
+        p_buf->len = (data_len > BTA_GATT_MAX_ATTR_LEN) ? BTA_GATT_MAX_ATTR_LEN : data_len;
+        memcpy(p_buf->value, p_data, p_buf->len);
+    }
+
+    bta_sys_sendmsg(p_buf);
+}
+
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_SendRsp
@@ -41,6 +41,7 @@ enum
     BTA_GATTS_API_DEREG_EVT,
     BTA_GATTS_API_CREATE_SRVC_EVT,
     BTA_GATTS_API_INDICATION_EVT,
+    BTA_GATTS_API_NOTIFY_MULTI_EVT,
 
     BTA_GATTS_API_ADD_INCL_SRVC_EVT,
     BTA_GATTS_API_ADD_CHAR_EVT,
@@ -122,6 +123,16 @@ typedef struct
     UINT8   value[BTA_GATT_MAX_ATTR_LEN];
 }tBTA_GATTS_API_INDICATION;
 
+typedef struct
+{
+    BT_HDR  hdr;
+    UINT16  attr_id;
+    UINT16  len;
+    UINT8   num_conn;
+    UINT16  conn_id[GATT_MAX_PHY_CHANNEL];
+    UINT8   value[BTA_GATT_MAX_ATTR_LEN];
+}tBTA_GATTS_API_NOTIFY_MULTI;
+
 typedef struct
 {
     BT_HDR              hdr;
@@ -168,6 +179,7 @@ typedef union
     tBTA_GATTS_API_ADD_DESCR        api_add_char_descr;
     tBTA_GATTS_API_START            api_start;
     tBTA_GATTS_API_INDICATION       api_indicate;
+    tBTA_GATTS_API_NOTIFY_MULTI     api_notify_multi;
     tBTA_GATTS_API_RSP              api_rsp;
     tBTA_GATTS_API_OPEN             api_open;
     tBTA_GATTS_API_CANCEL_OPEN      api_cancel_open;
@@ -241,6 +253,7 @@ extern void bta_gatts_stop_service(tBTA_GATTS_SRVC_CB *p_srvc_cb, tBTA_GATTS_DAT
 
 extern void bta_gatts_send_rsp(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg);
 extern void bta_gatts_indicate_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg);
+extern void bta_gatts_notify_multi_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg);
 
 
 extern void bta_gatts_open (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg);
@@ -91,6 +91,10 @@ BOOLEAN bta_gatts_hdl_event(BT_HDR *p_msg)
             bta_gatts_indicate_handle(p_cb,(tBTA_GATTS_DATA *) p_msg);
             break;
 
+        case BTA_GATTS_API_NOTIFY_MULTI_EVT:
+            bta_gatts_notify_multi_handle(p_cb,(tBTA_GATTS_DATA *) p_msg);
+            break;
+
         case BTA_GATTS_API_OPEN_EVT:
             bta_gatts_open(p_cb,(tBTA_GATTS_DATA *) p_msg);
             break;
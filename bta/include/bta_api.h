@@ -910,6 +910,16 @@ typedef union
 /* Security callback */
 typedef void (tBTA_DM_SEC_CBACK)(tBTA_DM_SEC_EVT event, tBTA_DM_SEC *p_data);
 
+/* Bonded device restored by BTA_DmAddDevices() */
+typedef struct
+{
+    BD_ADDR         bd_addr;
+    DEV_CLASS       dev_class;
+    LINK_KEY        link_key;
+    UINT8           key_type;
+    UINT8           pin_length;
+} tBTA_DM_BONDED_DEV;
+
 #define BTA_BLE_MULTI_ADV_ILLEGAL 0
 
 /* multi adv callback event */
@@ -1628,6 +1638,20 @@ extern void BTA_DmAddDevice(BD_ADDR bd_addr, DEV_CLASS dev_class,
                             BOOLEAN is_trusted, UINT8 key_type,
                             tBTA_IO_CAP io_cap, UINT8 pin_length);
 
+/*******************************************************************************
+**
+** Function         BTA_DmAddDevices
+**
+** Description      This function adds |num_devs| bonded devices with their
+**                  link keys to the security database in a single message.
+**                  It is used at startup instead of calling BTA_DmAddDevice
+**                  for every bonded device. The devices are copied.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTA_DmAddDevices(const tBTA_DM_BONDED_DEV *p_devs, UINT16 num_devs);
+
 /*******************************************************************************
 **
 ** Function         BTA_DmRemoveDevice
@@ -2029,6 +2053,22 @@ extern void BTA_DmSetEncryption(BD_ADDR bd_addr, tBTA_TRANSPORT transport,
 extern void BTA_DmBleObserve(BOOLEAN start, UINT16 duration, UINT16 period,
                              tBTA_DM_SEARCH_CBACK *p_results_cb);
 
+/*******************************************************************************
+**
+** Function         BTA_DmBleSetRawScanReports
+**
+** Description      This function asks for every advertising report to be
+**                  delivered to observers instead of only those that carry
+**                  new data, RSSI or a periodic refresh.
+**
+** Parameters       client_if: GATT client interface.
+**                  raw: TRUE to receive every advertising report.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTA_DmBleSetRawScanReports(tGATT_IF client_if, BOOLEAN raw);
+
 
 #endif
 
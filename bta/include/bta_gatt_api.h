@@ -1201,6 +1201,27 @@ extern void BTA_GATTS_HandleValueIndication (UINT16 conn_id, UINT16 attr_id,
                                              UINT8 *p_data,
                                              BOOLEAN need_confirm);
 
+/*******************************************************************************
+**
+** Function         BTA_GATTS_HandleValueNotificationMulti
+**
+** Description      This function is called to send the same notification to
+**                  several connections at once. A BTA_GATTS_CONF_EVT is
+**                  reported for every connection with its own status.
+**
+** Parameters       num_conn - number of connection identifiers in p_conn_id.
+**                  p_conn_id - connection identifiers to notify.
+**                  attr_id - attribute ID to notify.
+**                  data_len - notify data length.
+**                  p_data: data to notify.
+**
+** Returns          None
+**
+*******************************************************************************/
+extern void BTA_GATTS_HandleValueNotificationMulti (UINT8 num_conn, UINT16 *p_conn_id,
+                                                    UINT16 attr_id, UINT16 data_len,
+                                                    UINT8 *p_data);
+
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_SendRsp
@@ -2224,8 +2224,9 @@ static void bta_jv_pm_conn_idle(tBTA_JV_PM_CB *p_cb)
         p_cb->state = BTA_JV_PM_IDLE_ST;
             // start intermediate idle timer for 1s
         if (!alarm_is_scheduled(p_cb->idle_timer)) {
-            alarm_set_on_queue(p_cb->idle_timer, BTA_JV_IDLE_TIMEOUT_MS,
-                   bta_jv_idle_timeout_handler, p_cb, btu_general_alarm_queue);
+            alarm_set_on_queue_with_slack(p_cb->idle_timer, BTA_JV_IDLE_TIMEOUT_MS,
+                   BT_IDLE_TIMER_SLACK_MS, bta_jv_idle_timeout_handler, p_cb,
+                   btu_general_alarm_queue);
         }
     }
 }
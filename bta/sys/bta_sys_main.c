@@ -39,6 +39,7 @@
 #include "osi/include/hash_map.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/pool.h"
 #include "osi/include/thread.h"
 #include "utl.h"
 
@@ -54,6 +55,11 @@ tBTA_SYS_CB bta_sys_cb;
 fixed_queue_t *btu_bta_alarm_queue;
 extern thread_t *bt_workqueue_thread;
 
+/* Pool for the frequent API messages, see bta_sys_msg_alloc. It is created
+** once and kept across stack restarts, since bta_sys_event may release a
+** message to it after bta_sys_free. */
+static pool_t *bta_sys_msg_pool;
+
 /* trace level */
 /* TODO Hard-coded trace levels -  Needs to be configurable */
 UINT8 appl_trace_level = BT_TRACE_LEVEL_WARNING; //APPL_INITIAL_TRACE_LEVEL;
@@ -175,6 +181,10 @@ void bta_sys_init(void)
 {
     memset(&bta_sys_cb, 0, sizeof(tBTA_SYS_CB));
 
+    if (bta_sys_msg_pool == NULL)
+        bta_sys_msg_pool = pool_new("bta_sys_msg", BTA_SYS_MSG_POOL_BLOCK_SIZE,
+                                    BTA_SYS_MSG_POOL_NUM_BLOCKS);
+
     btu_bta_alarm_queue = fixed_queue_new(SIZE_MAX);
 
     alarm_register_processing_queue(btu_bta_alarm_queue, bt_workqueue_thread);
@@ -503,7 +513,7 @@ void bta_sys_event(BT_HDR *p_msg)
 
     if (freebuf)
     {
-        osi_free(p_msg);
+        pool_put(bta_sys_msg_pool, p_msg);
     }
 
 }
@@ -579,6 +589,23 @@ void bta_sys_sendmsg(void *p_msg)
         fixed_queue_enqueue(btu_bta_msg_queue, p_msg);
 }
 
+/*******************************************************************************
+**
+** Function         bta_sys_msg_alloc
+**
+** Description      Allocates a message of |size| bytes for bta_sys_sendmsg,
+**                  from the BTA message pool when a block is free. Only
+**                  for events whose handler returns TRUE, so that the
+**                  message is released by bta_sys_event.
+**
+** Returns          pointer to the message, never NULL
+**
+*******************************************************************************/
+void *bta_sys_msg_alloc(size_t size)
+{
+    return pool_alloc(bta_sys_msg_pool, size);
+}
+
 /*******************************************************************************
 **
 ** Function         bta_sys_start_timer
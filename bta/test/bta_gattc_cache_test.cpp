@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "bta_gattc_int.h"
+#include "osi/include/allocator.h"
+#include "osi/include/list.h"
+
+void bta_gattc_fill_nv_attr(tBTA_GATTC_NV_ATTR *p_attr, UINT8 type, UINT16 s_handle,
+                            UINT16 e_handle, tBT_UUID uuid, UINT8 prop, UINT16 incl_srvc_handle,
+                            BOOLEAN is_primary);
+const tBTA_GATTC_SERVICE *bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV *p_srcb,
+                                                                UINT16 handle);
+}
+
+static BD_ADDR SERVER_BDA = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+class BtaGattcCacheTest : public AllocationTestHarness {
+  protected:
+    virtual void SetUp() {
+      AllocationTestHarness::SetUp();
+      memset(&srcb_, 0, sizeof(srcb_));
+      memset(&clcb_, 0, sizeof(clcb_));
+      bdcpy(srcb_.server_bda, SERVER_BDA);
+      clcb_.p_srcb = &srcb_;
+      remove_cache_file();
+    }
+
+    virtual void TearDown() {
+      bta_gattc_cache_release(&srcb_);
+      remove_cache_file();
+      AllocationTestHarness::TearDown();
+    }
+
+    static void remove_cache_file() {
+      char fname[255];
+      snprintf(fname, sizeof(fname), "%s%02x%02x%02x%02x%02x%02x", GATT_CACHE_PREFIX,
+               SERVER_BDA[0], SERVER_BDA[1], SERVER_BDA[2], SERVER_BDA[3], SERVER_BDA[4],
+               SERVER_BDA[5]);
+      remove(fname);
+    }
+
+    tBTA_GATTC_SERVICE *service_at(size_t index) {
+      list_node_t *node = list_begin(srcb_.p_srvc_cache);
+      while (index--)
+        node = list_next(node);
+      return (tBTA_GATTC_SERVICE *)list_node(node);
+    }
+
+    tBTA_GATTC_SERV srcb_;
+    tBTA_GATTC_CLCB clcb_;
+};
+
+// The services of a cached database can overlap. Filling one of them in
+// from the NV cache must not add its attributes to another service whose
+// range also covers them and which is not filled in yet.
+TEST_F(BtaGattcCacheTest, test_fill_service_with_overlapping_range) {
+  tBT_UUID uuid;
+  memset(&uuid, 0, sizeof(uuid));
+  uuid.len = LEN_UUID_16;
+  uuid.uu.uuid16 = 0x180f;
+
+  // The inner service comes first, so it is found first for handle 0x0006.
+  tBTA_GATTC_NV_ATTR attrs[2];
+  bta_gattc_fill_nv_attr(&attrs[0], BTA_GATTC_ATTR_TYPE_SRVC, 0x0005, 0x0008, uuid, 0, 0, TRUE);
+  bta_gattc_fill_nv_attr(&attrs[1], BTA_GATTC_ATTR_TYPE_SRVC, 0x0001, 0x0010, uuid, 0, 0, TRUE);
+  bta_gattc_rebuild_cache(&srcb_, 2, attrs);
+  ASSERT_EQ(2u, list_length(srcb_.p_srvc_cache));
+
+  // The outer service owns a characteristic inside the inner range.
+  tBTA_GATTC_SERVICE *outer = service_at(1);
+  tBTA_GATTC_CHARACTERISTIC *p_char =
+      (tBTA_GATTC_CHARACTERISTIC *)osi_calloc(sizeof(tBTA_GATTC_CHARACTERISTIC));
+  p_char->handle = 0x0006;
+  p_char->uuid = uuid;
+  p_char->service = outer;
+  p_char->descriptors = list_new(osi_free);
+  list_append(outer->characteristics, p_char);
+
+  bta_gattc_cache_save(&srcb_, 0);
+  ASSERT_TRUE(bta_gattc_cache_load(&clcb_));
+
+  const tBTA_GATTC_SERVICE *loaded = bta_gattc_get_service_for_handle_srcb(&srcb_, 0x0002);
+  ASSERT_TRUE(loaded != NULL);
+  EXPECT_EQ(0x0001, loaded->s_handle);
+  ASSERT_TRUE(loaded->characteristics != NULL);
+  ASSERT_EQ(1u, list_length(loaded->characteristics));
+  tBTA_GATTC_CHARACTERISTIC *loaded_char =
+      (tBTA_GATTC_CHARACTERISTIC *)list_front(loaded->characteristics);
+  EXPECT_EQ(0x0006, loaded_char->handle);
+  EXPECT_EQ(loaded, loaded_char->service);
+
+  // The inner service was left alone and fills in empty.
+  tBTA_GATTC_SERVICE *inner = service_at(0);
+  EXPECT_TRUE(inner->characteristics == NULL);
+  EXPECT_EQ(inner, bta_gattc_get_service_for_handle_srcb(&srcb_, 0x0005));
+  ASSERT_TRUE(inner->characteristics != NULL);
+  EXPECT_TRUE(list_is_empty(inner->characteristics));
+}
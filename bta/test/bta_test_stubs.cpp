@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Stand-ins for the stack and BTA functions that bta_gattc_cache.c calls
+// outside of itself. None of them are reached by the cache load and save
+// paths under test.
+
+extern "C" {
+#include "bta_gattc_int.h"
+#include "btm_int.h"
+#include "sdp_api.h"
+#include "osi/include/osi.h"
+}
+
+extern "C" {
+
+UINT8 appl_trace_level = BT_TRACE_LEVEL_NONE;
+UINT8 btif_trace_level = BT_TRACE_LEVEL_NONE;
+
+void LogMsg(UNUSED_ATTR UINT32 trace_set_mask, UNUSED_ATTR const char *fmt_str, ...) {}
+void vnd_LogMsg(UNUSED_ATTR UINT32 trace_set_mask, UNUSED_ATTR const char *fmt_str, ...) {}
+
+tGATT_STATUS GATTC_Discover(UNUSED_ATTR UINT16 conn_id, UNUSED_ATTR tGATT_DISC_TYPE disc_type,
+                            UNUSED_ATTR tGATT_DISC_PARAM *p_param) {
+  return GATT_ERROR;
+}
+
+BOOLEAN SDP_InitDiscoveryDb(UNUSED_ATTR tSDP_DISCOVERY_DB *p_db, UNUSED_ATTR UINT32 len,
+                            UNUSED_ATTR UINT16 num_uuid, UNUSED_ATTR tSDP_UUID *p_uuid_list,
+                            UNUSED_ATTR UINT16 num_attr, UNUSED_ATTR UINT16 *p_attr_list) {
+  return FALSE;
+}
+
+BOOLEAN SDP_ServiceSearchAttributeRequest2(UNUSED_ATTR UINT8 *p_bd_addr,
+                                           UNUSED_ATTR tSDP_DISCOVERY_DB *p_db,
+                                           UNUSED_ATTR tSDP_DISC_CMPL_CB2 *p_cb,
+                                           UNUSED_ATTR void *user_data) {
+  return FALSE;
+}
+
+tSDP_DISC_REC *SDP_FindServiceInDb(UNUSED_ATTR tSDP_DISCOVERY_DB *p_db,
+                                   UNUSED_ATTR UINT16 service_uuid,
+                                   UNUSED_ATTR tSDP_DISC_REC *p_start_rec) {
+  return NULL;
+}
+
+BOOLEAN SDP_FindServiceUUIDInRec(UNUSED_ATTR tSDP_DISC_REC *p_rec, UNUSED_ATTR tBT_UUID *p_uuid) {
+  return FALSE;
+}
+
+BOOLEAN SDP_FindProtocolListElemInRec(UNUSED_ATTR tSDP_DISC_REC *p_rec,
+                                      UNUSED_ATTR UINT16 layer_uuid,
+                                      UNUSED_ATTR tSDP_PROTOCOL_ELEM *p_elem) {
+  return FALSE;
+}
+
+BOOLEAN bta_gattc_sm_execute(UNUSED_ATTR tBTA_GATTC_CLCB *p_clcb, UNUSED_ATTR UINT16 event,
+                             UNUSED_ATTR tBTA_GATTC_DATA *p_data) {
+  return FALSE;
+}
+
+tBTA_GATTC_CLCB *bta_gattc_find_clcb_by_conn_id(UNUSED_ATTR UINT16 conn_id) {
+  return NULL;
+}
+
+tBTA_GATTC_SERV *bta_gattc_find_scb_by_cid(UNUSED_ATTR UINT16 conn_id) {
+  return NULL;
+}
+
+void bta_gattc_reset_discover_st(UNUSED_ATTR tBTA_GATTC_SERV *p_srcb,
+                                 UNUSED_ATTR tBTA_GATT_STATUS status) {}
+
+BOOLEAN bta_gattc_uuid_compare(UNUSED_ATTR const tBT_UUID *p_src,
+                               UNUSED_ATTR const tBT_UUID *p_tar,
+                               UNUSED_ATTR BOOLEAN is_precise) {
+  return FALSE;
+}
+
+void bta_to_btif_uuid(UNUSED_ATTR bt_uuid_t *p_dest, UNUSED_ATTR tBT_UUID *p_src) {}
+
+BOOLEAN btm_sec_is_a_bonded_dev(UNUSED_ATTR BD_ADDR bda) {
+  return FALSE;
+}
+
+}
@@ -32,6 +32,7 @@ btcoreCommonSrc := \
 btcoreCommonTestSrc := \
     ./test/bdaddr_test.cpp \
     ./test/device_class_test.cpp \
+    ./test/module_test.cpp \
     ./test/property_test.cpp \
     ./test/uuid_test.cpp \
     ../osi/test/AllocationTestHarness.cpp
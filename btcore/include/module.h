@@ -54,6 +54,18 @@ void module_shut_down(const module_t *module);
 // If not initialized, does nothing.
 void module_clean_up(const module_t *module);
 
+// Initialize the NULL terminated |modules| concurrently. Each module is
+// initialized on a worker thread once the modules it depends on among
+// |modules| are; dependencies outside |modules| must be initialized
+// already. After a failure no further modules are started. Returns true if
+// every module was initialized.
+bool module_init_all(const module_t *modules[]);
+
+// Dump the state of every module, and how long its last init and start up
+// took, to the |fd| file descriptor. The caller is responsible for closing
+// the |fd|.
+void module_debug_dump(int fd);
+
 // Temporary callbacked wrapper for module start up, so real modules can be
 // spliced into the current janky startup sequence. Runs on a separate thread,
 // which terminates when the module start up has finished. When module startup
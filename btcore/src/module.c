@@ -20,15 +20,20 @@
 
 #include <assert.h>
 #include <dlfcn.h>
+#include <inttypes.h>
 #include <pthread.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "btcore/include/module.h"
 #include "osi/include/allocator.h"
 #include "osi/include/hash_functions.h"
 #include "osi/include/hash_map.h"
+#include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/semaphore.h"
+#include "osi/include/time.h"
 
 typedef enum {
   MODULE_STATE_NONE = 0,
@@ -37,16 +42,27 @@ typedef enum {
   MODULE_STATE_STARTUP_ERROR = 3
 } module_state_t;
 
+typedef struct {
+  const module_t *module;
+  module_state_t state;
+  uint64_t init_us;       // duration of the last init
+  uint64_t start_up_us;   // duration of the last start up
+} module_metadata_t;
+
 static const size_t number_of_metadata_buckets = 42;
 static hash_map_t *metadata;
+// The same entries as |metadata|, in the order the modules were first seen.
+static list_t *metadata_order;
 // Include this lock for now for correctness, while the startup sequence is being refactored
-static pthread_mutex_t metadata_lock;
+static pthread_mutex_t metadata_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static bool call_lifecycle_function(module_lifecycle_fn function);
 static module_state_t get_module_state(const module_t *module);
 static void set_module_state(const module_t *module, module_state_t state);
+static module_metadata_t *get_metadata_locked(const module_t *module);
 
 void module_management_start(void) {
+  pthread_mutex_lock(&metadata_lock);
   metadata = hash_map_new(
     number_of_metadata_buckets,
     hash_function_pointer,
@@ -54,18 +70,19 @@ void module_management_start(void) {
     osi_free,
     NULL
   );
-
-  pthread_mutex_init(&metadata_lock, NULL);
+  metadata_order = list_new(NULL);
+  pthread_mutex_unlock(&metadata_lock);
 }
 
 void module_management_stop(void) {
-  if (!metadata)
-    return;
-
-  hash_map_free(metadata);
-  metadata = NULL;
-
-  pthread_mutex_destroy(&metadata_lock);
+  pthread_mutex_lock(&metadata_lock);
+  if (metadata) {
+    list_free(metadata_order);
+    metadata_order = NULL;
+    hash_map_free(metadata);
+    metadata = NULL;
+  }
+  pthread_mutex_unlock(&metadata_lock);
 }
 
 const module_t *get_module(const char *name) {
@@ -80,12 +97,21 @@ bool module_init(const module_t *module) {
   assert(get_module_state(module) == MODULE_STATE_NONE);
 
   LOG_INFO(LOG_TAG, "%s Initializing module \"%s\"", __func__, module->name);
-  if (!call_lifecycle_function(module->init)) {
+  uint64_t start_us = time_get_os_boottime_us();
+  bool success = call_lifecycle_function(module->init);
+  uint64_t elapsed_us = time_get_os_boottime_us() - start_us;
+
+  pthread_mutex_lock(&metadata_lock);
+  get_metadata_locked(module)->init_us = elapsed_us;
+  pthread_mutex_unlock(&metadata_lock);
+
+  if (!success) {
     LOG_ERROR(LOG_TAG, "%s Failed to initialize module \"%s\"",
               __func__, module->name);
     return false;
   }
-  LOG_INFO(LOG_TAG, "%s Initialized module \"%s\"", __func__, module->name);
+  LOG_INFO(LOG_TAG, "%s Initialized module \"%s\" in %" PRIu64 " ms",
+           __func__, module->name, elapsed_us / 1000);
 
   set_module_state(module, MODULE_STATE_INITIALIZED);
   return true;
@@ -100,12 +126,21 @@ bool module_start_up(const module_t *module) {
   assert(get_module_state(module) == MODULE_STATE_INITIALIZED || module->init == NULL);
 
   LOG_INFO(LOG_TAG, "%s Starting module \"%s\"", __func__, module->name);
-  if (!call_lifecycle_function(module->start_up)) {
+  uint64_t start_us = time_get_os_boottime_us();
+  bool success = call_lifecycle_function(module->start_up);
+  uint64_t elapsed_us = time_get_os_boottime_us() - start_us;
+
+  pthread_mutex_lock(&metadata_lock);
+  get_metadata_locked(module)->start_up_us = elapsed_us;
+  pthread_mutex_unlock(&metadata_lock);
+
+  if (!success) {
     LOG_ERROR(LOG_TAG, "%s failed to start up \"%s\"", __func__, module->name);
     set_module_state(module, MODULE_STATE_STARTUP_ERROR);
     return false;
   }
-  LOG_INFO(LOG_TAG, "%s Started module \"%s\"", __func__, module->name);
+  LOG_INFO(LOG_TAG, "%s Started module \"%s\" in %" PRIu64 " ms",
+           __func__, module->name, elapsed_us / 1000);
 
   set_module_state(module, MODULE_STATE_STARTED);
   return true;
@@ -169,24 +204,181 @@ static bool call_lifecycle_function(module_lifecycle_fn function) {
 
 static module_state_t get_module_state(const module_t *module) {
   pthread_mutex_lock(&metadata_lock);
-  module_state_t *state_ptr = hash_map_get(metadata, module);
+  module_metadata_t *entry = hash_map_get(metadata, module);
+  module_state_t state = entry ? entry->state : MODULE_STATE_NONE;
   pthread_mutex_unlock(&metadata_lock);
 
-  return state_ptr ? *state_ptr : MODULE_STATE_NONE;
+  return state;
 }
 
 static void set_module_state(const module_t *module, module_state_t state) {
   pthread_mutex_lock(&metadata_lock);
+  get_metadata_locked(module)->state = state;
+  pthread_mutex_unlock(&metadata_lock);
+}
+
+static module_metadata_t *get_metadata_locked(const module_t *module) {
+  module_metadata_t *entry = hash_map_get(metadata, module);
+  if (!entry) {
+    entry = osi_calloc(sizeof(module_metadata_t));
+    entry->module = module;
+    hash_map_set(metadata, module, entry);
+    list_append(metadata_order, entry);
+  }
+  return entry;
+}
+
+void module_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth Modules:\n");
 
-  module_state_t *state_ptr = hash_map_get(metadata, module);
-  if (!state_ptr) {
-    state_ptr = osi_malloc(sizeof(module_state_t));
-    hash_map_set(metadata, module, state_ptr);
+  pthread_mutex_lock(&metadata_lock);
+  if (!metadata_order || list_is_empty(metadata_order)) {
+    pthread_mutex_unlock(&metadata_lock);
+    dprintf(fd, "  None\n");
+    return;
   }
 
+  dprintf(fd, "  %-24s %-8s %12s %12s\n", "Module", "State", "Init (ms)",
+          "Start (ms)");
+  for (const list_node_t *node = list_begin(metadata_order);
+       node != list_end(metadata_order); node = list_next(node)) {
+    const module_metadata_t *entry = list_node(node);
+    const char *state = "none";
+    switch (entry->state) {
+      case MODULE_STATE_NONE: state = "none"; break;
+      case MODULE_STATE_INITIALIZED: state = "init"; break;
+      case MODULE_STATE_STARTED: state = "started"; break;
+      case MODULE_STATE_STARTUP_ERROR: state = "error"; break;
+    }
+    dprintf(fd, "  %-24s %-8s %8" PRIu64 ".%03" PRIu64 " %8" PRIu64 ".%03" PRIu64 "\n",
+            entry->module->name, state,
+            entry->init_us / 1000, entry->init_us % 1000,
+            entry->start_up_us / 1000, entry->start_up_us % 1000);
+  }
   pthread_mutex_unlock(&metadata_lock);
+}
+
+// Runs the init of a set of modules in dependency order, concurrently where
+// the dependencies allow it.
+
+typedef struct {
+  const module_t *module;
+  thread_t *thread;
+  bool started;
+  bool finished;
+  bool success;
+  pthread_mutex_t *lock;
+  semaphore_t *finished_sem;
+} module_task_t;
+
+static bool task_is_ready(module_task_t *tasks, size_t count, size_t index);
+static void run_task(void *context);
+
+bool module_init_all(const module_t *modules[]) {
+  assert(metadata != NULL);
+  assert(modules != NULL);
+
+  size_t count = 0;
+  while (modules[count])
+    ++count;
+  if (!count)
+    return true;
+
+  pthread_mutex_t lock;
+  pthread_mutex_init(&lock, NULL);
+  semaphore_t *finished_sem = semaphore_new(0);
+  module_task_t *tasks = osi_calloc(sizeof(module_task_t) * count);
+  for (size_t i = 0; i < count; ++i) {
+    tasks[i].module = modules[i];
+    tasks[i].lock = &lock;
+    tasks[i].finished_sem = finished_sem;
+  }
+
+  size_t running = 0;
+  size_t remaining = count;
+  bool success = true;
+  while (remaining) {
+    // Stop starting new modules once one has failed, but let the running
+    // ones finish.
+    if (success) {
+      for (size_t i = 0; i < count; ++i) {
+        if (tasks[i].started || !task_is_ready(tasks, count, i))
+          continue;
+        tasks[i].started = true;
+        tasks[i].thread = thread_new("module_worker");
+        if (!tasks[i].thread) {
+          // Run it here instead.
+          tasks[i].success = module_init(tasks[i].module);
+          tasks[i].finished = true;
+          --remaining;
+          if (!tasks[i].success)
+            success = false;
+          continue;
+        }
+        thread_post(tasks[i].thread, run_task, &tasks[i]);
+        ++running;
+      }
+    }
+
+    if (!running) {
+      if (remaining && success)
+        LOG_ERROR(LOG_TAG, "%s dependency cycle among %zu modules", __func__,
+                  remaining);
+      break;
+    }
+
+    semaphore_wait(finished_sem);
+
+    pthread_mutex_lock(&lock);
+    for (size_t i = 0; i < count; ++i) {
+      if (!tasks[i].finished || !tasks[i].thread)
+        continue;
+      pthread_mutex_unlock(&lock);
+      thread_free(tasks[i].thread);
+      pthread_mutex_lock(&lock);
+      tasks[i].thread = NULL;
+      --running;
+      --remaining;
+      if (!tasks[i].success)
+        success = false;
+    }
+    pthread_mutex_unlock(&lock);
+  }
+
+  osi_free(tasks);
+  semaphore_free(finished_sem);
+  pthread_mutex_destroy(&lock);
+  return success && !remaining;
+}
+
+// A module is ready once every dependency it has in the set has finished
+// successfully. Dependencies outside the set are the caller's concern.
+static bool task_is_ready(module_task_t *tasks, size_t count, size_t index) {
+  for (const char *const *dependency = tasks[index].module->dependencies;
+       *dependency; ++dependency) {
+    for (size_t i = 0; i < count; ++i) {
+      if (strcmp(tasks[i].module->name, *dependency))
+        continue;
+      pthread_mutex_lock(tasks[i].lock);
+      bool done = tasks[i].finished && tasks[i].success;
+      pthread_mutex_unlock(tasks[i].lock);
+      if (!done)
+        return false;
+    }
+  }
+  return true;
+}
+
+static void run_task(void *context) {
+  module_task_t *task = context;
+  bool success = module_init(task->module);
+
+  pthread_mutex_lock(task->lock);
+  task->success = success;
+  task->finished = true;
+  pthread_mutex_unlock(task->lock);
 
-  *state_ptr = state;
+  semaphore_post(task->finished_sem);
 }
 
 // TODO(zachoverflow): remove when everything modulized
@@ -0,0 +1,223 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include "osi/test/AllocationTestHarness.h"
+
+extern "C" {
+#include "btcore/include/module.h"
+#include "osi/include/semaphore.h"
+}  // "C"
+
+static semaphore_t *first_started;
+static semaphore_t *second_started;
+static bool first_done;
+static bool dependency_seen;
+
+// Waits up to a second, so a test that gets run serially fails instead of
+// hanging.
+static bool wait_for(semaphore_t *semaphore) {
+  for (int i = 0; i < 1000; ++i) {
+    if (semaphore_try_wait(semaphore))
+      return true;
+    usleep(1000);
+  }
+  return false;
+}
+
+static future_t *first_init(void) {
+  semaphore_post(first_started);
+  bool ok = wait_for(second_started);
+  first_done = true;
+  return future_new_immediate(ok ? FUTURE_SUCCESS : FUTURE_FAIL);
+}
+
+static future_t *second_init(void) {
+  semaphore_post(second_started);
+  bool ok = wait_for(first_started);
+  return future_new_immediate(ok ? FUTURE_SUCCESS : FUTURE_FAIL);
+}
+
+static future_t *dependent_init(void) {
+  dependency_seen = first_done;
+  return NULL;
+}
+
+static future_t *failing_init(void) {
+  return future_new_immediate(FUTURE_FAIL);
+}
+
+static const module_t first_module = {
+  .name = "first_module",
+  .init = first_init,
+  .start_up = NULL,
+  .shut_down = NULL,
+  .clean_up = NULL,
+  .dependencies = {NULL}
+};
+
+static const module_t second_module = {
+  .name = "second_module",
+  .init = second_init,
+  .start_up = NULL,
+  .shut_down = NULL,
+  .clean_up = NULL,
+  .dependencies = {NULL}
+};
+
+static const module_t dependent_module = {
+  .name = "dependent_module",
+  .init = dependent_init,
+  .start_up = NULL,
+  .shut_down = NULL,
+  .clean_up = NULL,
+  .dependencies = {"second_module", "first_module", NULL}
+};
+
+static const module_t failing_module = {
+  .name = "failing_module",
+  .init = failing_init,
+  .start_up = NULL,
+  .shut_down = NULL,
+  .clean_up = NULL,
+  .dependencies = {NULL}
+};
+
+static int counted_inits;
+
+static future_t *counted_init(void) {
+  ++counted_inits;
+  return NULL;
+}
+
+static const module_t independent_module = {
+  .name = "independent_module",
+  .init = counted_init,
+  .start_up = NULL,
+  .shut_down = NULL,
+  .clean_up = NULL,
+  .dependencies = {NULL}
+};
+
+static const module_t cycle_a_module = {
+  .name = "cycle_a_module",
+  .init = counted_init,
+  .start_up = NULL,
+  .shut_down = NULL,
+  .clean_up = NULL,
+  .dependencies = {"cycle_b_module", NULL}
+};
+
+static const module_t cycle_b_module = {
+  .name = "cycle_b_module",
+  .init = counted_init,
+  .start_up = NULL,
+  .shut_down = NULL,
+  .clean_up = NULL,
+  .dependencies = {"cycle_a_module", NULL}
+};
+
+static const module_t after_failing_module = {
+  .name = "after_failing_module",
+  .init = dependent_init,
+  .start_up = NULL,
+  .shut_down = NULL,
+  .clean_up = NULL,
+  .dependencies = {"failing_module", NULL}
+};
+
+class ModuleTest : public AllocationTestHarness {
+ protected:
+  virtual void SetUp() {
+    AllocationTestHarness::SetUp();
+    module_management_start();
+    first_started = semaphore_new(0);
+    second_started = semaphore_new(0);
+    first_done = false;
+    dependency_seen = false;
+    counted_inits = 0;
+  }
+
+  virtual void TearDown() {
+    semaphore_free(first_started);
+    semaphore_free(second_started);
+    module_management_stop();
+    AllocationTestHarness::TearDown();
+  }
+};
+
+TEST_F(ModuleTest, test_init_all_concurrent) {
+  // The first two modules each wait for the other to start.
+  const module_t *modules[] = {
+    &dependent_module, &first_module, &second_module, NULL
+  };
+  EXPECT_TRUE(module_init_all(modules));
+  EXPECT_TRUE(dependency_seen);
+
+  for (int i = 0; modules[i]; ++i)
+    module_clean_up(modules[i]);
+}
+
+TEST_F(ModuleTest, test_init_all_failure) {
+  const module_t *modules[] = {
+    &after_failing_module, &failing_module, NULL
+  };
+  EXPECT_FALSE(module_init_all(modules));
+
+  // Nothing was initialized, so nothing needs cleaning up, and the module
+  // after the failing one can still be initialized on its own.
+  EXPECT_TRUE(module_init(&after_failing_module));
+  module_clean_up(&after_failing_module);
+}
+
+TEST_F(ModuleTest, test_init_all_cycle) {
+  // The module outside the cycle still gets initialized; the call fails
+  // instead of waiting forever on the two that depend on each other.
+  const module_t *modules[] = {
+    &cycle_a_module, &independent_module, &cycle_b_module, NULL
+  };
+  EXPECT_FALSE(module_init_all(modules));
+  EXPECT_EQ(1, counted_inits);
+
+  module_clean_up(&independent_module);
+}
+
+TEST_F(ModuleTest, test_debug_dump) {
+  const module_t *modules[] = {
+    &first_module, &second_module, NULL
+  };
+  EXPECT_TRUE(module_init_all(modules));
+
+  FILE *file = tmpfile();
+  module_debug_dump(fileno(file));
+  rewind(file);
+  char buf[1024];
+  size_t len = fread(buf, 1, sizeof(buf) - 1, file);
+  buf[len] = '\0';
+  fclose(file);
+
+  std::string contents(buf);
+  EXPECT_NE(std::string::npos, contents.find("first_module"));
+  EXPECT_NE(std::string::npos, contents.find("second_module"));
+
+  module_clean_up(&first_module);
+  module_clean_up(&second_module);
+}
@@ -48,6 +48,7 @@ btifCommonSrc += \
   src/btif_hf_client.c \
   src/btif_hh.c \
   src/btif_hl.c \
+  src/btif_keystore.c \
   src/btif_sdp.c \
   src/btif_media_task.c \
   src/btif_pan.c \
@@ -87,6 +88,7 @@ btifCommonSrc += \
 
 # Tests
 btifTestSrc := \
+  test/btif_keystore_test.cpp \
   test/btif_storage_test.cpp
 
 # Includes
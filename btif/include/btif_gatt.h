@@ -28,7 +28,10 @@
 #ifndef BTIF_GATT_H
 #define BTIF_GATT_H
 
-
+#if (defined(BLE_INCLUDED) && (BLE_INCLUDED == TRUE))
+/* Writes the LE scan report suppression and batch scan counters to |fd|. */
+void btif_gattc_scan_dump(int fd);
+#endif
 
 #endif
 
@@ -0,0 +1,101 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <hardware/bluetooth.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A binary copy of the bonding keys kept in bt_config.conf, so that enabling
+// with many bonded devices reads one small file instead of looking up and
+// hex-decoding every key of every config section.
+//
+// The file holds a header followed by fixed size entries and is read and
+// written whole. bt_config.conf stays authoritative: the caller stamps each
+// saved store with a generation number that it also records in the config,
+// and rebuilds the store from the config whenever the two disagree.
+
+#define BTIF_KEYSTORE_LINK_KEY_LEN 16
+
+// Slots for the LE keys of a device. Large enough for any tBTM_LE_*_KEYS.
+#define BTIF_KEYSTORE_LE_KEY_SLOTS 5
+#define BTIF_KEYSTORE_LE_KEY_MAX 32
+
+// Bits of |btif_keystore_entry_t.key_mask|.
+#define BTIF_KEYSTORE_HAS_LINK_KEY 0x01
+#define BTIF_KEYSTORE_HAS_LE_KEY(slot) (0x02 << (slot))
+// The LE local identity key was distributed. It has no payload.
+#define BTIF_KEYSTORE_HAS_LE_LID 0x40
+
+// The entry layout is also the file layout, so it is made of bytes only.
+typedef struct {
+  bt_bdaddr_t addr;
+  uint8_t key_mask;
+  uint8_t link_key_type;
+  uint8_t pin_length;
+  uint8_t link_key[BTIF_KEYSTORE_LINK_KEY_LEN];
+  uint8_t le_key_len[BTIF_KEYSTORE_LE_KEY_SLOTS];
+  uint8_t le_key[BTIF_KEYSTORE_LE_KEY_SLOTS][BTIF_KEYSTORE_LE_KEY_MAX];
+} btif_keystore_entry_t;
+
+typedef struct btif_keystore_t btif_keystore_t;
+
+// Where btif_storage keeps its key store.
+extern const char *BTIF_KEYSTORE_PATH;
+
+// Creates an empty key store. Returns NULL on allocation failure. The
+// returned store must be freed with |btif_keystore_free|.
+btif_keystore_t *btif_keystore_new(void);
+
+// Reads the key store at |path|. Returns NULL if the file does not exist or
+// is truncated, of another version or fails its checksum.
+btif_keystore_t *btif_keystore_load(const char *path);
+
+// Returns a copy of |keystore|, or NULL on allocation failure. The copy must
+// be freed with |btif_keystore_free|.
+btif_keystore_t *btif_keystore_clone(const btif_keystore_t *keystore);
+
+// Frees |keystore|. |keystore| may be NULL.
+void btif_keystore_free(btif_keystore_t *keystore);
+
+// Atomically replaces the file at |path| with |keystore|, stamped with
+// |generation|. Returns true once the file is synced to disk.
+bool btif_keystore_save(btif_keystore_t *keystore, const char *path, uint32_t generation);
+
+// Returns the generation |keystore| was last saved or loaded with, or 0 for
+// a new store.
+uint32_t btif_keystore_generation(const btif_keystore_t *keystore);
+
+// Returns the number of entries in |keystore|.
+size_t btif_keystore_count(const btif_keystore_t *keystore);
+
+// Returns the entry at |index|, which must be less than the count. Entries
+// keep the order they were added in. The pointer is valid until the next
+// call that adds or removes an entry.
+btif_keystore_entry_t *btif_keystore_at(btif_keystore_t *keystore, size_t index);
+
+// Returns the entry for |addr|. If there is none, adds an empty one when
+// |create| is true and returns NULL otherwise. Also returns NULL if the entry
+// could not be allocated.
+btif_keystore_entry_t *btif_keystore_find(btif_keystore_t *keystore, const bt_bdaddr_t *addr,
+                                          bool create);
+
+// Removes the entry for |addr|, if any.
+void btif_keystore_remove(btif_keystore_t *keystore, const bt_bdaddr_t *addr);
@@ -298,6 +298,44 @@ BOOLEAN btif_storage_is_restricted_device(const bt_bdaddr_t *remote_bd_addr);
 *******************************************************************************/
 BOOLEAN btif_storage_is_wiimote(bt_bdaddr_t *remote_bd_addr, bt_bdname_t *remote_bd_name);
 
+/*******************************************************************************
+**
+** Function         btif_storage_write_keystore
+**
+** Description      BTIF storage API - Writes the binary key store to NVRAM if
+**                  it changed since it was last written. Called by btif_config
+**                  before each config save.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_write_keystore(void);
+
+/*******************************************************************************
+**
+** Function         btif_storage_free_keystore
+**
+** Description      BTIF storage API - Writes out and frees the binary key
+**                  store. It is reloaded on next use.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_free_keystore(void);
+
+/*******************************************************************************
+**
+** Function         btif_storage_clear_keystore
+**
+** Description      BTIF storage API - Drops the binary key store, in memory
+**                  and in NVRAM, without writing it. Called by btif_config
+**                  when the config is cleared.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_clear_keystore(void);
+
 /*******************************************************************************
 ** Function         btif_storage_get_num_bonded_devices
 **
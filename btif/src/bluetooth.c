@@ -50,6 +50,7 @@
 #endif
 
 #include "bt_utils.h"
+#include "btcore/include/module.h"
 #include "btif_api.h"
 #include "btif_common.h"
 #include "device/include/controller.h"
@@ -62,6 +63,8 @@
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
 #include "osi/include/osi.h"
+#include "osi/include/pool.h"
+#include "osi/include/trace_ring.h"
 #include "osi/include/wakelock.h"
 #include "stack_manager.h"
 #include "btif_config.h"
@@ -69,6 +72,7 @@
 #include "btif/include/btif_debug_btsnoop.h"
 #include "btif/include/btif_debug_conn.h"
 #include "btif/include/btif_debug_l2c.h"
+#include "btif/include/btif_gatt.h"
 #include "btif/include/btif_media.h"
 #include "l2cdefs.h"
 #include "l2c_api.h"
@@ -391,9 +395,15 @@ static void dump(int fd, const char **arguments)
     btif_debug_bond_event_dump(fd);
     btif_debug_a2dp_dump(fd);
     btif_debug_l2c_dump(fd);
+#if (defined(BLE_INCLUDED) && (BLE_INCLUDED == TRUE))
+    btif_gattc_scan_dump(fd);
+#endif
     btif_debug_config_dump(fd);
     wakelock_debug_dump(fd);
     alarm_debug_dump(fd);
+    module_debug_dump(fd);
+    pool_debug_dump(fd);
+    trace_ring_debug_dump(fd);
 #if defined(BTSNOOP_MEM) && (BTSNOOP_MEM == TRUE)
     btif_debug_btsnoop_dump(fd);
 #endif
@@ -35,13 +35,18 @@
 #include "btif_common.h"
 #include "btif_config.h"
 #include "btif_config_transcode.h"
+#include "btif_keystore.h"
+#include "btif_storage.h"
 #include "btif_util.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocator.h"
 #include "osi/include/compat.h"
 #include "osi/include/config.h"
+#include "osi/include/hash_functions.h"
+#include "osi/include/hash_map.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/time.h"
 
 /**
  * TODO(apanicke): cutils/properties.h is only being used to pull-in runtime
@@ -57,6 +62,7 @@
 #define INFO_SECTION "Info"
 #define FILE_TIMESTAMP "TimeCreated"
 #define FILE_SOURCE "FileSource"
+#define JOURNAL_GENERATION "JournalGeneration"
 #define TIME_STRING_LENGTH sizeof("YYYY-MM-DD HH:MM:SS")
 static const char* TIME_STRING_FORMAT = "%Y-%m-%d %H:%M:%S";
 
@@ -64,13 +70,23 @@ static const char* TIME_STRING_FORMAT = "%Y-%m-%d %H:%M:%S";
 #if defined(OS_GENERIC)
 static const char *CONFIG_FILE_PATH = "bt_config.conf";
 static const char *CONFIG_BACKUP_PATH = "bt_config.bak";
+static const char *CONFIG_JOURNAL_PATH = "bt_config.journal";
 static const char *CONFIG_LEGACY_FILE_PATH = "bt_config.xml";
 #else  // !defined(OS_GENERIC)
 static const char *CONFIG_FILE_PATH = "/data/misc/bluedroid/bt_config.conf";
 static const char *CONFIG_BACKUP_PATH = "/data/misc/bluedroid/bt_config.bak";
+static const char *CONFIG_JOURNAL_PATH = "/data/misc/bluedroid/bt_config.journal";
 static const char *CONFIG_LEGACY_FILE_PATH = "/data/misc/bluedroid/bt_config.xml";
 #endif  // defined(OS_GENERIC)
 static const period_ms_t CONFIG_SETTLE_PERIOD_MS = 3000;
+// Writing back to disk is not urgent; let the save wait for another wakeup.
+static const period_ms_t CONFIG_SETTLE_SLACK_MS = 3000;
+
+// Saves append the changed keys to the journal until it grows past this size;
+// the next save then writes a full snapshot and empties the journal. Set to 0
+// to always write full snapshots.
+static const size_t CONFIG_JOURNAL_MAX_SIZE = 16 * 1024;
+static const size_t CONFIG_JOURNAL_BUCKETS = 32;
 
 static void timer_config_save_cb(void *data);
 static void btif_config_write(UINT16 event, char *p_param);
@@ -78,7 +94,17 @@ static bool is_factory_reset(void);
 static void delete_config_files(void);
 static void btif_config_remove_unpaired(config_t *config);
 static void btif_config_remove_restricted(config_t *config);
+static bool btif_config_is_unpaired(const config_t *conf, const char *section);
 static config_t *btif_config_open(const char* filename);
+static int btif_config_count_sections(const config_t *conf);
+static bool string_equals(const void *key_a, const void *key_b);
+static void btif_config_mark_dirty(const char *section, const char *key);
+static bool btif_config_record_journal(void);
+static config_t *btif_config_take_snapshot(void);
+static bool btif_config_save_snapshot(config_t *snapshot);
+static void btif_config_reset_persisted(const config_t *persisted_config);
+static void btif_config_lock(bool reader);
+static void btif_config_unlock(void);
 
 static enum ConfigSource {
   NOT_LOADED,
@@ -131,13 +157,41 @@ bool btif_get_address_type(const BD_ADDR bd_addr, int *p_addr_type)
 }
 
 static pthread_mutex_t lock;  // protects operations on |config|.
+static pthread_mutex_t write_lock;  // serializes saves; protects |journal|.
 static config_t *config;
 static alarm_t *config_timer;
 
+typedef struct {
+  uint64_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+} lock_stat_t;
+
+// Lock metrics, protected by |lock|.
+static uint64_t lock_acquired_us;
+static lock_stat_t lock_hold;     // every hold of |lock|
+static lock_stat_t reader_wait;   // getters waiting for |lock|
+static lock_stat_t save_io;       // saves, excluding the in-memory work
+
+static void btif_config_update_stat(lock_stat_t *stat, uint64_t elapsed_us);
+
+// Journal state. |dirty| holds "section\nkey" for every key changed since the
+// last save. |persisted| holds the sections the snapshot plus journal contain.
+// All of it is protected by |lock|, except |journal| and |journal_generation|,
+// which only change under |write_lock|.
+static config_journal_t *journal;
+static int journal_generation;
+static hash_map_t *dirty;
+static hash_map_t *persisted;
+static bool snapshot_needed;
+static int journal_compactions;
+static size_t journal_bytes;   // copy of the journal size for the dump
+
 // Module lifecycle functions
 
 static future_t *init(void) {
   pthread_mutex_init(&lock, NULL);
+  pthread_mutex_init(&write_lock, NULL);
   pthread_mutex_lock(&lock);
 
   if (is_factory_reset())
@@ -167,20 +221,36 @@ static future_t *init(void) {
     file_source = "Empty";
   }
 
-  if (file_source != NULL)
-    config_set_string(config, INFO_SECTION, FILE_SOURCE, file_source);
-
   if (!config) {
     LOG_ERROR("%s unable to allocate a config object.", __func__);
     goto error;
   }
 
+  // Changes saved since the snapshot was written are in the journal. A backup
+  // is the snapshot the journal was started for if the original was lost
+  // while being replaced.
+  journal_generation = config_get_int(config, INFO_SECTION, JOURNAL_GENERATION, 0);
+  if (btif_config_source == ORIGINAL || btif_config_source == BACKUP) {
+    int records = config_journal_replay(config, CONFIG_JOURNAL_PATH, journal_generation);
+    if (records > 0)
+      LOG_INFO(LOG_TAG, "%s replayed %d journal records.", __func__, records);
+  }
+
+  // Anything changed below is not in the snapshot or journal yet.
+  int sections_loaded = btif_config_count_sections(config);
+
+  if (file_source != NULL)
+    config_set_string(config, INFO_SECTION, FILE_SOURCE, file_source);
+
   btif_config_remove_unpaired(config);
 
   // Cleanup temporary pairings if we have left guest mode
   if (!is_restricted_mode())
     btif_config_remove_restricted(config);
 
+  snapshot_needed = (file_source != NULL) ||
+      (btif_config_count_sections(config) != sections_loaded);
+
   // Read or set config file creation timestamp
   const char* time_str = config_get_string(config, INFO_SECTION, FILE_TIMESTAMP, NULL);
   if (time_str != NULL) {
@@ -191,9 +261,25 @@ static future_t *init(void) {
     if (time_created) {
       strftime(btif_config_time_created, TIME_STRING_LENGTH, TIME_STRING_FORMAT, time_created);
       config_set_string(config, INFO_SECTION, FILE_TIMESTAMP, btif_config_time_created);
+      snapshot_needed = true;
     }
   }
 
+  dirty = hash_map_new(CONFIG_JOURNAL_BUCKETS, hash_function_string, osi_free, NULL,
+                       string_equals);
+  persisted = hash_map_new(CONFIG_JOURNAL_BUCKETS, hash_function_string, osi_free, NULL,
+                           string_equals);
+  if (!dirty || !persisted) {
+    LOG_ERROR(LOG_TAG, "%s unable to allocate journal state.", __func__);
+    goto error;
+  }
+  btif_config_reset_persisted(config);
+
+  // Without a journal every save writes a full snapshot.
+  if (CONFIG_JOURNAL_MAX_SIZE > 0)
+    journal = config_journal_open(CONFIG_JOURNAL_PATH, journal_generation);
+  journal_bytes = journal ? config_journal_size(journal) : 0;
+
   // TODO(sharvil): use a non-wake alarm for this once we have
   // API support for it. There's no need to wake the system to
   // write back to disk.
@@ -211,10 +297,15 @@ static future_t *init(void) {
 error:
   alarm_free(config_timer);
   config_free(config);
+  hash_map_free(dirty);
+  hash_map_free(persisted);
   pthread_mutex_unlock(&lock);
   pthread_mutex_destroy(&lock);
+  pthread_mutex_destroy(&write_lock);
   config_timer = NULL;
   config = NULL;
+  dirty = NULL;
+  persisted = NULL;
   btif_config_source = NOT_LOADED;
   return future_new_immediate(FUTURE_FAIL);
 }
@@ -243,9 +334,16 @@ static future_t *clean_up(void) {
 
   alarm_free(config_timer);
   config_free(config);
+  config_journal_close(journal);
+  hash_map_free(dirty);
+  hash_map_free(persisted);
   pthread_mutex_destroy(&lock);
+  pthread_mutex_destroy(&write_lock);
   config_timer = NULL;
   config = NULL;
+  journal = NULL;
+  dirty = NULL;
+  persisted = NULL;
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -264,9 +362,9 @@ bool btif_config_has_section(const char *section) {
   assert(config != NULL);
   assert(section != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(true);
   bool ret = config_has_section(config, section);
-  pthread_mutex_unlock(&lock);
+  btif_config_unlock();
 
   return ret;
 }
@@ -276,9 +374,9 @@ bool btif_config_exist(const char *section, const char *key) {
   assert(section != NULL);
   assert(key != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(true);
   bool ret = config_has_key(config, section, key);
-  pthread_mutex_unlock(&lock);
+  btif_config_unlock();
 
   return ret;
 }
@@ -289,11 +387,11 @@ bool btif_config_get_int(const char *section, const char *key, int *value) {
   assert(key != NULL);
   assert(value != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(true);
   bool ret = config_has_key(config, section, key);
   if (ret)
     *value = config_get_int(config, section, key, *value);
-  pthread_mutex_unlock(&lock);
+  btif_config_unlock();
 
   return ret;
 }
@@ -303,9 +401,10 @@ bool btif_config_set_int(const char *section, const char *key, int value) {
   assert(section != NULL);
   assert(key != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(false);
   config_set_int(config, section, key, value);
-  pthread_mutex_unlock(&lock);
+  btif_config_mark_dirty(section, key);
+  btif_config_unlock();
 
   return true;
 }
@@ -317,9 +416,9 @@ bool btif_config_get_str(const char *section, const char *key, char *value, int
   assert(value != NULL);
   assert(size_bytes != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(true);
   const char *stored_value = config_get_string(config, section, key, NULL);
-  pthread_mutex_unlock(&lock);
+  btif_config_unlock();
 
   if (!stored_value)
     return false;
@@ -336,9 +435,10 @@ bool btif_config_set_str(const char *section, const char *key, const char *value
   assert(key != NULL);
   assert(value != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(false);
   config_set_string(config, section, key, value);
-  pthread_mutex_unlock(&lock);
+  btif_config_mark_dirty(section, key);
+  btif_config_unlock();
 
   return true;
 }
@@ -350,9 +450,9 @@ bool btif_config_get_bin(const char *section, const char *key, uint8_t *value, s
   assert(value != NULL);
   assert(length != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(true);
   const char *value_str = config_get_string(config, section, key, NULL);
-  pthread_mutex_unlock(&lock);
+  btif_config_unlock();
 
   if (!value_str)
     return false;
@@ -376,9 +476,9 @@ size_t btif_config_get_bin_length(const char *section, const char *key) {
   assert(section != NULL);
   assert(key != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(true);
   const char *value_str = config_get_string(config, section, key, NULL);
-  pthread_mutex_unlock(&lock);
+  btif_config_unlock();
 
   if (!value_str)
     return 0;
@@ -404,9 +504,10 @@ bool btif_config_set_bin(const char *section, const char *key, const uint8_t *va
     str[(i * 2) + 1] = lookup[value[i] & 0x0F];
   }
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(false);
   config_set_string(config, section, key, str);
-  pthread_mutex_unlock(&lock);
+  btif_config_mark_dirty(section, key);
+  btif_config_unlock();
 
   osi_free(str);
   return true;
@@ -439,9 +540,11 @@ bool btif_config_remove(const char *section, const char *key) {
   assert(section != NULL);
   assert(key != NULL);
 
-  pthread_mutex_lock(&lock);
+  btif_config_lock(false);
   bool ret = config_remove_key(config, section, key);
-  pthread_mutex_unlock(&lock);
+  if (ret)
+    btif_config_mark_dirty(section, key);
+  btif_config_unlock();
 
   return ret;
 }
@@ -450,7 +553,8 @@ void btif_config_save(void) {
   assert(config != NULL);
   assert(config_timer != NULL);
 
-  alarm_set(config_timer, CONFIG_SETTLE_PERIOD_MS, timer_config_save_cb, NULL);
+  alarm_set_with_slack(config_timer, CONFIG_SETTLE_PERIOD_MS, CONFIG_SETTLE_SLACK_MS,
+                       timer_config_save_cb, NULL);
 }
 
 void btif_config_flush(void) {
@@ -467,18 +571,26 @@ bool btif_config_clear(void) {
 
   alarm_cancel(config_timer);
 
-  pthread_mutex_lock(&lock);
+  pthread_mutex_lock(&write_lock);
+  // Taken before |lock|, as btif_config_write does.
+  btif_storage_clear_keystore();
+
+  btif_config_lock(false);
   config_free(config);
 
   config = config_new_empty();
   if (config == NULL) {
-    pthread_mutex_unlock(&lock);
+    btif_config_unlock();
+    pthread_mutex_unlock(&write_lock);
     return false;
   }
 
-  bool ret = config_save(config, CONFIG_FILE_PATH);
+  config_t *snapshot = btif_config_take_snapshot();
   btif_config_source = RESET;
-  pthread_mutex_unlock(&lock);
+  btif_config_unlock();
+
+  bool ret = btif_config_save_snapshot(snapshot);
+  pthread_mutex_unlock(&write_lock);
   return ret;
 }
 
@@ -493,15 +605,193 @@ static void btif_config_write(UNUSED_ATTR UINT16 event, UNUSED_ATTR char *p_para
   assert(config != NULL);
   assert(config_timer != NULL);
 
+  // Only the in-memory work is done under |lock|; the file I/O below runs
+  // under |write_lock| alone so that readers do not wait for the disk.
+  pthread_mutex_lock(&write_lock);
+
+  // The key store goes first: the config saved below records its generation,
+  // or drops the record if the store could not be written.
+  btif_storage_write_keystore();
+
+  btif_config_lock(false);
+  if (hash_map_is_empty(dirty) && !snapshot_needed) {
+    btif_config_unlock();
+    pthread_mutex_unlock(&write_lock);
+    return;
+  }
+
+  config_t *snapshot = NULL;
+  bool journaled = journal && !snapshot_needed &&
+      config_journal_size(journal) < CONFIG_JOURNAL_MAX_SIZE && btif_config_record_journal();
+  if (!journaled)
+    snapshot = btif_config_take_snapshot();
+  btif_config_unlock();
+
+  uint64_t start_us = time_get_os_boottime_us();
+  if (journaled && !config_journal_commit(journal)) {
+    LOG_WARN(LOG_TAG, "%s unable to append to journal; writing snapshot.", __func__);
+    btif_config_lock(false);
+    snapshot = btif_config_take_snapshot();
+    btif_config_unlock();
+  }
+
+  if (snapshot) {
+    rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
+    btif_config_save_snapshot(snapshot);
+  }
+
+  btif_config_lock(false);
+  btif_config_update_stat(&save_io, time_get_os_boottime_us() - start_us);
+  journal_bytes = journal ? config_journal_size(journal) : 0;
+  btif_config_unlock();
+  pthread_mutex_unlock(&write_lock);
+}
+
+// Returns a copy of |config| to be saved as the snapshot for the next journal
+// generation. Changes made from now on are journaled against it. Called with
+// |lock| and |write_lock| held.
+static config_t *btif_config_take_snapshot(void) {
+  config_t *snapshot = config_new_clone(config);
+  config_set_int(snapshot, INFO_SECTION, JOURNAL_GENERATION, journal_generation + 1);
+  hash_map_clear(dirty);
+  return snapshot;
+}
+
+// Writes |snapshot| without unpaired devices, empties the journal and frees
+// |snapshot|. Called with |write_lock| held but not |lock|.
+static bool btif_config_save_snapshot(config_t *snapshot) {
+  btif_config_remove_unpaired(snapshot);
+  bool ret = config_save(snapshot, CONFIG_FILE_PATH);
+
+  if (ret) {
+    journal_generation++;
+    if (journal && !config_journal_reset(journal, journal_generation)) {
+      config_journal_close(journal);
+      journal = NULL;
+    }
+  }
+
+  btif_config_lock(false);
+  if (ret) {
+    config_set_int(config, INFO_SECTION, JOURNAL_GENERATION, journal_generation);
+    btif_config_reset_persisted(snapshot);
+    snapshot_needed = false;
+    journal_compactions++;
+    journal_bytes = journal ? config_journal_size(journal) : 0;
+  } else {
+    // The journal still belongs to the old snapshot, which may or may not
+    // have been replaced. Only a new snapshot is safe; retry it next time.
+    snapshot_needed = true;
+  }
+  btif_config_unlock();
+
+  config_free(snapshot);
+  return ret;
+}
+
+static bool btif_config_journal_entry(hash_map_entry_t *hash_entry, void *context) {
+  bool *ok = context;
+  char *section = osi_strdup(hash_entry->key);
+  char *key = strchr(section, '\n');
+  *key++ = '\0';
+
+  if (!config_has_section(config, section) || btif_config_is_unpaired(config, section)) {
+    // Unpaired devices are not persisted, as in a snapshot.
+    if (hash_map_has_key(persisted, section)) {
+      *ok = config_journal_remove_section(journal, section);
+      hash_map_erase(persisted, section);
+    }
+  } else if (!hash_map_has_key(persisted, section)) {
+    *ok = config_journal_add_section(journal, config, section);
+    hash_map_set(persisted, osi_strdup(section), NULL);
+  } else {
+    const char *value = config_get_string(config, section, key, NULL);
+    *ok = value ? config_journal_set(journal, section, key, value)
+                : config_journal_remove_key(journal, section, key);
+  }
+
+  osi_free(section);
+  return *ok;
+}
+
+// Records the keys changed since the last save in the journal, in memory only;
+// the caller commits them. Called with |lock| and |write_lock| held. Returns
+// false if a snapshot must be written instead.
+static bool btif_config_record_journal(void) {
+  bool ok = true;
+  hash_map_foreach(dirty, btif_config_journal_entry, &ok);
+  if (!ok)
+    return false;
+
+  hash_map_clear(dirty);
+  return true;
+}
+
+// Resets the sections known to be on disk to those of |persisted_config|.
+// Called with |lock| held.
+static void btif_config_reset_persisted(const config_t *persisted_config) {
+  hash_map_clear(persisted);
+
+  const config_section_node_t *snode = config_section_begin(persisted_config);
+  for (; snode != config_section_end(persisted_config); snode = config_section_next(snode))
+    hash_map_set(persisted, osi_strdup(config_section_name(snode)), NULL);
+}
+
+static void btif_config_lock(bool reader) {
+  uint64_t start_us = time_get_os_boottime_us();
   pthread_mutex_lock(&lock);
-  rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
-  config_t *config_paired = config_new_clone(config);
-  btif_config_remove_unpaired(config_paired);
-  config_save(config_paired, CONFIG_FILE_PATH);
-  config_free(config_paired);
+  lock_acquired_us = time_get_os_boottime_us();
+  if (reader)
+    btif_config_update_stat(&reader_wait, lock_acquired_us - start_us);
+}
+
+static void btif_config_unlock(void) {
+  btif_config_update_stat(&lock_hold, time_get_os_boottime_us() - lock_acquired_us);
   pthread_mutex_unlock(&lock);
 }
 
+static void btif_config_update_stat(lock_stat_t *stat, uint64_t elapsed_us) {
+  stat->count++;
+  stat->total_us += elapsed_us;
+  if (elapsed_us > stat->max_us)
+    stat->max_us = elapsed_us;
+}
+
+// Records that |key| of |section| changed since the last save. Called with
+// |lock| held.
+static void btif_config_mark_dirty(const char *section, const char *key) {
+  size_t len = strlen(section) + strlen(key) + 2;
+  char *entry = osi_malloc(len);
+  snprintf(entry, len, "%s\n%s", section, key);
+
+  if (hash_map_has_key(dirty, entry))
+    osi_free(entry);
+  else
+    hash_map_set(dirty, entry, NULL);
+}
+
+static bool string_equals(const void *key_a, const void *key_b) {
+  return !strcmp(key_a, key_b);
+}
+
+static int btif_config_count_sections(const config_t *conf) {
+  int count = 0;
+  const config_section_node_t *snode = config_section_begin(conf);
+  for (; snode != config_section_end(conf); snode = config_section_next(snode))
+    count++;
+  return count;
+}
+
+static bool btif_config_is_unpaired(const config_t *conf, const char *section) {
+  return string_is_bdaddr(section) &&
+         !config_has_key(conf, section, "LinkKey") &&
+         !config_has_key(conf, section, "LE_KEY_PENC") &&
+         !config_has_key(conf, section, "LE_KEY_PID") &&
+         !config_has_key(conf, section, "LE_KEY_PCSRK") &&
+         !config_has_key(conf, section, "LE_KEY_LENC") &&
+         !config_has_key(conf, section, "LE_KEY_LCSRK");
+}
+
 static void btif_config_remove_unpaired(config_t *conf) {
   assert(conf != NULL);
   int paired_devices = 0;
@@ -513,12 +803,7 @@ static void btif_config_remove_unpaired(config_t *conf) {
   while (snode != config_section_end(conf)) {
     const char *section = config_section_name(snode);
     if (string_is_bdaddr(section)) {
-      if (!config_has_key(conf, section, "LinkKey") &&
-          !config_has_key(conf, section, "LE_KEY_PENC") &&
-          !config_has_key(conf, section, "LE_KEY_PID") &&
-          !config_has_key(conf, section, "LE_KEY_PCSRK") &&
-          !config_has_key(conf, section, "LE_KEY_LENC") &&
-          !config_has_key(conf, section, "LE_KEY_LCSRK")) {
+      if (btif_config_is_unpaired(conf, section)) {
         snode = config_section_next(snode);
         config_remove_section(conf, section);
         continue;
@@ -562,6 +847,31 @@ void btif_debug_config_dump(int fd) {
     dprintf(fd, "  File created/tagged: %s\n", btif_config_time_created);
     dprintf(fd, "  File source: %s\n", config_get_string(config, INFO_SECTION,
                                            FILE_SOURCE, "Original"));
+
+    btif_config_lock(false);
+    lock_stat_t hold = lock_hold;
+    lock_stat_t wait = reader_wait;
+    lock_stat_t io = save_io;
+    size_t bytes = journal_bytes;
+    int compactions = journal_compactions;
+    btif_config_unlock();
+
+    if (bytes > 0)
+      dprintf(fd, "  Journal: %zu bytes, %d snapshots written\n", bytes, compactions);
+    else
+      dprintf(fd, "  Journal: disabled, %d snapshots written\n", compactions);
+    dprintf(fd, "  Lock held: %llu times, avg %llu us, max %llu us\n",
+            (unsigned long long)hold.count,
+            (unsigned long long)(hold.count ? hold.total_us / hold.count : 0),
+            (unsigned long long)hold.max_us);
+    dprintf(fd, "  Reader wait: %llu reads, avg %llu us, max %llu us\n",
+            (unsigned long long)wait.count,
+            (unsigned long long)(wait.count ? wait.total_us / wait.count : 0),
+            (unsigned long long)wait.max_us);
+    dprintf(fd, "  Save I/O: %llu saves, avg %llu us, max %llu us\n",
+            (unsigned long long)io.count,
+            (unsigned long long)(io.count ? io.total_us / io.count : 0),
+            (unsigned long long)io.max_us);
 }
 
 static void btif_config_remove_restricted(config_t* config) {
@@ -587,5 +897,7 @@ static bool is_factory_reset(void) {
 static void delete_config_files(void) {
   remove(CONFIG_FILE_PATH);
   remove(CONFIG_BACKUP_PATH);
+  remove(CONFIG_JOURNAL_PATH);
+  remove(BTIF_KEYSTORE_PATH);
   property_set("persist.bluetooth.factoryreset", "false");
 }
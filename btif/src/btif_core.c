@@ -58,6 +58,7 @@
 #include "osi/include/future.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/pool.h"
 #include "osi/include/properties.h"
 #include "osi/include/thread.h"
 #include "stack_manager.h"
@@ -82,6 +83,16 @@
 #define VENDOR_MAX_CMD_HDR_SIZE    (3)
 #define VENDOR_BD_ADDR_TYPE        (1)
 
+/* Context switch messages up to this size, header included, come out of
+*  btif_msg_pool instead of the heap. Most BTA callback parameters fit. */
+#ifndef BTIF_MSG_POOL_BLOCK_SIZE
+#define BTIF_MSG_POOL_BLOCK_SIZE   (512)
+#endif
+
+#ifndef BTIF_MSG_POOL_NUM_BLOCKS
+#define BTIF_MSG_POOL_NUM_BLOCKS   (64)
+#endif
+
 /************************************************************************************
 **  Local type definitions
 ************************************************************************************/
@@ -129,6 +140,10 @@ static UINT8 btif_dut_mode = 0;
 
 static thread_t *bt_jni_workqueue_thread;
 static const char *BT_JNI_WORKQUEUE_NAME = "bt_jni_workqueue";
+
+/* Created once and kept for the life of the process, so that messages
+*  still in flight across a stack restart are always released to it. */
+static pool_t *btif_msg_pool;
 static uid_set_t* uid_set = NULL;
 
 static BOOLEAN ssr_triggered = FALSE;
@@ -208,7 +223,8 @@ static void btif_context_switched(void *p_msg)
 bt_status_t btif_transfer_context (tBTIF_CBACK *p_cback, UINT16 event, char* p_params, int param_len, tBTIF_COPY_CBACK *p_copy_cback)
 {
     tBTIF_CONTEXT_SWITCH_CBACK *p_msg =
-        (tBTIF_CONTEXT_SWITCH_CBACK *)osi_malloc(sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len);
+        (tBTIF_CONTEXT_SWITCH_CBACK *)pool_alloc(btif_msg_pool,
+                                                 sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len);
 
     BTIF_TRACE_VERBOSE("btif_transfer_context event %d, len %d", event, param_len);
 
@@ -291,7 +307,7 @@ static void bt_jni_msg_ready(void *context) {
       BTIF_TRACE_ERROR("unhandled btif event (%d)", p_msg->event & BT_EVT_MASK);
       break;
   }
-  osi_free(p_msg);
+  pool_put(btif_msg_pool, p_msg);
 }
 
 /*******************************************************************************
@@ -308,7 +324,7 @@ void btif_sendmsg(void *p_msg)
 {
   if (!bt_jni_workqueue_thread) {
     BTIF_TRACE_ERROR("%s: message dropped, queue not initialized or gone", __func__);
-    osi_free(p_msg);
+    pool_put(btif_msg_pool, p_msg);
     return;
   }
 
@@ -519,6 +535,9 @@ bt_status_t btif_init_bluetooth() {
   memset(&btif_local_bd_addr, 0, sizeof(bt_bdaddr_t));
   btif_fetch_local_bdaddr(&btif_local_bd_addr);
 
+  if (btif_msg_pool == NULL)
+    btif_msg_pool = pool_new("btif_msg", BTIF_MSG_POOL_BLOCK_SIZE, BTIF_MSG_POOL_NUM_BLOCKS);
+
   bt_jni_workqueue_thread = thread_new(BT_JNI_WORKQUEUE_NAME);
   if (bt_jni_workqueue_thread == NULL) {
     LOG_ERROR(LOG_TAG, "%s Unable to create thread %s", __func__, BT_JNI_WORKQUEUE_NAME);
@@ -704,6 +723,7 @@ bt_status_t btif_cleanup_bluetooth(void)
 #endif
 
     btif_dm_cleanup();
+    btif_storage_free_keystore();
     btif_jni_disassociate();
     btif_queue_release();
 
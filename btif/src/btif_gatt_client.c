@@ -781,18 +781,13 @@ static void btif_gattc_upstreams_evt(uint16_t event, char* p_param)
         case BTA_GATTC_BTH_SCAN_RD_EVT:
         {
             btgatt_batch_track_cb_t *p_data = (btgatt_batch_track_cb_t*) p_param;
-            uint8_t *p_rep_data = NULL;
-
-            if (p_data->read_reports.data_len > 0 && NULL != p_data->read_reports.p_rep_data)
-            {
-                p_rep_data = osi_malloc(p_data->read_reports.data_len);
-                memcpy(p_rep_data, p_data->read_reports.p_rep_data, p_data->read_reports.data_len);
-            }
 
+            /* The report buffer was handed over by bta_batch_scan_reports_cb */
             HAL_CBACK(bt_gatt_callbacks, client->batchscan_reports_cb
                     , p_data->client_if, p_data->status, p_data->read_reports.report_format
-                    , p_data->read_reports.num_records, p_data->read_reports.data_len, p_rep_data);
-            osi_free(p_rep_data);
+                    , p_data->read_reports.num_records, p_data->read_reports.data_len
+                    , p_data->read_reports.p_rep_data);
+            osi_free(p_data->read_reports.p_rep_data);
             break;
         }
 
@@ -1010,18 +1005,12 @@ static void bta_batch_scan_reports_cb(tBTA_DM_BLE_REF_VALUE ref_value, UINT8 rep
     btif_scan_track_cb.read_reports.data_len = data_len;
     btif_scan_track_cb.read_reports.num_records = num_records;
 
-    if (data_len > 0)
-    {
-        btif_scan_track_cb.read_reports.p_rep_data = osi_malloc(data_len);
-        memcpy(btif_scan_track_cb.read_reports.p_rep_data, p_rep_data, data_len);
-        osi_free(p_rep_data);
-    }
+    /* Reports arrive in bounded batches; pass the batch buffer on as is and
+       let the upstream handler free it once the HAL callback returns. */
+    btif_scan_track_cb.read_reports.p_rep_data = p_rep_data;
 
     btif_transfer_context(btif_gattc_upstreams_evt, BTA_GATTC_BTH_SCAN_RD_EVT,
         (char*) &btif_scan_track_cb, sizeof(btgatt_batch_track_cb_t), NULL);
-
-    if (data_len > 0)
-        osi_free_and_reset((void **)&btif_scan_track_cb.read_reports.p_rep_data);
 }
 
 static void bta_scan_results_cb (tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_data)
@@ -1068,6 +1057,56 @@ static void bta_scan_results_cb (tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_dat
                                  (char*) &btif_cb, sizeof(btif_gattc_cb_t), NULL);
 }
 
+void btif_gattc_scan_dump(int fd)
+{
+    tBTM_BLE_ADV_DEDUP_STATS stats;
+    tBTM_BLE_BATCH_SCAN_STATS batch;
+    tBTM_HCI_TXN_STATS txn;
+    tGATT_CL_READ_STATS read;
+    UINT8 client;
+
+    BTM_BleGetAdvDedupStats(&stats);
+    BTM_BleGetBatchScanStats(&batch);
+    GATTC_GetReadStats(&read);
+
+    dprintf(fd, "\nLE Scan Report Suppression:\n");
+    dprintf(fd, "  Forwarded: %u (new %u, payload changed %u, RSSI changed %u, "
+            "refreshed %u, raw %u)\n", stats.forwarded, stats.new_adv,
+            stats.payload_changed, stats.rssi_changed, stats.refreshed, stats.raw);
+    dprintf(fd, "  Suppressed: %u\n", stats.suppressed);
+    dprintf(fd, "  Advertisers evicted: %u\n", stats.evicted);
+
+    dprintf(fd, "\nLE Batch Scan Reports:\n");
+    dprintf(fd, "  Reads: %u (%u responses, %u malformed)\n", batch.reads, batch.chunks,
+            batch.malformed);
+    dprintf(fd, "  Records: %u received, %u delivered in %u batches, %u merged\n",
+            batch.records_in, batch.records_out, batch.batches, batch.merged);
+    dprintf(fd, "  High water: %u bytes per batch, %u bytes per read\n",
+            batch.batch_high_water, batch.read_high_water);
+
+    dprintf(fd, "\nLE Controller Command Transactions:\n");
+    for (client = 0; client < BTM_HCI_TXN_MAX_CLIENTS; client++)
+    {
+        BTM_HciTxnGetStats(client, &txn);
+
+        dprintf(fd, "  %s: %u commands (%u failed, %u held, %u dropped), "
+                "%u in flight max\n",
+                client == BTM_HCI_TXN_APCF ? "Scan filter" : "Advertising",
+                txn.cmds, txn.failed, txn.held, txn.dropped, txn.in_flight_high_water);
+        dprintf(fd, "    Command latency: avg %llu us, max %u us\n",
+                txn.cmds ? (unsigned long long)(txn.cmd_total_us / txn.cmds) : 0ULL,
+                txn.cmd_max_us);
+        dprintf(fd, "    Transactions: %u, latency last %u us, avg %llu us, max %u us\n",
+                txn.txns, txn.txn_last_us,
+                txn.txns ? (unsigned long long)(txn.txn_total_us / txn.txns) : 0ULL,
+                txn.txn_max_us);
+    }
+
+    dprintf(fd, "\nGATT Client Read Coalescing:\n");
+    dprintf(fd, "  Read Multiple: %u sent, %u round trips saved, %u resent as reads\n",
+            read.read_multi_sent, read.rtt_saved, read.read_multi_fallback);
+}
+
 static void bta_track_adv_event_cb(tBTA_DM_BLE_TRACK_ADV_DATA *p_track_adv_data)
 {
     btgatt_track_adv_info_t btif_scan_track_cb;
@@ -1187,6 +1226,7 @@ static void btgattc_handle_event(uint16_t event, char* p_param)
         case BTIF_GATTC_UNREGISTER_APP:
             btif_gattc_clear_clientif(p_cb->client_if, TRUE);
             btif_gattc_decr_app_count();
+            BTA_DmBleSetRawScanReports(p_cb->client_if, FALSE);
             BTA_GATTC_AppDeregister(p_cb->client_if);
             break;
 
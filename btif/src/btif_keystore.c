@@ -0,0 +1,337 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_keystore"
+
+#include "btif_keystore.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+
+#if defined(OS_GENERIC)
+const char *BTIF_KEYSTORE_PATH = "bt_keys.bin";
+#else  // !defined(OS_GENERIC)
+const char *BTIF_KEYSTORE_PATH = "/data/misc/bluedroid/bt_keys.bin";
+#endif  // defined(OS_GENERIC)
+
+static const uint8_t KEYSTORE_MAGIC[4] = {'B', 'T', 'K', 'S'};
+static const uint16_t KEYSTORE_VERSION = 2;
+static const size_t KEYSTORE_INITIAL_CAPACITY = 16;
+
+typedef struct {
+  uint8_t magic[4];
+  uint16_t version;
+  uint16_t entry_size;
+  uint32_t count;
+  uint32_t generation;
+  uint32_t checksum;  // of the entries
+} keystore_header_t;
+
+struct btif_keystore_t {
+  btif_keystore_entry_t *entries;
+  size_t count;
+  size_t capacity;
+  uint32_t generation;
+};
+
+static bool grow(btif_keystore_t *keystore, size_t capacity);
+static uint32_t checksum(const void *data, size_t length);
+static bool read_all(int fd, void *buffer, size_t length);
+static bool write_all(int fd, const void *buffer, size_t length);
+
+btif_keystore_t *btif_keystore_new(void) {
+  btif_keystore_t *keystore = osi_calloc(sizeof(btif_keystore_t));
+  if (!grow(keystore, KEYSTORE_INITIAL_CAPACITY)) {
+    osi_free(keystore);
+    return NULL;
+  }
+  return keystore;
+}
+
+btif_keystore_t *btif_keystore_load(const char *path) {
+  assert(path != NULL);
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    if (errno != ENOENT)
+      LOG_ERROR(LOG_TAG, "%s unable to open '%s': %s", __func__, path, strerror(errno));
+    return NULL;
+  }
+
+  btif_keystore_t *keystore = NULL;
+  uint8_t *contents = NULL;
+
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to stat '%s': %s", __func__, path, strerror(errno));
+    goto done;
+  }
+
+  // The whole file is read at once and then checked, rather than entry by
+  // entry.
+  size_t size = (size_t)st.st_size;
+  if (size < sizeof(keystore_header_t))
+    goto invalid;
+  contents = osi_malloc(size);
+  if (!read_all(fd, contents, size)) {
+    LOG_ERROR(LOG_TAG, "%s unable to read '%s': %s", __func__, path, strerror(errno));
+    goto done;
+  }
+
+  keystore_header_t header;
+  memcpy(&header, contents, sizeof(header));
+  const uint8_t *entries = contents + sizeof(header);
+  size_t entries_size = size - sizeof(header);
+  if (memcmp(header.magic, KEYSTORE_MAGIC, sizeof(KEYSTORE_MAGIC)) != 0 ||
+      header.version != KEYSTORE_VERSION ||
+      header.entry_size != sizeof(btif_keystore_entry_t) ||
+      entries_size != (size_t)header.count * sizeof(btif_keystore_entry_t) ||
+      header.checksum != checksum(entries, entries_size))
+    goto invalid;
+
+  keystore = osi_calloc(sizeof(btif_keystore_t));
+  if (!grow(keystore, header.count > KEYSTORE_INITIAL_CAPACITY ?
+                      header.count : KEYSTORE_INITIAL_CAPACITY)) {
+    osi_free(keystore);
+    keystore = NULL;
+    goto done;
+  }
+  memcpy(keystore->entries, entries, entries_size);
+  keystore->count = header.count;
+  keystore->generation = header.generation;
+  goto done;
+
+invalid:
+  LOG_WARN(LOG_TAG, "%s ignoring invalid key store '%s'.", __func__, path);
+
+done:
+  osi_free(contents);
+  close(fd);
+  return keystore;
+}
+
+btif_keystore_t *btif_keystore_clone(const btif_keystore_t *keystore) {
+  assert(keystore != NULL);
+
+  btif_keystore_t *clone = osi_calloc(sizeof(btif_keystore_t));
+  if (!grow(clone, keystore->capacity)) {
+    osi_free(clone);
+    return NULL;
+  }
+  memcpy(clone->entries, keystore->entries, keystore->count * sizeof(btif_keystore_entry_t));
+  clone->count = keystore->count;
+  clone->generation = keystore->generation;
+  return clone;
+}
+
+void btif_keystore_free(btif_keystore_t *keystore) {
+  if (!keystore)
+    return;
+
+  osi_free(keystore->entries);
+  osi_free(keystore);
+}
+
+bool btif_keystore_save(btif_keystore_t *keystore, const char *path, uint32_t generation) {
+  assert(keystore != NULL);
+  assert(path != NULL);
+
+  // Same steps as config_save: write and sync a temp file, rename it over
+  // |path| and sync the directory.
+  static const char *temp_file_ext = ".new";
+  const size_t temp_path_len = strlen(path) + strlen(temp_file_ext) + 1;
+  char *temp_path = osi_calloc(temp_path_len);
+  snprintf(temp_path, temp_path_len, "%s%s", path, temp_file_ext);
+  char *temp_dirname = osi_strdup(path);
+  const char *dir_name = dirname(temp_dirname);
+  int dir_fd = -1;
+  int fd = -1;
+
+  dir_fd = open(dir_name, O_RDONLY);
+  if (dir_fd == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to open dir '%s': %s", __func__, dir_name, strerror(errno));
+    goto error;
+  }
+
+  fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to open '%s': %s", __func__, temp_path, strerror(errno));
+    goto error;
+  }
+
+  size_t entries_size = keystore->count * sizeof(btif_keystore_entry_t);
+  keystore_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, KEYSTORE_MAGIC, sizeof(KEYSTORE_MAGIC));
+  header.version = KEYSTORE_VERSION;
+  header.entry_size = sizeof(btif_keystore_entry_t);
+  header.count = keystore->count;
+  header.generation = generation;
+  header.checksum = checksum(keystore->entries, entries_size);
+
+  if (!write_all(fd, &header, sizeof(header)) ||
+      !write_all(fd, keystore->entries, entries_size)) {
+    LOG_ERROR(LOG_TAG, "%s unable to write '%s': %s", __func__, temp_path, strerror(errno));
+    goto error;
+  }
+
+  if (fsync(fd) == -1)
+    LOG_WARN(LOG_TAG, "%s unable to fsync '%s': %s", __func__, temp_path, strerror(errno));
+
+  if (close(fd) == -1) {
+    fd = -1;
+    LOG_ERROR(LOG_TAG, "%s unable to close '%s': %s", __func__, temp_path, strerror(errno));
+    goto error;
+  }
+  fd = -1;
+
+  if (rename(temp_path, path) == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to commit '%s': %s", __func__, path, strerror(errno));
+    goto error;
+  }
+
+  if (fsync(dir_fd) == -1)
+    LOG_WARN(LOG_TAG, "%s unable to fsync dir '%s': %s", __func__, dir_name, strerror(errno));
+  close(dir_fd);
+
+  keystore->generation = generation;
+  osi_free(temp_path);
+  osi_free(temp_dirname);
+  return true;
+
+error:
+  unlink(temp_path);
+  if (fd != -1)
+    close(fd);
+  if (dir_fd != -1)
+    close(dir_fd);
+  osi_free(temp_path);
+  osi_free(temp_dirname);
+  return false;
+}
+
+uint32_t btif_keystore_generation(const btif_keystore_t *keystore) {
+  assert(keystore != NULL);
+  return keystore->generation;
+}
+
+size_t btif_keystore_count(const btif_keystore_t *keystore) {
+  assert(keystore != NULL);
+  return keystore->count;
+}
+
+btif_keystore_entry_t *btif_keystore_at(btif_keystore_t *keystore, size_t index) {
+  assert(keystore != NULL);
+  assert(index < keystore->count);
+  return &keystore->entries[index];
+}
+
+btif_keystore_entry_t *btif_keystore_find(btif_keystore_t *keystore, const bt_bdaddr_t *addr,
+                                          bool create) {
+  assert(keystore != NULL);
+  assert(addr != NULL);
+
+  for (size_t i = 0; i < keystore->count; ++i) {
+    if (!memcmp(&keystore->entries[i].addr, addr, sizeof(bt_bdaddr_t)))
+      return &keystore->entries[i];
+  }
+
+  if (!create)
+    return NULL;
+
+  if (keystore->count == keystore->capacity && !grow(keystore, keystore->capacity * 2))
+    return NULL;
+
+  btif_keystore_entry_t *entry = &keystore->entries[keystore->count++];
+  memset(entry, 0, sizeof(*entry));
+  memcpy(&entry->addr, addr, sizeof(bt_bdaddr_t));
+  return entry;
+}
+
+void btif_keystore_remove(btif_keystore_t *keystore, const bt_bdaddr_t *addr) {
+  assert(keystore != NULL);
+  assert(addr != NULL);
+
+  btif_keystore_entry_t *entry = btif_keystore_find(keystore, addr, false);
+  if (!entry)
+    return;
+
+  btif_keystore_entry_t *end = keystore->entries + keystore->count;
+  memmove(entry, entry + 1, (end - entry - 1) * sizeof(*entry));
+  --keystore->count;
+}
+
+static bool grow(btif_keystore_t *keystore, size_t capacity) {
+  btif_keystore_entry_t *entries = osi_calloc(capacity * sizeof(btif_keystore_entry_t));
+  if (!entries)
+    return false;
+
+  if (keystore->entries)
+    memcpy(entries, keystore->entries, keystore->count * sizeof(btif_keystore_entry_t));
+  osi_free(keystore->entries);
+  keystore->entries = entries;
+  keystore->capacity = capacity;
+  return true;
+}
+
+// FNV-1a; only meant to catch truncated or corrupted files.
+static uint32_t checksum(const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static bool read_all(int fd, void *buffer, size_t length) {
+  uint8_t *p = (uint8_t *)buffer;
+  while (length > 0) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = read(fd, p, length));
+    if (ret <= 0)
+      return false;
+    p += ret;
+    length -= ret;
+  }
+  return true;
+}
+
+static bool write_all(int fd, const void *buffer, size_t length) {
+  const uint8_t *p = (const uint8_t *)buffer;
+  while (length > 0) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(fd, p, length));
+    if (ret <= 0)
+      return false;
+    p += ret;
+    length -= ret;
+  }
+  return true;
+}
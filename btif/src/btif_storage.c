@@ -35,6 +35,9 @@
 #include <alloca.h>
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -44,6 +47,7 @@
 #include "btif_api.h"
 #include "btif_config.h"
 #include "btif_hh.h"
+#include "btif_keystore.h"
 #include "btif_util.h"
 #include "bt_common.h"
 #include "osi/include/allocator.h"
@@ -76,6 +80,8 @@
 #define BTIF_STORAGE_KEY_ADAPTER_NAME "Name"
 #define BTIF_STORAGE_KEY_ADAPTER_SCANMODE "ScanMode"
 #define BTIF_STORAGE_KEY_ADAPTER_DISC_TIMEOUT "DiscoveryTimeout"
+#define BTIF_STORAGE_SECTION_INFO "Info"
+#define BTIF_STORAGE_KEY_KEYSTORE_GENERATION "KeyStoreGeneration"
 
 /* This is a local property to add a device found */
 #define BT_PROPERTY_REMOTE_DEVICE_TIMESTAMP 0xFF
@@ -147,6 +153,33 @@ typedef struct
     bt_bdaddr_t devices[BTM_SEC_MAX_DEVICE_RECORDS];
 } btif_bonded_devices_t;
 
+/************************************************************************************
+**  Static variables
+************************************************************************************/
+/* Binary copy of the bonding keys in the config, see btif_keystore.h. Loaded
+** on first use. Changes are written out with the config, see
+** btif_storage_write_keystore. */
+static pthread_mutex_t keystore_lock = PTHREAD_MUTEX_INITIALIZER;
+static btif_keystore_t *keystore;       /* protected by keystore_lock */
+static uint32_t keystore_generation;    /* of |keystore| in memory; protected by keystore_lock */
+static bool keystore_dirty;             /* protected by keystore_lock */
+
+#if (BLE_INCLUDED == TRUE)
+/* LE keys held in the key store slots, in the order they are restored */
+static const struct
+{
+    UINT8 key_type;
+    size_t key_len;
+} keystore_le_keys[BTIF_KEYSTORE_LE_KEY_SLOTS] =
+{
+    { BTIF_DM_LE_KEY_PENC, sizeof(tBTM_LE_PENC_KEYS) },
+    { BTIF_DM_LE_KEY_PID, sizeof(tBTM_LE_PID_KEYS) },
+    { BTIF_DM_LE_KEY_PCSRK, sizeof(tBTM_LE_PCSRK_KEYS) },
+    { BTIF_DM_LE_KEY_LENC, sizeof(tBTM_LE_LENC_KEYS) },
+    { BTIF_DM_LE_KEY_LCSRK, sizeof(tBTM_LE_LCSRK_KEYS) },
+};
+#endif
+
 /************************************************************************************
 **  External variables
 ************************************************************************************/
@@ -167,6 +200,18 @@ static bt_status_t btif_in_fetch_bonded_ble_device(const char *remote_bd_addr,in
                                               btif_bonded_devices_t *p_bonded_devices);
 #endif
 static bt_status_t btif_in_fetch_bonded_device(const char *bdstr, int *dev_type);
+static btif_keystore_t *btif_in_keystore_get(void);
+static uint32_t btif_in_keystore_changed(void);
+static void btif_in_keystore_stamp(uint32_t generation);
+static uint32_t btif_in_keystore_set_link_key(const bt_bdaddr_t *remote_bd_addr,
+                                              LINK_KEY link_key, uint8_t key_type,
+                                              uint8_t pin_length);
+static uint32_t btif_in_keystore_remove_link_key(const bt_bdaddr_t *remote_bd_addr);
+#if (BLE_INCLUDED == TRUE)
+static uint32_t btif_in_keystore_set_le_key(const bt_bdaddr_t *remote_bd_addr, UINT8 key_type,
+                                            const char *key, UINT8 key_length);
+static uint32_t btif_in_keystore_remove_le_keys(const bt_bdaddr_t *remote_bd_addr);
+#endif
 
 /************************************************************************************
 **  Static functions
@@ -447,73 +492,527 @@ static bt_status_t btif_in_fetch_bonded_device(const char *bdstr, int *p_dev_typ
 
 /*******************************************************************************
 **
-** Function         btif_in_fetch_bonded_devices
+** Function         btif_in_add_bonded_addr
 **
-** Description      Internal helper function to fetch the bonded devices
-**                  from NVRAM
+** Description      Internal helper function to append an address to the list
+**                  of bonded devices
 **
-** Returns          BT_STATUS_SUCCESS if successful, BT_STATUS_FAIL otherwise
+** Returns          void
 **
 *******************************************************************************/
-static bt_status_t btif_in_fetch_bonded_devices(btif_bonded_devices_t *p_bonded_devices, int add)
+static void btif_in_add_bonded_addr(btif_bonded_devices_t *p_bonded_devices,
+                                    const bt_bdaddr_t *bd_addr)
 {
-    memset(p_bonded_devices, 0, sizeof(btif_bonded_devices_t));
+    if (p_bonded_devices->num_devices >= BTM_SEC_MAX_DEVICE_RECORDS)
+    {
+        BTIF_TRACE_WARNING("%s too many bonded devices", __func__);
+        return;
+    }
+    memcpy(&p_bonded_devices->devices[p_bonded_devices->num_devices++], bd_addr,
+           sizeof(bt_bdaddr_t));
+}
 
-    BOOLEAN bt_linkkey_file_found=FALSE;
-#if BLE_INCLUDED == TRUE
+#if (BLE_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         btif_in_fetch_bonded_ble_keys
+**
+** Description      Internal helper function to add the LE keys of a key store
+**                  entry to BTA, if it is an LE device
+**
+** Returns          TRUE if the entry has LE keys, FALSE otherwise
+**
+*******************************************************************************/
+static BOOLEAN btif_in_fetch_bonded_ble_keys(const char *bdstr,
+                                             const btif_keystore_entry_t *entry, int add,
+                                             btif_bonded_devices_t *p_bonded_devices)
+{
     int device_type;
+    int addr_type;
+    bt_bdaddr_t bd_addr = entry->addr;
+    bool device_added = false;
+    bool key_found = false;
+
+    if (!btif_config_get_int(bdstr, "DevType", &device_type) ||
+        (device_type & BT_DEVICE_TYPE_BLE) != BT_DEVICE_TYPE_BLE)
+        return FALSE;
+
+    BTIF_TRACE_DEBUG("%s Found a LE device: %s", __func__, bdstr);
+
+    if (btif_storage_get_remote_addr_type(&bd_addr, &addr_type) != BT_STATUS_SUCCESS)
+    {
+        addr_type = BLE_ADDR_PUBLIC;
+        btif_storage_set_remote_addr_type(&bd_addr, BLE_ADDR_PUBLIC);
+    }
+
+    for (int slot = 0; slot < BTIF_KEYSTORE_LE_KEY_SLOTS; slot++)
+    {
+        if (!(entry->key_mask & BTIF_KEYSTORE_HAS_LE_KEY(slot)))
+            continue;
+
+        if (add)
+        {
+            if (!device_added)
+            {
+                BTA_DmAddBleDevice(bd_addr.address, addr_type, BT_DEVICE_TYPE_BLE);
+                device_added = true;
+            }
+
+            tBTA_LE_KEY_VALUE key_value;
+            size_t key_len = entry->le_key_len[slot];
+            if (key_len > sizeof(key_value))
+                key_len = sizeof(key_value);
+            memset(&key_value, 0, sizeof(key_value));
+            memcpy(&key_value, entry->le_key[slot], key_len);
+            BTIF_TRACE_DEBUG("%s() Adding key type %d for %s", __func__,
+                             keystore_le_keys[slot].key_type, bdstr);
+            BTA_DmAddBleKey(bd_addr.address, &key_value, keystore_le_keys[slot].key_type);
+        }
+
+        key_found = true;
+    }
+
+    /* LID has no payload, BTM only records that it was distributed */
+    if (entry->key_mask & BTIF_KEYSTORE_HAS_LE_LID)
+    {
+        if (add)
+        {
+            if (!device_added)
+            {
+                BTA_DmAddBleDevice(bd_addr.address, addr_type, BT_DEVICE_TYPE_BLE);
+                device_added = true;
+            }
+
+            tBTA_LE_KEY_VALUE key_value;
+            memset(&key_value, 0, sizeof(key_value));
+            BTIF_TRACE_DEBUG("%s() Adding key type %d for %s", __func__,
+                             BTIF_DM_LE_KEY_LID, bdstr);
+            BTA_DmAddBleKey(bd_addr.address, &key_value, BTIF_DM_LE_KEY_LID);
+        }
+
+        key_found = true;
+    }
+
+    // Fill in the bonded devices
+    if (device_added)
+    {
+        btif_in_add_bonded_addr(p_bonded_devices, &bd_addr);
+        btif_gatts_add_bonded_dev_from_nv(bd_addr.address);
+    }
+
+    return key_found;
+}
 #endif
 
+/*******************************************************************************
+**
+** Function         btif_in_keystore_rebuild
+**
+** Description      Internal helper function to build the key store from the
+**                  keys in the config
+**
+** Returns          The key store, or NULL if it could not be allocated
+**
+*******************************************************************************/
+static btif_keystore_t *btif_in_keystore_rebuild(void)
+{
+    btif_keystore_t *ks = btif_keystore_new();
+    if (ks == NULL)
+        return NULL;
+
     for (const btif_config_section_iter_t *iter = btif_config_section_begin(); iter != btif_config_section_end(); iter = btif_config_section_next(iter)) {
         const char *name = btif_config_section_name(iter);
         if (!string_is_bdaddr(name))
             continue;
 
-        BTIF_TRACE_DEBUG("Remote device:%s", name);
+        bt_bdaddr_t bd_addr;
+        string_to_bdaddr(name, &bd_addr);
+
         LINK_KEY link_key;
         size_t size = sizeof(link_key);
-        if (btif_config_get_bin(name, "LinkKey", link_key, &size)) {
-            int linkkey_type;
-            if (btif_config_get_int(name, "LinkKeyType", &linkkey_type)) {
-                bt_bdaddr_t bd_addr;
-                string_to_bdaddr(name, &bd_addr);
-                if (add) {
-                    DEV_CLASS dev_class = {0, 0, 0};
-                    int cod;
-                    int pin_length = 0;
-                    if (btif_config_get_int(name, "DevClass", &cod))
-                        uint2devclass((UINT32)cod, dev_class);
-                    btif_config_get_int(name, "PinLength", &pin_length);
-                    BTA_DmAddDevice(bd_addr.address, dev_class, link_key, 0, 0,
-                                    (UINT8)linkkey_type, 0, pin_length);
+        int linkkey_type;
+        if (btif_config_get_bin(name, "LinkKey", link_key, &size) &&
+            btif_config_get_int(name, "LinkKeyType", &linkkey_type))
+        {
+            btif_keystore_entry_t *entry = btif_keystore_find(ks, &bd_addr, true);
+            if (entry == NULL)
+                goto error;
+
+            int pin_length = 0;
+            btif_config_get_int(name, "PinLength", &pin_length);
+            entry->key_mask |= BTIF_KEYSTORE_HAS_LINK_KEY;
+            entry->link_key_type = (uint8_t)linkkey_type;
+            entry->pin_length = (uint8_t)pin_length;
+            memcpy(entry->link_key, link_key, LINK_KEY_LEN);
+        }
 
-#if BLE_INCLUDED == TRUE
-                    if (btif_config_get_int(name, "DevType", &device_type) &&
-                        (device_type == BT_DEVICE_TYPE_DUMO) ) {
-                        btif_gatts_add_bonded_dev_from_nv(bd_addr.address);
-                    }
+#if (BLE_INCLUDED == TRUE)
+        for (int slot = 0; slot < BTIF_KEYSTORE_LE_KEY_SLOTS; slot++)
+        {
+            char key[BTIF_KEYSTORE_LE_KEY_MAX];
+            memset(key, 0, sizeof(key));
+            if (btif_storage_get_ble_bonding_key(&bd_addr, keystore_le_keys[slot].key_type, key,
+                                                 keystore_le_keys[slot].key_len) != BT_STATUS_SUCCESS)
+                continue;
+
+            btif_keystore_entry_t *entry = btif_keystore_find(ks, &bd_addr, true);
+            if (entry == NULL)
+                goto error;
+
+            entry->key_mask |= BTIF_KEYSTORE_HAS_LE_KEY(slot);
+            entry->le_key_len[slot] = keystore_le_keys[slot].key_len;
+            memcpy(entry->le_key[slot], key, keystore_le_keys[slot].key_len);
+        }
+
+        char lid[BTIF_KEYSTORE_LE_KEY_MAX];
+        if (btif_storage_get_ble_bonding_key(&bd_addr, BTIF_DM_LE_KEY_LID, lid,
+                                             sizeof(lid)) == BT_STATUS_SUCCESS)
+        {
+            btif_keystore_entry_t *entry = btif_keystore_find(ks, &bd_addr, true);
+            if (entry == NULL)
+                goto error;
+
+            entry->key_mask |= BTIF_KEYSTORE_HAS_LE_LID;
+        }
 #endif
-                }
-                bt_linkkey_file_found = TRUE;
-                memcpy(&p_bonded_devices->devices[p_bonded_devices->num_devices++], &bd_addr, sizeof(bt_bdaddr_t));
-            } else {
+    }
+
+    BTIF_TRACE_EVENT("%s: %zu devices with keys", __func__, btif_keystore_count(ks));
+    return ks;
+
+error:
+    btif_keystore_free(ks);
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_keystore_get
+**
+** Description      Internal helper function to get the key store, loading it
+**                  or rebuilding it from the config on first use. The caller
+**                  must hold keystore_lock.
+**
+** Returns          The key store, or NULL if it could not be allocated
+**
+*******************************************************************************/
+static btif_keystore_t *btif_in_keystore_get(void)
+{
+    if (keystore != NULL)
+        return keystore;
+
+    /* The file is only used if it was saved along with the current config */
+    int generation = 0;
+    btif_config_get_int(BTIF_STORAGE_SECTION_INFO, BTIF_STORAGE_KEY_KEYSTORE_GENERATION,
+                        &generation);
+
+    keystore = btif_keystore_load(BTIF_KEYSTORE_PATH);
+    if (keystore != NULL && generation != 0 &&
+        btif_keystore_generation(keystore) == (uint32_t)generation)
+    {
+        keystore_generation = (uint32_t)generation;
+        keystore_dirty = false;
+        return keystore;
+    }
+
+    /* Rebuilt stores get a generation that no file on disk can have */
+    keystore_generation = (uint32_t)generation;
+    if (keystore != NULL && btif_keystore_generation(keystore) > keystore_generation)
+        keystore_generation = btif_keystore_generation(keystore);
+    btif_keystore_free(keystore);
+
+    BTIF_TRACE_WARNING("%s rebuilding key store from config", __func__);
+    keystore = btif_in_keystore_rebuild();
+    if (keystore != NULL)
+    {
+        /* The config already holds every key in the rebuilt store */
+        btif_in_keystore_stamp(btif_in_keystore_changed());
+        btif_config_save();
+    }
+    return keystore;
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_keystore_changed
+**
+** Description      Internal helper function to mark the key store as changed,
+**                  before the same change is made to the config. The store is
+**                  written by btif_storage_write_keystore on the next config
+**                  save. The caller must hold keystore_lock.
+**
+** Returns          The generation to record with btif_in_keystore_stamp once
+**                  the config holds the change
+**
+*******************************************************************************/
+static uint32_t btif_in_keystore_changed(void)
+{
+    keystore_dirty = true;
+    return ++keystore_generation;
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_keystore_stamp
+**
+** Description      Internal helper function to record in the config that the
+**                  key store with |generation| matches it
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_in_keystore_stamp(uint32_t generation)
+{
+    if (generation != 0)
+        btif_config_set_int(BTIF_STORAGE_SECTION_INFO, BTIF_STORAGE_KEY_KEYSTORE_GENERATION,
+                            (int)generation);
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_keystore_set_link_key
+**
+** Description      Internal helper function to store a link key in the key
+**                  store
+**
+** Returns          The generation to stamp, or 0 if there is none
+**
+*******************************************************************************/
+static uint32_t btif_in_keystore_set_link_key(const bt_bdaddr_t *remote_bd_addr,
+                                              LINK_KEY link_key, uint8_t key_type,
+                                              uint8_t pin_length)
+{
+    uint32_t generation = 0;
+
+    pthread_mutex_lock(&keystore_lock);
+    btif_keystore_t *ks = btif_in_keystore_get();
+    btif_keystore_entry_t *entry = ks ? btif_keystore_find(ks, remote_bd_addr, true) : NULL;
+    if (entry != NULL)
+    {
+        entry->key_mask |= BTIF_KEYSTORE_HAS_LINK_KEY;
+        entry->link_key_type = key_type;
+        entry->pin_length = pin_length;
+        memcpy(entry->link_key, link_key, LINK_KEY_LEN);
+        generation = btif_in_keystore_changed();
+    }
+    pthread_mutex_unlock(&keystore_lock);
+
+    return generation;
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_keystore_remove_link_key
+**
+** Description      Internal helper function to remove a link key from the key
+**                  store
+**
+** Returns          The generation to stamp, or 0 if there is none
+**
+*******************************************************************************/
+static uint32_t btif_in_keystore_remove_link_key(const bt_bdaddr_t *remote_bd_addr)
+{
+    uint32_t generation = 0;
+
+    pthread_mutex_lock(&keystore_lock);
+    btif_keystore_t *ks = btif_in_keystore_get();
+    btif_keystore_entry_t *entry = ks ? btif_keystore_find(ks, remote_bd_addr, false) : NULL;
+    if (entry != NULL && (entry->key_mask & BTIF_KEYSTORE_HAS_LINK_KEY))
+    {
+        entry->key_mask &= ~BTIF_KEYSTORE_HAS_LINK_KEY;
+        memset(entry->link_key, 0, sizeof(entry->link_key));
+        if (entry->key_mask == 0)
+            btif_keystore_remove(ks, remote_bd_addr);
+        generation = btif_in_keystore_changed();
+    }
+    pthread_mutex_unlock(&keystore_lock);
+
+    return generation;
+}
+
 #if (BLE_INCLUDED == TRUE)
-                bt_linkkey_file_found = FALSE;
-#else
-                BTIF_TRACE_ERROR("bounded device:%s, LinkKeyType or PinLength is invalid", name);
+/*******************************************************************************
+**
+** Function         btif_in_keystore_set_le_key
+**
+** Description      Internal helper function to store an LE key in the key
+**                  store. Key types without a slot or a key_mask bit are only
+**                  kept in the config.
+**
+** Returns          The generation to stamp, or 0 if there is none
+**
+*******************************************************************************/
+static uint32_t btif_in_keystore_set_le_key(const bt_bdaddr_t *remote_bd_addr, UINT8 key_type,
+                                            const char *key, UINT8 key_length)
+{
+    int slot;
+    for (slot = 0; slot < BTIF_KEYSTORE_LE_KEY_SLOTS; slot++)
+    {
+        if (keystore_le_keys[slot].key_type == key_type)
+            break;
+    }
+    if (slot == BTIF_KEYSTORE_LE_KEY_SLOTS && key_type != BTIF_DM_LE_KEY_LID)
+        return 0;
+
+    uint32_t generation = 0;
+
+    pthread_mutex_lock(&keystore_lock);
+    btif_keystore_t *ks = btif_in_keystore_get();
+    if (ks != NULL && key_length > BTIF_KEYSTORE_LE_KEY_MAX)
+    {
+        /* Cannot be held; leave the config as the only copy */
+        BTIF_TRACE_ERROR("%s key type %d too long: %d", __func__, key_type, key_length);
+        btif_config_remove(BTIF_STORAGE_SECTION_INFO, BTIF_STORAGE_KEY_KEYSTORE_GENERATION);
+        btif_keystore_free(keystore);
+        keystore = NULL;
+        keystore_dirty = false;
+        ks = NULL;
+    }
+
+    btif_keystore_entry_t *entry = ks ? btif_keystore_find(ks, remote_bd_addr, true) : NULL;
+    if (entry != NULL && key_type == BTIF_DM_LE_KEY_LID)
+    {
+        entry->key_mask |= BTIF_KEYSTORE_HAS_LE_LID;
+        generation = btif_in_keystore_changed();
+    }
+    else if (entry != NULL)
+    {
+        entry->key_mask |= BTIF_KEYSTORE_HAS_LE_KEY(slot);
+        entry->le_key_len[slot] = key_length;
+        memset(entry->le_key[slot], 0, sizeof(entry->le_key[slot]));
+        memcpy(entry->le_key[slot], key, key_length);
+        generation = btif_in_keystore_changed();
+    }
+    pthread_mutex_unlock(&keystore_lock);
+
+    return generation;
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_keystore_remove_le_keys
+**
+** Description      Internal helper function to remove the LE keys of a device
+**                  from the key store
+**
+** Returns          The generation to stamp, or 0 if there is none
+**
+*******************************************************************************/
+static uint32_t btif_in_keystore_remove_le_keys(const bt_bdaddr_t *remote_bd_addr)
+{
+    const uint8_t le_key_mask = (uint8_t)~BTIF_KEYSTORE_HAS_LINK_KEY;
+    uint32_t generation = 0;
+
+    pthread_mutex_lock(&keystore_lock);
+    btif_keystore_t *ks = btif_in_keystore_get();
+    btif_keystore_entry_t *entry = ks ? btif_keystore_find(ks, remote_bd_addr, false) : NULL;
+    if (entry != NULL && (entry->key_mask & le_key_mask))
+    {
+        entry->key_mask &= ~le_key_mask;
+        memset(entry->le_key_len, 0, sizeof(entry->le_key_len));
+        memset(entry->le_key, 0, sizeof(entry->le_key));
+        if (entry->key_mask == 0)
+            btif_keystore_remove(ks, remote_bd_addr);
+        generation = btif_in_keystore_changed();
+    }
+    pthread_mutex_unlock(&keystore_lock);
+
+    return generation;
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         btif_in_fetch_bonded_devices
+**
+** Description      Internal helper function to fetch the bonded devices
+**                  from NVRAM
+**
+** Returns          BT_STATUS_SUCCESS if successful, BT_STATUS_FAIL otherwise
+**
+*******************************************************************************/
+static bt_status_t btif_in_fetch_bonded_devices(btif_bonded_devices_t *p_bonded_devices, int add)
+{
+    memset(p_bonded_devices, 0, sizeof(btif_bonded_devices_t));
+
+    pthread_mutex_lock(&keystore_lock);
+    btif_keystore_t *ks = btif_in_keystore_get();
+    if (ks == NULL)
+    {
+        pthread_mutex_unlock(&keystore_lock);
+        return BT_STATUS_NOMEM;
+    }
+
+    /* The link keys are handed to BTA in one message once all are known */
+    tBTA_DM_BONDED_DEV *p_devs = NULL;
+    UINT16 num_devs = 0;
+    if (add && btif_keystore_count(ks) > 0)
+        p_devs = (tBTA_DM_BONDED_DEV *)osi_malloc(btif_keystore_count(ks) * sizeof(tBTA_DM_BONDED_DEV));
+
+    bool removed = false;
+    size_t i = 0;
+    while (i < btif_keystore_count(ks))
+    {
+        btif_keystore_entry_t *entry = btif_keystore_at(ks, i);
+        bdstr_t bdstr;
+        bdaddr_to_string(&entry->addr, bdstr, sizeof(bdstr));
+
+        /* Sections can also be removed by btif_config, e.g. restricted pairings */
+        if (!btif_config_has_section(bdstr))
+        {
+            btif_keystore_remove(ks, &entry->addr);
+            removed = true;
+            continue;
+        }
+        i++;
+
+        BTIF_TRACE_DEBUG("Remote device:%s", bdstr);
+        BOOLEAN bt_linkkey_file_found = FALSE;
+        if (entry->key_mask & BTIF_KEYSTORE_HAS_LINK_KEY)
+        {
+            if (add)
+            {
+                tBTA_DM_BONDED_DEV *p_dev = &p_devs[num_devs++];
+                int cod;
+                memset(p_dev, 0, sizeof(*p_dev));
+                bdcpy(p_dev->bd_addr, entry->addr.address);
+                if (btif_config_get_int(bdstr, "DevClass", &cod))
+                    uint2devclass((UINT32)cod, p_dev->dev_class);
+                memcpy(p_dev->link_key, entry->link_key, LINK_KEY_LEN);
+                p_dev->key_type = entry->link_key_type;
+                p_dev->pin_length = entry->pin_length;
+
+#if BLE_INCLUDED == TRUE
+                int device_type;
+                if (btif_config_get_int(bdstr, "DevType", &device_type) &&
+                    (device_type == BT_DEVICE_TYPE_DUMO) ) {
+                    btif_gatts_add_bonded_dev_from_nv(p_dev->bd_addr);
+                }
 #endif
             }
+            bt_linkkey_file_found = TRUE;
+            btif_in_add_bonded_addr(p_bonded_devices, &entry->addr);
         }
 #if (BLE_INCLUDED == TRUE)
-        if (!btif_in_fetch_bonded_ble_device(name, add, p_bonded_devices) &&
+        if (!btif_in_fetch_bonded_ble_keys(bdstr, entry, add, p_bonded_devices) &&
             !bt_linkkey_file_found) {
-            BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found", name);
+            BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found", bdstr);
         }
 #else
         if(!bt_linkkey_file_found)
-            BTIF_TRACE_DEBUG("Remote device:%s, no link key", name);
+            BTIF_TRACE_DEBUG("Remote device:%s, no link key", bdstr);
 #endif
     }
+
+    if (removed)
+    {
+        btif_in_keystore_stamp(btif_in_keystore_changed());
+        btif_config_save();
+    }
+    pthread_mutex_unlock(&keystore_lock);
+
+    BTA_DmAddDevices(p_devs, num_devs);
+    osi_free(p_devs);
     return BT_STATUS_SUCCESS;
 }
 
@@ -805,9 +1304,12 @@ bt_status_t btif_storage_add_bonded_device(bt_bdaddr_t *remote_bd_addr,
 {
     bdstr_t bdstr;
     bdaddr_to_string(remote_bd_addr, bdstr, sizeof(bdstr));
+    uint32_t generation = btif_in_keystore_set_link_key(remote_bd_addr, link_key,
+                                                        key_type, pin_length);
     int ret = btif_config_set_int(bdstr, "LinkKeyType", (int)key_type);
     ret &= btif_config_set_int(bdstr, "PinLength", (int)pin_length);
     ret &= btif_config_set_bin(bdstr, "LinkKey", link_key, sizeof(LINK_KEY));
+    btif_in_keystore_stamp(generation);
 
     if (is_restricted_mode()) {
         BTIF_TRACE_WARNING("%s: '%s' pairing will be removed if unrestricted",
@@ -840,6 +1342,7 @@ bt_status_t btif_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr)
     btif_storage_remove_ble_bonding_keys(remote_bd_addr);
 #endif
 
+    uint32_t generation = btif_in_keystore_remove_link_key(remote_bd_addr);
     int ret = 1;
     if(btif_config_exist(bdstr, "LinkKeyType"))
         ret &= btif_config_remove(bdstr, "LinkKeyType");
@@ -847,6 +1350,7 @@ bt_status_t btif_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr)
         ret &= btif_config_remove(bdstr, "PinLength");
     if(btif_config_exist(bdstr, "LinkKey"))
         ret &= btif_config_remove(bdstr, "LinkKey");
+    btif_in_keystore_stamp(generation);
     /* write bonded info immediately */
     btif_config_flush();
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
@@ -1004,6 +1508,98 @@ bt_status_t btif_storage_load_bonded_devices(void)
     return BT_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+**
+** Function         btif_storage_write_keystore
+**
+** Description      BTIF storage API - Writes the key store to NVRAM if it has
+**                  changed since it was last written. Called by btif_config
+**                  before it saves the config, so that a saved key store
+**                  generation is never ahead of the store on disk.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_write_keystore(void)
+{
+    pthread_mutex_lock(&keystore_lock);
+    if (!keystore_dirty || keystore == NULL)
+    {
+        pthread_mutex_unlock(&keystore_lock);
+        return;
+    }
+
+    /* The file is written from a copy so that key changes do not wait for it */
+    btif_keystore_t *ks = btif_keystore_clone(keystore);
+    uint32_t generation = keystore_generation;
+    keystore_dirty = false;
+    pthread_mutex_unlock(&keystore_lock);
+
+    if (ks != NULL && btif_keystore_save(ks, BTIF_KEYSTORE_PATH, generation))
+    {
+        btif_keystore_free(ks);
+        return;
+    }
+    btif_keystore_free(ks);
+
+    /* Keep the old file from being trusted; retried on the next config save */
+    BTIF_TRACE_ERROR("%s unable to write key store generation %u", __func__, generation);
+    btif_config_remove(BTIF_STORAGE_SECTION_INFO, BTIF_STORAGE_KEY_KEYSTORE_GENERATION);
+    pthread_mutex_lock(&keystore_lock);
+    if (keystore != NULL)
+        keystore_dirty = true;
+    pthread_mutex_unlock(&keystore_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_free_keystore
+**
+** Description      BTIF storage API - Frees the key store held in memory. It is
+**                  loaded and checked against the config again on next use,
+**                  which may be a different config after the stack restarts.
+**                  Changes that were not written yet are written first; if
+**                  that fails the config no longer vouches for the file.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_free_keystore(void)
+{
+    btif_storage_write_keystore();
+
+    pthread_mutex_lock(&keystore_lock);
+    btif_keystore_free(keystore);
+    keystore = NULL;
+    keystore_generation = 0;
+    keystore_dirty = false;
+    pthread_mutex_unlock(&keystore_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_clear_keystore
+**
+** Description      BTIF storage API - Frees the key store held in memory and
+**                  deletes the file, discarding unwritten changes. Used when
+**                  the config is cleared, so no key outlives it.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_clear_keystore(void)
+{
+    pthread_mutex_lock(&keystore_lock);
+    btif_keystore_free(keystore);
+    keystore = NULL;
+    keystore_generation = 0;
+    keystore_dirty = false;
+    if (remove(BTIF_KEYSTORE_PATH) != 0 && errno != ENOENT)
+        BTIF_TRACE_ERROR("%s unable to delete %s: %s", __func__, BTIF_KEYSTORE_PATH,
+                         strerror(errno));
+    pthread_mutex_unlock(&keystore_lock);
+}
+
 #if (BLE_INCLUDED == TRUE)
 
 /*******************************************************************************
@@ -1049,7 +1645,9 @@ bt_status_t btif_storage_add_ble_bonding_key(bt_bdaddr_t *remote_bd_addr,
         default:
             return BT_STATUS_FAIL;
     }
+    uint32_t generation = btif_in_keystore_set_le_key(remote_bd_addr, key_type, key, key_length);
     int ret = btif_config_set_bin(bdstr, name, (const uint8_t *)key, key_length);
+    btif_in_keystore_stamp(generation);
     btif_config_save();
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 }
@@ -1091,6 +1689,7 @@ bt_status_t btif_storage_get_ble_bonding_key(bt_bdaddr_t *remote_bd_addr,
             break;
         case BTIF_DM_LE_KEY_LID:
             name =  "LE_KEY_LID";
+            break;
         default:
             return BT_STATUS_FAIL;
     }
@@ -1115,6 +1714,7 @@ bt_status_t btif_storage_remove_ble_bonding_keys(bt_bdaddr_t *remote_bd_addr)
     bdstr_t bdstr;
     bdaddr_to_string(remote_bd_addr, bdstr, sizeof(bdstr));
     BTIF_TRACE_DEBUG(" %s in bd addr:%s",__FUNCTION__, bdstr);
+    uint32_t generation = btif_in_keystore_remove_le_keys(remote_bd_addr);
     int ret = 1;
     if(btif_config_exist(bdstr, "LE_KEY_PENC"))
         ret &= btif_config_remove(bdstr, "LE_KEY_PENC");
@@ -1126,6 +1726,9 @@ bt_status_t btif_storage_remove_ble_bonding_keys(bt_bdaddr_t *remote_bd_addr)
         ret &= btif_config_remove(bdstr, "LE_KEY_LENC");
     if(btif_config_exist(bdstr, "LE_KEY_LCSRK"))
         ret &= btif_config_remove(bdstr, "LE_KEY_LCSRK");
+    if(btif_config_exist(bdstr, "LE_KEY_LID"))
+        ret &= btif_config_remove(bdstr, "LE_KEY_LID");
+    btif_in_keystore_stamp(generation);
     btif_config_save();
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 }
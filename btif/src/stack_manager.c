@@ -28,6 +28,7 @@
 #include "btif_api.h"
 #include "btif_common.h"
 #include "device/include/controller.h"
+#include "device/include/interop.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/semaphore.h"
@@ -37,6 +38,7 @@
 #include "btif_config.h"
 #include "btif_profile_queue.h"
 #include "bt_utils.h"
+#include "stack_config.h"
 
 static thread_t *management_thread;
 
@@ -116,8 +118,19 @@ static void event_init_stack(void *context) {
     module_management_start();
 
     module_init(get_module(OSI_MODULE));
-    module_init(get_module(BT_UTILS_MODULE));
-    module_init(get_module(BTIF_CONFIG_MODULE));
+
+    // Everything else relies on osi. These load their own files, so they
+    // are initialized concurrently as their dependencies allow.
+    const module_t *modules[] = {
+      get_module(BTIF_CONFIG_MODULE),
+      get_module(STACK_CONFIG_MODULE),
+      get_module(INTEROP_MODULE),
+      get_module(BT_UTILS_MODULE),
+      NULL
+    };
+    if (!module_init_all(modules))
+      LOG_ERROR(LOG_TAG, "%s not every module was initialized", __func__);
+
     btif_init_bluetooth();
 
     // stack init is synchronous, so no waiting necessary here
@@ -223,6 +236,8 @@ static void event_clean_up_stack(void *context) {
   stack_is_initialized = false;
 
   btif_cleanup_bluetooth();
+  module_clean_up(get_module(STACK_CONFIG_MODULE));
+  module_clean_up(get_module(INTEROP_MODULE));
   module_clean_up(get_module(BTIF_CONFIG_MODULE));
   module_clean_up(get_module(BT_UTILS_MODULE));
   module_clean_up(get_module(OSI_MODULE));
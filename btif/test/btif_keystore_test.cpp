@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+#include "btif/include/btif_keystore.h"
+}
+
+static const char KEYSTORE_FILE[] = "/data/local/tmp/btif_keystore_test.bin";
+
+static bt_bdaddr_t make_addr(uint8_t last) {
+  bt_bdaddr_t addr = {{0x00, 0x11, 0x22, 0x33, 0x44, last}};
+  return addr;
+}
+
+class BtifKeystoreTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() { remove(KEYSTORE_FILE); }
+  virtual void TearDown() { remove(KEYSTORE_FILE); }
+};
+
+TEST_F(BtifKeystoreTest, test_missing_file) {
+  EXPECT_TRUE(btif_keystore_load(KEYSTORE_FILE) == NULL);
+}
+
+TEST_F(BtifKeystoreTest, test_find_remove) {
+  btif_keystore_t *keystore = btif_keystore_new();
+  ASSERT_TRUE(keystore != NULL);
+
+  bt_bdaddr_t addrs[40];
+  for (int i = 0; i < 40; ++i) {
+    addrs[i] = make_addr(i);
+    btif_keystore_entry_t *entry = btif_keystore_find(keystore, &addrs[i], true);
+    ASSERT_TRUE(entry != NULL);
+    entry->pin_length = i;
+  }
+  EXPECT_EQ(40u, btif_keystore_count(keystore));
+  EXPECT_EQ(7, btif_keystore_find(keystore, &addrs[7], false)->pin_length);
+
+  btif_keystore_remove(keystore, &addrs[7]);
+  EXPECT_EQ(39u, btif_keystore_count(keystore));
+  EXPECT_TRUE(btif_keystore_find(keystore, &addrs[7], false) == NULL);
+
+  // Entries keep their order.
+  EXPECT_EQ(6, btif_keystore_at(keystore, 6)->pin_length);
+  EXPECT_EQ(8, btif_keystore_at(keystore, 7)->pin_length);
+
+  btif_keystore_free(keystore);
+}
+
+TEST_F(BtifKeystoreTest, test_save_load) {
+  btif_keystore_t *keystore = btif_keystore_new();
+  bt_bdaddr_t addr = make_addr(1);
+  btif_keystore_entry_t *entry = btif_keystore_find(keystore, &addr, true);
+  entry->key_mask = BTIF_KEYSTORE_HAS_LINK_KEY | BTIF_KEYSTORE_HAS_LE_KEY(2);
+  entry->link_key_type = 5;
+  memset(entry->link_key, 0xab, sizeof(entry->link_key));
+  entry->le_key_len[2] = 20;
+  memset(entry->le_key[2], 0xcd, 20);
+
+  ASSERT_TRUE(btif_keystore_save(keystore, KEYSTORE_FILE, 42));
+  EXPECT_EQ(42u, btif_keystore_generation(keystore));
+
+  btif_keystore_t *loaded = btif_keystore_load(KEYSTORE_FILE);
+  ASSERT_TRUE(loaded != NULL);
+  EXPECT_EQ(42u, btif_keystore_generation(loaded));
+  ASSERT_EQ(1u, btif_keystore_count(loaded));
+  EXPECT_EQ(0, memcmp(entry, btif_keystore_at(loaded, 0), sizeof(*entry)));
+
+  btif_keystore_free(loaded);
+  btif_keystore_free(keystore);
+}
+
+TEST_F(BtifKeystoreTest, test_clone) {
+  btif_keystore_t *keystore = btif_keystore_new();
+  bt_bdaddr_t addr = make_addr(1);
+  btif_keystore_find(keystore, &addr, true)->pin_length = 4;
+
+  btif_keystore_t *clone = btif_keystore_clone(keystore);
+  ASSERT_TRUE(clone != NULL);
+
+  // The copy does not share entries with the original.
+  btif_keystore_find(keystore, &addr, false)->pin_length = 6;
+  ASSERT_EQ(1u, btif_keystore_count(clone));
+  EXPECT_EQ(4, btif_keystore_find(clone, &addr, false)->pin_length);
+
+  ASSERT_TRUE(btif_keystore_save(clone, KEYSTORE_FILE, 3));
+  EXPECT_EQ(3u, btif_keystore_generation(clone));
+  EXPECT_EQ(0u, btif_keystore_generation(keystore));
+
+  btif_keystore_free(clone);
+  btif_keystore_free(keystore);
+}
+
+TEST_F(BtifKeystoreTest, test_corrupt_file) {
+  btif_keystore_t *keystore = btif_keystore_new();
+  bt_bdaddr_t addr = make_addr(1);
+  btif_keystore_find(keystore, &addr, true)->pin_length = 4;
+  ASSERT_TRUE(btif_keystore_save(keystore, KEYSTORE_FILE, 1));
+  btif_keystore_free(keystore);
+
+  // Flip a byte of the entry.
+  FILE *file = fopen(KEYSTORE_FILE, "r+b");
+  ASSERT_TRUE(file != NULL);
+  fseek(file, -1, SEEK_END);
+  fputc(0xff, file);
+  fclose(file);
+  EXPECT_TRUE(btif_keystore_load(KEYSTORE_FILE) == NULL);
+
+  // Truncate it.
+  file = fopen(KEYSTORE_FILE, "wb");
+  fputs("BTKS", file);
+  fclose(file);
+  EXPECT_TRUE(btif_keystore_load(KEYSTORE_FILE) == NULL);
+}
@@ -226,7 +226,7 @@ bool interop_match_addr_get_max_lat(const interop_feature_t feature,
 // of |addr|, implementing the workaround identified by |feature|. |addr| may not be
 // null and |length| must be greater than 0 and less than sizeof(bt_bdaddr_t).
 // As |interop_feature_t| is not exposed in the public API, feature must be a valid
-// integer representing an optoin in the enum.
+// integer representing an optoin in the enum; entries with any other value are ignored.
 void interop_database_add(const uint16_t feature, const bt_bdaddr_t *addr, size_t length);
 
 // Clear the dynamic portion of the interoperability workaround database.
@@ -19,6 +19,8 @@
 #define LOG_TAG "bt_device_interop"
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h> // For memcmp
 
 #include "btcore/include/module.h"
@@ -27,23 +29,68 @@
 #include "osi/include/allocator.h"
 #include "osi/include/list.h"
 #include "osi/include/log.h"
+#include "osi/include/osi.h"
 
 #define CASE_RETURN_STR(const) case const: return #const;
 
+// Address and name prefixes are kept in byte tries, so a lookup costs at
+// most one step per byte of the address or name, however many entries the
+// database has. Every node records the features of the prefixes ending at
+// it and of its whole subtree; a lookup stops as soon as the subtree holds
+// nothing for the feature asked about.
+typedef struct {
+  uint64_t features;      // prefixes ending here
+  uint64_t subtree;       // prefixes ending here or below
+  uint16_t first_child;   // children are contiguous and sorted by |byte|
+  uint16_t num_children;
+  uint8_t byte;
+} interop_trie_node_t;
+
+typedef struct {
+  interop_trie_node_t *nodes;
+  size_t num_nodes;
+} interop_trie_t;
+
+typedef struct {
+  const uint8_t *key;
+  size_t length;
+  interop_feature_t feature;
+} interop_trie_key_t;
+
+#define INTEROP_FEATURE_BIT(feature) (1ULL << (feature))
+
+// Every feature needs a bit in the 64-bit trie node masks.
+COMPILE_ASSERT(END_OF_INTEROP_LIST <= 64);
+
+// The dynamic entries; the address trie holds these and the fixed ones.
 static list_t *interop_list = NULL;
 
+// Protects the tries, which are built on first use and rebuilt when the
+// dynamic database changes.
+static pthread_mutex_t interop_lock = PTHREAD_MUTEX_INITIALIZER;
+static interop_trie_t interop_addr_trie;
+static interop_trie_t interop_name_trie;
+static bool interop_addr_trie_valid = false;
+static bool interop_name_trie_valid = false;
+
 static const char* interop_feature_string_(const interop_feature_t feature);
 static void interop_free_entry_(void *data);
 static void interop_lazy_init_(void);
-static bool interop_match_fixed_(const interop_feature_t feature, const bt_bdaddr_t *addr);
-static bool interop_match_dynamic_(const interop_feature_t feature, const bt_bdaddr_t *addr);
+static bool interop_match_addr_(const interop_feature_t feature, const bt_bdaddr_t *addr);
+static bool interop_match_name_(const interop_feature_t feature, const char *name);
+static void interop_build_addr_trie_(void);
+static void interop_build_name_trie_(void);
+static void interop_trie_build_(interop_trie_t *trie, interop_trie_key_t *keys, size_t count);
+static void interop_trie_free_(interop_trie_t *trie);
+static bool interop_trie_match_(const interop_trie_t *trie, const interop_feature_t feature,
+    const uint8_t *key, size_t length);
 
 // Interface functions
 
 bool interop_match_addr(const interop_feature_t feature, const bt_bdaddr_t *addr) {
   assert(addr);
 
-  if (interop_match_fixed_(feature, addr) || interop_match_dynamic_(feature, addr)) {
+  if (interop_match_addr_(feature, addr)) {
     char bdstr[20] = {0};
     LOG_WARN(LOG_TAG, "%s() Device %s is a match for interop workaround %s.",
           __func__, bdaddr_to_string(addr, bdstr, sizeof(bdstr)),
@@ -57,15 +104,10 @@ bool interop_match_addr(const interop_feature_t feature, const bt_bdaddr_t *addr
 bool interop_match_name(const interop_feature_t feature, const char *name) {
   assert(name);
 
-  const size_t db_size = sizeof(interop_name_database) / sizeof(interop_name_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_name_database[i].feature &&
-        strlen(name) >= interop_name_database[i].length &&
-        strncmp(name, interop_name_database[i].name, interop_name_database[i].length) == 0) {
-      LOG_WARN(LOG_TAG, "%s() Device with name: %s is a match for interop workaround %s", __func__,
-          name, interop_feature_string_(feature));
-      return true;
-    }
+  if (interop_match_name_(feature, name)) {
+    LOG_WARN(LOG_TAG, "%s() Device with name: %s is a match for interop workaround %s", __func__,
+        name, interop_feature_string_(feature));
+    return true;
   }
 
   return false;
@@ -108,25 +150,44 @@ void interop_database_add(const uint16_t feature, const bt_bdaddr_t *addr, size_
   assert(length > 0);
   assert(length < sizeof(bt_bdaddr_t));
 
+  // |feature| comes through the HAL, only accept workarounds that exist.
+  if (feature >= END_OF_INTEROP_LIST) {
+    LOG_WARN(LOG_TAG, "%s() Ignoring entry for unknown interop workaround %d.",
+        __func__, feature);
+    return;
+  }
+
   interop_addr_entry_t *entry = osi_calloc(sizeof(interop_addr_entry_t));
   memcpy(&entry->addr, addr, length);
   entry->feature = feature;
   entry->length = length;
 
+  pthread_mutex_lock(&interop_lock);
   interop_lazy_init_();
   list_append(interop_list, entry);
+  interop_addr_trie_valid = false;
+  pthread_mutex_unlock(&interop_lock);
 }
 
 void interop_database_clear() {
+  pthread_mutex_lock(&interop_lock);
   if (interop_list)
     list_clear(interop_list);
+  interop_addr_trie_valid = false;
+  pthread_mutex_unlock(&interop_lock);
 }
 
 // Module life-cycle functions
 
 static future_t *interop_clean_up(void) {
+  pthread_mutex_lock(&interop_lock);
   list_free(interop_list);
   interop_list = NULL;
+  interop_trie_free_(&interop_addr_trie);
+  interop_trie_free_(&interop_name_trie);
+  interop_addr_trie_valid = false;
+  interop_name_trie_valid = false;
+  pthread_mutex_unlock(&interop_lock);
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -173,32 +234,172 @@ static void interop_lazy_init_(void) {
   }
 }
 
-static bool interop_match_dynamic_(const interop_feature_t feature, const bt_bdaddr_t *addr) {
-  if (interop_list == NULL || list_length(interop_list) == 0)
-    return false;
+static bool interop_match_addr_(const interop_feature_t feature, const bt_bdaddr_t *addr) {
+  assert(addr);
 
-  const list_node_t *node = list_begin(interop_list);
-  while (node != list_end(interop_list)) {
-    interop_addr_entry_t *entry = list_node(node);
-    assert(entry);
+  pthread_mutex_lock(&interop_lock);
+  if (!interop_addr_trie_valid)
+    interop_build_addr_trie_();
+  bool match = interop_trie_match_(&interop_addr_trie, feature,
+      addr->address, sizeof(addr->address));
+  pthread_mutex_unlock(&interop_lock);
+  return match;
+}
 
-    if (feature == entry->feature && memcmp(addr, &entry->addr, entry->length) == 0)
-      return true;
+static bool interop_match_name_(const interop_feature_t feature, const char *name) {
+  assert(name);
 
-    node = list_next(node);
-  }
-  return false;
+  pthread_mutex_lock(&interop_lock);
+  if (!interop_name_trie_valid)
+    interop_build_name_trie_();
+  bool match = interop_trie_match_(&interop_name_trie, feature,
+      (const uint8_t *)name, strlen(name));
+  pthread_mutex_unlock(&interop_lock);
+  return match;
 }
 
-static bool interop_match_fixed_(const interop_feature_t feature, const bt_bdaddr_t *addr) {
-  assert(addr);
-
+static void interop_build_addr_trie_(void) {
   const size_t db_size = sizeof(interop_addr_database) / sizeof(interop_addr_entry_t);
+  const size_t count = db_size + (interop_list ? list_length(interop_list) : 0);
+  interop_trie_key_t *keys = osi_calloc(sizeof(interop_trie_key_t) * (count ? count : 1));
+
   for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_addr_database[i].feature &&
-        memcmp(addr, &interop_addr_database[i].addr, interop_addr_database[i].length) == 0) {
+    keys[i].key = interop_addr_database[i].addr.address;
+    keys[i].length = interop_addr_database[i].length;
+    keys[i].feature = interop_addr_database[i].feature;
+  }
+
+  if (interop_list) {
+    size_t i = db_size;
+    for (const list_node_t *node = list_begin(interop_list);
+         node != list_end(interop_list); node = list_next(node), ++i) {
+      const interop_addr_entry_t *entry = list_node(node);
+      keys[i].key = entry->addr.address;
+      keys[i].length = entry->length;
+      keys[i].feature = entry->feature;
+    }
+  }
+
+  interop_trie_build_(&interop_addr_trie, keys, count);
+  osi_free(keys);
+  interop_addr_trie_valid = true;
+}
+
+static void interop_build_name_trie_(void) {
+  const size_t count = sizeof(interop_name_database) / sizeof(interop_name_entry_t);
+  interop_trie_key_t *keys = osi_calloc(sizeof(interop_trie_key_t) * count);
+
+  for (size_t i = 0; i != count; ++i) {
+    keys[i].key = (const uint8_t *)interop_name_database[i].name;
+    keys[i].length = interop_name_database[i].length;
+    keys[i].feature = interop_name_database[i].feature;
+  }
+
+  interop_trie_build_(&interop_name_trie, keys, count);
+  osi_free(keys);
+  interop_name_trie_valid = true;
+}
+
+// Orders keys bytewise, with a prefix before the keys it is a prefix of.
+static int interop_trie_key_cmp_(const void *a, const void *b) {
+  const interop_trie_key_t *ka = a;
+  const interop_trie_key_t *kb = b;
+  size_t length = ka->length < kb->length ? ka->length : kb->length;
+  int cmp = memcmp(ka->key, kb->key, length);
+  if (cmp)
+    return cmp;
+  return (ka->length > kb->length) - (ka->length < kb->length);
+}
+
+// Fills in |node| from |keys|, which are sorted and share their first
+// |depth| bytes, and appends its children to the trie.
+static uint64_t interop_trie_fill_(interop_trie_t *trie, size_t node,
+    const interop_trie_key_t *keys, size_t count, size_t depth) {
+  size_t i = 0;
+  for (; i < count && keys[i].length == depth; ++i)
+    trie->nodes[node].features |= INTEROP_FEATURE_BIT(keys[i].feature);
+
+  // Allocate all children first so they are contiguous.
+  const size_t first_child = trie->num_nodes;
+  for (size_t j = i; j < count;) {
+    const uint8_t byte = keys[j].key[depth];
+    while (j < count && keys[j].key[depth] == byte)
+      ++j;
+    trie->nodes[trie->num_nodes++].byte = byte;
+  }
+
+  trie->nodes[node].first_child = first_child;
+  trie->nodes[node].num_children = trie->num_nodes - first_child;
+
+  uint64_t subtree = trie->nodes[node].features;
+  size_t child = first_child;
+  for (size_t j = i; j < count; ++child) {
+    size_t end = j;
+    while (end < count && keys[end].key[depth] == keys[j].key[depth])
+      ++end;
+    subtree |= interop_trie_fill_(trie, child, keys + j, end - j, depth + 1);
+    j = end;
+  }
+
+  trie->nodes[node].subtree = subtree;
+  return subtree;
+}
+
+static void interop_trie_build_(interop_trie_t *trie, interop_trie_key_t *keys, size_t count) {
+  interop_trie_free_(trie);
+
+  // One node per key byte is enough, plus the root.
+  size_t max_nodes = 1;
+  for (size_t i = 0; i != count; ++i) {
+    assert(keys[i].feature < 64);
+    max_nodes += keys[i].length;
+  }
+  assert(max_nodes <= UINT16_MAX);
+
+  qsort(keys, count, sizeof(interop_trie_key_t), interop_trie_key_cmp_);
+
+  trie->nodes = osi_calloc(sizeof(interop_trie_node_t) * max_nodes);
+  trie->num_nodes = 1;
+  interop_trie_fill_(trie, 0, keys, count, 0);
+}
+
+static void interop_trie_free_(interop_trie_t *trie) {
+  osi_free(trie->nodes);
+  trie->nodes = NULL;
+  trie->num_nodes = 0;
+}
+
+static bool interop_trie_match_(const interop_trie_t *trie, const interop_feature_t feature,
+    const uint8_t *key, size_t length) {
+  if (trie->num_nodes == 0)
+    return false;
+
+  const uint64_t bit = INTEROP_FEATURE_BIT(feature);
+  const interop_trie_node_t *node = &trie->nodes[0];
+  for (size_t depth = 0; node->subtree & bit; ++depth) {
+    if (node->features & bit)
       return true;
+    if (depth == length)
+      return false;
+
+    const interop_trie_node_t *children = &trie->nodes[node->first_child];
+    size_t lo = 0;
+    size_t hi = node->num_children;
+    node = NULL;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (children[mid].byte == key[depth]) {
+        node = &children[mid];
+        break;
+      }
+      if (children[mid].byte < key[depth])
+        lo = mid + 1;
+      else
+        hi = mid;
     }
+
+    if (!node)
+      return false;
   }
 
   return false;
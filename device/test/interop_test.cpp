@@ -63,6 +63,24 @@ TEST(InteropTest, test_dynamic) {
   EXPECT_FALSE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
 }
 
+TEST(InteropTest, test_dynamic_unknown_feature) {
+  bt_bdaddr_t test_address;
+
+  string_to_bdaddr("11:22:33:44:55:66", &test_address);
+  interop_database_add(END_OF_INTEROP_LIST, &test_address, 3);
+  interop_database_add(64, &test_address, 3);
+  interop_database_add(0xffff, &test_address, 3);
+
+  // The unknown entries are rejected and do not disturb valid ones.
+  EXPECT_FALSE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+  interop_database_add(INTEROP_AUTO_RETRY_PAIRING, &test_address, 3);
+  EXPECT_TRUE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+  EXPECT_FALSE(interop_match_addr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS, &test_address));
+
+  interop_database_clear();
+  EXPECT_FALSE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+}
+
 TEST(InteropTest, test_name_hit) {
   EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "BMW M3"));
   EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Audi"));
@@ -75,3 +93,20 @@ TEST(InteropTest, test_name_miss) {
   EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "audi"));
   EXPECT_FALSE(interop_match_name(INTEROP_AUTO_RETRY_PAIRING, "BMW M3"));
 }
+
+TEST(InteropTest, test_dynamic_nested_prefix) {
+  bt_bdaddr_t test_address;
+
+  string_to_bdaddr("12:34:56:78:9a:bc", &test_address);
+  interop_database_add(INTEROP_DISABLE_AUTO_PAIRING, &test_address, 4);
+  interop_database_add(INTEROP_AUTO_RETRY_PAIRING, &test_address, 2);
+  EXPECT_TRUE(interop_match_addr(INTEROP_DISABLE_AUTO_PAIRING, &test_address));
+  EXPECT_TRUE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+
+  string_to_bdaddr("12:34:56:00:9a:bc", &test_address);
+  EXPECT_FALSE(interop_match_addr(INTEROP_DISABLE_AUTO_PAIRING, &test_address));
+  EXPECT_TRUE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+
+  interop_database_clear();
+  EXPECT_FALSE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+}
@@ -109,6 +109,15 @@
 #define BTA_DISABLE_DELAY 200 /* in milliseconds */
 #endif
 
+/* Block size and count of the pool bta_sys_msg_alloc serves messages from */
+#ifndef BTA_SYS_MSG_POOL_BLOCK_SIZE
+#define BTA_SYS_MSG_POOL_BLOCK_SIZE 128
+#endif
+
+#ifndef BTA_SYS_MSG_POOL_NUM_BLOCKS
+#define BTA_SYS_MSG_POOL_NUM_BLOCKS 32
+#endif
+
 #ifndef SBC_FOR_EMBEDDED_LINUX
 #define SBC_FOR_EMBEDDED_LINUX TRUE
 #endif
@@ -198,6 +207,13 @@
 #define BTA_FTS_OPS_IDLE_TO_SNIFF_DELAY_MS 7000
 #endif
 
+// How late idle and inactivity timers (link idle, RFCOMM inactivity, sniff
+// mode timers) may fire, so that their expiration can share a wakeup with
+// another alarm.
+#ifndef BT_IDLE_TIMER_SLACK_MS
+#define BT_IDLE_TIMER_SLACK_MS 1000
+#endif
+
 //------------------End added from bdroid_buildcfg.h---------------------
 
 /******************************************************************************
@@ -393,11 +409,24 @@
 #define BTM_SCO_DATA_SIZE_MAX       240
 #endif
 
-/* The size in bytes of the BTM inquiry database. */
+/* The number of entries in the BTM inquiry database. The database is allocated
+** at startup; InqDbSize in bt_stack.conf overrides this. */
 #ifndef BTM_INQ_DB_SIZE
 #define BTM_INQ_DB_SIZE             40
 #endif
 
+/* Number of hash buckets used to look up inquiry database and duplicate
+** response entries by address. Must be a power of two. */
+#ifndef BTM_INQ_DB_HASH_SIZE
+#define BTM_INQ_DB_HASH_SIZE        64
+#endif
+
+/* Number of addresses remembered to filter duplicate responses during one
+** inquiry. When full, the least recently seen address is forgotten. */
+#ifndef BTM_INQ_BDADDR_DB_SIZE
+#define BTM_INQ_BDADDR_DB_SIZE      256
+#endif
+
 /* The default scan mode */
 #ifndef BTM_DEFAULT_SCAN_TYPE
 #define BTM_DEFAULT_SCAN_TYPE       BTM_SCAN_TYPE_INTERLACED
@@ -455,6 +484,43 @@
 #define BTM_SEC_MAX_DEVICE_RECORDS  100
 #endif
 
+/* Number of hash buckets used to look up security records by address and by
+** connection handle. Must be a power of two; keep it close to
+** BTM_SEC_MAX_DEVICE_RECORDS when that is raised. */
+#ifndef BTM_SEC_DEV_HASH_SIZE
+#define BTM_SEC_DEV_HASH_SIZE  128
+#endif
+
+/* Number of resolvable private addresses remembered by BTM, together with
+ * the bonded record they resolved to (or the fact that none matched). */
+#ifndef BTM_BLE_RPA_CACHE_SIZE
+#define BTM_BLE_RPA_CACHE_SIZE  32
+#endif
+
+/* Suppress repeated, unchanged advertising reports to LE observers. Off by
+ * default: reports are fanned out to every scanning client above BTM, and a
+ * client that needs every report must opt out with BTM_BleSetRawScanReports. */
+#ifndef BTM_BLE_ADV_DEDUP_ENABLED
+#define BTM_BLE_ADV_DEDUP_ENABLED   FALSE
+#endif
+
+/* Number of advertisers remembered to suppress repeated, unchanged
+ * advertising reports to LE observers. */
+#ifndef BTM_BLE_ADV_DEDUP_SIZE
+#define BTM_BLE_ADV_DEDUP_SIZE  256
+#endif
+
+/* An unchanged advertiser is still reported once per this interval. */
+#ifndef BTM_BLE_ADV_DEDUP_REFRESH_MS
+#define BTM_BLE_ADV_DEDUP_REFRESH_MS    1000
+#endif
+
+/* An unchanged advertiser is reported again once its RSSI moved by this many
+ * dB from the last reported RSSI. */
+#ifndef BTM_BLE_ADV_DEDUP_RSSI_STEP
+#define BTM_BLE_ADV_DEDUP_RSSI_STEP     8
+#endif
+
 /* The number of security records for services. */
 #ifndef BTM_SEC_MAX_SERVICE_RECORDS
 #define BTM_SEC_MAX_SERVICE_RECORDS 32
@@ -520,6 +586,18 @@
 #define BTM_MAX_VSE_CALLBACKS           3
 #endif
 
+/* Number of HCI commands the BTM command transaction layer can hold, queued or
+ * waiting for completion. */
+#ifndef BTM_HCI_TXN_MAX_CMDS
+#define BTM_HCI_TXN_MAX_CMDS            32
+#endif
+
+/* Number of vendor specific commands the BTM command transaction layer hands to
+ * HCI before waiting for completions. Further commands are held in BTM. */
+#ifndef BTM_HCI_TXN_WINDOW
+#define BTM_HCI_TXN_WINDOW              8
+#endif
+
 /* Safe reattempt even after device is blacklisted for role switch */
 #ifndef BTM_SAFE_REATTEMPT_ROLE_SWITCH
 #define BTM_SAFE_REATTEMPT_ROLE_SWITCH TRUE
@@ -848,6 +926,30 @@
 #endif
 #endif
 
+/* Number of serialized discovery responses (primary service, Find Information,
+** Read By Type) kept by the GATT server for replay to other clients */
+#ifndef GATT_SR_DISC_CACHE_SIZE
+#define GATT_SR_DISC_CACHE_SIZE     16
+#endif
+
+/* Maximum number of queued client reads merged into one Read Multiple request.
+** Set to 0 to disable read coalescing. */
+#ifndef GATT_CL_READ_MULTI_MAX
+#define GATT_CL_READ_MULTI_MAX      8
+#endif
+
+/* Number of attribute value lengths remembered per link, used to decide
+** whether queued reads can be merged into one Read Multiple request */
+#ifndef GATT_CL_READ_LEN_CACHE_SIZE
+#define GATT_CL_READ_LEN_CACHE_SIZE 16
+#endif
+
+/* Number of (peer, handle) notification subscriptions tracked by the GATT client
+** for applications that only want notifications they registered for */
+#ifndef GATT_CL_MAX_NOTIF_SUB
+#define GATT_CL_MAX_NOTIF_SUB       64
+#endif
+
 /* Used for conformance testing ONLY */
 #ifndef GATT_CONFORMANCE_TESTING
 #define GATT_CONFORMANCE_TESTING           FALSE
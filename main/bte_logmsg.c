@@ -38,6 +38,7 @@
 #include "osi/include/config.h"
 #include "osi/include/log.h"
 #include "osi/include/log.h"
+#include "osi/include/trace_ring.h"
 #include "port_api.h"
 #include "sdp_api.h"
 #include "stack_config.h"
@@ -173,7 +174,8 @@ static tBTTRC_FUNC_MAP bttrc_set_level_map[] = {
 };
 
 void LogMsg(uint32_t trace_set_mask, const char *fmt_str, ...) {
-  static char buffer[BTE_LOG_BUF_SIZE];
+  // Per call, since every thread traces.
+  char buffer[BTE_LOG_BUF_SIZE];
   int trace_layer = TRACE_GET_LAYER(trace_set_mask);
   if (trace_layer >= TRACE_LAYER_MAX_NUM)
     trace_layer = 0;
@@ -211,11 +213,28 @@ void vnd_LogMsg(uint32_t trace_set_mask, const char *fmt_str, ...) {
 
   tag = bt_layer_tags[trace_layer];
 
+  // Traces below the configured level land here. They are kept unformatted
+  // in the trace ring, which costs little enough to do for all of them, and
+  // are formatted only if the ring is dumped.
+  char level;
+  switch (TRACE_GET_TYPE(trace_set_mask)) {
+    case TRACE_TYPE_ERROR: level = 'E'; break;
+    case TRACE_TYPE_WARNING: level = 'W'; break;
+    case TRACE_TYPE_API:
+    case TRACE_TYPE_EVENT: level = 'I'; break;
+    default: level = 'D'; break;
+  }
+
   va_list ap;
   va_start(ap, fmt_str);
-  if(logger_interface)
-    logger_interface->send_log_msg(tag, fmt_str, ap);
+  trace_ring_vrecord(tag, level, fmt_str, ap);
   va_end(ap);
+
+  if (logger_interface) {
+    va_start(ap, fmt_str);
+    logger_interface->send_log_msg(tag, fmt_str, ap);
+    va_end(ap);
+  }
 }
 
 void vnd_GenerateLogs() {
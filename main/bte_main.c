@@ -44,7 +44,6 @@
 #include "btsnoop.h"
 #include "btu.h"
 #include "bt_common.h"
-#include "device/include/interop.h"
 #include "hci_layer.h"
 #include "osi/include/alarm.h"
 #include "osi/include/fixed_queue.h"
@@ -99,8 +98,8 @@ fixed_queue_t *btu_hci_msg_queue;
 ******************************************************************************/
 void bte_main_boot_entry(void)
 {
-    module_init(get_module(INTEROP_MODULE));
-
+    /* The interop and stack config modules are initialized by the stack
+    ** manager, together with the other modules it initializes */
     hci = hci_layer_get_interface();
     if (!hci)
       LOG_ERROR(LOG_TAG, "%s could not get hci layer interface.", __func__);
@@ -113,8 +112,6 @@ void bte_main_boot_entry(void)
 
     data_dispatcher_register_default(hci->event_dispatcher, btu_hci_msg_queue);
     hci->set_data_queue(btu_hci_msg_queue);
-
-    module_init(get_module(STACK_CONFIG_MODULE));
 }
 
 /******************************************************************************
@@ -133,10 +130,6 @@ void bte_main_cleanup()
     fixed_queue_free(btu_hci_msg_queue, NULL);
 
     btu_hci_msg_queue = NULL;
-
-    module_clean_up(get_module(STACK_CONFIG_MODULE));
-
-    module_clean_up(get_module(INTEROP_MODULE));
 }
 
 /******************************************************************************
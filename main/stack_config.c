@@ -37,6 +37,7 @@ const char *PTS_DISABLE_SDP_LE_PAIR = "PTS_DisableSDPOnLEPair";
 const char *PTS_SMP_PAIRING_OPTIONS_KEY = "PTS_SmpOptions";
 const char *PTS_SMP_FAILURE_CASE_KEY = "PTS_SmpFailureCase";
 const char *PTS_LE_NONCONN_ADV_MODE = "PTS_EnableNonConnAdvMode";
+const char *INQ_DB_SIZE_KEY = "InqDbSize";
 
 static config_t *config;
 
@@ -127,6 +128,10 @@ static bool get_pts_le_nonconn_adv_enabled(void) {
   return config_get_bool(config, CONFIG_DEFAULT_SECTION, PTS_LE_NONCONN_ADV_MODE, false);
 }
 
+static int get_inq_db_size(void) {
+  return config_get_int(config, CONFIG_DEFAULT_SECTION, INQ_DB_SIZE_KEY, 0);
+}
+
 static config_t *get_all(void) {
   return config;
 }
@@ -143,6 +148,7 @@ const stack_config_t interface = {
   get_pts_smp_options,
   get_pts_smp_failure_case,
   get_pts_le_nonconn_adv_enabled,
+  get_inq_db_size,
   get_all
 };
 
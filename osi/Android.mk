@@ -42,6 +42,7 @@ btosiCommonSrc := \
     ./src/metrics.cpp \
     ./src/mutex.c \
     ./src/osi.c \
+    ./src/pool.c \
     ./src/properties.c \
     ./src/reactor.c \
     ./src/ringbuffer.c \
@@ -51,6 +52,7 @@ btosiCommonSrc := \
     ./src/socket_utils/socket_local_server.c \
     ./src/thread.c \
     ./src/time.c \
+    ./src/trace_ring.c \
     ./src/wakelock.c \
     ./src/vnd_log.c
 
@@ -71,13 +73,15 @@ btosiCommonTestSrc := \
     ./test/leaky_bonded_queue_test.cpp \
     ./test/list_test.cpp \
     ./test/metrics_test.cpp \
+    ./test/pool_test.cpp \
     ./test/properties_test.cpp \
     ./test/rand_test.cpp \
     ./test/reactor_test.cpp \
     ./test/ringbuffer_test.cpp \
     ./test/semaphore_test.cpp \
     ./test/thread_test.cpp \
-    ./test/time_test.cpp
+    ./test/time_test.cpp \
+    ./test/trace_ring_test.cpp
 
 btosiCommonIncludes := \
     $(LOCAL_PATH)/.. \
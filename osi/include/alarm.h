@@ -85,6 +85,25 @@ void alarm_set_on_queue(alarm_t *alarm, period_ms_t interval_ms,
                         alarm_callback_t cb, void *data,
                         fixed_queue_t *queue);
 
+// Same as |alarm_set|, but allows |alarm| to fire up to |slack_ms|
+// milliseconds after its deadline. The alarm never fires before its
+// deadline; the slack only lets its expiration be delayed onto the
+// wakeup of another alarm so that both are serviced by a single
+// wakeup (and a single wakelock acquisition). Intended for idle and
+// inactivity timeouts whose exact expiry time does not matter. The
+// slack holds for this setting of |alarm| only, including all
+// instances of a periodic alarm; |alarm_set| and
+// |alarm_set_on_queue| always set it back to 0.
+void alarm_set_with_slack(alarm_t *alarm, period_ms_t interval_ms,
+                          period_ms_t slack_ms, alarm_callback_t cb,
+                          void *data);
+
+// Same as |alarm_set_on_queue|, with a slack as for
+// |alarm_set_with_slack|.
+void alarm_set_on_queue_with_slack(alarm_t *alarm, period_ms_t interval_ms,
+                                   period_ms_t slack_ms, alarm_callback_t cb,
+                                   void *data, fixed_queue_t *queue);
+
 // This function cancels the |alarm| if it was previously set.
 // When this call returns, the caller has a guarantee that the
 // callback is not in progress and will not be called if it
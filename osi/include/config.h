@@ -17,6 +17,7 @@
 // - All strings are case sensitive.
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // The default section name to use if a key/value pair is not defined within
 // a section.
@@ -134,3 +135,53 @@ const char *config_section_name(const config_section_node_t *iter);
 // and special formatting in the original file will be lost. Neither |config| nor
 // |filename| may be NULL.
 bool config_save(const config_t *config, const char *filename);
+
+// A journal records changes to a config as compact key-level records appended
+// to a file, so that a small change does not require rewriting the whole file
+// with |config_save|. The journal belongs to a snapshot saved with
+// |config_save| and is only valid for the |generation| it was started for; the
+// caller stores the generation in the snapshot and bumps it whenever a new
+// snapshot replaces the old one.
+typedef struct config_journal_t config_journal_t;
+
+// Opens the journal at |filename| for appending. If the file does not exist or
+// was started for a different |generation|, it is emptied and started for
+// |generation|. A record left incomplete by an interrupted write is dropped.
+// Returns NULL on error. Clients must call |config_journal_close| on the
+// returned handle. |filename| must not be NULL.
+config_journal_t *config_journal_open(const char *filename, int generation);
+
+// Closes |journal| without committing pending records. |journal| may be NULL.
+void config_journal_close(config_journal_t *journal);
+
+// Records that |key| in |section| was set to |value|, that |key| was removed
+// from |section|, or that |section| was removed. Records are kept in memory
+// and only reach the file on |config_journal_commit|, so they can be recorded
+// under a lock that the file I/O should not be done under. Returns false if the record could not be written
+// or cannot be represented in the journal (e.g. a string contains a newline);
+// the caller should then save a new snapshot instead. No argument may be NULL.
+bool config_journal_set(config_journal_t *journal, const char *section, const char *key, const char *value);
+bool config_journal_remove_key(config_journal_t *journal, const char *section, const char *key);
+bool config_journal_remove_section(config_journal_t *journal, const char *section);
+
+// Records every key of |section| in |config| as set. Returns false under the
+// same conditions as |config_journal_set|. No argument may be NULL.
+bool config_journal_add_section(config_journal_t *journal, const config_t *config, const char *section);
+
+// Writes pending records to the file and syncs it to disk. Returns true on
+// success. |journal| must not be NULL.
+bool config_journal_commit(config_journal_t *journal);
+
+// Empties |journal| and starts it for |generation|, dropping pending records.
+// Returns true on success. |journal| must not be NULL.
+bool config_journal_reset(config_journal_t *journal, int generation);
+
+// Returns the size of the journal file in bytes, including committed records
+// only. |journal| must not be NULL.
+size_t config_journal_size(const config_journal_t *journal);
+
+// Applies the records of the journal at |filename| to |config| in order, if the
+// journal was started for |generation|. Returns the number of records applied;
+// a missing journal or one for another generation applies none. Neither
+// |config| nor |filename| may be NULL.
+int config_journal_replay(config_t *config, const char *filename, int generation);
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A pool of fixed size blocks for messages that are allocated on one thread
+// and released on another. The blocks come out of a single slab allocated
+// up front. A request larger than the block size, or made while every block
+// is in use, falls back to |osi_malloc|. |pool_put| tells the two apart, so
+// whoever ends up owning a message can release it without knowing where it
+// came from. A NULL pool behaves like an empty one.
+typedef struct pool_t pool_t;
+
+typedef struct {
+  size_t block_size;
+  size_t num_blocks;
+  size_t in_use;        // blocks currently handed out
+  uint64_t allocs;      // calls to |pool_alloc|
+  uint64_t hits;        // ...served from the slab
+  uint64_t too_big;     // ...larger than |block_size|
+  uint64_t exhausted;   // ...made while no block was free
+} pool_stats_t;
+
+// Creates a pool named |name| of |num_blocks| blocks, each able to hold
+// |block_size| bytes. |name| must not be NULL and both sizes must be
+// greater than zero. Returns NULL on failure.
+pool_t *pool_new(const char *name, size_t block_size, size_t num_blocks);
+
+// Frees |pool|. Every block must have been returned with |pool_put|.
+// |pool| may be NULL.
+void pool_free(pool_t *pool);
+
+// Returns |size| bytes of uninitialized memory, from |pool| if it has a
+// free block big enough and from |osi_malloc| otherwise. Never returns NULL.
+void *pool_alloc(pool_t *pool, size_t size);
+
+// Releases |ptr|, which was returned by |pool_alloc| on |pool| or by
+// |osi_malloc|. |ptr| may be NULL.
+void pool_put(pool_t *pool, void *ptr);
+
+// Returns true if |ptr| is a block of |pool|'s slab.
+bool pool_owns(const pool_t *pool, const void *ptr);
+
+// Copies the counters of |pool| into |stats|. |pool| may be NULL, in which
+// case |stats| is zeroed.
+void pool_get_stats(pool_t *pool, pool_stats_t *stats);
+
+// Dump the counters of every pool, including the allocations each one
+// avoided per second since the previous dump, to the |fd| file descriptor.
+// The caller is responsible for closing the |fd|.
+void pool_debug_dump(int fd);
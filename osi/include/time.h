@@ -28,3 +28,7 @@
 // as (t2_u32 - t1_u32 < delta_u32) should work as expected as long
 // as there is no multiple rollover between t2_u32 and t1_u32.
 uint32_t time_get_os_boottime_ms(void);
+
+// Get the OS boot time in microseconds. Unlike time_get_os_boottime_ms()
+// the 64-bit return value does not roll over.
+uint64_t time_get_os_boottime_us(void);
@@ -0,0 +1,43 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdarg.h>
+
+// Binary trace records, kept in memory and formatted only when dumped.
+//
+// Each thread that records gets its own ring of fixed size records, so
+// recording takes no lock and never blocks: it stores the timestamp, the
+// format string pointer and the raw arguments, copying only the contents of
+// "%s" arguments. Once a ring is full the oldest records are overwritten.
+// Formats must be string literals (or otherwise outlive the process), since
+// only the pointer is kept. At most 8 arguments and 64 bytes of string
+// arguments are kept per record; the rest is dropped from the dump.
+
+// Records the message |format| with |args| under |tag|, which must also
+// outlive the process. |level| is a single letter shown in the dump, e.g.
+// 'D' for debug. Safe to call from any thread.
+void trace_ring_vrecord(const char *tag, char level, const char *format,
+                        va_list args);
+void trace_ring_record(const char *tag, char level, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+// Formats the records of every thread, oldest first, to the |fd| file
+// descriptor. The caller is responsible for closing the |fd|.
+void trace_ring_debug_dump(int fd);
@@ -79,6 +79,7 @@ struct alarm_t {
   period_ms_t creation_time;
   period_ms_t period;
   period_ms_t deadline;
+  period_ms_t slack;            // How long after |deadline| the alarm may fire
   period_ms_t prev_deadline;    // Previous deadline - used for accounting of
                                 // periodic timers
   bool is_periodic;
@@ -108,6 +109,15 @@ static list_t *alarms;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
+static period_ms_t fire_time;   // When |timer| or |wakeup_timer| will fire
+
+// Scheduler-wide statistics, protected by |monitor|
+static struct {
+  size_t wakeups;               // Wakeups that expired at least one alarm
+  size_t expirations;
+  size_t wakeups_saved;         // Wakeups avoided by slack
+  size_t wakelock_acquisitions;
+} scheduler_stats;
 
 // All alarm callbacks are dispatched from |dispatcher_thread|
 static thread_t *dispatcher_thread;
@@ -122,12 +132,13 @@ static alarm_t *alarm_new_internal(const char *name, bool is_periodic);
 static bool lazy_initialize(void);
 static period_ms_t now(void);
 static void alarm_set_internal(alarm_t *alarm, period_ms_t period,
-                               alarm_callback_t cb, void *data,
-                               fixed_queue_t *queue);
+                               period_ms_t slack, alarm_callback_t cb,
+                               void *data, fixed_queue_t *queue);
 static void alarm_cancel_internal(alarm_t *alarm);
 static void remove_pending_alarm(alarm_t *alarm);
 static void schedule_next_instance(alarm_t *alarm);
 static void reschedule_root_alarm(void);
+static period_ms_t next_fire_time(void);
 static void alarm_queue_ready(fixed_queue_t *queue, void *context);
 static void timer_callback(void *data);
 static void callback_dispatch(void *context);
@@ -228,13 +239,27 @@ void alarm_set_on_queue(alarm_t *alarm, period_ms_t interval_ms,
                         alarm_callback_t cb, void *data,
                         fixed_queue_t *queue) {
   assert(queue != NULL);
-  alarm_set_internal(alarm, interval_ms, cb, data, queue);
+  alarm_set_internal(alarm, interval_ms, 0, cb, data, queue);
+}
+
+void alarm_set_with_slack(alarm_t *alarm, period_ms_t interval_ms,
+                          period_ms_t slack_ms, alarm_callback_t cb,
+                          void *data) {
+  alarm_set_on_queue_with_slack(alarm, interval_ms, slack_ms, cb, data,
+                                default_callback_queue);
+}
+
+void alarm_set_on_queue_with_slack(alarm_t *alarm, period_ms_t interval_ms,
+                                   period_ms_t slack_ms, alarm_callback_t cb,
+                                   void *data, fixed_queue_t *queue) {
+  assert(queue != NULL);
+  alarm_set_internal(alarm, interval_ms, slack_ms, cb, data, queue);
 }
 
 // Runs in exclusion with alarm_cancel and timer_callback.
 static void alarm_set_internal(alarm_t *alarm, period_ms_t period,
-                               alarm_callback_t cb, void *data,
-                               fixed_queue_t *queue) {
+                               period_ms_t slack, alarm_callback_t cb,
+                               void *data, fixed_queue_t *queue) {
   assert(alarms != NULL);
   assert(alarm != NULL);
   assert(cb != NULL);
@@ -243,6 +268,7 @@ static void alarm_set_internal(alarm_t *alarm, period_ms_t period,
 
   alarm->creation_time = now();
   alarm->period = period;
+  alarm->slack = slack;
   alarm->queue = queue;
   alarm->callback = cb;
   alarm->data = data;
@@ -310,6 +336,9 @@ void alarm_cleanup(void) {
 
   timer_delete(wakeup_timer);
   timer_delete(timer);
+  timer_set = false;
+  fire_time = 0;
+  memset(&scheduler_stats, 0, sizeof(scheduler_stats));
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
@@ -458,9 +487,12 @@ static void schedule_next_instance(alarm_t *alarm) {
     }
   }
 
-  // If the new alarm has the earliest deadline, we need to re-evaluate our schedule.
+  // If the new alarm has the earliest deadline, or its slack does not stretch
+  // as far as the time the timer is set for, we need to re-evaluate our
+  // schedule.
   if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
+      (!list_is_empty(alarms) && list_front(alarms) == alarm) ||
+      alarm->deadline + alarm->slack < fire_time) {
     reschedule_root_alarm();
   }
 }
@@ -475,21 +507,24 @@ static void reschedule_root_alarm(void) {
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
+  fire_time = 0;
   if (list_is_empty(alarms))
     goto done;
 
-  const alarm_t *next = list_front(alarms);
-  const int64_t next_expiration = next->deadline - now();
+  const period_ms_t next = next_fire_time();
+  const int64_t next_expiration = next - now();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
       if (!wakelock_acquire()) {
         LOG_ERROR(LOG_TAG, "%s unable to acquire wake lock", __func__);
         goto done;
       }
+      scheduler_stats.wakelock_acquisitions++;
     }
 
-    timer_time.it_value.tv_sec = (next->deadline / 1000);
-    timer_time.it_value.tv_nsec = (next->deadline % 1000) * 1000000LL;
+    fire_time = next;
+    timer_time.it_value.tv_sec = (next / 1000);
+    timer_time.it_value.tv_nsec = (next % 1000) * 1000000LL;
 
     // It is entirely unsafe to call timer_settime(2) with a zeroed timerspec
     // for timers with *_ALARM clock IDs. Although the man page states that the
@@ -514,9 +549,9 @@ static void reschedule_root_alarm(void) {
     struct itimerspec wakeup_time;
     memset(&wakeup_time, 0, sizeof(wakeup_time));
 
-
-    wakeup_time.it_value.tv_sec = (next->deadline / 1000);
-    wakeup_time.it_value.tv_nsec = (next->deadline % 1000) * 1000000LL;
+    fire_time = next;
+    wakeup_time.it_value.tv_sec = (next / 1000);
+    wakeup_time.it_value.tv_nsec = (next % 1000) * 1000000LL;
     if (timer_settime(wakeup_timer, TIMER_ABSTIME, &wakeup_time, NULL) == -1)
       LOG_ERROR(LOG_TAG, "%s unable to set wakeup timer: %s",
                 __func__, strerror(errno));
@@ -552,6 +587,28 @@ done:
   }
 }
 
+// Returns the time the root timer should fire at: the latest time that is
+// still within the slack of every alarm due by then. All alarms with a
+// deadline up to that time expire together on one wakeup.
+// NOTE: must be called with monitor lock.
+static period_ms_t next_fire_time(void) {
+  const alarm_t *front = list_front(alarms);
+  period_ms_t next = front->deadline + front->slack;
+
+  // The list is sorted by deadline, so once a deadline is past |next| no
+  // later alarm can bring it forward.
+  for (const list_node_t *node = list_next(list_begin(alarms));
+       node != list_end(alarms); node = list_next(node)) {
+    const alarm_t *alarm = (const alarm_t *)list_node(node);
+    if (alarm->deadline > next)
+      break;
+    if (alarm->deadline + alarm->slack < next)
+      next = alarm->deadline + alarm->slack;
+  }
+
+  return next;
+}
+
 void alarm_register_processing_queue(fixed_queue_t *queue, thread_t *thread) {
   assert(queue != NULL);
   assert(thread != NULL);
@@ -632,8 +689,8 @@ static void timer_callback(UNUSED_ATTR void *ptr) {
 
 // Function running on |dispatcher_thread| that performs the following:
 //   (1) Receives a signal using |alarm_exired| that the alarm has expired
-//   (2) Dispatches the alarm callback for processing by the corresponding
-// thread for that alarm.
+//   (2) Dispatches the callbacks of all expired alarms for processing by the
+// corresponding thread for each alarm.
 static void callback_dispatch(UNUSED_ATTR void *context) {
   while (true) {
     period_ms_t just_now;
@@ -642,35 +699,53 @@ static void callback_dispatch(UNUSED_ATTR void *context) {
       break;
 
     pthread_mutex_lock(&monitor);
-    alarm_t *alarm;
     just_now = now();
 
     // Take into account that the alarm may get cancelled before we get to it.
-    // We're done here if there are no alarms or the alarm at the front is in
-    // the future. Release the monitor lock and exit right away since there's
-    // nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = list_front(alarms))->deadline > just_now) {
-      reschedule_root_alarm();
-      pthread_mutex_unlock(&monitor);
-      continue;
+    // Count the alarms that are due up front: a periodic alarm is put back
+    // into the list behind them and must not be dispatched twice.
+    size_t expired = 0;
+    for (list_node_t *node = list_begin(alarms); node != list_end(alarms);
+         node = list_next(node)) {
+      if (((alarm_t *)list_node(node))->deadline > just_now)
+        break;
+      expired++;
     }
 
-    list_remove(alarms, alarm);
-
-    if(just_now - alarm->deadline > 1000)
-      LOG_DEBUG(LOG_TAG, "%s Delay in timer callback", __func__);
+    if (expired != 0)
+      scheduler_stats.wakeups++;
+
+    // The time the timer was programmed for. Alarms due after it were only
+    // picked up because this wakeup came late, not because of any slack.
+    const period_ms_t programmed = fire_time;
+    period_ms_t prev_deadline = 0;
+    for (size_t i = 0; i < expired; i++) {
+      alarm_t *alarm = list_front(alarms);
+      list_remove(alarms, alarm);
+
+      if(just_now - alarm->deadline > 1000)
+        LOG_DEBUG(LOG_TAG, "%s Delay in timer callback", __func__);
+
+      // Alarms with the same deadline would have shared a wakeup anyway.
+      if (i != 0 && alarm->deadline != prev_deadline &&
+          alarm->deadline <= programmed)
+        scheduler_stats.wakeups_saved++;
+      scheduler_stats.expirations++;
+      prev_deadline = alarm->deadline;
+
+      if (alarm->is_periodic) {
+        alarm->prev_deadline = alarm->deadline;
+        schedule_next_instance(alarm);
+        alarm->stats.rescheduled_count++;
+      }
 
-    if (alarm->is_periodic) {
-      alarm->prev_deadline = alarm->deadline;
-      schedule_next_instance(alarm);
-      alarm->stats.rescheduled_count++;
+      // Enqueue the alarm for processing
+      fixed_queue_enqueue(alarm->queue, alarm);
     }
-    reschedule_root_alarm();
-
-    // Enqueue the alarm for processing
-    fixed_queue_enqueue(alarm->queue, alarm);
 
+    // We're done here if there were no alarms or the alarm at the front was
+    // in the future; either way the timer is set for whatever is left.
+    reschedule_root_alarm();
     pthread_mutex_unlock(&monitor);
   }
 
@@ -745,7 +820,12 @@ void alarm_debug_dump(int fd)
 
   period_ms_t just_now = now();
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "  Total Alarms: %zu\n", list_length(alarms));
+  dprintf(fd, "  Wakeups (total/saved by slack): %zu / %zu\n",
+          scheduler_stats.wakeups, scheduler_stats.wakeups_saved);
+  dprintf(fd, "  Expirations: %zu\n", scheduler_stats.expirations);
+  dprintf(fd, "  Wakelock acquisitions: %zu\n\n",
+          scheduler_stats.wakelock_acquisitions);
 
   // Dump info for each alarm
   for (list_node_t *node = list_begin(alarms); node != list_end(alarms);
@@ -766,11 +846,12 @@ void alarm_debug_dump(int fd)
             stats->overdue_scheduling.count,
             stats->premature_scheduling.count);
 
-    dprintf(fd, "%-51s: %llu / %llu / %lld\n",
-            "    Time in ms (since creation/interval/remaining)",
+    dprintf(fd, "%-51s: %llu / %llu / %lld / %llu\n",
+            "    Time in ms (since creation/interval/remaining/slack)",
             (unsigned long long)(just_now - alarm->creation_time),
             (unsigned long long) alarm->period,
-            (long long)(alarm->deadline - just_now));
+            (long long)(alarm->deadline - just_now),
+            (unsigned long long) alarm->slack);
 
     dump_stat(fd, &stats->callback_execution,
               "    Callback execution time in ms (total/max/avg)");
@@ -25,6 +25,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <libgen.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,34 +36,91 @@
 #include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/compat.h"
+#include "osi/include/hash_functions.h"
+#include "osi/include/osi.h"
+
+// Sections, key names and entries are chained into hash indexes so lookups
+// do not walk every section of the config. The lists still own the objects
+// and keep their insertion order, which is the order they are written in.
+typedef struct index_node_t {
+  struct index_node_t *next;
+  hash_index_t hash;
+} index_node_t;
+
+typedef struct {
+  index_node_t **buckets;
+  size_t num_buckets;     // always a power of two
+  size_t size;
+} index_t;
+
+// Key names are interned per config; every section uses the same few keys.
+typedef struct {
+  index_node_t node;
+  size_t refs;
+  char name[];
+} key_name_t;
+
+typedef struct section_t section_t;
 
 typedef struct {
-  char *key;
+  index_node_t node;      // hashed by section and key name
+  section_t *section;
+  key_name_t *key_name;
+  const char *key;        // |key_name->name|
   char *value;
 } entry_t;
 
-typedef struct {
+struct section_t {
+  index_node_t node;      // hashed by name
+  config_t *config;
   char *name;
   list_t *entries;
-} section_t;
+};
 
 struct config_t {
   list_t *sections;
+  index_t section_index;
+  index_t key_index;
+  index_t entry_index;
+};
+
+struct config_journal_t {
+  int fd;
+  size_t size;      // bytes committed to the file
+  char *pending;    // records not committed yet
+  size_t pending_length;
+  size_t pending_capacity;
 };
 
 // Empty definition; this type is aliased to list_node_t.
 struct config_section_iter_t {};
 
 static bool config_parse(FILE *fp, config_t *config);
+static bool journal_read_header(FILE *fp, int *generation);
+static bool journal_append(config_journal_t *journal, const char *format, ...);
+static bool journal_apply(config_t *config, char *line);
+
+static void index_init(index_t *index);
+static void index_cleanup(index_t *index);
+static index_node_t *index_bucket(const index_t *index, hash_index_t hash);
+static void index_insert(index_t *index, index_node_t *node);
+static void index_remove(index_t *index, index_node_t *node);
+
+static key_name_t *key_name_find(const config_t *config, const char *key);
+static key_name_t *key_name_get(config_t *config, const char *key);
+static void key_name_put(config_t *config, key_name_t *key_name);
 
-static section_t *section_new(const char *name);
+static section_t *section_new(config_t *config, const char *name);
 static void section_free(void *ptr);
 static section_t *section_find(const config_t *config, const char *section);
 
-static entry_t *entry_new(const char *key, const char *value);
+static entry_t *entry_new(section_t *section, const char *key, const char *value);
 static void entry_free(void *ptr);
 static entry_t *entry_find(const config_t *config, const char *section, const char *key);
 
+// Initial number of buckets of each index; they double as they fill up.
+static const size_t INDEX_MIN_BUCKETS = 16;
+
 config_t *config_new_empty(void) {
   config_t *config = osi_calloc(sizeof(config_t));
 
@@ -72,6 +130,9 @@ config_t *config_new_empty(void) {
     goto error;
   }
 
+  index_init(&config->section_index);
+  index_init(&config->key_index);
+  index_init(&config->entry_index);
   return config;
 
 error:;
@@ -131,6 +192,9 @@ void config_free(config_t *config) {
     return;
 
   list_free(config->sections);
+  index_cleanup(&config->section_index);
+  index_cleanup(&config->key_index);
+  index_cleanup(&config->entry_index);
   osi_free(config);
 }
 
@@ -213,27 +277,21 @@ void config_set_bool(config_t *config, const char *section, const char *key, boo
 void config_set_string(config_t *config, const char *section, const char *key, const char *value) {
   section_t *sec = section_find(config, section);
   if (!sec) {
-    sec = section_new(section);
-    if (sec)
-      list_append(config->sections, sec);
-    else {
+    sec = section_new(config, section);
+    if (!sec) {
       LOG_ERROR(LOG_TAG,"%s: Unable to allocate memory for section", __func__);
+      return;
     }
   }
 
-  if (sec) {
-    for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
-      entry_t *entry = list_node(node);
-      if (!strcmp(entry->key, key)) {
-        osi_free(entry->value);
-        entry->value = osi_strdup(value);
-        return;
-      }
-    }
-
-    entry_t *entry = entry_new(key, value);
-    list_append(sec->entries, entry);
+  entry_t *entry = entry_find(config, section, key);
+  if (entry) {
+    osi_free(entry->value);
+    entry->value = osi_strdup(value);
+    return;
   }
+
+  entry_new(sec, key, value);
 }
 
 bool config_remove_section(config_t *config, const char *section) {
@@ -252,12 +310,11 @@ bool config_remove_key(config_t *config, const char *section, const char *key) {
   assert(section != NULL);
   assert(key != NULL);
 
-  section_t *sec = section_find(config, section);
   entry_t *entry = entry_find(config, section, key);
-  if (!sec || !entry)
+  if (!entry)
     return false;
 
-  return list_remove(sec->entries, entry);
+  return list_remove(entry->section->entries, entry);
 }
 
 const config_section_node_t *config_section_begin(const config_t *config) {
@@ -448,11 +505,8 @@ static bool config_parse(FILE *fp, config_t *config) {
     if (*line_ptr == '#') {
         strlcpy(comment, line_ptr, 1024);
 
-        if(!section_find(config, comment)) {
-            section_t *sec = section_new(comment);
-            if (sec)
-                list_append(config->sections, sec);
-        }
+        if(!section_find(config, comment))
+            section_new(config, comment);
     } else if (*line_ptr == '[') {
       size_t len = strlen(line_ptr);
       if (line_ptr[len - 1] != ']') {
@@ -481,11 +535,376 @@ static bool config_parse(FILE *fp, config_t *config) {
   return true;
 }
 
-static section_t *section_new(const char *name) {
+// Journal records are single lines appended after a header line:
+//   "+[section] key = value" sets |key|,
+//   "-[section] key" removes |key|,
+//   "-[section]" removes |section|.
+// Only lines terminated by a newline are complete records.
+static const char *JOURNAL_HEADER_FORMAT = "#journal %d\n";
+
+config_journal_t *config_journal_open(const char *filename, int generation) {
+  assert(filename != NULL);
+
+  config_journal_t *journal = osi_calloc(sizeof(config_journal_t));
+  journal->fd = open(filename, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (journal->fd < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to open journal '%s': %s", __func__, filename, strerror(errno));
+    osi_free(journal);
+    return NULL;
+  }
+
+  FILE *fp = fopen(filename, "rt");
+  int file_generation;
+  if (!fp || !journal_read_header(fp, &file_generation) || file_generation != generation) {
+    if (fp)
+      fclose(fp);
+    if (!config_journal_reset(journal, generation))
+      goto error;
+    return journal;
+  }
+
+  // Find the end of the last complete record and drop anything after it, so
+  // that new records do not get appended to a torn one.
+  long end = ftell(fp);
+  long pos = end;
+  int ch;
+  while ((ch = fgetc(fp)) != EOF) {
+    ++pos;
+    if (ch == '\n')
+      end = pos;
+  }
+  fclose(fp);
+
+  if (pos != end) {
+    LOG_WARN(LOG_TAG, "%s dropping incomplete record at the end of '%s'.", __func__, filename);
+    if (ftruncate(journal->fd, end) == -1) {
+      LOG_ERROR(LOG_TAG, "%s unable to truncate journal '%s': %s", __func__, filename, strerror(errno));
+      goto error;
+    }
+  }
+
+  if (lseek(journal->fd, end, SEEK_SET) == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to seek journal '%s': %s", __func__, filename, strerror(errno));
+    goto error;
+  }
+
+  journal->size = end;
+  return journal;
+
+error:
+  config_journal_close(journal);
+  return NULL;
+}
+
+void config_journal_close(config_journal_t *journal) {
+  if (!journal)
+    return;
+
+  close(journal->fd);
+  osi_free(journal->pending);
+  osi_free(journal);
+}
+
+bool config_journal_set(config_journal_t *journal, const char *section, const char *key, const char *value) {
+  assert(journal != NULL);
+  assert(section != NULL);
+  assert(key != NULL);
+  assert(value != NULL);
+
+  if (strpbrk(section, "]\n") || !*key || strpbrk(key, "=\n") || strchr(value, '\n'))
+    return false;
+
+  return journal_append(journal, "+[%s] %s = %s\n", section, key, value);
+}
+
+bool config_journal_remove_key(config_journal_t *journal, const char *section, const char *key) {
+  assert(journal != NULL);
+  assert(section != NULL);
+  assert(key != NULL);
+
+  if (strpbrk(section, "]\n") || !*key || strpbrk(key, "=\n"))
+    return false;
+
+  return journal_append(journal, "-[%s] %s\n", section, key);
+}
+
+bool config_journal_remove_section(config_journal_t *journal, const char *section) {
+  assert(journal != NULL);
+  assert(section != NULL);
+
+  if (strpbrk(section, "]\n"))
+    return false;
+
+  return journal_append(journal, "-[%s]\n", section);
+}
+
+bool config_journal_add_section(config_journal_t *journal, const config_t *config, const char *section) {
+  assert(journal != NULL);
+  assert(config != NULL);
+  assert(section != NULL);
+
+  const section_t *sec = section_find(config, section);
+  if (!sec)
+    return true;
+
+  for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
+    const entry_t *entry = list_node(node);
+    if (!config_journal_set(journal, section, entry->key, entry->value))
+      return false;
+  }
+
+  return true;
+}
+
+bool config_journal_commit(config_journal_t *journal) {
+  assert(journal != NULL);
+
+  size_t length = journal->pending_length;
+  journal->pending_length = 0;
+
+  for (size_t written = 0; written < length; ) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(journal->fd, journal->pending + written, length - written));
+    if (ret < 0) {
+      LOG_ERROR(LOG_TAG, "%s unable to write journal: %s", __func__, strerror(errno));
+      return false;
+    }
+    written += ret;
+    journal->size += ret;
+  }
+
+  // Only the journal is synced; its directory entry does not change.
+  if (fsync(journal->fd) < 0)
+    LOG_WARN(LOG_TAG, "%s unable to fsync journal: %s", __func__, strerror(errno));
+
+  return true;
+}
+
+bool config_journal_reset(config_journal_t *journal, int generation) {
+  assert(journal != NULL);
+
+  // Drop pending records; they belong to the old generation.
+  journal->pending_length = 0;
+  if (ftruncate(journal->fd, 0) == -1 || lseek(journal->fd, 0, SEEK_SET) == -1) {
+    LOG_ERROR(LOG_TAG, "%s unable to truncate journal: %s", __func__, strerror(errno));
+    return false;
+  }
+
+  journal->size = 0;
+  return journal_append(journal, JOURNAL_HEADER_FORMAT, generation) &&
+         config_journal_commit(journal);
+}
+
+size_t config_journal_size(const config_journal_t *journal) {
+  assert(journal != NULL);
+  return journal->size;
+}
+
+int config_journal_replay(config_t *config, const char *filename, int generation) {
+  assert(config != NULL);
+  assert(filename != NULL);
+
+  FILE *fp = fopen(filename, "rt");
+  if (!fp)
+    return 0;
+
+  int file_generation;
+  if (!journal_read_header(fp, &file_generation) || file_generation != generation) {
+    LOG_WARN(LOG_TAG, "%s ignoring journal '%s' of another generation.", __func__, filename);
+    fclose(fp);
+    return 0;
+  }
+
+  int records = 0;
+  char line[1024];
+  while (fgets(line, sizeof(line), fp)) {
+    size_t len = strlen(line);
+    if (line[len - 1] != '\n') {
+      // Too long to be a record, or torn by an interrupted write.
+      int ch;
+      while ((ch = fgetc(fp)) != EOF && ch != '\n');
+      continue;
+    }
+
+    line[len - 1] = '\0';
+    if (journal_apply(config, line))
+      ++records;
+  }
+
+  fclose(fp);
+  return records;
+}
+
+static bool journal_read_header(FILE *fp, int *generation) {
+  char line[32];
+  if (fseek(fp, 0, SEEK_SET) == -1 || !fgets(line, sizeof(line), fp))
+    return false;
+
+  char newline;
+  return sscanf(line, "#journal %d%c", generation, &newline) == 2 && newline == '\n';
+}
+
+static bool journal_append(config_journal_t *journal, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+  if (length < 0)
+    return false;
+
+  size_t needed = journal->pending_length + length + 1;
+  if (needed > journal->pending_capacity) {
+    size_t capacity = journal->pending_capacity ? journal->pending_capacity : 256;
+    while (capacity < needed)
+      capacity *= 2;
+
+    char *pending = osi_malloc(capacity);
+    if (journal->pending_length)
+      memcpy(pending, journal->pending, journal->pending_length);
+    osi_free(journal->pending);
+    journal->pending = pending;
+    journal->pending_capacity = capacity;
+  }
+
+  va_start(args, format);
+  vsnprintf(journal->pending + journal->pending_length, length + 1, format, args);
+  va_end(args);
+  journal->pending_length += length;
+  return true;
+}
+
+static bool journal_apply(config_t *config, char *line) {
+  if ((line[0] != '+' && line[0] != '-') || line[1] != '[')
+    return false;
+
+  char *section = line + 2;
+  char *end = strchr(section, ']');
+  if (!end)
+    return false;
+
+  *end = '\0';
+  char *key = trim(end + 1);
+
+  if (line[0] == '-') {
+    if (*key == '\0')
+      config_remove_section(config, section);
+    else
+      config_remove_key(config, section, key);
+    return true;
+  }
+
+  char *split = strchr(key, '=');
+  if (!split)
+    return false;
+
+  *split = '\0';
+  config_set_string(config, section, trim(key), trim(split + 1));
+  return true;
+}
+
+static void index_init(index_t *index) {
+  index->num_buckets = INDEX_MIN_BUCKETS;
+  index->buckets = osi_calloc(sizeof(index_node_t *) * index->num_buckets);
+  index->size = 0;
+}
+
+static void index_cleanup(index_t *index) {
+  // The indexed objects are owned by the lists and freed with them.
+  assert(index->size == 0);
+  osi_free(index->buckets);
+  index->buckets = NULL;
+}
+
+static size_t index_slot(const index_t *index, hash_index_t hash) {
+  return (hash ^ (hash >> 16)) & (index->num_buckets - 1);
+}
+
+static index_node_t *index_bucket(const index_t *index, hash_index_t hash) {
+  return index->buckets[index_slot(index, hash)];
+}
+
+static void index_insert(index_t *index, index_node_t *node) {
+  if (index->size >= index->num_buckets) {
+    index_t grown = { .num_buckets = index->num_buckets * 2 };
+    grown.buckets = osi_calloc(sizeof(index_node_t *) * grown.num_buckets);
+    for (size_t i = 0; i < index->num_buckets; ++i) {
+      index_node_t *next;
+      for (index_node_t *n = index->buckets[i]; n; n = next) {
+        next = n->next;
+        size_t slot = index_slot(&grown, n->hash);
+        n->next = grown.buckets[slot];
+        grown.buckets[slot] = n;
+      }
+    }
+    osi_free(index->buckets);
+    index->buckets = grown.buckets;
+    index->num_buckets = grown.num_buckets;
+  }
+
+  size_t slot = index_slot(index, node->hash);
+  node->next = index->buckets[slot];
+  index->buckets[slot] = node;
+  ++index->size;
+}
+
+static void index_remove(index_t *index, index_node_t *node) {
+  for (index_node_t **n = &index->buckets[index_slot(index, node->hash)]; *n; n = &(*n)->next) {
+    if (*n == node) {
+      *n = node->next;
+      --index->size;
+      return;
+    }
+  }
+
+  assert(false);
+}
+
+static hash_index_t entry_hash(const section_t *section, const key_name_t *key_name) {
+  return section->node.hash * 31 + key_name->node.hash;
+}
+
+static key_name_t *key_name_find(const config_t *config, const char *key) {
+  hash_index_t hash = hash_function_string(key);
+  for (index_node_t *n = index_bucket(&config->key_index, hash); n; n = n->next) {
+    key_name_t *key_name = (key_name_t *)n;
+    if (n->hash == hash && !strcmp(key_name->name, key))
+      return key_name;
+  }
+
+  return NULL;
+}
+
+static key_name_t *key_name_get(config_t *config, const char *key) {
+  key_name_t *key_name = key_name_find(config, key);
+  if (!key_name) {
+    size_t len = strlen(key) + 1;
+    key_name = osi_calloc(sizeof(key_name_t) + len);
+    memcpy(key_name->name, key, len);
+    key_name->node.hash = hash_function_string(key);
+    index_insert(&config->key_index, &key_name->node);
+  }
+
+  ++key_name->refs;
+  return key_name;
+}
+
+static void key_name_put(config_t *config, key_name_t *key_name) {
+  if (--key_name->refs)
+    return;
+
+  index_remove(&config->key_index, &key_name->node);
+  osi_free(key_name);
+}
+
+static section_t *section_new(config_t *config, const char *name) {
   section_t *section = osi_calloc(sizeof(section_t));
 
+  section->config = config;
   section->name = osi_strdup(name);
   section->entries = list_new(entry_free);
+  section->node.hash = hash_function_string(name);
+  list_append(config->sections, section);
+  index_insert(&config->section_index, &section->node);
   return section;
 }
 
@@ -494,26 +913,33 @@ static void section_free(void *ptr) {
     return;
 
   section_t *section = ptr;
-  osi_free(section->name);
   list_free(section->entries);
+  index_remove(&section->config->section_index, &section->node);
+  osi_free(section->name);
   osi_free(section);
 }
 
 static section_t *section_find(const config_t *config, const char *section) {
-  for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
-    section_t *sec = list_node(node);
-    if (!strcmp(sec->name, section))
+  hash_index_t hash = hash_function_string(section);
+  for (index_node_t *n = index_bucket(&config->section_index, hash); n; n = n->next) {
+    section_t *sec = (section_t *)n;
+    if (n->hash == hash && !strcmp(sec->name, section))
       return sec;
   }
 
   return NULL;
 }
 
-static entry_t *entry_new(const char *key, const char *value) {
+static entry_t *entry_new(section_t *section, const char *key, const char *value) {
   entry_t *entry = osi_calloc(sizeof(entry_t));
 
-  entry->key = osi_strdup(key);
+  entry->section = section;
+  entry->key_name = key_name_get(section->config, key);
+  entry->key = entry->key_name->name;
   entry->value = osi_strdup(value);
+  entry->node.hash = entry_hash(section, entry->key_name);
+  list_append(section->entries, entry);
+  index_insert(&section->config->entry_index, &entry->node);
   return entry;
 }
 
@@ -522,7 +948,9 @@ static void entry_free(void *ptr) {
     return;
 
   entry_t *entry = ptr;
-  osi_free(entry->key);
+  config_t *config = entry->section->config;
+  index_remove(&config->entry_index, &entry->node);
+  key_name_put(config, entry->key_name);
   osi_free(entry->value);
   osi_free(entry);
 }
@@ -532,9 +960,15 @@ static entry_t *entry_find(const config_t *config, const char *section, const ch
   if (!sec)
     return NULL;
 
-  for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
-    entry_t *entry = list_node(node);
-    if (!strcmp(entry->key, key))
+  // A key name nobody uses cannot be in any section.
+  key_name_t *key_name = key_name_find(config, key);
+  if (!key_name)
+    return NULL;
+
+  hash_index_t hash = entry_hash(sec, key_name);
+  for (index_node_t *n = index_bucket(&config->entry_index, hash); n; n = n->next) {
+    entry_t *entry = (entry_t *)n;
+    if (entry->section == sec && entry->key_name == key_name)
       return entry;
   }
 
@@ -0,0 +1,206 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_pool"
+
+#include "osi/include/pool.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "osi/include/allocator.h"
+#include "osi/include/list.h"
+#include "osi/include/time.h"
+
+// Block sizes are rounded up to this, so every block keeps the alignment
+// |osi_malloc| gave the slab.
+#define POOL_BLOCK_ALIGN 16
+
+typedef struct block_t {
+  struct block_t *next;
+} block_t;
+
+struct pool_t {
+  pthread_mutex_t lock;
+  char *name;
+  uint8_t *slab;
+  uint8_t *slab_end;
+  size_t block_size;        // requested size
+  size_t stride;            // |block_size| rounded up to the alignment
+  block_t *free_blocks;
+  pool_stats_t stats;
+
+  // Counters as of the previous |pool_debug_dump|.
+  uint64_t dumped_hits;
+  uint64_t dumped_us;
+};
+
+// All live pools, for |pool_debug_dump|.
+static pthread_mutex_t pools_lock = PTHREAD_MUTEX_INITIALIZER;
+static list_t *pools;
+
+pool_t *pool_new(const char *name, size_t block_size, size_t num_blocks) {
+  assert(name != NULL);
+  assert(block_size > 0);
+  assert(num_blocks > 0);
+
+  pool_t *pool = osi_calloc(sizeof(pool_t));
+  pthread_mutex_init(&pool->lock, NULL);
+  pool->name = osi_strdup(name);
+  pool->block_size = block_size;
+  pool->stride = (block_size + POOL_BLOCK_ALIGN - 1) & ~(size_t)(POOL_BLOCK_ALIGN - 1);
+  pool->slab = osi_malloc(pool->stride * num_blocks);
+  pool->slab_end = pool->slab + pool->stride * num_blocks;
+  pool->stats.block_size = block_size;
+  pool->stats.num_blocks = num_blocks;
+  pool->dumped_us = time_get_os_boottime_us();
+
+  // Hand out the blocks in address order.
+  for (size_t i = num_blocks; i > 0; --i) {
+    block_t *block = (block_t *)(pool->slab + pool->stride * (i - 1));
+    block->next = pool->free_blocks;
+    pool->free_blocks = block;
+  }
+
+  pthread_mutex_lock(&pools_lock);
+  if (!pools)
+    pools = list_new(NULL);
+  list_append(pools, pool);
+  pthread_mutex_unlock(&pools_lock);
+
+  return pool;
+}
+
+void pool_free(pool_t *pool) {
+  if (!pool)
+    return;
+
+  assert(pool->stats.in_use == 0);
+
+  pthread_mutex_lock(&pools_lock);
+  list_remove(pools, pool);
+  if (list_is_empty(pools)) {
+    list_free(pools);
+    pools = NULL;
+  }
+  pthread_mutex_unlock(&pools_lock);
+
+  pthread_mutex_destroy(&pool->lock);
+  osi_free(pool->slab);
+  osi_free(pool->name);
+  osi_free(pool);
+}
+
+void *pool_alloc(pool_t *pool, size_t size) {
+  if (!pool)
+    return osi_malloc(size);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stats.allocs++;
+  if (size > pool->block_size) {
+    pool->stats.too_big++;
+  } else if (!pool->free_blocks) {
+    pool->stats.exhausted++;
+  } else {
+    block_t *block = pool->free_blocks;
+    pool->free_blocks = block->next;
+    pool->stats.hits++;
+    pool->stats.in_use++;
+    pthread_mutex_unlock(&pool->lock);
+    return block;
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return osi_malloc(size);
+}
+
+void pool_put(pool_t *pool, void *ptr) {
+  if (!ptr)
+    return;
+
+  if (!pool_owns(pool, ptr)) {
+    osi_free(ptr);
+    return;
+  }
+
+  assert(((uint8_t *)ptr - pool->slab) % pool->stride == 0);
+
+  block_t *block = ptr;
+  pthread_mutex_lock(&pool->lock);
+  block->next = pool->free_blocks;
+  pool->free_blocks = block;
+  pool->stats.in_use--;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+bool pool_owns(const pool_t *pool, const void *ptr) {
+  // The slab never moves, so no lock is needed.
+  return pool && (const uint8_t *)ptr >= pool->slab &&
+      (const uint8_t *)ptr < pool->slab_end;
+}
+
+void pool_get_stats(pool_t *pool, pool_stats_t *stats) {
+  assert(stats != NULL);
+
+  if (!pool) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  *stats = pool->stats;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth Message Pools:\n");
+
+  pthread_mutex_lock(&pools_lock);
+  if (!pools) {
+    pthread_mutex_unlock(&pools_lock);
+    dprintf(fd, "  None\n");
+    return;
+  }
+
+  uint64_t now_us = time_get_os_boottime_us();
+  for (const list_node_t *node = list_begin(pools); node != list_end(pools);
+       node = list_next(node)) {
+    pool_t *pool = list_node(node);
+
+    pthread_mutex_lock(&pool->lock);
+    pool_stats_t stats = pool->stats;
+    uint64_t hits = stats.hits - pool->dumped_hits;
+    uint64_t elapsed_us = now_us - pool->dumped_us;
+    pool->dumped_hits = stats.hits;
+    pool->dumped_us = now_us;
+    pthread_mutex_unlock(&pool->lock);
+
+    dprintf(fd, "  Pool : %s (%zu x %zu bytes)\n", pool->name,
+            stats.num_blocks, stats.block_size);
+    dprintf(fd, "%-51s: %zu\n", "    Blocks in use", stats.in_use);
+    dprintf(fd, "%-51s: %" PRIu64 " / %" PRIu64 " / %" PRIu64 " / %" PRIu64 "\n",
+            "    Allocations (total/pooled/too big/exhausted)",
+            stats.allocs, stats.hits, stats.too_big, stats.exhausted);
+    dprintf(fd, "%-51s: %.1f\n", "    Allocations avoided per second",
+            elapsed_us ? hits * 1000000.0 / elapsed_us : 0.0);
+  }
+  pthread_mutex_unlock(&pools_lock);
+}
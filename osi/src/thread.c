@@ -33,6 +33,7 @@
 #include "osi/include/compat.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
+#include "osi/include/pool.h"
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
@@ -43,6 +44,7 @@ struct thread_t {
   char name[THREAD_NAME_MAX + 1];
   reactor_t *reactor;
   fixed_queue_t *work_queue;
+  pool_t *work_items;
 };
 
 struct start_arg {
@@ -58,9 +60,15 @@ typedef struct {
 
 static void *run_thread(void *start_arg);
 static void work_queue_read_cb(void *context);
+static void work_queue_free(thread_t *thread);
 
 static const size_t DEFAULT_WORK_QUEUE_CAPACITY = 128;
 
+// Work items come from a per thread pool, so posting does not allocate. A
+// full work queue blocks the poster, so the pool only needs to cover the
+// queue's capacity, up to this many items.
+static const size_t MAX_WORK_ITEM_POOL_SIZE = 256;
+
 thread_t *thread_new_sized(const char *name, size_t work_queue_capacity) {
   assert(name != NULL);
   assert(work_queue_capacity != 0);
@@ -78,6 +86,9 @@ thread_t *thread_new_sized(const char *name, size_t work_queue_capacity) {
   if (!ret->work_queue)
     goto error;
 
+  ret->work_items = pool_new(name, sizeof(work_item_t),
+      work_queue_capacity < MAX_WORK_ITEM_POOL_SIZE ? work_queue_capacity : MAX_WORK_ITEM_POOL_SIZE);
+
   // Start is on the stack, but we use a semaphore, so it's safe
   struct start_arg start;
   start.start_sem = semaphore_new(0);
@@ -98,7 +109,7 @@ thread_t *thread_new_sized(const char *name, size_t work_queue_capacity) {
 
 error:;
   if (ret) {
-    fixed_queue_free(ret->work_queue, osi_free);
+    work_queue_free(ret);
     reactor_free(ret->reactor);
   }
   osi_free(ret);
@@ -116,7 +127,7 @@ void thread_free(thread_t *thread) {
   thread_stop(thread);
   thread_join(thread);
 
-  fixed_queue_free(thread->work_queue, osi_free);
+  work_queue_free(thread);
   reactor_free(thread->reactor);
   osi_free(thread);
 }
@@ -141,7 +152,7 @@ bool thread_post(thread_t *thread, thread_fn func, void *context) {
 
   // Queue item is freed either when the queue itself is destroyed
   // or when the item is removed from the queue for dispatch.
-  work_item_t *item = (work_item_t *)osi_malloc(sizeof(work_item_t));
+  work_item_t *item = (work_item_t *)pool_alloc(thread->work_items, sizeof(work_item_t));
   item->func = func;
   item->context = context;
   fixed_queue_enqueue(thread->work_queue, item);
@@ -203,7 +214,7 @@ static void *run_thread(void *start_arg) {
   semaphore_post(start->start_sem);
 
   int fd = fixed_queue_get_dequeue_fd(thread->work_queue);
-  void *context = thread->work_queue;
+  void *context = thread;
 
   reactor_object_t *work_queue_object = reactor_register(thread->reactor, fd, context, work_queue_read_cb, NULL);
   reactor_start(thread->reactor);
@@ -216,7 +227,7 @@ static void *run_thread(void *start_arg) {
   work_item_t *item = fixed_queue_try_dequeue(thread->work_queue);
   while (item && count <= fixed_queue_capacity(thread->work_queue)) {
     item->func(item->context);
-    osi_free(item);
+    pool_put(thread->work_items, item);
     item = fixed_queue_try_dequeue(thread->work_queue);
     ++count;
   }
@@ -231,8 +242,18 @@ static void *run_thread(void *start_arg) {
 static void work_queue_read_cb(void *context) {
   assert(context != NULL);
 
-  fixed_queue_t *queue = (fixed_queue_t *)context;
-  work_item_t *item = fixed_queue_dequeue(queue);
+  thread_t *thread = (thread_t *)context;
+  work_item_t *item = fixed_queue_dequeue(thread->work_queue);
   item->func(item->context);
-  osi_free(item);
+  pool_put(thread->work_items, item);
+}
+
+static void work_queue_free(thread_t *thread) {
+  if (thread->work_queue) {
+    work_item_t *item;
+    while ((item = fixed_queue_try_dequeue(thread->work_queue)) != NULL)
+      pool_put(thread->work_items, item);
+    fixed_queue_free(thread->work_queue, NULL);
+  }
+  pool_free(thread->work_items);
 }
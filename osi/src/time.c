@@ -27,3 +27,9 @@ uint32_t time_get_os_boottime_ms(void) {
   clock_gettime(CLOCK_BOOTTIME, &timespec);
   return (timespec.tv_sec * 1000) + (timespec.tv_nsec / 1000000);
 }
+
+uint64_t time_get_os_boottime_us(void) {
+  struct timespec timespec;
+  clock_gettime(CLOCK_BOOTTIME, &timespec);
+  return ((uint64_t)timespec.tv_sec * 1000000) + (timespec.tv_nsec / 1000);
+}
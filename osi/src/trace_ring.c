@@ -0,0 +1,490 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_trace_ring"
+
+#include "osi/include/trace_ring.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "osi/include/allocator.h"
+#include "osi/include/compat.h"
+#include "osi/include/list.h"
+#include "osi/include/osi.h"
+#include "osi/include/time.h"
+
+#define TRACE_RING_RECORDS 256
+#define TRACE_RING_MAX_ARGS 8
+#define TRACE_RING_STRING_SIZE 64
+
+// Offset of a "%s" argument that did not fit in |strings|.
+#define STRING_TRUNCATED TRACE_RING_STRING_SIZE
+// Offset of a NULL "%s" argument.
+#define STRING_NULL (TRACE_RING_STRING_SIZE + 1)
+
+typedef struct {
+  uint64_t timestamp_us;
+  const char *tag;
+  const char *format;
+  uint64_t args[TRACE_RING_MAX_ARGS];
+  uint8_t num_args;
+  char level;
+  char strings[TRACE_RING_STRING_SIZE];   // "%s" arguments, NUL terminated
+} trace_record_t;
+
+typedef struct {
+  pid_t tid;                              // 0 once the thread has exited
+  uint32_t head;                          // records written, stored with release
+  trace_record_t records[TRACE_RING_RECORDS];
+} trace_ring_t;
+
+typedef enum {
+  ARG_SIGNED,
+  ARG_UNSIGNED,
+  ARG_DOUBLE,
+  ARG_POINTER,
+  ARG_STRING,
+  ARG_IGNORED,                            // %n
+} arg_type_t;
+
+typedef enum {
+  LENGTH_NONE,
+  LENGTH_HH,
+  LENGTH_H,
+  LENGTH_L,
+  LENGTH_LL,
+  LENGTH_BIG_L,
+  LENGTH_J,
+  LENGTH_Z,
+  LENGTH_T,
+} length_t;
+
+// A single conversion of a printf format.
+typedef struct {
+  char flags[8];
+  int width;                              // -1 for none, -2 for '*'
+  int precision;                          // -1 for none, -2 for '*'
+  length_t length;
+  char conversion;
+  arg_type_t type;
+} spec_t;
+
+// Guards |rings| and the ownership of every ring in it. The owning thread
+// writes its ring without it.
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static list_t *rings;
+
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ring_key;
+
+static void ring_key_init(void);
+static void ring_release(void *ring);
+static trace_ring_t *ring_get(void);
+static const char *parse_spec(const char *p, spec_t *spec);
+static void dump_record(int fd, const trace_record_t *record);
+
+void trace_ring_record(const char *tag, char level, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  trace_ring_vrecord(tag, level, format, args);
+  va_end(args);
+}
+
+void trace_ring_vrecord(const char *tag, char level, const char *format,
+                        va_list args) {
+  trace_ring_t *ring = ring_get();
+  if (!ring || !format)
+    return;
+
+  // Only this thread stores to |head|.
+  uint32_t head = ring->head;
+  trace_record_t *record = &ring->records[head % TRACE_RING_RECORDS];
+
+  record->timestamp_us = time_get_os_boottime_us();
+  record->tag = tag;
+  record->format = format;
+  record->level = level;
+  record->num_args = 0;
+
+  size_t strings_len = 0;
+  const char *p = format;
+  while ((p = strchr(p, '%')) != NULL) {
+    spec_t spec;
+    p = parse_spec(p + 1, &spec);
+    if (spec.conversion == '%')
+      continue;
+    // The argument types are unknown past an unsupported conversion.
+    if (spec.conversion == '\0')
+      break;
+
+    int stars = (spec.width == -2) + (spec.precision == -2);
+    if (record->num_args + stars + 1 > TRACE_RING_MAX_ARGS)
+      break;
+
+    for (int i = 0; i < stars; ++i)
+      record->args[record->num_args++] = (uint64_t)(int64_t)va_arg(args, int);
+
+    uint64_t value = 0;
+    switch (spec.type) {
+      case ARG_SIGNED: {
+        int64_t v;
+        switch (spec.length) {
+          case LENGTH_HH: v = (signed char)va_arg(args, int); break;
+          case LENGTH_H: v = (short)va_arg(args, int); break;
+          case LENGTH_L: v = va_arg(args, long); break;
+          case LENGTH_LL: v = va_arg(args, long long); break;
+          case LENGTH_J: v = va_arg(args, intmax_t); break;
+          case LENGTH_Z: v = va_arg(args, ssize_t); break;
+          case LENGTH_T: v = va_arg(args, ptrdiff_t); break;
+          default: v = va_arg(args, int); break;
+        }
+        value = (uint64_t)v;
+        break;
+      }
+      case ARG_UNSIGNED:
+        switch (spec.length) {
+          case LENGTH_HH: value = (unsigned char)va_arg(args, unsigned int); break;
+          case LENGTH_H: value = (unsigned short)va_arg(args, unsigned int); break;
+          case LENGTH_L: value = va_arg(args, unsigned long); break;
+          case LENGTH_LL: value = va_arg(args, unsigned long long); break;
+          case LENGTH_J: value = va_arg(args, uintmax_t); break;
+          case LENGTH_Z: value = va_arg(args, size_t); break;
+          case LENGTH_T: value = (uint64_t)va_arg(args, ptrdiff_t); break;
+          default: value = va_arg(args, unsigned int); break;
+        }
+        break;
+      case ARG_DOUBLE: {
+        double v = (spec.length == LENGTH_BIG_L) ?
+            (double)va_arg(args, long double) : va_arg(args, double);
+        memcpy(&value, &v, sizeof(value));
+        break;
+      }
+      case ARG_POINTER:
+      case ARG_IGNORED:
+        value = (uintptr_t)va_arg(args, void *);
+        break;
+      case ARG_STRING: {
+        const char *s = va_arg(args, const char *);
+        if (!s) {
+          value = STRING_NULL;
+          break;
+        }
+        // With a precision |s| need not be terminated, e.g. "%.*s" of a
+        // buffer; only the part that gets printed is read and stored.
+        int precision = spec.precision;
+        if (precision == -2)
+          precision = (int)record->args[record->num_args - 1];
+        size_t len = precision >= 0 ? strnlen(s, precision) : strlen(s);
+        if (strings_len + len + 1 > TRACE_RING_STRING_SIZE) {
+          value = STRING_TRUNCATED;
+          break;
+        }
+        memcpy(record->strings + strings_len, s, len);
+        record->strings[strings_len + len] = '\0';
+        value = strings_len;
+        strings_len += len + 1;
+        break;
+      }
+    }
+    record->args[record->num_args++] = value;
+  }
+
+  // Publishes the record to |trace_ring_debug_dump|.
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void trace_ring_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth Trace Ring:\n");
+
+  trace_record_t *records = osi_malloc(sizeof(trace_record_t) * TRACE_RING_RECORDS);
+
+  pthread_mutex_lock(&rings_lock);
+  if (!rings) {
+    pthread_mutex_unlock(&rings_lock);
+    osi_free(records);
+    dprintf(fd, "  None\n");
+    return;
+  }
+
+  for (const list_node_t *node = list_begin(rings); node != list_end(rings);
+       node = list_next(node)) {
+    trace_ring_t *ring = list_node(node);
+
+    // The owner keeps writing while the ring is copied. Records written in
+    // the meantime, and the one being written as |end| is read, may be torn
+    // and are skipped.
+    uint32_t start = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    memcpy(records, ring->records, sizeof(trace_record_t) * TRACE_RING_RECORDS);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint32_t end = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+
+    uint32_t first = start > TRACE_RING_RECORDS ? start - TRACE_RING_RECORDS : 0;
+    if (end - first >= TRACE_RING_RECORDS)
+      first = end - TRACE_RING_RECORDS + 1;
+
+    if (ring->tid)
+      dprintf(fd, "  Thread %d (%" PRIu32 " records):\n", ring->tid, start);
+    else
+      dprintf(fd, "  Exited thread (%" PRIu32 " records):\n", start);
+
+    for (uint32_t i = first; (int32_t)(start - i) > 0; ++i)
+      dump_record(fd, &records[i % TRACE_RING_RECORDS]);
+  }
+  pthread_mutex_unlock(&rings_lock);
+
+  osi_free(records);
+}
+
+static void ring_key_init(void) {
+  pthread_key_create(&ring_key, ring_release);
+}
+
+// Called when the owning thread exits. The ring keeps its records until
+// another thread takes it over.
+static void ring_release(void *ring) {
+  pthread_mutex_lock(&rings_lock);
+  ((trace_ring_t *)ring)->tid = 0;
+  pthread_mutex_unlock(&rings_lock);
+}
+
+static trace_ring_t *ring_get(void) {
+  pthread_once(&ring_key_once, ring_key_init);
+
+  trace_ring_t *ring = pthread_getspecific(ring_key);
+  if (ring)
+    return ring;
+
+  pthread_mutex_lock(&rings_lock);
+  if (!rings)
+    rings = list_new(NULL);
+
+  // Reuse the ring of an exited thread before growing the list.
+  for (const list_node_t *node = list_begin(rings); node != list_end(rings);
+       node = list_next(node)) {
+    trace_ring_t *candidate = list_node(node);
+    if (!candidate->tid) {
+      ring = candidate;
+      ring->head = 0;
+      break;
+    }
+  }
+  if (!ring) {
+    ring = osi_calloc(sizeof(trace_ring_t));
+    list_append(rings, ring);
+  }
+  ring->tid = gettid();
+  pthread_mutex_unlock(&rings_lock);
+
+  pthread_setspecific(ring_key, ring);
+  return ring;
+}
+
+// Parses the conversion following a '%' at |p|. Returns a pointer past it.
+// |spec->conversion| is '\0' if the conversion is not supported.
+static const char *parse_spec(const char *p, spec_t *spec) {
+  size_t num_flags = 0;
+  while (*p && strchr("-+ #0", *p)) {
+    if (num_flags < sizeof(spec->flags) - 1)
+      spec->flags[num_flags++] = *p;
+    ++p;
+  }
+  spec->flags[num_flags] = '\0';
+
+  spec->width = -1;
+  if (*p == '*') {
+    spec->width = -2;
+    ++p;
+  } else if (*p >= '0' && *p <= '9') {
+    spec->width = 0;
+    while (*p >= '0' && *p <= '9')
+      spec->width = spec->width * 10 + (*p++ - '0');
+  }
+
+  spec->precision = -1;
+  if (*p == '.') {
+    ++p;
+    spec->precision = 0;
+    if (*p == '*') {
+      spec->precision = -2;
+      ++p;
+    } else {
+      while (*p >= '0' && *p <= '9')
+        spec->precision = spec->precision * 10 + (*p++ - '0');
+    }
+  }
+
+  spec->length = LENGTH_NONE;
+  switch (*p) {
+    case 'h':
+      spec->length = (p[1] == 'h') ? LENGTH_HH : LENGTH_H;
+      p += (p[1] == 'h') ? 2 : 1;
+      break;
+    case 'l':
+      spec->length = (p[1] == 'l') ? LENGTH_LL : LENGTH_L;
+      p += (p[1] == 'l') ? 2 : 1;
+      break;
+    case 'q': spec->length = LENGTH_LL; ++p; break;
+    case 'L': spec->length = LENGTH_BIG_L; ++p; break;
+    case 'j': spec->length = LENGTH_J; ++p; break;
+    case 'z': spec->length = LENGTH_Z; ++p; break;
+    case 't': spec->length = LENGTH_T; ++p; break;
+  }
+
+  spec->conversion = *p;
+  switch (*p) {
+    case 'd': case 'i': case 'c':
+      spec->type = ARG_SIGNED;
+      break;
+    case 'u': case 'x': case 'X': case 'o':
+      spec->type = ARG_UNSIGNED;
+      break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      spec->type = ARG_DOUBLE;
+      break;
+    case 'p':
+      spec->type = ARG_POINTER;
+      break;
+    case 's':
+      spec->type = ARG_STRING;
+      break;
+    case 'n':
+      spec->type = ARG_IGNORED;
+      break;
+    case '%':
+      break;
+    default:
+      spec->conversion = '\0';
+      return p;
+  }
+  return p + 1;
+}
+
+static void dump_record(int fd, const trace_record_t *record) {
+  char line[1024];
+  size_t len = 0;
+  size_t next_arg = 0;
+
+#define APPEND(...)                                                     \
+  do {                                                                  \
+    if (len < sizeof(line)) {                                           \
+      int n = snprintf(line + len, sizeof(line) - len, __VA_ARGS__);    \
+      if (n > 0)                                                        \
+        len += n;                                                       \
+    }                                                                   \
+  } while (0)
+
+  const char *p = record->format;
+  while (*p) {
+    const char *percent = strchr(p, '%');
+    if (!percent) {
+      APPEND("%s", p);
+      break;
+    }
+    APPEND("%.*s", (int)(percent - p), p);
+
+    spec_t spec;
+    const char *end = parse_spec(percent + 1, &spec);
+    if (spec.conversion == '%') {
+      APPEND("%%");
+      p = end;
+      continue;
+    }
+
+    // Unsupported conversions, and anything past the recorded arguments,
+    // are shown as written.
+    int stars = (spec.width == -2) + (spec.precision == -2);
+    if (spec.conversion == '\0' || next_arg + stars + 1 > record->num_args) {
+      APPEND("%s", percent);
+      break;
+    }
+
+    int width = spec.width;
+    int precision = spec.precision;
+    if (spec.width == -2)
+      width = (int)record->args[next_arg++];
+    if (spec.precision == -2)
+      precision = (int)record->args[next_arg++];
+    uint64_t value = record->args[next_arg++];
+
+    // Rebuild the conversion for the single stored argument. A negative
+    // '*' width still reads as the '-' flag; a negative '*' precision is
+    // dropped, as printf ignores it.
+    char format[32];
+    int n = snprintf(format, sizeof(format), "%%%s", spec.flags);
+    if (spec.width != -1)
+      n += snprintf(format + n, sizeof(format) - n, "%d", width);
+    if (spec.precision != -1 && precision >= 0)
+      n += snprintf(format + n, sizeof(format) - n, ".%d", precision);
+
+    switch (spec.type) {
+      case ARG_SIGNED:
+        if (spec.conversion == 'c') {
+          snprintf(format + n, sizeof(format) - n, "c");
+          APPEND(format, (int)value);
+        } else {
+          snprintf(format + n, sizeof(format) - n, "lld");
+          APPEND(format, (long long)value);
+        }
+        break;
+      case ARG_UNSIGNED:
+        snprintf(format + n, sizeof(format) - n, "ll%c", spec.conversion);
+        APPEND(format, (unsigned long long)value);
+        break;
+      case ARG_DOUBLE: {
+        double v;
+        memcpy(&v, &value, sizeof(v));
+        snprintf(format + n, sizeof(format) - n, "%c", spec.conversion);
+        APPEND(format, v);
+        break;
+      }
+      case ARG_POINTER:
+        snprintf(format + n, sizeof(format) - n, "p");
+        APPEND(format, (void *)(uintptr_t)value);
+        break;
+      case ARG_STRING: {
+        const char *s = "...";
+        if (value == STRING_NULL)
+          s = "(null)";
+        else if (value < STRING_TRUNCATED)
+          s = record->strings + value;
+        snprintf(format + n, sizeof(format) - n, "s");
+        APPEND(format, s);
+        break;
+      }
+      case ARG_IGNORED:
+        break;
+    }
+    p = end;
+  }
+
+#undef APPEND
+
+  if (len >= sizeof(line))
+    len = sizeof(line) - 1;
+
+  dprintf(fd, "    %" PRIu64 ".%06" PRIu64 " %c %s: %.*s\n",
+          record->timestamp_us / 1000000, record->timestamp_us % 1000000,
+          record->level, record->tag ? record->tag : "", (int)len, line);
+}
@@ -252,6 +252,65 @@ TEST_F(AlarmTest, test_set_long_long) {
   alarm_free(alarm[1]);
 }
 
+TEST_F(AlarmTest, test_set_slack_batches) {
+  alarm_t *alarm[2] = {
+    alarm_new("alarm_test.test_set_slack_batches_0"),
+    alarm_new("alarm_test.test_set_slack_batches_1")
+  };
+
+  // The first alarm may wait for the second one.
+  alarm_set_with_slack(alarm[0], 10, 50, cb, NULL);
+  alarm_set(alarm[1], 40, cb, NULL);
+
+  EXPECT_TRUE(WakeLockHeld());
+  msleep(20);
+  EXPECT_EQ(cb_counter, 0);
+
+  semaphore_wait(semaphore);
+  semaphore_wait(semaphore);
+
+  EXPECT_EQ(cb_counter, 2);
+  EXPECT_FALSE(WakeLockHeld());
+
+  alarm_free(alarm[0]);
+  alarm_free(alarm[1]);
+}
+
+TEST_F(AlarmTest, test_set_slack_bounded) {
+  alarm_t *alarm = alarm_new("alarm_test.test_set_slack_bounded");
+
+  alarm_set_with_slack(alarm, 10, 20, cb, NULL);
+
+  msleep(10 + 20 + EPSILON_MS);
+  EXPECT_EQ(cb_counter, 1);
+  EXPECT_FALSE(WakeLockHeld());
+
+  alarm_free(alarm);
+}
+
+TEST_F(AlarmTest, test_set_without_slack_clears_it) {
+  alarm_t *alarm[2] = {
+    alarm_new("alarm_test.test_set_without_slack_clears_it_0"),
+    alarm_new("alarm_test.test_set_without_slack_clears_it_1")
+  };
+
+  // Setting the first alarm again without slack drops the earlier slack, so
+  // it no longer waits for the second one.
+  alarm_set_with_slack(alarm[0], 10, 100, cb, NULL);
+  alarm_set(alarm[0], 10, cb, NULL);
+  alarm_set(alarm[1], 80, cb, NULL);
+
+  msleep(10 + EPSILON_MS);
+  EXPECT_EQ(cb_counter, 1);
+
+  semaphore_wait(semaphore);
+  semaphore_wait(semaphore);
+  EXPECT_EQ(cb_counter, 2);
+
+  alarm_free(alarm[0]);
+  alarm_free(alarm[1]);
+}
+
 TEST_F(AlarmTest, test_is_scheduled) {
   alarm_t *alarm = alarm_new("alarm_test.test_is_scheduled");
 
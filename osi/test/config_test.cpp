@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <unistd.h>
 
 #include "AllocationTestHarness.h"
 
@@ -7,6 +8,7 @@ extern "C" {
 }
 
 static const char CONFIG_FILE[] = "/data/local/tmp/config_test.conf";
+static const char JOURNAL_FILE[] = "/data/local/tmp/config_test.journal";
 static const char CONFIG_FILE_CONTENT[] =
 "                                                                                    \n\
 first_key=value                                                                      \n\
@@ -55,6 +57,7 @@ class ConfigTest : public AllocationTestHarness {
       FILE *fp = fopen(CONFIG_FILE, "wt");
       fwrite(CONFIG_FILE_CONTENT, 1, sizeof(CONFIG_FILE_CONTENT), fp);
       fclose(fp);
+      unlink(JOURNAL_FILE);
     }
 };
 
@@ -165,6 +168,39 @@ TEST_F(ConfigTest, config_remove_key_missing) {
   config_free(config);
 }
 
+TEST_F(ConfigTest, config_many_sections) {
+  config_t *config = config_new_empty();
+  char section[32];
+  for (int i = 0; i < 1000; ++i) {
+    snprintf(section, sizeof(section), "%02x:%02x:00:00:00:00", i >> 8, i & 0xff);
+    config_set_int(config, section, "Index", i);
+    config_set_string(config, section, "Name", section);
+  }
+
+  for (int i = 0; i < 1000; i += 2) {
+    snprintf(section, sizeof(section), "%02x:%02x:00:00:00:00", i >> 8, i & 0xff);
+    EXPECT_TRUE(config_remove_key(config, section, "Name"));
+    EXPECT_TRUE(config_remove_section(config, section));
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    snprintf(section, sizeof(section), "%02x:%02x:00:00:00:00", i >> 8, i & 0xff);
+    EXPECT_EQ(config_has_section(config, section), i % 2 == 1);
+    EXPECT_EQ(config_get_int(config, section, "Index", -1), i % 2 ? i : -1);
+  }
+
+  // Sections keep the order they were added in.
+  int i = 1;
+  for (const config_section_node_t *node = config_section_begin(config);
+       node != config_section_end(config); node = config_section_next(node), i += 2) {
+    snprintf(section, sizeof(section), "%02x:%02x:00:00:00:00", i >> 8, i & 0xff);
+    EXPECT_STREQ(section, config_section_name(node));
+  }
+  EXPECT_EQ(i, 1001);
+
+  config_free(config);
+}
+
 TEST_F(ConfigTest, config_section_begin) {
   config_t *config = config_new(CONFIG_FILE);
   const config_section_node_t *section = config_section_begin(config);
@@ -201,3 +237,94 @@ TEST_F(ConfigTest, config_save_basic) {
   EXPECT_TRUE(config_save(config, CONFIG_FILE));
   config_free(config);
 }
+
+TEST_F(ConfigTest, config_journal_replay) {
+  config_journal_t *journal = config_journal_open(JOURNAL_FILE, 1);
+  EXPECT_TRUE(journal != NULL);
+  EXPECT_TRUE(config_journal_set(journal, "DID", "productId", "0x1300"));
+  EXPECT_TRUE(config_journal_set(journal, "New", "key", "a value"));
+  EXPECT_TRUE(config_journal_remove_key(journal, "DID", "version"));
+  EXPECT_TRUE(config_journal_remove_section(journal, CONFIG_DEFAULT_SECTION));
+  EXPECT_TRUE(config_journal_commit(journal));
+  EXPECT_TRUE(config_journal_size(journal) > 0);
+  config_journal_close(journal);
+
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_EQ(config_journal_replay(config, JOURNAL_FILE, 1), 4);
+  EXPECT_EQ(config_get_int(config, "DID", "productId", 0), 0x1300);
+  EXPECT_STREQ(config_get_string(config, "New", "key", NULL), "a value");
+  EXPECT_FALSE(config_has_key(config, "DID", "version"));
+  EXPECT_FALSE(config_has_section(config, CONFIG_DEFAULT_SECTION));
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_journal_uncommitted) {
+  config_journal_t *journal = config_journal_open(JOURNAL_FILE, 1);
+  EXPECT_TRUE(config_journal_set(journal, "DID", "productId", "0x1300"));
+  EXPECT_TRUE(config_journal_reset(journal, 1));
+  config_journal_close(journal);
+
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_EQ(config_journal_replay(config, JOURNAL_FILE, 1), 0);
+  EXPECT_EQ(config_get_int(config, "DID", "productId", 0), 0x1200);
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_journal_other_generation) {
+  config_journal_t *journal = config_journal_open(JOURNAL_FILE, 1);
+  EXPECT_TRUE(config_journal_set(journal, "DID", "productId", "0x1300"));
+  EXPECT_TRUE(config_journal_commit(journal));
+  config_journal_close(journal);
+
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_EQ(config_journal_replay(config, JOURNAL_FILE, 2), 0);
+  EXPECT_EQ(config_get_int(config, "DID", "productId", 0), 0x1200);
+
+  // Opening for another generation starts an empty journal.
+  journal = config_journal_open(JOURNAL_FILE, 2);
+  config_journal_close(journal);
+  EXPECT_EQ(config_journal_replay(config, JOURNAL_FILE, 1), 0);
+  EXPECT_EQ(config_journal_replay(config, JOURNAL_FILE, 2), 0);
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_journal_torn_record) {
+  config_journal_t *journal = config_journal_open(JOURNAL_FILE, 1);
+  EXPECT_TRUE(config_journal_set(journal, "DID", "productId", "0x1300"));
+  EXPECT_TRUE(config_journal_commit(journal));
+  config_journal_close(journal);
+
+  FILE *fp = fopen(JOURNAL_FILE, "at");
+  fputs("+[DID] vers", fp);
+  fclose(fp);
+
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_EQ(config_journal_replay(config, JOURNAL_FILE, 1), 1);
+
+  // New records must not be appended to the torn one.
+  journal = config_journal_open(JOURNAL_FILE, 1);
+  EXPECT_TRUE(config_journal_set(journal, "DID", "version", "0x2222"));
+  EXPECT_TRUE(config_journal_commit(journal));
+  config_journal_close(journal);
+
+  EXPECT_EQ(config_journal_replay(config, JOURNAL_FILE, 1), 2);
+  EXPECT_EQ(config_get_int(config, "DID", "version", 0), 0x2222);
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_journal_unrepresentable) {
+  config_t *config = config_new(CONFIG_FILE);
+  config_journal_t *journal = config_journal_open(JOURNAL_FILE, 1);
+  EXPECT_FALSE(config_journal_set(journal, "DID", "key", "two\nlines"));
+  EXPECT_FALSE(config_journal_set(journal, "DID", "a=b", "value"));
+  EXPECT_FALSE(config_journal_remove_section(journal, "a]b"));
+  EXPECT_TRUE(config_journal_add_section(journal, config, "DID"));
+  EXPECT_TRUE(config_journal_commit(journal));
+  config_journal_close(journal);
+
+  config_t *empty = config_new_empty();
+  EXPECT_EQ(config_journal_replay(empty, JOURNAL_FILE, 1), 4);
+  EXPECT_EQ(config_get_int(empty, "DID", "version", 0), 0x1436);
+  config_free(empty);
+  config_free(config);
+}
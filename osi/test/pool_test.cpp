@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "AllocationTestHarness.h"
+
+extern "C" {
+#include "osi/include/allocator.h"
+#include "osi/include/pool.h"
+}
+
+class PoolTest : public AllocationTestHarness {};
+
+TEST_F(PoolTest, test_new_free) {
+  pool_t *pool = pool_new("test", 32, 4);
+  ASSERT_TRUE(pool != NULL);
+  pool_free(pool);
+}
+
+TEST_F(PoolTest, test_alloc_from_slab) {
+  pool_t *pool = pool_new("test", 24, 4);
+
+  void *blocks[4];
+  for (int i = 0; i < 4; ++i) {
+    blocks[i] = pool_alloc(pool, 24);
+    EXPECT_TRUE(pool_owns(pool, blocks[i]));
+    EXPECT_EQ(0u, (uintptr_t)blocks[i] % sizeof(void *));
+    memset(blocks[i], i, 24);
+  }
+
+  pool_stats_t stats;
+  pool_get_stats(pool, &stats);
+  EXPECT_EQ(4u, stats.allocs);
+  EXPECT_EQ(4u, stats.hits);
+  EXPECT_EQ(4u, stats.in_use);
+
+  for (int i = 0; i < 4; ++i)
+    pool_put(pool, blocks[i]);
+
+  pool_get_stats(pool, &stats);
+  EXPECT_EQ(0u, stats.in_use);
+
+  // Released blocks are handed out again.
+  void *block = pool_alloc(pool, 8);
+  EXPECT_TRUE(pool_owns(pool, block));
+  pool_put(pool, block);
+
+  pool_free(pool);
+}
+
+TEST_F(PoolTest, test_fallback) {
+  pool_t *pool = pool_new("test", 16, 1);
+
+  void *big = pool_alloc(pool, 17);
+  EXPECT_FALSE(pool_owns(pool, big));
+
+  void *block = pool_alloc(pool, 16);
+  EXPECT_TRUE(pool_owns(pool, block));
+
+  void *extra = pool_alloc(pool, 16);
+  EXPECT_FALSE(pool_owns(pool, extra));
+
+  pool_stats_t stats;
+  pool_get_stats(pool, &stats);
+  EXPECT_EQ(3u, stats.allocs);
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.too_big);
+  EXPECT_EQ(1u, stats.exhausted);
+
+  pool_put(pool, big);
+  pool_put(pool, block);
+  pool_put(pool, extra);
+  pool_put(pool, NULL);
+
+  pool_free(pool);
+}
+
+TEST_F(PoolTest, test_put_osi_malloc) {
+  pool_t *pool = pool_new("test", 16, 1);
+  pool_put(pool, osi_malloc(8));
+  pool_free(pool);
+}
+
+TEST_F(PoolTest, test_null_pool) {
+  void *ptr = pool_alloc(NULL, 8);
+  EXPECT_TRUE(ptr != NULL);
+  EXPECT_FALSE(pool_owns(NULL, ptr));
+  pool_put(NULL, ptr);
+
+  pool_stats_t stats;
+  pool_get_stats(NULL, &stats);
+  EXPECT_EQ(0u, stats.allocs);
+}
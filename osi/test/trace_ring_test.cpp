@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string>
+
+extern "C" {
+#include "osi/include/trace_ring.h"
+}
+
+// Rings live for the whole process, so these tests do not use
+// AllocationTestHarness and look for their own records in the dump.
+static std::string dump() {
+  FILE *file = tmpfile();
+  trace_ring_debug_dump(fileno(file));
+  rewind(file);
+
+  std::string contents;
+  char buf[256];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), file)) > 0)
+    contents.append(buf, len);
+  fclose(file);
+  return contents;
+}
+
+TEST(TraceRingTest, test_record_formats_on_dump) {
+  const char *name = "handle";
+  trace_ring_record("bt_test", 'D', "basic %s=%d 0x%04x %c %%", name, -7, 0xbeef, 'z');
+  EXPECT_NE(std::string::npos, dump().find("D bt_test: basic handle=-7 0xbeef z %"));
+}
+
+TEST(TraceRingTest, test_string_is_copied) {
+  char name[] = "before";
+  trace_ring_record("bt_test", 'D', "copied %s", name);
+  strcpy(name, "after!");
+  EXPECT_NE(std::string::npos, dump().find("copied before"));
+}
+
+TEST(TraceRingTest, test_lengths) {
+  trace_ring_record("bt_test", 'W', "lengths %hhu %hd %ld %llu %zu",
+                    (unsigned char)200, (short)-3, -400000L,
+                    18446744073709551615ULL, (size_t)42);
+  EXPECT_NE(std::string::npos,
+            dump().find("W bt_test: lengths 200 -3 -400000 18446744073709551615 42"));
+}
+
+TEST(TraceRingTest, test_stars) {
+  trace_ring_record("bt_test", 'D', "stars %*d|%-*d|%.*s|%*d", 4, 7, 3, 8, 2, "abcdef", -3, 9);
+  EXPECT_NE(std::string::npos, dump().find("stars    7|8  |ab|9  "));
+}
+
+TEST(TraceRingTest, test_precision_limits_string_read) {
+  // Neither buffer is terminated; only |precision| bytes may be read.
+  const char fixed[4] = { 'w', 'x', 'y', 'z' };
+  const char starred[3] = { 'a', 'b', 'c' };
+  trace_ring_record("bt_test", 'D', "precision %.3s|%.*s|", fixed, 2, starred);
+  EXPECT_NE(std::string::npos, dump().find("precision wxy|ab|"));
+}
+
+TEST(TraceRingTest, test_null_and_long_strings) {
+  std::string long_string(100, 'x');
+  trace_ring_record("bt_test", 'D', "strings %s %s", (const char *)NULL, long_string.c_str());
+  EXPECT_NE(std::string::npos, dump().find("strings (null) ..."));
+}
+
+TEST(TraceRingTest, test_too_many_args) {
+  trace_ring_record("bt_test", 'D', "many %d %d %d %d %d %d %d %d %d %d",
+                    1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+  EXPECT_NE(std::string::npos, dump().find("many 1 2 3 4 5 6 7 8 %d %d"));
+}
+
+TEST(TraceRingTest, test_overwrites_oldest) {
+  trace_ring_record("bt_test", 'D', "oldest record");
+  for (int i = 0; i < 1000; ++i)
+    trace_ring_record("bt_test", 'D', "filler %d", i);
+
+  std::string contents = dump();
+  EXPECT_EQ(std::string::npos, contents.find("oldest record"));
+  EXPECT_NE(std::string::npos, contents.find("filler 999"));
+}
+
+static void *record_thread(void *context) {
+  trace_ring_record("bt_test", 'E', "from thread %d", *(int *)context);
+  return NULL;
+}
+
+TEST(TraceRingTest, test_threads_keep_records) {
+  for (int i = 0; i < 3; ++i) {
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, record_thread, &i));
+    pthread_join(thread, NULL);
+  }
+
+  // An exited thread's ring is taken over by the next thread.
+  std::string contents = dump();
+  EXPECT_NE(std::string::npos, contents.find("from thread 2"));
+  EXPECT_NE(std::string::npos, contents.find("Exited thread"));
+}
@@ -74,6 +74,7 @@ btserviceDaemonSrc := \
 	ipc/ipc_manager.cpp \
 	logging_helpers.cpp \
 	low_energy_client.cpp \
+	scan_filter_matcher.cpp \
 	settings.cpp
 
 btserviceLinuxSrc := \
@@ -108,6 +109,7 @@ btserviceBaseTestSrc := \
 	test/gatt_identifier_unittest.cpp \
 	test/gatt_server_unittest.cpp \
 	test/low_energy_client_unittest.cpp \
+	test/scan_filter_matcher_unittest.cpp \
 	test/settings_unittest.cpp \
 	test/util_unittest.cpp \
 	test/uuid_unittest.cpp
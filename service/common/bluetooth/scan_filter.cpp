@@ -29,6 +29,15 @@ ScanFilter::ScanFilter(const ScanFilter& other) {
 
   if (other.service_uuid_mask_)
     service_uuid_mask_.reset(new UUID(*other.service_uuid_mask_));
+
+  if (other.service_data_uuid_)
+    service_data_uuid_.reset(new UUID(*other.service_data_uuid_));
+  service_data_ = other.service_data_;
+  service_data_mask_ = other.service_data_mask_;
+
+  manufacturer_id_ = other.manufacturer_id_;
+  manufacturer_data_ = other.manufacturer_data_;
+  manufacturer_data_mask_ = other.manufacturer_data_mask_;
 }
 
 ScanFilter& ScanFilter::operator=(const ScanFilter& other) {
@@ -45,6 +54,17 @@ ScanFilter& ScanFilter::operator=(const ScanFilter& other) {
   else
     service_uuid_mask_ = nullptr;
 
+  if (other.service_data_uuid_)
+    service_data_uuid_.reset(new UUID(*other.service_data_uuid_));
+  else
+    service_data_uuid_ = nullptr;
+  service_data_ = other.service_data_;
+  service_data_mask_ = other.service_data_mask_;
+
+  manufacturer_id_ = other.manufacturer_id_;
+  manufacturer_data_ = other.manufacturer_data_;
+  manufacturer_data_mask_ = other.manufacturer_data_mask_;
+
   return *this;
 }
 
@@ -67,6 +87,43 @@ void ScanFilter::SetServiceUuidWithMask(const UUID& service_uuid,
   service_uuid_mask_.reset(new UUID(mask));
 }
 
+void ScanFilter::SetServiceData(const UUID& service_data_uuid,
+                                const std::vector<uint8_t>& data) {
+  SetServiceDataWithMask(service_data_uuid, data,
+                         std::vector<uint8_t>(data.size(), 0xFF));
+}
+
+bool ScanFilter::SetServiceDataWithMask(const UUID& service_data_uuid,
+                                        const std::vector<uint8_t>& data,
+                                        const std::vector<uint8_t>& mask) {
+  if (data.size() != mask.size())
+    return false;
+
+  service_data_uuid_.reset(new UUID(service_data_uuid));
+  service_data_ = data;
+  service_data_mask_ = mask;
+  return true;
+}
+
+void ScanFilter::SetManufacturerData(uint16_t manufacturer_id,
+                                     const std::vector<uint8_t>& data) {
+  SetManufacturerDataWithMask(manufacturer_id, data,
+                              std::vector<uint8_t>(data.size(), 0xFF));
+}
+
+bool ScanFilter::SetManufacturerDataWithMask(
+    uint16_t manufacturer_id,
+    const std::vector<uint8_t>& data,
+    const std::vector<uint8_t>& mask) {
+  if (data.size() != mask.size())
+    return false;
+
+  manufacturer_id_ = manufacturer_id;
+  manufacturer_data_ = data;
+  manufacturer_data_mask_ = mask;
+  return true;
+}
+
 bool ScanFilter::operator==(const ScanFilter& rhs) const {
   if (device_name_ != rhs.device_name_)
     return false;
@@ -92,6 +149,22 @@ bool ScanFilter::operator==(const ScanFilter& rhs) const {
       *service_uuid_mask_ != *rhs.service_uuid_mask_)
     return false;
 
+  if (!!service_data_uuid_ != !!rhs.service_data_uuid_)
+    return false;
+
+  if (service_data_uuid_ && rhs.service_data_uuid_ &&
+      *service_data_uuid_ != *rhs.service_data_uuid_)
+    return false;
+
+  if (service_data_ != rhs.service_data_ ||
+      service_data_mask_ != rhs.service_data_mask_)
+    return false;
+
+  if (manufacturer_id_ != rhs.manufacturer_id_ ||
+      manufacturer_data_ != rhs.manufacturer_data_ ||
+      manufacturer_data_mask_ != rhs.manufacturer_data_mask_)
+    return false;
+
   return true;
 }
 
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <bluetooth/uuid.h>
 
@@ -61,6 +62,51 @@ class ScanFilter {
   // advertised value, and 0 to ignore that bit.
   void SetServiceUuidWithMask(const UUID& service_uuid, const UUID& mask);
 
+  // The service data UUID, data and mask used while filtering scan results.
+  // A scan result matches if it contains a service data field for
+  // |service_data_uuid| whose payload starts with |service_data|, comparing
+  // only the bits that are set in |service_data_mask|. service_data_uuid()
+  // returns nullptr if service data filtering has not been set.
+  UUID* service_data_uuid() const { return service_data_uuid_.get(); }
+  const std::vector<uint8_t>& service_data() const { return service_data_; }
+  const std::vector<uint8_t>& service_data_mask() const {
+    return service_data_mask_;
+  }
+
+  // Sets the service data for this filter. All bits of |data| are matched.
+  void SetServiceData(const UUID& service_data_uuid,
+                      const std::vector<uint8_t>& data);
+
+  // Sets the service data for this filter with a mask. Returns false if
+  // |mask| and |data| have different lengths.
+  bool SetServiceDataWithMask(const UUID& service_data_uuid,
+                              const std::vector<uint8_t>& data,
+                              const std::vector<uint8_t>& mask);
+
+  // The manufacturer ID, data and mask used while filtering scan results. The
+  // semantics are the same as for the service data fields above, keyed by the
+  // Company Identifier of the manufacturer specific data field.
+  // manufacturer_id() returns -1 if manufacturer data filtering has not been
+  // set.
+  int manufacturer_id() const { return manufacturer_id_; }
+  const std::vector<uint8_t>& manufacturer_data() const {
+    return manufacturer_data_;
+  }
+  const std::vector<uint8_t>& manufacturer_data_mask() const {
+    return manufacturer_data_mask_;
+  }
+
+  // Sets the manufacturer data for this filter. All bits of |data| are
+  // matched.
+  void SetManufacturerData(uint16_t manufacturer_id,
+                           const std::vector<uint8_t>& data);
+
+  // Sets the manufacturer data for this filter with a mask. Returns false if
+  // |mask| and |data| have different lengths.
+  bool SetManufacturerDataWithMask(uint16_t manufacturer_id,
+                                   const std::vector<uint8_t>& data,
+                                   const std::vector<uint8_t>& mask);
+
   // Comparison operator.
   bool operator==(const ScanFilter& rhs) const;
 
@@ -71,7 +117,13 @@ class ScanFilter {
   std::unique_ptr<UUID> service_uuid_;
   std::unique_ptr<UUID> service_uuid_mask_;
 
-  // TODO(armansito): Add service and manufacturer data filter fields.
+  std::unique_ptr<UUID> service_data_uuid_;
+  std::vector<uint8_t> service_data_;
+  std::vector<uint8_t> service_data_mask_;
+
+  int manufacturer_id_ = -1;
+  std::vector<uint8_t> manufacturer_data_;
+  std::vector<uint8_t> manufacturer_data_mask_;
 };
 
 }  // namespace bluetooth
@@ -420,6 +420,14 @@ bool LowEnergyClient::StartScan(const ScanSettings& settings,
   }
 
   // TODO(jpawlowski): Push settings and filtering logic below the HAL.
+  // Until then the filters are applied in software to every scan result, so
+  // they also hold when the controller's filter (APCF) tables are full or
+  // the controller doesn't support offloaded filtering at all.
+  {
+    lock_guard<mutex> lock(scan_fields_lock_);
+    scan_filter_matcher_.Compile(filters);
+  }
+
   bt_status_t status = hal::BluetoothGattInterface::Get()->
       StartScan(client_id_);
   if (status != BT_STATUS_SUCCESS) {
@@ -573,9 +581,15 @@ void LowEnergyClient::ScanResultCallback(
   if (!delegate_)
     return;
 
-  // TODO(armansito): Apply software filters here.
-
   size_t record_len = GetScanRecordLength(adv_data);
+
+  // Drop results that don't match before anything gets allocated for them.
+  {
+    lock_guard<mutex> lock(scan_fields_lock_);
+    if (!scan_filter_matcher_.Matches(bda, adv_data, record_len))
+      return;
+  }
+
   std::vector<uint8_t> scan_record(adv_data, adv_data + record_len);
 
   ScanResult result(BtAddrString(&bda), scan_record, rssi);
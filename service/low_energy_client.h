@@ -32,6 +32,7 @@
 #include "service/common/bluetooth/scan_settings.h"
 #include "service/common/bluetooth/uuid.h"
 #include "service/hal/bluetooth_gatt_interface.h"
+#include "service/scan_filter_matcher.h"
 
 namespace bluetooth {
 
@@ -219,6 +220,10 @@ class LowEnergyClient : private hal::BluetoothGattInterface::ClientObserver,
   // Current scan settings.
   ScanSettings scan_settings_;
 
+  // The filters passed to StartScan, compiled for matching scan results in
+  // software. Results that don't match are dropped before they are copied.
+  ScanFilterMatcher scan_filter_matcher_;
+
   // If true, then this client have a BLE device scan in progress.
   std::atomic_bool scan_started_;
 
@@ -0,0 +1,424 @@
+//
+//  Copyright (C) 2016 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "service/scan_filter_matcher.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <base/logging.h>
+
+#include "service/common/bluetooth/util/address_helper.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/hcidefs.h"
+
+namespace bluetooth {
+
+namespace {
+
+// A 62 byte report (advertising data and scan response) holds at most 31
+// fields and at most 29 16-bit service UUIDs. Anything beyond that is ignored.
+const size_t kMaxAdvFields = 31;
+const size_t kMaxAdvUuids = 31;
+
+// Bluetooth SIG base UUID, big endian.
+const uint8_t kSigBaseUUID[UUID::kNumBytes128] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+  0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb
+};
+
+// Expands the little endian |len| byte UUID at |data| into its big endian
+// 128-bit form, the same layout UUID::GetFullBigEndian() returns.
+bool ExpandUUID(const uint8_t* data, size_t len, uint8_t* out) {
+  if (len != UUID::kNumBytes16 && len != UUID::kNumBytes32 &&
+      len != UUID::kNumBytes128)
+    return false;
+
+  memcpy(out, kSigBaseUUID, UUID::kNumBytes128);
+
+  // 16-bit UUIDs occupy bytes 2-3 of the base UUID, 32-bit ones bytes 0-3.
+  size_t offset = (len == UUID::kNumBytes16) ? 2 : 0;
+  for (size_t i = 0; i < len; ++i)
+    out[offset + i] = data[len - i - 1];
+
+  return true;
+}
+
+size_t UUIDLengthForType(uint8_t type) {
+  switch (type) {
+    case HCI_EIR_MORE_16BITS_UUID_TYPE:
+    case HCI_EIR_COMPLETE_16BITS_UUID_TYPE:
+    case HCI_EIR_SERVICE_DATA_16BITS_UUID_TYPE:
+      return UUID::kNumBytes16;
+    case HCI_EIR_MORE_32BITS_UUID_TYPE:
+    case HCI_EIR_COMPLETE_32BITS_UUID_TYPE:
+    case HCI_EIR_SERVICE_DATA_32BITS_UUID_TYPE:
+      return UUID::kNumBytes32;
+    case HCI_EIR_MORE_128BITS_UUID_TYPE:
+    case HCI_EIR_COMPLETE_128BITS_UUID_TYPE:
+    case HCI_EIR_SERVICE_DATA_128BITS_UUID_TYPE:
+      return UUID::kNumBytes128;
+    default:
+      return 0;
+  }
+}
+
+// Returns true if |data| starts with |prefix| for the bits set in |mask|.
+// |prefix| must already be masked.
+bool MaskedPrefixMatch(const std::vector<uint8_t>& prefix,
+                       const std::vector<uint8_t>& mask,
+                       const uint8_t* data, size_t len) {
+  if (prefix.size() > len)
+    return false;
+
+  for (size_t i = 0; i < prefix.size(); ++i) {
+    if ((data[i] & mask[i]) != prefix[i])
+      return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+struct ScanFilterMatcher::AdvFields {
+  const uint8_t* name = nullptr;
+  size_t name_len = 0;
+
+  UUID128 uuids[kMaxAdvUuids];
+  size_t num_uuids = 0;
+
+  struct Data {
+    UUID128 uuid;
+    uint16_t id;
+    const uint8_t* data;
+    size_t len;
+  };
+
+  Data service_data[kMaxAdvFields];
+  size_t num_service_data = 0;
+
+  Data manufacturer_data[kMaxAdvFields];
+  size_t num_manufacturer_data = 0;
+};
+
+size_t ScanFilterMatcher::UUID128Hash::operator()(const UUID128& key) const {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < UUID::kNumBytes128; ++i)
+    h = (h ^ key[i]) * 16777619u;
+  return h;
+}
+
+ScanFilterMatcher::ScanFilterMatcher()
+    : match_all_(true),
+      needs_adv_fields_(false) {
+}
+
+// static
+uint64_t ScanFilterMatcher::AddressKey(const bt_bdaddr_t& bda) {
+  uint64_t key = 0;
+  for (size_t i = 0; i < sizeof(bda.address); ++i)
+    key = (key << 8) | bda.address[i];
+  return key;
+}
+
+void ScanFilterMatcher::Clear() {
+  filters_.clear();
+  by_address_.clear();
+  by_uuid_.clear();
+  by_service_data_uuid_.clear();
+  by_manufacturer_id_.clear();
+  unindexed_.clear();
+  match_all_ = true;
+  needs_adv_fields_ = false;
+}
+
+void ScanFilterMatcher::Compile(const std::vector<ScanFilter>& filters) {
+  Clear();
+
+  // With no filters every report matches.
+  if (filters.empty())
+    return;
+
+  // From here on, if every filter gets dropped nothing matches rather than
+  // everything.
+  match_all_ = false;
+
+  for (const auto& filter : filters) {
+    CompiledFilter compiled;
+
+    if (!filter.device_address().empty()) {
+      bt_bdaddr_t bda;
+      if (!util::BdAddrFromString(filter.device_address(), &bda)) {
+        LOG(WARNING) << "Dropping scan filter with invalid address: "
+                     << filter.device_address();
+        continue;
+      }
+      compiled.has_address = true;
+      compiled.address = AddressKey(bda);
+    }
+
+    if (!filter.device_name().empty()) {
+      compiled.has_name = true;
+      compiled.name = filter.device_name();
+    }
+
+    if (filter.service_uuid()) {
+      compiled.has_uuid = true;
+      compiled.uuid = filter.service_uuid()->GetFullBigEndian();
+      if (filter.service_uuid_mask())
+        compiled.uuid_mask = filter.service_uuid_mask()->GetFullBigEndian();
+      else
+        compiled.uuid_mask.fill(0xFF);
+      for (size_t i = 0; i < compiled.uuid.size(); ++i)
+        compiled.uuid[i] &= compiled.uuid_mask[i];
+    }
+
+    if (filter.service_data_uuid()) {
+      compiled.has_service_data = true;
+      compiled.service_data_uuid =
+          filter.service_data_uuid()->GetFullBigEndian();
+      compiled.service_data_mask = filter.service_data_mask();
+      compiled.service_data = filter.service_data();
+      for (size_t i = 0; i < compiled.service_data.size(); ++i)
+        compiled.service_data[i] &= compiled.service_data_mask[i];
+    }
+
+    if (filter.manufacturer_id() >= 0) {
+      compiled.manufacturer_id = filter.manufacturer_id();
+      compiled.manufacturer_data_mask = filter.manufacturer_data_mask();
+      compiled.manufacturer_data = filter.manufacturer_data();
+      for (size_t i = 0; i < compiled.manufacturer_data.size(); ++i)
+        compiled.manufacturer_data[i] &= compiled.manufacturer_data_mask[i];
+    }
+
+    bool has_adv_field = compiled.has_name || compiled.has_uuid ||
+                         compiled.has_service_data ||
+                         compiled.manufacturer_id >= 0;
+    if (!compiled.has_address && !has_adv_field) {
+      // A filter without fields matches everything; nothing else matters.
+      Clear();
+      return;
+    }
+    needs_adv_fields_ |= has_adv_field;
+
+    uint16_t index = filters_.size();
+    bool uuid_is_exact = compiled.has_uuid &&
+        std::all_of(compiled.uuid_mask.begin(), compiled.uuid_mask.end(),
+                    [](uint8_t b) { return b == 0xFF; });
+
+    if (compiled.has_address)
+      by_address_[compiled.address].push_back(index);
+    else if (uuid_is_exact)
+      by_uuid_[compiled.uuid].push_back(index);
+    else if (compiled.has_service_data)
+      by_service_data_uuid_[compiled.service_data_uuid].push_back(index);
+    else if (compiled.manufacturer_id >= 0)
+      by_manufacturer_id_[compiled.manufacturer_id].push_back(index);
+    else
+      unindexed_.push_back(index);
+
+    filters_.push_back(std::move(compiled));
+  }
+
+  VLOG(2) << __func__ << ": " << filters_.size() << " of " << filters.size()
+          << " filters compiled, " << unindexed_.size() << " unindexed";
+}
+
+// static
+void ScanFilterMatcher::ParseAdvFields(const uint8_t* adv_data, size_t adv_len,
+                                       AdvFields* out_fields) {
+  size_t i = 0;
+  while (i < adv_len) {
+    size_t field_len = adv_data[i];
+
+    // A zero length field marks the end of the significant part; a field
+    // running past the end of the report is malformed and ends parsing too.
+    if (field_len == 0 || i + field_len >= adv_len)
+      break;
+
+    uint8_t type = adv_data[i + 1];
+    const uint8_t* value = adv_data + i + 2;
+    size_t value_len = field_len - 1;
+    i += field_len + 1;
+
+    switch (type) {
+      case HCI_EIR_SHORTENED_LOCAL_NAME_TYPE:
+      case HCI_EIR_COMPLETE_LOCAL_NAME_TYPE:
+        out_fields->name = value;
+        out_fields->name_len = value_len;
+        break;
+
+      case HCI_EIR_MORE_16BITS_UUID_TYPE:
+      case HCI_EIR_COMPLETE_16BITS_UUID_TYPE:
+      case HCI_EIR_MORE_32BITS_UUID_TYPE:
+      case HCI_EIR_COMPLETE_32BITS_UUID_TYPE:
+      case HCI_EIR_MORE_128BITS_UUID_TYPE:
+      case HCI_EIR_COMPLETE_128BITS_UUID_TYPE: {
+        size_t uuid_len = UUIDLengthForType(type);
+        for (size_t j = 0; j + uuid_len <= value_len &&
+             out_fields->num_uuids < kMaxAdvUuids; j += uuid_len) {
+          ExpandUUID(value + j, uuid_len,
+                     out_fields->uuids[out_fields->num_uuids++].data());
+        }
+        break;
+      }
+
+      case HCI_EIR_SERVICE_DATA_16BITS_UUID_TYPE:
+      case HCI_EIR_SERVICE_DATA_32BITS_UUID_TYPE:
+      case HCI_EIR_SERVICE_DATA_128BITS_UUID_TYPE: {
+        size_t uuid_len = UUIDLengthForType(type);
+        if (value_len < uuid_len ||
+            out_fields->num_service_data == kMaxAdvFields)
+          break;
+        AdvFields::Data* entry =
+            &out_fields->service_data[out_fields->num_service_data++];
+        ExpandUUID(value, uuid_len, entry->uuid.data());
+        entry->data = value + uuid_len;
+        entry->len = value_len - uuid_len;
+        break;
+      }
+
+      case HCI_EIR_MANUFACTURER_SPECIFIC_TYPE: {
+        if (value_len < 2 ||
+            out_fields->num_manufacturer_data == kMaxAdvFields)
+          break;
+        AdvFields::Data* entry =
+            &out_fields->manufacturer_data[out_fields->num_manufacturer_data++];
+        entry->id = value[0] | (value[1] << 8);
+        entry->data = value + 2;
+        entry->len = value_len - 2;
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+}
+
+bool ScanFilterMatcher::MatchesFilter(const CompiledFilter& filter,
+                                      uint64_t address,
+                                      const AdvFields& fields) const {
+  if (filter.has_address && filter.address != address)
+    return false;
+
+  if (filter.has_name &&
+      (fields.name_len != filter.name.size() ||
+       memcmp(fields.name, filter.name.data(), fields.name_len) != 0))
+    return false;
+
+  if (filter.has_uuid) {
+    bool found = false;
+    for (size_t i = 0; i < fields.num_uuids && !found; ++i) {
+      found = true;
+      for (size_t j = 0; j < UUID::kNumBytes128; ++j) {
+        if ((fields.uuids[i][j] & filter.uuid_mask[j]) != filter.uuid[j]) {
+          found = false;
+          break;
+        }
+      }
+    }
+    if (!found)
+      return false;
+  }
+
+  if (filter.has_service_data) {
+    bool found = false;
+    for (size_t i = 0; i < fields.num_service_data && !found; ++i) {
+      const AdvFields::Data& entry = fields.service_data[i];
+      found = entry.uuid == filter.service_data_uuid &&
+              MaskedPrefixMatch(filter.service_data, filter.service_data_mask,
+                                entry.data, entry.len);
+    }
+    if (!found)
+      return false;
+  }
+
+  if (filter.manufacturer_id >= 0) {
+    bool found = false;
+    for (size_t i = 0; i < fields.num_manufacturer_data && !found; ++i) {
+      const AdvFields::Data& entry = fields.manufacturer_data[i];
+      found = entry.id == filter.manufacturer_id &&
+              MaskedPrefixMatch(filter.manufacturer_data,
+                                filter.manufacturer_data_mask,
+                                entry.data, entry.len);
+    }
+    if (!found)
+      return false;
+  }
+
+  return true;
+}
+
+bool ScanFilterMatcher::MatchesAny(const FilterList& list, uint64_t address,
+                                   const AdvFields& fields) const {
+  for (uint16_t index : list) {
+    if (MatchesFilter(filters_[index], address, fields))
+      return true;
+  }
+  return false;
+}
+
+bool ScanFilterMatcher::Matches(const bt_bdaddr_t& bda,
+                                const uint8_t* adv_data,
+                                size_t adv_len) const {
+  if (match_all_)
+    return true;
+
+  uint64_t address = AddressKey(bda);
+  AdvFields fields;
+  if (needs_adv_fields_)
+    ParseAdvFields(adv_data, adv_len, &fields);
+
+  if (!by_address_.empty()) {
+    auto iter = by_address_.find(address);
+    if (iter != by_address_.end() && MatchesAny(iter->second, address, fields))
+      return true;
+  }
+
+  if (!by_uuid_.empty()) {
+    for (size_t i = 0; i < fields.num_uuids; ++i) {
+      auto iter = by_uuid_.find(fields.uuids[i]);
+      if (iter != by_uuid_.end() && MatchesAny(iter->second, address, fields))
+        return true;
+    }
+  }
+
+  if (!by_service_data_uuid_.empty()) {
+    for (size_t i = 0; i < fields.num_service_data; ++i) {
+      auto iter = by_service_data_uuid_.find(fields.service_data[i].uuid);
+      if (iter != by_service_data_uuid_.end() &&
+          MatchesAny(iter->second, address, fields))
+        return true;
+    }
+  }
+
+  if (!by_manufacturer_id_.empty()) {
+    for (size_t i = 0; i < fields.num_manufacturer_data; ++i) {
+      auto iter = by_manufacturer_id_.find(fields.manufacturer_data[i].id);
+      if (iter != by_manufacturer_id_.end() &&
+          MatchesAny(iter->second, address, fields))
+        return true;
+    }
+  }
+
+  return MatchesAny(unindexed_, address, fields);
+}
+
+}  // namespace bluetooth
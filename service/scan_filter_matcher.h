@@ -0,0 +1,122 @@
+//
+//  Copyright (C) 2016 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <base/macros.h>
+#include <hardware/bluetooth.h>
+
+#include "service/common/bluetooth/scan_filter.h"
+
+namespace bluetooth {
+
+// ScanFilterMatcher compiles a list of ScanFilter objects into a form that can
+// be evaluated against raw advertising reports without allocating memory.
+//
+// A report passes if it matches at least one filter, and it matches a filter if
+// it satisfies every field that is set on that filter. An empty filter list
+// matches every report. Each filter is indexed by the most selective field it
+// has (device address, then exact service UUID, then service data UUID, then
+// manufacturer ID) so a report is only checked against the filters that could
+// possibly match it; filters without any of these fields are checked linearly.
+//
+// ScanFilterMatcher is not thread-safe.
+class ScanFilterMatcher {
+ public:
+  ScanFilterMatcher();
+  ~ScanFilterMatcher() = default;
+
+  // Replaces the current filters with |filters|. Filters whose device address
+  // can't be parsed are dropped.
+  void Compile(const std::vector<ScanFilter>& filters);
+
+  // Removes all filters so that every report matches.
+  void Clear();
+
+  // Returns true if |adv_data|, the |adv_len| bytes of advertising data and
+  // scan response received from |bda|, matches the compiled filters.
+  bool Matches(const bt_bdaddr_t& bda, const uint8_t* adv_data,
+               size_t adv_len) const;
+
+  // Returns the number of compiled filters.
+  size_t size() const { return filters_.size(); }
+
+ private:
+  typedef std::array<uint8_t, UUID::kNumBytes128> UUID128;
+
+  struct UUID128Hash {
+    size_t operator()(const UUID128& key) const;
+  };
+
+  // The fields of an advertising report that filters look at. Values point
+  // into the report.
+  struct AdvFields;
+
+  struct CompiledFilter {
+    bool has_address = false;
+    uint64_t address = 0;
+
+    bool has_name = false;
+    std::string name;
+
+    bool has_uuid = false;
+    UUID128 uuid;
+    UUID128 uuid_mask;
+
+    bool has_service_data = false;
+    UUID128 service_data_uuid;
+    std::vector<uint8_t> service_data;  // Pre-masked.
+    std::vector<uint8_t> service_data_mask;
+
+    int manufacturer_id = -1;
+    std::vector<uint8_t> manufacturer_data;  // Pre-masked.
+    std::vector<uint8_t> manufacturer_data_mask;
+  };
+
+  typedef std::vector<uint16_t> FilterList;
+
+  static uint64_t AddressKey(const bt_bdaddr_t& bda);
+  static void ParseAdvFields(const uint8_t* adv_data, size_t adv_len,
+                             AdvFields* out_fields);
+  bool MatchesFilter(const CompiledFilter& filter, uint64_t address,
+                     const AdvFields& fields) const;
+  bool MatchesAny(const FilterList& list, uint64_t address,
+                  const AdvFields& fields) const;
+
+  std::vector<CompiledFilter> filters_;
+
+  // True if a filter with no fields is set, which matches every report.
+  bool match_all_;
+
+  // True if any filter looks at the advertising data, i.e. the report has to
+  // be parsed before matching.
+  bool needs_adv_fields_;
+
+  std::unordered_map<uint64_t, FilterList> by_address_;
+  std::unordered_map<UUID128, FilterList, UUID128Hash> by_uuid_;
+  std::unordered_map<UUID128, FilterList, UUID128Hash> by_service_data_uuid_;
+  std::unordered_map<uint16_t, FilterList> by_manufacturer_id_;
+  FilterList unindexed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanFilterMatcher);
+};
+
+}  // namespace bluetooth
@@ -959,6 +959,63 @@ TEST_F(LowEnergyClientPostRegisterTest, ScanRecord) {
   le_client_->SetDelegate(nullptr);
 }
 
+TEST_F(LowEnergyClientPostRegisterTest, ScanFilters) {
+  TestDelegate delegate;
+  le_client_->SetDelegate(&delegate);
+
+  const uint8_t kTestRecord[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0x0D, 0x18,
+                                  0x00 };
+  const bt_bdaddr_t kTestAddress0 = {
+    { 0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0C }
+  };
+  const bt_bdaddr_t kTestAddress1 = {
+    { 0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0D }
+  };
+  const int kTestRssi = 64;
+
+  EXPECT_CALL(mock_adapter_, IsEnabled())
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock_handler_, Scan(_))
+      .WillRepeatedly(Return(BT_STATUS_SUCCESS));
+
+  ScanSettings settings;
+  std::vector<ScanFilter> filters(1);
+  ASSERT_TRUE(filters[0].SetDeviceAddress("01:02:03:0A:0B:0C"));
+  ASSERT_TRUE(le_client_->StartScan(settings, filters));
+
+  // Only results from the filtered address get through.
+  fake_hal_gatt_iface_->NotifyScanResultCallback(
+      kTestAddress1, kTestRssi, (uint8_t*) kTestRecord);
+  EXPECT_EQ(0, delegate.scan_result_count());
+  fake_hal_gatt_iface_->NotifyScanResultCallback(
+      kTestAddress0, kTestRssi, (uint8_t*) kTestRecord);
+  EXPECT_EQ(1, delegate.scan_result_count());
+
+  // Filter on a service UUID that isn't advertised.
+  filters[0] = ScanFilter();
+  filters[0].SetServiceUuid(UUID("180F"));
+  ASSERT_TRUE(le_client_->StartScan(settings, filters));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(
+      kTestAddress0, kTestRssi, (uint8_t*) kTestRecord);
+  EXPECT_EQ(1, delegate.scan_result_count());
+
+  // The advertised one.
+  filters[0].SetServiceUuid(UUID("180D"));
+  ASSERT_TRUE(le_client_->StartScan(settings, filters));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(
+      kTestAddress1, kTestRssi, (uint8_t*) kTestRecord);
+  EXPECT_EQ(2, delegate.scan_result_count());
+
+  // No filters, everything gets through.
+  ASSERT_TRUE(le_client_->StartScan(settings, std::vector<ScanFilter>()));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(
+      kTestAddress1, kTestRssi, (uint8_t*) kTestRecord);
+  EXPECT_EQ(3, delegate.scan_result_count());
+
+  ASSERT_TRUE(le_client_->StopScan());
+  le_client_->SetDelegate(nullptr);
+}
+
 MATCHER_P(BitEq, x, std::string(negation ? "isn't" : "is") +
                         " bitwise equal to " + ::testing::PrintToString(x)) {
   static_assert(sizeof(x) == sizeof(arg), "Size mismatch");
@@ -0,0 +1,203 @@
+//
+//  Copyright (C) 2016 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <gtest/gtest.h>
+
+#include "service/common/bluetooth/scan_filter.h"
+#include "service/scan_filter_matcher.h"
+
+namespace bluetooth {
+namespace {
+
+const bt_bdaddr_t kTestAddress0 = { { 0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0C } };
+const bt_bdaddr_t kTestAddress1 = { { 0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0D } };
+const char kTestAddress0Str[] = "01:02:03:0A:0B:0C";
+
+// Flags, complete list of 16-bit UUIDs (0x180D, 0x180F), complete local name
+// "hrm", service data for 0x180D (0x01 0x02 0x03) and manufacturer data for
+// company 0x00E0 (0xAA 0xBB).
+const uint8_t kTestRecord[] = {
+  0x02, 0x01, 0x06,
+  0x05, 0x03, 0x0D, 0x18, 0x0F, 0x18,
+  0x04, 0x09, 'h', 'r', 'm',
+  0x06, 0x16, 0x0D, 0x18, 0x01, 0x02, 0x03,
+  0x05, 0xFF, 0xE0, 0x00, 0xAA, 0xBB
+};
+
+UUID UUID16(uint8_t msb, uint8_t lsb) {
+  return UUID(UUID::UUID16Bit({{ msb, lsb }}));
+}
+
+class ScanFilterMatcherTest : public ::testing::Test {
+ public:
+  ScanFilterMatcherTest() = default;
+  ~ScanFilterMatcherTest() override = default;
+
+ protected:
+  bool Matches(const ScanFilter& filter,
+               const bt_bdaddr_t& bda = kTestAddress0) {
+    matcher_.Compile(std::vector<ScanFilter>({ filter }));
+    return matcher_.Matches(bda, kTestRecord, sizeof(kTestRecord));
+  }
+
+  ScanFilterMatcher matcher_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ScanFilterMatcherTest);
+};
+
+TEST_F(ScanFilterMatcherTest, EmptyFilters) {
+  EXPECT_TRUE(matcher_.Matches(kTestAddress0, kTestRecord,
+                               sizeof(kTestRecord)));
+
+  matcher_.Compile(std::vector<ScanFilter>());
+  EXPECT_EQ(0U, matcher_.size());
+  EXPECT_TRUE(matcher_.Matches(kTestAddress0, kTestRecord,
+                               sizeof(kTestRecord)));
+  EXPECT_TRUE(matcher_.Matches(kTestAddress0, nullptr, 0));
+
+  // A filter without fields also lets everything through.
+  EXPECT_TRUE(Matches(ScanFilter()));
+}
+
+TEST_F(ScanFilterMatcherTest, Address) {
+  ScanFilter filter;
+  ASSERT_TRUE(filter.SetDeviceAddress(kTestAddress0Str));
+
+  EXPECT_TRUE(Matches(filter, kTestAddress0));
+  EXPECT_FALSE(Matches(filter, kTestAddress1));
+  EXPECT_TRUE(matcher_.Matches(kTestAddress0, nullptr, 0));
+}
+
+TEST_F(ScanFilterMatcherTest, Name) {
+  ScanFilter filter;
+  filter.set_device_name("hrm");
+  EXPECT_TRUE(Matches(filter));
+
+  filter.set_device_name("hr");
+  EXPECT_FALSE(Matches(filter));
+
+  filter.set_device_name("hrm2");
+  EXPECT_FALSE(Matches(filter));
+}
+
+TEST_F(ScanFilterMatcherTest, ServiceUuid) {
+  ScanFilter filter;
+  filter.SetServiceUuid(UUID16(0x18, 0x0F));
+  EXPECT_TRUE(Matches(filter));
+
+  filter.SetServiceUuid(UUID16(0x18, 0x0A));
+  EXPECT_FALSE(Matches(filter));
+
+  // Only look at the upper byte of the 16-bit UUID.
+  UUID::UUID128Bit mask;
+  mask.fill(0xFF);
+  mask[3] = 0x00;
+  filter.SetServiceUuidWithMask(UUID16(0x18, 0x0A), UUID(mask));
+  EXPECT_TRUE(Matches(filter));
+
+  filter.SetServiceUuidWithMask(UUID16(0x19, 0x0A), UUID(mask));
+  EXPECT_FALSE(Matches(filter));
+}
+
+TEST_F(ScanFilterMatcherTest, ServiceData) {
+  ScanFilter filter;
+  filter.SetServiceData(UUID16(0x18, 0x0D), { 0x01, 0x02 });
+  EXPECT_TRUE(Matches(filter));
+
+  filter.SetServiceData(UUID16(0x18, 0x0D), { 0x01, 0x02, 0x03 });
+  EXPECT_TRUE(Matches(filter));
+
+  // Longer than the advertised data.
+  filter.SetServiceData(UUID16(0x18, 0x0D), { 0x01, 0x02, 0x03, 0x04 });
+  EXPECT_FALSE(Matches(filter));
+
+  filter.SetServiceData(UUID16(0x18, 0x0D), { 0x01, 0x03 });
+  EXPECT_FALSE(Matches(filter));
+
+  // Right data, wrong UUID.
+  filter.SetServiceData(UUID16(0x18, 0x0F), { 0x01, 0x02 });
+  EXPECT_FALSE(Matches(filter));
+
+  EXPECT_TRUE(filter.SetServiceDataWithMask(UUID16(0x18, 0x0D),
+                                            { 0x01, 0x0F }, { 0xFF, 0xF0 }));
+  EXPECT_TRUE(Matches(filter));
+
+  EXPECT_FALSE(filter.SetServiceDataWithMask(UUID16(0x18, 0x0D),
+                                             { 0x01, 0x0F }, { 0xFF }));
+}
+
+TEST_F(ScanFilterMatcherTest, ManufacturerData) {
+  ScanFilter filter;
+  filter.SetManufacturerData(0x00E0, {});
+  EXPECT_TRUE(Matches(filter));
+
+  filter.SetManufacturerData(0x00E0, { 0xAA });
+  EXPECT_TRUE(Matches(filter));
+
+  filter.SetManufacturerData(0x00E1, { 0xAA });
+  EXPECT_FALSE(Matches(filter));
+
+  filter.SetManufacturerData(0x00E0, { 0xAB });
+  EXPECT_FALSE(Matches(filter));
+
+  EXPECT_TRUE(filter.SetManufacturerDataWithMask(0x00E0, { 0xAB, 0xBB },
+                                                 { 0xF0, 0xFF }));
+  EXPECT_TRUE(Matches(filter));
+}
+
+TEST_F(ScanFilterMatcherTest, AllFieldsMustMatch) {
+  ScanFilter filter;
+  ASSERT_TRUE(filter.SetDeviceAddress(kTestAddress0Str));
+  filter.SetServiceUuid(UUID16(0x18, 0x0D));
+  filter.set_device_name("hrm");
+  EXPECT_TRUE(Matches(filter));
+  EXPECT_FALSE(Matches(filter, kTestAddress1));
+
+  filter.set_device_name("other");
+  EXPECT_FALSE(Matches(filter));
+}
+
+TEST_F(ScanFilterMatcherTest, AnyFilterMatches) {
+  std::vector<ScanFilter> filters(4);
+  ASSERT_TRUE(filters[0].SetDeviceAddress("00:00:00:00:00:01"));
+  filters[1].SetServiceUuid(UUID16(0x18, 0x0A));
+  filters[2].set_device_name("other");
+  filters[3].SetManufacturerData(0x00E0, { 0xAA });
+
+  matcher_.Compile(filters);
+  EXPECT_EQ(4U, matcher_.size());
+  EXPECT_TRUE(matcher_.Matches(kTestAddress0, kTestRecord,
+                               sizeof(kTestRecord)));
+
+  filters.pop_back();
+  matcher_.Compile(filters);
+  EXPECT_FALSE(matcher_.Matches(kTestAddress0, kTestRecord,
+                                sizeof(kTestRecord)));
+}
+
+TEST_F(ScanFilterMatcherTest, MalformedRecord) {
+  ScanFilter filter;
+  filter.set_device_name("hrm");
+
+  // The name field claims more bytes than the record has.
+  const uint8_t kRecord[] = { 0x02, 0x01, 0x06, 0x09, 0x09, 'h', 'r', 'm' };
+  matcher_.Compile(std::vector<ScanFilter>({ filter }));
+  EXPECT_FALSE(matcher_.Matches(kTestAddress0, kRecord, sizeof(kRecord)));
+}
+
+}  // namespace
+}  // namespace bluetooth
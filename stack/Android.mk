@@ -80,6 +80,7 @@ LOCAL_SRC_FILES:= \
     ./btm/btm_sco.c \
     ./btm/btm_pm.c \
     ./btm/btm_devctl.c \
+    ./btm/btm_hci_txn.c \
     ./rfcomm/rfc_utils.c \
     ./rfcomm/port_rfc.c \
     ./rfcomm/rfc_l2cap_if.c \
@@ -118,7 +119,9 @@ LOCAL_SRC_FILES:= \
     ./smp/smp_keys.c \
     ./smp/smp_api.c \
     ./smp/aes.c \
+    ./smp/smp_aes.c \
     ./smp/smp_br_main.c\
+    ./smp/p_256_ecc_ct.c \
     ./smp/p_256_curvepara.c \
     ./smp/p_256_ecc_pp.c \
     ./smp/p_256_multprecision.c \
@@ -136,6 +139,7 @@ LOCAL_SRC_FILES:= \
     ./sdp/sdp_utils.c \
     ./sdp/sdp_api.c \
     ./sdp/sdp_discovery.c \
+    ./sdp/sdp_peer_ver.c \
     ./pan/pan_main.c \
     ./srvc/srvc_battery.c \
     ./srvc/srvc_dis.c \
@@ -169,3 +173,52 @@ LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
 LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
 
 include $(BUILD_STATIC_LIBRARY)
+
+# Bluetooth stack unit tests for target
+# ========================================================
+ifeq (,$(strip $(SANITIZE_TARGET)))
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+                   $(LOCAL_PATH)/include \
+                   $(LOCAL_PATH)/btm \
+                   $(LOCAL_PATH)/l2cap \
+                   $(LOCAL_PATH)/gatt \
+                   $(LOCAL_PATH)/sdp \
+                   $(LOCAL_PATH)/../btcore/include \
+                   $(LOCAL_PATH)/../btif/include \
+                   $(LOCAL_PATH)/../hci/include \
+                   $(LOCAL_PATH)/../include \
+                   $(LOCAL_PATH)/../udrv/include \
+                   $(LOCAL_PATH)/../bta/include \
+                   $(LOCAL_PATH)/../bta/sys \
+                   $(LOCAL_PATH)/../utils/include \
+                   $(LOCAL_PATH)/../osi/test \
+                   $(LOCAL_PATH)/../ \
+                   $(bluetooth_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ../osi/test/AllocationTestHarness.cpp \
+    ../osi/test/AlarmTestHarness.cpp \
+    ./btm/btm_hci_txn.c \
+    ./gatt/att_protocol.c \
+    ./gatt/gatt_cl.c \
+    ./sdp/sdp_peer_ver.c \
+    ./test/stack_test_stubs.cpp \
+    ./test/att_protocol_test.cpp \
+    ./test/btm_hci_txn_test.cpp \
+    ./test/gatt_cl_test.cpp \
+    ./test/sdp_peer_ver_test.cpp
+
+LOCAL_MODULE := net_test_stack
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog libcutils
+LOCAL_STATIC_LIBRARIES := libosi
+
+LOCAL_CFLAGS += $(bluetooth_CFLAGS)
+LOCAL_CFLAGS += -DAVRC_PEER_VERSION_CONF_FILE=\"/data/local/tmp/net_test_stack_avrc_peer_entries.conf\"
+LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
+LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
+
+include $(BUILD_NATIVE_TEST)
+endif # SANITIZE_TARGET
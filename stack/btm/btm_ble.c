@@ -106,6 +106,7 @@ BOOLEAN BTM_SecAddBleDevice (const BD_ADDR bd_addr, BD_NAME bd_name, tBT_DEVICE_
     p_dev_rec->ble.ble_addr_type = addr_type;
 
     memcpy(p_dev_rec->ble.pseudo_addr, bd_addr, BD_ADDR_LEN);
+    btm_sec_dev_rec_reindex(p_dev_rec);
     /* sync up with the Inq Data base*/
     tBTM_INQ_INFO      *p_info = BTM_InqDbRead(bd_addr);
     if (p_info)
@@ -1390,9 +1391,13 @@ void btm_sec_save_le_key(BD_ADDR bd_addr, tBTM_LE_KEY_TYPE key_type, tBTM_LE_KEY
                 memcpy(p_rec->ble.static_addr, p_keys->pid_key.static_addr, BD_ADDR_LEN);
                 p_rec->ble.static_addr_type = p_keys->pid_key.addr_type;
                 p_rec->ble.key_type |= BTM_LE_KEY_PID;
+#if (BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE)
+                btm_ble_rpa_cache_flush();
+#endif
                 BTM_TRACE_DEBUG("BTM_LE_KEY_PID key_type=0x%x save peer IRK",  p_rec->ble.key_type);
                  /* update device record address as static address */
                 memcpy(p_rec->bd_addr, p_keys->pid_key.static_addr, BD_ADDR_LEN);
+                btm_sec_dev_rec_reindex(p_rec);
                 /* combine DUMO device security record if needed */
                 btm_consolidate_dev(p_rec);
                 break;
@@ -2067,7 +2072,7 @@ void btm_ble_connected (UINT8 *bda, UINT16 handle, UINT8 enc_mode, UINT8 role,
     }
     else    /* Update the timestamp for this device */
     {
-        p_dev_rec->timestamp = btm_cb.dev_rec_count++;
+        btm_sec_dev_rec_touch(p_dev_rec);
     }
 
     /* update device information */
@@ -2076,6 +2081,7 @@ void btm_ble_connected (UINT8 *bda, UINT16 handle, UINT8 enc_mode, UINT8 role,
     p_dev_rec->ble.ble_addr_type = addr_type;
     /* update pseudo address */
     memcpy(p_dev_rec->ble.pseudo_addr, bda, BD_ADDR_LEN);
+    btm_sec_dev_rec_reindex(p_dev_rec);
 
     p_dev_rec->role_master = FALSE;
     if (role == HCI_ROLE_MASTER)
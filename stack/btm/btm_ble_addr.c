@@ -30,6 +30,7 @@
 #include "btm_int.h"
 #include "gap_api.h"
 #include "device/include/controller.h"
+#include "osi/include/time.h"
 
 #if (defined BLE_INCLUDED && BLE_INCLUDED == TRUE)
 #include "btm_ble_int.h"
@@ -205,38 +206,6 @@ void btm_gen_non_resolvable_private_addr (tBTM_BLE_ADDR_CBACK *p_cback, void *p)
 /*******************************************************************************
 **  Utility functions for Random address resolving
 *******************************************************************************/
-/*******************************************************************************
-**
-** Function         btm_ble_proc_resolve_x
-**
-** Description      This function compares the X with random address 3 MSO bytes
-**                  to find a match.
-**
-** Returns          TRUE on match, FALSE otherwise
-**
-*******************************************************************************/
-static BOOLEAN btm_ble_proc_resolve_x(tSMP_ENC *p)
-{
-    tBTM_LE_RANDOM_CB   *p_mgnt_cb = &btm_cb.ble_ctr_cb.addr_mgnt_cb;
-    UINT8    comp[3];
-    BTM_TRACE_EVENT ("btm_ble_proc_resolve_x");
-    /* compare the hash with 3 LSB of bd address */
-    comp[0] = p_mgnt_cb->random_bda[5];
-    comp[1] = p_mgnt_cb->random_bda[4];
-    comp[2] = p_mgnt_cb->random_bda[3];
-
-    if (p)
-    {
-        if (!memcmp(p->param_buf, &comp[0], 3))
-        {
-            /* match is found */
-            BTM_TRACE_EVENT ("match is found");
-            return TRUE;
-        }
-    }
-    return FALSE;
-}
-
 /*******************************************************************************
 **
 ** Function         btm_ble_init_pseudo_addr
@@ -254,6 +223,7 @@ BOOLEAN btm_ble_init_pseudo_addr (tBTM_SEC_DEV_REC *p_dev_rec, BD_ADDR new_pseud
     if (memcmp(p_dev_rec->ble.pseudo_addr, dummy_bda, BD_ADDR_LEN) == 0)
     {
         memcpy(p_dev_rec->ble.pseudo_addr, new_pseudo_addr, BD_ADDR_LEN);
+        btm_sec_dev_rec_reindex(p_dev_rec);
         return TRUE;
     }
 
@@ -306,44 +276,214 @@ BOOLEAN btm_ble_addr_resolvable (BD_ADDR rpa, tBTM_SEC_DEV_REC *p_dev_rec)
 
 /*******************************************************************************
 **
-** Function         btm_ble_match_random_bda
+** Function         btm_ble_rpa_cache_build_irk
 **
-** Description      This function match the random address to the appointed device
-**                  record, starting from calculating IRK. If record index exceed
-**                  the maximum record number, matching failed and send callback.
+** Description      Expand the IRK of every security record holding a peer
+**                  identity key, so that resolving an address costs a single
+**                  AES block per candidate.
 **
-** Returns          None.
+** Returns          void
 **
 *******************************************************************************/
-static BOOLEAN btm_ble_match_random_bda(void *data, void *context)
+static void btm_ble_rpa_cache_build_irk(tBTM_BLE_RPA_CACHE *p_cache)
 {
-#if (BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE)
-    /* use the 3 MSB of bd address as prand */
+    p_cache->num_irk = 0;
 
-    tBTM_LE_RANDOM_CB *p_mgnt_cb = &btm_cb.ble_ctr_cb.addr_mgnt_cb;
-    UINT8 rand[3];
-    rand[0] = p_mgnt_cb->random_bda[2];
-    rand[1] = p_mgnt_cb->random_bda[1];
-    rand[2] = p_mgnt_cb->random_bda[0];
+    list_node_t *end = list_end(btm_cb.sec_dev_rec);
+    for (list_node_t *node = list_begin(btm_cb.sec_dev_rec); node != end; node = list_next(node)) {
+        tBTM_SEC_DEV_REC *p_dev_rec = list_node(node);
 
-    BTM_TRACE_EVENT("%s next iteration", __func__);
+        if (!(p_dev_rec->ble.key_type & BTM_LE_KEY_PID))
+            continue;
 
-    tSMP_ENC output;
-    tBTM_SEC_DEV_REC *p_dev_rec = data;
+        if (p_cache->num_irk >= BTM_BLE_RPA_MAX_IRK)
+        {
+            BTM_TRACE_WARNING("%s too many IRKs, ignoring the rest", __func__);
+            break;
+        }
 
-    BTM_TRACE_DEBUG("sec_flags = %02x device_type = %d", p_dev_rec->sec_flags,
-                    p_dev_rec->device_type);
+        p_cache->irk_rec[p_cache->num_irk] = p_dev_rec;
+        p_cache->irk_sched[p_cache->num_irk] = SMP_KeySchedNew(p_dev_rec->ble.keys.irk);
+        p_cache->num_irk++;
+    }
 
-    if (!(p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) ||
-        !(p_dev_rec->ble.key_type & BTM_LE_KEY_PID))
-        return TRUE;
+    p_cache->irk_valid = TRUE;
+    BTM_TRACE_DEBUG("%s %d IRKs", __func__, p_cache->num_irk);
+}
 
-    /* generate X = E irk(R0, R1, R2) and R is random address 3 LSO */
-    SMP_Encrypt(p_dev_rec->ble.keys.irk, BT_OCTET16_LEN,
-                &rand[0], 3, &output);
-    // if it was match, finish iteration, otherwise continue
-    return !btm_ble_proc_resolve_x(&output);
-#endif
+/*******************************************************************************
+**
+** Function         btm_ble_rpa_cache_flush
+**
+** Description      Forget all cached address resolutions and expanded IRKs.
+**                  Called whenever a security record is removed or its
+**                  identity key changes.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_ble_rpa_cache_flush(void)
+{
+    tBTM_BLE_RPA_CACHE *p_cache = &btm_cb.ble_ctr_cb.rpa_cache;
+
+    if (p_cache->irk_valid)
+    {
+        BTM_TRACE_DEBUG("%s hit %u neg_hit %u miss %u aes %u", __func__,
+                        p_cache->hit, p_cache->neg_hit, p_cache->miss,
+                        p_cache->aes_ops);
+    }
+
+    for (UINT16 xx = 0; xx < p_cache->num_irk; xx++)
+    {
+        SMP_KeySchedFree(p_cache->irk_sched[xx]);
+        p_cache->irk_sched[xx] = NULL;
+        p_cache->irk_rec[xx] = NULL;
+    }
+    p_cache->num_irk = 0;
+    p_cache->irk_valid = FALSE;
+
+    memset(p_cache->entry, 0, sizeof(p_cache->entry));
+    p_cache->next_entry = 0;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_rpa_cache_find
+**
+** Description      Look up an unexpired cache entry for a private address.
+**
+** Returns          pointer to the entry or NULL
+**
+*******************************************************************************/
+static tBTM_BLE_RPA_CACHE_ENTRY *btm_ble_rpa_cache_find(tBTM_BLE_RPA_CACHE *p_cache,
+                                                        const BD_ADDR rpa, UINT32 now)
+{
+    tBTM_BLE_RPA_CACHE_ENTRY *p_entry = &p_cache->entry[0];
+
+    for (UINT16 xx = 0; xx < BTM_BLE_RPA_CACHE_SIZE; xx++, p_entry++)
+    {
+        if (!p_entry->in_use || memcmp(p_entry->rpa, rpa, BD_ADDR_LEN))
+            continue;
+
+        if ((INT32)(p_entry->expire_ms - now) <= 0)
+        {
+            p_entry->in_use = FALSE;
+            return NULL;
+        }
+        return p_entry;
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_rpa_cache_store
+**
+** Description      Remember the outcome of resolving a private address.
+**                  p_dev_rec is NULL when no bonded IRK resolves it.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_ble_rpa_cache_store(tBTM_BLE_RPA_CACHE *p_cache, const BD_ADDR rpa,
+                                    tBTM_SEC_DEV_REC *p_dev_rec, UINT32 now)
+{
+    tBTM_BLE_RPA_CACHE_ENTRY *p_entry = NULL;
+
+    for (UINT16 xx = 0; xx < BTM_BLE_RPA_CACHE_SIZE; xx++)
+    {
+        if (!p_cache->entry[xx].in_use)
+        {
+            p_entry = &p_cache->entry[xx];
+            break;
+        }
+    }
+
+    if (p_entry == NULL)
+    {
+        p_entry = &p_cache->entry[p_cache->next_entry];
+        p_cache->next_entry = (p_cache->next_entry + 1) % BTM_BLE_RPA_CACHE_SIZE;
+    }
+
+    memcpy(p_entry->rpa, rpa, BD_ADDR_LEN);
+    p_entry->p_dev_rec = p_dev_rec;
+    p_entry->expire_ms = now + BTM_BLE_RPA_CACHE_TTL_MS;
+    p_entry->in_use = TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_rpa_cache_resolve
+**
+** Description      Find the bonded LE device whose IRK generates a resolvable
+**                  private address. Results, including failures, are cached
+**                  for the address refresh interval.
+**
+** Returns          pointer to the security record, or NULL if not resolved.
+**
+*******************************************************************************/
+tBTM_SEC_DEV_REC *btm_ble_rpa_cache_resolve(const BD_ADDR rpa)
+{
+    tBTM_BLE_RPA_CACHE *p_cache = &btm_cb.ble_ctr_cb.rpa_cache;
+    tBTM_SEC_DEV_REC *p_match = NULL;
+    BOOLEAN skipped = FALSE;
+    UINT32 now;
+    UINT16 idx;
+
+    if (!BTM_BLE_IS_RESOLVE_BDA(rpa))
+        return NULL;
+
+    now = time_get_os_boottime_ms();
+
+    tBTM_BLE_RPA_CACHE_ENTRY *p_entry = btm_ble_rpa_cache_find(p_cache, rpa, now);
+    if (p_entry != NULL)
+    {
+        p_match = p_entry->p_dev_rec;
+        if (p_match == NULL)
+        {
+            p_cache->neg_hit++;
+            return NULL;
+        }
+
+        if (p_match->device_type & BT_DEVICE_TYPE_BLE)
+        {
+            p_cache->hit++;
+            return p_match;
+        }
+        p_entry->in_use = FALSE;
+        p_match = NULL;
+    }
+
+    p_cache->miss++;
+
+    if (!p_cache->irk_valid)
+        btm_ble_rpa_cache_build_irk(p_cache);
+
+    BTM_TRACE_DEBUG("%s try to resolve against %d IRKs", __func__, p_cache->num_irk);
+
+    idx = 0;
+    while ((idx = SMP_ResolveRpaBatch(rpa, p_cache->irk_sched, p_cache->num_irk, idx))
+           < p_cache->num_irk)
+    {
+        tBTM_SEC_DEV_REC *p_dev_rec = p_cache->irk_rec[idx];
+        if (p_dev_rec->device_type & BT_DEVICE_TYPE_BLE)
+        {
+            p_match = p_dev_rec;
+            break;
+        }
+
+        /* identity key known but not (yet) flagged as an LE device */
+        skipped = TRUE;
+        idx++;
+    }
+    p_cache->aes_ops += (p_match != NULL) ? idx + 1 : p_cache->num_irk;
+
+    /* a skipped record may become an LE device later, so only remember the
+     * failure if every candidate was really tried */
+    if (p_match != NULL || !skipped)
+        btm_ble_rpa_cache_store(p_cache, rpa, p_match, now);
+
+    return p_match;
 }
 
 /*******************************************************************************
@@ -367,10 +507,7 @@ void btm_ble_resolve_random_addr(BD_ADDR random_bda, tBTM_BLE_RESOLVE_CBACK * p_
         memcpy(p_mgnt_cb->random_bda, random_bda, BD_ADDR_LEN);
         p_mgnt_cb->extended = extended;
         /* start to resolve random address */
-        /* check for next security record */
-
-        list_node_t * n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda, NULL);
-        tBTM_SEC_DEV_REC *p_dev_rec = n ? list_node(n) : NULL;
+        tBTM_SEC_DEV_REC *p_dev_rec = btm_ble_rpa_cache_resolve(random_bda);
 
         BTM_TRACE_EVENT("%s:  %sresolved", __func__, (p_dev_rec == NULL ? "not " : ""));
         p_mgnt_cb->busy = FALSE;
@@ -395,18 +532,15 @@ void btm_ble_resolve_random_addr(BD_ADDR random_bda, tBTM_BLE_RESOLVE_CBACK * p_
 tBTM_SEC_DEV_REC* btm_find_dev_by_identity_addr(BD_ADDR bd_addr, UINT8 addr_type)
 {
 #if BLE_PRIVACY_SPT == TRUE
-    list_node_t *end = list_end(btm_cb.sec_dev_rec);
-    for (list_node_t *node = list_begin(btm_cb.sec_dev_rec); node != end; node = list_next(node)) {
-        tBTM_SEC_DEV_REC *p_dev_rec = list_node(node);
-        if (memcmp(p_dev_rec->ble.static_addr, bd_addr, BD_ADDR_LEN) == 0) {
-            if ((p_dev_rec->ble.static_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
-                (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
-                BTM_TRACE_WARNING("%s find pseudo->random match with diff addr type: %d vs %d",
-                    __func__, p_dev_rec->ble.static_addr_type, addr_type);
-
-            /* found the match */
-            return p_dev_rec;
-        }
+    tBTM_SEC_DEV_REC *p_dev_rec = btm_find_dev_by_static_addr(bd_addr);
+    if (p_dev_rec != NULL) {
+        if ((p_dev_rec->ble.static_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
+            (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
+            BTM_TRACE_WARNING("%s find pseudo->random match with diff addr type: %d vs %d",
+                __func__, p_dev_rec->ble.static_addr_type, addr_type);
+
+        /* found the match */
+        return p_dev_rec;
     }
 #endif
 
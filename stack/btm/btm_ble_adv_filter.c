@@ -55,6 +55,8 @@ static const BD_ADDR     na_bda= {0};
 
 static UINT8 btm_ble_cs_update_pf_counter(tBTM_BLE_SCAN_COND_OP action,
                                   UINT8 cond_type, tBLE_BD_ADDR *p_bd_addr, UINT8 num_available);
+void btm_ble_scan_pf_cmpl_cback(tBTM_VSC_CMPL *p_params, UINT8 cb_evt, UINT32 ref_value,
+                                void *p_cback);
 
 #define BTM_BLE_SET_SCAN_PF_OPCODE(x, y) (((x)<<4)|y)
 #define BTM_BLE_GET_SCAN_PF_SUBCODE(x)    ((x) >> 4)
@@ -68,8 +70,6 @@ static UINT8 btm_ble_cs_update_pf_counter(tBTM_BLE_SCAN_COND_OP action,
 #define BTM_BLE_ADV_FILTER_CLEAR_LEN            3
 #define BTM_BLE_ADV_FILTER_LEN     2
 
-#define BTM_BLE_ADV_FILT_CB_EVT_MASK       0xF0
-#define BTM_BLE_ADV_FILT_SUBCODE_MASK      0x0F
 
 /*******************************************************************************
 **
@@ -101,58 +101,25 @@ tBTM_STATUS btm_ble_obtain_vsc_details()
 
 /*******************************************************************************
 **
-** Function         btm_ble_advfilt_enq_op_q
+** Function         btm_ble_advfilt_send
 **
-** Description      enqueue an adv filter operation in q to check command complete
-**                  status
+** Description      send an adv filter command. param[0] and param[1] carry the
+**                  sub-opcode and action the completion is checked against.
 **
-** Returns          void
-**
-*******************************************************************************/
-void btm_ble_advfilt_enq_op_q(UINT8 action, UINT8 ocf, tBTM_BLE_FILT_CB_EVT cb_evt,
-                              tBTM_BLE_REF_VALUE ref, tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback,
-                              tBTM_BLE_PF_PARAM_CBACK  *p_filt_param_cback)
-{
-    btm_ble_adv_filt_cb.op_q.action_ocf[btm_ble_adv_filt_cb.op_q.next_idx] = (action |(ocf << 4));
-    btm_ble_adv_filt_cb.op_q.ref_value[btm_ble_adv_filt_cb.op_q.next_idx] = ref;
-    btm_ble_adv_filt_cb.op_q.cb_evt[btm_ble_adv_filt_cb.op_q.next_idx] = cb_evt;
-    btm_ble_adv_filt_cb.op_q.p_scan_cfg_cback[btm_ble_adv_filt_cb.op_q.next_idx] = p_cmpl_cback;
-    btm_ble_adv_filt_cb.op_q.p_filt_param_cback[btm_ble_adv_filt_cb.op_q.next_idx]
-        = p_filt_param_cback;
-    BTM_TRACE_DEBUG("btm_ble_advfilt_enq_op_q: act_ocf:%d, action:%d, ocf:%d,cb_evt;%d, cback:%x",
-        btm_ble_adv_filt_cb.op_q.action_ocf[btm_ble_adv_filt_cb.op_q.next_idx], action,
-        ocf, cb_evt, p_cmpl_cback);
-    btm_ble_adv_filt_cb.op_q.next_idx = (btm_ble_adv_filt_cb.op_q.next_idx + 1)
-                    % BTM_BLE_PF_TYPE_MAX;
-}
-
-/*******************************************************************************
-**
-** Function         btm_ble_advfilt_deq_op_q
+** Parameters       cb_evt: which callback p_cback is, BTM_BLE_FILT_CFG or
+**                          BTM_BLE_FILT_ADV_PARAM; 0 for no callback
 **
-** Description      dequeue an adv filter operation from q when command complete
-**                  is received
-**
-** Returns          void
+** Returns          BTM_CMD_STARTED if the command was issued, error otherwise
 **
 *******************************************************************************/
-void btm_ble_advfilt_deq_op_q(UINT8 *p_action,UINT8 *p_ocf, tBTM_BLE_FILT_CB_EVT *p_cb_evt,
-                              tBTM_BLE_REF_VALUE *p_ref, tBTM_BLE_PF_CFG_CBACK ** p_cmpl_cback,
-                              tBTM_BLE_PF_PARAM_CBACK  **p_filt_param_cback)
+static tBTM_STATUS btm_ble_advfilt_send(UINT8 len, UINT8 *param, tBTM_BLE_FILT_CB_EVT cb_evt,
+                                        tBTM_BLE_REF_VALUE ref_value, void *p_cback)
 {
-    *p_ocf = (btm_ble_adv_filt_cb.op_q.action_ocf[btm_ble_adv_filt_cb.op_q.pending_idx] >> 4);
-    *p_action = (btm_ble_adv_filt_cb.op_q.action_ocf[btm_ble_adv_filt_cb.op_q.pending_idx]
-                & BTM_BLE_ADV_FILT_SUBCODE_MASK);
-    *p_ref = btm_ble_adv_filt_cb.op_q.ref_value[btm_ble_adv_filt_cb.op_q.pending_idx];
-    *p_cb_evt = btm_ble_adv_filt_cb.op_q.cb_evt[btm_ble_adv_filt_cb.op_q.pending_idx];
-    *p_cmpl_cback = btm_ble_adv_filt_cb.op_q.p_scan_cfg_cback[btm_ble_adv_filt_cb.op_q.pending_idx];
-    *p_filt_param_cback =
-        btm_ble_adv_filt_cb.op_q.p_filt_param_cback[btm_ble_adv_filt_cb.op_q.pending_idx];
-
-    btm_ble_adv_filt_cb.op_q.pending_idx = (btm_ble_adv_filt_cb.op_q.pending_idx + 1)
-        % BTM_BLE_PF_TYPE_MAX;
-    BTM_TRACE_DEBUG("btm_ble_advfilt_deq_op_q: ocf:%d, action:%d, ref_value:%d, cb_evt:%x",
-        *p_ocf,*p_action, *p_ref, *p_cb_evt);
+    BTM_TRACE_DEBUG("%s: ocf:%d, action:%d, cb_evt:%d, ref_value:%d", __func__,
+                    param[0], param[1], cb_evt, ref_value);
+
+    return btm_hci_txn_vsc(BTM_HCI_TXN_APCF, HCI_BLE_ADV_FILTER_OCF, len, param,
+                           btm_ble_scan_pf_cmpl_cback, cb_evt, ref_value, p_cback);
 }
 
 /*******************************************************************************
@@ -253,14 +220,14 @@ UINT8 btm_ble_ocf_to_condtype(UINT8 ocf)
 ** Returns          pointer to the counter if found; NULL otherwise.
 **
 *******************************************************************************/
-void btm_ble_scan_pf_cmpl_cback(tBTM_VSC_CMPL *p_params)
+void btm_ble_scan_pf_cmpl_cback(tBTM_VSC_CMPL *p_params, UINT8 cb_evt, UINT32 ref_value,
+                                void *p_cback)
 {
     UINT8  status = 0;
     UINT8  *p = p_params->p_param_buf, op_subcode = 0, action = 0xff;
     UINT16  evt_len = p_params->param_len;
     UINT8   ocf = BTM_BLE_META_PF_ALL, cond_type = 0;
-    UINT8   num_avail = 0, cb_evt = 0;
-    tBTM_BLE_REF_VALUE ref_value = 0;
+    UINT8   num_avail = 0;
     tBTM_BLE_PF_CFG_CBACK *p_scan_cfg_cback = NULL;
     tBTM_BLE_PF_PARAM_CBACK *p_filt_param_cback = NULL;
 
@@ -268,41 +235,33 @@ void btm_ble_scan_pf_cmpl_cback(tBTM_VSC_CMPL *p_params)
     {
       BTM_TRACE_ERROR("%s cannot interpret APCF callback status = %d, length = %d",
           __func__, status, evt_len);
-        btm_ble_advfilt_deq_op_q(&action, &ocf, &cb_evt, &ref_value, &p_scan_cfg_cback,
-                                 &p_filt_param_cback);
         return;
     }
 
-    btm_ble_advfilt_deq_op_q(&action, &ocf, &cb_evt, &ref_value, &p_scan_cfg_cback,
-                             &p_filt_param_cback);
+    if (BTM_BLE_FILT_CFG == cb_evt)
+        p_scan_cfg_cback = (tBTM_BLE_PF_CFG_CBACK *)p_cback;
+    else if (BTM_BLE_FILT_ADV_PARAM == cb_evt)
+        p_filt_param_cback = (tBTM_BLE_PF_PARAM_CBACK *)p_cback;
 
     STREAM_TO_UINT8(status, p);
     STREAM_TO_UINT8(op_subcode, p);
     STREAM_TO_UINT8(action, p);
 
-    /* Ignore the event, if it is not the same one expected */
+    /* The transaction layer matched the completion to the command by sub-opcode */
+    ocf = op_subcode;
+
     if (3 == evt_len)
     {
-        if(ocf != op_subcode)
+        if (BTM_BLE_META_PF_ENABLE != op_subcode)
         {
-             BTM_TRACE_ERROR("btm_ble_scan_pf_cmpl_cback:3-Incorrect opcode :%d, %d, %d, %d, %d, %d",
-                                        ocf, op_subcode, action, evt_len, ref_value, status);
+             BTM_TRACE_ERROR("btm_ble_scan_pf_cmpl_cback:3-Incorrect opcode :%d, %d, %d, %d, %d",
+                                        op_subcode, action, evt_len, ref_value, status);
              return;
         }
-        else
-        {
-            if(NULL != btm_ble_adv_filt_cb.p_filt_stat_cback)
-               btm_ble_adv_filt_cb.p_filt_stat_cback(action, status, ref_value);
-            BTM_TRACE_DEBUG("btm_ble_scan_pf_cmpl_cback enabled/disabled, %d, %d, %d, %d",
-                                         ocf, action, status, ref_value);
-            return;
-        }
-    }
-
-    if (4 == evt_len && ocf != op_subcode)
-    {
-        BTM_TRACE_ERROR("btm_ble_scan_pf_cmpl_cback:4-Incorrect opcode: %d, %d, %d, %d, %d",
-                                ocf, op_subcode, action, status, ref_value);
+        if(NULL != btm_ble_adv_filt_cb.p_filt_stat_cback)
+           btm_ble_adv_filt_cb.p_filt_stat_cback(action, status, ref_value);
+        BTM_TRACE_DEBUG("btm_ble_scan_pf_cmpl_cback enabled/disabled, %d, %d, %d, %d",
+                                     ocf, action, status, ref_value);
         return;
     }
 
@@ -456,7 +415,10 @@ BOOLEAN btm_ble_dealloc_addr_filter_counter(tBLE_BD_ADDR *p_bd_addr, UINT8 filte
 *******************************************************************************/
 tBTM_STATUS btm_ble_update_pf_local_name(tBTM_BLE_SCAN_COND_OP action,
                                          tBTM_BLE_PF_FILT_INDEX filt_index,
-                                         tBTM_BLE_PF_COND_PARAM *p_cond)
+                                         tBTM_BLE_PF_COND_PARAM *p_cond,
+                                         tBTM_BLE_FILT_CB_EVT cb_evt,
+                                         tBTM_BLE_REF_VALUE ref_value,
+                                         tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback)
 {
     tBTM_BLE_PF_LOCAL_NAME_COND *p_local_name = (p_cond == NULL) ? NULL : &p_cond->local_name;
     UINT8       param[BTM_BLE_PF_STR_LEN_MAX + BTM_BLE_ADV_FILT_META_HDR_LENGTH],
@@ -486,11 +448,8 @@ tBTM_STATUS btm_ble_update_pf_local_name(tBTM_BLE_SCAN_COND_OP action,
     }
 
     /* send local name filter */
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              len,
-                              param,
-                              btm_ble_scan_pf_cmpl_cback))
-            != BTM_NO_RESOURCES)
+    if ((st = btm_ble_advfilt_send(len, param, cb_evt, ref_value, (void *)p_cmpl_cback))
+            == BTM_CMD_STARTED)
     {
         memset(&btm_ble_adv_filt_cb.cur_filter_target, 0, sizeof(tBLE_BD_ADDR));
     }
@@ -545,7 +504,8 @@ tBTM_STATUS btm_ble_update_pf_manu_data(tBTM_BLE_SCAN_COND_OP action,
                                         tBTM_BLE_PF_COND_PARAM *p_data,
                                         tBTM_BLE_PF_COND_TYPE cond_type,
                                         tBTM_BLE_FILT_CB_EVT cb_evt,
-                                        tBTM_BLE_REF_VALUE ref_value)
+                                        tBTM_BLE_REF_VALUE ref_value,
+                                        tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback)
 {
     tBTM_BLE_PF_MANU_COND *p_manu_data = (p_data == NULL) ? NULL : &p_data->manu_data;
     tBTM_BLE_PF_SRVC_PATTERN_COND *p_srvc_data = (p_data == NULL) ? NULL : &p_data->srvc_data;
@@ -637,10 +597,8 @@ tBTM_STATUS btm_ble_update_pf_manu_data(tBTM_BLE_SCAN_COND_OP action,
     }
 
     /* send manufacturer*/
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              len,
-                              param,
-                              btm_ble_scan_pf_cmpl_cback)) != BTM_NO_RESOURCES)
+    if ((st = btm_ble_advfilt_send(len, param, cb_evt, ref_value, (void *)p_cmpl_cback))
+            == BTM_CMD_STARTED)
     {
         memset(&btm_ble_adv_filt_cb.cur_filter_target, 0, sizeof(tBLE_BD_ADDR));
     }
@@ -733,7 +691,10 @@ UINT8 btm_ble_cs_update_pf_counter(tBTM_BLE_SCAN_COND_OP action,
 *******************************************************************************/
 tBTM_STATUS btm_ble_update_addr_filter(tBTM_BLE_SCAN_COND_OP action,
                                        tBTM_BLE_PF_FILT_INDEX filt_index,
-                                       tBTM_BLE_PF_COND_PARAM *p_cond)
+                                       tBTM_BLE_PF_COND_PARAM *p_cond,
+                                       tBTM_BLE_FILT_CB_EVT cb_evt,
+                                       tBTM_BLE_REF_VALUE ref_value,
+                                       tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback)
 {
     UINT8       param[BTM_BLE_META_ADDR_LEN + BTM_BLE_ADV_FILT_META_HDR_LENGTH],
                 * p= param;
@@ -758,10 +719,9 @@ tBTM_STATUS btm_ble_update_addr_filter(tBTM_BLE_SCAN_COND_OP action,
         UINT8_TO_STREAM(p, p_addr->type);
     }
     /* send address filter */
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_META_ADDR_LEN),
-                              param,
-                              btm_ble_scan_pf_cmpl_cback)) != BTM_NO_RESOURCES)
+    if ((st = btm_ble_advfilt_send((UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_META_ADDR_LEN),
+                                   param, cb_evt, ref_value, (void *)p_cmpl_cback))
+            == BTM_CMD_STARTED)
     {
         memset(&btm_ble_adv_filt_cb.cur_filter_target, 0, sizeof(tBLE_BD_ADDR));
     }
@@ -788,7 +748,8 @@ tBTM_STATUS btm_ble_update_uuid_filter(tBTM_BLE_SCAN_COND_OP action,
                                        tBTM_BLE_PF_COND_TYPE filter_type,
                                        tBTM_BLE_PF_COND_PARAM *p_cond,
                                        tBTM_BLE_FILT_CB_EVT cb_evt,
-                                       tBTM_BLE_REF_VALUE ref_value)
+                                       tBTM_BLE_REF_VALUE ref_value,
+                                       tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback)
 {
     UINT8       param[BTM_BLE_META_UUID_LEN + BTM_BLE_ADV_FILT_META_HDR_LENGTH],
                 * p= param,
@@ -830,17 +791,15 @@ tBTM_STATUS btm_ble_update_uuid_filter(tBTM_BLE_SCAN_COND_OP action,
         BDADDR_TO_STREAM(p, p_uuid_cond->p_target_addr->bda);
         UINT8_TO_STREAM(p, p_uuid_cond->p_target_addr->type);
 
-        /* send address filter */
-        if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                                  (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_META_ADDR_LEN),
-                                  param,
-                                  btm_ble_scan_pf_cmpl_cback)) == BTM_NO_RESOURCES)
+        /* send address filter, only the UUID filter reports to p_cmpl_cback */
+        if ((st = btm_ble_advfilt_send(
+                    (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_META_ADDR_LEN),
+                    param, 0, ref_value, NULL)) != BTM_CMD_STARTED)
         {
             BTM_TRACE_ERROR("Update Address filter into controller failed.");
             return st;
         }
 
-        btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_ADDR, cb_evt, ref_value, NULL, NULL);
         BTM_TRACE_DEBUG("Updated Address filter");
     }
 
@@ -904,10 +863,8 @@ tBTM_STATUS btm_ble_update_uuid_filter(tBTM_BLE_SCAN_COND_OP action,
     }
 
     /* send UUID filter update */
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              len,
-                              param,
-                              btm_ble_scan_pf_cmpl_cback)) != BTM_NO_RESOURCES)
+    if ((st = btm_ble_advfilt_send(len, param, cb_evt, ref_value, (void *)p_cmpl_cback))
+            == BTM_CMD_STARTED)
     {
         if (p_uuid_cond && p_uuid_cond->p_target_addr)
             memcpy(&btm_ble_adv_filt_cb.cur_filter_target, p_uuid_cond->p_target_addr,
@@ -970,38 +927,25 @@ tBTM_STATUS btm_ble_clear_scan_pf_filter(tBTM_BLE_SCAN_COND_OP action,
     {
         /* clear manufactuer data filter */
         st = btm_ble_update_pf_manu_data(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL,
-                                    BTM_BLE_PF_MANU_DATA, cb_evt, ref_value);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_MANU_DATA, cb_evt,
-                                    ref_value, NULL, NULL);
+                                    BTM_BLE_PF_MANU_DATA, cb_evt, ref_value, NULL);
 
         /* clear local name filter */
-        st = btm_ble_update_pf_local_name(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_LOCAL_NAME, cb_evt,
-                                    ref_value, NULL, NULL);
+        st = btm_ble_update_pf_local_name(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL,
+                                          cb_evt, ref_value, NULL);
 
         /* update the counter for service data */
         st = btm_ble_update_srvc_data_change(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL);
 
         /* clear UUID filter */
         st = btm_ble_update_uuid_filter(BTM_BLE_SCAN_COND_CLEAR, filt_index,
-                                   BTM_BLE_PF_SRVC_UUID, NULL, cb_evt, ref_value);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_UUID, cb_evt, ref_value, NULL, NULL);
+                                   BTM_BLE_PF_SRVC_UUID, NULL, cb_evt, ref_value, NULL);
 
         st = btm_ble_update_uuid_filter(BTM_BLE_SCAN_COND_CLEAR, filt_index,
-                                   BTM_BLE_PF_SRVC_SOL_UUID, NULL, cb_evt, ref_value);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_SOL_UUID, cb_evt,
-                                    ref_value, NULL, NULL);
+                                   BTM_BLE_PF_SRVC_SOL_UUID, NULL, cb_evt, ref_value, NULL);
 
         /* clear service data filter */
         st = btm_ble_update_pf_manu_data(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL,
-                                    BTM_BLE_PF_SRVC_DATA_PATTERN, cb_evt, ref_value);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_SRVC_DATA, cb_evt,
-                                    ref_value, NULL, NULL);
+                                    BTM_BLE_PF_SRVC_DATA_PATTERN, cb_evt, ref_value, NULL);
     }
 
     /* select feature based on control block settings */
@@ -1016,11 +960,11 @@ tBTM_STATUS btm_ble_clear_scan_pf_filter(tBTM_BLE_SCAN_COND_OP action,
     /* set logic condition as OR as default */
     UINT8_TO_STREAM(p, BTM_BLE_PF_LOGIC_OR);
 
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                               (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_PF_FEAT_SEL_LEN),
-                                param,
-                                btm_ble_scan_pf_cmpl_cback))
-            != BTM_NO_RESOURCES)
+    /* the feature selection reports the whole clear to p_cmpl_cback */
+    if ((st = btm_ble_advfilt_send(
+                (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_PF_FEAT_SEL_LEN),
+                param, BTM_BLE_FILT_CFG, ref_value, (void *)p_cmpl_cback))
+            == BTM_CMD_STARTED)
     {
         if (p_target)
             memcpy(&btm_ble_adv_filt_cb.cur_filter_target, p_target, sizeof(tBLE_BD_ADDR));
@@ -1114,16 +1058,11 @@ tBTM_STATUS BTM_BleAdvFilterParamSetup(int action, tBTM_BLE_PF_FILT_INDEX filt_i
             len = BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_ADV_FILT_FEAT_SELN_LEN +
                   BTM_BLE_ADV_FILT_TRACK_NUM;
 
-        if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                                (UINT8)len,
-                                 param,
-                                 btm_ble_scan_pf_cmpl_cback))
-               == BTM_NO_RESOURCES)
+        if ((st = btm_ble_advfilt_send((UINT8)len, param, BTM_BLE_FILT_ADV_PARAM,
+                                       ref_value, (void *)p_cmpl_cback)) != BTM_CMD_STARTED)
         {
             return st;
         }
-        btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_FEAT_SEL, BTM_BLE_FILT_ADV_PARAM,
-                                 ref_value, NULL, p_cmpl_cback);
     }
     else
     if (BTM_BLE_SCAN_COND_DELETE == action)
@@ -1134,16 +1073,12 @@ tBTM_STATUS BTM_BleAdvFilterParamSetup(int action, tBTM_BLE_PF_FILT_INDEX filt_i
         /* Filter index */
         UINT8_TO_STREAM(p, filt_index);
 
-        if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                                (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH),
-                                 param,
-                                 btm_ble_scan_pf_cmpl_cback))
-               == BTM_NO_RESOURCES)
+        if ((st = btm_ble_advfilt_send((UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH), param,
+                                       BTM_BLE_FILT_ADV_PARAM, ref_value,
+                                       (void *)p_cmpl_cback)) != BTM_CMD_STARTED)
         {
             return st;
         }
-        btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_FEAT_SEL,  BTM_BLE_FILT_ADV_PARAM,
-                                 ref_value, NULL, p_cmpl_cback);
     }
     else
     if (BTM_BLE_SCAN_COND_CLEAR == action)
@@ -1155,16 +1090,12 @@ tBTM_STATUS BTM_BleAdvFilterParamSetup(int action, tBTM_BLE_PF_FILT_INDEX filt_i
         UINT8_TO_STREAM(p, BTM_BLE_META_PF_FEAT_SEL);
         UINT8_TO_STREAM(p, BTM_BLE_SCAN_COND_CLEAR);
 
-        if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                                (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH-1),
-                                 param,
-                                 btm_ble_scan_pf_cmpl_cback))
-               == BTM_NO_RESOURCES)
+        if ((st = btm_ble_advfilt_send((UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH-1), param,
+                                       BTM_BLE_FILT_ADV_PARAM, ref_value,
+                                       (void *)p_cmpl_cback)) != BTM_CMD_STARTED)
         {
             return st;
         }
-        btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_FEAT_SEL,  BTM_BLE_FILT_ADV_PARAM,
-                                 ref_value, NULL, p_cmpl_cback);
     }
 
     return st;
@@ -1202,13 +1133,10 @@ tBTM_STATUS BTM_BleEnableDisableFilterFeature(UINT8 enable,
     /* enable adv data payload filtering */
     UINT8_TO_STREAM(p, enable);
 
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              BTM_BLE_PCF_ENABLE_LEN, param,
-                              btm_ble_scan_pf_cmpl_cback)) == BTM_CMD_STARTED)
+    if ((st = btm_ble_advfilt_send(BTM_BLE_PCF_ENABLE_LEN, param, BTM_BLE_FILT_ENABLE_DISABLE,
+                                   ref_value, NULL)) == BTM_CMD_STARTED)
     {
          btm_ble_adv_filt_cb.p_filt_stat_cback = p_stat_cback;
-         btm_ble_advfilt_enq_op_q(enable, BTM_BLE_META_PF_ENABLE, BTM_BLE_FILT_ENABLE_DISABLE,
-                                  ref_value, NULL, NULL);
     }
     return st;
 }
@@ -1238,36 +1166,41 @@ tBTM_STATUS BTM_BleCfgFilterCondition(tBTM_BLE_SCAN_COND_OP action,
                                       tBTM_BLE_REF_VALUE ref_value)
 {
     tBTM_STATUS     st = BTM_ILLEGAL_VALUE;
-    UINT8 ocf = 0;
     BTM_TRACE_EVENT (" BTM_BleCfgFilterCondition action:%d, cond_type:%d, index:%d", action,
                         cond_type, filt_index);
 
     if (BTM_SUCCESS  != btm_ble_obtain_vsc_details())
         return st;
 
+    btm_hci_txn_begin(BTM_HCI_TXN_APCF);
+
     switch (cond_type)
     {
         /* write service data filter */
         case BTM_BLE_PF_SRVC_DATA_PATTERN:
         /* write manufacturer data filter */
         case BTM_BLE_PF_MANU_DATA:
-            st = btm_ble_update_pf_manu_data(action, filt_index, p_cond, cond_type, 0, ref_value);
+            st = btm_ble_update_pf_manu_data(action, filt_index, p_cond, cond_type,
+                                             BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback);
             break;
 
         /* write local name filter */
         case BTM_BLE_PF_LOCAL_NAME:
-            st = btm_ble_update_pf_local_name(action, filt_index, p_cond);
+            st = btm_ble_update_pf_local_name(action, filt_index, p_cond,
+                                              BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback);
             break;
 
         /* filter on advertiser address */
         case BTM_BLE_PF_ADDR_FILTER:
-            st = btm_ble_update_addr_filter(action, filt_index, p_cond);
+            st = btm_ble_update_addr_filter(action, filt_index, p_cond,
+                                            BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback);
             break;
 
         /* filter on service/solicitated UUID */
         case BTM_BLE_PF_SRVC_UUID:
         case BTM_BLE_PF_SRVC_SOL_UUID:
-            st = btm_ble_update_uuid_filter(action, filt_index, cond_type, p_cond, 0, ref_value);
+            st = btm_ble_update_uuid_filter(action, filt_index, cond_type, p_cond,
+                                            BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback);
             break;
 
         case BTM_BLE_PF_SRVC_DATA:
@@ -1284,17 +1217,7 @@ tBTM_STATUS BTM_BleCfgFilterCondition(tBTM_BLE_SCAN_COND_OP action,
             break;
     }
 
-    if(BTM_CMD_STARTED == st && cond_type != BTM_BLE_PF_TYPE_ALL)
-    {
-       ocf = btm_ble_condtype_to_ocf(cond_type);
-       btm_ble_advfilt_enq_op_q(action, ocf, BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback, NULL);
-    }
-    else
-    if(BTM_CMD_STARTED == st && BTM_BLE_PF_TYPE_ALL == cond_type)
-    {
-       btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_FEAT_SEL, BTM_BLE_FILT_CFG,
-                                ref_value, p_cmpl_cback, NULL);
-    }
+    btm_hci_txn_end(BTM_HCI_TXN_APCF);
     return st;
 }
 
@@ -1311,7 +1234,7 @@ tBTM_STATUS BTM_BleCfgFilterCondition(tBTM_BLE_SCAN_COND_OP action,
 *******************************************************************************/
 void btm_ble_adv_filter_init(void)
 {
-    memset(&btm_ble_adv_filt_cb, 0, sizeof(tBTM_BLE_MULTI_ADV_CB));
+    memset(&btm_ble_adv_filt_cb, 0, sizeof(tBTM_BLE_ADV_FILTER_CB));
     if (BTM_SUCCESS != btm_ble_obtain_vsc_details())
        return;
 
@@ -1335,6 +1258,7 @@ void btm_ble_adv_filter_init(void)
 *******************************************************************************/
 void btm_ble_adv_filter_cleanup(void)
 {
+    btm_hci_txn_flush(BTM_HCI_TXN_APCF);
     osi_free_and_reset((void **)&btm_ble_adv_filt_cb.p_addr_filter_count);
 }
 
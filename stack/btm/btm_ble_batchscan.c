@@ -27,6 +27,7 @@
 #include "btm_int.h"
 #include "device/include/controller.h"
 #include "hcimsgs.h"
+#include "osi/include/osi.h"
 
 #if (BLE_INCLUDED == TRUE)
 
@@ -43,11 +44,21 @@ tBTM_BLE_ADV_TRACK_CB ble_advtrack_cb;
 #define BTM_BLE_BATCH_SCAN_CB_EVT_MASK       0xF0
 #define BTM_BLE_BATCH_SCAN_SUBCODE_MASK      0x0F
 
+/* report record layout: address, address type, tx power, RSSI and timestamp,
+   followed in full (active) reports by the length prefixed advertising data
+   and scan response */
+#define BTM_BLE_BATCH_REC_FIXED_LEN          11
+#define BTM_BLE_BATCH_REC_MAX_LEN            (BTM_BLE_BATCH_REC_FIXED_LEN + 2 * (1 + 255))
+
+/* a batch must hold at least one record of any size */
+COMPILE_ASSERT(BTM_BLE_BATCH_REP_BATCH_SIZE >= BTM_BLE_BATCH_REC_MAX_LEN);
+
 /*******************************************************************************
 **  Local functions
 *******************************************************************************/
 void btm_ble_batchscan_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params);
 void btm_ble_batchscan_cleanup(void);
+static void btm_ble_batchscan_batch_reset(tBTM_BLE_BATCH_REP_BATCH *p_batch);
 
 /*******************************************************************************
 **
@@ -177,9 +188,8 @@ tBTM_STATUS btm_ble_batchscan_enq_rep_q(UINT8 report_format, tBTM_BLE_REF_VALUE
 
     ble_batchscan_cb.main_rep_q.rep_mode[ble_batchscan_cb.main_rep_q.next_idx] = report_format;
     ble_batchscan_cb.main_rep_q.ref_value[ble_batchscan_cb.main_rep_q.next_idx] = ref_value;
-    ble_batchscan_cb.main_rep_q.num_records[ble_batchscan_cb.main_rep_q.next_idx] = 0;
-    ble_batchscan_cb.main_rep_q.data_len[ble_batchscan_cb.main_rep_q.next_idx] = 0;
-    ble_batchscan_cb.main_rep_q.p_data[ble_batchscan_cb.main_rep_q.next_idx] = NULL;
+    btm_ble_batchscan_batch_reset(&ble_batchscan_cb.main_rep_q.batch[ble_batchscan_cb.main_rep_q.next_idx]);
+    ble_batchscan_cb.main_rep_q.batch[ble_batchscan_cb.main_rep_q.next_idx].read_len = 0;
     BTM_TRACE_DEBUG("btm_ble_batchscan_enq_rep_q: index:%d, rep %d, ref %d",
             ble_batchscan_cb.main_rep_q.next_idx, report_format, ref_value);
 
@@ -188,19 +198,207 @@ tBTM_STATUS btm_ble_batchscan_enq_rep_q(UINT8 report_format, tBTM_BLE_REF_VALUE
     return BTM_SUCCESS;
 }
 
+/*******************************************************************************
+**
+** Function         btm_ble_batchscan_rec_len
+**
+** Description      Returns the length of the report record at p, 0 if it runs
+**                  past the avail bytes left in the response.
+**
+*******************************************************************************/
+static UINT16 btm_ble_batchscan_rec_len(UINT8 report_format, UINT8 *p, UINT16 avail)
+{
+    UINT16 len = BTM_BLE_BATCH_REC_FIXED_LEN;
+
+    if (avail < len)
+        return 0;
+
+    if (BTM_BLE_BATCH_SCAN_MODE_ACTI == report_format)
+    {
+        /* advertising data */
+        if (avail < len + 1)
+            return 0;
+        len += 1 + p[len];
+
+        /* scan response */
+        if (avail < len + 1)
+            return 0;
+        len += 1 + p[len];
+
+        if (avail < len)
+            return 0;
+    }
+
+    return len;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_batchscan_addr_hash
+**
+** Description      Hashes the address at the start of a report record.
+**
+*******************************************************************************/
+static UINT8 btm_ble_batchscan_addr_hash(const UINT8 *p_addr)
+{
+    UINT32 h = ((UINT32)p_addr[2] << 24 | (UINT32)p_addr[3] << 16 |
+                (UINT32)p_addr[4] << 8 | p_addr[5]) ^ ((UINT32)p_addr[0] << 8 | p_addr[1]);
+
+    return (UINT8)(((h * 0x9E3779B1) >> 16) & (BTM_BLE_BATCH_REP_HASH_SIZE - 1));
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_batchscan_batch_reset
+**
+** Description      Empties a batch. The buffer must have been released.
+**
+*******************************************************************************/
+static void btm_ble_batchscan_batch_reset(tBTM_BLE_BATCH_REP_BATCH *p_batch)
+{
+    p_batch->p_buf = NULL;
+    p_batch->len = 0;
+    p_batch->num_records = 0;
+    memset(p_batch->hash, BTM_BLE_BATCH_REP_NO_RECORD, sizeof(p_batch->hash));
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_batchscan_batch_rehash
+**
+** Description      Rebuilds the address index of a batch.
+**
+*******************************************************************************/
+static void btm_ble_batchscan_batch_rehash(tBTM_BLE_BATCH_REP_BATCH *p_batch)
+{
+    UINT8 i, h;
+
+    memset(p_batch->hash, BTM_BLE_BATCH_REP_NO_RECORD, sizeof(p_batch->hash));
+    for (i = 0; i < p_batch->num_records; i++)
+    {
+        h = btm_ble_batchscan_addr_hash(p_batch->p_buf + p_batch->rec_off[i]);
+        p_batch->rec_next[i] = p_batch->hash[h];
+        p_batch->hash[h] = i;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_batchscan_flush_rep_data
+**
+** Description      Passes the records collected so far for a report read to
+**                  the report callback, which takes ownership of the buffer.
+**
+*******************************************************************************/
+static void btm_ble_batchscan_flush_rep_data(int index, UINT8 status)
+{
+    tBTM_BLE_BATCH_REP_BATCH *p_batch = &ble_batchscan_cb.main_rep_q.batch[index];
+
+    if (0 == p_batch->num_records)
+        return;
+
+    BTM_TRACE_DEBUG("%s: index:%d, rep %d, num %d, len %d", __func__, index,
+                    ble_batchscan_cb.main_rep_q.rep_mode[index], p_batch->num_records,
+                    p_batch->len);
+
+    ble_batchscan_cb.stats.batches++;
+    ble_batchscan_cb.stats.records_out += p_batch->num_records;
+
+    if (NULL != ble_batchscan_cb.p_scan_rep_cback)
+        ble_batchscan_cb.p_scan_rep_cback(ble_batchscan_cb.main_rep_q.ref_value[index],
+                                          ble_batchscan_cb.main_rep_q.rep_mode[index],
+                                          p_batch->num_records, p_batch->len,
+                                          p_batch->p_buf, status);
+    else
+        osi_free(p_batch->p_buf);
+
+    btm_ble_batchscan_batch_reset(p_batch);
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_batchscan_add_rec
+**
+** Description      Adds one report record to the batch of a report read. A
+**                  record from an address that is already in the batch
+**                  replaces the earlier one. A full batch is passed on first.
+**
+*******************************************************************************/
+static void btm_ble_batchscan_add_rec(int index, UINT8 *p_rec, UINT16 rec_len)
+{
+    tBTM_BLE_BATCH_REP_BATCH *p_batch = &ble_batchscan_cb.main_rep_q.batch[index];
+    UINT8 h = btm_ble_batchscan_addr_hash(p_rec);
+    UINT8 i;
+    UINT16 off, next_off, old_len;
+
+    ble_batchscan_cb.stats.records_in++;
+
+    for (i = p_batch->hash[h]; i != BTM_BLE_BATCH_REP_NO_RECORD; i = p_batch->rec_next[i])
+    {
+        if (memcmp(p_batch->p_buf + p_batch->rec_off[i], p_rec, BD_ADDR_LEN) == 0)
+            break;
+    }
+
+    if (i != BTM_BLE_BATCH_REP_NO_RECORD)
+    {
+        ble_batchscan_cb.stats.merged++;
+
+        off = p_batch->rec_off[i];
+        next_off = (i + 1 < p_batch->num_records) ? p_batch->rec_off[i + 1] : p_batch->len;
+        old_len = next_off - off;
+
+        /* same size (always the case for truncated records): update in place */
+        if (old_len == rec_len)
+        {
+            memcpy(p_batch->p_buf + off, p_rec, rec_len);
+            return;
+        }
+
+        /* otherwise drop the older record and append the new one */
+        memmove(p_batch->p_buf + off, p_batch->p_buf + next_off, p_batch->len - next_off);
+        p_batch->len -= old_len;
+        p_batch->num_records--;
+        for (; i < p_batch->num_records; i++)
+            p_batch->rec_off[i] = p_batch->rec_off[i + 1] - old_len;
+        btm_ble_batchscan_batch_rehash(p_batch);
+    }
+
+    if (NULL != p_batch->p_buf &&
+        (p_batch->len + rec_len > BTM_BLE_BATCH_REP_BATCH_SIZE ||
+         BTM_BLE_BATCH_REP_MAX_RECORDS == p_batch->num_records))
+    {
+        btm_ble_batchscan_flush_rep_data(index, BTM_SUCCESS);
+    }
+
+    if (NULL == p_batch->p_buf)
+        p_batch->p_buf = osi_malloc(BTM_BLE_BATCH_REP_BATCH_SIZE);
+
+    i = p_batch->num_records++;
+    p_batch->rec_off[i] = p_batch->len;
+    memcpy(p_batch->p_buf + p_batch->len, p_rec, rec_len);
+    p_batch->len += rec_len;
+    p_batch->rec_next[i] = p_batch->hash[h];
+    p_batch->hash[h] = i;
+
+    if (p_batch->len > ble_batchscan_cb.stats.batch_high_water)
+        ble_batchscan_cb.stats.batch_high_water = p_batch->len;
+}
+
 /*******************************************************************************
 **
 ** Function         btm_ble_batchscan_enq_rep_data
 **
-** Description      setup the data in the main report queue
+** Description      Parses the records of one READ_RESULTS response into the
+**                  batch of its report read
 **
 ** Returns          void
 **
 *******************************************************************************/
 void btm_ble_batchscan_enq_rep_data(UINT8 report_format, UINT8 num_records, UINT8 *p_data,
-                                    UINT8 data_len)
+                                    UINT16 data_len)
 {
     int index = 0;
+    UINT16 rec_len;
 
     for (index = 0; index < BTM_BLE_BATCH_REP_MAIN_Q_SIZE; index++)
     {
@@ -211,30 +409,25 @@ void btm_ble_batchscan_enq_rep_data(UINT8 report_format, UINT8 num_records, UINT
     BTM_TRACE_DEBUG("btm_ble_batchscan_enq_rep_data: index:%d, rep %d, num %d len : %d",
         index, report_format, num_records, data_len);
 
-    if (index < BTM_BLE_BATCH_REP_MAIN_Q_SIZE && data_len > 0 && num_records > 0)
-    {
-        int len = ble_batchscan_cb.main_rep_q.data_len[index];
-        UINT8 *p_orig_data = ble_batchscan_cb.main_rep_q.p_data[index];
-        UINT8 *p_app_data;
+    if (index == BTM_BLE_BATCH_REP_MAIN_Q_SIZE || data_len == 0 || num_records == 0)
+        return;
 
-        if (NULL != p_orig_data)
-        {
-            p_app_data = osi_malloc(len + data_len);
-            memcpy(p_app_data, p_orig_data, len);
-            memcpy(p_app_data+len, p_data, data_len);
-            osi_free(p_orig_data);
-            ble_batchscan_cb.main_rep_q.p_data[index] = p_app_data;
-            ble_batchscan_cb.main_rep_q.num_records[index] += num_records;
-            ble_batchscan_cb.main_rep_q.data_len[index] += data_len;
-        }
-        else
+    ble_batchscan_cb.stats.chunks++;
+    ble_batchscan_cb.main_rep_q.batch[index].read_len += data_len;
+
+    for (; num_records > 0; num_records--)
+    {
+        rec_len = btm_ble_batchscan_rec_len(report_format, p_data, data_len);
+        if (0 == rec_len)
         {
-            p_app_data = osi_malloc(data_len);
-            memcpy(p_app_data, p_data, data_len);
-            ble_batchscan_cb.main_rep_q.p_data[index] = p_app_data;
-            ble_batchscan_cb.main_rep_q.num_records[index] = num_records;
-            ble_batchscan_cb.main_rep_q.data_len[index] = data_len;
+            BTM_TRACE_ERROR("%s: malformed record, %d bytes left", __func__, data_len);
+            ble_batchscan_cb.stats.malformed++;
+            break;
         }
+
+        btm_ble_batchscan_add_rec(index, p_data, rec_len);
+        p_data += rec_len;
+        data_len -= rec_len;
     }
 }
 
@@ -243,7 +436,8 @@ void btm_ble_batchscan_enq_rep_data(UINT8 report_format, UINT8 num_records, UINT
 ** Function         btm_ble_batchscan_deq_rep_q
 **
 ** Description      dequeue a batchscan report  in q when command complete
-**                  is received
+**                  is received. Returns the records of the read that have not
+**                  been passed to the report callback yet.
 **
 ** Returns          void
 **
@@ -252,6 +446,7 @@ void btm_ble_batchscan_deq_rep_data(UINT8 report_format, tBTM_BLE_REF_VALUE *p_r
                                  UINT8 *p_num_records, UINT8 **p_data, UINT16 *p_data_len)
 {
     int index = 0;
+    tBTM_BLE_BATCH_REP_BATCH *p_batch;
 
     for (index = 0; index < BTM_BLE_BATCH_REP_MAIN_Q_SIZE; index++)
     {
@@ -265,16 +460,26 @@ void btm_ble_batchscan_deq_rep_data(UINT8 report_format, tBTM_BLE_REF_VALUE *p_r
         return;
     }
 
-    *p_num_records = ble_batchscan_cb.main_rep_q.num_records[index];
+    p_batch = &ble_batchscan_cb.main_rep_q.batch[index];
+
+    *p_num_records = p_batch->num_records;
     *p_ref_value = ble_batchscan_cb.main_rep_q.ref_value[index];
-    *p_data = ble_batchscan_cb.main_rep_q.p_data[index];
-    *p_data_len = ble_batchscan_cb.main_rep_q.data_len[index];
+    *p_data = p_batch->p_buf;
+    *p_data_len = p_batch->len;
 
-    ble_batchscan_cb.main_rep_q.p_data[index] = NULL;
-    ble_batchscan_cb.main_rep_q.data_len[index] = 0;
+    ble_batchscan_cb.stats.reads++;
+    if (p_batch->read_len > ble_batchscan_cb.stats.read_high_water)
+        ble_batchscan_cb.stats.read_high_water = p_batch->read_len;
+    if (p_batch->num_records > 0)
+    {
+        ble_batchscan_cb.stats.batches++;
+        ble_batchscan_cb.stats.records_out += p_batch->num_records;
+    }
+
+    btm_ble_batchscan_batch_reset(p_batch);
+    p_batch->read_len = 0;
     ble_batchscan_cb.main_rep_q.rep_mode[index] = 0;
     ble_batchscan_cb.main_rep_q.ref_value[index] = 0;
-    ble_batchscan_cb.main_rep_q.num_records[index] = 0;
 
     BTM_TRACE_DEBUG("btm_ble_batchscan_deq_rep_data: index:%d, rep %d, num %d, data_len %d",
         index, report_format, *p_num_records, *p_data_len);
@@ -473,8 +678,10 @@ void btm_ble_batchscan_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params)
                         {
                             btm_ble_batchscan_deq_rep_data(report_format, &ref_value, &num_records,
                                                            &p_data, &data_len);
-                            /* Send whatever is available, in case of a command failure */
-                            if (NULL != ble_batchscan_cb.p_scan_rep_cback && NULL != p_data)
+                            /* Send whatever is available, in case of a command failure.
+                               Earlier batches may have been sent already, so this is
+                               sent even without records to end the read. */
+                            if (NULL != ble_batchscan_cb.p_scan_rep_cback)
                                 ble_batchscan_cb.p_scan_rep_cback(ref_value,report_format,
                                                  num_records, data_len, p_data, status);
                         }
@@ -928,6 +1135,22 @@ tBTM_STATUS BTM_BleTrackAdvertiser(tBTM_BLE_TRACK_ADV_CBACK *p_track_cback,
     return BTM_CMD_STARTED;
 }
 
+/*******************************************************************************
+**
+** Function         BTM_BleGetBatchScanStats
+**
+** Description      Reads the batch scan report pipeline counters.
+**
+** Parameters       p_stats: filled with the counters.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTM_BleGetBatchScanStats(tBTM_BLE_BATCH_SCAN_STATS *p_stats)
+{
+    *p_stats = ble_batchscan_cb.stats;
+}
+
 /*******************************************************************************
 **
 ** Function         btm_ble_batchscan_init
@@ -964,7 +1187,7 @@ void btm_ble_batchscan_cleanup(void)
     BTM_TRACE_EVENT (" btm_ble_batchscan_cleanup");
 
     for (index = 0; index < BTM_BLE_BATCH_REP_MAIN_Q_SIZE; index++)
-        osi_free_and_reset((void **)&ble_batchscan_cb.main_rep_q.p_data[index]);
+        osi_free_and_reset((void **)&ble_batchscan_cb.main_rep_q.batch[index].p_buf);
 
     memset(&ble_batchscan_cb, 0, sizeof(tBTM_BLE_BATCH_SCAN_CB));
     memset(&ble_advtrack_cb, 0, sizeof(tBTM_BLE_ADV_TRACK_CB));
@@ -75,6 +75,7 @@ static tBTM_BLE_CTRL_FEATURES_CBACK    *p_ext_adv_ctrl_le_feature_rd_cmpl_cback
 *******************************************************************************/
 static void btm_ble_update_adv_flag(UINT8 flag);
 static void btm_ble_process_adv_pkt_cont(BD_ADDR bda, UINT8 addr_type, UINT16 evt_type, UINT8 *p, BOOLEAN extended);
+static void btm_ble_adv_dedup_flush(void);
 UINT8 *btm_ble_build_adv_data(tBTM_BLE_AD_MASK *p_data_mask, UINT8 **p_dst,
                               tBTM_BLE_ADV_DATA *p_data, UINT16 max_len);
 static UINT8 btm_set_conn_mode_adv_init_addr(tBTM_BLE_INQ_CB *p_cb,
@@ -434,6 +435,8 @@ tBTM_STATUS BTM_BleObserve(BOOLEAN start, UINT16 duration, UINT16 period,
 
         if (status == BTM_CMD_STARTED)
         {
+            /* a new observer gets the first report of every advertiser */
+            btm_ble_adv_dedup_flush();
             btm_cb.ble_ctr_cb.scan_activity |= BTM_LE_OBSERVE_ACTIVE;
             if (duration != 0) {
                 /* start observer timer */
@@ -458,6 +461,54 @@ tBTM_STATUS BTM_BleObserve(BOOLEAN start, UINT16 duration, UINT16 period,
 
 }
 
+/*******************************************************************************
+**
+** Function         BTM_BleSetRawScanReports
+**
+** Description      When built with BTM_BLE_ADV_DEDUP_ENABLED, observers only
+**                  receive an advertising report when the advertiser is new,
+**                  its data changed, its RSSI moved by
+**                  BTM_BLE_ADV_DEDUP_RSSI_STEP, or BTM_BLE_ADV_DEDUP_REFRESH_MS
+**                  elapsed since it was last reported. While any client has
+**                  raw reports enabled every report is passed on.
+**
+** Parameters       client_if: GATT client interface.
+**                  raw: TRUE to receive every advertising report.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTM_BleSetRawScanReports(tGATT_IF client_if, BOOLEAN raw)
+{
+    tBTM_BLE_ADV_DEDUP *p_dedup = &btm_cb.ble_ctr_cb.adv_dedup;
+
+    BTM_TRACE_EVENT("%s client_if=%d raw=%d", __func__, client_if, raw);
+
+    if (client_if == 0 || client_if > BTM_BLE_ADV_DEDUP_MAX_RAW_CLIENTS)
+        return;
+
+    if (raw)
+        p_dedup->raw_clients |= (UINT32)1 << (client_if - 1);
+    else
+        p_dedup->raw_clients &= ~((UINT32)1 << (client_if - 1));
+}
+
+/*******************************************************************************
+**
+** Function         BTM_BleGetAdvDedupStats
+**
+** Description      Reads the observer advertising report suppression counters.
+**
+** Parameters       p_stats: filled with the counters.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTM_BleGetAdvDedupStats(tBTM_BLE_ADV_DEDUP_STATS *p_stats)
+{
+    *p_stats = btm_cb.ble_ctr_cb.adv_dedup.stats;
+}
+
 /*******************************************************************************
 **
 ** Function         BTM_BleBroadcast
@@ -2944,13 +2995,13 @@ void btm_clear_all_pending_le_entry(void)
     UINT16       xx;
     tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    for (xx = 0; xx < btm_cb.btm_inq_vars.inq_db_size; xx++, p_ent++)
     {
         /* mark all pending LE entry as unused if an LE only device has scan response outstanding */
         if ((p_ent->in_use) &&
             (p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
              !p_ent->scan_rsp)
-            p_ent->in_use = FALSE;
+            btm_inq_db_remove(p_ent);
     }
 }
 
@@ -3101,6 +3152,183 @@ void btm_ble_process_adv_pkt (UINT8 *p_data, BOOLEAN extended)
     }
 }
 
+/*******************************************************************************
+**  Observer advertising report suppression
+**
+**  Advertisers repeat the same payload many times a second. For each recently
+**  heard address and event type the hash of the last reported payload, its
+**  RSSI and the time it was reported are kept, so that only reports carrying
+**  something new reach the observer callback. Keying on the event type keeps
+**  the alternating advertising and scan response reports of an advertiser
+**  from looking like payload changes. Entries are found through a hash of the
+**  key and the least recently heard one is recycled when the table is full.
+*******************************************************************************/
+
+static UINT16 btm_ble_adv_dedup_bucket(const UINT8 *p_addr, UINT16 evt_type)
+{
+    UINT32 h = ((UINT32)p_addr[2] << 24) | ((UINT32)p_addr[3] << 16) |
+               ((UINT32)p_addr[4] << 8) | p_addr[5];
+
+    h ^= ((UINT32)p_addr[0] << 8) | p_addr[1];
+    h ^= (UINT32)evt_type << 20;
+    return (UINT16)(((h * 0x9E3779B1) >> 16) & (BTM_BLE_ADV_DEDUP_HASH_SIZE - 1));
+}
+
+/* FNV-1a over the address type and advertising data */
+static UINT32 btm_ble_adv_dedup_hash(UINT8 addr_type, const UINT8 *p_data, UINT16 len)
+{
+    UINT32 h = 2166136261u;
+
+    h = (h ^ addr_type) * 16777619u;
+    while (len--)
+        h = (h ^ *p_data++) * 16777619u;
+    return h;
+}
+
+static void btm_ble_adv_dedup_unlink(tBTM_BLE_ADV_DEDUP *p_dedup, tBTM_BLE_ADV_DEDUP_ENT *p_ent)
+{
+    tBTM_BLE_ADV_DEDUP_ENT **pp;
+
+    for (pp = &p_dedup->hash[btm_ble_adv_dedup_bucket(p_ent->bd_addr, p_ent->evt_type)]; *pp;
+         pp = &(*pp)->p_hash_next)
+    {
+        if (*pp == p_ent)
+        {
+            *pp = p_ent->p_hash_next;
+            break;
+        }
+    }
+    p_ent->p_hash_next = NULL;
+
+    if (p_ent->p_lru_prev)
+        p_ent->p_lru_prev->p_lru_next = p_ent->p_lru_next;
+    else
+        p_dedup->p_oldest = p_ent->p_lru_next;
+
+    if (p_ent->p_lru_next)
+        p_ent->p_lru_next->p_lru_prev = p_ent->p_lru_prev;
+    else
+        p_dedup->p_newest = p_ent->p_lru_prev;
+
+    p_ent->p_lru_prev = NULL;
+    p_ent->p_lru_next = NULL;
+}
+
+static void btm_ble_adv_dedup_link(tBTM_BLE_ADV_DEDUP *p_dedup, tBTM_BLE_ADV_DEDUP_ENT *p_ent)
+{
+    tBTM_BLE_ADV_DEDUP_ENT **pp =
+        &p_dedup->hash[btm_ble_adv_dedup_bucket(p_ent->bd_addr, p_ent->evt_type)];
+
+    p_ent->p_hash_next = *pp;
+    *pp = p_ent;
+
+    p_ent->p_lru_next = NULL;
+    p_ent->p_lru_prev = p_dedup->p_newest;
+    if (p_dedup->p_newest)
+        p_dedup->p_newest->p_lru_next = p_ent;
+    else
+        p_dedup->p_oldest = p_ent;
+    p_dedup->p_newest = p_ent;
+}
+
+/* forgets all advertisers, keeping the counters and the settings */
+static void btm_ble_adv_dedup_flush(void)
+{
+    tBTM_BLE_ADV_DEDUP *p_dedup = &btm_cb.ble_ctr_cb.adv_dedup;
+
+    memset(p_dedup->entry, 0, sizeof(p_dedup->entry));
+    memset(p_dedup->hash, 0, sizeof(p_dedup->hash));
+    p_dedup->num_used = 0;
+    p_dedup->p_oldest = NULL;
+    p_dedup->p_newest = NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_adv_dedup_check
+**
+** Description      Decides whether an advertising report has to be passed to
+**                  the observer, and records it if so.
+**
+** Returns          TRUE to report, FALSE if nothing changed since the
+**                  advertiser was last reported.
+**
+*******************************************************************************/
+static BOOLEAN btm_ble_adv_dedup_check(const BD_ADDR bda, UINT8 addr_type, UINT16 evt_type,
+                                       INT8 rssi, const UINT8 *p_data, UINT16 len)
+{
+    tBTM_BLE_ADV_DEDUP      *p_dedup = &btm_cb.ble_ctr_cb.adv_dedup;
+    tBTM_BLE_ADV_DEDUP_ENT  *p_ent;
+    UINT32                  payload_hash;
+    UINT32                  now_ms;
+    int                     rssi_delta;
+
+    if (!p_dedup->enabled)
+        return TRUE;
+
+    if (p_dedup->raw_clients)
+    {
+        p_dedup->stats.raw++;
+        p_dedup->stats.forwarded++;
+        return TRUE;
+    }
+
+    payload_hash = btm_ble_adv_dedup_hash(addr_type, p_data, len);
+    now_ms = (UINT32)time_get_os_boottime_ms();
+
+    for (p_ent = p_dedup->hash[btm_ble_adv_dedup_bucket(bda, evt_type)]; p_ent;
+         p_ent = p_ent->p_hash_next)
+    {
+        if (p_ent->evt_type == evt_type && !memcmp(p_ent->bd_addr, bda, BD_ADDR_LEN))
+            break;
+    }
+
+    if (p_ent == NULL)
+    {
+        if (p_dedup->num_used < BTM_BLE_ADV_DEDUP_SIZE)
+            p_ent = &p_dedup->entry[p_dedup->num_used++];
+        else
+        {
+            p_ent = p_dedup->p_oldest;
+            btm_ble_adv_dedup_unlink(p_dedup, p_ent);
+            p_dedup->stats.evicted++;
+        }
+        memcpy(p_ent->bd_addr, bda, BD_ADDR_LEN);
+        p_ent->evt_type = evt_type;
+        p_ent->in_use = TRUE;
+        p_dedup->stats.new_adv++;
+    }
+    else
+    {
+        btm_ble_adv_dedup_unlink(p_dedup, p_ent);
+
+        /* measured from the last forwarded RSSI, so that an RSSI hovering
+        ** around a value is not reported on every small swing */
+        rssi_delta = (int)rssi - p_ent->rssi;
+
+        if (p_ent->payload_hash != payload_hash)
+            p_dedup->stats.payload_changed++;
+        else if (rssi_delta >= BTM_BLE_ADV_DEDUP_RSSI_STEP ||
+                 rssi_delta <= -BTM_BLE_ADV_DEDUP_RSSI_STEP)
+            p_dedup->stats.rssi_changed++;
+        else if ((UINT32)(now_ms - p_ent->report_ms) >= BTM_BLE_ADV_DEDUP_REFRESH_MS)
+            p_dedup->stats.refreshed++;
+        else
+        {
+            btm_ble_adv_dedup_link(p_dedup, p_ent);
+            p_dedup->stats.suppressed++;
+            return FALSE;
+        }
+    }
+
+    p_ent->payload_hash = payload_hash;
+    p_ent->rssi = rssi;
+    p_ent->report_ms = now_ms;
+    btm_ble_adv_dedup_link(p_dedup, p_ent);
+    p_dedup->stats.forwarded++;
+    return TRUE;
+}
+
 /*******************************************************************************
 **
 ** Function         btm_ble_process_adv_pkt_cont
@@ -3167,7 +3395,7 @@ static void btm_ble_process_adv_pkt_cont(BD_ADDR bda, UINT8 addr_type, UINT16 ev
     }
     p_le_inq_cb = &p_i->inq_info.results.inq_data;
 
-    p_i->time_of_resp = time_get_os_boottime_ms();
+    btm_inq_db_touch(p_i);
 
     /* update the LE device information in inquiry database */
     if (!btm_ble_update_inq_result(p_i, addr_type, evt_type, p, extended))
@@ -3224,7 +3452,9 @@ static void btm_ble_process_adv_pkt_cont(BD_ADDR bda, UINT8 addr_type, UINT16 ev
         {
             (p_inq_results_cb)((tBTM_INQ_RESULTS *) &p_i->inq_info.results, p_le_inq_cb->adv_data_cache);
         }
-        if (p_obs_results_cb && (result & BTM_BLE_OBS_RESULT))
+        if (p_obs_results_cb && (result & BTM_BLE_OBS_RESULT) &&
+            btm_ble_adv_dedup_check(bda, addr_type, evt_type, p_i->inq_info.results.rssi,
+                                    p_le_inq_cb->adv_data_cache, p_le_inq_cb->adv_len))
         {
             (p_obs_results_cb)((tBTM_INQ_RESULTS *) &p_i->inq_info.results, p_le_inq_cb->adv_data_cache);
         }
@@ -3777,6 +4007,9 @@ void btm_ble_init(void)
 
     alarm_free(p_cb->observer_timer);
     alarm_free(p_cb->inq_var.fast_adv_timer);
+#if (BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE)
+    btm_ble_rpa_cache_flush();
+#endif
     memset(p_cb, 0, sizeof(tBTM_BLE_CB));
     memset(&(btm_cb.cmn_ble_vsc_cb), 0 , sizeof(tBTM_BLE_VSC_CB));
     btm_cb.cmn_ble_vsc_cb.values_read = FALSE;
@@ -3805,6 +4038,8 @@ void btm_ble_init(void)
     p_cb->addr_mgnt_cb.refresh_raddr_timer =
         alarm_new("btm_ble_addr.refresh_raddr_timer");
 
+    p_cb->adv_dedup.enabled = BTM_BLE_ADV_DEDUP_ENABLED;
+
 #if BLE_VND_INCLUDED == FALSE
     btm_ble_adv_filter_init();
 #endif
@@ -194,6 +194,76 @@ typedef struct
     BOOLEAN                     extended;
 } tBTM_LE_RANDOM_CB;
 
+#if SMP_INCLUDED == TRUE
+/* A peer keeps its RPA for at least the address refresh interval */
+#define BTM_BLE_RPA_CACHE_TTL_MS        BTM_BLE_PRIVATE_ADDR_INT_MS
+
+/* the record list may briefly hold one record above the limit */
+#define BTM_BLE_RPA_MAX_IRK             (BTM_SEC_MAX_DEVICE_RECORDS + 1)
+
+typedef struct
+{
+    BD_ADDR             rpa;
+    void                *p_dev_rec;     /* NULL: no bonded IRK resolves rpa */
+    UINT32              expire_ms;
+    BOOLEAN             in_use;
+} tBTM_BLE_RPA_CACHE_ENTRY;
+
+/* resolvable private address cache */
+typedef struct
+{
+    tBTM_BLE_RPA_CACHE_ENTRY    entry[BTM_BLE_RPA_CACHE_SIZE];
+    UINT16                      next_entry;     /* round robin replacement */
+
+    /* expanded IRKs of all records holding a peer identity key */
+    BOOLEAN                     irk_valid;
+    UINT16                      num_irk;
+    void                        *irk_rec[BTM_BLE_RPA_MAX_IRK];  /* tBTM_SEC_DEV_REC */
+    tSMP_KEY_SCHED              *irk_sched[BTM_BLE_RPA_MAX_IRK];
+
+    UINT32                      hit;
+    UINT32                      neg_hit;
+    UINT32                      miss;
+    UINT32                      aes_ops;
+} tBTM_BLE_RPA_CACHE;
+#endif
+
+/* must be a power of two */
+#define BTM_BLE_ADV_DEDUP_HASH_SIZE     128
+
+/* client interfaces that can ask for raw reports, one bit each */
+#define BTM_BLE_ADV_DEDUP_MAX_RAW_CLIENTS   32
+
+/* one entry per advertiser address and event type, so that the advertising
+** and scan response reports of an advertiser are tracked separately */
+typedef struct t_btm_ble_adv_dedup_ent
+{
+    BD_ADDR             bd_addr;
+    UINT16              evt_type;
+    UINT32              payload_hash;   /* address type and data */
+    UINT32              report_ms;      /* last time the report was forwarded */
+    INT8                rssi;           /* RSSI of the last forwarded report */
+    BOOLEAN             in_use;
+
+    struct t_btm_ble_adv_dedup_ent *p_hash_next;
+    struct t_btm_ble_adv_dedup_ent *p_lru_prev;
+    struct t_btm_ble_adv_dedup_ent *p_lru_next;
+} tBTM_BLE_ADV_DEDUP_ENT;
+
+/* advertising report duplicate suppression for observers */
+typedef struct
+{
+    tBTM_BLE_ADV_DEDUP_ENT      entry[BTM_BLE_ADV_DEDUP_SIZE];
+    UINT16                      num_used;
+    tBTM_BLE_ADV_DEDUP_ENT      *hash[BTM_BLE_ADV_DEDUP_HASH_SIZE];
+    tBTM_BLE_ADV_DEDUP_ENT      *p_oldest;      /* least recently heard, recycled when full */
+    tBTM_BLE_ADV_DEDUP_ENT      *p_newest;
+
+    BOOLEAN                     enabled;        /* BTM_BLE_ADV_DEDUP_ENABLED */
+    UINT32                      raw_clients;    /* bit (client_if - 1): wants every report */
+    tBTM_BLE_ADV_DEDUP_STATS    stats;
+} tBTM_BLE_ADV_DEDUP;
+
 #define BTM_BLE_MAX_BG_CONN_DEV_NUM    10
 
 typedef struct
@@ -324,6 +394,7 @@ typedef struct
     tBTM_INQ_RESULTS_CB *p_obs_results_cb;
     tBTM_CMPL_CB *p_obs_cmpl_cb;
     alarm_t *observer_timer;
+    tBTM_BLE_ADV_DEDUP adv_dedup;
 
     /* background connection procedure cb value */
     tBTM_BLE_CONN_TYPE bg_conn_type;
@@ -341,6 +412,10 @@ typedef struct
     /* random address management control block */
     tBTM_LE_RANDOM_CB addr_mgnt_cb;
 
+#if SMP_INCLUDED == TRUE
+    tBTM_BLE_RPA_CACHE rpa_cache;
+#endif
+
     BOOLEAN enabled;
 
 #if BLE_PRIVACY_SPT == TRUE
@@ -479,7 +554,6 @@ extern void btm_ble_resolving_list_cleanup(void);
 
 #if (defined BLE_EXTENDED_ADV_SUPPORT && BLE_EXTENDED_ADV_SUPPORT == TRUE)
 extern void btm_ble_read_inst_length_complete (UINT8* p, UINT16 evt_len);
-extern void btm_ble_adv_extension_operation_complete (UINT8* p, UINT16 hcidm);
 extern void btm_ble_adv_set_terminated_evt (UINT8* p);
 extern void btm_ble_multi_adv_enable_all(UINT8 enable);
 extern void btm_ble_scan_timeout_evt(void);
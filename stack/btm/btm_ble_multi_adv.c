@@ -43,7 +43,6 @@
 #define BTM_BLE_EXTENDED_ADV_TIMEOUT                    0x3C
 
 #define BTM_BLE_MULTI_ADV_CB_EVT_MASK   0xF0
-#define BTM_BLE_MULTI_ADV_SUBCODE_MASK  0x0F
 
 #ifdef WIPOWER_SUPPORTED
 #define WIPOWER_16_UUID_LSB 0xFE
@@ -74,9 +73,7 @@ extern void btm_ble_update_dmt_flag_bits(UINT8 *flag_value,
 
 static inline BOOLEAN is_btm_multi_adv_cb_valid()
 {
-    if (!btm_multi_adv_cb.p_adv_inst ||
-        !btm_multi_adv_cb.op_q.p_sub_code ||
-        !btm_multi_adv_cb.op_q.p_inst_id)
+    if (!btm_multi_adv_cb.p_adv_inst)
         return FALSE;
     else
         return TRUE;
@@ -89,52 +86,27 @@ static tBTM_STATUS btm_ble_extended_adv_set_params (tBTM_BLE_MULTI_ADV_INST *p_i
                                              tBTM_BLE_ADV_PARAMS *p_params,
                                              UINT8 cb_evt);
 static tBTM_STATUS btm_ble_enable_extended_adv (BOOLEAN enable, UINT8 inst_id, UINT16 duration, UINT8 max_ext_adv_evts, UINT8 cb_evt);
+static void btm_ble_adv_extension_operation_complete(tBTM_VSC_CMPL *p_params, UINT8 cb_evt,
+                                                     UINT32 ref, void *p_ref);
 #endif
 
-/*******************************************************************************
-**
-** Function         btm_ble_multi_adv_enq_op_q
-**
-** Description      enqueue a multi adv operation in q to check command complete
-**                  status.
-**
-** Returns          void
-**
-*******************************************************************************/
-void btm_ble_multi_adv_enq_op_q(UINT8 opcode, UINT8 inst_id, UINT8 cb_evt)
-{
-    UINT8 max_adv_instance = BTM_BleMaxMultiAdvInstanceCount();
-    tBTM_BLE_MULTI_ADV_OPQ  *p_op_q = &btm_multi_adv_cb.op_q;
-
-    p_op_q->p_inst_id[p_op_q->next_idx] = inst_id;
-
-    p_op_q->p_sub_code[p_op_q->next_idx] = (opcode |(cb_evt << 4));
-
-    if (max_adv_instance > 0)
-       p_op_q->next_idx = (p_op_q->next_idx + 1) %  max_adv_instance;
-}
+void btm_ble_multi_adv_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params, UINT8 cb_evt, UINT32 ref,
+                                       void *p_ref);
 
 /*******************************************************************************
 **
-** Function         btm_ble_multi_adv_deq_op_q
+** Function         btm_ble_multi_adv_send
 **
-** Description      dequeue a multi adv operation from q when command complete
-**                  is received.
+** Description      send a multi adv VSC; the completion is reported to
+**                  btm_ble_multi_adv_vsc_cmpl_cback with inst_id and cb_evt.
 **
-** Returns          void
+** Returns          BTM_CMD_STARTED if the command was issued, error otherwise
 **
 *******************************************************************************/
-void btm_ble_multi_adv_deq_op_q(UINT8 *p_opcode, UINT8 *p_inst_id, UINT8 *p_cb_evt)
+static tBTM_STATUS btm_ble_multi_adv_send(UINT8 len, UINT8 *param, UINT8 inst_id, UINT8 cb_evt)
 {
-    UINT8 max_adv_instance = BTM_BleMaxMultiAdvInstanceCount();
-    tBTM_BLE_MULTI_ADV_OPQ  *p_op_q = &btm_multi_adv_cb.op_q;
-
-    *p_inst_id = p_op_q->p_inst_id[p_op_q->pending_idx] & 0x7F;
-    *p_cb_evt = (p_op_q->p_sub_code[p_op_q->pending_idx] >> 4);
-    *p_opcode = (p_op_q->p_sub_code[p_op_q->pending_idx] & BTM_BLE_MULTI_ADV_SUBCODE_MASK);
-
-    if (max_adv_instance > 0)
-       p_op_q->pending_idx = (p_op_q->pending_idx + 1) % max_adv_instance;
+    return btm_hci_txn_vsc(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_MULTI_ADV_OCF, len, param,
+                           btm_ble_multi_adv_vsc_cmpl_cback, cb_evt, inst_id, NULL);
 }
 
 /*******************************************************************************
@@ -148,13 +120,13 @@ void btm_ble_multi_adv_deq_op_q(UINT8 *p_opcode, UINT8 *p_inst_id, UINT8 *p_cb_e
 ** Returns          void
 **
 *******************************************************************************/
-void btm_ble_multi_adv_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params)
+void btm_ble_multi_adv_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params, UINT8 cb_evt, UINT32 ref,
+                                       void *p_ref)
 {
     UINT8  status, subcode;
-    UINT8  *p = p_params->p_param_buf, inst_id;
+    UINT8  *p = p_params->p_param_buf, inst_id = (UINT8)ref;
     UINT16  len = p_params->param_len;
     tBTM_BLE_MULTI_ADV_INST *p_inst ;
-    UINT8   cb_evt = 0, opcode;
 
     if (!controller_get_interface()->get_is_ready())
     {
@@ -174,13 +146,12 @@ void btm_ble_multi_adv_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params)
     pthread_mutex_lock(&btm_multi_adv_lock);
     if (!is_btm_multi_adv_cb_valid())
         goto error;
-    btm_ble_multi_adv_deq_op_q(&opcode, &inst_id, &cb_evt);
 
-    BTM_TRACE_DEBUG("op_code = %02x inst_id = %d cb_evt = %02x", opcode, inst_id, cb_evt);
+    BTM_TRACE_DEBUG("op_code = %02x inst_id = %d cb_evt = %02x", subcode, inst_id, cb_evt);
 
-    if (opcode != subcode || inst_id == 0)
+    if (inst_id == 0 || inst_id > BTM_BleMaxMultiAdvInstanceCount())
     {
-        BTM_TRACE_ERROR("get unexpected VSC cmpl, expect: %d get: %d",subcode,opcode);
+        BTM_TRACE_ERROR("get VSC cmpl for invalid instance: %d", inst_id);
         goto error;
     }
 
@@ -263,14 +234,7 @@ tBTM_STATUS btm_ble_enable_multi_adv (BOOLEAN enable, UINT8 inst_id, UINT8 cb_ev
 
     BTM_TRACE_EVENT (" btm_ble_enable_multi_adv: enb %d, Inst ID %d",enb,inst_id);
 
-    if ((rt = BTM_VendorSpecificCommand (HCI_BLE_MULTI_ADV_OCF,
-                                    BTM_BLE_MULTI_ADV_ENB_LEN,
-                                    param,
-                                    btm_ble_multi_adv_vsc_cmpl_cback))
-                                     == BTM_CMD_STARTED)
-    {
-        btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_ENB, inst_id, cb_evt);
-    }
+    rt = btm_ble_multi_adv_send(BTM_BLE_MULTI_ADV_ENB_LEN, param, inst_id, cb_evt);
     return rt;
 }
 /*******************************************************************************
@@ -355,11 +319,8 @@ tBTM_STATUS btm_ble_multi_adv_set_params (tBTM_BLE_MULTI_ADV_INST *p_inst,
     BTM_TRACE_EVENT("set_params:Chnl Map %d,adv_fltr policy %d,ID:%d, TX Power%d",
         p_params->channel_map,p_params->adv_filter_policy,p_inst->inst_id,p_params->tx_power);
 
-    if ((rt = BTM_VendorSpecificCommand (HCI_BLE_MULTI_ADV_OCF,
-                                    BTM_BLE_MULTI_ADV_SET_PARAM_LEN,
-                                    param,
-                                    btm_ble_multi_adv_vsc_cmpl_cback))
-           == BTM_CMD_STARTED)
+    if ((rt = btm_ble_multi_adv_send(BTM_BLE_MULTI_ADV_SET_PARAM_LEN, param,
+                                     p_inst->inst_id, cb_evt)) == BTM_CMD_STARTED)
     {
         p_inst->adv_evt = p_params->adv_type;
 
@@ -371,7 +332,6 @@ tBTM_STATUS btm_ble_multi_adv_set_params (tBTM_BLE_MULTI_ADV_INST *p_inst,
                                btu_general_alarm_queue);
         }
 #endif
-        btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_SET_PARAM, p_inst->inst_id, cb_evt);
     }
     return rt;
 }
@@ -411,10 +371,8 @@ tBTM_STATUS btm_ble_multi_adv_write_rpa (tBTM_BLE_MULTI_ADV_INST *p_inst, BD_ADD
         UINT8_TO_STREAM (pp, BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR);
         BDADDR_TO_STREAM(pp, random_addr);
         UINT8_TO_STREAM(pp,  p_inst->inst_id);
-        rt = BTM_VendorSpecificCommand (HCI_BLE_MULTI_ADV_OCF,
-                                    BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR_LEN,
-                                    param,
-                                    btm_ble_multi_adv_vsc_cmpl_cback);
+        rt = btm_ble_multi_adv_send(BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR_LEN, param,
+                                    p_inst->inst_id, 0);
     }
 
 
@@ -426,8 +384,6 @@ tBTM_STATUS btm_ble_multi_adv_write_rpa (tBTM_BLE_MULTI_ADV_INST *p_inst, BD_ADD
                            BTM_BLE_PRIVATE_ADDR_INT_MS,
                            btm_ble_adv_raddr_timer_timeout, p_inst,
                            btu_general_alarm_queue);
-        btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR,
-                                   p_inst->inst_id, 0);
     }
     return rt;
 }
@@ -680,6 +636,7 @@ tBTM_STATUS BTM_BleEnableAdvInstance (tBTM_BLE_ADV_PARAMS *p_params,
         return BTM_ERR_PROCESSING;
     }
 
+    btm_hci_txn_begin(BTM_HCI_TXN_MULTI_ADV);
     for (i = 0; i <  BTM_BleMaxMultiAdvInstanceCount() - 1; i ++, p_inst++)
     {
         if (FALSE == p_inst->in_use)
@@ -737,6 +694,7 @@ tBTM_STATUS BTM_BleEnableAdvInstance (tBTM_BLE_ADV_PARAMS *p_params,
             break;
         }
     }
+    btm_hci_txn_end(BTM_HCI_TXN_MULTI_ADV);
     return rt;
 }
 
@@ -777,6 +735,8 @@ tBTM_STATUS BTM_BleUpdateAdvInstParam (UINT8 inst_id, tBTM_BLE_ADV_PARAMS *p_par
             return BTM_WRONG_MODE;
         }
         else {
+            /* disable, set params and re-enable form one transaction */
+            btm_hci_txn_begin(BTM_HCI_TXN_MULTI_ADV);
 #if (defined BLE_EXTENDED_ADV_SUPPORT && (BLE_EXTENDED_ADV_SUPPORT == TRUE))
             if (controller_get_interface()->supports_ble_extended_advertisements())
                 btm_ble_enable_extended_adv(FALSE, inst_id, 0, 0/*p_params->max_ext_adv_evts*/, 0);
@@ -809,6 +769,7 @@ tBTM_STATUS BTM_BleUpdateAdvInstParam (UINT8 inst_id, tBTM_BLE_ADV_PARAMS *p_par
                 rt = btm_ble_enable_multi_adv(TRUE, inst_id, cb_evt);
             }
         }
+        btm_hci_txn_end(BTM_HCI_TXN_MULTI_ADV);
     }
     return rt;
 }
@@ -877,14 +838,8 @@ tBTM_STATUS BTM_BleCfgAdvInstData (UINT8 inst_id, BOOLEAN is_scan_rsp,
     }
 #endif
 
-    if ((rt = BTM_VendorSpecificCommand (HCI_BLE_MULTI_ADV_OCF,
-                                    (UINT8)BTM_BLE_MULTI_ADV_WRITE_DATA_LEN,
-                                    param,
-                                    btm_ble_multi_adv_vsc_cmpl_cback))
-                                     == BTM_CMD_STARTED)
-    {
-        btm_ble_multi_adv_enq_op_q(sub_code, inst_id, BTM_BLE_MULTI_ADV_DATA_EVT);
-    }
+    rt = btm_ble_multi_adv_send((UINT8)BTM_BLE_MULTI_ADV_WRITE_DATA_LEN, param,
+                                inst_id, BTM_BLE_MULTI_ADV_DATA_EVT);
     return rt;
 }
 
@@ -1031,12 +986,6 @@ void btm_ble_multi_adv_init(UINT8 max_adv_inst)
         btm_multi_adv_cb.p_adv_inst = osi_calloc(sizeof(tBTM_BLE_MULTI_ADV_INST) *
                                                  (max_adv_inst));
 
-        btm_multi_adv_cb.op_q.p_sub_code = osi_calloc(sizeof(UINT8) *
-                                                      (max_adv_inst));
-
-        btm_multi_adv_cb.op_q.p_inst_id = osi_calloc(sizeof(UINT8) *
-                                                     (max_adv_inst));
-
         btm_ble_ext_enable_cb.set_ids = osi_calloc(sizeof(UINT8) * max_adv_inst);
 
         btm_ble_ext_enable_cb.durations = osi_calloc(sizeof(UINT16) * max_adv_inst);
@@ -1078,6 +1027,8 @@ void btm_ble_multi_adv_cleanup(void)
     wipower_inst_id = BTM_BLE_MULTI_ADV_DEFAULT_STD;
 #endif
 
+    btm_hci_txn_flush(BTM_HCI_TXN_MULTI_ADV);
+
     pthread_mutex_lock(&btm_multi_adv_lock);
     if (btm_multi_adv_cb.p_adv_inst) {
         for (size_t i = 0; i < btm_cb.cmn_ble_vsc_cb.adv_inst_max; i++) {
@@ -1086,9 +1037,6 @@ void btm_ble_multi_adv_cleanup(void)
         osi_free_and_reset((void **)&btm_multi_adv_cb.p_adv_inst);
     }
 
-    osi_free_and_reset((void **)&btm_multi_adv_cb.op_q.p_sub_code);
-    osi_free_and_reset((void **)&btm_multi_adv_cb.op_q.p_inst_id);
-    osi_free_and_reset((void **)&btm_multi_adv_cb.op_q.p_inst_id);
     osi_free_and_reset((void **)&btm_ble_ext_enable_cb.set_ids);
     osi_free_and_reset((void **)&btm_ble_ext_enable_cb.durations);
     osi_free_and_reset((void **)&btm_ble_ext_enable_cb.max_adv_events);
@@ -1144,16 +1092,23 @@ tBTM_STATUS btm_ble_enable_extended_adv (BOOLEAN enable, UINT8 inst_id, UINT16 d
     inst_id = inst_id - 1;
     duration = duration * 100; //duration is interpreted as t*10msec
 
-    if ((rt = btsnd_hcic_ble_set_extended_adv_enable (enb,
+    /* Tracked first, so that a command is never sent without its completion
+    ** being routed */
+    if ((rt = btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_WRITE_EXTENDED_ADV_ENABLE,
+                                btm_ble_adv_extension_operation_complete, cb_evt,
+                                inst_id + 1, NULL)) != BTM_CMD_STARTED)
+        return rt;
+
+    if (!btsnd_hcic_ble_set_extended_adv_enable (enb,
                                     1, //Num of sets
                                     &inst_id,
                                     &duration,
                                     &max_ext_adv_evts))
-                                    == BTM_CMD_STARTED)
     {
-        btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_ENB, inst_id + 1, cb_evt);
+        btm_hci_txn_cancel(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_WRITE_EXTENDED_ADV_ENABLE);
+        return BTM_NO_RESOURCES;
     }
-    return rt;
+    return BTM_CMD_STARTED;
 }
 
 /*******************************************************************************
@@ -1321,20 +1276,24 @@ tBTM_STATUS btm_ble_extended_adv_set_params (tBTM_BLE_MULTI_ADV_INST *p_inst,
     BTM_TRACE_ERROR ("%s: evt_prop::%d, primary_phy=%d,p_params->sec_adv_max_skip=%d, p_params->sec_adv_phy=%d, p_params->adv_sid=%d, p_params->scan_req_notf_enb=%d", __func__,
                     evt_prop, pri_phy, sec_adv_max_skip, sec_adv_phy, adv_sid, scan_req_notf_enb);
 
-    rt = btsnd_hcic_ble_set_extended_adv_params (set_id - 1, evt_prop,
+    if ((rt = btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_WRITE_EXTENDED_ADV_PARAMS,
+                                btm_ble_adv_extension_operation_complete, cb_evt,
+                                set_id, NULL)) != BTM_CMD_STARTED)
+        return rt;
+
+    if (!btsnd_hcic_ble_set_extended_adv_params (set_id - 1, evt_prop,
                                                  adv_int_min, adv_int_max,
                                                  channel_map, own_addr_type,
                                                  dir_addr_type, p_inst->rpa,
                                                  adv_filter_policy, btm_ble_map_adv_tx_power(tx_power),
                                                  pri_phy, sec_adv_max_skip,
-                                                 sec_adv_phy, adv_sid, scan_req_notf_enb);
-
-    if (rt == BTM_CMD_STARTED)
+                                                 sec_adv_phy, adv_sid, scan_req_notf_enb))
     {
-        btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_SET_PARAM, set_id, cb_evt);
+        btm_hci_txn_cancel(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_WRITE_EXTENDED_ADV_PARAMS);
+        return BTM_NO_RESOURCES;
     }
 
-    return rt;
+    return BTM_CMD_STARTED;
 }
 
 /*******************************************************************************
@@ -1361,31 +1320,38 @@ tBTM_STATUS btm_ble_extended_adv_set_params (tBTM_BLE_MULTI_ADV_INST *p_inst,
 tBTM_STATUS btm_ble_send_ext_adv_data (BOOLEAN is_scan_rsp, UINT8 inst_id, UINT8 operation, UINT8 frag_pref, UINT8 data_len, UINT8 *param)
 {
     tBTM_STATUS rt;
-    UINT8 sub_code;
+    BOOLEAN sent;
+    UINT16 hcicmd = is_scan_rsp ? HCI_BLE_WRITE_EXTENDED_SCAN_RSP_DATA :
+                                  HCI_BLE_WRITE_EXTENDED_ADV_DATA;
+
+    if ((rt = btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, hcicmd,
+                                btm_ble_adv_extension_operation_complete,
+                                BTM_BLE_MULTI_ADV_DATA_EVT, inst_id, NULL)) != BTM_CMD_STARTED)
+        return rt;
+
     if (!is_scan_rsp)
     {
-        rt = btsnd_hcic_ble_set_extended_adv_data(inst_id - 1,
+        sent = btsnd_hcic_ble_set_extended_adv_data(inst_id - 1,
                                     operation,
                                     frag_pref,
                                     data_len,
                                     param);
-        sub_code = BTM_BLE_MULTI_ADV_WRITE_ADV_DATA;
     }
     else
     {
-        rt = btsnd_hcic_ble_set_extended_scan_rsp_data(inst_id - 1,
+        sent = btsnd_hcic_ble_set_extended_scan_rsp_data(inst_id - 1,
                                     operation,
                                     frag_pref,
                                     data_len,
                                     param);
-        sub_code = BTM_BLE_MULTI_ADV_WRITE_SCAN_RSP_DATA;
     }
 
-    if (rt == BTM_CMD_STARTED)
+    if (!sent)
     {
-        btm_ble_multi_adv_enq_op_q(sub_code, inst_id, BTM_BLE_MULTI_ADV_DATA_EVT);
+        btm_hci_txn_cancel(BTM_HCI_TXN_MULTI_ADV, hcicmd);
+        return BTM_NO_RESOURCES;
     }
-    return rt;
+    return BTM_CMD_STARTED;
 }
 
 
@@ -1542,6 +1508,8 @@ tBTM_STATUS BTM_BleWriteExtendedAdvData (UINT8 inst_id, BOOLEAN is_scan_rsp,
 
     if(num_hci_cmds > 0)
     {
+        btm_hci_txn_begin(BTM_HCI_TXN_MULTI_ADV);
+
         //Disable advertisement
         rt = btm_ble_enable_extended_adv (FALSE, inst_id,
                                          p_inst->duration, 0/*p_params->max_ext_adv_evts*/,
@@ -1578,6 +1546,7 @@ tBTM_STATUS BTM_BleWriteExtendedAdvData (UINT8 inst_id, BOOLEAN is_scan_rsp,
         {
             rt = btm_ble_enable_extended_adv (TRUE, p_inst->inst_id, p_inst->duration, 0, 0/*instead of BTM_BLE_EXTENDED_ADV_ENB_EVT*/);
         }
+        btm_hci_txn_end(BTM_HCI_TXN_MULTI_ADV);
     }
     else
         rt = btm_ble_send_ext_adv_data(is_scan_rsp, inst_id, operation, frag_pref, data_len, param);
@@ -1652,22 +1621,26 @@ void btm_ble_multi_adv_enable_all(UINT8 enable)
 
     if (!enable)
     {
-       if (btsnd_hcic_ble_set_extended_adv_enable(enb, 0, NULL, NULL, NULL)
-                                                   == BTM_CMD_STARTED)
+       if (btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_WRITE_EXTENDED_ADV_ENABLE,
+                             btm_ble_adv_extension_operation_complete, 0, 1, NULL)
+                             == BTM_CMD_STARTED &&
+           !btsnd_hcic_ble_set_extended_adv_enable(enb, 0, NULL, NULL, NULL))
        {
-           btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_ENB, 1, 0);
+           btm_hci_txn_cancel(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_WRITE_EXTENDED_ADV_ENABLE);
        }
     }
     else
     {
-        if ((btsnd_hcic_ble_set_extended_adv_enable (enb,
+        if (btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_WRITE_EXTENDED_ADV_ENABLE,
+                              btm_ble_adv_extension_operation_complete, 0, 1, NULL)
+                              == BTM_CMD_STARTED &&
+            !btsnd_hcic_ble_set_extended_adv_enable (enb,
                                     num_instances,
                                     btm_ble_ext_enable_cb.set_ids,
                                     btm_ble_ext_enable_cb.durations,
                                     btm_ble_ext_enable_cb.max_adv_events))
-                                    == BTM_CMD_STARTED)
         {
-            btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_ENB, 1, 0);
+            btm_hci_txn_cancel(BTM_HCI_TXN_MULTI_ADV, HCI_BLE_WRITE_EXTENDED_ADV_ENABLE);
         }
     }
 }
@@ -1730,22 +1703,24 @@ void btm_ble_adv_set_terminated_evt (UINT8* p)
 ** Function         btm_ble_adv_extension_operation_complete
 **
 ** Description      This function is a callback event of adv extension operation
-**                  including write rpa, set adv data/scan rsp data
+**                  including set adv params, enable, set adv data/scan rsp data
 **
 ** Returns          void
 **
 *******************************************************************************/
-
-void btm_ble_adv_extension_operation_complete(UINT8* p, UINT16 hcicmd)
+static void btm_ble_adv_extension_operation_complete(tBTM_VSC_CMPL *p_params, UINT8 cb_evt,
+                                                     UINT32 ref, void *p_ref)
 {
     UINT8 status;
-    UINT8 cb_evt = 0, opcode;
-    UINT8 subcode = 0;
-    UINT8 inst_id;
+    UINT8 *p = p_params->p_param_buf;
+    UINT8 inst_id = (UINT8)ref;
     tBTM_BLE_MULTI_ADV_INST *p_inst ;
+
+    if (p_params->param_len < 1)
+        return;
     STREAM_TO_UINT8 (status, p);
 
-    BTM_TRACE_EVENT ("%s, status: %d, opcode = %d", __func__, status, hcicmd);
+    BTM_TRACE_EVENT ("%s, status: %d, opcode = %d", __func__, status, p_params->opcode);
 
     if (status != HCI_SUCCESS)
     {
@@ -1753,30 +1728,10 @@ void btm_ble_adv_extension_operation_complete(UINT8* p, UINT16 hcicmd)
         return;
     }
 
-    btm_ble_multi_adv_deq_op_q(&opcode, &inst_id, &cb_evt);
-
-    switch (hcicmd)
-    {
-        case HCI_BLE_WRITE_EXTENDED_ADV_RPA:
-            subcode = BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR;
-            break;
-        case HCI_BLE_WRITE_EXTENDED_ADV_DATA:
-            subcode = BTM_BLE_MULTI_ADV_WRITE_ADV_DATA;
-            break;
-        case HCI_BLE_WRITE_EXTENDED_SCAN_RSP_DATA:
-            subcode = BTM_BLE_MULTI_ADV_WRITE_SCAN_RSP_DATA;
-            break;
-        case HCI_BLE_WRITE_EXTENDED_ADV_PARAMS:
-            subcode = BTM_BLE_MULTI_ADV_SET_PARAM;
-            break;
-        case HCI_BLE_WRITE_EXTENDED_ADV_ENABLE:
-            subcode = BTM_BLE_MULTI_ADV_ENB;
-            break;
-    }
-
-    if (opcode != subcode)
+    if (!btm_multi_adv_cb.p_adv_inst || inst_id == 0 ||
+        inst_id > BTM_BleMaxMultiAdvInstanceCount())
     {
-        BTM_TRACE_ERROR("got unexpected Event, expected: %d got: %d", opcode, subcode);
+        BTM_TRACE_ERROR("%s: invalid instance %d", __func__, inst_id);
         return;
     }
     p_inst = &btm_multi_adv_cb.p_adv_inst[inst_id - 1];
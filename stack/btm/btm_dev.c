@@ -37,6 +37,8 @@
 #include "hcidefs.h"
 #include "l2c_api.h"
 
+static void btm_sec_dev_rec_remove(tBTM_SEC_DEV_REC *p_dev_rec);
+
 /*******************************************************************************
 **
 ** Function         BTM_SecAddDevice
@@ -70,6 +72,7 @@ BOOLEAN BTM_SecAddDevice (BD_ADDR bd_addr, DEV_CLASS dev_class, BD_NAME bd_name,
 
         memcpy (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
         p_dev_rec->hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_BR_EDR);
+        btm_sec_dev_rec_reindex(p_dev_rec);
 
 #if BLE_INCLUDED == TRUE
         /* use default value for background connection params */
@@ -78,7 +81,7 @@ BOOLEAN BTM_SecAddDevice (BD_ADDR bd_addr, DEV_CLASS dev_class, BD_NAME bd_name,
 #endif
     } else {
         /* "Bump" timestamp for existing record */
-        p_dev_rec->timestamp = btm_cb.dev_rec_count++;
+        btm_sec_dev_rec_touch(p_dev_rec);
 
         /* TODO(eisenbach):
          * Small refactor, but leaving original logic for now.
@@ -281,6 +284,7 @@ tBTM_SEC_DEV_REC *btm_sec_alloc_dev (BD_ADDR bd_addr)
     p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_LE);
 #endif
     p_dev_rec->hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_BR_EDR);
+    btm_sec_dev_rec_reindex(p_dev_rec);
 
     return(p_dev_rec);
 }
@@ -304,7 +308,7 @@ void btm_sec_free_dev (tBTM_SEC_DEV_REC *p_dev_rec)
     /* Clear out any saved BLE keys */
     btm_sec_clear_ble_keys (p_dev_rec);
 #endif
-    list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+    btm_sec_dev_rec_remove(p_dev_rec);
 }
 
 /*******************************************************************************
@@ -361,6 +365,236 @@ BOOLEAN btm_dev_support_switch (BD_ADDR bd_addr)
     return(FALSE);
 }
 
+/*******************************************************************************
+**  Security record index
+**
+**  btm_cb.sec_dev_rec keeps the records in allocation order. Each record is
+**  also chained into one hash table per indexed field (BTM_SEC_IDX_*) and
+**  into a list ordered by timestamp, so lookups and the choice of the record
+**  to recycle do not walk every record. When several records match a lookup
+**  the one allocated first is returned, as the scan of the list did.
+**
+**  Unset keys (all zero addresses, BTM_SEC_INVALID_HANDLE) are not indexed;
+**  lookups for them fall back to scanning the list.
+*******************************************************************************/
+
+static BOOLEAN btm_sec_dev_addr_is_zero(const UINT8 *p_addr)
+{
+    static const BD_ADDR zero_bda = {0};
+
+    return memcmp(p_addr, zero_bda, BD_ADDR_LEN) == 0;
+}
+
+static UINT16 btm_sec_dev_hash_addr(const UINT8 *p_addr)
+{
+    UINT32 h = ((UINT32)p_addr[2] << 24) | ((UINT32)p_addr[3] << 16) |
+               ((UINT32)p_addr[4] << 8) | p_addr[5];
+
+    h ^= ((UINT32)p_addr[0] << 8) | p_addr[1];
+    return (UINT16)(((h * 0x9E3779B1) >> 16) & (BTM_SEC_DEV_HASH_SIZE - 1));
+}
+
+static UINT16 btm_sec_dev_hash_handle(UINT16 handle)
+{
+    return (UINT16)((((UINT32)handle * 0x9E3779B1) >> 16) & (BTM_SEC_DEV_HASH_SIZE - 1));
+}
+
+/* address key of an address index, NULL for a handle index */
+static const UINT8 *btm_sec_dev_idx_addr(const tBTM_SEC_DEV_REC *p_dev_rec, int idx)
+{
+    switch (idx)
+    {
+        case BTM_SEC_IDX_ADDR:
+            return p_dev_rec->bd_addr;
+#if BLE_INCLUDED == TRUE
+        case BTM_SEC_IDX_PSEUDO:
+            return p_dev_rec->ble.pseudo_addr;
+        case BTM_SEC_IDX_STATIC:
+            return p_dev_rec->ble.static_addr;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+static UINT16 btm_sec_dev_idx_handle(const tBTM_SEC_DEV_REC *p_dev_rec, int idx)
+{
+#if BLE_INCLUDED == TRUE
+    if (idx == BTM_SEC_IDX_BLE_HANDLE)
+        return p_dev_rec->ble_hci_handle;
+#endif
+    return p_dev_rec->hci_handle;
+}
+
+/* bucket the record belongs in for an index, BTM_SEC_IDX_NONE if its key is unset */
+static UINT16 btm_sec_dev_idx_bucket(const tBTM_SEC_DEV_REC *p_dev_rec, int idx)
+{
+    const UINT8 *p_addr = btm_sec_dev_idx_addr(p_dev_rec, idx);
+    UINT16      handle;
+
+    if (p_addr)
+        return btm_sec_dev_addr_is_zero(p_addr) ? BTM_SEC_IDX_NONE : btm_sec_dev_hash_addr(p_addr);
+
+    handle = btm_sec_dev_idx_handle(p_dev_rec, idx);
+    return (handle == BTM_SEC_INVALID_HANDLE) ? BTM_SEC_IDX_NONE : btm_sec_dev_hash_handle(handle);
+}
+
+static void btm_sec_dev_idx_unlink(tBTM_SEC_DEV_REC *p_dev_rec, int idx)
+{
+    tBTM_SEC_DEV_REC **pp;
+
+    if (p_dev_rec->idx_bucket[idx] == BTM_SEC_IDX_NONE)
+        return;
+
+    for (pp = &btm_cb.sec_dev_idx[idx][p_dev_rec->idx_bucket[idx]]; *pp; pp = &(*pp)->p_idx_next[idx])
+    {
+        if (*pp == p_dev_rec)
+        {
+            *pp = p_dev_rec->p_idx_next[idx];
+            break;
+        }
+    }
+    p_dev_rec->p_idx_next[idx] = NULL;
+    p_dev_rec->idx_bucket[idx] = BTM_SEC_IDX_NONE;
+}
+
+static void btm_sec_dev_lru_unlink(tBTM_SEC_DEV_REC *p_dev_rec)
+{
+    if (p_dev_rec->p_lru_prev)
+        p_dev_rec->p_lru_prev->p_lru_next = p_dev_rec->p_lru_next;
+    else if (btm_cb.p_sec_dev_oldest == p_dev_rec)
+        btm_cb.p_sec_dev_oldest = p_dev_rec->p_lru_next;
+
+    if (p_dev_rec->p_lru_next)
+        p_dev_rec->p_lru_next->p_lru_prev = p_dev_rec->p_lru_prev;
+    else if (btm_cb.p_sec_dev_newest == p_dev_rec)
+        btm_cb.p_sec_dev_newest = p_dev_rec->p_lru_prev;
+
+    p_dev_rec->p_lru_prev = p_dev_rec->p_lru_next = NULL;
+}
+
+/* places the record by its timestamp, looking from the newest end */
+static void btm_sec_dev_lru_insert(tBTM_SEC_DEV_REC *p_dev_rec)
+{
+    tBTM_SEC_DEV_REC *p_prev = btm_cb.p_sec_dev_newest;
+
+    while (p_prev && p_prev->timestamp > p_dev_rec->timestamp)
+        p_prev = p_prev->p_lru_prev;
+
+    p_dev_rec->p_lru_prev = p_prev;
+    p_dev_rec->p_lru_next = p_prev ? p_prev->p_lru_next : btm_cb.p_sec_dev_oldest;
+
+    if (p_dev_rec->p_lru_next)
+        p_dev_rec->p_lru_next->p_lru_prev = p_dev_rec;
+    else
+        btm_cb.p_sec_dev_newest = p_dev_rec;
+
+    if (p_prev)
+        p_prev->p_lru_next = p_dev_rec;
+    else
+        btm_cb.p_sec_dev_oldest = p_dev_rec;
+}
+
+/*******************************************************************************
+**
+** Function         btm_sec_dev_rec_reindex
+**
+** Description      Files the record under the current values of its indexed
+**                  fields (bd_addr, hci_handle and, for LE, pseudo_addr,
+**                  static_addr and ble_hci_handle). Must be called after any
+**                  of them is changed.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_sec_dev_rec_reindex(tBTM_SEC_DEV_REC *p_dev_rec)
+{
+    for (int idx = 0; idx < BTM_SEC_IDX_MAX; idx++)
+    {
+        UINT16 bucket = btm_sec_dev_idx_bucket(p_dev_rec, idx);
+
+        /* lookups compare the field itself, same bucket needs no move */
+        if (bucket == p_dev_rec->idx_bucket[idx])
+            continue;
+
+        btm_sec_dev_idx_unlink(p_dev_rec, idx);
+        if (bucket != BTM_SEC_IDX_NONE)
+        {
+            p_dev_rec->p_idx_next[idx] = btm_cb.sec_dev_idx[idx][bucket];
+            btm_cb.sec_dev_idx[idx][bucket] = p_dev_rec;
+            p_dev_rec->idx_bucket[idx] = bucket;
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_sec_dev_rec_touch
+**
+** Description      Bumps the timestamp of the record, making it the last one
+**                  to be recycled when the database is full.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_sec_dev_rec_touch(tBTM_SEC_DEV_REC *p_dev_rec)
+{
+    p_dev_rec->timestamp = btm_cb.dev_rec_count++;
+    btm_sec_dev_lru_unlink(p_dev_rec);
+    btm_sec_dev_lru_insert(p_dev_rec);
+}
+
+/*******************************************************************************
+**
+** Function         btm_sec_dev_rec_remove
+**
+** Description      Takes the record out of the indexes and the database and
+**                  frees it.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_sec_dev_rec_remove(tBTM_SEC_DEV_REC *p_dev_rec)
+{
+    for (int idx = 0; idx < BTM_SEC_IDX_MAX; idx++)
+        btm_sec_dev_idx_unlink(p_dev_rec, idx);
+    btm_sec_dev_lru_unlink(p_dev_rec);
+
+    list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+#if (BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE)
+    btm_ble_rpa_cache_flush();
+#endif
+}
+
+/* earliest allocated record whose address key for idx is p_addr, or p_best */
+static tBTM_SEC_DEV_REC *btm_sec_dev_idx_find_addr(int idx, const UINT8 *p_addr,
+                                                   tBTM_SEC_DEV_REC *p_best)
+{
+    tBTM_SEC_DEV_REC *p_dev_rec = btm_cb.sec_dev_idx[idx][btm_sec_dev_hash_addr(p_addr)];
+
+    for (; p_dev_rec; p_dev_rec = p_dev_rec->p_idx_next[idx])
+    {
+        if (!memcmp(btm_sec_dev_idx_addr(p_dev_rec, idx), p_addr, BD_ADDR_LEN) &&
+            (!p_best || p_dev_rec->idx_seq < p_best->idx_seq))
+            p_best = p_dev_rec;
+    }
+    return p_best;
+}
+
+static tBTM_SEC_DEV_REC *btm_sec_dev_idx_find_handle(int idx, UINT16 handle,
+                                                     tBTM_SEC_DEV_REC *p_best)
+{
+    tBTM_SEC_DEV_REC *p_dev_rec = btm_cb.sec_dev_idx[idx][btm_sec_dev_hash_handle(handle)];
+
+    for (; p_dev_rec; p_dev_rec = p_dev_rec->p_idx_next[idx])
+    {
+        if (btm_sec_dev_idx_handle(p_dev_rec, idx) == handle &&
+            (!p_best || p_dev_rec->idx_seq < p_best->idx_seq))
+            p_best = p_dev_rec;
+    }
+    return p_best;
+}
+
 bool is_handle_equal(void *data, void *context)
 {
     tBTM_SEC_DEV_REC *p_dev_rec = data;
@@ -388,11 +622,19 @@ bool is_handle_equal(void *data, void *context)
 *******************************************************************************/
 tBTM_SEC_DEV_REC *btm_find_dev_by_handle (UINT16 handle)
 {
-    list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-    if (n)
-        return list_node(n);
+    tBTM_SEC_DEV_REC *p_dev_rec;
 
-    return NULL;
+    if (handle == BTM_SEC_INVALID_HANDLE)
+    {
+        list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
+        return n ? list_node(n) : NULL;
+    }
+
+    p_dev_rec = btm_sec_dev_idx_find_handle(BTM_SEC_IDX_HANDLE, handle, NULL);
+#if BLE_INCLUDED == TRUE
+    p_dev_rec = btm_sec_dev_idx_find_handle(BTM_SEC_IDX_BLE_HANDLE, handle, p_dev_rec);
+#endif
+    return p_dev_rec;
 }
 
 bool is_address_equal(void *data, void *context)
@@ -406,9 +648,6 @@ bool is_address_equal(void *data, void *context)
     // If a LE random address is looking for device record
     if (!memcmp(p_dev_rec->ble.pseudo_addr, *bd_addr, BD_ADDR_LEN))
         return false;
-
-    if (btm_ble_addr_resolvable(*bd_addr, p_dev_rec))
-        return false;
 #endif
     return true;
 }
@@ -425,16 +664,65 @@ bool is_address_equal(void *data, void *context)
 *******************************************************************************/
 tBTM_SEC_DEV_REC *btm_find_dev(const BD_ADDR bd_addr)
 {
+    tBTM_SEC_DEV_REC *p_dev_rec;
+
     if (!bd_addr)
         return NULL;
 
-    list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)bd_addr);
-    if (n)
-        return list_node(n);
+    if (btm_sec_dev_addr_is_zero(bd_addr))
+    {
+        list_node_t *n = list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)bd_addr);
+        return n ? list_node(n) : NULL;
+    }
+
+    p_dev_rec = btm_sec_dev_idx_find_addr(BTM_SEC_IDX_ADDR, bd_addr, NULL);
+#if BLE_INCLUDED == TRUE
+    p_dev_rec = btm_sec_dev_idx_find_addr(BTM_SEC_IDX_PSEUDO, bd_addr, p_dev_rec);
+#endif
+    if (p_dev_rec)
+        return p_dev_rec;
+
+#if BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE
+    /* not a known address, try the bonded IRKs */
+    p_dev_rec = btm_ble_rpa_cache_resolve(bd_addr);
+    if (p_dev_rec)
+    {
+        btm_ble_init_pseudo_addr(p_dev_rec, (UINT8 *)bd_addr);
+        return p_dev_rec;
+    }
+#endif
 
     return NULL;
 }
 
+#if BLE_INCLUDED == TRUE
+/*******************************************************************************
+**
+** Function         btm_find_dev_by_static_addr
+**
+** Description      Look for the record in the device database whose LE
+**                  identity (static) address is bd_addr
+**
+** Returns          Pointer to the record or NULL
+**
+*******************************************************************************/
+tBTM_SEC_DEV_REC *btm_find_dev_by_static_addr(const BD_ADDR bd_addr)
+{
+    if (btm_sec_dev_addr_is_zero(bd_addr))
+    {
+        list_node_t *end = list_end(btm_cb.sec_dev_rec);
+        for (list_node_t *node = list_begin(btm_cb.sec_dev_rec); node != end; node = list_next(node)) {
+            tBTM_SEC_DEV_REC *p_dev_rec = list_node(node);
+            if (!memcmp(p_dev_rec->ble.static_addr, bd_addr, BD_ADDR_LEN))
+                return p_dev_rec;
+        }
+        return NULL;
+    }
+
+    return btm_sec_dev_idx_find_addr(BTM_SEC_IDX_STATIC, bd_addr, NULL);
+}
+#endif
+
 /*******************************************************************************
 **
 ** Function         btm_consolidate_dev
@@ -452,14 +740,23 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC *p_target_rec)
     BTM_TRACE_DEBUG("%s", __func__);
 
     list_node_t *end = list_end(btm_cb.sec_dev_rec);
-    for (list_node_t *node = list_begin(btm_cb.sec_dev_rec); node != end; node = list_next(node)) {
+    list_node_t *next;
+    for (list_node_t *node = list_begin(btm_cb.sec_dev_rec); node != end; node = next) {
         tBTM_SEC_DEV_REC *p_dev_rec = list_node(node);
 
+        next = list_next(node);
         if (p_target_rec == p_dev_rec)
             continue;
 
         if (!memcmp (p_dev_rec->bd_addr, p_target_rec->bd_addr, BD_ADDR_LEN))
         {
+            UINT32 idx_seq = p_target_rec->idx_seq;
+
+            /* the copy below overwrites the index links */
+            for (int idx = 0; idx < BTM_SEC_IDX_MAX; idx++)
+                btm_sec_dev_idx_unlink(p_target_rec, idx);
+            btm_sec_dev_lru_unlink(p_target_rec);
+
             memcpy(p_target_rec, p_dev_rec, sizeof(tBTM_SEC_DEV_REC));
             p_target_rec->ble = temp_rec.ble;
             p_target_rec->ble_hci_handle = temp_rec.ble_hci_handle;
@@ -472,10 +769,18 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC *p_target_rec)
             p_target_rec->no_smp_on_br = temp_rec.no_smp_on_br;
             p_target_rec->bond_type = temp_rec.bond_type;
 
+            memset(p_target_rec->p_idx_next, 0, sizeof(p_target_rec->p_idx_next));
+            for (int idx = 0; idx < BTM_SEC_IDX_MAX; idx++)
+                p_target_rec->idx_bucket[idx] = BTM_SEC_IDX_NONE;
+            p_target_rec->idx_seq = idx_seq;
+            p_target_rec->p_lru_prev = p_target_rec->p_lru_next = NULL;
+
             /* remove the combined record */
-            list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+            btm_sec_dev_rec_remove(p_dev_rec);
 
-            p_dev_rec->bond_type = BOND_TYPE_UNKNOWN;
+            btm_sec_dev_rec_reindex(p_target_rec);
+            btm_sec_dev_lru_insert(p_target_rec);
+            continue;
         }
 
         /* an RPA device entry is a duplicate of the target record */
@@ -487,7 +792,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC *p_target_rec)
                 p_target_rec->device_type |= p_dev_rec->device_type;
 
                 /* remove the combined record */
-                list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+                btm_sec_dev_rec_remove(p_dev_rec);
             }
         }
     }
@@ -530,35 +835,17 @@ tBTM_SEC_DEV_REC *btm_find_or_alloc_dev (BD_ADDR bd_addr)
 *******************************************************************************/
 static tBTM_SEC_DEV_REC* btm_find_oldest_dev_rec (void)
 {
-    tBTM_SEC_DEV_REC *p_oldest = NULL;
-    UINT32       ts_oldest = 0xFFFFFFFF;
-    tBTM_SEC_DEV_REC *p_oldest_paired = NULL;
-    UINT32       ts_oldest_paired = 0xFFFFFFFF;
-
-    list_node_t *end = list_end(btm_cb.sec_dev_rec);
-    for (list_node_t *node = list_begin(btm_cb.sec_dev_rec); node != end; node = list_next(node)) {
-        tBTM_SEC_DEV_REC *p_dev_rec = list_node(node);
+    tBTM_SEC_DEV_REC *p_dev_rec;
 
-        if ((p_dev_rec->sec_flags & (BTM_SEC_LINK_KEY_KNOWN | BTM_SEC_LE_LINK_KEY_KNOWN)) == 0) {
-            // Device is not paired
-            if (p_dev_rec->timestamp < ts_oldest) {
-                p_oldest = p_dev_rec;
-                ts_oldest = p_dev_rec->timestamp;
-            }
-        } else {
-            // Paired device
-            if (p_dev_rec->timestamp < ts_oldest_paired) {
-                p_oldest_paired = p_dev_rec;
-                ts_oldest_paired = p_dev_rec->timestamp;
-            }
-        }
+    for (p_dev_rec = btm_cb.p_sec_dev_oldest; p_dev_rec; p_dev_rec = p_dev_rec->p_lru_next)
+    {
+        // Device is not paired
+        if ((p_dev_rec->sec_flags & (BTM_SEC_LINK_KEY_KNOWN | BTM_SEC_LE_LINK_KEY_KNOWN)) == 0)
+            return p_dev_rec;
     }
 
     // If we did not find any non-paired devices, use the oldest paired one...
-    if (ts_oldest == 0xFFFFFFFF)
-        p_oldest = p_oldest_paired;
-
-    return p_oldest;
+    return btm_cb.p_sec_dev_oldest;
 }
 
 /*******************************************************************************
@@ -580,7 +867,7 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void)
     if (list_length(btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS)
     {
         p_dev_rec = btm_find_oldest_dev_rec();
-        list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+        btm_sec_dev_rec_remove(p_dev_rec);
     }
 
     p_dev_rec = osi_calloc(sizeof(tBTM_SEC_DEV_REC));
@@ -590,6 +877,15 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void)
     p_dev_rec->sec_flags = BTM_SEC_IN_USE;
     p_dev_rec->bond_type = BOND_TYPE_UNKNOWN;
     p_dev_rec->timestamp = btm_cb.dev_rec_count++;
+    p_dev_rec->hci_handle = BTM_SEC_INVALID_HANDLE;
+#if BLE_INCLUDED == TRUE
+    p_dev_rec->ble_hci_handle = BTM_SEC_INVALID_HANDLE;
+#endif
+
+    for (int idx = 0; idx < BTM_SEC_IDX_MAX; idx++)
+        p_dev_rec->idx_bucket[idx] = BTM_SEC_IDX_NONE;
+    p_dev_rec->idx_seq = btm_cb.sec_dev_seq++;
+    btm_sec_dev_lru_insert(p_dev_rec);
 
     return p_dev_rec;
 }
@@ -163,6 +163,9 @@ static void reset_complete(void *result) {
   /* Clear current security state */
   list_foreach(btm_cb.sec_dev_rec, set_sec_state_idle, NULL);
 
+  /* Commands issued before the reset will not complete */
+  btm_hci_txn_reset();
+
   /* After the reset controller should restore all parameters to defaults. */
   btm_cb.btm_inq_vars.inq_counter       = 1;
   btm_cb.btm_inq_vars.inq_scan_window   = HCI_DEF_INQUIRYSCAN_WINDOW;
@@ -0,0 +1,727 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the HCI command transaction layer. Subsystems that
+ *  configure the controller with a burst of independent commands (APCF
+ *  filters, multi advertising) issue them here instead of keeping their own
+ *  ring of pending operations:
+ *
+ *  - Vendor specific commands are handed to HCI up to BTM_HCI_TXN_WINDOW at a
+ *    time; the rest are held with a copy of their parameters and issued as
+ *    completions come back. HCI still enforces the controller's credits.
+ *  - Completions are matched to the oldest outstanding command with the same
+ *    opcode and, for vendor specific commands, the same sub-opcode, so one
+ *    lost or failed completion does not shift every later one.
+ *  - Commands a client issues between btm_hci_txn_begin() and
+ *    btm_hci_txn_end() form a transaction; its latency is measured from the
+ *    first issue to the last completion.
+ *
+ ******************************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bt_utils.h"
+#include "btm_api.h"
+#include "btm_int.h"
+#include "hcidefs.h"
+#include "osi/include/allocator.h"
+#include "osi/include/time.h"
+
+#define BTM_HCI_TXN_NONE        0xFF
+
+#if (BTM_HCI_TXN_MAX_CMDS >= BTM_HCI_TXN_NONE)
+#error "BTM_HCI_TXN_MAX_CMDS must fit an 8-bit index"
+#endif
+
+typedef struct
+{
+    UINT16                  opcode;     /* full HCI opcode */
+    UINT8                   sub_opcode; /* first parameter of a vendor specific command */
+    BOOLEAN                 is_vsc;
+    BOOLEAN                 sent;       /* FALSE while held back by the window */
+    UINT8                   client;
+    UINT8                   txn;        /* index into txn[] */
+    UINT8                   evt;        /* returned to p_cback as given */
+    UINT32                  ref;
+    void                    *p_ref;
+    tBTM_HCI_TXN_CMPL_CBACK *p_cback;
+    UINT8                   param_len;
+    UINT8                   *p_param;   /* copy of the parameters while held */
+    UINT64                  sent_us;
+    UINT8                   next;       /* next command in issue order, or free list */
+} tBTM_HCI_TXN_CMD;
+
+typedef struct
+{
+    BOOLEAN     in_use;
+    UINT8       depth;      /* nested btm_hci_txn_begin() calls not yet ended */
+    UINT8       client;
+    UINT8       pending;    /* commands not completed yet */
+    UINT64      start_us;   /* first command issued */
+} tBTM_HCI_TXN;
+
+typedef struct
+{
+    tBTM_HCI_TXN_CMD    cmd[BTM_HCI_TXN_MAX_CMDS];
+    tBTM_HCI_TXN        txn[BTM_HCI_TXN_MAX_CMDS];
+    UINT8               head;       /* oldest command, queued or in flight */
+    UINT8               tail;
+    UINT8               free;
+    UINT8               in_flight;  /* vendor specific commands handed to HCI */
+    UINT8               held;       /* vendor specific commands waiting for the window */
+    UINT8               open_txn[BTM_HCI_TXN_MAX_CLIENTS];
+    UINT8               client_in_flight[BTM_HCI_TXN_MAX_CLIENTS];
+    tBTM_HCI_TXN_STATS  stats[BTM_HCI_TXN_MAX_CLIENTS];
+} tBTM_HCI_TXN_CB;
+
+static tBTM_HCI_TXN_CB btm_hci_txn_cb;
+static pthread_mutex_t btm_hci_txn_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void btm_hci_txn_vsc_cmpl(tBTM_VSC_CMPL *p_params);
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_init
+**
+** Description      Initializes the transaction layer. No command is pending
+**                  afterwards.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_hci_txn_init(void)
+{
+    UINT8 i;
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    for (i = 0; i < BTM_HCI_TXN_MAX_CMDS; i++)
+        osi_free(btm_hci_txn_cb.cmd[i].p_param);
+
+    memset(&btm_hci_txn_cb, 0, sizeof(tBTM_HCI_TXN_CB));
+    for (i = 0; i < BTM_HCI_TXN_MAX_CMDS; i++)
+        btm_hci_txn_cb.cmd[i].next = (i + 1 < BTM_HCI_TXN_MAX_CMDS) ? i + 1 : BTM_HCI_TXN_NONE;
+
+    btm_hci_txn_cb.head = BTM_HCI_TXN_NONE;
+    btm_hci_txn_cb.tail = BTM_HCI_TXN_NONE;
+    btm_hci_txn_cb.free = 0;
+    memset(btm_hci_txn_cb.open_txn, BTM_HCI_TXN_NONE, sizeof(btm_hci_txn_cb.open_txn));
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_alloc_txn
+**
+** Description      Allocates a transaction for client. Called with the lock held.
+**
+** Returns          index of the transaction, BTM_HCI_TXN_NONE if none is free
+**
+*******************************************************************************/
+static UINT8 btm_hci_txn_alloc_txn(UINT8 client)
+{
+    UINT8 i;
+
+    for (i = 0; i < BTM_HCI_TXN_MAX_CMDS; i++)
+    {
+        tBTM_HCI_TXN *p_txn = &btm_hci_txn_cb.txn[i];
+        if (!p_txn->in_use)
+        {
+            memset(p_txn, 0, sizeof(tBTM_HCI_TXN));
+            p_txn->in_use = TRUE;
+            p_txn->client = client;
+            return i;
+        }
+    }
+    return BTM_HCI_TXN_NONE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_check_done
+**
+** Description      Records and releases a transaction once it is ended and
+**                  all of its commands completed. Called with the lock held.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_hci_txn_check_done(UINT8 txn_idx, UINT64 now_us)
+{
+    tBTM_HCI_TXN *p_txn = &btm_hci_txn_cb.txn[txn_idx];
+    tBTM_HCI_TXN_STATS *p_stats = &btm_hci_txn_cb.stats[p_txn->client];
+    UINT32 elapsed_us;
+
+    if (p_txn->depth > 0 || p_txn->pending > 0)
+        return;
+
+    if (p_txn->start_us != 0)
+    {
+        elapsed_us = (UINT32)(now_us - p_txn->start_us);
+        p_stats->txns++;
+        p_stats->txn_last_us = elapsed_us;
+        p_stats->txn_total_us += elapsed_us;
+        if (elapsed_us > p_stats->txn_max_us)
+            p_stats->txn_max_us = elapsed_us;
+
+        BTM_TRACE_DEBUG("%s: client %d transaction done in %u us", __func__,
+                        p_txn->client, elapsed_us);
+    }
+    p_txn->in_use = FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_send
+**
+** Description      Hands a vendor specific command to HCI. Called with the
+**                  lock held.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_hci_txn_send(tBTM_HCI_TXN_CMD *p_cmd, UINT8 *p_param)
+{
+    tBTM_HCI_TXN_STATS *p_stats = &btm_hci_txn_cb.stats[p_cmd->client];
+
+    p_cmd->sent = TRUE;
+    p_cmd->sent_us = time_get_os_boottime_us();
+    if (btm_hci_txn_cb.txn[p_cmd->txn].start_us == 0)
+        btm_hci_txn_cb.txn[p_cmd->txn].start_us = p_cmd->sent_us;
+
+    btm_hci_txn_cb.in_flight++;
+    if (++btm_hci_txn_cb.client_in_flight[p_cmd->client] > p_stats->in_flight_high_water)
+        p_stats->in_flight_high_water = btm_hci_txn_cb.client_in_flight[p_cmd->client];
+
+    BTM_VendorSpecificCommand(p_cmd->opcode, p_cmd->param_len, p_param, btm_hci_txn_vsc_cmpl);
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_send_held
+**
+** Description      Issues held commands, oldest first, while the window has
+**                  room. Called with the lock held.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_hci_txn_send_held(void)
+{
+    UINT8 idx = btm_hci_txn_cb.head;
+
+    while (btm_hci_txn_cb.held > 0 && btm_hci_txn_cb.in_flight < BTM_HCI_TXN_WINDOW &&
+           idx != BTM_HCI_TXN_NONE)
+    {
+        tBTM_HCI_TXN_CMD *p_cmd = &btm_hci_txn_cb.cmd[idx];
+
+        if (!p_cmd->sent)
+        {
+            btm_hci_txn_cb.held--;
+            btm_hci_txn_send(p_cmd, p_cmd->p_param);
+            osi_free_and_reset((void **)&p_cmd->p_param);
+        }
+        idx = p_cmd->next;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_add
+**
+** Description      Appends a command to the issue order and to the client's
+**                  open transaction, or to a transaction of its own. Called
+**                  with the lock held.
+**
+** Returns          the command, NULL if the pool is exhausted
+**
+*******************************************************************************/
+static tBTM_HCI_TXN_CMD *btm_hci_txn_add(UINT8 client, UINT16 opcode,
+                                         tBTM_HCI_TXN_CMPL_CBACK *p_cback,
+                                         UINT8 evt, UINT32 ref, void *p_ref)
+{
+    tBTM_HCI_TXN_CMD *p_cmd;
+    UINT8 idx = btm_hci_txn_cb.free;
+    UINT8 txn_idx = btm_hci_txn_cb.open_txn[client];
+
+    if (idx != BTM_HCI_TXN_NONE && txn_idx == BTM_HCI_TXN_NONE)
+        txn_idx = btm_hci_txn_alloc_txn(client);
+
+    if (idx == BTM_HCI_TXN_NONE || txn_idx == BTM_HCI_TXN_NONE)
+    {
+        BTM_TRACE_ERROR("%s: no room for opcode 0x%04x of client %d", __func__, opcode, client);
+        btm_hci_txn_cb.stats[client].dropped++;
+        return NULL;
+    }
+
+    p_cmd = &btm_hci_txn_cb.cmd[idx];
+    btm_hci_txn_cb.free = p_cmd->next;
+
+    memset(p_cmd, 0, sizeof(tBTM_HCI_TXN_CMD));
+    p_cmd->opcode = opcode;
+    p_cmd->client = client;
+    p_cmd->txn = txn_idx;
+    p_cmd->evt = evt;
+    p_cmd->ref = ref;
+    p_cmd->p_ref = p_ref;
+    p_cmd->p_cback = p_cback;
+    p_cmd->next = BTM_HCI_TXN_NONE;
+
+    if (btm_hci_txn_cb.tail == BTM_HCI_TXN_NONE)
+        btm_hci_txn_cb.head = idx;
+    else
+        btm_hci_txn_cb.cmd[btm_hci_txn_cb.tail].next = idx;
+    btm_hci_txn_cb.tail = idx;
+
+    btm_hci_txn_cb.txn[txn_idx].pending++;
+    return p_cmd;
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_remove
+**
+** Description      Unlinks a command from the issue order and returns it to
+**                  the free list. Called with the lock held.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_hci_txn_remove(UINT8 idx, UINT8 prev)
+{
+    tBTM_HCI_TXN_CMD *p_cmd = &btm_hci_txn_cb.cmd[idx];
+
+    if (prev == BTM_HCI_TXN_NONE)
+        btm_hci_txn_cb.head = p_cmd->next;
+    else
+        btm_hci_txn_cb.cmd[prev].next = p_cmd->next;
+    if (btm_hci_txn_cb.tail == idx)
+        btm_hci_txn_cb.tail = prev;
+
+    if (p_cmd->sent)
+    {
+        if (p_cmd->is_vsc && btm_hci_txn_cb.in_flight > 0)
+            btm_hci_txn_cb.in_flight--;
+        if (btm_hci_txn_cb.client_in_flight[p_cmd->client] > 0)
+            btm_hci_txn_cb.client_in_flight[p_cmd->client]--;
+    }
+    else if (btm_hci_txn_cb.held > 0)
+    {
+        btm_hci_txn_cb.held--;
+    }
+    osi_free_and_reset((void **)&p_cmd->p_param);
+
+    btm_hci_txn_cb.txn[p_cmd->txn].pending--;
+
+    p_cmd->next = btm_hci_txn_cb.free;
+    btm_hci_txn_cb.free = idx;
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_flush
+**
+** Description      Drops every command and transaction of client, e.g. when
+**                  the client is cleaned up. Completions still arriving for
+**                  dropped commands are ignored.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_hci_txn_flush(UINT8 client)
+{
+    UINT8 idx, prev = BTM_HCI_TXN_NONE, next, i;
+
+    if (client >= BTM_HCI_TXN_MAX_CLIENTS)
+        return;
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    for (idx = btm_hci_txn_cb.head; idx != BTM_HCI_TXN_NONE; idx = next)
+    {
+        next = btm_hci_txn_cb.cmd[idx].next;
+        if (btm_hci_txn_cb.cmd[idx].client == client)
+        {
+            btm_hci_txn_cb.stats[client].dropped++;
+            btm_hci_txn_remove(idx, prev);
+        }
+        else
+        {
+            prev = idx;
+        }
+    }
+
+    for (i = 0; i < BTM_HCI_TXN_MAX_CMDS; i++)
+    {
+        if (btm_hci_txn_cb.txn[i].in_use && btm_hci_txn_cb.txn[i].client == client)
+            btm_hci_txn_cb.txn[i].in_use = FALSE;
+    }
+    btm_hci_txn_cb.open_txn[client] = BTM_HCI_TXN_NONE;
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_reset
+**
+** Description      Drops every pending command after the controller was reset;
+**                  none of them will complete. Counters are kept.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_hci_txn_reset(void)
+{
+    UINT8 client;
+
+    for (client = 0; client < BTM_HCI_TXN_MAX_CLIENTS; client++)
+        btm_hci_txn_flush(client);
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    btm_hci_txn_cb.in_flight = 0;
+    btm_hci_txn_cb.held = 0;
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_begin
+**
+** Description      Starts a transaction for client. Commands the client issues
+**                  until the matching btm_hci_txn_end() belong to it. Calls may
+**                  nest; the outermost pair delimits the transaction.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_hci_txn_begin(UINT8 client)
+{
+    UINT8 txn_idx;
+
+    if (client >= BTM_HCI_TXN_MAX_CLIENTS)
+        return;
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    txn_idx = btm_hci_txn_cb.open_txn[client];
+    if (txn_idx == BTM_HCI_TXN_NONE)
+    {
+        txn_idx = btm_hci_txn_alloc_txn(client);
+        btm_hci_txn_cb.open_txn[client] = txn_idx;
+    }
+
+    if (txn_idx != BTM_HCI_TXN_NONE)
+        btm_hci_txn_cb.txn[txn_idx].depth++;
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_end
+**
+** Description      Ends the transaction started by btm_hci_txn_begin(). It is
+**                  recorded once all of its commands complete.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_hci_txn_end(UINT8 client)
+{
+    UINT8 txn_idx;
+
+    if (client >= BTM_HCI_TXN_MAX_CLIENTS)
+        return;
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    txn_idx = btm_hci_txn_cb.open_txn[client];
+    if (txn_idx != BTM_HCI_TXN_NONE && --btm_hci_txn_cb.txn[txn_idx].depth == 0)
+    {
+        btm_hci_txn_cb.open_txn[client] = BTM_HCI_TXN_NONE;
+        btm_hci_txn_check_done(txn_idx, time_get_os_boottime_us());
+    }
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_vsc
+**
+** Description      Issues a vendor specific command for client. p_param[0] is
+**                  the sub-opcode the controller echoes in the completion.
+**                  p_cback is called with evt, ref and p_ref when it completes.
+**
+** Returns          BTM_CMD_STARTED if the command was issued or held,
+**                  BTM_NO_RESOURCES if too many commands are pending,
+**                  BTM_ILLEGAL_VALUE if the parameters are invalid.
+**
+*******************************************************************************/
+tBTM_STATUS btm_hci_txn_vsc(UINT8 client, UINT16 ocf, UINT8 param_len,
+                            UINT8 *p_param, tBTM_HCI_TXN_CMPL_CBACK *p_cback,
+                            UINT8 evt, UINT32 ref, void *p_ref)
+{
+    tBTM_HCI_TXN_CMD *p_cmd;
+
+    if (client >= BTM_HCI_TXN_MAX_CLIENTS || param_len == 0 || p_param == NULL)
+        return BTM_ILLEGAL_VALUE;
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    p_cmd = btm_hci_txn_add(client, ocf | HCI_GRP_VENDOR_SPECIFIC, p_cback, evt, ref, p_ref);
+    if (p_cmd == NULL)
+    {
+        pthread_mutex_unlock(&btm_hci_txn_lock);
+        return BTM_NO_RESOURCES;
+    }
+
+    p_cmd->is_vsc = TRUE;
+    p_cmd->sub_opcode = p_param[0];
+    p_cmd->param_len = param_len;
+
+    if (btm_hci_txn_cb.in_flight < BTM_HCI_TXN_WINDOW && btm_hci_txn_cb.held == 0)
+    {
+        btm_hci_txn_send(p_cmd, p_param);
+    }
+    else
+    {
+        p_cmd->p_param = osi_malloc(param_len);
+        memcpy(p_cmd->p_param, p_param, param_len);
+        btm_hci_txn_cb.held++;
+        btm_hci_txn_cb.stats[client].held++;
+    }
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+    return BTM_CMD_STARTED;
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_track
+**
+** Description      Tracks a standard HCI command client is about to send
+**                  itself, so that its completion, reported with
+**                  btm_hci_txn_cmd_complete(), reaches p_cback. Such commands
+**                  count towards transactions but are never held back. The
+**                  command must only be sent if it is tracked; if sending it
+**                  fails, it is dropped with btm_hci_txn_cancel().
+**
+** Returns          BTM_CMD_STARTED, or BTM_NO_RESOURCES if too many commands
+**                  are pending
+**
+*******************************************************************************/
+tBTM_STATUS btm_hci_txn_track(UINT8 client, UINT16 opcode,
+                              tBTM_HCI_TXN_CMPL_CBACK *p_cback,
+                              UINT8 evt, UINT32 ref, void *p_ref)
+{
+    tBTM_HCI_TXN_CMD *p_cmd;
+    tBTM_HCI_TXN_STATS *p_stats;
+
+    if (client >= BTM_HCI_TXN_MAX_CLIENTS)
+        return BTM_ILLEGAL_VALUE;
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    p_cmd = btm_hci_txn_add(client, opcode, p_cback, evt, ref, p_ref);
+    if (p_cmd == NULL)
+    {
+        pthread_mutex_unlock(&btm_hci_txn_lock);
+        return BTM_NO_RESOURCES;
+    }
+
+    p_stats = &btm_hci_txn_cb.stats[client];
+    p_cmd->sent = TRUE;
+    p_cmd->sent_us = time_get_os_boottime_us();
+    if (btm_hci_txn_cb.txn[p_cmd->txn].start_us == 0)
+        btm_hci_txn_cb.txn[p_cmd->txn].start_us = p_cmd->sent_us;
+    if (++btm_hci_txn_cb.client_in_flight[client] > p_stats->in_flight_high_water)
+        p_stats->in_flight_high_water = btm_hci_txn_cb.client_in_flight[client];
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+    return BTM_CMD_STARTED;
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_cancel
+**
+** Description      Drops the command of client most recently tracked with
+**                  btm_hci_txn_track() for opcode, when it could not be sent.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_hci_txn_cancel(UINT8 client, UINT16 opcode)
+{
+    tBTM_HCI_TXN_CMD *p_cmd = NULL;
+    UINT8 idx, prev = BTM_HCI_TXN_NONE, found = BTM_HCI_TXN_NONE, found_prev = BTM_HCI_TXN_NONE;
+    UINT8 txn_idx;
+
+    if (client >= BTM_HCI_TXN_MAX_CLIENTS)
+        return;
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    for (idx = btm_hci_txn_cb.head; idx != BTM_HCI_TXN_NONE; idx = p_cmd->next)
+    {
+        p_cmd = &btm_hci_txn_cb.cmd[idx];
+        if (!p_cmd->is_vsc && p_cmd->client == client && p_cmd->opcode == opcode)
+        {
+            found = idx;
+            found_prev = prev;
+        }
+        prev = idx;
+    }
+
+    if (found != BTM_HCI_TXN_NONE)
+    {
+        p_cmd = &btm_hci_txn_cb.cmd[found];
+        txn_idx = p_cmd->txn;
+
+        /* A transaction started only by this command never ran */
+        if (btm_hci_txn_cb.txn[txn_idx].pending == 1 &&
+            btm_hci_txn_cb.txn[txn_idx].start_us == p_cmd->sent_us)
+            btm_hci_txn_cb.txn[txn_idx].start_us = 0;
+
+        btm_hci_txn_remove(found, found_prev);
+        btm_hci_txn_check_done(txn_idx, time_get_os_boottime_us());
+    }
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_complete
+**
+** Description      Matches a completion to the oldest outstanding command with
+**                  the same opcode and, if the completion carries one, the
+**                  same sub-opcode, and calls its callback.
+**
+** Returns          TRUE if a command matched
+**
+*******************************************************************************/
+static BOOLEAN btm_hci_txn_complete(tBTM_VSC_CMPL *p_params, BOOLEAN has_sub_opcode,
+                                    UINT8 sub_opcode)
+{
+    tBTM_HCI_TXN_CMD *p_cmd = NULL;
+    tBTM_HCI_TXN_STATS *p_stats;
+    tBTM_HCI_TXN_CMPL_CBACK *p_cback;
+    UINT8 idx, prev = BTM_HCI_TXN_NONE, txn_idx, evt;
+    UINT32 ref, elapsed_us;
+    void *p_ref;
+    UINT64 now_us;
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    for (idx = btm_hci_txn_cb.head; idx != BTM_HCI_TXN_NONE; idx = p_cmd->next)
+    {
+        p_cmd = &btm_hci_txn_cb.cmd[idx];
+        if (p_cmd->sent && p_cmd->opcode == p_params->opcode &&
+            (!p_cmd->is_vsc || !has_sub_opcode || p_cmd->sub_opcode == sub_opcode))
+            break;
+        prev = idx;
+    }
+
+    if (idx == BTM_HCI_TXN_NONE)
+    {
+        pthread_mutex_unlock(&btm_hci_txn_lock);
+        BTM_TRACE_WARNING("%s: no command pending for opcode 0x%04x", __func__,
+                          p_params->opcode);
+        return FALSE;
+    }
+
+    now_us = time_get_os_boottime_us();
+    elapsed_us = (UINT32)(now_us - p_cmd->sent_us);
+    p_stats = &btm_hci_txn_cb.stats[p_cmd->client];
+    p_stats->cmds++;
+    p_stats->cmd_total_us += elapsed_us;
+    if (elapsed_us > p_stats->cmd_max_us)
+        p_stats->cmd_max_us = elapsed_us;
+    if (p_params->param_len < 1 || p_params->p_param_buf[0] != HCI_SUCCESS)
+        p_stats->failed++;
+
+    p_cback = p_cmd->p_cback;
+    evt = p_cmd->evt;
+    ref = p_cmd->ref;
+    p_ref = p_cmd->p_ref;
+    txn_idx = p_cmd->txn;
+
+    btm_hci_txn_remove(idx, prev);
+    btm_hci_txn_check_done(txn_idx, now_us);
+    btm_hci_txn_send_held();
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+
+    if (p_cback != NULL)
+        (*p_cback)(p_params, evt, ref, p_ref);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_vsc_cmpl
+**
+** Description      Completion callback of every vendor specific command issued
+**                  by the transaction layer.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_hci_txn_vsc_cmpl(tBTM_VSC_CMPL *p_params)
+{
+    /* A command status carries only the status, no sub-opcode */
+    if (p_params->param_len >= 2)
+        btm_hci_txn_complete(p_params, TRUE, p_params->p_param_buf[1]);
+    else
+        btm_hci_txn_complete(p_params, FALSE, 0);
+}
+
+/*******************************************************************************
+**
+** Function         btm_hci_txn_cmd_complete
+**
+** Description      Reports the completion of a command tracked with
+**                  btm_hci_txn_track().
+**
+** Returns          TRUE if a tracked command matched
+**
+*******************************************************************************/
+BOOLEAN btm_hci_txn_cmd_complete(UINT8 *p, UINT16 opcode, UINT16 evt_len)
+{
+    tBTM_VSC_CMPL params;
+
+    params.opcode = opcode;
+    params.param_len = evt_len;
+    params.p_param_buf = p;
+    return btm_hci_txn_complete(&params, FALSE, 0);
+}
+
+/*******************************************************************************
+**
+** Function         BTM_HciTxnGetStats
+**
+** Description      Reads the HCI command transaction counters of a client.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTM_HciTxnGetStats(UINT8 client, tBTM_HCI_TXN_STATS *p_stats)
+{
+    if (client >= BTM_HCI_TXN_MAX_CLIENTS)
+    {
+        memset(p_stats, 0, sizeof(tBTM_HCI_TXN_STATS));
+        return;
+    }
+
+    pthread_mutex_lock(&btm_hci_txn_lock);
+    memcpy(p_stats, &btm_hci_txn_cb.stats[client], sizeof(tBTM_HCI_TXN_STATS));
+    pthread_mutex_unlock(&btm_hci_txn_lock);
+}
@@ -40,6 +40,7 @@
 #include "btm_api.h"
 #include "btm_int.h"
 #include "hcidefs.h"
+#include "stack_config.h"
 
 /* 3 second timeout waiting for responses */
 #define BTM_INQ_REPLY_TIMEOUT_MS (3 * 1000)
@@ -136,6 +137,7 @@ const UINT16 BTM_EIR_UUID_LKUP_TBL[BTM_EIR_MAX_SERVICES] =
 static void         btm_initiate_inquiry (tBTM_INQUIRY_VAR_ST *p_inq);
 static tBTM_STATUS  btm_set_inq_event_filter (UINT8 filter_cond_type, tBTM_INQ_FILT_COND *p_filt_cond);
 static void         btm_clr_inq_result_flt (void);
+static void         btm_inq_db_alloc (UINT16 size);
 
 static UINT8        btm_convert_uuid_to_eir_service( UINT16 uuid16 );
 static void         btm_set_eir_uuid( UINT8 *p_eir, tBTM_INQ_RESULTS *p_results );
@@ -1172,7 +1174,7 @@ tBTM_INQ_INFO *BTM_InqDbFirst (void)
     UINT16       xx;
     tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    for (xx = 0; xx < btm_cb.btm_inq_vars.inq_db_size; xx++, p_ent++)
     {
         if (p_ent->in_use)
             return (&p_ent->inq_info);
@@ -1204,7 +1206,7 @@ tBTM_INQ_INFO *BTM_InqDbNext (tBTM_INQ_INFO *p_cur)
         p_ent = (tINQ_DB_ENT *) ((UINT8 *)p_cur - offsetof (tINQ_DB_ENT, inq_info));
         inx = (UINT16)((p_ent - btm_cb.btm_inq_vars.inq_db) + 1);
 
-        for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < BTM_INQ_DB_SIZE; inx++, p_ent++)
+        for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < btm_cb.btm_inq_vars.inq_db_size; inx++, p_ent++)
         {
             if (p_ent->in_use)
                 return (&p_ent->inq_info);
@@ -1285,6 +1287,241 @@ tBTM_STATUS BTM_ReadInquiryRspTxPower (tBTM_CMPL_CB *p_cb)
 **                                                                              **
 **********************************************************************************
 *********************************************************************************/
+
+/*******************************************************************************
+**  Inquiry database index
+**
+**  inq_db is an array of inq_db_size entries so that BTM_InqDbFirst/Next can
+**  walk it in order. In-use entries are also chained into inq_db_hash by
+**  address and into a list ordered by the time of their last response, which
+**  gives constant time lookups and picks the entry to recycle when the
+**  database is full. Unused entries are kept on p_inq_free.
+**
+**  The duplicate response filter (p_bd_db) is indexed the same way.
+*******************************************************************************/
+
+static UINT16 btm_inq_hash_addr(const UINT8 *p_addr)
+{
+    UINT32 h = ((UINT32)p_addr[2] << 24) | ((UINT32)p_addr[3] << 16) |
+               ((UINT32)p_addr[4] << 8) | p_addr[5];
+
+    h ^= ((UINT32)p_addr[0] << 8) | p_addr[1];
+    return (UINT16)(((h * 0x9E3779B1) >> 16) & (BTM_INQ_DB_HASH_SIZE - 1));
+}
+
+static void btm_inq_db_hash_unlink(tINQ_DB_ENT *p_ent)
+{
+    tINQ_DB_ENT **pp;
+
+    pp = &btm_cb.btm_inq_vars.inq_db_hash[btm_inq_hash_addr(p_ent->inq_info.results.remote_bd_addr)];
+    for (; *pp; pp = &(*pp)->p_hash_next)
+    {
+        if (*pp == p_ent)
+        {
+            *pp = p_ent->p_hash_next;
+            break;
+        }
+    }
+    p_ent->p_hash_next = NULL;
+}
+
+static void btm_inq_db_hash_link(tINQ_DB_ENT *p_ent)
+{
+    tINQ_DB_ENT **pp;
+
+    pp = &btm_cb.btm_inq_vars.inq_db_hash[btm_inq_hash_addr(p_ent->inq_info.results.remote_bd_addr)];
+    p_ent->p_hash_next = *pp;
+    *pp = p_ent;
+}
+
+static void btm_inq_db_lru_unlink(tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    if (p_ent->p_lru_prev)
+        p_ent->p_lru_prev->p_lru_next = p_ent->p_lru_next;
+    else
+        p_inq->p_inq_oldest = p_ent->p_lru_next;
+
+    if (p_ent->p_lru_next)
+        p_ent->p_lru_next->p_lru_prev = p_ent->p_lru_prev;
+    else
+        p_inq->p_inq_newest = p_ent->p_lru_prev;
+
+    p_ent->p_lru_prev = NULL;
+    p_ent->p_lru_next = NULL;
+}
+
+static void btm_inq_db_lru_append(tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    p_ent->p_lru_next = NULL;
+    p_ent->p_lru_prev = p_inq->p_inq_newest;
+    if (p_inq->p_inq_newest)
+        p_inq->p_inq_newest->p_lru_next = p_ent;
+    else
+        p_inq->p_inq_oldest = p_ent;
+    p_inq->p_inq_newest = p_ent;
+}
+
+static int btm_inq_db_cmp_time(const void *p_a, const void *p_b)
+{
+    const tINQ_DB_ENT *p_ent_a = *(const tINQ_DB_ENT * const *)p_a;
+    const tINQ_DB_ENT *p_ent_b = *(const tINQ_DB_ENT * const *)p_b;
+
+    if (p_ent_a->time_of_resp != p_ent_b->time_of_resp)
+        return (p_ent_a->time_of_resp < p_ent_b->time_of_resp) ? -1 : 1;
+    return (p_ent_a < p_ent_b) ? -1 : (p_ent_a > p_ent_b);
+}
+
+/* Rebuilds the hash, LRU and free lists after entries moved in inq_db */
+static void btm_inq_db_reindex(void)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT        **pp_used = NULL;
+    tINQ_DB_ENT         *p_ent;
+    UINT16               num_used = 0;
+    UINT16               xx;
+
+    memset(p_inq->inq_db_hash, 0, sizeof(p_inq->inq_db_hash));
+    p_inq->p_inq_oldest = NULL;
+    p_inq->p_inq_newest = NULL;
+    p_inq->p_inq_free = NULL;
+
+    for (xx = 0, p_ent = p_inq->inq_db; xx < p_inq->inq_db_size; xx++, p_ent++)
+    {
+        if (p_ent->in_use)
+        {
+            if (!pp_used)
+                pp_used = (tINQ_DB_ENT **)osi_malloc(p_inq->inq_db_size * sizeof(tINQ_DB_ENT *));
+            pp_used[num_used++] = p_ent;
+        }
+    }
+
+    /* free list in array order so that empty slots are reused from the start */
+    for (xx = p_inq->inq_db_size; xx > 0; xx--)
+    {
+        p_ent = &p_inq->inq_db[xx - 1];
+        p_ent->p_hash_next = NULL;
+        p_ent->p_lru_prev = NULL;
+        if (!p_ent->in_use)
+        {
+            p_ent->p_lru_next = p_inq->p_inq_free;
+            p_inq->p_inq_free = p_ent;
+        }
+    }
+
+    if (!pp_used)
+        return;
+
+    qsort(pp_used, num_used, sizeof(tINQ_DB_ENT *), btm_inq_db_cmp_time);
+    for (xx = 0; xx < num_used; xx++)
+    {
+        btm_inq_db_hash_link(pp_used[xx]);
+        btm_inq_db_lru_append(pp_used[xx]);
+    }
+    osi_free(pp_used);
+}
+
+/* Replaces the database with an empty one holding size entries */
+static void btm_inq_db_alloc(UINT16 size)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    osi_free(p_inq->inq_db);
+    p_inq->inq_db = (tINQ_DB_ENT *)osi_calloc(size * sizeof(tINQ_DB_ENT));
+    p_inq->inq_db_size = size;
+    btm_inq_db_reindex();
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_touch
+**
+** Description      This function records that a response was just received
+**                  for an entry, making it the last one to be recycled.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_inq_db_touch (tINQ_DB_ENT *p_ent)
+{
+    p_ent->time_of_resp = time_get_os_boottime_ms();
+
+    btm_inq_db_lru_unlink(p_ent);
+    btm_inq_db_lru_append(p_ent);
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_remove
+**
+** Description      This function returns an in-use entry to the free list.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_inq_db_remove (tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    if (!p_ent->in_use)
+        return;
+
+    btm_inq_db_hash_unlink(p_ent);
+    btm_inq_db_lru_unlink(p_ent);
+    p_ent->in_use = FALSE;
+    p_ent->p_lru_next = p_inq->p_inq_free;
+    p_inq->p_inq_free = p_ent;
+}
+
+static void btm_inq_bdaddr_unlink(tINQ_BDADDR *p_db)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_BDADDR        **pp;
+
+    for (pp = &p_inq->bd_db_hash[btm_inq_hash_addr(p_db->bd_addr)]; *pp; pp = &(*pp)->p_hash_next)
+    {
+        if (*pp == p_db)
+        {
+            *pp = p_db->p_hash_next;
+            break;
+        }
+    }
+    p_db->p_hash_next = NULL;
+
+    if (p_db->p_lru_prev)
+        p_db->p_lru_prev->p_lru_next = p_db->p_lru_next;
+    else
+        p_inq->p_bd_oldest = p_db->p_lru_next;
+
+    if (p_db->p_lru_next)
+        p_db->p_lru_next->p_lru_prev = p_db->p_lru_prev;
+    else
+        p_inq->p_bd_newest = p_db->p_lru_prev;
+
+    p_db->p_lru_prev = NULL;
+    p_db->p_lru_next = NULL;
+}
+
+static void btm_inq_bdaddr_link(tINQ_BDADDR *p_db)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_BDADDR        **pp = &p_inq->bd_db_hash[btm_inq_hash_addr(p_db->bd_addr)];
+
+    p_db->p_hash_next = *pp;
+    *pp = p_db;
+
+    p_db->p_lru_next = NULL;
+    p_db->p_lru_prev = p_inq->p_bd_newest;
+    if (p_inq->p_bd_newest)
+        p_inq->p_bd_newest->p_lru_next = p_db;
+    else
+        p_inq->p_bd_oldest = p_db;
+    p_inq->p_bd_newest = p_db;
+}
+
 /*******************************************************************************
 **
 ** Function         btm_inq_db_reset
@@ -1381,6 +1618,8 @@ void btm_inq_db_reset (void)
 *******************************************************************************/
 void btm_inq_db_init (void)
 {
+    int size;
+
 #if 0  /* cleared in btm_init; put back in if called from anywhere else! */
     memset (&btm_cb.btm_inq_vars, 0, sizeof (tBTM_INQUIRY_VAR_ST));
 #endif
@@ -1388,6 +1627,12 @@ void btm_inq_db_init (void)
     btm_cb.btm_inq_vars.remote_name_timer =
         alarm_new("btm_inq.remote_name_timer");
     btm_cb.btm_inq_vars.no_inc_ssp = BTM_NO_SSP_ON_INQUIRY;
+
+    /* InqDbSize in bt_stack.conf overrides the built-in size */
+    size = stack_config_get_interface()->get_inq_db_size();
+    if (size <= 0 || size > UINT16_MAX)
+        size = BTM_INQ_DB_SIZE;
+    btm_inq_db_alloc((UINT16)size);
 }
 
 /*********************************************************************************
@@ -1463,17 +1708,16 @@ void btm_clr_inq_db (BD_ADDR p_bda)
     BTM_TRACE_DEBUG ("btm_clr_inq_db: inq_active:0x%x state:%d",
         btm_cb.btm_inq_vars.inq_active, btm_cb.btm_inq_vars.state);
 #endif
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    if (p_bda == NULL)
     {
-        if (p_ent->in_use)
-        {
-            /* If this is the specified BD_ADDR or clearing all devices */
-            if (p_bda == NULL ||
-                (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN)))
-            {
-                p_ent->in_use = FALSE;
-            }
-        }
+        /* clearing all devices */
+        for (xx = 0; xx < p_inq->inq_db_size; xx++, p_ent++)
+            p_ent->in_use = FALSE;
+        btm_inq_db_reindex();
+    }
+    else if ((p_ent = btm_inq_db_find(p_bda)) != NULL)
+    {
+        btm_inq_db_remove(p_ent);
     }
 #if (BTM_INQ_DEBUG == TRUE)
     BTM_TRACE_DEBUG ("inq_active:0x%x state:%d",
@@ -1499,6 +1743,9 @@ static void btm_clr_inq_result_flt (void)
     osi_free_and_reset((void **)&p_inq->p_bd_db);
     p_inq->num_bd_entries = 0;
     p_inq->max_bd_entries = 0;
+    memset(p_inq->bd_db_hash, 0, sizeof(p_inq->bd_db_hash));
+    p_inq->p_bd_oldest = NULL;
+    p_inq->p_bd_newest = NULL;
 }
 
 /*******************************************************************************
@@ -1506,7 +1753,9 @@ static void btm_clr_inq_result_flt (void)
 ** Function         btm_inq_find_bdaddr
 **
 ** Description      This function looks through the bdaddr database for a match
-**                  based on Bluetooth Device Address
+**                  based on Bluetooth Device Address. A new address is added,
+**                  replacing the least recently seen one if the database is
+**                  full.
 **
 ** Returns          TRUE if found, else FALSE (new entry)
 **
@@ -1514,25 +1763,41 @@ static void btm_clr_inq_result_flt (void)
 BOOLEAN btm_inq_find_bdaddr (BD_ADDR p_bda)
 {
     tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
-    tINQ_BDADDR         *p_db = &p_inq->p_bd_db[0];
-    UINT16       xx;
+    tINQ_BDADDR         *p_db;
 
     /* Don't bother searching, database doesn't exist or periodic mode */
-    if ((p_inq->inq_active & BTM_PERIODIC_INQUIRY_ACTIVE) || !p_db)
+    if ((p_inq->inq_active & BTM_PERIODIC_INQUIRY_ACTIVE) || !p_inq->p_bd_db)
         return (FALSE);
 
-    for (xx = 0; xx < p_inq->num_bd_entries; xx++, p_db++)
+    for (p_db = p_inq->bd_db_hash[btm_inq_hash_addr(p_bda)]; p_db; p_db = p_db->p_hash_next)
     {
-        if (!memcmp(p_db->bd_addr, p_bda, BD_ADDR_LEN)
-            && p_db->inq_count == p_inq->inq_counter)
-            return (TRUE);
+        if (!memcmp(p_db->bd_addr, p_bda, BD_ADDR_LEN))
+            break;
     }
 
-    if (xx < p_inq->max_bd_entries)
+    if (p_db)
     {
+        BOOLEAN seen = (p_db->inq_count == p_inq->inq_counter);
+
+        btm_inq_bdaddr_unlink(p_db);
+        p_db->inq_count = p_inq->inq_counter;
+        btm_inq_bdaddr_link(p_db);
+        if (seen)
+            return (TRUE);
+    }
+    else
+    {
+        if (p_inq->num_bd_entries < p_inq->max_bd_entries)
+            p_db = &p_inq->p_bd_db[p_inq->num_bd_entries++];
+        else
+        {
+            p_db = p_inq->p_bd_oldest;
+            btm_inq_bdaddr_unlink(p_db);
+        }
+
         p_db->inq_count = p_inq->inq_counter;
         memcpy(p_db->bd_addr, p_bda, BD_ADDR_LEN);
-        p_inq->num_bd_entries++;
+        btm_inq_bdaddr_link(p_db);
     }
 
     /* If here, New Entry */
@@ -1551,12 +1816,11 @@ BOOLEAN btm_inq_find_bdaddr (BD_ADDR p_bda)
 *******************************************************************************/
 tINQ_DB_ENT *btm_inq_db_find (const BD_ADDR p_bda)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
+    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db_hash[btm_inq_hash_addr(p_bda)];
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    for (; p_ent; p_ent = p_ent->p_hash_next)
     {
-        if ((p_ent->in_use) && (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN)))
+        if (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN))
             return (p_ent);
     }
 
@@ -1569,44 +1833,35 @@ tINQ_DB_ENT *btm_inq_db_find (const BD_ADDR p_bda)
 **
 ** Function         btm_inq_db_new
 **
-** Description      This function looks through the inquiry database for an unused
-**                  entry. If no entry is free, it allocates the oldest entry.
+** Description      This function takes an unused entry from the inquiry database.
+**                  If no entry is free, it recycles the one that responded least
+**                  recently.
 **
 ** Returns          pointer to entry
 **
 *******************************************************************************/
 tINQ_DB_ENT *btm_inq_db_new (BD_ADDR p_bda)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
-    tINQ_DB_ENT  *p_old = btm_cb.btm_inq_vars.inq_db;
-    UINT32       ot = 0xFFFFFFFF;
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent = p_inq->p_inq_free;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    if (p_ent)
+        p_inq->p_inq_free = p_ent->p_lru_next;
+    else
     {
-        if (!p_ent->in_use)
-        {
-            memset (p_ent, 0, sizeof (tINQ_DB_ENT));
-            memcpy (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
-            p_ent->in_use = TRUE;
-
-            return (p_ent);
-        }
-
-        if (p_ent->time_of_resp < ot)
-        {
-            p_old = p_ent;
-            ot    = p_ent->time_of_resp;
-        }
+        /* If here, no free entry found. Use the oldest. */
+        p_ent = p_inq->p_inq_oldest;
+        btm_inq_db_hash_unlink(p_ent);
+        btm_inq_db_lru_unlink(p_ent);
     }
 
-    /* If here, no free entry found. Return the oldest. */
-
-    memset (p_old, 0, sizeof (tINQ_DB_ENT));
-    memcpy (p_old->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
-    p_old->in_use = TRUE;
+    memset (p_ent, 0, sizeof (tINQ_DB_ENT));
+    memcpy (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
+    p_ent->in_use = TRUE;
+    btm_inq_db_hash_link(p_ent);
+    btm_inq_db_lru_append(p_ent);
 
-    return (p_old);
+    return (p_ent);
 }
 
 
@@ -1816,7 +2071,8 @@ static void btm_initiate_inquiry (tBTM_INQUIRY_VAR_ST *p_inq)
     }
 
     /* Make sure the number of responses doesn't overflow the database configuration */
-    p_inqparms->max_resps = (UINT8)((p_inqparms->max_resps <= BTM_INQ_DB_SIZE) ? p_inqparms->max_resps : BTM_INQ_DB_SIZE);
+    if (p_inqparms->max_resps > p_inq->inq_db_size)
+        p_inqparms->max_resps = (UINT8)p_inq->inq_db_size;
 
     lap = (p_inq->inq_active & BTM_LIMITED_INQUIRY_ACTIVE) ? &limited_inq_lap : &general_inq_lap;
 
@@ -1833,8 +2089,8 @@ static void btm_initiate_inquiry (tBTM_INQUIRY_VAR_ST *p_inq)
         btm_clr_inq_result_flt();
 
         /* Allocate memory to hold bd_addrs responding */
-        p_inq->p_bd_db = (tINQ_BDADDR *)osi_calloc(BT_DEFAULT_BUFFER_SIZE);
-        p_inq->max_bd_entries = (UINT16)(BT_DEFAULT_BUFFER_SIZE / sizeof(tINQ_BDADDR));
+        p_inq->p_bd_db = (tINQ_BDADDR *)osi_calloc(BTM_INQ_BDADDR_DB_SIZE * sizeof(tINQ_BDADDR));
+        p_inq->max_bd_entries = BTM_INQ_BDADDR_DB_SIZE;
 
         if (!btsnd_hcic_inquiry(*lap, p_inqparms->duration, 0))
             btm_process_inq_complete (BTM_NO_RESOURCES, (UINT8)(p_inqparms->mode & BTM_BR_INQUIRY_MASK));
@@ -2008,7 +2264,7 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
                         bda[0], bda[1], bda[2],bda[3], bda[4], bda[5]);
             BTM_TRACE_WARNING ("btm_process_inq_results: Dev class: %02x-%02x-%02x",
                         p_cur->dev_class[0], p_cur->dev_class[1], p_cur->dev_class[2]);
-            p_i->time_of_resp = time_get_os_boottime_ms();
+            btm_inq_db_touch(p_i);
 
             if (p_i->inq_count != p_inq->inq_counter)
                 p_inq->inq_cmpl_info.num_resp++;       /* A new response was found */
@@ -2082,29 +2338,28 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
 ** Returns          void
 **
 *******************************************************************************/
+static int btm_inq_cmp_rssi(const void *p_a, const void *p_b)
+{
+    const tINQ_DB_ENT *p_ent_a = (const tINQ_DB_ENT *)p_a;
+    const tINQ_DB_ENT *p_ent_b = (const tINQ_DB_ENT *)p_b;
+
+    return (int)p_ent_b->inq_info.results.rssi - (int)p_ent_a->inq_info.results.rssi;
+}
+
 void btm_sort_inq_result(void)
 {
-    UINT8 xx, yy, num_resp;
-    tINQ_DB_ENT *p_ent  = btm_cb.btm_inq_vars.inq_db;
-    tINQ_DB_ENT *p_next = btm_cb.btm_inq_vars.inq_db+1;
-    int size;
-    tINQ_DB_ENT *p_tmp = (tINQ_DB_ENT *)osi_malloc(sizeof(tINQ_DB_ENT));
-
-    num_resp = (btm_cb.btm_inq_vars.inq_cmpl_info.num_resp<BTM_INQ_DB_SIZE)?
-                btm_cb.btm_inq_vars.inq_cmpl_info.num_resp: BTM_INQ_DB_SIZE;
-
-    size = sizeof(tINQ_DB_ENT);
-    for (xx = 0; xx < num_resp-1; xx++, p_ent++) {
-        for (yy = xx+1, p_next = p_ent+1; yy < num_resp; yy++, p_next++) {
-            if (p_ent->inq_info.results.rssi < p_next->inq_info.results.rssi) {
-                memcpy(p_tmp, p_next, size);
-                memcpy(p_next, p_ent,  size);
-                memcpy(p_ent, p_tmp,  size);
-            }
-        }
-    }
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    UINT16 num_resp;
+
+    num_resp = (p_inq->inq_cmpl_info.num_resp < p_inq->inq_db_size) ?
+                p_inq->inq_cmpl_info.num_resp : p_inq->inq_db_size;
+    if (num_resp < 2)
+        return;
+
+    qsort(p_inq->inq_db, num_resp, sizeof(tINQ_DB_ENT), btm_inq_cmp_rssi);
 
-    osi_free(p_tmp);
+    /* entries moved, so the lists pointing at them have to be rebuilt */
+    btm_inq_db_reindex();
 }
 
 /*******************************************************************************
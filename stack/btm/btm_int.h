@@ -211,16 +211,20 @@ BT_OCTET16 ble_encryption_key_value; /* BLE encryption key */
 #define BTM_MIN_INQ_TX_POWER    -70
 #define BTM_MAX_INQ_TX_POWER    20
 
-typedef struct
+typedef struct t_inq_bdaddr
 {
     UINT32          inq_count;          /* Used for determining if a response has already been      */
                                         /* received for the current inquiry operation. (We do not   */
                                         /* want to flood the caller with multiple responses from    */
                                         /* the same device.                                         */
     BD_ADDR         bd_addr;
+
+    struct t_inq_bdaddr *p_hash_next;   /* next entry in the same bd_db_hash bucket */
+    struct t_inq_bdaddr *p_lru_prev;    /* entry seen less recently */
+    struct t_inq_bdaddr *p_lru_next;    /* entry seen more recently */
 } tINQ_BDADDR;
 
-typedef struct
+typedef struct t_inq_db_ent
 {
     UINT32          time_of_resp;
     UINT32          inq_count;          /* "timestamps" the entry with a particular inquiry count   */
@@ -234,6 +238,10 @@ typedef struct
 #if (BLE_INCLUDED == TRUE)
     BOOLEAN         scan_rsp;
 #endif
+
+    struct t_inq_db_ent *p_hash_next;   /* next entry in the same inq_db_hash bucket */
+    struct t_inq_db_ent *p_lru_prev;    /* entry that responded less recently */
+    struct t_inq_db_ent *p_lru_next;    /* entry that responded more recently, or next free entry */
 } tINQ_DB_ENT;
 
 
@@ -282,7 +290,15 @@ typedef struct
     tINQ_BDADDR     *p_bd_db;               /* Pointer to memory that holds bdaddrs */
     UINT16           num_bd_entries;        /* Number of entries in database */
     UINT16           max_bd_entries;        /* Maximum number of entries that can be stored */
-    tINQ_DB_ENT      inq_db[BTM_INQ_DB_SIZE];
+    tINQ_BDADDR     *bd_db_hash[BTM_INQ_DB_HASH_SIZE];
+    tINQ_BDADDR     *p_bd_oldest;           /* Least recently seen bdaddr, recycled when full */
+    tINQ_BDADDR     *p_bd_newest;
+    tINQ_DB_ENT     *inq_db;                /* inq_db_size entries, allocated in btm_inq_db_init */
+    UINT16           inq_db_size;
+    tINQ_DB_ENT     *inq_db_hash[BTM_INQ_DB_HASH_SIZE];
+    tINQ_DB_ENT     *p_inq_oldest;          /* Least recently responding entry, recycled when full */
+    tINQ_DB_ENT     *p_inq_newest;
+    tINQ_DB_ENT     *p_inq_free;            /* Unused entries, chained through p_lru_next */
     tBTM_INQ_PARMS   inqparms;              /* Contains the parameters for the current inquiry */
     tBTM_INQUIRY_CMPL inq_cmpl_info;        /* Status and number of responses from the last inquiry */
 
@@ -512,11 +528,25 @@ enum
 };
 typedef UINT8 tBTM_BOND_TYPE;
 
+/* Lookup indexes over the security device records (btm_dev.c) */
+enum
+{
+    BTM_SEC_IDX_ADDR,           /* bd_addr */
+    BTM_SEC_IDX_HANDLE,         /* hci_handle */
+#if BLE_INCLUDED == TRUE
+    BTM_SEC_IDX_PSEUDO,         /* ble.pseudo_addr */
+    BTM_SEC_IDX_STATIC,         /* ble.static_addr */
+    BTM_SEC_IDX_BLE_HANDLE,     /* ble_hci_handle */
+#endif
+    BTM_SEC_IDX_MAX
+};
+#define BTM_SEC_IDX_NONE        0xFFFF  /* record not filed in that index */
+
 /*
 ** Define structure for Security Device Record.
 ** A record exists for each device authenticated with this device
 */
-typedef struct
+typedef struct t_btm_sec_dev_rec
 {
     tBTM_SEC_SERV_REC   *p_cur_service;
     tBTM_SEC_CALLBACK   *p_callback;
@@ -627,6 +657,13 @@ typedef struct
     UINT8           switch_role_attempts;
 #endif
 
+    /* Index links, owned by btm_dev.c. Call btm_sec_dev_rec_reindex() after
+    ** changing any of the indexed fields above. */
+    struct t_btm_sec_dev_rec *p_idx_next[BTM_SEC_IDX_MAX];  /* hash chains */
+    UINT16          idx_bucket[BTM_SEC_IDX_MAX];    /* bucket filed in or BTM_SEC_IDX_NONE */
+    UINT32          idx_seq;                        /* allocation order */
+    struct t_btm_sec_dev_rec *p_lru_prev;           /* towards the oldest timestamp */
+    struct t_btm_sec_dev_rec *p_lru_next;           /* towards the newest timestamp */
 } tBTM_SEC_DEV_REC;
 
 #define BTM_SEC_IS_SM4(sm) ((BOOLEAN)(BTM_SM4_TRUE == ((sm)&BTM_SM4_TRUE)))
@@ -881,6 +918,10 @@ typedef struct
     UINT8                    disc_reason;   /* for legacy devices */
     tBTM_SEC_SERV_REC        sec_serv_rec[BTM_SEC_MAX_SERVICE_RECORDS];
     list_t                  *sec_dev_rec;   /* list of tBTM_SEC_DEV_REC */
+    tBTM_SEC_DEV_REC        *sec_dev_idx[BTM_SEC_IDX_MAX][BTM_SEC_DEV_HASH_SIZE];
+    tBTM_SEC_DEV_REC        *p_sec_dev_oldest;  /* LRU order by timestamp */
+    tBTM_SEC_DEV_REC        *p_sec_dev_newest;
+    UINT32                   sec_dev_seq;   /* allocation counter for idx_seq */
     tBTM_SEC_SERV_REC       *p_out_serv;
     tBTM_MKEY_CALLBACK      *mkey_cback;
 
@@ -951,6 +992,8 @@ extern void         btm_event_filter_complete (UINT8 *p);
 extern void         btm_inq_stop_on_ssp(void);
 extern void         btm_inq_clear_ssp(void);
 extern tINQ_DB_ENT *btm_inq_db_find (const BD_ADDR p_bda);
+extern void         btm_inq_db_touch (tINQ_DB_ENT *p_ent);
+extern void         btm_inq_db_remove (tINQ_DB_ENT *p_ent);
 extern BOOLEAN      btm_inq_find_bdaddr (BD_ADDR p_bda);
 
 extern BOOLEAN btm_lookup_eir(BD_ADDR_PTR p_rem_addr);
@@ -1052,6 +1095,8 @@ extern void btm_ble_add_2_white_list_complete(UINT8 status);
 extern void btm_ble_remove_from_white_list_complete(UINT8 *p, UINT16 evt_len);
 extern void btm_ble_clear_white_list_complete(UINT8 *p, UINT16 evt_len);
 extern BOOLEAN btm_ble_addr_resolvable(BD_ADDR rpa, tBTM_SEC_DEV_REC *p_dev_rec);
+extern tBTM_SEC_DEV_REC *btm_ble_rpa_cache_resolve(const BD_ADDR rpa);
+extern void btm_ble_rpa_cache_flush(void);
 extern tBTM_STATUS btm_ble_read_resolving_list_entry(tBTM_SEC_DEV_REC *p_dev_rec);
 extern BOOLEAN btm_ble_resolving_list_load_dev(tBTM_SEC_DEV_REC *p_dev_rec);
 extern void btm_ble_resolving_list_remove_dev(tBTM_SEC_DEV_REC *p_dev_rec);
@@ -1073,6 +1118,28 @@ extern void btm_delete_stored_link_key_complete (UINT8 *p);
 extern void btm_report_device_status (tBTM_DEV_STATUS status);
 
 
+/* Internal functions provided by btm_hci_txn.c
+**********************************************
+*/
+/* Completion of a command issued through the transaction layer. evt, ref and
+** p_ref are the values given when the command was issued. */
+typedef void (tBTM_HCI_TXN_CMPL_CBACK) (tBTM_VSC_CMPL *p_params, UINT8 evt,
+                                        UINT32 ref, void *p_ref);
+
+extern void btm_hci_txn_init(void);
+extern void btm_hci_txn_reset(void);
+extern void btm_hci_txn_flush(UINT8 client);
+extern void btm_hci_txn_begin(UINT8 client);
+extern void btm_hci_txn_end(UINT8 client);
+extern tBTM_STATUS btm_hci_txn_vsc(UINT8 client, UINT16 ocf, UINT8 param_len,
+                                   UINT8 *p_param, tBTM_HCI_TXN_CMPL_CBACK *p_cback,
+                                   UINT8 evt, UINT32 ref, void *p_ref);
+extern tBTM_STATUS btm_hci_txn_track(UINT8 client, UINT16 opcode,
+                                     tBTM_HCI_TXN_CMPL_CBACK *p_cback,
+                                     UINT8 evt, UINT32 ref, void *p_ref);
+extern void btm_hci_txn_cancel(UINT8 client, UINT16 opcode);
+extern BOOLEAN btm_hci_txn_cmd_complete(UINT8 *p, UINT16 opcode, UINT16 evt_len);
+
 /* Internal functions provided by btm_dev.c
 **********************************************
 */
@@ -1084,6 +1151,11 @@ extern void               btm_sec_free_dev (tBTM_SEC_DEV_REC *p_dev_rec);
 extern tBTM_SEC_DEV_REC  *btm_find_dev (const BD_ADDR bd_addr);
 extern tBTM_SEC_DEV_REC  *btm_find_or_alloc_dev (BD_ADDR bd_addr);
 extern tBTM_SEC_DEV_REC  *btm_find_dev_by_handle (UINT16 handle);
+#if BLE_INCLUDED == TRUE
+extern tBTM_SEC_DEV_REC  *btm_find_dev_by_static_addr (const BD_ADDR bd_addr);
+#endif
+extern void               btm_sec_dev_rec_reindex (tBTM_SEC_DEV_REC *p_dev_rec);
+extern void               btm_sec_dev_rec_touch (tBTM_SEC_DEV_REC *p_dev_rec);
 extern tBTM_BOND_TYPE     btm_get_bond_type_dev(BD_ADDR bd_addr);
 extern BOOLEAN            btm_set_bond_type_dev(BD_ADDR bd_addr,
                                                 tBTM_BOND_TYPE bond_type);
@@ -75,6 +75,7 @@ void btm_init (void)
 
     btm_cb.sec_dev_rec = list_new(osi_free);
 
+    btm_hci_txn_init();                 /* HCI command transactions */
     btm_dev_init();                     /* Device Manager Structures & HCI_Reset */
 }
 
@@ -2142,6 +2142,7 @@ tBTM_STATUS btm_sec_l2cap_access_req (BD_ADDR bd_addr, UINT16 psm, UINT16 handle
     p_dev_rec = btm_find_or_alloc_dev (bd_addr);
 
     p_dev_rec->hci_handle = handle;
+    btm_sec_dev_rec_reindex(p_dev_rec);
 
     /* Find the service record for the PSM */
     p_serv_rec = btm_sec_find_first_serv (conn_type, psm);
@@ -4484,7 +4485,7 @@ void btm_sec_connected (UINT8 *bda, UINT16 handle, UINT8 status, UINT8 enc_mode)
 #if BLE_INCLUDED == TRUE
         bit_shift = (handle == p_dev_rec->ble_hci_handle) ? 8 :0;
 #endif
-        p_dev_rec->timestamp = btm_cb.dev_rec_count++;
+        btm_sec_dev_rec_touch(p_dev_rec);
         if (p_dev_rec->sm4 & BTM_SM4_CONN_PEND)
         {
             /* tell L2CAP it's a bonding connection. */
@@ -4691,6 +4692,7 @@ void btm_sec_connected (UINT8 *bda, UINT16 handle, UINT8 status, UINT8 enc_mode)
     }
 
     p_dev_rec->hci_handle = handle;
+    btm_sec_dev_rec_reindex(p_dev_rec);
 
     /* role may not be correct here, it will be updated by l2cap, but we need to */
     /* notify btm_acl that link is up, so starting of rmt name request will not */
@@ -4858,6 +4860,7 @@ void btm_sec_disconnected (UINT16 handle, UINT8 reason)
         p_dev_rec->sec_flags &= ~(BTM_SEC_AUTHORIZED | BTM_SEC_AUTHENTICATED | BTM_SEC_ENCRYPTED
                 | BTM_SEC_ROLE_SWITCHED | BTM_SEC_16_DIGIT_PIN_AUTHED);
     }
+    btm_sec_dev_rec_reindex(p_dev_rec);
 
 #if BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE
     if (p_dev_rec->sec_state == BTM_SEC_STATE_DISCONNECTING_BOTH)
@@ -6313,6 +6316,10 @@ void btm_sec_clear_ble_keys (tBTM_SEC_DEV_REC  *p_dev_rec)
 #if (SMP_INCLUDED== TRUE)
     p_dev_rec->ble.key_type = BTM_LE_KEY_NONE;
     memset (&p_dev_rec->ble.keys, 0, sizeof(tBTM_SEC_BLE_KEYS));
+#if (BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE)
+    btm_ble_rpa_cache_flush();
+#endif
+    SMP_AesClearKeyCache();
 
 #if (BLE_PRIVACY_SPT == TRUE)
     btm_ble_resolving_list_remove_dev(p_dev_rec);
@@ -919,7 +919,7 @@ static void btu_hcif_hdl_command_complete (UINT16 opcode, UINT8 *p, UINT16 evt_l
         case HCI_BLE_WRITE_EXTENDED_SCAN_RSP_DATA:
         case HCI_BLE_WRITE_EXTENDED_ADV_PARAMS:
         case HCI_BLE_WRITE_EXTENDED_ADV_ENABLE:
-            btm_ble_adv_extension_operation_complete(p, opcode);
+            btm_hci_txn_cmd_complete(p, opcode, evt_len);
             break;
         case HCI_BLE_READ_MAX_ADV_LENGTH:
             btm_ble_read_inst_length_complete (p, evt_len);
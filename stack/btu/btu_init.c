@@ -115,8 +115,13 @@ void btu_free_core(void)
       /* Free the mandatory core stack components */
       l2c_free();
 
+      sdp_free();
+
 #if BLE_INCLUDED == TRUE
       gatt_free();
+#if (defined(SMP_INCLUDED) && SMP_INCLUDED == TRUE)
+      smp_ecc_free();
+#endif
 #endif
 }
 
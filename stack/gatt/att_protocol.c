@@ -438,6 +438,69 @@ tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg)
     return cmd_sent;
 }
 
+/*******************************************************************************
+**
+** Function         attp_send_sr_msg_multi
+**
+** Description      This function sends one server PDU to a set of clients.
+**                  Each link gets its own copy of the PDU cut to its MTU, as
+**                  L2CAP takes ownership of every buffer it is given. A
+**                  failure or congestion on one link does not stop the
+**                  others.
+**
+** Parameter        num_tcb: number of entries in pp_tcb and p_status.
+**                  pp_tcb: connection control blocks; a NULL entry is
+**                          reported as GATT_ILLEGAL_PARAMETER.
+**                  p_msg: the PDU to send, still owned by the caller.
+**                  p_status: per link result.
+**
+** Returns          GATT_SUCCESS if sent on at least one link; otherwise the
+**                  error code of the first link.
+**
+*******************************************************************************/
+tGATT_STATUS attp_send_sr_msg_multi (UINT8 num_tcb, tGATT_TCB **pp_tcb, BT_HDR *p_msg,
+                                     tGATT_STATUS *p_status)
+{
+    tGATT_STATUS    cmd_sent = GATT_ILLEGAL_PARAMETER;
+    BT_HDR          *p_buf;
+    UINT16          pdu_len;
+    UINT8           i;
+
+    for (i = 0; i < num_tcb; i ++)
+    {
+        if (pp_tcb[i] == NULL)
+        {
+            p_status[i] = GATT_ILLEGAL_PARAMETER;
+        }
+        else
+        {
+            pdu_len = p_msg->len;
+            if (pdu_len > pp_tcb[i]->payload_size)
+            {
+                pdu_len = pp_tcb[i]->payload_size;
+                GATT_TRACE_WARNING("attribute value too long, to be truncated to %d",
+                                   pdu_len - GATT_HDR_SIZE);
+            }
+
+            p_buf = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + pdu_len);
+            p_buf->offset = L2CAP_MIN_OFFSET;
+            p_buf->len = pdu_len;
+            p_buf->layer_specific = 0;
+            memcpy((UINT8 *)(p_buf + 1) + L2CAP_MIN_OFFSET,
+                   (UINT8 *)(p_msg + 1) + p_msg->offset, pdu_len);
+
+            p_status[i] = attp_send_sr_msg (pp_tcb[i], p_buf);
+        }
+
+        if (p_status[i] == GATT_SUCCESS || p_status[i] == GATT_CONGESTED)
+            cmd_sent = GATT_SUCCESS;
+        else if (i == 0)
+            cmd_sent = p_status[i];
+    }
+
+    return cmd_sent;
+}
+
 /*******************************************************************************
 **
 ** Function         attp_cl_send_cmd
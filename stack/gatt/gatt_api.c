@@ -33,9 +33,13 @@
 #include "gatt_int.h"
 #include "l2c_api.h"
 #include "btm_int.h"
+#include "osi/include/osi.h"
 
 #define SYSTEM_APP_GATT_IF  3
 
+/* every application must have a bit in the notification subscription mask */
+COMPILE_ASSERT(GATT_MAX_APPS <= GATT_NOTIF_SUB_MAX_APPS);
+
 /*******************************************************************************
 **
 ** Function         GATT_SetTraceLevel
@@ -445,6 +449,7 @@ BOOLEAN GATTS_DeleteService (tGATT_IF gatt_if, tBT_UUID *p_svc_uuid, UINT16 svc_
 
     gatt_remove_an_item_from_list(p_list_info, p_list);
     gatt_free_hdl_buffer(p_list);
+    gatt_sr_disc_cache_flush();
 
     return(TRUE);
 }
@@ -526,6 +531,7 @@ tGATT_STATUS GATTS_StartService (tGATT_IF gatt_if, UINT16 service_handle,
                                p_list->asgn_range.is_primary);
 
     gatt_add_a_srv_to_list(&gatt_cb.srv_list_info, &gatt_cb.srv_list[i_sreg]);
+    gatt_sr_disc_cache_flush();
 
     GATT_TRACE_DEBUG ("allocated i_sreg=%d ",i_sreg);
 
@@ -573,6 +579,7 @@ void GATTS_StopService (UINT16 service_handle)
         }
         gatt_remove_a_srv_from_list(&gatt_cb.srv_list_info, &gatt_cb.srv_list[ii]);
         gatt_cb.srv_list[ii].in_use = FALSE;
+        gatt_sr_disc_cache_flush();
         memset (&gatt_cb.sr_reg[ii], 0, sizeof(tGATT_SR_REG));
     }
     else
@@ -703,6 +710,66 @@ tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
     return cmd_sent;
 }
 
+/*******************************************************************************
+**
+** Function         GATTS_HandleValueNotificationMulti
+**
+** Description      This function sends the same handle value notification to
+**                  a set of clients. The ATT PDU is encoded once and copied
+**                  onto each link; a failure or congestion on one link does
+**                  not stop the notification to the others.
+**
+** Parameter        num_conn: number of entries in p_conn_id, at most
+**                            GATT_MAX_PHY_CHANNEL.
+**                  p_conn_id: connection identifiers to notify.
+**                  attr_handle: Attribute handle of this handle value notification.
+**                  val_len: Length of the notified attribute value.
+**                  p_val: Pointer to the notified attribute value data.
+**                  p_status: per connection result, GATT_CONGESTED if the link
+**                            accepted the PDU but is congested. May be NULL.
+**
+** Returns          GATT_SUCCESS if sent on at least one link; otherwise error code.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_HandleValueNotificationMulti (UINT8 num_conn, UINT16 *p_conn_id,
+                                                 UINT16 attr_handle, UINT16 val_len,
+                                                 UINT8 *p_val, tGATT_STATUS *p_status)
+{
+    tGATT_TCB       *tcbs[GATT_MAX_PHY_CHANNEL];
+    tGATT_STATUS    status[GATT_MAX_PHY_CHANNEL], cmd_sent;
+    BT_HDR          *p_pdu;
+    UINT8           i;
+
+    GATT_TRACE_API ("GATTS_HandleValueNotificationMulti num_conn=%d", num_conn);
+
+    if (!GATT_HANDLE_IS_VALID (attr_handle) || p_conn_id == NULL || num_conn == 0 ||
+        num_conn > GATT_MAX_PHY_CHANNEL)
+        return GATT_ILLEGAL_PARAMETER;
+
+    for (i = 0; i < num_conn; i ++)
+    {
+        tcbs[i] = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(p_conn_id[i]));
+
+        if (gatt_get_regcb(GATT_GET_GATT_IF(p_conn_id[i])) == NULL)
+            tcbs[i] = NULL;
+
+        if (tcbs[i] == NULL)
+            GATT_TRACE_ERROR ("GATTS_HandleValueNotificationMulti Unknown conn_id: %u ", p_conn_id[i]);
+    }
+
+    /* encode once for the largest MTU, each link gets a copy cut to its own MTU */
+    p_pdu = attp_build_value_cmd(GATT_MAX_MTU_SIZE, GATT_HANDLE_VALUE_NOTIF, attr_handle,
+                                 0, val_len, p_val);
+
+    cmd_sent = attp_send_sr_msg_multi(num_conn, tcbs, p_pdu, status);
+
+    if (p_status != NULL)
+        memcpy(p_status, status, num_conn * sizeof(tGATT_STATUS));
+
+    osi_free(p_pdu);
+    return cmd_sent;
+}
+
 /*******************************************************************************
 **
 ** Function         GATTS_SendRsp
@@ -1129,6 +1196,116 @@ tGATT_STATUS GATTC_SendHandleValueConfirm (UINT16 conn_id, UINT16 handle)
     return ret;
 }
 
+/*******************************************************************************
+**
+** Function         GATTC_SetNotifyFilter
+**
+** Description      This function is called to limit the notifications passed
+**                  to a client application to the handles it subscribed to
+**                  with GATTC_AddNotifySubscription. Indications are always
+**                  passed on.
+**
+** Parameters       gatt_if: application interface.
+**                  enable: TRUE to filter notifications, FALSE to receive all.
+**
+** Returns          TRUE if the filter was set.
+**
+*******************************************************************************/
+BOOLEAN GATTC_SetNotifyFilter (tGATT_IF gatt_if, BOOLEAN enable)
+{
+    tGATT_REG *p_reg = gatt_get_regcb(gatt_if);
+
+    GATT_TRACE_API ("GATTC_SetNotifyFilter gatt_if=%d enable=%d", gatt_if, enable);
+
+    if (p_reg == NULL || gatt_if > GATT_NOTIF_SUB_MAX_APPS)
+        return FALSE;
+
+    p_reg->notif_filter = enable;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         GATTC_AddNotifySubscription
+**
+** Description      This function is called to subscribe a client application
+**                  to the notifications of a peer handle.
+**
+** Parameters       gatt_if: application interface.
+**                  peer_bda: peer device address.
+**                  handle: characteristic value handle.
+**
+** Returns          TRUE if added. If the subscription table is full the
+**                  notification filter of the application is turned off.
+**
+*******************************************************************************/
+BOOLEAN GATTC_AddNotifySubscription (tGATT_IF gatt_if, BD_ADDR peer_bda, UINT16 handle)
+{
+    tGATT_REG       *p_reg = gatt_get_regcb(gatt_if);
+    tGATT_NOTIF_SUB *p_sub;
+
+    GATT_TRACE_API ("GATTC_AddNotifySubscription gatt_if=%d handle=0x%04x", gatt_if, handle);
+
+    if (p_reg == NULL || gatt_if > GATT_NOTIF_SUB_MAX_APPS || !GATT_HANDLE_IS_VALID(handle))
+        return FALSE;
+
+    if ((p_sub = gatt_find_notif_sub(peer_bda, handle)) == NULL &&
+        (p_sub = gatt_add_notif_sub(peer_bda, handle)) == NULL)
+    {
+        GATT_TRACE_WARNING("%s: subscription table full, gatt_if %d gets all notifications",
+                           __func__, gatt_if);
+        p_reg->notif_filter = FALSE;
+        return FALSE;
+    }
+
+    p_sub->app_mask |= GATT_NOTIF_SUB_BIT(gatt_if);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         GATTC_RemoveNotifySubscription
+**
+** Description      This function is called to remove the notification
+**                  subscriptions of a client application for a handle range
+**                  of a peer.
+**
+** Parameters       gatt_if: application interface.
+**                  peer_bda: peer device address.
+**                  start_handle: first handle of the range.
+**                  end_handle: last handle of the range.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void GATTC_RemoveNotifySubscription (tGATT_IF gatt_if, BD_ADDR peer_bda,
+                                     UINT16 start_handle, UINT16 end_handle)
+{
+    GATT_TRACE_API ("GATTC_RemoveNotifySubscription gatt_if=%d 0x%04x-0x%04x",
+                    gatt_if, start_handle, end_handle);
+
+    if (gatt_if == 0 || gatt_if > GATT_NOTIF_SUB_MAX_APPS)
+        return;
+
+    gatt_remove_notif_sub(gatt_if, peer_bda, start_handle, end_handle);
+}
+
+/*******************************************************************************
+**
+** Function         GATTC_GetReadStats
+**
+** Description      Reads the client read coalescing counters.
+**
+** Parameters       p_stats: filled with the counters.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void GATTC_GetReadStats (tGATT_CL_READ_STATS *p_stats)
+{
+    *p_stats = gatt_cb.cl_read_stats;
+}
+
 
 /*******************************************************************************/
 /*                                                                             */
@@ -1301,6 +1478,7 @@ void GATT_Deregister (tGATT_IF gatt_if)
     }
 
     gatt_deregister_bgdev_list(gatt_if);
+    gatt_remove_notif_sub(gatt_if, NULL, 0x0000, 0xFFFF);
     /* update the listen mode */
 #if (defined(BLE_PERIPHERAL_MODE_SUPPORT) && (BLE_PERIPHERAL_MODE_SUPPORT == TRUE))
     GATT_Listen(gatt_if, FALSE, NULL);
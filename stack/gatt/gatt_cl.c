@@ -47,6 +47,8 @@
 **                       G L O B A L      G A T T       D A T A                 *
 *********************************************************************************/
 void gatt_send_prepare_write(tGATT_TCB  *p_tcb, tGATT_CLCB *p_clcb);
+static void gatt_cl_read_len_update(tGATT_TCB *p_tcb, UINT16 handle, UINT16 len,
+                                    BOOLEAN complete);
 
 UINT8   disc_type_to_att_opcode[GATT_DISC_MAX] =
 {
@@ -665,6 +667,7 @@ void gatt_process_notification(tGATT_TCB *p_tcb, UINT8 op_code,
 {
     tGATT_VALUE     value;
     tGATT_REG       *p_reg;
+    tGATT_NOTIF_SUB *p_sub = NULL;
     UINT16          conn_id;
     tGATT_STATUS    encrypt_status;
     UINT8           *p= p_data, i,
@@ -724,11 +727,19 @@ void gatt_process_notification(tGATT_TCB *p_tcb, UINT8 op_code,
             attp_send_cl_msg(p_tcb, 0, GATT_HANDLE_VALUE_CONF, NULL);
     }
 
+    if (event == GATTC_OPTYPE_NOTIFICATION)
+        p_sub = gatt_find_notif_sub(p_tcb->peer_bda, value.handle);
+
     encrypt_status = gatt_get_link_encrypt_status(p_tcb);
     for (i = 0, p_reg = gatt_cb.cl_rcb; i < GATT_MAX_APPS; i++, p_reg++)
     {
         if (p_reg->in_use && p_reg->app_cb.p_cmpl_cb)
         {
+            /* skip applications not subscribed to this notification */
+            if (event == GATTC_OPTYPE_NOTIFICATION && p_reg->notif_filter &&
+                (p_sub == NULL || !(p_sub->app_mask & GATT_NOTIF_SUB_BIT(p_reg->gatt_if))))
+                continue;
+
             conn_id = GATT_CREATE_CONN_ID(p_tcb->tcb_idx, p_reg->gatt_if);
             (*p_reg->app_cb.p_cmpl_cb) (conn_id, event, encrypt_status, (tGATT_CL_COMPLETE *)&value);
         }
@@ -954,10 +965,14 @@ void gatt_process_read_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb,  UINT8 op_code,
     UINT16      offset = p_clcb->counter;
     UINT8       * p= p_data;
 
-    UNUSED(op_code);
-
     if (p_clcb->operation == GATTC_OPTYPE_READ)
     {
+        /* remember single read value lengths for later read coalescing */
+        if (op_code == GATT_RSP_READ && offset == 0 &&
+            p_clcb->op_subtype == GATT_READ_BY_HANDLE)
+            gatt_cl_read_len_update(p_tcb, p_clcb->s_handle, len,
+                                    (BOOLEAN)(len < p_tcb->payload_size - 1));
+
         if (p_clcb->op_subtype != GATT_READ_BY_HANDLE)
         {
             p_clcb->counter = len;
@@ -1092,6 +1107,264 @@ UINT8 gatt_cmd_to_rsp_code (UINT8 cmd_code)
     }
     return rsp_code;
 }
+/*******************************************************************************
+**
+** Function         gatt_cl_read_len_update
+**
+** Description      Record the value length returned by a single read of an
+**                  attribute. A length that changes, or a value that did not
+**                  fit into one response, marks the attribute as variable.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_cl_read_len_update(tGATT_TCB *p_tcb, UINT16 handle, UINT16 len,
+                                    BOOLEAN complete)
+{
+    tGATT_CL_READ_LEN *p_slot = NULL;
+    UINT8   i;
+
+    if (handle == 0)
+        return;
+
+    for (i = 0; i < GATT_CL_READ_LEN_CACHE_SIZE; i ++)
+    {
+        if (p_tcb->read_len[i].handle == handle)
+        {
+            p_slot = &p_tcb->read_len[i];
+            break;
+        }
+    }
+
+    if (p_slot == NULL)
+    {
+        p_slot = &p_tcb->read_len[p_tcb->read_len_next];
+        p_tcb->read_len_next = (p_tcb->read_len_next + 1) % GATT_CL_READ_LEN_CACHE_SIZE;
+
+        p_slot->handle = handle;
+        p_slot->len = len;
+        p_slot->count = complete ? 1 : 0;
+        return;
+    }
+
+    /* once variable, an attribute stays variable */
+    if (!complete || p_slot->len != len)
+        p_slot->count = 0;
+    else if (p_slot->count != 0 && p_slot->count < GATT_CL_READ_LEN_FIXED)
+        p_slot->count ++;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_read_len_set_variable
+**
+** Description      Mark the value length of an attribute as variable, so its
+**                  reads are no longer merged.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_cl_read_len_set_variable(tGATT_TCB *p_tcb, UINT16 handle)
+{
+    UINT8   i;
+
+    for (i = 0; i < GATT_CL_READ_LEN_CACHE_SIZE; i ++)
+    {
+        if (p_tcb->read_len[i].handle == handle)
+            p_tcb->read_len[i].count = 0;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_read_len_find
+**
+** Description      Look up the value length of an attribute whose length is
+**                  known to be fixed.
+**
+** Returns          TRUE if the length is known and fixed.
+**
+*******************************************************************************/
+static BOOLEAN gatt_cl_read_len_find(tGATT_TCB *p_tcb, UINT16 handle, UINT16 *p_len)
+{
+    UINT8   i;
+
+    for (i = 0; i < GATT_CL_READ_LEN_CACHE_SIZE; i ++)
+    {
+        if (p_tcb->read_len[i].handle == handle && handle != 0)
+        {
+            if (p_tcb->read_len[i].count < GATT_CL_READ_LEN_FIXED)
+                return FALSE;
+
+            *p_len = p_tcb->read_len[i].len;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_read_mergeable
+**
+** Description      Check whether a queued command is a plain read by handle
+**                  whose value length is known and fixed.
+**
+** Returns          TRUE if the read can be part of a Read Multiple request.
+**
+*******************************************************************************/
+static BOOLEAN gatt_cl_read_mergeable(tGATT_TCB *p_tcb, tGATT_CMD_Q *p_cmd, UINT16 *p_len)
+{
+    tGATT_CLCB  *p_clcb = &gatt_cb.clcb[p_cmd->clcb_idx];
+
+    if (!p_cmd->to_send || p_cmd->p_cmd == NULL || p_cmd->no_merge ||
+        p_cmd->op_code != GATT_REQ_READ)
+        return FALSE;
+
+    if (p_clcb->operation != GATTC_OPTYPE_READ ||
+        p_clcb->op_subtype != GATT_READ_BY_HANDLE || p_clcb->counter != 0)
+        return FALSE;
+
+    return gatt_cl_read_len_find(p_tcb, p_clcb->s_handle, p_len);
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_send_read_multi
+**
+** Description      Merge the reads at the head of the command queue into one
+**                  Read Multiple request when all values are known to fit
+**                  into a single response.
+**
+** Returns          TRUE if a Read Multiple request was sent.
+**
+*******************************************************************************/
+static BOOLEAN gatt_cl_send_read_multi(tGATT_TCB *p_tcb)
+{
+#if GATT_CL_READ_MULTI_MAX > 1
+    UINT16          handles[GATT_CL_READ_MULTI_MAX];
+    UINT16          total = 0, len;
+    UINT8           idx = p_tcb->pending_cl_req, num = 0, i;
+    tGATT_CMD_Q     *p_cmd;
+    tGATT_STATUS    att_ret;
+
+    if (p_tcb->no_read_multi)
+        return FALSE;
+
+    while (idx != p_tcb->next_slot_inq && num < GATT_CL_READ_MULTI_MAX)
+    {
+        p_cmd = &p_tcb->cl_cmd_q[idx];
+
+        /* a response filling the whole MTU could be truncated, stay below it */
+        if (!gatt_cl_read_mergeable(p_tcb, p_cmd, &len) ||
+            1 + 2 * (num + 1) > p_tcb->payload_size ||
+            total + len >= p_tcb->payload_size - 1)
+            break;
+
+        p_cmd->read_len = len;
+        handles[num ++] = gatt_cb.clcb[p_cmd->clcb_idx].s_handle;
+        total += len;
+        idx = (idx + 1) % GATT_CL_MAX_LCB;
+    }
+
+    if (num < 2)
+        return FALSE;
+
+    att_ret = attp_send_msg_to_l2cap(p_tcb,
+                                     attp_build_read_multi_cmd(p_tcb->payload_size, num, handles));
+    if (att_ret != GATT_SUCCESS && att_ret != GATT_CONGESTED)
+        return FALSE;
+
+    GATT_TRACE_DEBUG("%s: %d reads merged, %d bytes expected", __func__, num, total);
+
+    /* every merged read waits for the response with its own timer */
+    for (i = 0, idx = p_tcb->pending_cl_req; i < num; i ++, idx = (idx + 1) % GATT_CL_MAX_LCB)
+    {
+        p_cmd = &p_tcb->cl_cmd_q[idx];
+        osi_free_and_reset((void **)&p_cmd->p_cmd);
+        p_cmd->to_send = FALSE;
+        p_cmd->merged = 0;
+        gatt_start_rsp_timer (p_cmd->clcb_idx);
+    }
+
+    p_tcb->cl_cmd_q[p_tcb->pending_cl_req].merged = num - 1;
+    gatt_cb.cl_read_stats.read_multi_sent ++;
+
+    return TRUE;
+#else
+    UNUSED(p_tcb);
+    return FALSE;
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_process_read_multi_rsp
+**
+** Description      Split the response of a merged Read Multiple request back
+**                  to the individual reads. Any other response, an error or
+**                  values whose lengths do not add up, gets the reads rebuilt
+**                  in place and resent one by one, so each read ends with its
+**                  own value or status.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_cl_process_read_multi_rsp(tGATT_TCB *p_tcb, UINT8 op_code,
+                                           UINT16 len, UINT8 *p_data)
+{
+    tGATT_CMD_Q     *p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+    tGATT_CLCB      *p_clcb;
+    UINT8           num = p_cmd->merged + 1, i, idx, rsp_code;
+    UINT16          total = 0, read_len;
+
+    p_cmd->merged = 0;
+
+    for (i = 0, idx = p_tcb->pending_cl_req; i < num; i ++, idx = (idx + 1) % GATT_CL_MAX_LCB)
+    {
+        p_clcb = &gatt_cb.clcb[p_tcb->cl_cmd_q[idx].clcb_idx];
+        alarm_cancel(p_clcb->gatt_rsp_timer_ent);
+        p_clcb->retry_count = 0;
+        total += p_tcb->cl_cmd_q[idx].read_len;
+    }
+
+    /* the request was only sent if |total| stays below the MTU, so a
+    ** response of that length cannot have been truncated */
+    if (op_code == GATT_RSP_READ_MULTI && len == total)
+    {
+        for (i = 0; i < num; i ++)
+        {
+            read_len = p_tcb->cl_cmd_q[p_tcb->pending_cl_req].read_len;
+            p_clcb = gatt_cmd_dequeue(p_tcb, &rsp_code);
+            gatt_process_read_rsp(p_tcb, p_clcb, GATT_RSP_READ, read_len, p_data);
+            p_data += read_len;
+        }
+        gatt_cb.cl_read_stats.rtt_saved += num - 1;
+        return;
+    }
+
+    GATT_TRACE_WARNING("%s: op_code 0x%02x len %d (expected %d), resend %d reads",
+                       __func__, op_code, len, total, num);
+
+    if (op_code == GATT_RSP_ERROR && len >= 4 && p_data[3] == GATT_REQ_NOT_SUPPORTED)
+        p_tcb->no_read_multi = TRUE;
+
+    for (i = 0, idx = p_tcb->pending_cl_req; i < num; i ++, idx = (idx + 1) % GATT_CL_MAX_LCB)
+    {
+        p_cmd = &p_tcb->cl_cmd_q[idx];
+        p_clcb = &gatt_cb.clcb[p_cmd->clcb_idx];
+
+        /* a value length is not what was cached, stop merging reads of it */
+        if (op_code == GATT_RSP_READ_MULTI)
+            gatt_cl_read_len_set_variable(p_tcb, p_clcb->s_handle);
+
+        p_cmd->p_cmd = attp_build_handle_cmd(GATT_REQ_READ, p_clcb->s_handle, 0);
+        p_cmd->to_send = TRUE;
+        p_cmd->no_merge = TRUE;
+    }
+    gatt_cb.cl_read_stats.read_multi_fallback ++;
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_cl_send_next_cmd_inq
@@ -1113,6 +1386,9 @@ BOOLEAN gatt_cl_send_next_cmd_inq(tGATT_TCB *p_tcb)
            p_tcb->pending_cl_req != p_tcb->next_slot_inq &&
            p_cmd->to_send && p_cmd->p_cmd != NULL)
     {
+        if (gatt_cl_send_read_multi(p_tcb))
+            return TRUE;
+
         att_ret = attp_send_msg_to_l2cap(p_tcb, p_cmd->p_cmd);
 
         if (att_ret == GATT_SUCCESS || att_ret == GATT_CONGESTED)
@@ -1169,6 +1445,17 @@ void gatt_client_handle_server_rsp (tGATT_TCB *p_tcb, UINT8 op_code,
     tGATT_CLCB   *p_clcb = NULL;
     UINT8        rsp_code;
 
+    /* any response to reads merged into one Read Multiple request completes
+    ** or resends all of them */
+    if (op_code != GATT_HANDLE_VALUE_IND && op_code != GATT_HANDLE_VALUE_NOTIF &&
+        p_tcb->pending_cl_req != p_tcb->next_slot_inq &&
+        p_tcb->cl_cmd_q[p_tcb->pending_cl_req].merged != 0)
+    {
+        gatt_cl_process_read_multi_rsp(p_tcb, op_code, len, p_data);
+        gatt_cl_send_next_cmd_inq(p_tcb);
+        return;
+    }
+
     if (op_code != GATT_HANDLE_VALUE_IND && op_code != GATT_HANDLE_VALUE_NOTIF)
     {
         p_clcb = gatt_cmd_dequeue(p_tcb, &rsp_code);
@@ -42,6 +42,10 @@ static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db);
 static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PERM perm);
 static BOOLEAN deallocate_attr_in_db(tGATT_SVC_DB *p_db, void *p_attr);
 static BOOLEAN copy_extra_byte_in_db(tGATT_SVC_DB *p_db, void **p_dst, UINT16 len);
+static void gatts_add_attr_type_idx(tGATT_SVC_DB *p_db, tGATT_ATTR16 *p_attr);
+static void gatts_remove_attr_type_idx(tGATT_SVC_DB *p_db, tGATT_ATTR16 *p_attr);
+static UINT16 gatts_attr_type_idx_lower_bound(tGATT_SVC_DB *p_db, const UINT8 *p_uuid, UINT16 handle);
+static void gatts_uuid_to_uuid128(tBT_UUID *p_uuid, UINT8 uuid_128[LEN_UUID_128]);
 
 static BOOLEAN gatts_db_add_service_declaration(tGATT_SVC_DB *p_db, tBT_UUID *p_service, BOOLEAN is_pri);
 static tGATT_STATUS gatts_send_app_read_request(tGATT_TCB *p_tcb, UINT8 op_code,
@@ -65,7 +69,7 @@ BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN
     if(!p_db->svc_buffer)
        p_db->svc_buffer = fixed_queue_new(SIZE_MAX);
 
-    if (!allocate_svc_db_buf(p_db))
+    if (num_handle == 0 || !allocate_svc_db_buf(p_db))
     {
         GATT_TRACE_ERROR("gatts_init_service_db failed, no resources");
         return FALSE;
@@ -74,7 +78,13 @@ BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN
     GATT_TRACE_DEBUG("gatts_init_service_db");
     GATT_TRACE_DEBUG("s_hdl = %d num_handle = %d", s_hdl, num_handle );
 
+    /* one attribute slot and one type index entry per reserved handle */
+    gatts_free_attr_tbl(p_db);
+    p_db->p_attr_tbl = (tGATT_ATTR *)osi_calloc(num_handle * sizeof(tGATT_ATTR));
+    p_db->p_type_idx = (tGATT_ATTR_TYPE_IDX *)osi_calloc(num_handle * sizeof(tGATT_ATTR_TYPE_IDX));
+
     /* update service database information */
+    p_db->start_handle  = s_hdl;
     p_db->next_handle   = s_hdl;
     p_db->end_handle    = s_hdl + num_handle;
 
@@ -107,6 +117,46 @@ tBT_UUID * gatts_get_service_uuid (tGATT_SVC_DB *p_db)
     }
 }
 
+/*******************************************************************************
+**
+** Function         gatts_find_attr_by_handle
+**
+** Description      Look up an attribute in a service database by handle.
+**
+** Parameter        p_db: database pointer.
+**                  handle: attribute handle.
+**
+** Returns          pointer to the attribute, NULL if not in this database.
+**
+*******************************************************************************/
+tGATT_ATTR16 *gatts_find_attr_by_handle(tGATT_SVC_DB *p_db, UINT16 handle)
+{
+    if (!p_db || !p_db->p_attr_tbl ||
+        handle < p_db->start_handle || handle >= p_db->next_handle)
+        return NULL;
+
+    return &p_db->p_attr_tbl[handle - p_db->start_handle].attr16;
+}
+
+/*******************************************************************************
+**
+** Function         gatts_free_attr_tbl
+**
+** Description      Free the attribute table and type index of a service database.
+**
+** Parameter        p_db: database pointer.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void gatts_free_attr_tbl(tGATT_SVC_DB *p_db)
+{
+    osi_free_and_reset((void **)&p_db->p_attr_tbl);
+    osi_free_and_reset((void **)&p_db->p_type_idx);
+    p_db->type_idx_cnt = 0;
+    p_db->p_attr_list = NULL;
+}
+
 /*******************************************************************************
 **
 ** Function         gatts_check_attr_readability
@@ -334,75 +384,77 @@ tGATT_STATUS gatts_db_read_attr_value_by_type (tGATT_TCB   *p_tcb,
 {
     tGATT_STATUS status = GATT_NOT_FOUND;
     tGATT_ATTR16  *p_attr;
-    UINT16      len = 0;
+    UINT16      len = 0, idx;
     UINT8       *p = (UINT8 *)(p_rsp + 1) + p_rsp->len + L2CAP_MIN_OFFSET;
-    tBT_UUID    attr_uuid;
+    UINT8       type_uuid[LEN_UUID_128];
 
     if (p_db && p_db->p_attr_list)
     {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
+        /* an unspecified type matches every attribute, walk the table in handle
+        ** order; otherwise only visit the type index entries of this type */
+        if (type.len != 0)
+        {
+            gatts_uuid_to_uuid128(&type, type_uuid);
+            idx = gatts_attr_type_idx_lower_bound(p_db, type_uuid, s_handle);
+        }
+        else
+            idx = (s_handle > p_db->start_handle) ? (s_handle - p_db->start_handle) : 0;
 
-        while (p_attr && p_attr->handle <= e_handle)
+        for (;; idx ++)
         {
-            if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
-            {
-                attr_uuid.len = LEN_UUID_16;
-                attr_uuid.uu.uuid16 = p_attr->uuid;
-            }
-            else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
+            if (type.len != 0)
             {
-                attr_uuid.len = LEN_UUID_32;
-                attr_uuid.uu.uuid32 = ((tGATT_ATTR32 *)p_attr)->uuid;
+                if (idx >= p_db->type_idx_cnt ||
+                    memcmp(p_db->p_type_idx[idx].uuid, type_uuid, LEN_UUID_128) != 0)
+                    break;
+
+                p_attr = gatts_find_attr_by_handle(p_db, p_db->p_type_idx[idx].handle);
             }
             else
+                p_attr = gatts_find_attr_by_handle(p_db, (UINT16)(p_db->start_handle + idx));
+
+            if (p_attr == NULL || p_attr->handle > e_handle)
+                break;
+
+            if (*p_len <= 2)
             {
-                attr_uuid.len = LEN_UUID_128;
-                memcpy(attr_uuid.uu.uuid128, ((tGATT_ATTR128 *)p_attr)->uuid, LEN_UUID_128);
+                status = GATT_NO_RESOURCES;
+                break;
             }
 
-            if (p_attr->handle >= s_handle && gatt_uuid_compare(type, attr_uuid))
-            {
-                if (*p_len <= 2)
-                {
-                    status = GATT_NO_RESOURCES;
-                    break;
-                }
+            UINT16_TO_STREAM (p, p_attr->handle);
 
-                UINT16_TO_STREAM (p, p_attr->handle);
+            status = read_attr_value ((void *)p_attr, 0, &p, FALSE, (UINT16)(*p_len -2), &len, sec_flag, key_size);
 
-                status = read_attr_value ((void *)p_attr, 0, &p, FALSE, (UINT16)(*p_len -2), &len, sec_flag, key_size);
+            if (status == GATT_PENDING)
+            {
+                status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, 0, trans_id);
 
-                if (status == GATT_PENDING)
-                {
-                    status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, 0, trans_id);
+                /* one callback at a time */
+                break;
+            }
+            else if (status == GATT_SUCCESS)
+            {
+                if (p_rsp->offset == 0)
+                    p_rsp->offset = len + 2;
 
-                    /* one callback at a time */
-                    break;
-                }
-                else if (status == GATT_SUCCESS)
+                if (p_rsp->offset == len + 2)
                 {
-                    if (p_rsp->offset == 0)
-                        p_rsp->offset = len + 2;
-
-                    if (p_rsp->offset == len + 2)
-                    {
-                        p_rsp->len += (len  + 2);
-                        *p_len -= (len + 2);
-                    }
-                    else
-                    {
-                        GATT_TRACE_ERROR("format mismatch");
-                        status = GATT_NO_RESOURCES;
-                        break;
-                    }
+                    p_rsp->len += (len  + 2);
+                    *p_len -= (len + 2);
                 }
                 else
                 {
-                    *p_cur_handle = p_attr->handle;
+                    GATT_TRACE_ERROR("format mismatch");
+                    status = GATT_NO_RESOURCES;
                     break;
                 }
             }
-            p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+            else
+            {
+                *p_cur_handle = p_attr->handle;
+                break;
+            }
         }
     }
 
@@ -639,25 +691,15 @@ tGATT_STATUS gatts_read_attr_value_by_handle(tGATT_TCB *p_tcb,
     tGATT_ATTR16  *p_attr;
     UINT8       *pp = p_value;
 
-    if (p_db && p_db->p_attr_list)
+    if ((p_attr = gatts_find_attr_by_handle(p_db, handle)) != NULL)
     {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
+        status = read_attr_value (p_attr, offset, &pp,
+                                  (BOOLEAN)(op_code == GATT_REQ_READ_BLOB),
+                                  mtu, p_len, sec_flag, key_size);
 
-        while (p_attr && handle >= p_attr->handle)
+        if (status == GATT_PENDING)
         {
-            if (p_attr->handle == handle)
-            {
-                status = read_attr_value (p_attr, offset, &pp,
-                                          (BOOLEAN)(op_code == GATT_REQ_READ_BLOB),
-                                          mtu, p_len, sec_flag, key_size);
-
-                if (status == GATT_PENDING)
-                {
-                    status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, offset, trans_id);
-                }
-                break;
-            }
-            p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+            status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, offset, trans_id);
         }
     }
 
@@ -692,21 +734,11 @@ tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB *p_db,
     tGATT_STATUS status = GATT_NOT_FOUND;
     tGATT_ATTR16  *p_attr;
 
-    if (p_db && p_db->p_attr_list)
+    if ((p_attr = gatts_find_attr_by_handle(p_db, handle)) != NULL)
     {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
-
-        while (p_attr && handle >= p_attr->handle)
-        {
-            if (p_attr->handle == handle)
-            {
-                status = gatts_check_attr_readability (p_attr, 0,
-                                                       is_long,
-                                                       sec_flag, key_size);
-                break;
-            }
-            p_attr = (tGATT_ATTR16 *) p_attr->p_next;
-        }
+        status = gatts_check_attr_readability (p_attr, 0,
+                                               is_long,
+                                               sec_flag, key_size);
     }
 
     return status;
@@ -742,151 +774,140 @@ tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_code,
     GATT_TRACE_DEBUG( "gatts_write_attr_perm_check op_code=0x%0x handle=0x%04x offset=%d len=%d sec_flag=0x%0x key_size=%d",
                        op_code, handle, offset, len, sec_flag, key_size);
 
-    if (p_db != NULL)
+    if ((p_attr = gatts_find_attr_by_handle(p_db, handle)) != NULL)
     {
-        p_attr = (tGATT_ATTR16 *) p_db->p_attr_list;
+        perm = p_attr->permission;
+        min_key_size = (((perm & GATT_ENCRYPT_KEY_SIZE_MASK) >> 12));
+        if (min_key_size != 0 )
+        {
+            min_key_size +=6;
+        }
+        GATT_TRACE_DEBUG( "gatts_write_attr_perm_check p_attr->permission =0x%04x min_key_size==0x%04x",
+                           p_attr->permission,
+                           min_key_size);
 
-        while (p_attr != NULL)
+        if ((op_code == GATT_CMD_WRITE || op_code == GATT_REQ_WRITE)
+            && (perm & GATT_WRITE_SIGNED_PERM))
         {
-            if (p_attr->handle == handle)
+            /* use the rules for the mixed security see section 10.2.3*/
+            /* use security mode 1 level 2 when the following condition follows */
+            /* LE security mode 2 level 1 and LE security mode 1 level 2 */
+            if ((perm & GATT_PERM_WRITE_SIGNED) && (perm & GATT_PERM_WRITE_ENCRYPTED))
             {
-                perm = p_attr->permission;
-                min_key_size = (((perm & GATT_ENCRYPT_KEY_SIZE_MASK) >> 12));
-                if (min_key_size != 0 )
-                {
-                    min_key_size +=6;
-                }
-                GATT_TRACE_DEBUG( "gatts_write_attr_perm_check p_attr->permission =0x%04x min_key_size==0x%04x",
-                                   p_attr->permission,
-                                   min_key_size);
-
-                if ((op_code == GATT_CMD_WRITE || op_code == GATT_REQ_WRITE)
-                    && (perm & GATT_WRITE_SIGNED_PERM))
-                {
-                    /* use the rules for the mixed security see section 10.2.3*/
-                    /* use security mode 1 level 2 when the following condition follows */
-                    /* LE security mode 2 level 1 and LE security mode 1 level 2 */
-                    if ((perm & GATT_PERM_WRITE_SIGNED) && (perm & GATT_PERM_WRITE_ENCRYPTED))
-                    {
-                        perm = GATT_PERM_WRITE_ENCRYPTED;
-                    }
-                    /* use security mode 1 level 3 when the following condition follows */
-                    /* LE security mode 2 level 2 and security mode 1 and LE */
-                    else if (((perm & GATT_PERM_WRITE_SIGNED_MITM) && (perm & GATT_PERM_WRITE_ENCRYPTED)) ||
-                              /* LE security mode 2 and security mode 1 level 3 */
-                             ((perm & GATT_WRITE_SIGNED_PERM) && (perm & GATT_PERM_WRITE_ENC_MITM)))
-                    {
-                        perm = GATT_PERM_WRITE_ENC_MITM;
-                    }
-                }
+                perm = GATT_PERM_WRITE_ENCRYPTED;
+            }
+            /* use security mode 1 level 3 when the following condition follows */
+            /* LE security mode 2 level 2 and security mode 1 and LE */
+            else if (((perm & GATT_PERM_WRITE_SIGNED_MITM) && (perm & GATT_PERM_WRITE_ENCRYPTED)) ||
+                      /* LE security mode 2 and security mode 1 level 3 */
+                     ((perm & GATT_WRITE_SIGNED_PERM) && (perm & GATT_PERM_WRITE_ENC_MITM)))
+            {
+                perm = GATT_PERM_WRITE_ENC_MITM;
+            }
+        }
 
-                if ((op_code == GATT_SIGN_CMD_WRITE) && !(perm & GATT_WRITE_SIGNED_PERM))
-                {
-                    status = GATT_WRITE_NOT_PERMIT;
-                    GATT_TRACE_DEBUG( "gatts_write_attr_perm_check - sign cmd write not allowed");
-                }
-                 if ((op_code == GATT_SIGN_CMD_WRITE) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED))
-                {
-                    status = GATT_INVALID_PDU;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - Error!! sign cmd write sent on a encypted link");
-                }
-                else if (!(perm & GATT_WRITE_ALLOWED))
-                {
+        if ((op_code == GATT_SIGN_CMD_WRITE) && !(perm & GATT_WRITE_SIGNED_PERM))
+        {
+            status = GATT_WRITE_NOT_PERMIT;
+            GATT_TRACE_DEBUG( "gatts_write_attr_perm_check - sign cmd write not allowed");
+        }
+         if ((op_code == GATT_SIGN_CMD_WRITE) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED))
+        {
+            status = GATT_INVALID_PDU;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - Error!! sign cmd write sent on a encypted link");
+        }
+        else if (!(perm & GATT_WRITE_ALLOWED))
+        {
+            status = GATT_WRITE_NOT_PERMIT;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_WRITE_NOT_PERMIT");
+        }
+        /* require authentication, but not been authenticated */
+        else if ((perm & GATT_WRITE_AUTH_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_UNAUTHED))
+        {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION");
+        }
+        else if ((perm & GATT_WRITE_MITM_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_AUTHED))
+        {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: MITM required");
+        }
+        else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED))
+        {
+            status = GATT_INSUF_ENCRYPTION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_ENCRYPTION");
+        }
+        else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED) && (key_size < min_key_size))
+        {
+            status = GATT_INSUF_KEY_SIZE;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_KEY_SIZE");
+        }
+        /* LE security mode 2 attribute  */
+        else if (perm & GATT_WRITE_SIGNED_PERM && op_code != GATT_SIGN_CMD_WRITE && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED)
+            &&  (perm & GATT_WRITE_ALLOWED) == 0)
+        {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: LE security mode 2 required");
+        }
+        else /* writable: must be char value declaration or char descritpors */
+        {
+            if(p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
+            {
+            switch (p_attr->uuid)
+            {
+                case GATT_UUID_CHAR_PRESENT_FORMAT:/* should be readable only */
+                case GATT_UUID_CHAR_EXT_PROP:/* should be readable only */
+                case GATT_UUID_CHAR_AGG_FORMAT: /* should be readable only */
+                    case GATT_UUID_CHAR_VALID_RANGE:
                     status = GATT_WRITE_NOT_PERMIT;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_WRITE_NOT_PERMIT");
-                }
-                /* require authentication, but not been authenticated */
-                else if ((perm & GATT_WRITE_AUTH_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_UNAUTHED))
-                {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION");
-                }
-                else if ((perm & GATT_WRITE_MITM_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_AUTHED))
-                {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: MITM required");
-                }
-                else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED))
-                {
-                    status = GATT_INSUF_ENCRYPTION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_ENCRYPTION");
+                    break;
+
+                case GATT_UUID_CHAR_CLIENT_CONFIG:
+/* coverity[MISSING_BREAK] */
+/* intnended fall through, ignored */
+                    /* fall through */
+                case GATT_UUID_CHAR_SRVR_CONFIG:
+                    max_size = 2;
+                case GATT_UUID_CHAR_DESCRIPTION:
+                default: /* any other must be character value declaration */
+                    status = GATT_SUCCESS;
+                    break;
                 }
-                else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED) && (key_size < min_key_size))
+            }
+            else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_128 ||
+				              p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
+            {
+                 status = GATT_SUCCESS;
+            }
+            else
+            {
+                status = GATT_INVALID_PDU;
+            }
+
+            if (p_data == NULL && len  > 0)
+            {
+                status = GATT_INVALID_PDU;
+            }
+            /* these attribute does not allow write blob */
+            else if ( (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) &&
+                      (p_attr->uuid == GATT_UUID_CHAR_CLIENT_CONFIG ||
+                       p_attr->uuid == GATT_UUID_CHAR_SRVR_CONFIG) )
+            {
+                if (op_code == GATT_REQ_PREPARE_WRITE && offset != 0) /* does not allow write blob */
                 {
-                    status = GATT_INSUF_KEY_SIZE;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_KEY_SIZE");
+                    status = GATT_NOT_LONG;
+                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_NOT_LONG");
                 }
-                /* LE security mode 2 attribute  */
-                else if (perm & GATT_WRITE_SIGNED_PERM && op_code != GATT_SIGN_CMD_WRITE && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED)
-                    &&  (perm & GATT_WRITE_ALLOWED) == 0)
+                else if (len != max_size)    /* data does not match the required format */
                 {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: LE security mode 2 required");
+                    status = GATT_INVALID_ATTR_LEN;
+                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INVALID_PDU");
                 }
-                else /* writable: must be char value declaration or char descritpors */
+                else
                 {
-                    if(p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
-                    {
-                    switch (p_attr->uuid)
-                    {
-                        case GATT_UUID_CHAR_PRESENT_FORMAT:/* should be readable only */
-                        case GATT_UUID_CHAR_EXT_PROP:/* should be readable only */
-                        case GATT_UUID_CHAR_AGG_FORMAT: /* should be readable only */
-                            case GATT_UUID_CHAR_VALID_RANGE:
-                            status = GATT_WRITE_NOT_PERMIT;
-                            break;
-
-                        case GATT_UUID_CHAR_CLIENT_CONFIG:
-/* coverity[MISSING_BREAK] */
-/* intnended fall through, ignored */
-                            /* fall through */
-                        case GATT_UUID_CHAR_SRVR_CONFIG:
-                            max_size = 2;
-                        case GATT_UUID_CHAR_DESCRIPTION:
-                        default: /* any other must be character value declaration */
-                            status = GATT_SUCCESS;
-                            break;
-                        }
-                    }
-                    else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_128 ||
-				              p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
-                    {
-                         status = GATT_SUCCESS;
-                    }
-                    else
-                    {
-                        status = GATT_INVALID_PDU;
-                    }
-
-                    if (p_data == NULL && len  > 0)
-                    {
-                        status = GATT_INVALID_PDU;
-                    }
-                    /* these attribute does not allow write blob */
-                    else if ( (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) &&
-                              (p_attr->uuid == GATT_UUID_CHAR_CLIENT_CONFIG ||
-                               p_attr->uuid == GATT_UUID_CHAR_SRVR_CONFIG) )
-                    {
-                        if (op_code == GATT_REQ_PREPARE_WRITE && offset != 0) /* does not allow write blob */
-                        {
-                            status = GATT_NOT_LONG;
-                            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_NOT_LONG");
-                        }
-                        else if (len != max_size)    /* data does not match the required format */
-                        {
-                            status = GATT_INVALID_ATTR_LEN;
-                            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INVALID_PDU");
-                        }
-                        else
-                        {
-                            status = GATT_SUCCESS;
-                        }
-                    }
+                    status = GATT_SUCCESS;
                 }
-                break;
             }
-            else
-                p_attr = (tGATT_ATTR16 *)p_attr->p_next;
         }
     }
 
@@ -897,9 +918,9 @@ tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_code,
 **
 ** Function         allocate_attr_in_db
 **
-** Description      Allocate a memory space for a new attribute, and link this
-**                  attribute into the database attribute list.
-**
+** Description      Allocate the attribute table slot of the next handle for a
+**                  new attribute, and link this attribute into the database
+**                  attribute list and type index.
 **
 ** Parameter        p_db    : database pointer.
 **                  p_uuid:     pointer to attribute UUID
@@ -910,10 +931,9 @@ tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_code,
 *******************************************************************************/
 static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PERM perm)
 {
-    tGATT_ATTR16    *p_attr16 = NULL, *p_last;
+    tGATT_ATTR16    *p_attr16 = NULL;
     tGATT_ATTR32    *p_attr32 = NULL;
     tGATT_ATTR128   *p_attr128 = NULL;
-    UINT16      len = sizeof(tGATT_ATTR128);
 
     if (p_uuid == NULL)
     {
@@ -921,13 +941,6 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
         return NULL;
     }
 
-    if (p_uuid->len == LEN_UUID_16)
-        len = sizeof(tGATT_ATTR16);
-    else if (p_uuid->len == LEN_UUID_32)
-        len = sizeof(tGATT_ATTR32);
-
-    GATT_TRACE_DEBUG("allocate attr %d bytes ",len);
-
     if (p_db->end_handle <= p_db->next_handle)
     {
         GATT_TRACE_DEBUG("handle space full. handle_max = %d next_handle = %d",
@@ -935,16 +948,15 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
         return NULL;
     }
 
-    if (p_db->mem_free < len)
+    if (p_db->p_attr_tbl == NULL)
     {
-        if (!allocate_svc_db_buf(p_db))
-        {
-            GATT_TRACE_ERROR("allocate_attr_in_db failed, no resources");
-            return NULL;
-        }
+        GATT_TRACE_ERROR("allocate_attr_in_db failed, service DB not initialized");
+        return NULL;
     }
-    memset(p_db->p_free_mem, 0, len);
-    p_attr16 = (tGATT_ATTR16 *) p_db->p_free_mem;
+
+    /* the attribute lives in the table slot of its handle */
+    p_attr16 = &p_db->p_attr_tbl[p_db->next_handle - p_db->start_handle].attr16;
+    memset(p_attr16, 0, sizeof(tGATT_ATTR));
 
     if (p_uuid->len == LEN_UUID_16 && p_uuid->uu.uuid16 != GATT_ILLEGAL_UUID)
     {
@@ -953,36 +965,31 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
     }
     else if (p_uuid->len == LEN_UUID_32)
     {
-        p_attr32 = (tGATT_ATTR32 *) p_db->p_free_mem;
+        p_attr32 = (tGATT_ATTR32 *) p_attr16;
         p_attr32->uuid_type = GATT_ATTR_UUID_TYPE_32;
         p_attr32->uuid = p_uuid->uu.uuid32;
     }
     else if (p_uuid->len == LEN_UUID_128)
     {
-        p_attr128 = (tGATT_ATTR128 *) p_db->p_free_mem;
+        p_attr128 = (tGATT_ATTR128 *) p_attr16;
         p_attr128->uuid_type = GATT_ATTR_UUID_TYPE_128;
         memcpy(p_attr128->uuid, p_uuid->uu.uuid128, LEN_UUID_128);
     }
 
-    p_db->p_free_mem += len;
-    p_db->mem_free -= len;
-
     p_attr16->handle = p_db->next_handle++;
     p_attr16->permission = perm;
     p_attr16->p_next = NULL;
 
-    /* link the attribute record into the end of DB */
+    /* link the attribute record into the end of DB, right after the previous handle */
     if (p_db->p_attr_list == NULL)
         p_db->p_attr_list = p_attr16;
     else
-    {
-        p_last = (tGATT_ATTR16 *)p_db->p_attr_list;
+        p_db->p_attr_tbl[p_attr16->handle - 1 - p_db->start_handle].attr16.p_next = p_attr16;
 
-        while (p_last != NULL && p_last->p_next != NULL)
-            p_last = (tGATT_ATTR16 *)p_last->p_next;
+    gatts_add_attr_type_idx(p_db, p_attr16);
 
-        p_last->p_next = p_attr16;
-    }
+    /* the attribute may be added to a started service */
+    gatt_sr_disc_cache_flush();
 
     if (p_attr16->uuid_type == GATT_ATTR_UUID_TYPE_16)
     {
@@ -1009,7 +1016,9 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
 **
 ** Function         deallocate_attr_in_db
 **
-** Description      Free an attribute within the database.
+** Description      Free an attribute within the database. Attributes are
+**                  allocated in handle order, so only the most recently
+**                  allocated attribute can be freed.
 **
 ** Parameter        p_db: database pointer.
 **                  p_attr: pointer to the attribute record to be freed.
@@ -1019,34 +1028,132 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
 *******************************************************************************/
 static BOOLEAN deallocate_attr_in_db(tGATT_SVC_DB *p_db, void *p_attr)
 {
-    tGATT_ATTR16  *p_cur, *p_next;
-    BOOLEAN     found = FALSE;
-
-    if (p_db->p_attr_list == NULL)
-        return found;
+    tGATT_ATTR16  *p_last = NULL;
 
-    p_cur   = (tGATT_ATTR16 *) p_db->p_attr_list;
-    p_next  = (tGATT_ATTR16 *) p_cur->p_next;
+    if (p_db->next_handle > p_db->start_handle)
+        p_last = gatts_find_attr_by_handle(p_db, p_db->next_handle - 1);
 
-    for (; p_cur != NULL && p_next != NULL;
-        p_cur = p_next, p_next = (tGATT_ATTR16 *)p_next->p_next)
+    if (p_last == NULL || p_last != p_attr)
     {
-        if (p_next == p_attr)
-        {
-            p_cur->p_next = p_next->p_next;
-            found = TRUE;
-        }
+        GATT_TRACE_ERROR("deallocate_attr_in_db: not the last attribute");
+        return FALSE;
     }
-    if (p_cur == p_attr && p_cur == p_db->p_attr_list)
+
+    gatts_remove_attr_type_idx(p_db, p_last);
+    p_db->next_handle --;
+
+    if (p_last == p_db->p_attr_list)
+        p_db->p_attr_list = NULL;
+    else
+        p_db->p_attr_tbl[p_db->next_handle - 1 - p_db->start_handle].attr16.p_next = NULL;
+
+    memset(p_last, 0, sizeof(tGATT_ATTR));
+    gatt_sr_disc_cache_flush();
+
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         gatts_uuid_to_uuid128
+**
+** Description      Expand a 16, 32 or 128 bits UUID into its 128 bits form.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void gatts_uuid_to_uuid128(tBT_UUID *p_uuid, UINT8 uuid_128[LEN_UUID_128])
+{
+    if (p_uuid->len == LEN_UUID_16)
+        gatt_convert_uuid16_to_uuid128(uuid_128, p_uuid->uu.uuid16);
+    else if (p_uuid->len == LEN_UUID_32)
+        gatt_convert_uuid32_to_uuid128(uuid_128, p_uuid->uu.uuid32);
+    else
+        memcpy(uuid_128, p_uuid->uu.uuid128, LEN_UUID_128);
+}
+
+/*******************************************************************************
+**
+** Function         gatts_attr_type_idx_lower_bound
+**
+** Description      Binary search the type index for the first entry that is
+**                  not less than (uuid, handle).
+**
+** Returns          index of the entry, type_idx_cnt if there is none.
+**
+*******************************************************************************/
+static UINT16 gatts_attr_type_idx_lower_bound(tGATT_SVC_DB *p_db, const UINT8 *p_uuid, UINT16 handle)
+{
+    UINT16  lo = 0, hi = p_db->type_idx_cnt, mid;
+    int     cmp;
+
+    while (lo < hi)
     {
-        p_db->p_attr_list = p_cur->p_next;
-        found = TRUE;
+        mid = lo + (hi - lo) / 2;
+        cmp = memcmp(p_db->p_type_idx[mid].uuid, p_uuid, LEN_UUID_128);
+
+        if (cmp < 0 || (cmp == 0 && p_db->p_type_idx[mid].handle < handle))
+            lo = mid + 1;
+        else
+            hi = mid;
     }
-    /* else attr not found */
-    if ( found)
-        p_db->next_handle --;
+    return lo;
+}
 
-    return found;
+/*******************************************************************************
+**
+** Function         gatts_add_attr_type_idx
+**
+** Description      Insert an attribute into the type index of the database.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void gatts_add_attr_type_idx(tGATT_SVC_DB *p_db, tGATT_ATTR16 *p_attr)
+{
+    tGATT_ATTR_TYPE_IDX entry;
+    UINT16              pos;
+
+    if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
+        gatt_convert_uuid16_to_uuid128(entry.uuid, p_attr->uuid);
+    else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
+        gatt_convert_uuid32_to_uuid128(entry.uuid, ((tGATT_ATTR32 *)p_attr)->uuid);
+    else
+        memcpy(entry.uuid, ((tGATT_ATTR128 *)p_attr)->uuid, LEN_UUID_128);
+    entry.handle = p_attr->handle;
+
+    pos = gatts_attr_type_idx_lower_bound(p_db, entry.uuid, entry.handle);
+
+    /* the index has room for every handle reserved by the service */
+    memmove(&p_db->p_type_idx[pos + 1], &p_db->p_type_idx[pos],
+            (p_db->type_idx_cnt - pos) * sizeof(tGATT_ATTR_TYPE_IDX));
+    p_db->p_type_idx[pos] = entry;
+    p_db->type_idx_cnt ++;
+}
+
+/*******************************************************************************
+**
+** Function         gatts_remove_attr_type_idx
+**
+** Description      Remove an attribute from the type index of the database.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void gatts_remove_attr_type_idx(tGATT_SVC_DB *p_db, tGATT_ATTR16 *p_attr)
+{
+    UINT16  pos;
+
+    for (pos = 0; pos < p_db->type_idx_cnt; pos ++)
+    {
+        if (p_db->p_type_idx[pos].handle == p_attr->handle)
+        {
+            memmove(&p_db->p_type_idx[pos], &p_db->p_type_idx[pos + 1],
+                    (p_db->type_idx_cnt - pos - 1) * sizeof(tGATT_ATTR_TYPE_IDX));
+            p_db->type_idx_cnt --;
+            break;
+        }
+    }
 }
 
 /*******************************************************************************
@@ -210,15 +210,37 @@ typedef struct
     UINT8                               uuid[LEN_UUID_128];
 } tGATT_ATTR128;
 
+/* Attribute slot in the handle indexed attribute table of a service; large
+** enough to hold any of tGATT_ATTR16, tGATT_ATTR32 or tGATT_ATTR128.
+*/
+typedef union
+{
+    tGATT_ATTR16                        attr16;
+    tGATT_ATTR32                        attr32;
+    tGATT_ATTR128                       attr128;
+} tGATT_ATTR;
+
+/* Attribute type index entry, sorted by (uuid, handle) for Read By Type
+*/
+typedef struct
+{
+    UINT8                               uuid[LEN_UUID_128]; /* attribute type in 128 bits form */
+    UINT16                              handle;
+} tGATT_ATTR_TYPE_IDX;
+
 /* Service Database definition
 */
 typedef struct
 {
     void            *p_attr_list;               /* pointer to the first attribute,
                                                   either tGATT_ATTR16 or tGATT_ATTR128 */
+    tGATT_ATTR      *p_attr_tbl;                /* attributes indexed by (handle - start_handle) */
+    tGATT_ATTR_TYPE_IDX *p_type_idx;            /* attribute handles sorted by type */
+    UINT16          type_idx_cnt;               /* number of entries in p_type_idx */
     UINT8           *p_free_mem;                /* Pointer to free memory       */
     fixed_queue_t   *svc_buffer;                /* buffer queue used for service database */
     UINT32          mem_free;                   /* Memory still available       */
+    UINT16          start_handle;               /* First handle number          */
     UINT16          end_handle;                 /* Last handle number           */
     UINT16          next_handle;                /* Next usable handle value     */
 } tGATT_SVC_DB;
@@ -255,8 +277,31 @@ typedef struct
     tGATT_IF     gatt_if; /* one based */
     BOOLEAN      in_use;
     UINT8        listening; /* if adv for all has been enabled */
+    BOOLEAN      notif_filter; /* only deliver notifications found in notif_sub */
 } tGATT_REG;
 
+/* notification subscription of client applications, app_mask 0 means unused */
+typedef struct
+{
+    BD_ADDR      peer_bda;
+    UINT16       handle;
+    UINT32       app_mask;  /* GATT_NOTIF_SUB_BIT() of each subscribed application */
+    UINT8        next;      /* one based index of the next entry in the handle bucket, 0 ends */
+} tGATT_NOTIF_SUB;
+
+#define GATT_NOTIF_SUB_BIT(gatt_if)     ((UINT32)1 << ((gatt_if) - 1))
+
+/* applications that have a bit in tGATT_NOTIF_SUB.app_mask, gatt_if 1 to this */
+#define GATT_NOTIF_SUB_MAX_APPS         ((int)sizeof(((tGATT_NOTIF_SUB *)0)->app_mask) * 8)
+
+/* subscriptions are chained into buckets by handle, the count must be a power of 2 */
+#define GATT_NOTIF_SUB_BUCKETS          16
+#define GATT_NOTIF_SUB_HASH(handle)     ((handle) & (GATT_NOTIF_SUB_BUCKETS - 1))
+
+#if GATT_CL_MAX_NOTIF_SUB > 255
+#error "GATT_CL_MAX_NOTIF_SUB must fit the one based UINT8 bucket links"
+#endif
+
 
 
 
@@ -267,8 +312,22 @@ typedef struct
     UINT16      clcb_idx;
     UINT8       op_code;
     BOOLEAN     to_send;
+    UINT8       merged;     /* number of following reads merged into this Read Multiple */
+    BOOLEAN     no_merge;   /* send as a single read, Read Multiple is not supported */
+    UINT16      read_len;   /* expected value length while merged */
 }tGATT_CMD_Q;
 
+/* A value length is taken as fixed once this many complete reads agreed on it */
+#define GATT_CL_READ_LEN_FIXED      2
+
+/* value length of a previously read attribute, handle 0 means unused */
+typedef struct
+{
+    UINT16      handle;
+    UINT16      len;
+    UINT8       count;      /* complete reads that returned len, 0 if the length varies */
+}tGATT_CL_READ_LEN;
+
 
 #if GATT_MAX_SR_PROFILES <= 8
 typedef UINT8 tGATT_APP_MASK;
@@ -378,6 +437,10 @@ typedef struct
     UINT8           pending_cl_req;
     UINT8           next_slot_inq;    /* index of next available slot in queue */
 
+    tGATT_CL_READ_LEN read_len[GATT_CL_READ_LEN_CACHE_SIZE];
+    UINT8           read_len_next;    /* next read_len slot to replace */
+    BOOLEAN         no_read_multi;    /* peer rejected Read Multiple */
+
     BOOLEAN         in_use;
     UINT8           tcb_idx;
 } tGATT_TCB;
@@ -433,6 +496,30 @@ typedef struct
     UINT32      service_change;
 }tGATT_SVC_CHG;
 
+/* discovery request a cached server response was built for
+*/
+typedef struct
+{
+    tBT_UUID    type;           /* attribute (group) type filter */
+    tBT_UUID    value;          /* Find By Type Value filter */
+    UINT16      s_hdl;
+    UINT16      e_hdl;
+    UINT16      mtu;            /* payload size the response was built for */
+    UINT8       op_code;
+} tGATT_SR_DISC_KEY;
+
+/* serialized discovery response, replayed as long as the database is unchanged
+*/
+typedef struct
+{
+    tGATT_SR_DISC_KEY   key;
+    UINT8               *p_pdu;     /* response PDU, NULL for an error response */
+    UINT32              last_used;
+    UINT16              len;
+    tGATT_STATUS        status;
+    BOOLEAN             in_use;
+} tGATT_SR_DISC_CACHE;
+
 typedef struct
 {
     tGATT_IF        gatt_if[GATT_MAX_APPS];
@@ -501,6 +588,16 @@ typedef struct
     tGATT_HDL_CFG           hdl_cfg;
     tGATT_BG_CONN_DEV       bgconn_dev[GATT_MAX_BG_CONN_DEV];
 
+    tGATT_SR_DISC_CACHE     sr_disc_cache[GATT_SR_DISC_CACHE_SIZE];
+    UINT32                  sr_disc_cache_seq;      /* LRU clock for sr_disc_cache */
+    UINT32                  sr_disc_cache_hits;
+    UINT32                  sr_disc_cache_misses;
+
+    tGATT_CL_READ_STATS     cl_read_stats;
+
+    tGATT_NOTIF_SUB         notif_sub[GATT_CL_MAX_NOTIF_SUB];
+    UINT8                   notif_sub_bucket[GATT_NOTIF_SUB_BUCKETS]; /* one based first entry, 0 empty */
+
 } tGATT_CB;
 
 
@@ -553,7 +650,13 @@ extern UINT16 gatt_profile_find_conn_id_by_bd_addr(BD_ADDR bda);
 /* Functions provided by att_protocol.c */
 extern tGATT_STATUS attp_send_cl_msg (tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 op_code, tGATT_CL_MSG *p_msg);
 extern BT_HDR *attp_build_sr_msg(tGATT_TCB *p_tcb, UINT8 op_code, tGATT_SR_MSG *p_msg);
+extern BT_HDR *attp_build_value_cmd (UINT16 payload_size, UINT8 op_code, UINT16 handle,
+                                     UINT16 offset, UINT16 len, UINT8 *p_data);
+extern BT_HDR *attp_build_handle_cmd(UINT8 op_code, UINT16 handle, UINT16 offset);
+extern BT_HDR *attp_build_read_multi_cmd(UINT16 payload_size, UINT16 num_handle, UINT16 *p_handle);
 extern tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg);
+extern tGATT_STATUS attp_send_sr_msg_multi (UINT8 num_tcb, tGATT_TCB **pp_tcb, BT_HDR *p_msg,
+                                            tGATT_STATUS *p_status);
 extern tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB *p_tcb, BT_HDR *p_toL2CAP);
 
 /* utility functions */
@@ -562,6 +665,7 @@ extern UINT32 gatt_add_sdp_record (tBT_UUID *p_uuid, UINT16 start_hdl, UINT16 en
 extern BOOLEAN gatt_parse_uuid_from_cmd(tBT_UUID *p_uuid, UINT16 len, UINT8 **p_data);
 extern UINT8 gatt_build_uuid_to_stream(UINT8 **p_dst, tBT_UUID uuid);
 extern BOOLEAN gatt_uuid_compare(tBT_UUID src, tBT_UUID tar);
+extern void gatt_convert_uuid16_to_uuid128(UINT8 uuid_128[LEN_UUID_128], UINT16 uuid_16);
 extern void gatt_convert_uuid32_to_uuid128(UINT8 uuid_128[LEN_UUID_128], UINT32 uuid_32);
 extern void gatt_sr_get_sec_info(BD_ADDR rem_bda, tBT_TRANSPORT transport, UINT8 *p_sec_flag, UINT8 *p_key_size);
 extern void gatt_start_rsp_timer(UINT16 clcb_idx);
@@ -587,6 +691,10 @@ extern tGATTS_PENDING_NEW_SRV_START *gatt_add_pending_new_srv_start( tGATTS_HNDL
 extern void gatt_free_srvc_db_buffer_app_id(tBT_UUID *p_app_id);
 extern BOOLEAN gatt_update_listen_mode(void);
 extern BOOLEAN gatt_cl_send_next_cmd_inq(tGATT_TCB *p_tcb);
+extern tGATT_NOTIF_SUB *gatt_find_notif_sub(BD_ADDR peer_bda, UINT16 handle);
+extern tGATT_NOTIF_SUB *gatt_add_notif_sub(BD_ADDR peer_bda, UINT16 handle);
+extern void gatt_remove_notif_sub(tGATT_IF gatt_if, BD_ADDR peer_bda,
+                                  UINT16 start_handle, UINT16 end_handle);
 
 /* reserved handle list */
 extern tGATT_HDL_LIST_ELEM *gatt_find_hdl_buffer_by_app_id (tBT_UUID *p_app_uuid128, tBT_UUID *p_svc_uuid, UINT16 svc_inst);
@@ -622,6 +730,7 @@ extern void gatt_sr_send_req_callback(UINT16 conn_id,  UINT32 trans_id,
                                       UINT8 op_code, tGATTS_DATA *p_req_data);
 extern UINT32 gatt_sr_enqueue_cmd (tGATT_TCB *p_tcb, UINT8 op_code, UINT16 handle);
 extern BOOLEAN gatt_cancel_open(tGATT_IF gatt_if, BD_ADDR bda);
+extern void gatt_sr_disc_cache_flush(void);
 
 /*   */
 
@@ -687,6 +796,8 @@ extern tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_co
 extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB *p_db, BOOLEAN is_long, UINT16 handle, tGATT_SEC_FLAG sec_flag,UINT8 key_size);
 extern void gatts_update_srv_list_elem(UINT8 i_sreg, UINT16 handle, BOOLEAN is_primary);
 extern tBT_UUID * gatts_get_service_uuid (tGATT_SVC_DB *p_db);
+extern tGATT_ATTR16 *gatts_find_attr_by_handle(tGATT_SVC_DB *p_db, UINT16 handle);
+extern void gatts_free_attr_tbl(tGATT_SVC_DB *p_db);
 
 extern void gatt_reset_bgdev_list(void);
 #endif
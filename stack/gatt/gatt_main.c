@@ -181,6 +181,8 @@ void gatt_free(void)
     {
         gatt_free_hdl_buffer(&gatt_cb.hdl_list[i]);
     }
+
+    gatt_sr_disc_cache_flush();
 }
 
 /*******************************************************************************
@@ -1190,6 +1192,8 @@ void gatt_proc_srv_chg (void)
 
     GATT_TRACE_DEBUG ("gatt_proc_srv_chg");
 
+    gatt_sr_disc_cache_flush();
+
     if (gatt_cb.cb_info.p_srv_chg_callback && gatt_cb.handle_of_h_r)
     {
         gatt_set_srv_chg();
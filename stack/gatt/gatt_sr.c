@@ -495,6 +495,169 @@ void gatt_process_read_multi_req (tGATT_TCB *p_tcb, UINT8 op_code, UINT16 len, U
         gatt_send_error_rsp(p_tcb, err, op_code, handle, FALSE);
 }
 
+/*******************************************************************************
+**
+** Function         gatt_sr_disc_cache_flush
+**
+** Description      Drop all cached discovery responses. Called whenever the
+**                  server attribute database or its service list changes.
+**
+** Returns          void
+**
+*******************************************************************************/
+void gatt_sr_disc_cache_flush(void)
+{
+    tGATT_SR_DISC_CACHE *p_entry = gatt_cb.sr_disc_cache;
+    UINT8               i;
+
+    for (i = 0; i < GATT_SR_DISC_CACHE_SIZE; i ++, p_entry ++)
+    {
+        if (p_entry->in_use)
+        {
+            osi_free(p_entry->p_pdu);
+            memset(p_entry, 0, sizeof(tGATT_SR_DISC_CACHE));
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         gatts_disc_cache_lookup
+**
+** Description      Look up a cached response for a discovery request.
+**
+** Parameter        p_key: discovery request.
+**                  pp_msg: output, copy of the cached response PDU ready to
+**                          be sent, NULL for a cached error response.
+**                  p_status: output, status of the cached response.
+**
+** Returns          TRUE if a cached response was found.
+**
+*******************************************************************************/
+static BOOLEAN gatts_disc_cache_lookup(tGATT_SR_DISC_KEY *p_key, BT_HDR **pp_msg,
+                                       tGATT_STATUS *p_status)
+{
+    tGATT_SR_DISC_CACHE *p_entry = gatt_cb.sr_disc_cache;
+    BT_HDR              *p_msg;
+    UINT8               i;
+
+    for (i = 0; i < GATT_SR_DISC_CACHE_SIZE; i ++, p_entry ++)
+    {
+        if (p_entry->in_use && !memcmp(&p_entry->key, p_key, sizeof(tGATT_SR_DISC_KEY)))
+        {
+            p_entry->last_used = ++gatt_cb.sr_disc_cache_seq;
+            gatt_cb.sr_disc_cache_hits ++;
+
+            *pp_msg = NULL;
+            *p_status = p_entry->status;
+
+            if (p_entry->p_pdu != NULL)
+            {
+                p_msg = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + p_entry->len);
+                p_msg->offset = L2CAP_MIN_OFFSET;
+                p_msg->len = p_entry->len;
+                p_msg->layer_specific = 0;
+                memcpy((UINT8 *)(p_msg + 1) + L2CAP_MIN_OFFSET, p_entry->p_pdu, p_entry->len);
+                *pp_msg = p_msg;
+            }
+
+            GATT_TRACE_DEBUG("%s op_code=0x%02x s_hdl=0x%04x hits=%u misses=%u", __func__,
+                             p_key->op_code, p_key->s_hdl,
+                             gatt_cb.sr_disc_cache_hits, gatt_cb.sr_disc_cache_misses);
+            return TRUE;
+        }
+    }
+
+    gatt_cb.sr_disc_cache_misses ++;
+    return FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         gatts_disc_cache_store
+**
+** Description      Remember the response built for a discovery request. Only
+**                  responses that depend on nothing but the database content,
+**                  i.e. a complete response or Attribute Not Found, are kept.
+**
+** Parameter        p_key: discovery request.
+**                  status: response status.
+**                  p_msg: response PDU for a successful request.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatts_disc_cache_store(tGATT_SR_DISC_KEY *p_key, tGATT_STATUS status, BT_HDR *p_msg)
+{
+    tGATT_SR_DISC_CACHE *p_entry = gatt_cb.sr_disc_cache, *p_victim = NULL;
+    UINT8               i;
+
+    if (status != GATT_SUCCESS && status != GATT_NOT_FOUND)
+        return;
+
+    /* reuse a free entry, or evict the least recently used one */
+    for (i = 0; i < GATT_SR_DISC_CACHE_SIZE; i ++, p_entry ++)
+    {
+        if (!p_entry->in_use)
+        {
+            p_victim = p_entry;
+            break;
+        }
+        if (p_victim == NULL || p_entry->last_used < p_victim->last_used)
+            p_victim = p_entry;
+    }
+
+    if (p_victim == NULL)
+        return;
+
+    osi_free(p_victim->p_pdu);
+    memset(p_victim, 0, sizeof(tGATT_SR_DISC_CACHE));
+
+    memcpy(&p_victim->key, p_key, sizeof(tGATT_SR_DISC_KEY));
+    p_victim->status = status;
+    p_victim->last_used = ++gatt_cb.sr_disc_cache_seq;
+    p_victim->in_use = TRUE;
+
+    if (status == GATT_SUCCESS)
+    {
+        p_victim->len = p_msg->len;
+        p_victim->p_pdu = (UINT8 *)osi_malloc(p_msg->len);
+        memcpy(p_victim->p_pdu, (UINT8 *)(p_msg + 1) + p_msg->offset, p_msg->len);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         gatts_disc_cache_key
+**
+** Description      Build the cache key of a discovery request.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatts_disc_cache_key(tGATT_SR_DISC_KEY *p_key, tGATT_TCB *p_tcb, UINT8 op_code,
+                                 UINT16 s_hdl, UINT16 e_hdl, tBT_UUID *p_type, tBT_UUID *p_value)
+{
+    /* keys are compared with memcmp(), clear the padding and unused UUID bytes */
+    memset(p_key, 0, sizeof(tGATT_SR_DISC_KEY));
+
+    p_key->op_code = op_code;
+    p_key->s_hdl = s_hdl;
+    p_key->e_hdl = e_hdl;
+    p_key->mtu = p_tcb->payload_size;
+
+    if (p_type != NULL)
+    {
+        p_key->type.len = p_type->len;
+        memcpy(&p_key->type.uu, &p_type->uu, p_type->len);
+    }
+    if (p_value != NULL)
+    {
+        p_key->value.len = p_value->len;
+        memcpy(&p_key->value.uu, &p_value->uu, p_value->len);
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_build_primary_service_rsp
@@ -604,66 +767,63 @@ static tGATT_STATUS gatt_build_find_info_rsp(tGATT_SR_REG *p_rcb, BT_HDR *p_msg,
     tGATT_STATUS        status = GATT_NOT_FOUND;
     UINT8               *p;
     UINT16              len = *p_len;
+    UINT16              handle;
     tGATT_ATTR16        *p_attr = NULL;
     UINT8               info_pair_len[2] = {4, 18};
 
     if (!p_rcb->p_db || !p_rcb->p_db->p_attr_list)
         return status;
 
-    /* check the attribute database */
-    p_attr = (tGATT_ATTR16 *) p_rcb->p_db->p_attr_list;
-
     p = (UINT8 *)(p_msg + 1) + L2CAP_MIN_OFFSET + p_msg->len;
 
-    while (p_attr)
+    /* check the attribute database, starting at the first requested handle */
+    handle = (s_hdl > p_rcb->p_db->start_handle) ? s_hdl : p_rcb->p_db->start_handle;
+
+    for (; handle <= e_hdl; handle ++)
     {
-        if (p_attr->handle > e_hdl)
+        if ((p_attr = gatts_find_attr_by_handle(p_rcb->p_db, handle)) == NULL)
         {
             break;
         }
 
-        if (p_attr->handle >= s_hdl)
-        {
-            if (p_msg->offset == 0)
-                p_msg->offset = (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) ? GATT_INFO_TYPE_PAIR_16 : GATT_INFO_TYPE_PAIR_128;
+        if (p_msg->offset == 0)
+            p_msg->offset = (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) ? GATT_INFO_TYPE_PAIR_16 : GATT_INFO_TYPE_PAIR_128;
 
-            if (len >= info_pair_len[p_msg->offset - 1])
+        if (len >= info_pair_len[p_msg->offset - 1])
+        {
+            if (p_msg->offset == GATT_INFO_TYPE_PAIR_16 && p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
             {
-                if (p_msg->offset == GATT_INFO_TYPE_PAIR_16 && p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
-                {
-                    UINT16_TO_STREAM(p, p_attr->handle);
-                    UINT16_TO_STREAM(p, p_attr->uuid);
-                }
-                else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 && p_attr->uuid_type == GATT_ATTR_UUID_TYPE_128  )
-                {
-                    UINT16_TO_STREAM(p, p_attr->handle);
-                    ARRAY_TO_STREAM (p, ((tGATT_ATTR128 *) p_attr)->uuid, LEN_UUID_128);
-                }
-                else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 && p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
-                {
-                    UINT16_TO_STREAM(p, p_attr->handle);
-                    gatt_convert_uuid32_to_uuid128(p, ((tGATT_ATTR32 *) p_attr)->uuid);
-                    p += LEN_UUID_128;
-                }
-                else
-                {
-                    GATT_TRACE_ERROR("format mismatch");
-                    status = GATT_NO_RESOURCES;
-                    break;
-                    /* format mismatch */
-                }
-                p_msg->len += info_pair_len[p_msg->offset - 1];
-                len -= info_pair_len[p_msg->offset - 1];
-                status = GATT_SUCCESS;
-
+                UINT16_TO_STREAM(p, p_attr->handle);
+                UINT16_TO_STREAM(p, p_attr->uuid);
+            }
+            else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 && p_attr->uuid_type == GATT_ATTR_UUID_TYPE_128  )
+            {
+                UINT16_TO_STREAM(p, p_attr->handle);
+                ARRAY_TO_STREAM (p, ((tGATT_ATTR128 *) p_attr)->uuid, LEN_UUID_128);
+            }
+            else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 && p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
+            {
+                UINT16_TO_STREAM(p, p_attr->handle);
+                gatt_convert_uuid32_to_uuid128(p, ((tGATT_ATTR32 *) p_attr)->uuid);
+                p += LEN_UUID_128;
             }
             else
             {
+                GATT_TRACE_ERROR("format mismatch");
                 status = GATT_NO_RESOURCES;
                 break;
+                /* format mismatch */
             }
+            p_msg->len += info_pair_len[p_msg->offset - 1];
+            len -= info_pair_len[p_msg->offset - 1];
+            status = GATT_SUCCESS;
+
+        }
+        else
+        {
+            status = GATT_NO_RESOURCES;
+            break;
         }
-        p_attr = (tGATT_ATTR16 *)p_attr->p_next;
     }
 
     *p_len = len;
@@ -750,6 +910,7 @@ void gatts_process_primary_service_req(tGATT_TCB *p_tcb, UINT8 op_code, UINT16 l
     tBT_UUID        uuid, value, primary_service = {LEN_UUID_16, {GATT_UUID_PRI_SERVICE}};
     BT_HDR          *p_msg = NULL;
     UINT16          msg_len = (UINT16)(sizeof(BT_HDR) + p_tcb->payload_size + L2CAP_MIN_OFFSET);
+    tGATT_SR_DISC_KEY   key;
 
     memset (&value, 0, sizeof(tBT_UUID));
     reason = gatts_validate_packet_format(op_code, &len, &p_data, &uuid, &s_hdl, &e_hdl);
@@ -765,10 +926,15 @@ void gatts_process_primary_service_req(tGATT_TCB *p_tcb, UINT8 op_code, UINT16 l
             }
 
             if (reason == GATT_SUCCESS) {
-                p_msg = (BT_HDR *)osi_calloc(msg_len);
-                reason = gatt_build_primary_service_rsp (p_msg, p_tcb, op_code,
-                                                         s_hdl, e_hdl, p_data,
-                                                         value);
+                gatts_disc_cache_key(&key, p_tcb, op_code, s_hdl, e_hdl, &uuid, &value);
+
+                if (!gatts_disc_cache_lookup(&key, &p_msg, &reason)) {
+                    p_msg = (BT_HDR *)osi_calloc(msg_len);
+                    reason = gatt_build_primary_service_rsp (p_msg, p_tcb, op_code,
+                                                             s_hdl, e_hdl, p_data,
+                                                             value);
+                    gatts_disc_cache_store(&key, reason, p_msg);
+                }
             }
         }
         else
@@ -815,10 +981,14 @@ static void gatts_process_find_info(tGATT_TCB *p_tcb, UINT8 op_code, UINT16 len,
     tGATT_SR_REG    *p_rcb;
     tGATT_SRV_LIST_INFO *p_list= &gatt_cb.srv_list_info;
     tGATT_SRV_LIST_ELEM  *p_srv=NULL;
+    tGATT_SR_DISC_KEY   key;
 
     reason = gatts_validate_packet_format(op_code, &len, &p_data, NULL, &s_hdl, &e_hdl);
 
     if (reason == GATT_SUCCESS)
+        gatts_disc_cache_key(&key, p_tcb, op_code, s_hdl, e_hdl, NULL, NULL);
+
+    if (reason == GATT_SUCCESS && !gatts_disc_cache_lookup(&key, &p_msg, &reason))
     {
         buf_len = (UINT16)(sizeof(BT_HDR) + p_tcb->payload_size + L2CAP_MIN_OFFSET);
 
@@ -850,6 +1020,8 @@ static void gatts_process_find_info(tGATT_TCB *p_tcb, UINT8 op_code, UINT16 len,
         *p = (UINT8)p_msg->offset;
 
         p_msg->offset = L2CAP_MIN_OFFSET;
+
+        gatts_disc_cache_store(&key, reason, p_msg);
     }
 
     if (reason != GATT_SUCCESS)
@@ -952,6 +1124,7 @@ void gatts_process_read_by_type_req(tGATT_TCB *p_tcb, UINT8 op_code, UINT16 len,
     UINT8               sec_flag, key_size;
     tGATT_SRV_LIST_INFO *p_list= &gatt_cb.srv_list_info;
     tGATT_SRV_LIST_ELEM  *p_srv=NULL;
+    tGATT_SR_DISC_KEY   key;
 
     reason = gatts_validate_packet_format(op_code, &len, &p_data, &uuid, &s_hdl, &e_hdl);
 
@@ -967,6 +1140,11 @@ void gatts_process_read_by_type_req(tGATT_TCB *p_tcb, UINT8 op_code, UINT16 len,
 #endif
 
     if (reason == GATT_SUCCESS)
+        gatts_disc_cache_key(&key, p_tcb, op_code, s_hdl, e_hdl, &uuid, NULL);
+
+    /* a response made only of declarations handled by the stack can be replayed;
+    ** anything involving an application read comes back as GATT_PENDING */
+    if (reason == GATT_SUCCESS && !gatts_disc_cache_lookup(&key, &p_msg, &reason))
     {
         p_msg = (BT_HDR *)osi_calloc(msg_len);
         p = (UINT8 *)(p_msg + 1) + L2CAP_MIN_OFFSET;
@@ -1015,6 +1193,8 @@ void gatts_process_read_by_type_req(tGATT_TCB *p_tcb, UINT8 op_code, UINT16 len,
         }
         *p = (UINT8)p_msg->offset;
         p_msg->offset = L2CAP_MIN_OFFSET;
+
+        gatts_disc_cache_store(&key, reason, p_msg);
     }
     if (reason != GATT_SUCCESS)
     {
@@ -1202,7 +1382,6 @@ void gatts_process_attribute_req (tGATT_TCB *p_tcb, UINT8 op_code,
     UINT8           *p = p_data, i;
     tGATT_SR_REG    *p_rcb = gatt_cb.sr_reg;
     tGATT_STATUS    status = GATT_INVALID_HANDLE;
-    tGATT_ATTR16    *p_attr;
 
     if (len < 2)
     {
@@ -1233,32 +1412,25 @@ void gatts_process_attribute_req (tGATT_TCB *p_tcb, UINT8 op_code,
         {
             if (p_rcb->in_use && p_rcb->s_hdl <= handle && p_rcb->e_hdl >= handle)
             {
-                p_attr = (tGATT_ATTR16 *)p_rcb->p_db->p_attr_list;
-
-                while (p_attr)
+                if (gatts_find_attr_by_handle(p_rcb->p_db, handle) != NULL)
                 {
-                    if (p_attr->handle == handle)
+                    switch (op_code)
                     {
-                        switch (op_code)
-                        {
-                            case GATT_REQ_READ: /* read char/char descriptor value */
-                            case GATT_REQ_READ_BLOB:
-                                gatts_process_read_req(p_tcb, p_rcb, op_code, handle, len, p);
-                                break;
-
-                            case GATT_REQ_WRITE: /* write char/char descriptor value */
-                            case GATT_CMD_WRITE:
-                            case GATT_SIGN_CMD_WRITE:
-                            case GATT_REQ_PREPARE_WRITE:
-                                gatts_process_write_req(p_tcb, i, handle, op_code, len, p);
-                                break;
-                            default:
-                                break;
-                        }
-                        status = GATT_SUCCESS;
-                        break;
+                        case GATT_REQ_READ: /* read char/char descriptor value */
+                        case GATT_REQ_READ_BLOB:
+                            gatts_process_read_req(p_tcb, p_rcb, op_code, handle, len, p);
+                            break;
+
+                        case GATT_REQ_WRITE: /* write char/char descriptor value */
+                        case GATT_CMD_WRITE:
+                        case GATT_SIGN_CMD_WRITE:
+                        case GATT_REQ_PREPARE_WRITE:
+                            gatts_process_write_req(p_tcb, i, handle, op_code, len, p);
+                            break;
+                        default:
+                            break;
                     }
-                    p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+                    status = GATT_SUCCESS;
                 }
                 break;
             }
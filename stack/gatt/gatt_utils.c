@@ -394,6 +394,7 @@ void gatt_free_hdl_buffer(tGATT_HDL_LIST_ELEM *p)
         while (!fixed_queue_is_empty(p->svc_db.svc_buffer))
             osi_free(fixed_queue_try_dequeue(p->svc_db.svc_buffer));
         fixed_queue_free(p->svc_db.svc_buffer, NULL);
+        gatts_free_attr_tbl(&p->svc_db);
         memset(p, 0, sizeof(tGATT_HDL_LIST_ELEM));
     }
 }
@@ -420,6 +421,7 @@ void gatt_free_srvc_db_buffer_app_id(tBT_UUID *p_app_id)
                 osi_free(fixed_queue_try_dequeue(p_elem->svc_db.svc_buffer));
             fixed_queue_free(p_elem->svc_db.svc_buffer, NULL);
             p_elem->svc_db.svc_buffer = NULL;
+            gatts_free_attr_tbl(&p_elem->svc_db);
 
             p_elem->svc_db.mem_free = 0;
             p_elem->svc_db.p_attr_list = p_elem->svc_db.p_free_mem = NULL;
@@ -2057,6 +2059,118 @@ BOOLEAN gatt_find_app_hold_link(tGATT_TCB *p_tcb, UINT8 start_idx, UINT8 *p_foun
     return found;
 }
 
+/*******************************************************************************
+**
+** Function         gatt_find_notif_sub
+**
+** Description      Find the notification subscription entry of a peer handle.
+**                  Only the entries chained into the bucket of the handle are
+**                  compared.
+**
+** Returns          pointer to the entry, NULL if no application subscribed.
+**
+*******************************************************************************/
+tGATT_NOTIF_SUB *gatt_find_notif_sub(BD_ADDR peer_bda, UINT16 handle)
+{
+    tGATT_NOTIF_SUB *p_sub;
+    UINT8           idx = gatt_cb.notif_sub_bucket[GATT_NOTIF_SUB_HASH(handle)];
+
+    while (idx != 0)
+    {
+        p_sub = &gatt_cb.notif_sub[idx - 1];
+        if (p_sub->handle == handle && !memcmp(p_sub->peer_bda, peer_bda, BD_ADDR_LEN))
+            return p_sub;
+        idx = p_sub->next;
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_add_notif_sub
+**
+** Description      Allocate the notification subscription entry of a peer
+**                  handle and chain it into the bucket of the handle. The
+**                  caller sets the application mask.
+**
+** Returns          pointer to the entry, NULL if the table is full.
+**
+*******************************************************************************/
+tGATT_NOTIF_SUB *gatt_add_notif_sub(BD_ADDR peer_bda, UINT16 handle)
+{
+    tGATT_NOTIF_SUB *p_sub = gatt_cb.notif_sub;
+    UINT8           *p_bucket = &gatt_cb.notif_sub_bucket[GATT_NOTIF_SUB_HASH(handle)];
+    UINT8           i;
+
+    for (i = 0; i < GATT_CL_MAX_NOTIF_SUB; i ++, p_sub ++)
+    {
+        if (p_sub->app_mask == 0)
+        {
+            memcpy(p_sub->peer_bda, peer_bda, BD_ADDR_LEN);
+            p_sub->handle = handle;
+            p_sub->next = *p_bucket;
+            *p_bucket = i + 1;
+            return p_sub;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_unlink_notif_sub
+**
+** Description      Take a notification subscription entry out of its handle
+**                  bucket and free it.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void gatt_unlink_notif_sub(tGATT_NOTIF_SUB *p_sub)
+{
+    UINT8   *p_link = &gatt_cb.notif_sub_bucket[GATT_NOTIF_SUB_HASH(p_sub->handle)];
+    UINT8   idx = (UINT8)(p_sub - gatt_cb.notif_sub) + 1;
+
+    while (*p_link != 0 && *p_link != idx)
+        p_link = &gatt_cb.notif_sub[*p_link - 1].next;
+
+    if (*p_link == idx)
+        *p_link = p_sub->next;
+
+    memset(p_sub, 0, sizeof(tGATT_NOTIF_SUB));
+}
+
+/*******************************************************************************
+**
+** Function         gatt_remove_notif_sub
+**
+** Description      Remove the notification subscriptions of an application for
+**                  a handle range of a peer, or of all peers if peer_bda is NULL.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void gatt_remove_notif_sub(tGATT_IF gatt_if, BD_ADDR peer_bda,
+                           UINT16 start_handle, UINT16 end_handle)
+{
+    tGATT_NOTIF_SUB *p_sub = gatt_cb.notif_sub;
+    UINT8           i;
+
+    for (i = 0; i < GATT_CL_MAX_NOTIF_SUB; i ++, p_sub ++)
+    {
+        if (p_sub->app_mask == 0 ||
+            p_sub->handle < start_handle || p_sub->handle > end_handle)
+            continue;
+
+        if (peer_bda != NULL && memcmp(p_sub->peer_bda, peer_bda, BD_ADDR_LEN))
+            continue;
+
+        p_sub->app_mask &= ~GATT_NOTIF_SUB_BIT(gatt_if);
+        if (p_sub->app_mask == 0)
+            gatt_unlink_notif_sub(p_sub);
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_cmd_enq
@@ -125,6 +125,27 @@ typedef struct
     UINT8 *adv_data_cache;
 } tBTM_BLE_INQ_DATA_CB;
 
+/* Users of the HCI command transaction layer */
+#define BTM_HCI_TXN_APCF            0   /* LE advertising packet content filter */
+#define BTM_HCI_TXN_MULTI_ADV       1   /* LE multi and extended advertising */
+#define BTM_HCI_TXN_MAX_CLIENTS     2
+
+/* HCI command transaction counters, kept per client */
+typedef struct
+{
+    UINT32  cmds;               /* commands completed */
+    UINT32  failed;             /* commands completed with an error status */
+    UINT32  held;               /* commands held back by the in-flight window */
+    UINT32  dropped;            /* commands refused or flushed before completing */
+    UINT32  txns;               /* transactions completed */
+    UINT8   in_flight_high_water; /* most commands outstanding at once */
+    UINT32  cmd_max_us;         /* slowest command, issue to completion */
+    UINT64  cmd_total_us;
+    UINT32  txn_last_us;        /* last transaction, first issue to last completion */
+    UINT32  txn_max_us;
+    UINT64  txn_total_us;
+} tBTM_HCI_TXN_STATS;
+
 
 #define  BTM_VSC_CMPL_DATA_SIZE  (BTM_MAX_VENDOR_SPECIFIC_LEN + sizeof(tBTM_VSC_CMPL))
 /**************************************************
@@ -2110,6 +2131,20 @@ extern tBTM_STATUS BTM_VendorSpecificCommand(UINT16 opcode,
                                              UINT8 *p_param_buf,
                                              tBTM_VSC_CMPL_CB *p_cb);
 
+/*******************************************************************************
+**
+** Function         BTM_HciTxnGetStats
+**
+** Description      Reads the HCI command transaction counters of a client.
+**
+** Parameters       client: BTM_HCI_TXN_APCF or BTM_HCI_TXN_MULTI_ADV.
+**                  p_stats: filled with the counters.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTM_HciTxnGetStats(UINT8 client, tBTM_HCI_TXN_STATS *p_stats);
+
 
 /*******************************************************************************
 **
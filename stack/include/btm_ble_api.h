@@ -540,14 +540,6 @@ typedef struct
 #endif
 }tBTM_BLE_ADV_PARAMS;
 
-typedef struct
-{
-    UINT8   *p_sub_code; /* dynamic array to store sub code */
-    UINT8   *p_inst_id;  /* dynamic array to store instance id */
-    UINT8   pending_idx;
-    UINT8   next_idx;
-}tBTM_BLE_MULTI_ADV_OPQ;
-
 typedef void (tBTM_BLE_MULTI_ADV_CBACK)(tBTM_BLE_MULTI_ADV_EVT evt, UINT8 inst_id,
                 void *p_ref, tBTM_STATUS status);
 
@@ -591,7 +583,6 @@ typedef struct
 typedef struct
 {
     tBTM_BLE_MULTI_ADV_INST *p_adv_inst; /* dynamic array to store adv instance */
-    tBTM_BLE_MULTI_ADV_OPQ  op_q;
 }tBTM_BLE_MULTI_ADV_CB;
 
 #if (defined BLE_EXTENDED_ADV_SUPPORT && (BLE_EXTENDED_ADV_SUPPORT == TRUE))
@@ -644,17 +635,54 @@ typedef struct
     UINT8   next_idx;
 }tBTM_BLE_BATCH_SCAN_OPQ;
 
+/* Batch scan reports are parsed as each READ_RESULTS response arrives and
+** handed to the report callback in batches of at most this many bytes, so a
+** long batch window never has to be reassembled in one buffer.
+*/
+#ifndef BTM_BLE_BATCH_REP_BATCH_SIZE
+#define BTM_BLE_BATCH_REP_BATCH_SIZE  2048
+#endif
+
+/* records per batch; the report callback counts records in a UINT8 */
+#define BTM_BLE_BATCH_REP_MAX_RECORDS 255
+#define BTM_BLE_BATCH_REP_HASH_SIZE   64    /* power of 2 */
+#define BTM_BLE_BATCH_REP_NO_RECORD   0xFF
+
+/* the batch of records being collected for one report read */
+typedef struct
+{
+    UINT8   *p_buf;         /* BTM_BLE_BATCH_REP_BATCH_SIZE bytes, given to the callback */
+    UINT16  len;
+    UINT8   num_records;
+    UINT16  rec_off[BTM_BLE_BATCH_REP_MAX_RECORDS];     /* record offsets in p_buf */
+    UINT8   rec_next[BTM_BLE_BATCH_REP_MAX_RECORDS];    /* address hash chains */
+    UINT8   hash[BTM_BLE_BATCH_REP_HASH_SIZE];
+    UINT32  read_len;       /* bytes received from the controller for this read */
+}tBTM_BLE_BATCH_REP_BATCH;
+
 typedef struct
 {
     UINT8   rep_mode[BTM_BLE_BATCH_REP_MAIN_Q_SIZE];
     tBTM_BLE_REF_VALUE  ref_value[BTM_BLE_BATCH_REP_MAIN_Q_SIZE];
-    UINT8   num_records[BTM_BLE_BATCH_REP_MAIN_Q_SIZE];
-    UINT16  data_len[BTM_BLE_BATCH_REP_MAIN_Q_SIZE];
-    UINT8   *p_data[BTM_BLE_BATCH_REP_MAIN_Q_SIZE];
+    tBTM_BLE_BATCH_REP_BATCH batch[BTM_BLE_BATCH_REP_MAIN_Q_SIZE];
     UINT8   pending_idx;
     UINT8   next_idx;
 }tBTM_BLE_BATCH_SCAN_REP_Q;
 
+/* Batch scan report pipeline counters */
+typedef struct
+{
+    UINT32  reads;              /* completed report reads */
+    UINT32  chunks;             /* READ_RESULTS responses carrying records */
+    UINT32  records_in;         /* records received from the controller */
+    UINT32  records_out;        /* records passed to the report callback */
+    UINT32  merged;             /* records replacing an earlier one from the same address */
+    UINT32  malformed;          /* responses with a record running past the end */
+    UINT32  batches;            /* report callbacks with records */
+    UINT16  batch_high_water;   /* most bytes held for a batch */
+    UINT32  read_high_water;    /* most bytes received in one read */
+}tBTM_BLE_BATCH_SCAN_STATS;
+
 typedef struct
 {
     tBTM_BLE_BATCH_SCAN_STATE      cur_state;
@@ -669,6 +697,7 @@ typedef struct
     tBTM_BLE_SCAN_THRESHOLD_CBACK *p_thres_cback;
     tBTM_BLE_SCAN_REP_CBACK       *p_scan_rep_cback;
     tBTM_BLE_REF_VALUE             ref_value;
+    tBTM_BLE_BATCH_SCAN_STATS      stats;
 }tBTM_BLE_BATCH_SCAN_CB;
 
 /* filter selection bit index  */
@@ -832,17 +861,6 @@ typedef union
     tBTM_BLE_PF_SRVC_PATTERN_COND           srvc_data;      /* service data pattern */
 }tBTM_BLE_PF_COND_PARAM;
 
-typedef struct
-{
-    UINT8   action_ocf[BTM_BLE_PF_TYPE_MAX];
-    tBTM_BLE_REF_VALUE  ref_value[BTM_BLE_PF_TYPE_MAX];
-    tBTM_BLE_PF_PARAM_CBACK  *p_filt_param_cback[BTM_BLE_PF_TYPE_MAX];
-    tBTM_BLE_PF_CFG_CBACK *p_scan_cfg_cback[BTM_BLE_PF_TYPE_MAX];
-    UINT8   cb_evt[BTM_BLE_PF_TYPE_MAX];
-    UINT8   pending_idx;
-    UINT8   next_idx;
-}tBTM_BLE_ADV_FILTER_ADV_OPQ;
-
 #define BTM_BLE_MAX_FILTER_COUNTER  (BTM_BLE_MAX_ADDR_FILTER + 1) /* per device filter + one generic filter indexed by 0 */
 
 #ifndef BTM_CS_IRK_LIST_MAX
@@ -863,7 +881,6 @@ typedef struct
     tBTM_BLE_PF_COUNT   *p_addr_filter_count; /* per BDA filter array */
     tBLE_BD_ADDR        cur_filter_target;
     tBTM_BLE_PF_STATUS_CBACK *p_filt_stat_cback;
-    tBTM_BLE_ADV_FILTER_ADV_OPQ  op_q;
 }tBTM_BLE_ADV_FILTER_CB;
 
 /* Sub codes */
@@ -953,6 +970,19 @@ typedef struct
     tBTM_BLE_ENERGY_INFO_CBACK *p_ener_cback;
 }tBTM_BLE_ENERGY_INFO_CB;
 
+/* Observer advertising report suppression counters */
+typedef struct
+{
+    UINT32  forwarded;          /* reports passed to the observer */
+    UINT32  suppressed;         /* unchanged reports dropped */
+    UINT32  new_adv;            /* forwarded, advertiser not heard recently */
+    UINT32  payload_changed;    /* forwarded, advertising data or address type changed */
+    UINT32  rssi_changed;       /* forwarded, RSSI moved by BTM_BLE_ADV_DEDUP_RSSI_STEP */
+    UINT32  refreshed;          /* forwarded, refresh interval expired */
+    UINT32  raw;                /* forwarded unfiltered for a raw report client */
+    UINT32  evicted;            /* advertisers forgotten to make room */
+} tBTM_BLE_ADV_DEDUP_STATS;
+
 typedef BOOLEAN (tBTM_BLE_SEL_CBACK)(BD_ADDR random_bda,     UINT8 *p_remote_name);
 typedef void (tBTM_BLE_CTRL_FEATURES_CBACK)(tBTM_STATUS status);
 
@@ -1175,7 +1205,11 @@ extern tBTM_STATUS BTM_BleDisableBatchScan(tBTM_BLE_REF_VALUE ref_value);
 **
 ** Function         BTM_BleReadScanReports
 **
-** Description      This function is called to read batch scan reports
+** Description      This function is called to read batch scan reports. The
+**                  records are passed to the reports callback in batches of at
+**                  most BTM_BLE_BATCH_REP_BATCH_SIZE bytes as they are read
+**                  out, with records from the same address merged within a
+**                  batch. The last callback of a read may carry no records.
 **
 ** Parameters       tBLE_SCAN_MODE scan_mode - Scan mode report to be read out
                     tBTM_BLE_SCAN_REP_CBACK* p_cback - Reports callback
@@ -1186,6 +1220,19 @@ extern tBTM_STATUS BTM_BleDisableBatchScan(tBTM_BLE_REF_VALUE ref_value);
 extern tBTM_STATUS BTM_BleReadScanReports(tBLE_SCAN_MODE scan_mode,
                                                   tBTM_BLE_REF_VALUE ref_value);
 
+/*******************************************************************************
+**
+** Function         BTM_BleGetBatchScanStats
+**
+** Description      Reads the batch scan report pipeline counters.
+**
+** Parameters       p_stats: filled with the counters.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTM_BleGetBatchScanStats(tBTM_BLE_BATCH_SCAN_STATS *p_stats);
+
 /*******************************************************************************
 **
 ** Function         BTM_BleTrackAdvertiser
@@ -1230,6 +1277,38 @@ extern tBTM_STATUS BTM_BleWriteScanRsp(tBTM_BLE_AD_MASK data_mask,
 extern tBTM_STATUS BTM_BleObserve(BOOLEAN start, UINT16 duration, UINT16 period,
                                   tBTM_INQ_RESULTS_CB *p_results_cb, tBTM_CMPL_CB *p_cmpl_cb);
 
+/*******************************************************************************
+**
+** Function         BTM_BleSetRawScanReports
+**
+** Description      When built with BTM_BLE_ADV_DEDUP_ENABLED, observers only
+**                  receive an advertising report when the advertiser is new,
+**                  its data changed, its RSSI moved by
+**                  BTM_BLE_ADV_DEDUP_RSSI_STEP, or BTM_BLE_ADV_DEDUP_REFRESH_MS
+**                  elapsed since it was last reported. While any client has
+**                  raw reports enabled every report is passed on.
+**
+** Parameters       client_if: GATT client interface.
+**                  raw: TRUE to receive every advertising report.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTM_BleSetRawScanReports(tGATT_IF client_if, BOOLEAN raw);
+
+/*******************************************************************************
+**
+** Function         BTM_BleGetAdvDedupStats
+**
+** Description      Reads the observer advertising report suppression counters.
+**
+** Parameters       p_stats: filled with the counters.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTM_BleGetAdvDedupStats(tBTM_BLE_ADV_DEDUP_STATS *p_stats);
+
 
 /*******************************************************************************
 **
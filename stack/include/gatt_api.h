@@ -657,6 +657,14 @@ typedef struct
     tGATTS_NV_SRV_CHG_CBACK    *p_srv_chg_callback;
 } tGATT_APPL_INFO;
 
+/* Client read coalescing counters */
+typedef struct
+{
+    UINT32  read_multi_sent;        /* Read Multiple sent in place of reads */
+    UINT32  rtt_saved;              /* round trips saved by read coalescing */
+    UINT32  read_multi_fallback;    /* merged reads resent one by one */
+} tGATT_CL_READ_STATS;
+
 /*
 ***********************  End Handle Management Definitions   **********************/
 
@@ -880,6 +888,31 @@ extern  tGATT_STATUS GATTS_HandleValueIndication (UINT16 conn_id,
 extern  tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
                                                     UINT16 val_len, UINT8 *p_val);
 
+/*******************************************************************************
+**
+** Function         GATTS_HandleValueNotificationMulti
+**
+** Description      This function sends the same handle value notification to
+**                  a set of clients. The ATT PDU is encoded once and copied
+**                  onto each link; a failure or congestion on one link does
+**                  not stop the notification to the others.
+**
+** Parameter        num_conn: number of entries in p_conn_id, at most
+**                            GATT_MAX_PHY_CHANNEL.
+**                  p_conn_id: connection identifiers to notify.
+**                  attr_handle: Attribute handle of this handle value notification.
+**                  val_len: Length of the notified attribute value.
+**                  p_val: Pointer to the notified attribute value data.
+**                  p_status: per connection result, GATT_CONGESTED if the link
+**                            accepted the PDU but is congested. May be NULL.
+**
+** Returns          GATT_SUCCESS if sent on at least one link; otherwise error code.
+**
+*******************************************************************************/
+extern  tGATT_STATUS GATTS_HandleValueNotificationMulti (UINT8 num_conn, UINT16 *p_conn_id,
+                                                         UINT16 attr_handle, UINT16 val_len,
+                                                         UINT8 *p_val, tGATT_STATUS *p_status);
+
 
 /*******************************************************************************
 **
@@ -999,6 +1032,73 @@ extern tGATT_STATUS GATTC_ExecuteWrite (UINT16 conn_id, BOOLEAN is_execute);
 *******************************************************************************/
 extern tGATT_STATUS GATTC_SendHandleValueConfirm (UINT16 conn_id, UINT16 handle);
 
+/*******************************************************************************
+**
+** Function         GATTC_SetNotifyFilter
+**
+** Description      This function is called to limit the notifications passed
+**                  to a client application to the handles it subscribed to
+**                  with GATTC_AddNotifySubscription. Indications are always
+**                  passed on.
+**
+** Parameters       gatt_if: application interface.
+**                  enable: TRUE to filter notifications, FALSE to receive all.
+**
+** Returns          TRUE if the filter was set.
+**
+*******************************************************************************/
+extern BOOLEAN GATTC_SetNotifyFilter (tGATT_IF gatt_if, BOOLEAN enable);
+
+/*******************************************************************************
+**
+** Function         GATTC_AddNotifySubscription
+**
+** Description      This function is called to subscribe a client application
+**                  to the notifications of a peer handle.
+**
+** Parameters       gatt_if: application interface.
+**                  peer_bda: peer device address.
+**                  handle: characteristic value handle.
+**
+** Returns          TRUE if added. If the subscription table is full the
+**                  notification filter of the application is turned off.
+**
+*******************************************************************************/
+extern BOOLEAN GATTC_AddNotifySubscription (tGATT_IF gatt_if, BD_ADDR peer_bda,
+                                            UINT16 handle);
+
+/*******************************************************************************
+**
+** Function         GATTC_RemoveNotifySubscription
+**
+** Description      This function is called to remove the notification
+**                  subscriptions of a client application for a handle range
+**                  of a peer.
+**
+** Parameters       gatt_if: application interface.
+**                  peer_bda: peer device address.
+**                  start_handle: first handle of the range.
+**                  end_handle: last handle of the range.
+**
+** Returns          None.
+**
+*******************************************************************************/
+extern void GATTC_RemoveNotifySubscription (tGATT_IF gatt_if, BD_ADDR peer_bda,
+                                            UINT16 start_handle, UINT16 end_handle);
+
+/*******************************************************************************
+**
+** Function         GATTC_GetReadStats
+**
+** Description      Reads the client read coalescing counters.
+**
+** Parameters       p_stats: filled with the counters.
+**
+** Returns          None.
+**
+*******************************************************************************/
+extern void GATTC_GetReadStats (tGATT_CL_READ_STATS *p_stats);
+
 
 /*******************************************************************************
 **
@@ -689,4 +689,18 @@ BOOLEAN SDP_FindServiceUUIDInRec(tSDP_DISC_REC *p_rec, tBT_UUID *p_uuid);
 ********************************************************************************/
 BOOLEAN SDP_Dev_Blacklisted_For_Avrcp15 (BD_ADDR addr);
 
+/*******************************************************************************
+**
+** Function         SDP_StoreAvrcTgVersion
+**
+** Description      This function records the AVRCP target version of a peer,
+**                  which the SDP server uses to pick the AVRCP version it
+**                  advertises to peers with the same OUI. A version already
+**                  recorded for the OUI is kept.
+**
+** Returns          TRUE if the version was recorded
+**
+*******************************************************************************/
+BOOLEAN SDP_StoreAvrcTgVersion (BD_ADDR addr, UINT16 ver);
+
 #endif  /* SDP_API_H */
@@ -287,6 +287,9 @@ typedef struct
     UINT8   param_buf[BT_OCTET16_LEN];
 } tSMP_ENC;
 
+/* Pre-expanded AES-128 key schedule */
+typedef struct smp_key_sched tSMP_KEY_SCHED;
+
 /* Security Manager events - Called by the stack when Security Manager related events occur.*/
 typedef UINT8 (tSMP_CALLBACK) (tSMP_EVT event, BD_ADDR bd_addr, tSMP_EVT_DATA *p_data);
 
@@ -461,6 +464,112 @@ extern BOOLEAN SMP_Encrypt (UINT8 *key, UINT8 key_len,
                             UINT8 *plain_text, UINT8 pt_len,
                             tSMP_ENC *p_out);
 
+/*******************************************************************************
+**
+** Function         SMP_KeySchedNew
+**
+** Description      This function expands an AES-128 key for repeated use with
+**                  SMP_EncryptSched and SMP_ResolveRpaBatch.
+**
+** Parameters:      key                 - Pointer to key, key[0] contains the LSB
+**
+**  Returns         key schedule, released with SMP_KeySchedFree
+*******************************************************************************/
+extern tSMP_KEY_SCHED *SMP_KeySchedNew(const UINT8 *key);
+
+/*******************************************************************************
+**
+** Function         SMP_KeySchedFree
+**
+** Description      This function wipes and releases a key schedule.
+**
+*******************************************************************************/
+extern void SMP_KeySchedFree(tSMP_KEY_SCHED *p_sched);
+
+/*******************************************************************************
+**
+** Function         SMP_EncryptSched
+**
+** Description      This function is the same as SMP_Encrypt but uses a key
+**                  schedule created by SMP_KeySchedNew.
+**
+** Parameters:      p_sched             - key schedule
+**                  plain_text          - Pointer to data to be encrypted
+**                                        plain_text[0] conatins the MSB
+**                  pt_len              - plain text length
+**                  p_out               - pointer to the encrypted outputs
+**
+**  Returns         Boolean - TRUE: encryption is successful
+*******************************************************************************/
+extern BOOLEAN SMP_EncryptSched(const tSMP_KEY_SCHED *p_sched,
+                                const UINT8 *plain_text, UINT8 pt_len,
+                                tSMP_ENC *p_out);
+
+/*******************************************************************************
+**
+** Function         SMP_ResolveRpaBatch
+**
+** Description      This function checks a resolvable private address against
+**                  an array of IRK key schedules.
+**
+** Parameters:      rpa                 - resolvable private address
+**                  p_sched             - IRK key schedules, NULL entries skipped
+**                  num                 - number of entries in p_sched
+**                  start               - first index to try
+**
+**  Returns         index of the first matching IRK, or num if none matches
+*******************************************************************************/
+extern UINT16 SMP_ResolveRpaBatch(const BD_ADDR rpa,
+                                  tSMP_KEY_SCHED * const *p_sched,
+                                  UINT16 num, UINT16 start);
+
+/*******************************************************************************
+**
+** Function         SMP_AesCmac
+**
+** Description      This function computes an AES-CMAC with tlen. It does not
+**                  allocate; the key schedule and subkeys are cached per key.
+**
+** Parameters:      key                 - CMAC key, key[0] contains the LSB
+**                  input               - message in little endian byte order
+**                  length              - message length in bytes
+**                  tlen                - mac length in bytes, at most 16
+**                  p_signature         - output, tlen bytes
+**
+**  Returns         Boolean - TRUE: mac is computed
+*******************************************************************************/
+extern BOOLEAN SMP_AesCmac(const UINT8 *key, const UINT8 *input, UINT16 length,
+                           UINT16 tlen, UINT8 *p_signature);
+
+/*******************************************************************************
+**
+** Function         SMP_AesClearKeyCache
+**
+** Description      This function wipes the cached key schedules.
+**
+*******************************************************************************/
+extern void SMP_AesClearKeyCache(void);
+
+/*******************************************************************************
+**
+** Function         SMP_AesBackend
+**
+** Description      This function returns the name of the AES implementation
+**                  selected for this CPU ("aes-ni", "armv8-ce" or "software").
+**
+*******************************************************************************/
+extern const char *SMP_AesBackend(void);
+
+/*******************************************************************************
+**
+** Function         SMP_AesForceSoftware
+**
+** Description      This function forces the software AES implementation, or
+**                  goes back to the one selected for this CPU.
+**
+*******************************************************************************/
+extern void SMP_AesForceSoftware(BOOLEAN force);
+
 /*******************************************************************************
 **
 ** Function         SMP_KeypressNotification
@@ -2824,6 +2824,7 @@ void l2cu_no_dynamic_ccbs (tL2C_LCB *p_lcb)
 {
     tBTM_STATUS     rc;
     period_ms_t     timeout_ms = p_lcb->idle_timeout * 1000;
+    period_ms_t     slack_ms = BT_IDLE_TIMER_SLACK_MS;
     bool            start_timeout = true;
 
 #if (L2CAP_NUM_FIXED_CHNLS > 0)
@@ -2846,6 +2847,9 @@ void l2cu_no_dynamic_ccbs (tL2C_LCB *p_lcb)
     {
         L2CAP_TRACE_DEBUG ("l2cu_no_dynamic_ccbs() IDLE timer 0, disconnecting link");
 
+        /* the timer now guards the disconnect, not the idle link */
+        slack_ms = 0;
+
         rc = btm_sec_disconnect (p_lcb->handle, HCI_ERR_PEER_USER);
         if (rc == BTM_CMD_STARTED)
         {
@@ -2880,9 +2884,9 @@ void l2cu_no_dynamic_ccbs (tL2C_LCB *p_lcb)
     if (start_timeout) {
         L2CAP_TRACE_DEBUG("%s starting IDLE timeout: %llu ms", __func__,
                           timeout_ms);
-        alarm_set_on_queue(p_lcb->l2c_lcb_timer, timeout_ms,
-                           l2c_lcb_timer_timeout, p_lcb,
-                           btu_general_alarm_queue);
+        alarm_set_on_queue_with_slack(p_lcb->l2c_lcb_timer, timeout_ms, slack_ms,
+                                      l2c_lcb_timer_timeout, p_lcb,
+                                      btu_general_alarm_queue);
     } else {
         L2CAP_TRACE_DEBUG("%s, alarm cancel", __func__);
         alarm_cancel(p_lcb->l2c_lcb_timer);
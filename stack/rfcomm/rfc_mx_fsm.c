@@ -527,7 +527,7 @@ void rfc_mx_sm_state_disc_wait_ua (tRFC_MCB *p_mcb, UINT16 event, void *p_data)
             while ((p_buf = (BT_HDR *)fixed_queue_try_dequeue(p_mcb->cmd_q)) != NULL)
                 osi_free(p_buf);
 
-            rfc_timer_start (p_mcb, RFC_MCB_INIT_INACT_TIMER);
+            rfc_inact_timer_start (p_mcb, RFC_MCB_INIT_INACT_TIMER);
 
             p_mcb->is_initiator     = TRUE;
             p_mcb->restart_required = FALSE;
@@ -184,7 +184,7 @@ tRFC_MCB *rfc_alloc_multiplexer_channel (BD_ADDR bd_addr, BOOLEAN is_initiator)
 
             p_mcb->is_initiator = is_initiator;
 
-            rfc_timer_start (p_mcb, RFC_MCB_INIT_INACT_TIMER);
+            rfc_inact_timer_start (p_mcb, RFC_MCB_INIT_INACT_TIMER);
 
             rfc_cb.rfc.last_mux = (UINT8) j;
             return (p_mcb);
@@ -239,6 +239,25 @@ void rfc_timer_start(tRFC_MCB *p_mcb, UINT16 timeout)
                        btu_general_alarm_queue);
 }
 
+/*******************************************************************************
+**
+** Function         rfc_inact_timer_start
+**
+** Description      Start RFC Timer as the multiplexer inactivity timer, which
+**                  may expire up to BT_IDLE_TIMER_SLACK_MS late
+**
+*******************************************************************************/
+void rfc_inact_timer_start(tRFC_MCB *p_mcb, UINT16 timeout)
+{
+    RFCOMM_TRACE_EVENT ("%s - timeout:%d seconds", __func__, timeout);
+
+    period_ms_t interval_ms = timeout * 1000;
+    alarm_set_on_queue_with_slack(p_mcb->mcb_timer, interval_ms,
+                                  BT_IDLE_TIMER_SLACK_MS,
+                                  rfcomm_mcb_timer_timeout, p_mcb,
+                                  btu_general_alarm_queue);
+}
+
 
 /*******************************************************************************
 **
@@ -317,7 +336,7 @@ void rfc_check_mcb_active (tRFC_MCB *p_mcb)
         rfc_mx_sm_execute (p_mcb, RFC_MX_EVENT_CLOSE_REQ, NULL);
     }
     else
-        rfc_timer_start (p_mcb, RFC_MCB_RELEASE_INACT_TIMER);
+        rfc_inact_timer_start (p_mcb, RFC_MCB_RELEASE_INACT_TIMER);
 }
 
 void rfcomm_port_timer_timeout(void *data)
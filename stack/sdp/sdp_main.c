@@ -137,6 +137,23 @@ void sdp_init (void)
     {
         SDP_TRACE_ERROR ("SDP Registration failed");
     }
+
+    sdp_peer_ver_init();
+}
+
+/*******************************************************************************
+**
+** Function         sdp_free
+**
+** Description      Releases the memory held by SDP and writes out the peer
+**                  versions that are not stored yet.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_free (void)
+{
+    sdp_peer_ver_free();
 }
 
 #if (defined(SDP_DEBUG) && SDP_DEBUG == TRUE)
@@ -0,0 +1,420 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the store of AVRCP target versions learned from peers.
+ *  The SDP server consults it for every AVRCP attribute it returns, so it is
+ *  read from AVRC_PEER_VERSION_CONF_FILE once and then kept in memory, hashed
+ *  by the OUI the versions are recorded for. New versions are appended to
+ *  the file from the alarm thread, never from the thread that stores them,
+ *  and whatever is still pending is written out when the stack shuts down.
+ *
+ *  It also caches the interoperability quirks the SDP server applies to the
+ *  records it returns to a peer, so that they are looked up once per peer
+ *  rather than for every attribute of every request.
+ *
+ ******************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bt_utils.h"
+#include "avrc_defs.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+#include "osi/include/alarm.h"
+#include "osi/include/allocator.h"
+#include "osi/include/hash_functions.h"
+#include "osi/include/hash_map.h"
+#include "osi/include/osi.h"
+
+/* Record layout of AVRC_PEER_VERSION_CONF_FILE */
+struct blacklist_entry
+{
+    int ver;
+    char addr[3];
+};
+
+#define SDP_PEER_VER_BUCKETS        64
+
+/* Delay before new records are written out, so a burst of them is appended
+** with a single open of the file */
+#define SDP_PEER_VER_PERSIST_MS     1000
+
+/* The OUI is the hash map key; this bit keeps 00:00:00 from being NULL */
+#define SDP_PEER_VER_KEY(addr)      UINT_TO_PTR(0x1000000 | ((addr)[0] << 16) | \
+                                                ((addr)[1] << 8) | (addr)[2])
+
+/* Quirks looked up for a peer, one entry per peer with an SDP connection */
+typedef struct
+{
+    BD_ADDR     addr;
+    BOOLEAN     in_use;
+    UINT8       known;      /* SDP_PEER_QUIRK_* bits looked up */
+    UINT8       quirks;     /* SDP_PEER_QUIRK_* bits that apply to the peer */
+} tSDP_PEER_QUIRKS;
+
+static pthread_mutex_t sdp_peer_ver_lock = PTHREAD_MUTEX_INITIALIZER;
+static hash_map_t *sdp_peer_ver_map;
+static alarm_t *sdp_peer_ver_timer;
+
+/* Records stored but not written to the file yet */
+static struct blacklist_entry *sdp_peer_ver_pending;
+static size_t sdp_peer_ver_num_pending;
+static size_t sdp_peer_ver_max_pending;
+
+static tSDP_PEER_QUIRKS sdp_peer_quirks[SDP_MAX_CONNECTIONS];
+static UINT8 sdp_peer_quirks_next;     /* round robin replacement */
+
+static void sdp_peer_ver_persist_cb(void *data);
+static void sdp_peer_ver_write(const struct blacklist_entry *p_recs, size_t num_recs);
+static tSDP_PEER_QUIRKS *sdp_peer_quirks_find(BD_ADDR addr);
+
+/*******************************************************************************
+**
+** Function         sdp_peer_ver_init
+**
+** Description      Loads the stored peer versions, unless they are loaded
+**                  already.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_peer_ver_init(void)
+{
+    struct blacklist_entry data;
+    FILE *fp;
+    int count = 0;
+
+    pthread_mutex_lock(&sdp_peer_ver_lock);
+    if (sdp_peer_ver_map)
+    {
+        pthread_mutex_unlock(&sdp_peer_ver_lock);
+        return;
+    }
+
+    sdp_peer_ver_map = hash_map_new(SDP_PEER_VER_BUCKETS, hash_function_integer,
+                                    NULL, NULL, NULL);
+    sdp_peer_ver_timer = alarm_new("sdp.peer_ver_timer");
+    if (sdp_peer_ver_timer == NULL)
+        SDP_TRACE_ERROR("%s unable to create alarm, records are written at once",
+                        __func__);
+
+    fp = fopen(AVRC_PEER_VERSION_CONF_FILE, "rb");
+    if (!fp)
+    {
+        SDP_TRACE_DEBUG("%s unable to open AVRC Conf file for read: err: (%s)",
+                        __func__, strerror(errno));
+    }
+    else
+    {
+        while (fread(&data, sizeof(data), 1, fp) != 0)
+        {
+            /* The first record for an OUI is the one that counts */
+            void *key = SDP_PEER_VER_KEY((UINT8 *)data.addr);
+            if (!hash_map_has_key(sdp_peer_ver_map, key))
+            {
+                hash_map_set(sdp_peer_ver_map, key, INT_TO_PTR(data.ver));
+                count++;
+            }
+        }
+        fclose(fp);
+    }
+    pthread_mutex_unlock(&sdp_peer_ver_lock);
+
+    SDP_TRACE_DEBUG("%s loaded %d peer versions", __func__, count);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_peer_ver_free
+**
+** Description      Writes out the records that are still pending and releases
+**                  the store and the quirk cache. Called at stack shutdown.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_peer_ver_free(void)
+{
+    struct blacklist_entry *p_recs;
+    size_t num_recs;
+
+    /* waits for a running persist callback to complete */
+    alarm_free(sdp_peer_ver_timer);
+    sdp_peer_ver_timer = NULL;
+
+    pthread_mutex_lock(&sdp_peer_ver_lock);
+    p_recs = sdp_peer_ver_pending;
+    num_recs = sdp_peer_ver_num_pending;
+    sdp_peer_ver_pending = NULL;
+    sdp_peer_ver_num_pending = 0;
+    sdp_peer_ver_max_pending = 0;
+
+    hash_map_free(sdp_peer_ver_map);
+    sdp_peer_ver_map = NULL;
+
+    memset(sdp_peer_quirks, 0, sizeof(sdp_peer_quirks));
+    sdp_peer_quirks_next = 0;
+    pthread_mutex_unlock(&sdp_peer_ver_lock);
+
+    sdp_peer_ver_write(p_recs, num_recs);
+    osi_free(p_recs);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_get_stored_avrc_tg_version
+**
+** Description      Looks up the AVRCP target version stored for the OUI of
+**                  |addr|.
+**
+** Returns          the version, or AVRC_REV_INVALID if none is stored
+**
+*******************************************************************************/
+int sdp_get_stored_avrc_tg_version(BD_ADDR addr)
+{
+    int stored_ver = AVRC_REV_INVALID;
+    void *key = SDP_PEER_VER_KEY(addr);
+
+    pthread_mutex_lock(&sdp_peer_ver_lock);
+    if (sdp_peer_ver_map && hash_map_has_key(sdp_peer_ver_map, key))
+        stored_ver = PTR_TO_INT(hash_map_get(sdp_peer_ver_map, key));
+    pthread_mutex_unlock(&sdp_peer_ver_lock);
+
+    SDP_TRACE_DEBUG("%s BD Addr: %x:%x:%x, ver = 0x%x", __func__,
+                    addr[0], addr[1], addr[2], stored_ver);
+    return stored_ver;
+}
+
+/*******************************************************************************
+**
+** Function         SDP_StoreAvrcTgVersion
+**
+** Description      Records |ver| as the AVRCP target version of peers with
+**                  the OUI of |addr|, unless one is recorded already. The
+**                  file is updated later from the alarm thread, or at once if
+**                  the alarm could not be created.
+**
+** Returns          TRUE if the version was recorded
+**
+*******************************************************************************/
+BOOLEAN SDP_StoreAvrcTgVersion(BD_ADDR addr, UINT16 ver)
+{
+    void *key = SDP_PEER_VER_KEY(addr);
+    BOOLEAN write_now = FALSE;
+
+    sdp_peer_ver_init();
+
+    pthread_mutex_lock(&sdp_peer_ver_lock);
+    if (hash_map_has_key(sdp_peer_ver_map, key))
+    {
+        pthread_mutex_unlock(&sdp_peer_ver_lock);
+        SDP_TRACE_DEBUG("%s entry already present for %x:%x:%x", __func__,
+                        addr[0], addr[1], addr[2]);
+        return FALSE;
+    }
+
+    hash_map_set(sdp_peer_ver_map, key, INT_TO_PTR(ver));
+
+    if (sdp_peer_ver_num_pending == sdp_peer_ver_max_pending)
+    {
+        size_t max_pending = sdp_peer_ver_max_pending ? sdp_peer_ver_max_pending * 2 : 4;
+        struct blacklist_entry *p = osi_calloc(max_pending * sizeof(*p));
+        if (sdp_peer_ver_num_pending)
+            memcpy(p, sdp_peer_ver_pending, sdp_peer_ver_num_pending * sizeof(*p));
+        osi_free(sdp_peer_ver_pending);
+        sdp_peer_ver_pending = p;
+        sdp_peer_ver_max_pending = max_pending;
+    }
+
+    struct blacklist_entry *p_rec = &sdp_peer_ver_pending[sdp_peer_ver_num_pending++];
+    memset(p_rec, 0, sizeof(*p_rec));
+    p_rec->ver = ver;
+    memcpy(p_rec->addr, addr, sizeof(p_rec->addr));
+
+    if (sdp_peer_ver_timer == NULL)
+        write_now = TRUE;
+    else if (!alarm_is_scheduled(sdp_peer_ver_timer))
+        alarm_set(sdp_peer_ver_timer, SDP_PEER_VER_PERSIST_MS, sdp_peer_ver_persist_cb, NULL);
+    pthread_mutex_unlock(&sdp_peer_ver_lock);
+
+    if (write_now)
+        sdp_peer_ver_persist_cb(NULL);
+
+    SDP_TRACE_DEBUG("%s stored version 0x%x for %x:%x:%x", __func__, ver,
+                    addr[0], addr[1], addr[2]);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_peer_ver_persist_cb
+**
+** Description      Appends the pending records to AVRC_PEER_VERSION_CONF_FILE.
+**                  Runs on the alarm thread.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_peer_ver_persist_cb(UNUSED_ATTR void *data)
+{
+    struct blacklist_entry *p_recs;
+    size_t num_recs;
+
+    pthread_mutex_lock(&sdp_peer_ver_lock);
+    p_recs = sdp_peer_ver_pending;
+    num_recs = sdp_peer_ver_num_pending;
+    sdp_peer_ver_pending = NULL;
+    sdp_peer_ver_num_pending = 0;
+    sdp_peer_ver_max_pending = 0;
+    pthread_mutex_unlock(&sdp_peer_ver_lock);
+
+    sdp_peer_ver_write(p_recs, num_recs);
+    osi_free(p_recs);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_peer_ver_write
+**
+** Description      Appends |num_recs| records to AVRC_PEER_VERSION_CONF_FILE.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_peer_ver_write(const struct blacklist_entry *p_recs, size_t num_recs)
+{
+    FILE *fp;
+
+    if (num_recs == 0)
+        return;
+
+    fp = fopen(AVRC_PEER_VERSION_CONF_FILE, "ab");
+    if (!fp)
+    {
+        SDP_TRACE_ERROR("%s unable to open AVRC Conf file for write: error: (%s)",
+                        __func__, strerror(errno));
+    }
+    else
+    {
+        if (fwrite(p_recs, sizeof(*p_recs), num_recs, fp) != num_recs)
+            SDP_TRACE_ERROR("%s unable to write AVRC Conf file: error: (%s)",
+                            __func__, strerror(errno));
+        fclose(fp);
+    }
+}
+
+/* Returns the quirk cache entry of |addr|, NULL if there is none.
+** The caller holds sdp_peer_ver_lock. */
+static tSDP_PEER_QUIRKS *sdp_peer_quirks_find(BD_ADDR addr)
+{
+    for (size_t i = 0; i < SDP_MAX_CONNECTIONS; i++)
+    {
+        if (sdp_peer_quirks[i].in_use && !memcmp(sdp_peer_quirks[i].addr, addr, BD_ADDR_LEN))
+            return &sdp_peer_quirks[i];
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_peer_quirk_get
+**
+** Description      Looks up whether |quirk| applies to the peer |addr|.
+**
+** Returns          TRUE if the quirk was looked up for the peer before, with
+**                  the result in |p_applies|. FALSE if it is not cached.
+**
+*******************************************************************************/
+BOOLEAN sdp_peer_quirk_get(BD_ADDR addr, UINT8 quirk, BOOLEAN *p_applies)
+{
+    tSDP_PEER_QUIRKS *p_ent;
+    BOOLEAN known = FALSE;
+
+    pthread_mutex_lock(&sdp_peer_ver_lock);
+    p_ent = sdp_peer_quirks_find(addr);
+    if (p_ent && (p_ent->known & quirk))
+    {
+        *p_applies = (p_ent->quirks & quirk) ? TRUE : FALSE;
+        known = TRUE;
+    }
+    pthread_mutex_unlock(&sdp_peer_ver_lock);
+
+    return known;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_peer_quirk_set
+**
+** Description      Caches whether |quirk| applies to the peer |addr|. When
+**                  all entries are taken, the oldest peer is dropped.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_peer_quirk_set(BD_ADDR addr, UINT8 quirk, BOOLEAN applies)
+{
+    tSDP_PEER_QUIRKS *p_ent;
+
+    pthread_mutex_lock(&sdp_peer_ver_lock);
+    p_ent = sdp_peer_quirks_find(addr);
+    if (p_ent == NULL)
+    {
+        p_ent = &sdp_peer_quirks[sdp_peer_quirks_next];
+        sdp_peer_quirks_next = (sdp_peer_quirks_next + 1) % SDP_MAX_CONNECTIONS;
+
+        memset(p_ent, 0, sizeof(*p_ent));
+        memcpy(p_ent->addr, addr, BD_ADDR_LEN);
+        p_ent->in_use = TRUE;
+    }
+
+    p_ent->known |= quirk;
+    if (applies)
+        p_ent->quirks |= quirk;
+    else
+        p_ent->quirks &= ~quirk;
+    pthread_mutex_unlock(&sdp_peer_ver_lock);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_peer_quirk_clear
+**
+** Description      Drops the cached quirks of the peer |addr|, so that they
+**                  are looked up again on its next SDP connection.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_peer_quirk_clear(BD_ADDR addr)
+{
+    tSDP_PEER_QUIRKS *p_ent;
+
+    pthread_mutex_lock(&sdp_peer_ver_lock);
+    p_ent = sdp_peer_quirks_find(addr);
+    if (p_ent)
+        memset(p_ent, 0, sizeof(*p_ent));
+    pthread_mutex_unlock(&sdp_peer_ver_lock);
+}
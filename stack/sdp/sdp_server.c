@@ -121,43 +121,6 @@ static tSDP_RECORD *sdp_update_pbap_record_if_blacklisted(tSDP_RECORD *p_rec,
 #define SDP_TEXT_BAD_MAX_RECORDS_LIST   NULL
 #endif
 
-struct blacklist_entry
-{
-    int ver;
-    char addr[3];
-};
-
-int sdp_get_stored_avrc_tg_version(BD_ADDR addr)
-{
-    int stored_ver = AVRC_REV_INVALID;
-    struct blacklist_entry data;
-    FILE *fp;
-
-    SDP_TRACE_DEBUG("%s target BD Addr: %x:%x:%x", __func__,\
-                        addr[0], addr[1], addr[2]);
-
-    fp = fopen(AVRC_PEER_VERSION_CONF_FILE, "rb");
-    if (!fp)
-    {
-       SDP_TRACE_ERROR("%s unable to open AVRC Conf file for read: err: (%s)",\
-                                        __func__, strerror(errno));
-       return stored_ver;
-    }
-    while (fread(&data, sizeof(data), 1, fp) != 0)
-    {
-        SDP_TRACE_DEBUG("Entry: addr = %x:%x:%x, ver = 0x%x",\
-                data.addr[0], data.addr[1], data.addr[2], data.ver);
-        if(!memcmp(addr, data.addr, 3))
-        {
-            stored_ver = data.ver;
-            SDP_TRACE_DEBUG("Entry found with version: 0x%x", stored_ver);
-            break;
-        }
-    }
-    fclose(fp);
-    return stored_ver;
-}
-
 /****************************************************************************
 **
 ** Function         sdp_dev_blacklisted_for_avrcp15
@@ -308,7 +271,7 @@ BD_ADDR                                                                      rem
 ***************************************************************************************/
 BOOLEAN sdp_change_hfp_version (tSDP_ATTRIBUTE *p_attr, BD_ADDR remote_address)
 {
-    bool is_blacklisted = FALSE;
+    BOOLEAN use_1_7 = FALSE;
     char value[PROPERTY_VALUE_MAX];
     if ((p_attr->id == ATTR_ID_BT_PROFILE_DESC_LIST) &&
         (p_attr->len >= SDP_PROFILE_DESC_LENGTH))
@@ -317,16 +280,23 @@ BOOLEAN sdp_change_hfp_version (tSDP_ATTRIBUTE *p_attr, BD_ADDR remote_address)
         if (((p_attr->value_ptr[3] << 8) | (p_attr->value_ptr[4])) ==
                 UUID_SERVCLASS_HF_HANDSFREE)
         {
-            bt_bdaddr_t remote_bdaddr;
-            bdcpy(remote_bdaddr.address, remote_address);
-            is_blacklisted = interop_database_match_addr(INTEROP_HFP_1_7_BLACKLIST, (bt_bdaddr_t *)&remote_bdaddr);
-            SDP_TRACE_DEBUG("%s: HF version is 1.7 for BD addr: %x:%x:%x",\
-                           __func__, remote_address[0], remote_address[1], remote_address[2]);
-            /* For PTS we should show AG's HFP version as 1.7 */
-            if (is_blacklisted ||
-                (property_get("bt.pts.certification", value, "false") &&
-                 strcmp(value, "true") == 0))
+            /* looked up once per connection of the peer */
+            if (!sdp_peer_quirk_get(remote_address, SDP_PEER_QUIRK_HFP_1_7, &use_1_7))
+            {
+                bt_bdaddr_t remote_bdaddr;
+                bdcpy(remote_bdaddr.address, remote_address);
+                /* For PTS we should show AG's HFP version as 1.7 */
+                use_1_7 = interop_database_match_addr(INTEROP_HFP_1_7_BLACKLIST,
+                                                      (bt_bdaddr_t *)&remote_bdaddr) ||
+                          (property_get("bt.pts.certification", value, "false") &&
+                           strcmp(value, "true") == 0);
+                sdp_peer_quirk_set(remote_address, SDP_PEER_QUIRK_HFP_1_7, use_1_7);
+            }
+
+            if (use_1_7)
             {
+                SDP_TRACE_DEBUG("%s: HF version is 1.7 for BD addr: %x:%x:%x",
+                               __func__, remote_address[0], remote_address[1], remote_address[2]);
                 p_attr->value_ptr[PROFILE_VERSION_POSITION] = 0x07; // Update HFP version as 1.7
                 SDP_TRACE_ERROR("SDP Change HFP Version = 0x%x",
                          p_attr->value_ptr[PROFILE_VERSION_POSITION]);
@@ -146,6 +146,9 @@ void sdpu_release_ccb (tCONN_CB *p_ccb)
     alarm_free(p_ccb->sdp_conn_timer);
     p_ccb->sdp_conn_timer = NULL;
 
+    /* Quirks are looked up again on the next connection of the peer */
+    sdp_peer_quirk_clear(p_ccb->device_address);
+
     /* Drop any response pointer we may be holding */
     p_ccb->con_state = SDP_STATE_IDLE;
 #if SDP_CLIENT_ENABLED == TRUE
@@ -247,6 +247,7 @@ extern tSDP_CB *sdp_cb_ptr;
 
 /* Functions provided by sdp_main.c */
 extern void     sdp_init (void);
+extern void     sdp_free (void);
 extern void     sdp_disconnect (tCONN_CB*p_ccb, UINT16 reason);
 
 #if (defined(SDP_DEBUG) && SDP_DEBUG == TRUE)
@@ -317,8 +318,20 @@ extern void     sdp_server_handle_client_req (tCONN_CB *p_ccb, BT_HDR *p_msg);
 #endif
 
 extern BOOLEAN sdp_dev_blacklisted_for_avrcp15 (BD_ADDR addr);
+
+/* Functions provided by sdp_peer_ver.c
+*/
+extern void sdp_peer_ver_init(void);
+extern void sdp_peer_ver_free(void);
 extern int sdp_get_stored_avrc_tg_version(BD_ADDR addr);
 
+/* Interoperability quirks cached per peer */
+#define SDP_PEER_QUIRK_HFP_1_7      0x01    /* advertise HFP AG version 1.7 */
+
+extern BOOLEAN sdp_peer_quirk_get(BD_ADDR addr, UINT8 quirk, BOOLEAN *p_applies);
+extern void sdp_peer_quirk_set(BD_ADDR addr, UINT8 quirk, BOOLEAN applies);
+extern void sdp_peer_quirk_clear(BD_ADDR addr);
+
 
 /* Functions provided by sdp_discovery.c
 */
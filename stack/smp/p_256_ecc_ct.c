@@ -0,0 +1,602 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2006-2015 Broadcom Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+ /******************************************************************************
+  *
+  *  This file contains a constant time P-256 implementation for LE Secure
+  *  Connections.
+  *
+  *  Field elements are four 64 bit limbs in Montgomery form. Points are kept
+  *  in homogeneous projective coordinates and combined with the complete
+  *  a = -3 formulas of Renes, Costello and Batina, so no input (including the
+  *  point at infinity and doublings) needs a special case.
+  *
+  *  k * G uses a fixed 4 bit window over a table of j * 16^i * G (built once
+  *  on first use) and needs one table lookup and one mixed addition per
+  *  window. k * P uses a 4 bit fixed window over a per call table. All table
+  *  lookups scan every entry, and no branch or memory index depends on the
+  *  scalar.
+  *
+  ******************************************************************************/
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "p_256_ecc_ct.h"
+
+#define ECC_CT_LIMBS    4
+#define ECC_CT_WINDOWS  64      /* 256 bit scalar / 4 bit window */
+#define ECC_CT_WSIZE    16
+
+typedef uint64_t felem[ECC_CT_LIMBS];
+
+typedef struct {
+    felem x;
+    felem y;
+    felem z;
+} ct_point;
+
+typedef struct {
+    felem x;
+    felem y;
+} ct_affine;
+
+static const felem p256_p = {
+    0xffffffffffffffffULL, 0x00000000ffffffffULL,
+    0x0000000000000000ULL, 0xffffffff00000001ULL
+};
+
+/* R^2 mod p, R = 2^256 */
+static const felem p256_rr = {
+    0x0000000000000003ULL, 0xfffffffbffffffffULL,
+    0xfffffffffffffffeULL, 0x00000004fffffffdULL
+};
+
+/* 1 in Montgomery form */
+static const felem p256_one = {
+    0x0000000000000001ULL, 0xffffffff00000000ULL,
+    0xffffffffffffffffULL, 0x00000000fffffffeULL
+};
+
+/* curve coefficient b in Montgomery form */
+static const felem p256_b = {
+    0xd89cdf6229c4bddfULL, 0xacf005cd78843090ULL,
+    0xe5a220abf7212ed6ULL, 0xdc30061d04874834ULL
+};
+
+/* base point in Montgomery form */
+static const ct_affine p256_g = {
+    { 0x79e730d418a9143cULL, 0x75ba95fc5fedb601ULL,
+      0x79fb732b77622510ULL, 0x18905f76a53755c6ULL },
+    { 0xddf25357ce95560aULL, 0x8b4ab8e4ba19e45cULL,
+      0xd2e88688dd21f325ULL, 0x8571ff1825885d85ULL }
+};
+
+/* base_table[i][j - 1] = j * 16^i * G, affine, Montgomery form */
+static ct_affine base_table[ECC_CT_WINDOWS][ECC_CT_WSIZE - 1];
+static pthread_once_t base_table_once = PTHREAD_ONCE_INIT;
+
+/*******************************************************************************
+**  Word arithmetic
+*******************************************************************************/
+
+/* returns the low word of a * b + c + *carry, high word goes to *carry */
+static inline uint64_t mac64(uint64_t a, uint64_t b, uint64_t c, uint64_t *carry)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 t = (unsigned __int128)a * b + c + *carry;
+    *carry = (uint64_t)(t >> 64);
+    return (uint64_t)t;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi;
+    uint64_t hl = a_hi * b_lo, hh = a_hi * b_hi;
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    uint64_t lo = (uint32_t)ll | (mid << 32);
+    uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+    lo += c;
+    hi += (lo < c);
+    lo += *carry;
+    hi += (lo < *carry);
+    *carry = hi;
+    return lo;
+#endif
+}
+
+static inline uint64_t adc64(uint64_t a, uint64_t b, uint64_t *carry)
+{
+    uint64_t s = a + *carry;
+    uint64_t c = (s < a);
+
+    s += b;
+    *carry = c | (s < b);
+    return s;
+}
+
+static inline uint64_t sbb64(uint64_t a, uint64_t b, uint64_t *borrow)
+{
+    uint64_t d = a - b;
+    uint64_t c = (a < b);
+
+    c |= (d < *borrow);
+    d -= *borrow;
+    *borrow = c;
+    return d;
+}
+
+/*******************************************************************************
+**  Field arithmetic mod p, Montgomery form
+*******************************************************************************/
+
+/* r = t - p if (hi:t) >= p else t; (hi:t) < 2p */
+static void fe_reduce_once(felem r, const felem t, uint64_t hi)
+{
+    felem s;
+    uint64_t borrow = 0, mask;
+    int i;
+
+    for (i = 0; i < ECC_CT_LIMBS; i++)
+        s[i] = sbb64(t[i], p256_p[i], &borrow);
+    sbb64(hi, 0, &borrow);
+
+    /* borrow set means (hi:t) < p: keep t */
+    mask = 0 - borrow;
+    for (i = 0; i < ECC_CT_LIMBS; i++)
+        r[i] = (t[i] & mask) | (s[i] & ~mask);
+}
+
+static void fe_add(felem r, const felem a, const felem b)
+{
+    felem t;
+    uint64_t carry = 0;
+    int i;
+
+    for (i = 0; i < ECC_CT_LIMBS; i++)
+        t[i] = adc64(a[i], b[i], &carry);
+    fe_reduce_once(r, t, carry);
+}
+
+static void fe_sub(felem r, const felem a, const felem b)
+{
+    felem t;
+    uint64_t borrow = 0, carry = 0, mask;
+    int i;
+
+    for (i = 0; i < ECC_CT_LIMBS; i++)
+        t[i] = sbb64(a[i], b[i], &borrow);
+
+    mask = 0 - borrow;
+    for (i = 0; i < ECC_CT_LIMBS; i++)
+        r[i] = adc64(t[i], p256_p[i] & mask, &carry);
+}
+
+/* r = a * b / R mod p (CIOS, -p^-1 mod 2^64 = 1) */
+static void fe_mul(felem r, const felem a, const felem b)
+{
+    uint64_t t[ECC_CT_LIMBS + 2] = { 0 };
+    uint64_t carry, c, m;
+    int i, j;
+
+    for (i = 0; i < ECC_CT_LIMBS; i++)
+    {
+        carry = 0;
+        for (j = 0; j < ECC_CT_LIMBS; j++)
+            t[j] = mac64(a[j], b[i], t[j], &carry);
+        t[ECC_CT_LIMBS] = adc64(t[ECC_CT_LIMBS], carry, &t[ECC_CT_LIMBS + 1]);
+
+        m = t[0];
+        carry = 0;
+        mac64(m, p256_p[0], t[0], &carry);
+        for (j = 1; j < ECC_CT_LIMBS; j++)
+            t[j - 1] = mac64(m, p256_p[j], t[j], &carry);
+        c = 0;
+        t[ECC_CT_LIMBS - 1] = adc64(t[ECC_CT_LIMBS], carry, &c);
+        t[ECC_CT_LIMBS] = t[ECC_CT_LIMBS + 1] + c;
+        t[ECC_CT_LIMBS + 1] = 0;
+    }
+
+    fe_reduce_once(r, t, t[ECC_CT_LIMBS]);
+}
+
+static void fe_sqr(felem r, const felem a)
+{
+    fe_mul(r, a, a);
+}
+
+/* r = a^(p - 2), i.e. 1 / a, or 0 when a is 0. The exponent is public. */
+static void fe_inv(felem r, const felem a)
+{
+    static const felem exp = {
+        0xfffffffffffffffdULL, 0x00000000ffffffffULL,
+        0x0000000000000000ULL, 0xffffffff00000001ULL
+    };
+    felem t;
+    int i;
+
+    memcpy(t, p256_one, sizeof(felem));
+    for (i = 255; i >= 0; i--)
+    {
+        fe_sqr(t, t);
+        if ((exp[i / 64] >> (i % 64)) & 1)
+            fe_mul(t, t, a);
+    }
+    memcpy(r, t, sizeof(felem));
+}
+
+static void fe_from_bytes(felem r, const UINT8 *p)
+{
+    felem t;
+    int i, j;
+
+    for (i = 0; i < ECC_CT_LIMBS; i++)
+    {
+        t[i] = 0;
+        for (j = 7; j >= 0; j--)
+            t[i] = (t[i] << 8) | p[i * 8 + j];
+    }
+    fe_mul(r, t, p256_rr);
+}
+
+static void fe_to_bytes(UINT8 *p, const felem a)
+{
+    static const felem one = { 1, 0, 0, 0 };
+    felem t;
+    int i, j;
+
+    fe_mul(t, a, one);
+    for (i = 0; i < ECC_CT_LIMBS; i++)
+        for (j = 0; j < 8; j++)
+            p[i * 8 + j] = (UINT8)(t[i] >> (8 * j));
+}
+
+/*******************************************************************************
+**  Point arithmetic, complete formulas for a = -3 (RCB16 algorithms 4, 5, 6)
+*******************************************************************************/
+
+static void point_add(ct_point *r, const ct_point *p, const ct_point *q)
+{
+    felem t0, t1, t2, t3, t4, x3, y3, z3;
+
+    fe_mul(t0, p->x, q->x);
+    fe_mul(t1, p->y, q->y);
+    fe_mul(t2, p->z, q->z);
+    fe_add(t3, p->x, p->y);
+    fe_add(t4, q->x, q->y);
+    fe_mul(t3, t3, t4);
+    fe_add(t4, t0, t1);
+    fe_sub(t3, t3, t4);
+    fe_add(t4, p->y, p->z);
+    fe_add(x3, q->y, q->z);
+    fe_mul(t4, t4, x3);
+    fe_add(x3, t1, t2);
+    fe_sub(t4, t4, x3);
+    fe_add(x3, p->x, p->z);
+    fe_add(y3, q->x, q->z);
+    fe_mul(x3, x3, y3);
+    fe_add(y3, t0, t2);
+    fe_sub(y3, x3, y3);
+    fe_mul(z3, p256_b, t2);
+    fe_sub(x3, y3, z3);
+    fe_add(z3, x3, x3);
+    fe_add(x3, x3, z3);
+    fe_sub(z3, t1, x3);
+    fe_add(x3, t1, x3);
+    fe_mul(y3, p256_b, y3);
+    fe_add(t1, t2, t2);
+    fe_add(t2, t1, t2);
+    fe_sub(y3, y3, t2);
+    fe_sub(y3, y3, t0);
+    fe_add(t1, y3, y3);
+    fe_add(y3, t1, y3);
+    fe_add(t1, t0, t0);
+    fe_add(t0, t1, t0);
+    fe_sub(t0, t0, t2);
+    fe_mul(t1, t4, y3);
+    fe_mul(t2, t0, y3);
+    fe_mul(y3, x3, z3);
+    fe_add(y3, y3, t2);
+    fe_mul(x3, t3, x3);
+    fe_sub(x3, x3, t1);
+    fe_mul(z3, t4, z3);
+    fe_mul(t1, t3, t0);
+    fe_add(z3, z3, t1);
+
+    memcpy(r->x, x3, sizeof(felem));
+    memcpy(r->y, y3, sizeof(felem));
+    memcpy(r->z, z3, sizeof(felem));
+}
+
+/* q must not be the point at infinity */
+static void point_add_mixed(ct_point *r, const ct_point *p, const ct_affine *q)
+{
+    felem t0, t1, t2, t3, t4, x3, y3, z3;
+
+    fe_mul(t0, p->x, q->x);
+    fe_mul(t1, p->y, q->y);
+    fe_add(t3, q->x, q->y);
+    fe_add(t4, p->x, p->y);
+    fe_mul(t3, t3, t4);
+    fe_add(t4, t0, t1);
+    fe_sub(t3, t3, t4);
+    fe_mul(t4, q->y, p->z);
+    fe_add(t4, t4, p->y);
+    fe_mul(y3, q->x, p->z);
+    fe_add(y3, y3, p->x);
+    fe_mul(z3, p256_b, p->z);
+    fe_sub(x3, y3, z3);
+    fe_add(z3, x3, x3);
+    fe_add(x3, x3, z3);
+    fe_sub(z3, t1, x3);
+    fe_add(x3, t1, x3);
+    fe_mul(y3, p256_b, y3);
+    fe_add(t1, p->z, p->z);
+    fe_add(t2, t1, p->z);
+    fe_sub(y3, y3, t2);
+    fe_sub(y3, y3, t0);
+    fe_add(t1, y3, y3);
+    fe_add(y3, t1, y3);
+    fe_add(t1, t0, t0);
+    fe_add(t0, t1, t0);
+    fe_sub(t0, t0, t2);
+    fe_mul(t1, t4, y3);
+    fe_mul(t2, t0, y3);
+    fe_mul(y3, x3, z3);
+    fe_add(y3, y3, t2);
+    fe_mul(x3, t3, x3);
+    fe_sub(x3, x3, t1);
+    fe_mul(z3, t4, z3);
+    fe_mul(t1, t3, t0);
+    fe_add(z3, z3, t1);
+
+    memcpy(r->x, x3, sizeof(felem));
+    memcpy(r->y, y3, sizeof(felem));
+    memcpy(r->z, z3, sizeof(felem));
+}
+
+static void point_double(ct_point *r, const ct_point *p)
+{
+    felem t0, t1, t2, t3, x3, y3, z3;
+
+    fe_sqr(t0, p->x);
+    fe_sqr(t1, p->y);
+    fe_sqr(t2, p->z);
+    fe_mul(t3, p->x, p->y);
+    fe_add(t3, t3, t3);
+    fe_mul(z3, p->x, p->z);
+    fe_add(z3, z3, z3);
+    fe_mul(y3, p256_b, t2);
+    fe_sub(y3, y3, z3);
+    fe_add(x3, y3, y3);
+    fe_add(y3, x3, y3);
+    fe_sub(x3, t1, y3);
+    fe_add(y3, t1, y3);
+    fe_mul(y3, x3, y3);
+    fe_mul(x3, x3, t3);
+    fe_add(t3, t2, t2);
+    fe_add(t2, t2, t3);
+    fe_mul(z3, p256_b, z3);
+    fe_sub(z3, z3, t2);
+    fe_sub(z3, z3, t0);
+    fe_add(t3, z3, z3);
+    fe_add(z3, z3, t3);
+    fe_add(t3, t0, t0);
+    fe_add(t0, t3, t0);
+    fe_sub(t0, t0, t2);
+    fe_mul(t0, t0, z3);
+    fe_add(y3, y3, t0);
+    fe_mul(t0, p->y, p->z);
+    fe_add(t0, t0, t0);
+    fe_mul(z3, t0, z3);
+    fe_sub(x3, x3, z3);
+    fe_mul(z3, t0, t1);
+    fe_add(z3, z3, z3);
+    fe_add(z3, z3, z3);
+
+    memcpy(r->x, x3, sizeof(felem));
+    memcpy(r->y, y3, sizeof(felem));
+    memcpy(r->z, z3, sizeof(felem));
+}
+
+static void point_set_infinity(ct_point *r)
+{
+    memset(r->x, 0, sizeof(felem));
+    memcpy(r->y, p256_one, sizeof(felem));
+    memset(r->z, 0, sizeof(felem));
+}
+
+static void point_to_affine(UINT8 *x, UINT8 *y, const ct_point *p)
+{
+    felem zinv, t;
+
+    /* infinity has z = 0 and comes out as (0, 0) */
+    fe_inv(zinv, p->z);
+    fe_mul(t, p->x, zinv);
+    fe_to_bytes(x, t);
+    fe_mul(t, p->y, zinv);
+    fe_to_bytes(y, t);
+}
+
+/*******************************************************************************
+**  Constant time helpers
+*******************************************************************************/
+
+/* all ones if a == b else 0 */
+static inline uint64_t ct_eq_mask(UINT32 a, UINT32 b)
+{
+    return 0 - (uint64_t)(((a ^ b) - 1) >> 31);
+}
+
+static inline void ct_cmov(uint64_t *r, const uint64_t *a, size_t words, uint64_t mask)
+{
+    size_t i;
+
+    for (i = 0; i < words; i++)
+        r[i] = (r[i] & ~mask) | (a[i] & mask);
+}
+
+static inline UINT32 ct_nibble(const UINT8 *k, int i)
+{
+    return (k[i >> 1] >> ((i & 1) << 2)) & 0x0f;
+}
+
+static void ct_wipe(void *p, size_t len)
+{
+    volatile UINT8 *v = (volatile UINT8 *)p;
+
+    while (len--)
+        *v++ = 0;
+}
+
+/*******************************************************************************
+**  Base point table
+*******************************************************************************/
+
+static void base_table_init(void)
+{
+    ct_point row[ECC_CT_WSIZE - 1], step;
+    felem prod[ECC_CT_WSIZE - 1], inv, zinv, t;
+    int i, j;
+
+    memcpy(step.x, p256_g.x, sizeof(felem));
+    memcpy(step.y, p256_g.y, sizeof(felem));
+    memcpy(step.z, p256_one, sizeof(felem));
+
+    for (i = 0; i < ECC_CT_WINDOWS; i++)
+    {
+        /* row[j - 1] = j * 16^i * G */
+        row[0] = step;
+        for (j = 1; j < ECC_CT_WSIZE - 1; j++)
+            point_add(&row[j], &row[j - 1], &step);
+        point_add(&step, &row[ECC_CT_WSIZE - 2], &step);
+
+        /* one inversion per window (Montgomery's trick) */
+        memcpy(prod[0], row[0].z, sizeof(felem));
+        for (j = 1; j < ECC_CT_WSIZE - 1; j++)
+            fe_mul(prod[j], prod[j - 1], row[j].z);
+        fe_inv(inv, prod[ECC_CT_WSIZE - 2]);
+
+        for (j = ECC_CT_WSIZE - 2; j >= 0; j--)
+        {
+            if (j > 0)
+            {
+                fe_mul(zinv, inv, prod[j - 1]);
+                fe_mul(inv, inv, row[j].z);
+            }
+            else
+                memcpy(zinv, inv, sizeof(felem));
+
+            fe_mul(t, row[j].x, zinv);
+            memcpy(base_table[i][j].x, t, sizeof(felem));
+            fe_mul(t, row[j].y, zinv);
+            memcpy(base_table[i][j].y, t, sizeof(felem));
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         ECC_BaseMult_Ct
+**
+** Description      Computes (x, y) = k * G in constant time using the
+**                  precomputed base point table.
+**
+** Returns          void
+**
+*******************************************************************************/
+void ECC_BaseMult_Ct(UINT8 *x, UINT8 *y, const UINT8 *k)
+{
+    ct_point acc, sum;
+    ct_affine entry;
+    UINT32 d;
+    int i, j;
+
+    pthread_once(&base_table_once, base_table_init);
+
+    point_set_infinity(&acc);
+    for (i = 0; i < ECC_CT_WINDOWS; i++)
+    {
+        d = ct_nibble(k, i);
+
+        memset(&entry, 0, sizeof(entry));
+        for (j = 1; j < ECC_CT_WSIZE; j++)
+            ct_cmov((uint64_t *)&entry, (const uint64_t *)&base_table[i][j - 1],
+                    sizeof(entry) / sizeof(uint64_t), ct_eq_mask(j, d));
+
+        /* the sum is always computed and only kept for a non zero digit */
+        point_add_mixed(&sum, &acc, &entry);
+        ct_cmov((uint64_t *)&acc, (const uint64_t *)&sum,
+                sizeof(acc) / sizeof(uint64_t), ~ct_eq_mask(d, 0));
+    }
+
+    point_to_affine(x, y, &acc);
+
+    ct_wipe(&acc, sizeof(acc));
+    ct_wipe(&sum, sizeof(sum));
+    ct_wipe(&entry, sizeof(entry));
+    ct_wipe(&d, sizeof(d));
+}
+
+/*******************************************************************************
+**
+** Function         ECC_PointMult_Ct
+**
+** Description      Computes (x, y) = k * (px, py) in constant time with a
+**                  4 bit fixed window.
+**
+** Returns          void
+**
+*******************************************************************************/
+void ECC_PointMult_Ct(UINT8 *x, UINT8 *y, const UINT8 *px, const UINT8 *py,
+                      const UINT8 *k)
+{
+    ct_point table[ECC_CT_WSIZE], acc, entry;
+    UINT32 d;
+    int i, j;
+
+    point_set_infinity(&table[0]);
+    fe_from_bytes(table[1].x, px);
+    fe_from_bytes(table[1].y, py);
+    memcpy(table[1].z, p256_one, sizeof(felem));
+    for (j = 2; j < ECC_CT_WSIZE; j++)
+        point_add(&table[j], &table[j - 1], &table[1]);
+
+    point_set_infinity(&acc);
+    for (i = ECC_CT_WINDOWS - 1; i >= 0; i--)
+    {
+        for (j = 0; j < 4; j++)
+            point_double(&acc, &acc);
+
+        d = ct_nibble(k, i);
+        memset(&entry, 0, sizeof(entry));
+        for (j = 0; j < ECC_CT_WSIZE; j++)
+            ct_cmov((uint64_t *)&entry, (const uint64_t *)&table[j],
+                    sizeof(entry) / sizeof(uint64_t), ct_eq_mask(j, d));
+
+        point_add(&acc, &acc, &entry);
+    }
+
+    point_to_affine(x, y, &acc);
+
+    ct_wipe(table, sizeof(table));
+    ct_wipe(&acc, sizeof(acc));
+    ct_wipe(&entry, sizeof(entry));
+    ct_wipe(&d, sizeof(d));
+}
@@ -0,0 +1,38 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2006-2015 Broadcom Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+ /******************************************************************************
+  *
+  *  Constant time P-256 scalar multiplication used for LE Secure Connections
+  *  key generation and DHKey computation.
+  *
+  *  All coordinates and scalars are 32 byte little endian integers, i.e. the
+  *  same layout as BT_OCTET32 and as the DWORD arrays of p_256_ecc_pp.h.
+  *
+  ******************************************************************************/
+
+#pragma once
+
+#include "bt_types.h"
+
+/* Computes (x, y) = k * G. */
+void ECC_BaseMult_Ct(UINT8 *x, UINT8 *y, const UINT8 *k);
+
+/* Computes (x, y) = k * (px, py). */
+void ECC_PointMult_Ct(UINT8 *x, UINT8 *y, const UINT8 *px, const UINT8 *py,
+                      const UINT8 *k);
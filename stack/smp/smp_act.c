@@ -1563,9 +1563,8 @@ void smp_fast_conn_param(tSMP_CB *p_cb, tSMP_INT_DATA *p_data)
 ** Description  The function is called when both local and peer public keys are
 **              saved.
 **              Actions:
-**              - invokes DHKey computation;
-**              - on slave side invokes sending local public key to the peer.
-**              - invokes SC phase 1 process.
+**              - invokes DHKey computation, which completes in
+**                smp_dhkey_computed().
 *******************************************************************************/
 void smp_both_have_public_keys(tSMP_CB *p_cb, tSMP_INT_DATA *p_data)
 {
@@ -1573,6 +1572,18 @@ void smp_both_have_public_keys(tSMP_CB *p_cb, tSMP_INT_DATA *p_data)
 
     /* invokes DHKey computation */
     smp_compute_dhkey(p_cb);
+}
+
+/*******************************************************************************
+** Function     smp_dhkey_computed
+** Description  The function is called when the DHKey is saved.
+**              Actions:
+**              - on slave side invokes sending local public key to the peer.
+**              - invokes SC phase 1 process.
+*******************************************************************************/
+void smp_dhkey_computed(tSMP_CB *p_cb)
+{
+    SMP_TRACE_DEBUG("%s",__func__);
 
     /* on slave side invokes sending local public key to the peer */
     if (p_cb->role == HCI_ROLE_SLAVE)
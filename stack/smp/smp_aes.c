@@ -0,0 +1,604 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2008-2012 Broadcom Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the AES-128 block cipher front end used by SMP: the
+ *  block function is picked at run time (AES-NI, ARMv8 Crypto Extensions or
+ *  the table based aes.c), key schedules are expanded once and kept in a
+ *  small per key cache, and AES-CMAC is computed without allocating.
+ *
+ *  Keys and data passed to the SMP_* functions are in the stack byte order
+ *  (LSB first); the cipher itself works on the reversed (MSB first) blocks.
+ *
+ ******************************************************************************/
+
+#include "bt_target.h"
+
+#if SMP_INCLUDED == TRUE
+
+#include <pthread.h>
+#include <string.h>
+
+#include "bt_types.h"
+#include "hcidefs.h"
+#include "osi/include/allocator.h"
+#include "smp_api.h"
+#include "aes.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SMP_AES_X86_AESNI
+#include <cpuid.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(__ARM_FEATURE_CRYPTO) && defined(__linux__)
+#define SMP_AES_ARMV8_CE
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+/* number of distinct keys (LTK, CSRK, SMP ephemeral keys...) kept expanded */
+#ifndef SMP_AES_KEY_CACHE_SIZE
+#define SMP_AES_KEY_CACHE_SIZE  8
+#endif
+
+#define SMP_AES128_ROUNDS       10
+
+struct smp_key_sched
+{
+    aes_context ctx;
+};
+
+typedef void (tSMP_AES_BLOCK_FN)(const tSMP_KEY_SCHED *p_sched,
+                                 const UINT8 *in, UINT8 *out);
+
+typedef struct
+{
+    BOOLEAN         in_use;
+    BT_OCTET16      key;            /* as given by the caller, LSB first */
+    tSMP_KEY_SCHED  sched;
+    BOOLEAN         has_subkeys;
+    BT_OCTET16      k1;             /* CMAC subkeys, MSB first */
+    BT_OCTET16      k2;
+    UINT32          last_use;
+} tSMP_AES_KEY;
+
+typedef struct
+{
+    tSMP_AES_BLOCK_FN   *p_block;
+    const char          *p_name;
+    tSMP_AES_BLOCK_FN   *p_hw_block;
+    const char          *p_hw_name;
+
+    pthread_mutex_t     lock;
+    tSMP_AES_KEY        key[SMP_AES_KEY_CACHE_SIZE];
+    UINT32              use_count;
+} tSMP_AES_CB;
+
+static tSMP_AES_CB smp_aes_cb = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+static pthread_once_t smp_aes_once = PTHREAD_ONCE_INIT;
+
+/*******************************************************************************
+**  Block functions
+*******************************************************************************/
+static void smp_aes_block_sw(const tSMP_KEY_SCHED *p_sched, const UINT8 *in, UINT8 *out)
+{
+    aes_encrypt(in, out, &p_sched->ctx);
+}
+
+#if defined(SMP_AES_X86_AESNI)
+__attribute__((target("aes,sse2")))
+static void smp_aes_block_aesni(const tSMP_KEY_SCHED *p_sched, const UINT8 *in, UINT8 *out)
+{
+    const __m128i *rk = (const __m128i *)p_sched->ctx.ksch;
+    __m128i state = _mm_loadu_si128((const __m128i *)in);
+
+    state = _mm_xor_si128(state, _mm_loadu_si128(&rk[0]));
+    for (int round = 1; round < SMP_AES128_ROUNDS; round++)
+        state = _mm_aesenc_si128(state, _mm_loadu_si128(&rk[round]));
+    state = _mm_aesenclast_si128(state, _mm_loadu_si128(&rk[SMP_AES128_ROUNDS]));
+
+    _mm_storeu_si128((__m128i *)out, state);
+}
+
+static BOOLEAN smp_aes_hw_supported(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return FALSE;
+
+    return (ecx & bit_AES) && (edx & bit_SSE2);
+}
+#endif
+
+#if defined(SMP_AES_ARMV8_CE)
+static void smp_aes_block_armv8(const tSMP_KEY_SCHED *p_sched, const UINT8 *in, UINT8 *out)
+{
+    const UINT8 *rk = p_sched->ctx.ksch;
+    uint8x16_t state = vld1q_u8(in);
+
+    for (int round = 0; round < SMP_AES128_ROUNDS - 1; round++)
+        state = vaesmcq_u8(vaeseq_u8(state, vld1q_u8(rk + round * BT_OCTET16_LEN)));
+    state = vaeseq_u8(state, vld1q_u8(rk + (SMP_AES128_ROUNDS - 1) * BT_OCTET16_LEN));
+    state = veorq_u8(state, vld1q_u8(rk + SMP_AES128_ROUNDS * BT_OCTET16_LEN));
+
+    vst1q_u8(out, state);
+}
+
+static BOOLEAN smp_aes_hw_supported(void)
+{
+#if defined(__aarch64__)
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#else
+    return (getauxval(AT_HWCAP2) & HWCAP2_AES) != 0;
+#endif
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         smp_aes_init
+**
+** Description      Pick the fastest AES block function for this CPU.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_aes_init(void)
+{
+    tSMP_AES_CB *p_cb = &smp_aes_cb;
+
+    p_cb->p_block = smp_aes_block_sw;
+    p_cb->p_name = "software";
+
+#if defined(SMP_AES_X86_AESNI)
+    if (smp_aes_hw_supported())
+    {
+        p_cb->p_hw_block = smp_aes_block_aesni;
+        p_cb->p_hw_name = "aes-ni";
+    }
+#elif defined(SMP_AES_ARMV8_CE)
+    if (smp_aes_hw_supported())
+    {
+        p_cb->p_hw_block = smp_aes_block_armv8;
+        p_cb->p_hw_name = "armv8-ce";
+    }
+#endif
+
+    if (p_cb->p_hw_block != NULL)
+    {
+        p_cb->p_block = p_cb->p_hw_block;
+        p_cb->p_name = p_cb->p_hw_name;
+    }
+}
+
+static inline void smp_aes_block(const tSMP_KEY_SCHED *p_sched, const UINT8 *in, UINT8 *out)
+{
+    pthread_once(&smp_aes_once, smp_aes_init);
+    smp_aes_cb.p_block(p_sched, in, out);
+}
+
+/*******************************************************************************
+**
+** Function         SMP_AesBackend
+**
+** Description      Name of the AES implementation in use.
+**
+** Returns          "aes-ni", "armv8-ce" or "software"
+**
+*******************************************************************************/
+const char *SMP_AesBackend(void)
+{
+    pthread_once(&smp_aes_once, smp_aes_init);
+    return smp_aes_cb.p_name;
+}
+
+/*******************************************************************************
+**
+** Function         SMP_AesForceSoftware
+**
+** Description      Select the software AES implementation even when the CPU
+**                  has AES instructions (used to compare implementations).
+**
+** Returns          void
+**
+*******************************************************************************/
+void SMP_AesForceSoftware(BOOLEAN force)
+{
+    tSMP_AES_CB *p_cb = &smp_aes_cb;
+
+    pthread_once(&smp_aes_once, smp_aes_init);
+
+    if (force || p_cb->p_hw_block == NULL)
+    {
+        p_cb->p_block = smp_aes_block_sw;
+        p_cb->p_name = "software";
+    }
+    else
+    {
+        p_cb->p_block = p_cb->p_hw_block;
+        p_cb->p_name = p_cb->p_hw_name;
+    }
+}
+
+/*******************************************************************************
+**  Key schedules
+*******************************************************************************/
+static void smp_aes_expand_key(tSMP_KEY_SCHED *p_sched, const UINT8 *key)
+{
+    UINT8 rev_key[BT_OCTET16_LEN];
+
+    for (int i = 0; i < BT_OCTET16_LEN; i++)
+        rev_key[i] = key[BT_OCTET16_LEN - 1 - i];
+
+    aes_set_key(rev_key, BT_OCTET16_LEN, &p_sched->ctx);
+    memset(rev_key, 0, sizeof(rev_key));
+}
+
+/*******************************************************************************
+**
+** Function         SMP_KeySchedNew
+**
+** Description      Expand an AES-128 key once so that it can be reused for
+**                  any number of block encryptions.
+**
+** Parameters:      key - 16 byte key, key[0] contains the LSB (same byte order
+**                        as the keys stored in the security database)
+**
+** Returns          the key schedule, to be released with SMP_KeySchedFree
+**
+*******************************************************************************/
+tSMP_KEY_SCHED *SMP_KeySchedNew(const UINT8 *key)
+{
+    tSMP_KEY_SCHED *p_sched = osi_malloc(sizeof(tSMP_KEY_SCHED));
+
+    smp_aes_expand_key(p_sched, key);
+    return p_sched;
+}
+
+/*******************************************************************************
+**
+** Function         SMP_KeySchedFree
+**
+** Description      Wipe and release a key schedule.
+**
+** Returns          void
+**
+*******************************************************************************/
+void SMP_KeySchedFree(tSMP_KEY_SCHED *p_sched)
+{
+    if (p_sched == NULL)
+        return;
+
+    memset(p_sched, 0, sizeof(tSMP_KEY_SCHED));
+    osi_free(p_sched);
+}
+
+/*******************************************************************************
+**
+** Function         smp_aes_key_get
+**
+** Description      Find the cached schedule of a key, expanding it into the
+**                  least recently used slot on a miss. Called with the cache
+**                  lock held.
+**
+** Returns          cache entry
+**
+*******************************************************************************/
+static tSMP_AES_KEY *smp_aes_key_get(const UINT8 *key)
+{
+    tSMP_AES_CB *p_cb = &smp_aes_cb;
+    tSMP_AES_KEY *p_key = NULL;
+    tSMP_AES_KEY *p_lru = &p_cb->key[0];
+
+    for (int i = 0; i < SMP_AES_KEY_CACHE_SIZE; i++)
+    {
+        tSMP_AES_KEY *p = &p_cb->key[i];
+
+        if (p->in_use && !memcmp(p->key, key, BT_OCTET16_LEN))
+        {
+            p_key = p;
+            break;
+        }
+
+        if (!p->in_use)
+            p_lru = p;
+        else if (p_lru->in_use && p->last_use < p_lru->last_use)
+            p_lru = p;
+    }
+
+    if (p_key == NULL)
+    {
+        p_key = p_lru;
+        memset(p_key, 0, sizeof(tSMP_AES_KEY));
+        memcpy(p_key->key, key, BT_OCTET16_LEN);
+        smp_aes_expand_key(&p_key->sched, key);
+        p_key->in_use = TRUE;
+    }
+
+    p_key->last_use = ++p_cb->use_count;
+    return p_key;
+}
+
+/*******************************************************************************
+**
+** Function         SMP_AesClearKeyCache
+**
+** Description      Wipe all cached key schedules, e.g. when keys are removed.
+**
+** Returns          void
+**
+*******************************************************************************/
+void SMP_AesClearKeyCache(void)
+{
+    pthread_mutex_lock(&smp_aes_cb.lock);
+    memset(smp_aes_cb.key, 0, sizeof(smp_aes_cb.key));
+    pthread_mutex_unlock(&smp_aes_cb.lock);
+}
+
+/*******************************************************************************
+**  Block encryption
+*******************************************************************************/
+static void smp_aes_encrypt_le(const tSMP_KEY_SCHED *p_sched, const UINT8 *plain_text,
+                               UINT8 pt_len, tSMP_ENC *p_out)
+{
+    UINT8 rev_data[BT_OCTET16_LEN];
+    UINT8 rev_out[BT_OCTET16_LEN];
+
+    if (pt_len > BT_OCTET16_LEN)
+        pt_len = BT_OCTET16_LEN;
+
+    memset(rev_data, 0, sizeof(rev_data));
+    for (int i = 0; i < pt_len; i++)
+        rev_data[BT_OCTET16_LEN - 1 - i] = plain_text[i];
+
+    smp_aes_block(p_sched, rev_data, rev_out);
+
+    for (int i = 0; i < BT_OCTET16_LEN; i++)
+        p_out->param_buf[i] = rev_out[BT_OCTET16_LEN - 1 - i];
+
+    p_out->param_len = BT_OCTET16_LEN;
+    p_out->status = HCI_SUCCESS;
+    p_out->opcode = HCI_BLE_ENCRYPT;
+}
+
+/*******************************************************************************
+**
+** Function         SMP_EncryptSched
+**
+** Description      Same as SMP_Encrypt, using an already expanded key.
+**
+** Parameters:      p_sched    - key schedule
+**                  plain_text - data to be encrypted, plain_text[0] is the MSB
+**                  pt_len     - plain text length, at most 16
+**                  p_out      - encrypted output
+**
+** Returns          TRUE if encryption was done
+**
+*******************************************************************************/
+BOOLEAN SMP_EncryptSched(const tSMP_KEY_SCHED *p_sched, const UINT8 *plain_text,
+                         UINT8 pt_len, tSMP_ENC *p_out)
+{
+    if (p_sched == NULL || p_out == NULL)
+        return FALSE;
+
+    smp_aes_encrypt_le(p_sched, plain_text, pt_len, p_out);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         smp_aes_encrypt_cached
+**
+** Description      Encrypt one block with a key whose schedule is looked up
+**                  in, or added to, the key cache.
+**
+** Returns          void
+**
+*******************************************************************************/
+void smp_aes_encrypt_cached(const UINT8 *key, const UINT8 *plain_text, UINT8 pt_len,
+                            tSMP_ENC *p_out)
+{
+    pthread_mutex_lock(&smp_aes_cb.lock);
+    smp_aes_encrypt_le(&smp_aes_key_get(key)->sched, plain_text, pt_len, p_out);
+    pthread_mutex_unlock(&smp_aes_cb.lock);
+}
+
+/*******************************************************************************
+**
+** Function         SMP_Encrypt
+**
+** Description      This function is called to encrypt the data with the specified
+**                  key. The key schedule is kept in the key cache.
+**
+** Parameters:      key                 - Pointer to key key[0] conatins the MSB
+**                  key_len             - key length
+**                  plain_text          - Pointer to data to be encrypted
+**                                        plain_text[0] conatins the MSB
+**                  pt_len              - plain text length
+**                  p_out                - output of the encrypted texts
+**
+**  Returns         Boolean - request is successful
+*******************************************************************************/
+BOOLEAN SMP_Encrypt (UINT8 *key, UINT8 key_len,
+                     UINT8 *plain_text, UINT8 pt_len,
+                     tSMP_ENC *p_out)
+{
+    if (p_out == NULL || key_len != BT_OCTET16_LEN)
+        return FALSE;
+
+    if (pt_len > BT_OCTET16_LEN)
+        pt_len = BT_OCTET16_LEN;
+
+    smp_aes_encrypt_cached(key, plain_text, pt_len, p_out);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         SMP_ResolveRpaBatch
+**
+** Description      Check a resolvable private address against a set of IRK
+**                  key schedules. The ah() input block is built once and each
+**                  candidate costs a single AES block encryption.
+**
+** Parameters:      rpa      - resolvable private address
+**                  p_sched  - array of IRK key schedules
+**                  num      - number of entries in p_sched
+**                  start    - index to start searching from
+**
+** Returns          index of the first schedule at or after start that
+**                  generates rpa, or num if none does.
+**
+*******************************************************************************/
+UINT16 SMP_ResolveRpaBatch(const BD_ADDR rpa, tSMP_KEY_SCHED * const *p_sched,
+                           UINT16 num, UINT16 start)
+{
+    UINT8 prand[BT_OCTET16_LEN];
+    UINT8 hash[BT_OCTET16_LEN];
+    UINT16 xx;
+
+    pthread_once(&smp_aes_once, smp_aes_init);
+
+    /* r' = padding || prand, in AES (MSB first) byte order */
+    memset(prand, 0, sizeof(prand));
+    prand[13] = rpa[0];
+    prand[14] = rpa[1];
+    prand[15] = rpa[2];
+
+    for (xx = start; xx < num; xx++)
+    {
+        if (p_sched[xx] == NULL)
+            continue;
+
+        smp_aes_cb.p_block(p_sched[xx], prand, hash);
+
+        /* ah() is the 24 LSBs of the output, compared with the hash part */
+        if (hash[15] == rpa[5] && hash[14] == rpa[4] && hash[13] == rpa[3])
+            break;
+    }
+
+    return xx;
+}
+
+/*******************************************************************************
+**  AES-CMAC (RFC 4493)
+*******************************************************************************/
+static void smp_aes_cmac_dbl(const UINT8 *in, UINT8 *out)
+{
+    UINT8 msb = in[0] & 0x80;
+
+    for (int i = 0; i < BT_OCTET16_LEN - 1; i++)
+        out[i] = (in[i] << 1) | (in[i + 1] >> 7);
+    out[BT_OCTET16_LEN - 1] = in[BT_OCTET16_LEN - 1] << 1;
+
+    if (msb)
+        out[BT_OCTET16_LEN - 1] ^= 0x87;
+}
+
+/*******************************************************************************
+**
+** Function         SMP_AesCmac
+**
+** Description      AES-CMAC with tlen, without any allocation. The subkeys
+**                  are cached together with the key schedule.
+**
+** Parameters       key - CMAC key in little endian order.
+**                  input - text to be signed in little endian byte order.
+**                  length - length of the input in byte.
+**                  tlen - length of mac desired, at most 16.
+**                  p_signature - where the mac is stored, tlen long.
+**
+** Returns          TRUE
+**
+*******************************************************************************/
+BOOLEAN SMP_AesCmac(const UINT8 *key, const UINT8 *input, UINT16 length,
+                    UINT16 tlen, UINT8 *p_signature)
+{
+    static const UINT8 zero[BT_OCTET16_LEN] = {0};
+    UINT8 x[BT_OCTET16_LEN];
+    UINT16 n, off, rem;
+
+    /* M[j] of RFC 4493 is input[length - 1 - j] */
+#define SMP_CMAC_MSG(j) (input[length - 1 - (j)])
+
+    if (input == NULL)
+        length = 0;
+    n = (length + BT_OCTET16_LEN - 1) / BT_OCTET16_LEN;
+    if (n == 0)
+        n = 1;
+    if (tlen > BT_OCTET16_LEN)
+        tlen = BT_OCTET16_LEN;
+
+    pthread_mutex_lock(&smp_aes_cb.lock);
+
+    tSMP_AES_KEY *p_key = smp_aes_key_get(key);
+
+    if (!p_key->has_subkeys)
+    {
+        UINT8 l[BT_OCTET16_LEN];
+
+        smp_aes_block(&p_key->sched, zero, l);
+        smp_aes_cmac_dbl(l, p_key->k1);
+        smp_aes_cmac_dbl(p_key->k1, p_key->k2);
+        memset(l, 0, sizeof(l));
+        p_key->has_subkeys = TRUE;
+    }
+
+    memset(x, 0, sizeof(x));
+    for (off = 0; off + BT_OCTET16_LEN < n * BT_OCTET16_LEN; off += BT_OCTET16_LEN)
+    {
+        for (int i = 0; i < BT_OCTET16_LEN; i++)
+            x[i] ^= SMP_CMAC_MSG(off + i);
+        smp_aes_block(&p_key->sched, x, x);
+    }
+
+    rem = length - off;
+    if (length != 0 && rem == BT_OCTET16_LEN)
+    {
+        for (int i = 0; i < BT_OCTET16_LEN; i++)
+            x[i] ^= SMP_CMAC_MSG(off + i) ^ p_key->k1[i];
+    }
+    else
+    {
+        for (int i = 0; i < rem; i++)
+            x[i] ^= SMP_CMAC_MSG(off + i);
+        x[rem] ^= 0x80;
+        for (int i = 0; i < BT_OCTET16_LEN; i++)
+            x[i] ^= p_key->k2[i];
+    }
+    smp_aes_block(&p_key->sched, x, x);
+
+    pthread_mutex_unlock(&smp_aes_cb.lock);
+
+#undef SMP_CMAC_MSG
+
+    /* the tlen most significant bytes of the mac, little endian */
+    for (int i = 0; i < tlen; i++)
+        p_signature[i] = x[tlen - 1 - i];
+
+    memset(x, 0, sizeof(x));
+    return TRUE;
+}
+
+#endif  /* SMP_INCLUDED */
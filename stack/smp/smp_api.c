@@ -502,32 +502,6 @@ void SMP_SecureConnectionOobDataReply(UINT8 *p_data)
     smp_sm_event(&smp_cb, SMP_SC_OOB_DATA_EVT, p_data);
 }
 
-/*******************************************************************************
-**
-** Function         SMP_Encrypt
-**
-** Description      This function is called to encrypt the data with the specified
-**                  key
-**
-** Parameters:      key                 - Pointer to key key[0] conatins the MSB
-**                  key_len             - key length
-**                  plain_text          - Pointer to data to be encrypted
-**                                        plain_text[0] conatins the MSB
-**                  pt_len              - plain text length
-**                  p_out                - output of the encrypted texts
-**
-**  Returns         Boolean - request is successful
-*******************************************************************************/
-BOOLEAN SMP_Encrypt (UINT8 *key, UINT8 key_len,
-                     UINT8 *plain_text, UINT8 pt_len,
-                     tSMP_ENC *p_out)
-
-{
-    BOOLEAN status=FALSE;
-    status = smp_encrypt_data(key, key_len, plain_text, pt_len, p_out);
-    return status;
-}
-
 /*******************************************************************************
 **
 ** Function         SMP_KeypressNotification
@@ -343,6 +343,7 @@ typedef struct
     BOOLEAN         wait_for_authorization_complete;
     UINT8           cert_failure; /*failure case for certification */
     alarm_t         *delayed_auth_timer_ent;
+    UINT32          ecc_seq;    /* pending P-256 job (smp_keys.c), 0 if none */
 }tSMP_CB;
 
 /* Server Action functions are of this type */
@@ -445,6 +446,7 @@ extern void smp_generate_csrk(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_fast_conn_param(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_key_pick_key(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_both_have_public_keys(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
+extern void smp_dhkey_computed(tSMP_CB *p_cb);
 extern void smp_start_secure_connection_phase1(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_process_local_nonce(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_process_pairing_commitment(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
@@ -514,6 +516,7 @@ extern void smp_generate_rand_cont(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_create_private_key(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_use_oob_private_key(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_compute_dhkey(tSMP_CB *p_cb);
+extern void smp_ecc_free(void);
 extern void smp_calculate_local_commitment(tSMP_CB *p_cb);
 extern void smp_calculate_peer_commitment(tSMP_CB *p_cb, BT_OCTET16 output_buf);
 extern void smp_calculate_numeric_comparison_display_number(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
@@ -544,6 +547,10 @@ extern BOOLEAN aes_cipher_msg_auth_code(BT_OCTET16 key, UINT8 *input, UINT16 len
                                                  UINT16 tlen, UINT8 *p_signature);
 extern void print128(BT_OCTET16 x, const UINT8 *key_name);
 
+/* smp_aes.c */
+extern void smp_aes_encrypt_cached(const UINT8 *key, const UINT8 *plain_text, UINT8 pt_len,
+                                   tSMP_ENC *p_out);
+
 #endif
 
 #endif /* SMP_INT_H */
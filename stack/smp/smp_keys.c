@@ -34,9 +34,10 @@
 #include "btm_int.h"
 #include "btm_ble_int.h"
 #include "hcimsgs.h"
-#include "aes.h"
-#include "p_256_ecc_pp.h"
+#include "p_256_ecc_ct.h"
 #include "device/include/controller.h"
+#include "osi/include/allocator.h"
+#include "osi/include/thread.h"
 
 #ifndef SMP_MAX_ENC_REPEAT
   #define SMP_MAX_ENC_REPEAT  3
@@ -60,6 +61,27 @@ static void smp_process_new_nonce(tSMP_CB *p_cb);
 
 #define SMP_PASSKEY_MASK    0xfff00000
 
+/* P-256 work done on the smp_ecc thread, completed on the BTU thread */
+typedef struct
+{
+    UINT32      seq;
+    BOOLEAN     is_dhkey;
+    BT_OCTET32  private_key;
+    BT_OCTET32  peer_x;
+    BT_OCTET32  peer_y;
+    BT_OCTET32  x;
+    BT_OCTET32  y;
+} tSMP_ECC_JOB;
+
+extern thread_t *bt_workqueue_thread;
+
+static thread_t *smp_ecc_thread;
+static UINT32 smp_ecc_next_seq = 1;
+
+static void smp_ecc_submit(tSMP_CB *p_cb, BOOLEAN is_dhkey);
+static void smp_ecc_run(void *context);
+static void smp_ecc_done(void *context);
+
 void smp_debug_print_nbyte_little_endian(UINT8 *p, const UINT8 *key_name, UINT8 len)
 {
 #if SMP_DEBUG == TRUE
@@ -124,13 +146,6 @@ BOOLEAN smp_encrypt_data (UINT8 *key, UINT8 key_len,
                           UINT8 *plain_text, UINT8 pt_len,
                           tSMP_ENC *p_out)
 {
-    aes_context ctx;
-    UINT8 *p_start = NULL;
-    UINT8 *p = NULL;
-    UINT8 *p_rev_data = NULL;    /* input data in big endilan format */
-    UINT8 *p_rev_key = NULL;     /* input key in big endilan format */
-    UINT8 *p_rev_output = NULL;  /* encrypted output in big endilan format */
-
     SMP_TRACE_DEBUG ("%s", __func__);
     if ( (p_out == NULL ) || (key_len != SMP_ENCRYT_KEY_SIZE) )
     {
@@ -138,38 +153,19 @@ BOOLEAN smp_encrypt_data (UINT8 *key, UINT8 key_len,
         return FALSE;
     }
 
-    p_start = (UINT8 *)osi_calloc(SMP_ENCRYT_DATA_SIZE * 4);
-
     if (pt_len > SMP_ENCRYT_DATA_SIZE)
         pt_len = SMP_ENCRYT_DATA_SIZE;
 
-    p = p_start;
-    ARRAY_TO_STREAM (p, plain_text, pt_len); /* byte 0 to byte 15 */
-    p_rev_data = p = p_start + SMP_ENCRYT_DATA_SIZE; /* start at byte 16 */
-    REVERSE_ARRAY_TO_STREAM (p, p_start, SMP_ENCRYT_DATA_SIZE);  /* byte 16 to byte 31 */
-    p_rev_key = p; /* start at byte 32 */
-    REVERSE_ARRAY_TO_STREAM (p, key, SMP_ENCRYT_KEY_SIZE); /* byte 32 to byte 47 */
-
 #if SMP_DEBUG == TRUE && SMP_DEBUG_VERBOSE == TRUE
     smp_debug_print_nbyte_little_endian(key, (const UINT8 *)"Key", SMP_ENCRYT_KEY_SIZE);
-    smp_debug_print_nbyte_little_endian(p_start, (const UINT8 *)"Plain text", SMP_ENCRYT_DATA_SIZE);
+    smp_debug_print_nbyte_little_endian(plain_text, (const UINT8 *)"Plain text", pt_len);
 #endif
-    p_rev_output = p;
-    aes_set_key(p_rev_key, SMP_ENCRYT_KEY_SIZE, &ctx);
-    aes_encrypt(p_rev_data, p, &ctx);  /* outputs in byte 48 to byte 63 */
-
-    p = p_out->param_buf;
-    REVERSE_ARRAY_TO_STREAM (p, p_rev_output, SMP_ENCRYT_DATA_SIZE);
+    /* the key schedule is expanded once per key and kept in smp_aes.c */
+    smp_aes_encrypt_cached(key, plain_text, pt_len, p_out);
 #if SMP_DEBUG == TRUE && SMP_DEBUG_VERBOSE == TRUE
     smp_debug_print_nbyte_little_endian(p_out->param_buf, (const UINT8 *)"Encrypted text", SMP_ENCRYT_KEY_SIZE);
 #endif
 
-    p_out->param_len = SMP_ENCRYT_KEY_SIZE;
-    p_out->status = HCI_SUCCESS;
-    p_out->opcode =  HCI_BLE_ENCRYPT;
-
-    osi_free(p_start);
-
     return TRUE;
 }
 
@@ -1061,72 +1057,184 @@ void smp_continue_private_key_creation (tSMP_CB *p_cb, tBTM_RAND_ENC *p)
 ** Function         smp_process_private_key
 **
 ** Description      This function processes private key.
-**                  It calculates public key and notifies SM that private key /
-**                  public key pair is created.
+**                  It starts the public key calculation; SM is notified that
+**                  the private key / public key pair is created from
+**                  smp_ecc_done().
 **
 ** Returns          void
 **
 *******************************************************************************/
 void smp_process_private_key(tSMP_CB *p_cb)
 {
-    Point       public_key;
-    BT_OCTET32  private_key;
-
     SMP_TRACE_DEBUG ("%s", __FUNCTION__);
 
-    memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-    ECC_PointMult(&public_key, &(curve_p256.G), (DWORD*) private_key, KEY_LENGTH_DWORDS_P256);
-    memcpy(p_cb->loc_publ_key.x, public_key.x, BT_OCTET32_LEN);
-    memcpy(p_cb->loc_publ_key.y, public_key.y, BT_OCTET32_LEN);
-
-    smp_debug_print_nbyte_little_endian (p_cb->private_key, (const UINT8 *)"private",
-                                         BT_OCTET32_LEN);
-    smp_debug_print_nbyte_little_endian (p_cb->loc_publ_key.x, (const UINT8 *)"local public(x)",
-                                         BT_OCTET32_LEN);
-    smp_debug_print_nbyte_little_endian (p_cb->loc_publ_key.y, (const UINT8 *)"local public(y)",
-                                         BT_OCTET32_LEN);
-    p_cb->flags |= SMP_PAIR_FLAG_HAVE_LOCAL_PUBL_KEY;
-    smp_sm_event(p_cb, SMP_LOC_PUBL_KEY_CRTD_EVT, NULL);
+    smp_ecc_submit(p_cb, FALSE);
 }
 
 /*******************************************************************************
 **
 ** Function         smp_compute_dhkey
 **
-** Description      The function:
-**                  - calculates a new public key using as input local private
-**                    key and peer public key;
-**                  - saves the new public key x-coordinate as DHKey.
+** Description      The function starts the calculation of a new public key
+**                  using as input local private key and peer public key.
+**                  Its x-coordinate is saved as DHKey and smp_dhkey_computed()
+**                  is called once it is available.
 **
 ** Returns          void
 **
 *******************************************************************************/
 void smp_compute_dhkey (tSMP_CB *p_cb)
 {
-    Point       peer_publ_key, new_publ_key;
-    BT_OCTET32  private_key;
-
     SMP_TRACE_DEBUG ("%s", __FUNCTION__);
 
-    memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-    memcpy(peer_publ_key.x, p_cb->peer_publ_key.x, BT_OCTET32_LEN);
-    memcpy(peer_publ_key.y, p_cb->peer_publ_key.y, BT_OCTET32_LEN);
+    smp_ecc_submit(p_cb, TRUE);
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_submit
+**
+** Description      Hands a P-256 point multiplication over to the smp_ecc
+**                  thread so the BTU thread keeps running while it is done.
+**                  p_cb->ecc_seq identifies the job; a job whose sequence
+**                  number no longer matches (pairing cancelled, control
+**                  block cleaned up) is dropped on completion.
+**
+**                  If the worker thread cannot be created the job is run
+**                  and completed in place.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_ecc_submit(tSMP_CB *p_cb, BOOLEAN is_dhkey)
+{
+    tSMP_ECC_JOB *p_job = (tSMP_ECC_JOB *)osi_calloc(sizeof(tSMP_ECC_JOB));
+
+    if (smp_ecc_next_seq == 0)
+        smp_ecc_next_seq = 1;
+    p_job->seq = p_cb->ecc_seq = smp_ecc_next_seq++;
+    p_job->is_dhkey = is_dhkey;
+    memcpy(p_job->private_key, p_cb->private_key, BT_OCTET32_LEN);
+    if (is_dhkey)
+    {
+        memcpy(p_job->peer_x, p_cb->peer_publ_key.x, BT_OCTET32_LEN);
+        memcpy(p_job->peer_y, p_cb->peer_publ_key.y, BT_OCTET32_LEN);
+    }
+
+    if (smp_ecc_thread == NULL)
+        smp_ecc_thread = thread_new("smp_ecc");
+
+    if (smp_ecc_thread == NULL || !thread_post(smp_ecc_thread, smp_ecc_run, p_job))
+    {
+        SMP_TRACE_WARNING("%s no worker thread, computing in place", __func__);
+        if (is_dhkey)
+            ECC_PointMult_Ct(p_job->x, p_job->y, p_job->peer_x, p_job->peer_y,
+                             p_job->private_key);
+        else
+            ECC_BaseMult_Ct(p_job->x, p_job->y, p_job->private_key);
+        smp_ecc_done(p_job);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_free
+**
+** Description      Stops the smp_ecc thread on shutdown. A job still running
+**                  finishes first; its result no longer matches and is dropped.
+**
+** Returns          void
+**
+*******************************************************************************/
+void smp_ecc_free(void)
+{
+    smp_cb.ecc_seq = 0;
+
+    thread_free(smp_ecc_thread);
+    smp_ecc_thread = NULL;
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_run
+**
+** Description      Runs on the smp_ecc thread: does the point multiplication
+**                  and posts the result back to the BTU thread.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_ecc_run(void *context)
+{
+    tSMP_ECC_JOB *p_job = (tSMP_ECC_JOB *)context;
+
+    if (p_job->is_dhkey)
+        ECC_PointMult_Ct(p_job->x, p_job->y, p_job->peer_x, p_job->peer_y,
+                         p_job->private_key);
+    else
+        ECC_BaseMult_Ct(p_job->x, p_job->y, p_job->private_key);
+
+    if (bt_workqueue_thread == NULL || !thread_post(bt_workqueue_thread, smp_ecc_done, p_job))
+    {
+        memset(p_job, 0, sizeof(tSMP_ECC_JOB));
+        osi_free(p_job);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_done
+**
+** Description      Runs on the BTU thread: stores the result of a P-256 job
+**                  and resumes the SM if the job is still current.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_ecc_done(void *context)
+{
+    tSMP_ECC_JOB *p_job = (tSMP_ECC_JOB *)context;
+    tSMP_CB      *p_cb = &smp_cb;
+
+    if (p_job->seq != p_cb->ecc_seq)
+    {
+        SMP_TRACE_DEBUG("%s stale job %u (current %u) dropped", __func__,
+                        p_job->seq, p_cb->ecc_seq);
+    }
+    else if (p_job->is_dhkey)
+    {
+        p_cb->ecc_seq = 0;
+        memcpy(p_cb->dhkey, p_job->x, BT_OCTET32_LEN);
 
-    ECC_PointMult(&new_publ_key, &peer_publ_key, (DWORD*) private_key, KEY_LENGTH_DWORDS_P256);
+        smp_debug_print_nbyte_little_endian (p_cb->private_key, (const UINT8 *)"private",
+                                             BT_OCTET32_LEN);
+        smp_debug_print_nbyte_little_endian (p_cb->peer_publ_key.x, (const UINT8 *)"rem public(x)",
+                                             BT_OCTET32_LEN);
+        smp_debug_print_nbyte_little_endian (p_cb->peer_publ_key.y, (const UINT8 *)"rem public(y)",
+                                             BT_OCTET32_LEN);
+        smp_debug_print_nbyte_little_endian (p_cb->dhkey, (const UINT8 *)"DHKey",
+                                             BT_OCTET32_LEN);
 
-    memcpy(p_cb->dhkey, new_publ_key.x, BT_OCTET32_LEN);
+        smp_dhkey_computed(p_cb);
+    }
+    else
+    {
+        p_cb->ecc_seq = 0;
+        memcpy(p_cb->loc_publ_key.x, p_job->x, BT_OCTET32_LEN);
+        memcpy(p_cb->loc_publ_key.y, p_job->y, BT_OCTET32_LEN);
 
-    smp_debug_print_nbyte_little_endian (p_cb->dhkey, (const UINT8 *)"Old DHKey",
-                                         BT_OCTET32_LEN);
+        smp_debug_print_nbyte_little_endian (p_cb->private_key, (const UINT8 *)"private",
+                                             BT_OCTET32_LEN);
+        smp_debug_print_nbyte_little_endian (p_cb->loc_publ_key.x, (const UINT8 *)"local public(x)",
+                                             BT_OCTET32_LEN);
+        smp_debug_print_nbyte_little_endian (p_cb->loc_publ_key.y, (const UINT8 *)"local public(y)",
+                                             BT_OCTET32_LEN);
+        p_cb->flags |= SMP_PAIR_FLAG_HAVE_LOCAL_PUBL_KEY;
+        smp_sm_event(p_cb, SMP_LOC_PUBL_KEY_CRTD_EVT, NULL);
+    }
 
-    smp_debug_print_nbyte_little_endian (p_cb->private_key, (const UINT8 *)"private",
-                                         BT_OCTET32_LEN);
-    smp_debug_print_nbyte_little_endian (p_cb->peer_publ_key.x, (const UINT8 *)"rem public(x)",
-                                         BT_OCTET32_LEN);
-    smp_debug_print_nbyte_little_endian (p_cb->peer_publ_key.y, (const UINT8 *)"rem public(y)",
-                                         BT_OCTET32_LEN);
-    smp_debug_print_nbyte_little_endian (p_cb->dhkey, (const UINT8 *)"Reverted DHKey",
-                                         BT_OCTET32_LEN);
+    memset(p_job, 0, sizeof(tSMP_ECC_JOB));
+    osi_free(p_job);
 }
 
 /*******************************************************************************
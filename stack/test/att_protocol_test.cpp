@@ -0,0 +1,132 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "AllocationTestHarness.h"
+#include "stack_test_stubs.h"
+
+extern "C" {
+#include "gatt_int.h"
+#include "l2c_api.h"
+#include "osi/include/allocator.h"
+}
+
+static const UINT16 NOTIF_HANDLE = 0x0021;
+
+class AttProtocolTest : public AllocationTestHarness {
+  protected:
+    virtual void SetUp() {
+      AllocationTestHarness::SetUp();
+      stack_test_stubs_reset();
+
+      memset(tcbs_, 0, sizeof(tcbs_));
+      for (size_t i = 0; i < 3; ++i) {
+        tcbs_[i].att_lcid = L2CAP_ATT_CID;
+        tcbs_[i].payload_size = GATT_DEF_BLE_MTU_SIZE;
+      }
+
+      for (size_t i = 0; i < sizeof(value_); ++i)
+        value_[i] = i;
+    }
+
+    virtual void TearDown() {
+      stack_test_stubs_reset();
+      AllocationTestHarness::TearDown();
+    }
+
+    BT_HDR *build_notification(UINT16 len) {
+      return attp_build_value_cmd(GATT_MAX_MTU_SIZE, GATT_HANDLE_VALUE_NOTIF,
+                                  NOTIF_HANDLE, 0, len, value_);
+    }
+
+    tGATT_TCB tcbs_[3];
+    UINT8 value_[100];
+};
+
+TEST_F(AttProtocolTest, test_send_multi_copies_pdu) {
+  tGATT_TCB *links[] = { &tcbs_[0], &tcbs_[1], &tcbs_[2] };
+  tGATT_STATUS status[3];
+  BT_HDR *p_pdu = build_notification(10);
+
+  EXPECT_EQ(GATT_SUCCESS, attp_send_sr_msg_multi(3, links, p_pdu, status));
+
+  ASSERT_EQ(3u, l2cap_sent.size());
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(GATT_SUCCESS, status[i]);
+    EXPECT_EQ(L2CAP_ATT_CID, l2cap_sent[i].cid);
+    ASSERT_EQ(GATT_HDR_SIZE + 10u, l2cap_sent[i].data.size());
+    EXPECT_EQ(GATT_HANDLE_VALUE_NOTIF, l2cap_sent[i].data[0]);
+    EXPECT_EQ(NOTIF_HANDLE & 0xff, l2cap_sent[i].data[1]);
+    EXPECT_EQ(0, memcmp(value_, &l2cap_sent[i].data[GATT_HDR_SIZE], 10));
+  }
+
+  osi_free(p_pdu);
+}
+
+TEST_F(AttProtocolTest, test_send_multi_cuts_to_link_mtu) {
+  tcbs_[1].payload_size = 64;
+  tGATT_TCB *links[] = { &tcbs_[0], &tcbs_[1] };
+  tGATT_STATUS status[2];
+  BT_HDR *p_pdu = build_notification(50);
+
+  EXPECT_EQ(GATT_SUCCESS, attp_send_sr_msg_multi(2, links, p_pdu, status));
+
+  ASSERT_EQ(2u, l2cap_sent.size());
+  EXPECT_EQ(GATT_DEF_BLE_MTU_SIZE, l2cap_sent[0].data.size());
+  EXPECT_EQ(GATT_HDR_SIZE + 50u, l2cap_sent[1].data.size());
+  EXPECT_EQ(0, memcmp(value_, &l2cap_sent[0].data[GATT_HDR_SIZE],
+                      GATT_DEF_BLE_MTU_SIZE - GATT_HDR_SIZE));
+
+  osi_free(p_pdu);
+}
+
+TEST_F(AttProtocolTest, test_send_multi_congested_and_failed_links) {
+  tGATT_TCB *links[] = { &tcbs_[0], &tcbs_[1], NULL, &tcbs_[2] };
+  tGATT_STATUS status[4];
+  BT_HDR *p_pdu = build_notification(4);
+
+  l2cap_write_results.push_back(L2CAP_DW_CONGESTED);
+  l2cap_write_results.push_back(L2CAP_DW_FAILED);
+  l2cap_write_results.push_back(L2CAP_DW_SUCCESS);
+
+  EXPECT_EQ(GATT_SUCCESS, attp_send_sr_msg_multi(4, links, p_pdu, status));
+
+  // The congested and failed links do not stop the batch.
+  EXPECT_EQ(3u, l2cap_sent.size());
+  EXPECT_EQ(GATT_CONGESTED, status[0]);
+  EXPECT_EQ(GATT_INTERNAL_ERROR, status[1]);
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, status[2]);
+  EXPECT_EQ(GATT_SUCCESS, status[3]);
+
+  osi_free(p_pdu);
+}
+
+TEST_F(AttProtocolTest, test_send_multi_all_links_failed) {
+  tGATT_TCB *links[] = { &tcbs_[0], NULL };
+  tGATT_STATUS status[2];
+  BT_HDR *p_pdu = build_notification(4);
+
+  l2cap_write_results.push_back(L2CAP_DW_FAILED);
+
+  EXPECT_EQ(GATT_INTERNAL_ERROR, attp_send_sr_msg_multi(2, links, p_pdu, status));
+  EXPECT_EQ(GATT_INTERNAL_ERROR, status[0]);
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, status[1]);
+
+  osi_free(p_pdu);
+}
@@ -0,0 +1,206 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "AllocationTestHarness.h"
+#include "stack_test_stubs.h"
+
+extern "C" {
+#include "btm_api.h"
+#include "btm_int.h"
+#include "hcidefs.h"
+}
+
+static const UINT16 VSC_OCF = 0x0157;
+static const UINT16 VSC_OPCODE = VSC_OCF | HCI_GRP_VENDOR_SPECIFIC;
+static const UINT16 STD_OPCODE = HCI_BLE_WRITE_EXTENDED_ADV_ENABLE;
+
+// One call of the completion callback.
+struct txn_completion {
+  UINT8 evt;
+  UINT32 ref;
+  UINT8 status;
+};
+
+static std::vector<txn_completion> completions;
+
+static void record_completion(tBTM_VSC_CMPL *p_params, UINT8 evt, UINT32 ref,
+                              void * /* p_ref */) {
+  txn_completion completion;
+  completion.evt = evt;
+  completion.ref = ref;
+  completion.status = p_params->param_len > 0 ? p_params->p_param_buf[0] : 0xFF;
+  completions.push_back(completion);
+}
+
+class BtmHciTxnTest : public AllocationTestHarness {
+  protected:
+    virtual void SetUp() {
+      AllocationTestHarness::SetUp();
+      stack_test_stubs_reset();
+      completions.clear();
+      btm_hci_txn_init();
+    }
+
+    virtual void TearDown() {
+      btm_hci_txn_init();
+      AllocationTestHarness::TearDown();
+    }
+
+    tBTM_STATUS issue_vsc(UINT8 sub_opcode, UINT32 ref) {
+      UINT8 param[] = { sub_opcode, 0x01 };
+      return btm_hci_txn_vsc(BTM_HCI_TXN_APCF, VSC_OCF, sizeof(param), param,
+                             record_completion, 0, ref, NULL);
+    }
+
+    // Completes the |index|th vendor specific command handed to HCI.
+    void complete_vsc(size_t index, UINT8 status) {
+      ASSERT_LT(index, vsc_sent.size());
+      UINT8 buf[] = { status, vsc_sent[index].params[0] };
+      tBTM_VSC_CMPL params;
+      params.opcode = vsc_sent[index].opcode;
+      params.param_len = sizeof(buf);
+      params.p_param_buf = buf;
+      vsc_sent[index].p_cb(&params);
+    }
+
+    BOOLEAN complete_std(UINT16 opcode, UINT8 status) {
+      UINT8 buf[] = { status };
+      return btm_hci_txn_cmd_complete(buf, opcode, sizeof(buf));
+    }
+
+    tBTM_HCI_TXN_STATS stats(UINT8 client) {
+      tBTM_HCI_TXN_STATS stats;
+      BTM_HciTxnGetStats(client, &stats);
+      return stats;
+    }
+};
+
+TEST_F(BtmHciTxnTest, test_window_holds_and_releases_commands) {
+  for (UINT32 i = 0; i < BTM_HCI_TXN_WINDOW + 2; ++i)
+    EXPECT_EQ(BTM_CMD_STARTED, issue_vsc(0x01, i));
+
+  ASSERT_EQ((size_t)BTM_HCI_TXN_WINDOW, vsc_sent.size());
+  EXPECT_EQ(2U, stats(BTM_HCI_TXN_APCF).held);
+  EXPECT_EQ(BTM_HCI_TXN_WINDOW, stats(BTM_HCI_TXN_APCF).in_flight_high_water);
+
+  // Each completion lets one held command through, in issue order.
+  complete_vsc(0, HCI_SUCCESS);
+  ASSERT_EQ((size_t)BTM_HCI_TXN_WINDOW + 1, vsc_sent.size());
+  complete_vsc(1, HCI_SUCCESS);
+  ASSERT_EQ((size_t)BTM_HCI_TXN_WINDOW + 2, vsc_sent.size());
+  EXPECT_EQ(VSC_OPCODE, vsc_sent.back().opcode);
+
+  for (size_t i = 2; i < vsc_sent.size(); ++i)
+    complete_vsc(i, HCI_SUCCESS);
+
+  ASSERT_EQ((size_t)BTM_HCI_TXN_WINDOW + 2, completions.size());
+  for (UINT32 i = 0; i < completions.size(); ++i)
+    EXPECT_EQ(i, completions[i].ref);
+  EXPECT_EQ((UINT32)BTM_HCI_TXN_WINDOW + 2, stats(BTM_HCI_TXN_APCF).cmds);
+}
+
+TEST_F(BtmHciTxnTest, test_completion_matched_by_sub_opcode) {
+  EXPECT_EQ(BTM_CMD_STARTED, issue_vsc(0x01, 10));
+  EXPECT_EQ(BTM_CMD_STARTED, issue_vsc(0x02, 20));
+
+  // The controller answers the second command first.
+  complete_vsc(1, HCI_ERR_ILLEGAL_PARAMETER_FMT);
+  complete_vsc(0, HCI_SUCCESS);
+
+  ASSERT_EQ(2U, completions.size());
+  EXPECT_EQ(20U, completions[0].ref);
+  EXPECT_EQ(HCI_ERR_ILLEGAL_PARAMETER_FMT, completions[0].status);
+  EXPECT_EQ(10U, completions[1].ref);
+  EXPECT_EQ(HCI_SUCCESS, completions[1].status);
+  EXPECT_EQ(1U, stats(BTM_HCI_TXN_APCF).failed);
+}
+
+TEST_F(BtmHciTxnTest, test_tracked_commands_matched_oldest_first) {
+  EXPECT_EQ(BTM_CMD_STARTED,
+            btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, STD_OPCODE,
+                              record_completion, 1, 100, NULL));
+  EXPECT_EQ(BTM_CMD_STARTED,
+            btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, STD_OPCODE,
+                              record_completion, 2, 200, NULL));
+
+  EXPECT_FALSE(complete_std(HCI_BLE_WRITE_EXTENDED_ADV_PARAMS, HCI_SUCCESS));
+  EXPECT_TRUE(complete_std(STD_OPCODE, HCI_SUCCESS));
+  EXPECT_TRUE(complete_std(STD_OPCODE, HCI_SUCCESS));
+  EXPECT_FALSE(complete_std(STD_OPCODE, HCI_SUCCESS));
+
+  ASSERT_EQ(2U, completions.size());
+  EXPECT_EQ(100U, completions[0].ref);
+  EXPECT_EQ(200U, completions[1].ref);
+
+  // Tracked commands are sent by the caller, never through the window.
+  EXPECT_TRUE(vsc_sent.empty());
+}
+
+TEST_F(BtmHciTxnTest, test_cancel_drops_tracked_command) {
+  EXPECT_EQ(BTM_CMD_STARTED,
+            btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, STD_OPCODE,
+                              record_completion, 1, 100, NULL));
+  btm_hci_txn_cancel(BTM_HCI_TXN_MULTI_ADV, STD_OPCODE);
+
+  EXPECT_FALSE(complete_std(STD_OPCODE, HCI_SUCCESS));
+  EXPECT_TRUE(completions.empty());
+  EXPECT_EQ(0U, stats(BTM_HCI_TXN_MULTI_ADV).txns);
+}
+
+TEST_F(BtmHciTxnTest, test_tracking_refused_when_full) {
+  for (UINT32 i = 0; i < BTM_HCI_TXN_MAX_CMDS; ++i) {
+    EXPECT_EQ(BTM_CMD_STARTED,
+              btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, STD_OPCODE,
+                                record_completion, 0, i, NULL));
+  }
+  EXPECT_EQ(BTM_NO_RESOURCES,
+            btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, STD_OPCODE,
+                              record_completion, 0, 0, NULL));
+  EXPECT_EQ(1U, stats(BTM_HCI_TXN_MULTI_ADV).dropped);
+
+  // A completion frees room for the next command.
+  EXPECT_TRUE(complete_std(STD_OPCODE, HCI_SUCCESS));
+  EXPECT_EQ(BTM_CMD_STARTED,
+            btm_hci_txn_track(BTM_HCI_TXN_MULTI_ADV, STD_OPCODE,
+                              record_completion, 0, 0, NULL));
+}
+
+TEST_F(BtmHciTxnTest, test_transaction_recorded_after_last_completion) {
+  btm_hci_txn_begin(BTM_HCI_TXN_APCF);
+  EXPECT_EQ(BTM_CMD_STARTED, issue_vsc(0x01, 1));
+  EXPECT_EQ(BTM_CMD_STARTED, issue_vsc(0x02, 2));
+  btm_hci_txn_end(BTM_HCI_TXN_APCF);
+
+  complete_vsc(0, HCI_SUCCESS);
+  EXPECT_EQ(0U, stats(BTM_HCI_TXN_APCF).txns);
+  complete_vsc(1, HCI_SUCCESS);
+  EXPECT_EQ(1U, stats(BTM_HCI_TXN_APCF).txns);
+}
+
+TEST_F(BtmHciTxnTest, test_flush_ignores_late_completions) {
+  EXPECT_EQ(BTM_CMD_STARTED, issue_vsc(0x01, 1));
+  btm_hci_txn_flush(BTM_HCI_TXN_APCF);
+
+  complete_vsc(0, HCI_SUCCESS);
+  EXPECT_TRUE(completions.empty());
+  EXPECT_EQ(1U, stats(BTM_HCI_TXN_APCF).dropped);
+}
@@ -0,0 +1,282 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "AlarmTestHarness.h"
+#include "stack_test_stubs.h"
+
+extern "C" {
+#include "gatt_int.h"
+#include "l2c_api.h"
+#include "osi/include/alarm.h"
+#include "osi/include/allocator.h"
+}
+
+static const UINT16 HANDLE_A = 0x0010;
+static const UINT16 HANDLE_B = 0x0020;
+
+static const UINT8 VALUE_A[] = { 0x01, 0x02, 0x03, 0x04 };
+static const UINT8 VALUE_B[] = { 0x05, 0x06 };
+
+class GattClTest : public AlarmTestHarness {
+  protected:
+    virtual void SetUp() {
+      AlarmTestHarness::SetUp();
+      stack_test_stubs_reset();
+
+      memset(&gatt_cb, 0, sizeof(gatt_cb));
+      tcb_ = &gatt_cb.tcb[0];
+      tcb_->in_use = TRUE;
+      tcb_->att_lcid = L2CAP_ATT_CID;
+      tcb_->payload_size = GATT_DEF_BLE_MTU_SIZE;
+
+      for (UINT16 i = 0; i < GATT_CL_MAX_LCB; ++i) {
+        gatt_cb.clcb[i].clcb_idx = i;
+        gatt_cb.clcb[i].gatt_rsp_timer_ent = alarm_new("gatt.gatt_rsp_timer");
+      }
+      next_clcb_ = 0;
+    }
+
+    virtual void TearDown() {
+      for (UINT16 i = 0; i < GATT_CL_MAX_LCB; ++i) {
+        alarm_free(gatt_cb.clcb[i].gatt_rsp_timer_ent);
+        osi_free(gatt_cb.clcb[i].p_attr_buf);
+        osi_free(tcb_->cl_cmd_q[i].p_cmd);
+      }
+
+      stack_test_stubs_reset();
+      AlarmTestHarness::TearDown();
+    }
+
+    // Queues a read by handle the way gatt_act_read does and returns its clcb.
+    UINT16 queue_read(UINT16 handle) {
+      UINT16 clcb_idx = next_clcb_;
+      next_clcb_ = (next_clcb_ + 1) % GATT_CL_MAX_LCB;
+
+      tGATT_CLCB *p_clcb = &gatt_cb.clcb[clcb_idx];
+      osi_free_and_reset((void **)&p_clcb->p_attr_buf);
+      p_clcb->in_use = TRUE;
+      p_clcb->p_tcb = tcb_;
+      p_clcb->operation = GATTC_OPTYPE_READ;
+      p_clcb->op_subtype = GATT_READ_BY_HANDLE;
+      p_clcb->s_handle = handle;
+      p_clcb->counter = 0;
+
+      tGATT_CMD_Q *p_cmd = &tcb_->cl_cmd_q[tcb_->next_slot_inq];
+      memset(p_cmd, 0, sizeof(*p_cmd));
+      p_cmd->p_cmd = attp_build_handle_cmd(GATT_REQ_READ, handle, 0);
+      p_cmd->clcb_idx = clcb_idx;
+      p_cmd->op_code = GATT_REQ_READ;
+      p_cmd->to_send = TRUE;
+      tcb_->next_slot_inq = (tcb_->next_slot_inq + 1) % GATT_CL_MAX_LCB;
+
+      return clcb_idx;
+    }
+
+    void respond(UINT8 op_code, const UINT8 *data, UINT16 len) {
+      UINT8 buf[GATT_DEF_BLE_MTU_SIZE];
+      memcpy(buf, data, len);
+      gatt_client_handle_server_rsp(tcb_, op_code, len, buf);
+    }
+
+    void respond_error(UINT8 reason) {
+      UINT8 rsp[] = { GATT_REQ_READ_MULTI, HANDLE_A & 0xff, HANDLE_A >> 8, reason };
+      respond(GATT_RSP_ERROR, rsp, sizeof(rsp));
+    }
+
+    // Reads |handle| with a single read |times| times, each returning |len|
+    // bytes of |value|.
+    void read_single(UINT16 handle, const UINT8 *value, UINT16 len, int times) {
+      for (int i = 0; i < times; ++i) {
+        queue_read(handle);
+        ASSERT_TRUE(gatt_cl_send_next_cmd_inq(tcb_));
+        ASSERT_EQ(GATT_REQ_READ, l2cap_sent.back().data[0]);
+        respond(GATT_RSP_READ, value, len);
+      }
+      stack_test_stubs_reset();
+    }
+
+    // Queues reads of A and B and sends them.
+    void send_reads_a_b(UINT16 *p_clcb_a, UINT16 *p_clcb_b) {
+      *p_clcb_a = queue_read(HANDLE_A);
+      *p_clcb_b = queue_read(HANDLE_B);
+      ASSERT_TRUE(gatt_cl_send_next_cmd_inq(tcb_));
+    }
+
+    // Expects the merged reads of A and B to go out again one by one after
+    // the Read Multiple response, and answers them.
+    void expect_resent_singly(UINT16 clcb_a, UINT16 clcb_b) {
+      EXPECT_TRUE(gatt_ended.empty());
+      EXPECT_EQ(1u, gatt_cb.cl_read_stats.read_multi_fallback);
+      ASSERT_EQ(2u, l2cap_sent.size());
+      EXPECT_EQ(GATT_REQ_READ, l2cap_sent[1].data[0]);
+      EXPECT_EQ(HANDLE_A, l2cap_sent[1].data[1] | (l2cap_sent[1].data[2] << 8));
+
+      respond(GATT_RSP_READ, VALUE_A, sizeof(VALUE_A));
+      ASSERT_EQ(3u, l2cap_sent.size());
+      EXPECT_EQ(GATT_REQ_READ, l2cap_sent[2].data[0]);
+      EXPECT_EQ(HANDLE_B, l2cap_sent[2].data[1] | (l2cap_sent[2].data[2] << 8));
+
+      respond(GATT_RSP_READ, VALUE_B, sizeof(VALUE_B));
+      ASSERT_EQ(2u, gatt_ended.size());
+      EXPECT_EQ(clcb_a, gatt_ended[0].clcb_idx);
+      EXPECT_EQ(GATT_SUCCESS, gatt_ended[0].status);
+      EXPECT_EQ(clcb_b, gatt_ended[1].clcb_idx);
+      EXPECT_EQ(GATT_SUCCESS, gatt_ended[1].status);
+      EXPECT_EQ(tcb_->pending_cl_req, tcb_->next_slot_inq);
+    }
+
+    tGATT_TCB *tcb_;
+    UINT16 next_clcb_;
+};
+
+TEST_F(GattClTest, test_one_read_is_not_enough_to_merge) {
+  UINT16 clcb_a, clcb_b;
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A), 1);
+  read_single(HANDLE_B, VALUE_B, sizeof(VALUE_B), 1);
+
+  send_reads_a_b(&clcb_a, &clcb_b);
+
+  ASSERT_EQ(1u, l2cap_sent.size());
+  EXPECT_EQ(GATT_REQ_READ, l2cap_sent[0].data[0]);
+  EXPECT_EQ(0u, gatt_cb.cl_read_stats.read_multi_sent);
+}
+
+TEST_F(GattClTest, test_varying_length_is_not_merged) {
+  UINT16 clcb_a, clcb_b;
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A), 1);
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A) - 1, 1);
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A), 2);
+  read_single(HANDLE_B, VALUE_B, sizeof(VALUE_B), 2);
+
+  send_reads_a_b(&clcb_a, &clcb_b);
+
+  ASSERT_EQ(1u, l2cap_sent.size());
+  EXPECT_EQ(GATT_REQ_READ, l2cap_sent[0].data[0]);
+}
+
+TEST_F(GattClTest, test_fixed_length_reads_merged_and_split) {
+  UINT16 clcb_a, clcb_b;
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A), 2);
+  read_single(HANDLE_B, VALUE_B, sizeof(VALUE_B), 2);
+
+  send_reads_a_b(&clcb_a, &clcb_b);
+
+  ASSERT_EQ(1u, l2cap_sent.size());
+  const std::vector<uint8_t> &req = l2cap_sent[0].data;
+  ASSERT_EQ(5u, req.size());
+  EXPECT_EQ(GATT_REQ_READ_MULTI, req[0]);
+  EXPECT_EQ(HANDLE_A, req[1] | (req[2] << 8));
+  EXPECT_EQ(HANDLE_B, req[3] | (req[4] << 8));
+  EXPECT_EQ(1u, gatt_cb.cl_read_stats.read_multi_sent);
+
+  // Both reads wait for the response with their own timer.
+  ASSERT_EQ(2u, gatt_rsp_timers.size());
+  EXPECT_EQ(clcb_a, gatt_rsp_timers[0]);
+  EXPECT_EQ(clcb_b, gatt_rsp_timers[1]);
+
+  UINT8 rsp[sizeof(VALUE_A) + sizeof(VALUE_B)];
+  memcpy(rsp, VALUE_A, sizeof(VALUE_A));
+  memcpy(rsp + sizeof(VALUE_A), VALUE_B, sizeof(VALUE_B));
+  respond(GATT_RSP_READ_MULTI, rsp, sizeof(rsp));
+
+  ASSERT_EQ(2u, gatt_ended.size());
+  EXPECT_EQ(clcb_a, gatt_ended[0].clcb_idx);
+  EXPECT_EQ(GATT_SUCCESS, gatt_ended[0].status);
+  EXPECT_EQ(clcb_b, gatt_ended[1].clcb_idx);
+  EXPECT_EQ(GATT_SUCCESS, gatt_ended[1].status);
+
+  tGATT_CLCB *p_clcb_a = &gatt_cb.clcb[clcb_a];
+  tGATT_CLCB *p_clcb_b = &gatt_cb.clcb[clcb_b];
+  ASSERT_EQ(sizeof(VALUE_A), p_clcb_a->counter);
+  EXPECT_EQ(0, memcmp(VALUE_A, p_clcb_a->p_attr_buf, sizeof(VALUE_A)));
+  ASSERT_EQ(sizeof(VALUE_B), p_clcb_b->counter);
+  EXPECT_EQ(0, memcmp(VALUE_B, p_clcb_b->p_attr_buf, sizeof(VALUE_B)));
+
+  EXPECT_EQ(tcb_->pending_cl_req, tcb_->next_slot_inq);
+  EXPECT_EQ(1u, gatt_cb.cl_read_stats.rtt_saved);
+}
+
+TEST_F(GattClTest, test_merged_length_mismatch_resends_singly) {
+  UINT16 clcb_a, clcb_b;
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A), 2);
+  read_single(HANDLE_B, VALUE_B, sizeof(VALUE_B), 2);
+
+  send_reads_a_b(&clcb_a, &clcb_b);
+  ASSERT_EQ(GATT_REQ_READ_MULTI, l2cap_sent[0].data[0]);
+
+  UINT8 rsp[sizeof(VALUE_A) + 1] = { 0 };
+  respond(GATT_RSP_READ_MULTI, rsp, sizeof(rsp));
+
+  expect_resent_singly(clcb_a, clcb_b);
+  EXPECT_FALSE(tcb_->no_read_multi);
+
+  // The lengths are no longer trusted, later reads go out one by one.
+  stack_test_stubs_reset();
+  send_reads_a_b(&clcb_a, &clcb_b);
+  ASSERT_EQ(1u, l2cap_sent.size());
+  EXPECT_EQ(GATT_REQ_READ, l2cap_sent[0].data[0]);
+}
+
+TEST_F(GattClTest, test_merged_error_resends_singly) {
+  UINT16 clcb_a, clcb_b;
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A), 2);
+  read_single(HANDLE_B, VALUE_B, sizeof(VALUE_B), 2);
+
+  send_reads_a_b(&clcb_a, &clcb_b);
+  ASSERT_EQ(GATT_REQ_READ_MULTI, l2cap_sent[0].data[0]);
+
+  respond_error(GATT_INSUF_AUTHENTICATION);
+
+  expect_resent_singly(clcb_a, clcb_b);
+  EXPECT_FALSE(tcb_->no_read_multi);
+
+  // Read Multiple is still used for this peer.
+  stack_test_stubs_reset();
+  send_reads_a_b(&clcb_a, &clcb_b);
+  ASSERT_EQ(1u, l2cap_sent.size());
+  EXPECT_EQ(GATT_REQ_READ_MULTI, l2cap_sent[0].data[0]);
+}
+
+TEST_F(GattClTest, test_merged_unexpected_opcode_resends_singly) {
+  UINT16 clcb_a, clcb_b;
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A), 2);
+  read_single(HANDLE_B, VALUE_B, sizeof(VALUE_B), 2);
+
+  send_reads_a_b(&clcb_a, &clcb_b);
+  ASSERT_EQ(GATT_REQ_READ_MULTI, l2cap_sent[0].data[0]);
+
+  respond(GATT_RSP_WRITE, VALUE_A, 0);
+
+  expect_resent_singly(clcb_a, clcb_b);
+}
+
+TEST_F(GattClTest, test_merged_not_supported_resends_singly) {
+  UINT16 clcb_a, clcb_b;
+  read_single(HANDLE_A, VALUE_A, sizeof(VALUE_A), 2);
+  read_single(HANDLE_B, VALUE_B, sizeof(VALUE_B), 2);
+
+  send_reads_a_b(&clcb_a, &clcb_b);
+  ASSERT_EQ(GATT_REQ_READ_MULTI, l2cap_sent[0].data[0]);
+
+  respond_error(GATT_REQ_NOT_SUPPORTED);
+
+  EXPECT_TRUE(tcb_->no_read_multi);
+  expect_resent_singly(clcb_a, clcb_b);
+}
@@ -0,0 +1,174 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+#include "AlarmTestHarness.h"
+
+extern "C" {
+#include "avrc_defs.h"
+#include "bt_utils.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+}
+
+// Record layout of AVRC_PEER_VERSION_CONF_FILE.
+struct peer_ver_record {
+  int ver;
+  char addr[3];
+};
+
+static BD_ADDR PEER_A = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static BD_ADDR PEER_B = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+static BD_ADDR PEER_A_OTHER_NAP = { 0x00, 0x11, 0x22, 0xfe, 0xdc, 0xba };
+
+class SdpPeerVerTest : public AlarmTestHarness {
+  protected:
+    virtual void SetUp() {
+      AlarmTestHarness::SetUp();
+      unlink(AVRC_PEER_VERSION_CONF_FILE);
+    }
+
+    virtual void TearDown() {
+      sdp_peer_ver_free();
+      unlink(AVRC_PEER_VERSION_CONF_FILE);
+      AlarmTestHarness::TearDown();
+    }
+
+    std::vector<peer_ver_record> read_records() {
+      std::vector<peer_ver_record> records;
+      peer_ver_record record;
+
+      FILE *fp = fopen(AVRC_PEER_VERSION_CONF_FILE, "rb");
+      if (!fp)
+        return records;
+      while (fread(&record, sizeof(record), 1, fp) == 1)
+        records.push_back(record);
+      fclose(fp);
+      return records;
+    }
+
+    void write_record(const BD_ADDR addr, int ver) {
+      peer_ver_record record;
+      memset(&record, 0, sizeof(record));
+      record.ver = ver;
+      memcpy(record.addr, addr, sizeof(record.addr));
+
+      FILE *fp = fopen(AVRC_PEER_VERSION_CONF_FILE, "ab");
+      ASSERT_TRUE(fp != NULL);
+      ASSERT_EQ(1u, fwrite(&record, sizeof(record), 1, fp));
+      fclose(fp);
+    }
+};
+
+TEST_F(SdpPeerVerTest, test_store_and_lookup_by_oui) {
+  sdp_peer_ver_init();
+  EXPECT_EQ(AVRC_REV_INVALID, sdp_get_stored_avrc_tg_version(PEER_A));
+
+  EXPECT_TRUE(SDP_StoreAvrcTgVersion(PEER_A, AVRC_REV_1_4));
+  EXPECT_EQ(AVRC_REV_1_4, sdp_get_stored_avrc_tg_version(PEER_A));
+  EXPECT_EQ(AVRC_REV_1_4, sdp_get_stored_avrc_tg_version(PEER_A_OTHER_NAP));
+  EXPECT_EQ(AVRC_REV_INVALID, sdp_get_stored_avrc_tg_version(PEER_B));
+
+  // The first version recorded for an OUI is kept.
+  EXPECT_FALSE(SDP_StoreAvrcTgVersion(PEER_A_OTHER_NAP, AVRC_REV_1_6));
+  EXPECT_EQ(AVRC_REV_1_4, sdp_get_stored_avrc_tg_version(PEER_A));
+}
+
+TEST_F(SdpPeerVerTest, test_free_writes_pending_records) {
+  sdp_peer_ver_init();
+  EXPECT_TRUE(SDP_StoreAvrcTgVersion(PEER_A, AVRC_REV_1_4));
+  EXPECT_TRUE(SDP_StoreAvrcTgVersion(PEER_B, AVRC_REV_1_6));
+
+  sdp_peer_ver_free();
+
+  std::vector<peer_ver_record> records = read_records();
+  ASSERT_EQ(2u, records.size());
+  EXPECT_EQ(AVRC_REV_1_4, records[0].ver);
+  EXPECT_EQ(0, memcmp(PEER_A, records[0].addr, 3));
+  EXPECT_EQ(AVRC_REV_1_6, records[1].ver);
+  EXPECT_EQ(0, memcmp(PEER_B, records[1].addr, 3));
+
+  // A later start of the stack finds them in the file.
+  sdp_peer_ver_init();
+  EXPECT_EQ(AVRC_REV_1_4, sdp_get_stored_avrc_tg_version(PEER_A));
+  EXPECT_EQ(AVRC_REV_1_6, sdp_get_stored_avrc_tg_version(PEER_B));
+}
+
+TEST_F(SdpPeerVerTest, test_free_without_pending_records) {
+  sdp_peer_ver_init();
+  sdp_peer_ver_free();
+
+  EXPECT_NE(0, access(AVRC_PEER_VERSION_CONF_FILE, F_OK));
+}
+
+TEST_F(SdpPeerVerTest, test_load_keeps_first_record_of_oui) {
+  write_record(PEER_A, AVRC_REV_1_3);
+  write_record(PEER_A_OTHER_NAP, AVRC_REV_1_6);
+  write_record(PEER_B, AVRC_REV_1_5);
+
+  sdp_peer_ver_init();
+  EXPECT_EQ(AVRC_REV_1_3, sdp_get_stored_avrc_tg_version(PEER_A));
+  EXPECT_EQ(AVRC_REV_1_5, sdp_get_stored_avrc_tg_version(PEER_B));
+
+  // Records that are already in the file are not appended again.
+  sdp_peer_ver_free();
+  EXPECT_EQ(3u, read_records().size());
+}
+
+TEST_F(SdpPeerVerTest, test_quirk_cached_per_peer) {
+  BOOLEAN applies = FALSE;
+
+  EXPECT_FALSE(sdp_peer_quirk_get(PEER_A, SDP_PEER_QUIRK_HFP_1_7, &applies));
+
+  sdp_peer_quirk_set(PEER_A, SDP_PEER_QUIRK_HFP_1_7, TRUE);
+  sdp_peer_quirk_set(PEER_B, SDP_PEER_QUIRK_HFP_1_7, FALSE);
+
+  ASSERT_TRUE(sdp_peer_quirk_get(PEER_A, SDP_PEER_QUIRK_HFP_1_7, &applies));
+  EXPECT_TRUE(applies);
+  ASSERT_TRUE(sdp_peer_quirk_get(PEER_B, SDP_PEER_QUIRK_HFP_1_7, &applies));
+  EXPECT_FALSE(applies);
+
+  // Quirks are cached for the full address, not the OUI.
+  EXPECT_FALSE(sdp_peer_quirk_get(PEER_A_OTHER_NAP, SDP_PEER_QUIRK_HFP_1_7, &applies));
+
+  sdp_peer_quirk_clear(PEER_A);
+  EXPECT_FALSE(sdp_peer_quirk_get(PEER_A, SDP_PEER_QUIRK_HFP_1_7, &applies));
+  EXPECT_TRUE(sdp_peer_quirk_get(PEER_B, SDP_PEER_QUIRK_HFP_1_7, &applies));
+}
+
+TEST_F(SdpPeerVerTest, test_quirk_cache_drops_oldest_peer) {
+  BD_ADDR addr = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  BOOLEAN applies;
+
+  for (int i = 0; i <= SDP_MAX_CONNECTIONS; i++) {
+    addr[5] = i;
+    sdp_peer_quirk_set(addr, SDP_PEER_QUIRK_HFP_1_7, TRUE);
+  }
+
+  addr[5] = 0;
+  EXPECT_FALSE(sdp_peer_quirk_get(addr, SDP_PEER_QUIRK_HFP_1_7, &applies));
+  for (int i = 1; i <= SDP_MAX_CONNECTIONS; i++) {
+    addr[5] = i;
+    EXPECT_TRUE(sdp_peer_quirk_get(addr, SDP_PEER_QUIRK_HFP_1_7, &applies));
+  }
+}
@@ -0,0 +1,163 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack_test_stubs.h"
+
+extern "C" {
+#include "btm_int.h"
+#include "gatt_int.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+#include "sdpint.h"
+#include "osi/include/allocator.h"
+#include "osi/include/osi.h"
+}
+
+std::vector<l2cap_sent_pdu> l2cap_sent;
+std::vector<uint8_t> l2cap_write_results;
+std::vector<gatt_ended_op> gatt_ended;
+std::vector<uint16_t> gatt_rsp_timers;
+std::vector<vsc_sent_cmd> vsc_sent;
+
+void stack_test_stubs_reset(void) {
+  l2cap_sent.clear();
+  l2cap_write_results.clear();
+  gatt_ended.clear();
+  gatt_rsp_timers.clear();
+  vsc_sent.clear();
+}
+
+static uint8_t l2cap_write(uint16_t cid, BT_HDR *p_buf) {
+  l2cap_sent_pdu pdu;
+  pdu.cid = cid;
+  const uint8_t *data = (const uint8_t *)(p_buf + 1) + p_buf->offset;
+  pdu.data.assign(data, data + p_buf->len);
+  l2cap_sent.push_back(pdu);
+
+  // L2CAP owns the buffer whatever the result.
+  osi_free(p_buf);
+
+  if (l2cap_write_results.empty())
+    return L2CAP_DW_SUCCESS;
+  uint8_t result = l2cap_write_results.front();
+  l2cap_write_results.erase(l2cap_write_results.begin());
+  return result;
+}
+
+extern "C" {
+
+tBTM_CB btm_cb;
+tGATT_CB gatt_cb;
+tSDP_CB sdp_cb;
+
+void LogMsg(UNUSED_ATTR UINT32 trace_set_mask, UNUSED_ATTR const char *fmt_str, ...) {}
+void vnd_LogMsg(UNUSED_ATTR UINT32 trace_set_mask, UNUSED_ATTR const char *fmt_str, ...) {}
+
+tBTM_STATUS BTM_VendorSpecificCommand(UINT16 opcode, UINT8 param_len,
+                                      UINT8 *p_param_buf, tBTM_VSC_CMPL_CB *p_cb) {
+  vsc_sent_cmd cmd;
+  cmd.opcode = opcode;
+  cmd.params.assign(p_param_buf, p_param_buf + param_len);
+  cmd.p_cb = p_cb;
+  vsc_sent.push_back(cmd);
+  return BTM_CMD_STARTED;
+}
+
+UINT16 L2CA_SendFixedChnlData(UINT16 fixed_cid, UNUSED_ATTR BD_ADDR rem_bda, BT_HDR *p_buf) {
+  return l2cap_write(fixed_cid, p_buf);
+}
+
+UINT8 L2CA_DataWrite(UINT16 cid, BT_HDR *p_data) {
+  return l2cap_write(cid, p_data);
+}
+
+UINT8 gatt_build_uuid_to_stream(UNUSED_ATTR UINT8 **p_dst, UNUSED_ATTR tBT_UUID uuid) {
+  return 0;
+}
+
+BOOLEAN gatt_cmd_enq(UNUSED_ATTR tGATT_TCB *p_tcb, UNUSED_ATTR UINT16 clcb_idx,
+                     UNUSED_ATTR BOOLEAN to_send, UNUSED_ATTR UINT8 op_code,
+                     UNUSED_ATTR BT_HDR *p_buf) {
+  return FALSE;
+}
+
+void gatt_start_rsp_timer(UINT16 clcb_idx) {
+  gatt_rsp_timers.push_back(clcb_idx);
+}
+
+void gatt_start_ind_ack_timer(UNUSED_ATTR tGATT_TCB *p_tcb) {}
+
+tGATT_CLCB *gatt_cmd_dequeue(tGATT_TCB *p_tcb, UINT8 *p_op_code) {
+  tGATT_CMD_Q *p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+
+  if (p_tcb->pending_cl_req == p_tcb->next_slot_inq)
+    return NULL;
+
+  *p_op_code = p_cmd->op_code;
+  p_tcb->pending_cl_req = (p_tcb->pending_cl_req + 1) % GATT_CL_MAX_LCB;
+  return &gatt_cb.clcb[p_cmd->clcb_idx];
+}
+
+void gatt_end_operation(tGATT_CLCB *p_clcb, tGATT_STATUS status,
+                        UNUSED_ATTR void *p_data) {
+  gatt_ended_op op;
+  op.clcb_idx = p_clcb->clcb_idx;
+  op.status = status;
+  gatt_ended.push_back(op);
+}
+
+tGATT_NOTIF_SUB *gatt_find_notif_sub(UNUSED_ATTR BD_ADDR peer_bda,
+                                     UNUSED_ATTR UINT16 handle) {
+  return NULL;
+}
+
+tGATT_STATUS gatt_get_link_encrypt_status(UNUSED_ATTR tGATT_TCB *p_tcb) {
+  return GATT_NOT_ENCRYPTED;
+}
+
+BOOLEAN gatt_parse_uuid_from_cmd(UNUSED_ATTR tBT_UUID *p_uuid,
+                                 UNUSED_ATTR UINT16 len,
+                                 UNUSED_ATTR UINT8 **p_data) {
+  return FALSE;
+}
+
+UINT8 gatt_send_write_msg(UNUSED_ATTR tGATT_TCB *p_tcb,
+                          UNUSED_ATTR UINT16 clcb_idx,
+                          UNUSED_ATTR UINT8 op_code,
+                          UNUSED_ATTR UINT16 handle, UNUSED_ATTR UINT16 len,
+                          UNUSED_ATTR UINT16 offset,
+                          UNUSED_ATTR UINT8 *p_data) {
+  return GATT_INTERNAL_ERROR;
+}
+
+BOOLEAN gatt_uuid_compare(UNUSED_ATTR tBT_UUID src, UNUSED_ATTR tBT_UUID tar) {
+  return FALSE;
+}
+
+void gatt_convert_uuid32_to_uuid128(UNUSED_ATTR UINT8 uuid_128[LEN_UUID_128],
+                                    UNUSED_ATTR UINT32 uuid_32) {}
+
+UINT8 *gatt_dbg_op_name(UNUSED_ATTR UINT8 op_code) {
+  return (UINT8 *)"";
+}
+
+void l2cble_set_fixed_channel_tx_data_length(UNUSED_ATTR BD_ADDR remote_bda,
+                                             UNUSED_ATTR UINT16 fix_cid,
+                                             UNUSED_ATTR UINT16 tx_mtu) {}
+
+}
@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+// Stand-ins for the stack functions that the units under test call outside
+// of themselves, with the state the tests inspect.
+
+#include <stdint.h>
+#include <vector>
+
+extern "C" {
+#include "bt_types.h"
+#include "btm_api.h"
+}
+
+// One PDU handed to L2CAP.
+struct l2cap_sent_pdu {
+  uint16_t cid;
+  std::vector<uint8_t> data;
+};
+
+// Every PDU passed to L2CA_SendFixedChnlData or L2CA_DataWrite, in order.
+extern std::vector<l2cap_sent_pdu> l2cap_sent;
+
+// Return codes for the next L2CAP writes, consumed in order. Once empty,
+// writes return L2CAP_DW_SUCCESS.
+extern std::vector<uint8_t> l2cap_write_results;
+
+// One call of gatt_end_operation.
+struct gatt_ended_op {
+  uint16_t clcb_idx;
+  uint8_t status;
+};
+
+// Every operation ended through gatt_end_operation, in order.
+extern std::vector<gatt_ended_op> gatt_ended;
+
+// The clcb index of every gatt_start_rsp_timer call, in order.
+extern std::vector<uint16_t> gatt_rsp_timers;
+
+// One command passed to BTM_VendorSpecificCommand.
+struct vsc_sent_cmd {
+  uint16_t opcode;
+  std::vector<uint8_t> params;
+  tBTM_VSC_CMPL_CB *p_cb;
+};
+
+// Every vendor specific command issued, in order.
+extern std::vector<vsc_sent_cmd> vsc_sent;
+
+// Clears the recorded state of all stubs.
+void stack_test_stubs_reset(void);
@@ -0,0 +1,21 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    config_bench.c
+
+LOCAL_C_INCLUDES += . \
+    $(LOCAL_PATH)/../../ \
+    $(bluetooth_C_INCLUDES)
+
+LOCAL_CFLAGS += $(bluetooth_CFLAGS)
+LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
+LOCAL_MODULE_PATH := $(TARGET_OUT_EXECUTABLES)
+LOCAL_MODULE_TAGS := debug optional
+LOCAL_MODULE:= config_bench
+
+LOCAL_SHARED_LIBRARIES += libc liblog libcutils
+LOCAL_STATIC_LIBRARIES += libosi
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,215 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Benchmark for osi/config with a btif_config shaped file: one section per
+// device, each holding the keys btif_config and btif_storage write for a
+// bonded (or merely seen) device. Times the operations btif does on it:
+//
+//   build:    config_set_string for every key, as during discovery/bonding.
+//   save:     config_save of the whole file.
+//   load:     config_new of the saved file, as at startup.
+//   lookup:   reads every key of every device, the way
+//             btif_storage_load_bonded_devices walks the config.
+//   unpaired: finds and removes the devices without a link key, the way
+//             btif_config_remove_unpaired does.
+//   clone:    config_new_clone, as taken for every snapshot save.
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osi/include/config.h"
+
+static const int DEFAULT_SECTIONS = 1000;
+static const int DEFAULT_ROUNDS = 10;
+static const char *DEFAULT_FILE = "/data/local/tmp/config_bench.conf";
+
+static const char *DEVICE_KEYS[] = {
+  "Name", "Timestamp", "DevClass", "DevType", "AddrType", "Manufacturer",
+  "LmpVer", "LmpSubVer", "Service", "LinkKeyType", "PinLength", "LinkKey",
+  "LE_KEY_PENC", "LE_KEY_PID", "LE_KEY_PCSRK", "LE_KEY_LENC", "LE_KEY_LCSRK",
+  "LE_KEY_LID", "HidAttrMask", "HidSubClass", "HidAppId", "HidVendorId",
+  "HidProductId", "HidVersion", "HidCountryCode", "HidSSRMaxLatency",
+  "HidSSRMinTimeout", "HidDescriptor", "Restricted", "SdpDiVendorId",
+  "SdpDiProductId", "SdpDiVersion", "SdpDiVendorIdSource", "AvrcpCtVersion",
+  "AvrcpFeatures", "Appearance", "SmpPairingKeySize", "DeviceIdVersion",
+};
+
+static const size_t NUM_DEVICE_KEYS = sizeof(DEVICE_KEYS) / sizeof(DEVICE_KEYS[0]);
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void device_name(int index, char *buf, size_t len) {
+  snprintf(buf, len, "%02x:%02x:%02x:%02x:%02x:%02x", 0x00, 0x1a, 0x7d,
+           (index >> 16) & 0xff, (index >> 8) & 0xff, index & 0xff);
+}
+
+// Every other device is bonded and has the full set of keys; the rest were
+// only seen during discovery and have the first few.
+static size_t device_keys(int index) {
+  return (index % 2) ? NUM_DEVICE_KEYS : 9;
+}
+
+static config_t *build(int num_sections) {
+  config_t *config = config_new_empty();
+  config_set_string(config, "Info", "FileSource", "Empty");
+  config_set_string(config, "Adapter", "Address", "00:1a:7d:da:71:13");
+
+  char section[18];
+  char value[64];
+  for (int i = 0; i < num_sections; ++i) {
+    device_name(i, section, sizeof(section));
+    for (size_t k = 0; k < device_keys(i); ++k) {
+      snprintf(value, sizeof(value), "%08x%08x", i, (unsigned)k * 2654435761u);
+      config_set_string(config, section, DEVICE_KEYS[k], value);
+    }
+  }
+
+  return config;
+}
+
+static size_t lookup(const config_t *config, int num_sections) {
+  size_t bytes = 0;
+  char section[18];
+  for (int i = 0; i < num_sections; ++i) {
+    device_name(i, section, sizeof(section));
+    for (size_t k = 0; k < NUM_DEVICE_KEYS; ++k) {
+      const char *value = config_get_string(config, section, DEVICE_KEYS[k], NULL);
+      if (value)
+        bytes += strlen(value);
+    }
+  }
+  return bytes;
+}
+
+static int remove_unpaired(config_t *config) {
+  int removed = 0;
+  const config_section_node_t *snode = config_section_begin(config);
+  while (snode != config_section_end(config)) {
+    const char *section = config_section_name(snode);
+    snode = config_section_next(snode);
+    if (strlen(section) != 17)
+      continue;
+    if (!config_has_key(config, section, "LinkKey") &&
+        !config_has_key(config, section, "LE_KEY_PENC")) {
+      config_remove_section(config, section);
+      ++removed;
+    }
+  }
+  return removed;
+}
+
+static void report(const char *name, uint64_t ns, int rounds, int num_sections) {
+  printf("%-9s %9.3f ms  %8.1f ns/section\n", name, ns / 1e6 / rounds,
+         (double)ns / rounds / num_sections);
+}
+
+static void usage(const char *name) {
+  printf("Usage: %s [-n sections] [-r rounds] [-f file]\n", name);
+  printf("  defaults: -n %d -r %d -f %s\n", DEFAULT_SECTIONS, DEFAULT_ROUNDS,
+         DEFAULT_FILE);
+}
+
+int main(int argc, char *argv[]) {
+  int num_sections = DEFAULT_SECTIONS;
+  int rounds = DEFAULT_ROUNDS;
+  const char *filename = DEFAULT_FILE;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:r:f:")) != -1) {
+    switch (opt) {
+      case 'n': num_sections = atoi(optarg); break;
+      case 'r': rounds = atoi(optarg); break;
+      case 'f': filename = optarg; break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (num_sections <= 0 || rounds <= 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  printf("%d sections, %d keys per bonded device, %d rounds\n", num_sections,
+         (int)NUM_DEVICE_KEYS, rounds);
+
+  uint64_t build_ns = 0, save_ns = 0, load_ns = 0, lookup_ns = 0;
+  uint64_t unpaired_ns = 0, clone_ns = 0;
+  size_t bytes = 0;
+  int removed = 0;
+
+  for (int r = 0; r < rounds; ++r) {
+    uint64_t start = now_ns();
+    config_t *config = build(num_sections);
+    build_ns += now_ns() - start;
+
+    start = now_ns();
+    if (!config_save(config, filename)) {
+      printf("unable to save '%s'\n", filename);
+      config_free(config);
+      return 1;
+    }
+    save_ns += now_ns() - start;
+    config_free(config);
+
+    start = now_ns();
+    config = config_new(filename);
+    load_ns += now_ns() - start;
+    if (!config) {
+      printf("unable to load '%s'\n", filename);
+      return 1;
+    }
+
+    start = now_ns();
+    bytes += lookup(config, num_sections);
+    lookup_ns += now_ns() - start;
+
+    start = now_ns();
+    config_t *clone = config_new_clone(config);
+    clone_ns += now_ns() - start;
+    config_free(clone);
+
+    start = now_ns();
+    removed += remove_unpaired(config);
+    unpaired_ns += now_ns() - start;
+
+    config_free(config);
+  }
+
+  report("build", build_ns, rounds, num_sections);
+  report("save", save_ns, rounds, num_sections);
+  report("load", load_ns, rounds, num_sections);
+  report("lookup", lookup_ns, rounds, num_sections);
+  report("clone", clone_ns, rounds, num_sections);
+  report("unpaired", unpaired_ns, rounds, num_sections);
+  printf("%zu value bytes read, %d sections removed per round\n",
+         bytes / rounds, removed / rounds);
+
+  unlink(filename);
+  return 0;
+}
@@ -0,0 +1,25 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    scan_filter_bench.cpp \
+    ../../service/scan_filter_matcher.cpp \
+    ../../service/common/bluetooth/scan_filter.cpp \
+    ../../service/common/bluetooth/util/address_helper.cpp \
+    ../../service/common/bluetooth/uuid.cpp
+
+LOCAL_C_INCLUDES += . \
+    $(LOCAL_PATH)/../../ \
+    $(LOCAL_PATH)/../../service/common \
+    $(bluetooth_C_INCLUDES)
+
+LOCAL_CFLAGS += $(bluetooth_CFLAGS)
+LOCAL_CPPFLAGS += $(bluetooth_CPPFLAGS)
+LOCAL_MODULE_PATH := $(TARGET_OUT_EXECUTABLES)
+LOCAL_MODULE_TAGS := debug optional
+LOCAL_MODULE:= scan_filter_bench
+
+LOCAL_SHARED_LIBRARIES += libchrome
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,432 @@
+//
+//  Copyright (C) 2016 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Benchmark for the software scan filters LowEnergyClient applies to every
+// scan result. Replays a synthetic stream of advertising reports from a pool
+// of advertisers and runs it through:
+//
+//   copy:     no filtering, only the per report copies LowEnergyClient makes
+//             before handing a result to its delegate (the old behavior).
+//   linear:   a straightforward filter implementation that re-parses the
+//             report for every filter, the way ScanFilter is evaluated by
+//             the framework.
+//   compiled: ScanFilterMatcher, which LowEnergyClient uses.
+//
+// linear and compiled must agree on every report.
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "service/common/bluetooth/scan_filter.h"
+#include "service/scan_filter_matcher.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/hcidefs.h"
+
+using bluetooth::ScanFilter;
+using bluetooth::ScanFilterMatcher;
+using bluetooth::UUID;
+
+namespace {
+
+const int kDefaultReports = 100000;
+const int kDefaultAdvertisers = 256;
+const int kDefaultFilters = 32;
+
+// Same as kScanRecordLength in service/low_energy_client.cpp.
+const size_t kScanRecordLength = 62;
+
+// The 16-bit service UUIDs and company IDs the synthetic advertisers use.
+const int kNumServiceUuids = 64;
+const int kNumCompanies = 16;
+
+struct Advertiser {
+  bt_bdaddr_t bda;
+  uint8_t record[kScanRecordLength];
+  size_t len;
+};
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+std::string AddressToString(const bt_bdaddr_t& bda) {
+  char buf[18];
+  snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
+           bda.address[0], bda.address[1], bda.address[2],
+           bda.address[3], bda.address[4], bda.address[5]);
+  return buf;
+}
+
+UUID ServiceUuid(int index) {
+  return UUID(UUID::UUID16Bit({{ 0x18, (uint8_t)index }}));
+}
+
+uint16_t CompanyId(int index) {
+  return 0x0100 + index;
+}
+
+size_t AddField(uint8_t* record, size_t len, uint8_t type,
+                const uint8_t* value, size_t value_len) {
+  if (len + value_len + 2 > kScanRecordLength)
+    return len;
+  record[len++] = value_len + 1;
+  record[len++] = type;
+  memcpy(record + len, value, value_len);
+  return len + value_len;
+}
+
+void SynthAdvertiser(int index, Advertiser* adv) {
+  for (size_t i = 0; i < sizeof(adv->bda.address); ++i)
+    adv->bda.address[i] = rand() & 0xff;
+
+  memset(adv->record, 0, sizeof(adv->record));
+  size_t len = 0;
+
+  const uint8_t flags = 0x06;
+  len = AddField(adv->record, len, HCI_EIR_FLAGS_TYPE, &flags, 1);
+
+  uint8_t uuids[6];
+  int num_uuids = 1 + rand() % 3;
+  int first_uuid = rand() % kNumServiceUuids;
+  for (int i = 0; i < num_uuids; ++i) {
+    uuids[i * 2] = (first_uuid + i) % kNumServiceUuids;
+    uuids[i * 2 + 1] = 0x18;
+  }
+  len = AddField(adv->record, len, HCI_EIR_COMPLETE_16BITS_UUID_TYPE, uuids,
+                 num_uuids * 2);
+
+  if (rand() % 2) {
+    uint8_t service_data[6] = { uuids[0], 0x18 };
+    for (int i = 2; i < 6; ++i)
+      service_data[i] = rand() & 0x0f;
+    len = AddField(adv->record, len, HCI_EIR_SERVICE_DATA_16BITS_UUID_TYPE,
+                   service_data, sizeof(service_data));
+  }
+
+  if (rand() % 2) {
+    uint16_t company = CompanyId(rand() % kNumCompanies);
+    uint8_t mfg_data[8] = { (uint8_t)company, (uint8_t)(company >> 8) };
+    for (int i = 2; i < 8; ++i)
+      mfg_data[i] = rand() & 0x0f;
+    len = AddField(adv->record, len, HCI_EIR_MANUFACTURER_SPECIFIC_TYPE,
+                   mfg_data, sizeof(mfg_data));
+  }
+
+  char name[16];
+  int name_len = snprintf(name, sizeof(name), "dev%d", index);
+  len = AddField(adv->record, len, HCI_EIR_COMPLETE_LOCAL_NAME_TYPE,
+                 (const uint8_t*)name, name_len);
+
+  adv->len = len;
+}
+
+// A mix of the filters apps typically register: a few known devices, a
+// handful of services, beacons by manufacturer data prefix.
+std::vector<ScanFilter> SynthFilters(const std::vector<Advertiser>& advs,
+                                     int num_filters) {
+  std::vector<ScanFilter> filters(num_filters);
+  for (int i = 0; i < num_filters; ++i) {
+    ScanFilter& filter = filters[i];
+    switch (i % 5) {
+      case 0: {
+        // Half of these point at advertisers that exist.
+        bt_bdaddr_t bda = advs[rand() % advs.size()].bda;
+        if (rand() % 2)
+          bda.address[5] ^= 0x5a;
+        filter.SetDeviceAddress(AddressToString(bda));
+        break;
+      }
+      case 1:
+        filter.SetServiceUuid(ServiceUuid(rand() % (kNumServiceUuids * 2)));
+        break;
+      case 2:
+        filter.SetServiceDataWithMask(
+            ServiceUuid(rand() % kNumServiceUuids),
+            { (uint8_t)(rand() & 0x0f), 0x00 }, { 0x0f, 0x00 });
+        break;
+      case 3:
+        filter.SetManufacturerDataWithMask(
+            CompanyId(rand() % (kNumCompanies * 2)),
+            { (uint8_t)(rand() & 0x0f) }, { 0x0f });
+        break;
+      case 4: {
+        char name[16];
+        snprintf(name, sizeof(name), "dev%d", rand() % (int)advs.size() * 2);
+        filter.set_device_name(name);
+        break;
+      }
+    }
+  }
+  return filters;
+}
+
+// The straightforward implementation: evaluate each filter on its own,
+// walking the record for every field and building UUID objects and strings.
+
+struct AdvField {
+  uint8_t type;
+  std::vector<uint8_t> value;
+};
+
+std::vector<AdvField> ParseRecord(const uint8_t* record, size_t len) {
+  std::vector<AdvField> fields;
+  for (size_t i = 0; i < len;) {
+    size_t field_len = record[i];
+    if (field_len == 0 || i + field_len >= len)
+      break;
+    AdvField field;
+    field.type = record[i + 1];
+    field.value.assign(record + i + 2, record + i + 1 + field_len);
+    fields.push_back(field);
+    i += field_len + 1;
+  }
+  return fields;
+}
+
+UUID UUIDFromLittleEndian(const uint8_t* data, size_t len) {
+  if (len == UUID::kNumBytes16)
+    return UUID(UUID::UUID16Bit({{ data[1], data[0] }}));
+  if (len == UUID::kNumBytes32)
+    return UUID(UUID::UUID32Bit({{ data[3], data[2], data[1], data[0] }}));
+  UUID::UUID128Bit bytes;
+  for (size_t i = 0; i < len; ++i)
+    bytes[len - i - 1] = data[i];
+  return UUID(bytes);
+}
+
+bool MaskedPrefix(const std::vector<uint8_t>& data,
+                  const std::vector<uint8_t>& mask,
+                  const std::vector<uint8_t>& value, size_t offset) {
+  if (value.size() < offset + data.size())
+    return false;
+  for (size_t i = 0; i < data.size(); ++i) {
+    if ((value[offset + i] & mask[i]) != (data[i] & mask[i]))
+      return false;
+  }
+  return true;
+}
+
+bool LinearMatchFilter(const ScanFilter& filter, const std::string& address,
+                       const uint8_t* record, size_t len) {
+  if (!filter.device_address().empty() && filter.device_address() != address)
+    return false;
+
+  std::vector<AdvField> fields = ParseRecord(record, len);
+
+  if (!filter.device_name().empty()) {
+    bool found = false;
+    for (const auto& field : fields) {
+      if ((field.type == HCI_EIR_COMPLETE_LOCAL_NAME_TYPE ||
+           field.type == HCI_EIR_SHORTENED_LOCAL_NAME_TYPE) &&
+          std::string(field.value.begin(), field.value.end()) ==
+              filter.device_name())
+        found = true;
+    }
+    if (!found)
+      return false;
+  }
+
+  if (filter.service_uuid()) {
+    UUID::UUID128Bit want = filter.service_uuid()->GetFullBigEndian();
+    UUID::UUID128Bit mask;
+    if (filter.service_uuid_mask())
+      mask = filter.service_uuid_mask()->GetFullBigEndian();
+    else
+      mask.fill(0xFF);
+    bool found = false;
+    for (const auto& field : fields) {
+      if (field.type != HCI_EIR_COMPLETE_16BITS_UUID_TYPE &&
+          field.type != HCI_EIR_MORE_16BITS_UUID_TYPE)
+        continue;
+      for (size_t i = 0; i + 2 <= field.value.size(); i += 2) {
+        UUID::UUID128Bit have =
+            UUIDFromLittleEndian(&field.value[i], 2).GetFullBigEndian();
+        bool equal = true;
+        for (size_t j = 0; j < have.size(); ++j)
+          equal &= (have[j] & mask[j]) == (want[j] & mask[j]);
+        found |= equal;
+      }
+    }
+    if (!found)
+      return false;
+  }
+
+  if (filter.service_data_uuid()) {
+    bool found = false;
+    for (const auto& field : fields) {
+      if (field.type != HCI_EIR_SERVICE_DATA_16BITS_UUID_TYPE ||
+          field.value.size() < 2)
+        continue;
+      if (UUIDFromLittleEndian(field.value.data(), 2) ==
+              *filter.service_data_uuid() &&
+          MaskedPrefix(filter.service_data(), filter.service_data_mask(),
+                       field.value, 2))
+        found = true;
+    }
+    if (!found)
+      return false;
+  }
+
+  if (filter.manufacturer_id() >= 0) {
+    bool found = false;
+    for (const auto& field : fields) {
+      if (field.type != HCI_EIR_MANUFACTURER_SPECIFIC_TYPE ||
+          field.value.size() < 2)
+        continue;
+      int id = field.value[0] | (field.value[1] << 8);
+      if (id == filter.manufacturer_id() &&
+          MaskedPrefix(filter.manufacturer_data(),
+                       filter.manufacturer_data_mask(), field.value, 2))
+        found = true;
+    }
+    if (!found)
+      return false;
+  }
+
+  return true;
+}
+
+bool LinearMatch(const std::vector<ScanFilter>& filters,
+                 const bt_bdaddr_t& bda, const uint8_t* record, size_t len) {
+  if (filters.empty())
+    return true;
+  std::string address = AddressToString(bda);
+  for (const auto& filter : filters) {
+    if (LinearMatchFilter(filter, address, record, len))
+      return true;
+  }
+  return false;
+}
+
+void Report(const char* name, uint64_t ns, int num_reports, int delivered) {
+  printf("%-9s %9.1f ms  %8.1f ns/report  %d delivered\n", name, ns / 1e6,
+         (double)ns / num_reports, delivered);
+}
+
+void Usage(const char* name) {
+  printf("Usage: %s [-n reports] [-a advertisers] [-f filters] [-s seed]\n",
+         name);
+  printf("  defaults: -n %d -a %d -f %d\n", kDefaultReports,
+         kDefaultAdvertisers, kDefaultFilters);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int num_reports = kDefaultReports;
+  int num_advertisers = kDefaultAdvertisers;
+  int num_filters = kDefaultFilters;
+  unsigned int seed = 1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:a:f:s:")) != -1) {
+    switch (opt) {
+      case 'n': num_reports = atoi(optarg); break;
+      case 'a': num_advertisers = atoi(optarg); break;
+      case 'f': num_filters = atoi(optarg); break;
+      case 's': seed = atoi(optarg); break;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (num_reports <= 0 || num_advertisers <= 0 || num_filters < 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  srand(seed);
+
+  std::vector<Advertiser> advs(num_advertisers);
+  for (int i = 0; i < num_advertisers; ++i)
+    SynthAdvertiser(i, &advs[i]);
+
+  std::vector<int> stream(num_reports);
+  for (auto& index : stream)
+    index = rand() % num_advertisers;
+
+  std::vector<ScanFilter> filters = SynthFilters(advs, num_filters);
+
+  printf("%d reports from %d advertisers, %d filters\n", num_reports,
+         num_advertisers, num_filters);
+
+  // Baseline: copy every report the way LowEnergyClient::ScanResultCallback
+  // does before calling the delegate.
+  size_t bytes = 0;
+  uint64_t start = NowNs();
+  for (int index : stream) {
+    const Advertiser& adv = advs[index];
+    std::vector<uint8_t> scan_record(adv.record, adv.record + adv.len);
+    std::string address = AddressToString(adv.bda);
+    bytes += scan_record.size() + address.size();
+  }
+  Report("copy", NowNs() - start, num_reports, num_reports);
+
+  int linear_delivered = 0;
+  std::vector<bool> linear_result(num_reports);
+  start = NowNs();
+  for (int i = 0; i < num_reports; ++i) {
+    const Advertiser& adv = advs[stream[i]];
+    linear_result[i] = LinearMatch(filters, adv.bda, adv.record, adv.len);
+    if (linear_result[i]) {
+      std::vector<uint8_t> scan_record(adv.record, adv.record + adv.len);
+      bytes += scan_record.size();
+      linear_delivered++;
+    }
+  }
+  Report("linear", NowNs() - start, num_reports, linear_delivered);
+
+  ScanFilterMatcher matcher;
+  start = NowNs();
+  matcher.Compile(filters);
+  uint64_t compile_ns = NowNs() - start;
+
+  int compiled_delivered = 0;
+  int mismatches = 0;
+  start = NowNs();
+  for (int i = 0; i < num_reports; ++i) {
+    const Advertiser& adv = advs[stream[i]];
+    bool match = matcher.Matches(adv.bda, adv.record, adv.len);
+    if (match) {
+      std::vector<uint8_t> scan_record(adv.record, adv.record + adv.len);
+      bytes += scan_record.size();
+      compiled_delivered++;
+    }
+    mismatches += (match != linear_result[i]);
+  }
+  Report("compiled", NowNs() - start, num_reports, compiled_delivered);
+  printf("compile   %9.1f us\n", compile_ns / 1e3);
+
+  // Keep the copies from being optimized away.
+  if (bytes == 0)
+    printf("\n");
+
+  if (mismatches) {
+    printf("FAIL: %d reports matched differently\n", mismatches);
+    return 1;
+  }
+
+  return 0;
+}
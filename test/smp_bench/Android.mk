@@ -0,0 +1,31 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    smp_bench.c \
+    ../../stack/smp/aes.c \
+    ../../stack/smp/smp_aes.c \
+    ../../stack/smp/p_256_ecc_ct.c \
+    ../../stack/smp/p_256_ecc_pp.c \
+    ../../stack/smp/p_256_curvepara.c \
+    ../../stack/smp/p_256_multprecision.c
+
+LOCAL_C_INCLUDES += . \
+    $(LOCAL_PATH)/../../stack/include \
+    $(LOCAL_PATH)/../../stack/smp \
+    $(LOCAL_PATH)/../../include \
+    $(LOCAL_PATH)/../../utils/include \
+    $(LOCAL_PATH)/../../ \
+    $(bluetooth_C_INCLUDES)
+
+LOCAL_CFLAGS += $(bluetooth_CFLAGS)
+LOCAL_CONLYFLAGS += $(bluetooth_CONLYFLAGS)
+LOCAL_MODULE_PATH := $(TARGET_OUT_EXECUTABLES)
+LOCAL_MODULE_TAGS := debug optional
+LOCAL_MODULE:= smp_bench
+
+LOCAL_SHARED_LIBRARIES += libc liblog libcutils
+LOCAL_STATIC_LIBRARIES += libosi
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,828 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2016 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/************************************************************************************
+ *
+ *  Filename:      smp_bench.c
+ *
+ *  Description:   Micro benchmarks for the SMP crypto paths used on every
+ *                 advertising report and link.
+ *
+ *                 kat: known answer tests (FIPS-197, SP 800-38A/B, and the
+ *                 Core spec ah() sample) against every AES implementation
+ *                 available on the CPU, and the P-256 debug key pair.
+ *
+ *                 aes, sign: block cipher and ATT signed write verification
+ *                 (AES-CMAC) throughput.
+ *
+ *                 p256: LE Secure Connections public key generation and
+ *                 DHKey latency, the constant time implementation against
+ *                 the original one.
+ *
+ *                 rpa: replays a stream of advertiser addresses and resolves
+ *                 each one against a set of bonded IRKs, the way BTM does for
+ *                 every report from a resolvable private address. The stream
+ *                 is either read from a file (one address per line, e.g. the
+ *                 advertiser addresses of the LE Advertising Reports in a
+ *                 btsnoop log) or synthesized.
+ *
+ ***********************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bt_target.h"
+#include "bt_types.h"
+#include "osi/include/allocator.h"
+#include "smp_api.h"
+#include "p_256_ecc_ct.h"
+#include "p_256_ecc_pp.h"
+
+/************************************************************************************
+**  Constants & Macros
+************************************************************************************/
+
+#define BENCH_DEFAULT_IRKS          BTM_SEC_MAX_DEVICE_RECORDS
+#define BENCH_DEFAULT_REPORTS       20000
+#define BENCH_DEFAULT_ADVERTISERS   64
+#define BENCH_RPA_CACHE_SIZE        BTM_BLE_RPA_CACHE_SIZE
+
+/************************************************************************************
+**  Local type definitions
+************************************************************************************/
+
+typedef struct
+{
+    BD_ADDR rpa;
+    int     match;      /* index of the resolving IRK, -1 for none */
+    int     in_use;
+} tBENCH_CACHE_ENTRY;
+
+typedef struct
+{
+    int         num_irk;
+    BT_OCTET16  *irk;
+    tSMP_KEY_SCHED **sched;
+
+    int         num_reports;
+    BD_ADDR     *report;
+} tBENCH_RPA;
+
+/************************************************************************************
+**  Helpers
+************************************************************************************/
+
+static UINT64 bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UINT64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_random(UINT8 *p, int len)
+{
+    for (int i = 0; i < len; i++)
+        p[i] = (UINT8)(rand() & 0xff);
+}
+
+/* generate an RPA from an IRK, as btm_gen_resolvable_private_addr does */
+static void bench_gen_rpa(tSMP_KEY_SCHED *p_sched, BD_ADDR rpa)
+{
+    UINT8 prand[3];
+    tSMP_ENC output;
+
+    bench_random(prand, sizeof(prand));
+    prand[2] = (prand[2] & 0x3f) | 0x40;
+
+    rpa[0] = prand[2];
+    rpa[1] = prand[1];
+    rpa[2] = prand[0];
+
+    SMP_EncryptSched(p_sched, prand, 3, &output);
+    rpa[5] = output.param_buf[0];
+    rpa[4] = output.param_buf[1];
+    rpa[3] = output.param_buf[2];
+}
+
+static int bench_parse_addr(const char *line, BD_ADDR addr)
+{
+    unsigned int b[BD_ADDR_LEN];
+
+    if (sscanf(line, "%02x:%02x:%02x:%02x:%02x:%02x",
+               &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != BD_ADDR_LEN)
+        return 0;
+
+    for (int i = 0; i < BD_ADDR_LEN; i++)
+        addr[i] = (UINT8)b[i];
+    return 1;
+}
+
+static int bench_load_reports(tBENCH_RPA *p_bench, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[128];
+    int size = 1024;
+
+    if (fp == NULL)
+    {
+        perror(path);
+        return 0;
+    }
+
+    p_bench->report = malloc(size * sizeof(BD_ADDR));
+    p_bench->num_reports = 0;
+    if (p_bench->report == NULL)
+    {
+        fclose(fp);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (line[0] == '#')
+            continue;
+
+        if (p_bench->num_reports == size)
+        {
+            BD_ADDR *p_report = realloc(p_bench->report, size * 2 * sizeof(BD_ADDR));
+            if (p_report == NULL)
+            {
+                printf("out of memory, using the first %d addresses\n", p_bench->num_reports);
+                break;
+            }
+            p_bench->report = p_report;
+            size *= 2;
+        }
+
+        if (bench_parse_addr(line, p_bench->report[p_bench->num_reports]))
+            p_bench->num_reports++;
+    }
+
+    fclose(fp);
+    return p_bench->num_reports;
+}
+
+/* a crowd of advertisers, a quarter of them bonded, each reporting many times */
+static void bench_synth_reports(tBENCH_RPA *p_bench, int num_reports, int num_adv)
+{
+    BD_ADDR *adv = osi_malloc(num_adv * sizeof(BD_ADDR));
+
+    for (int i = 0; i < num_adv; i++)
+    {
+        if ((i % 4) == 0)
+        {
+            bench_gen_rpa(p_bench->sched[rand() % p_bench->num_irk], adv[i]);
+        }
+        else
+        {
+            BT_OCTET16 irk;
+            bench_random(irk, sizeof(irk));
+            tSMP_KEY_SCHED *p_sched = SMP_KeySchedNew(irk);
+            bench_gen_rpa(p_sched, adv[i]);
+            SMP_KeySchedFree(p_sched);
+        }
+    }
+
+    p_bench->report = malloc(num_reports * sizeof(BD_ADDR));
+    p_bench->num_reports = num_reports;
+    for (int i = 0; i < num_reports; i++)
+        memcpy(p_bench->report[i], adv[rand() % num_adv], BD_ADDR_LEN);
+
+    osi_free(adv);
+}
+
+/************************************************************************************
+**  Resolvers
+************************************************************************************/
+
+/* what btm_ble_addr_resolvable() does: SMP_Encrypt for each bonded record */
+static int bench_resolve_per_record(tBENCH_RPA *p_bench, const BD_ADDR rpa, UINT32 *p_aes)
+{
+    UINT8 prand[3] = { rpa[2], rpa[1], rpa[0] };
+    UINT8 hash[3] = { rpa[5], rpa[4], rpa[3] };
+    tSMP_ENC output;
+
+    for (int i = 0; i < p_bench->num_irk; i++)
+    {
+        SMP_Encrypt(p_bench->irk[i], BT_OCTET16_LEN, prand, sizeof(prand), &output);
+        (*p_aes)++;
+
+        if (!memcmp(output.param_buf, hash, sizeof(hash)))
+            return i;
+    }
+    return -1;
+}
+
+static int bench_resolve_batch(tBENCH_RPA *p_bench, const BD_ADDR rpa, UINT32 *p_aes)
+{
+    UINT16 idx = SMP_ResolveRpaBatch(rpa, p_bench->sched, p_bench->num_irk, 0);
+
+    *p_aes += (idx < p_bench->num_irk) ? idx + 1 : p_bench->num_irk;
+    return (idx < p_bench->num_irk) ? idx : -1;
+}
+
+/************************************************************************************
+**  Benchmark
+************************************************************************************/
+
+static void bench_run_rpa(tBENCH_RPA *p_bench)
+{
+    tBENCH_CACHE_ENTRY cache[BENCH_RPA_CACHE_SIZE];
+    int next_entry = 0;
+    int *expect = osi_malloc(p_bench->num_reports * sizeof(int));
+    UINT32 aes_ops, hits, resolved = 0;
+    UINT64 start, elapsed;
+
+    /* per-record SMP_Encrypt */
+    aes_ops = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < p_bench->num_reports; i++)
+    {
+        expect[i] = bench_resolve_per_record(p_bench, p_bench->report[i], &aes_ops);
+        if (expect[i] >= 0)
+            resolved++;
+    }
+    elapsed = bench_now_ns() - start;
+    printf("%-20s %10.1f ns/report %8.2f AES/report (%u of %d resolved)\n",
+           "per-record", (double)elapsed / p_bench->num_reports,
+           (double)aes_ops / p_bench->num_reports, resolved, p_bench->num_reports);
+
+    /* expanded IRKs, one AES block per candidate */
+    aes_ops = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < p_bench->num_reports; i++)
+    {
+        if (bench_resolve_batch(p_bench, p_bench->report[i], &aes_ops) != expect[i])
+            printf("mismatch at report %d\n", i);
+    }
+    elapsed = bench_now_ns() - start;
+    printf("%-20s %10.1f ns/report %8.2f AES/report\n", "batch",
+           (double)elapsed / p_bench->num_reports,
+           (double)aes_ops / p_bench->num_reports);
+
+    /* expanded IRKs behind a positive/negative RPA cache */
+    memset(cache, 0, sizeof(cache));
+    aes_ops = 0;
+    hits = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < p_bench->num_reports; i++)
+    {
+        const UINT8 *rpa = p_bench->report[i];
+        int match = -2;
+
+        for (int j = 0; j < BENCH_RPA_CACHE_SIZE; j++)
+        {
+            if (cache[j].in_use && !memcmp(cache[j].rpa, rpa, BD_ADDR_LEN))
+            {
+                match = cache[j].match;
+                hits++;
+                break;
+            }
+        }
+
+        if (match == -2)
+        {
+            match = bench_resolve_batch(p_bench, rpa, &aes_ops);
+            memcpy(cache[next_entry].rpa, rpa, BD_ADDR_LEN);
+            cache[next_entry].match = match;
+            cache[next_entry].in_use = 1;
+            next_entry = (next_entry + 1) % BENCH_RPA_CACHE_SIZE;
+        }
+
+        if (match != expect[i])
+            printf("mismatch at report %d\n", i);
+    }
+    elapsed = bench_now_ns() - start;
+    printf("%-20s %10.1f ns/report %8.2f AES/report (%.1f%% cache hits)\n",
+           "batch+cache", (double)elapsed / p_bench->num_reports,
+           (double)aes_ops / p_bench->num_reports,
+           100.0 * hits / p_bench->num_reports);
+
+    osi_free(expect);
+}
+
+/************************************************************************************
+**  Known answer tests
+************************************************************************************/
+
+/* hex string in spec (MSB first) order to stack (LSB first) byte order */
+static int bench_hex_le(const char *hex, UINT8 *out)
+{
+    int len = strlen(hex) / 2;
+
+    for (int i = 0; i < len; i++)
+    {
+        unsigned int b;
+        sscanf(&hex[2 * i], "%02x", &b);
+        out[len - 1 - i] = (UINT8)b;
+    }
+    return len;
+}
+
+typedef struct
+{
+    const char *key;
+    const char *in;
+    const char *out;
+} tBENCH_KAT;
+
+/* FIPS-197 C.1 and SP 800-38A F.1.1 */
+static const tBENCH_KAT bench_aes_kat[] = {
+    { "000102030405060708090a0b0c0d0e0f", "00112233445566778899aabbccddeeff",
+      "69c4e0d86a7b0430d8cdb78070b4c55a" },
+    { "2b7e151628aed2a6abf7158809cf4f3c", "6bc1bee22e409f96e93d7e117393172a",
+      "3ad77bb40d7a3660a89ecaf32466ef97" },
+    { "2b7e151628aed2a6abf7158809cf4f3c", "ae2d8a571e03ac9c9eb76fac45af8e51",
+      "f5d3d58503b9699de785895a96fdbaaf" },
+};
+
+/* SP 800-38B D.1 / RFC 4493; the last one is the sample the stack carried
+ * in smp_cmac.c */
+static const tBENCH_KAT bench_cmac_kat[] = {
+    { "2b7e151628aed2a6abf7158809cf4f3c", "",
+      "bb1d6929e95937287fa37d129b756746" },
+    { "2b7e151628aed2a6abf7158809cf4f3c", "6bc1bee22e409f96e93d7e117393172a",
+      "070a16b46b4d4144f79bdd9dd04a287c" },
+    { "2b7e151628aed2a6abf7158809cf4f3c",
+      "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411",
+      "dfa66747de9ae63030ca32611497c827" },
+    { "2b7e151628aed2a6abf7158809cf4f3c",
+      "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+      "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710",
+      "51f0bebf7e3b9d92fc49741779363cfe" },
+};
+
+static int bench_run_kat_backend(void)
+{
+    UINT8 key[BT_OCTET16_LEN], in[64], expect[BT_OCTET16_LEN], mac[BT_OCTET16_LEN];
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(bench_aes_kat) / sizeof(bench_aes_kat[0]); i++)
+    {
+        tSMP_ENC output;
+
+        bench_hex_le(bench_aes_kat[i].key, key);
+        bench_hex_le(bench_aes_kat[i].in, in);
+        bench_hex_le(bench_aes_kat[i].out, expect);
+
+        tSMP_KEY_SCHED *p_sched = SMP_KeySchedNew(key);
+        SMP_EncryptSched(p_sched, in, BT_OCTET16_LEN, &output);
+        SMP_KeySchedFree(p_sched);
+
+        if (memcmp(output.param_buf, expect, BT_OCTET16_LEN))
+        {
+            printf("  AES vector %zu FAILED\n", i);
+            failed++;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(bench_cmac_kat) / sizeof(bench_cmac_kat[0]); i++)
+    {
+        int len;
+
+        bench_hex_le(bench_cmac_kat[i].key, key);
+        len = bench_hex_le(bench_cmac_kat[i].in, in);
+        bench_hex_le(bench_cmac_kat[i].out, expect);
+
+        /* twice: once expanding the key, once from the key cache */
+        for (int pass = 0; pass < 2; pass++)
+        {
+            memset(mac, 0, sizeof(mac));
+            SMP_AesCmac(key, in, len, BT_OCTET16_LEN, mac);
+            if (memcmp(mac, expect, BT_OCTET16_LEN))
+            {
+                printf("  CMAC vector %zu pass %d FAILED\n", i, pass);
+                failed++;
+            }
+        }
+    }
+
+    /* Core spec Vol 3 Part H D.7: ah(IRK, 0x708194) = 0x0dfbaa */
+    {
+        BD_ADDR rpa = {0x70, 0x81, 0x94, 0x0d, 0xfb, 0xaa};
+        tSMP_KEY_SCHED *p_sched[2];
+
+        bench_random(key, BT_OCTET16_LEN);
+        p_sched[0] = SMP_KeySchedNew(key);
+        bench_hex_le("ec0234a357c8ad05341010a60a397d9b", key);
+        p_sched[1] = SMP_KeySchedNew(key);
+
+        if (SMP_ResolveRpaBatch(rpa, p_sched, 2, 0) != 1)
+        {
+            printf("  ah() vector FAILED\n");
+            failed++;
+        }
+        SMP_KeySchedFree(p_sched[0]);
+        SMP_KeySchedFree(p_sched[1]);
+    }
+
+    SMP_AesClearKeyCache();
+    return failed;
+}
+
+/* Core spec Vol 3 Part H 2.3.5.6.1 debug key pair, and 2 * G */
+static const char *bench_p256_debug_priv =
+    "3f49f6d4a3c55f3874c9b3e3d2103f504aff607beb40b7995899b8a6cd3c1abd";
+static const char *bench_p256_debug_x =
+    "20b003d2f297be2c5e2c83a7e9f9a5b9eff49111acf4fddbcc0301480e359de6";
+static const char *bench_p256_debug_y =
+    "dc809c49652aeb6d63329abf5a52155c766345c28fed3024741c8ed01589d28b";
+static const char *bench_p256_2g_x =
+    "7cf27b188d034f7e8a52380304b51ac3c08969e277f21b35a60b48fc47669978";
+static const char *bench_p256_2g_y =
+    "07775510db8ed040293d9ac69f7430dbba7dade63ce982299e04b79d227873d1";
+
+#define BENCH_P256_COMPAT_KEYS  32
+
+/* k * G (px == NULL) or k * P with the original implementation; only usable
+ * where DWORD is 32 bit */
+static void bench_p256_old_mult(UINT8 *x, UINT8 *y, const UINT8 *px, const UINT8 *py,
+                                const UINT8 *k)
+{
+    Point p, q;
+    BT_OCTET32 key;
+
+    memset(&p, 0, sizeof(p));
+    memcpy(key, k, BT_OCTET32_LEN);
+    if (px == NULL)
+    {
+        p = curve_p256.G;
+    }
+    else
+    {
+        memcpy(p.x, px, BT_OCTET32_LEN);
+        memcpy(p.y, py, BT_OCTET32_LEN);
+    }
+    ECC_PointMult(&q, &p, (DWORD *)key, KEY_LENGTH_DWORDS_P256);
+    memcpy(x, q.x, BT_OCTET32_LEN);
+    memcpy(y, q.y, BT_OCTET32_LEN);
+}
+
+static int bench_run_kat_p256(void)
+{
+    BT_OCTET32 k, ex, ey, x, y, k2, x2, y2, dh1, dh2, tmp;
+    int failed = 0;
+
+    bench_hex_le(bench_p256_debug_priv, k);
+    bench_hex_le(bench_p256_debug_x, ex);
+    bench_hex_le(bench_p256_debug_y, ey);
+    ECC_BaseMult_Ct(x, y, k);
+    if (memcmp(x, ex, BT_OCTET32_LEN) || memcmp(y, ey, BT_OCTET32_LEN))
+    {
+        printf("  debug public key FAILED\n");
+        failed++;
+    }
+
+    memset(k2, 0, sizeof(k2));
+    k2[0] = 2;
+    bench_hex_le(bench_p256_2g_x, ex);
+    bench_hex_le(bench_p256_2g_y, ey);
+    ECC_BaseMult_Ct(x2, y2, k2);
+    if (memcmp(x2, ex, BT_OCTET32_LEN) || memcmp(y2, ey, BT_OCTET32_LEN))
+    {
+        printf("  2G FAILED\n");
+        failed++;
+    }
+
+    /* DHKey agreement between the debug key and a random one */
+    bench_random(k2, BT_OCTET32_LEN);
+    ECC_BaseMult_Ct(x2, y2, k2);
+    ECC_PointMult_Ct(dh1, tmp, x2, y2, k);
+    ECC_PointMult_Ct(dh2, tmp, x, y, k2);
+    if (memcmp(dh1, dh2, BT_OCTET32_LEN))
+    {
+        printf("  DHKey agreement FAILED\n");
+        failed++;
+    }
+
+    /* same results as the original implementation */
+    if (sizeof(DWORD) == 4)
+    {
+        for (int i = 0; i < BENCH_P256_COMPAT_KEYS; i++)
+        {
+            bench_random(k, BT_OCTET32_LEN);
+            ECC_BaseMult_Ct(x, y, k);
+            bench_p256_old_mult(ex, ey, NULL, NULL, k);
+            if (memcmp(x, ex, BT_OCTET32_LEN) || memcmp(y, ey, BT_OCTET32_LEN))
+            {
+                printf("  public key %d differs from p_256_ecc_pp FAILED\n", i);
+                failed++;
+            }
+
+            ECC_PointMult_Ct(dh1, tmp, x2, y2, k);
+            bench_p256_old_mult(dh2, tmp, x2, y2, k);
+            if (memcmp(dh1, dh2, BT_OCTET32_LEN))
+            {
+                printf("  DHKey %d differs from p_256_ecc_pp FAILED\n", i);
+                failed++;
+            }
+        }
+    }
+
+    return failed;
+}
+
+static int bench_run_kat(void)
+{
+    int failed = 0;
+
+    for (int sw = 1; sw >= 0; sw--)
+    {
+        SMP_AesForceSoftware(sw);
+        printf("%-10s ", SMP_AesBackend());
+        int f = bench_run_kat_backend();
+        printf("%s\n", f ? "FAILED" : "ok");
+        failed += f;
+    }
+
+    p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+    printf("%-10s ", "p256");
+    int f = bench_run_kat_p256();
+    printf("%s\n", f ? "FAILED" : "ok");
+    failed += f;
+
+    return failed ? 1 : 0;
+}
+
+/************************************************************************************
+**  Block and signed write throughput
+************************************************************************************/
+
+static void bench_run_aes(int iterations)
+{
+    BT_OCTET16 key;
+    UINT8 block[BT_OCTET16_LEN];
+    tSMP_ENC output;
+    UINT64 start;
+
+    bench_random(key, sizeof(key));
+    bench_random(block, sizeof(block));
+
+    for (int sw = 1; sw >= 0; sw--)
+    {
+        SMP_AesForceSoftware(sw);
+
+        tSMP_KEY_SCHED *p_sched = SMP_KeySchedNew(key);
+        start = bench_now_ns();
+        for (int i = 0; i < iterations; i++)
+        {
+            SMP_EncryptSched(p_sched, block, BT_OCTET16_LEN, &output);
+            block[0] ^= output.param_buf[0];
+        }
+        printf("%-10s %-24s %8.1f ns/op\n", SMP_AesBackend(), "block, expanded key",
+               (double)(bench_now_ns() - start) / iterations);
+        SMP_KeySchedFree(p_sched);
+
+        start = bench_now_ns();
+        for (int i = 0; i < iterations; i++)
+        {
+            p_sched = SMP_KeySchedNew(key);
+            SMP_EncryptSched(p_sched, block, BT_OCTET16_LEN, &output);
+            SMP_KeySchedFree(p_sched);
+            block[0] ^= output.param_buf[0];
+        }
+        printf("%-10s %-24s %8.1f ns/op\n", SMP_AesBackend(), "block, key expanded",
+               (double)(bench_now_ns() - start) / iterations);
+    }
+}
+
+/* ATT Signed Write Command: opcode, handle, value, sign counter; mac is 8 bytes */
+#define BENCH_SIGNED_WRITE_VALUE_LEN    20
+#define BENCH_SIGNED_WRITE_LEN          (1 + 2 + BENCH_SIGNED_WRITE_VALUE_LEN + 4)
+#define BENCH_CMAC_TLEN                 8
+
+static void bench_run_sign(int iterations)
+{
+    BT_OCTET16 csrk;
+    UINT8 pdu[BENCH_SIGNED_WRITE_LEN];
+    UINT8 expect[BENCH_CMAC_TLEN], mac[BENCH_CMAC_TLEN];
+    int bad = 0;
+    UINT64 start;
+
+    bench_random(csrk, sizeof(csrk));
+    bench_random(pdu, sizeof(pdu));
+    SMP_AesCmac(csrk, pdu, sizeof(pdu), BENCH_CMAC_TLEN, expect);
+
+    for (int sw = 1; sw >= 0; sw--)
+    {
+        SMP_AesForceSoftware(sw);
+
+        start = bench_now_ns();
+        for (int i = 0; i < iterations; i++)
+        {
+            SMP_AesCmac(csrk, pdu, sizeof(pdu), BENCH_CMAC_TLEN, mac);
+            bad += (memcmp(mac, expect, BENCH_CMAC_TLEN) != 0);
+        }
+        printf("%-10s %-24s %8.1f ns/op\n", SMP_AesBackend(), "verify, cached CSRK",
+               (double)(bench_now_ns() - start) / iterations);
+
+        start = bench_now_ns();
+        for (int i = 0; i < iterations; i++)
+        {
+            SMP_AesClearKeyCache();
+            SMP_AesCmac(csrk, pdu, sizeof(pdu), BENCH_CMAC_TLEN, mac);
+            bad += (memcmp(mac, expect, BENCH_CMAC_TLEN) != 0);
+        }
+        printf("%-10s %-24s %8.1f ns/op\n", SMP_AesBackend(), "verify, cold CSRK",
+               (double)(bench_now_ns() - start) / iterations);
+    }
+
+    if (bad)
+        printf("%d signatures did not verify\n", bad);
+}
+
+/************************************************************************************
+**  LE Secure Connections key generation and DHKey
+************************************************************************************/
+
+static void bench_run_p256(int iterations)
+{
+    BT_OCTET32 k, x, y, peer_x, peer_y, dhkey;
+    UINT64 start;
+
+    p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+    bench_random(k, BT_OCTET32_LEN);
+
+    start = bench_now_ns();
+    ECC_BaseMult_Ct(peer_x, peer_y, k);
+    printf("%-10s %-24s %8.1f us\n", "ct", "first keygen (table)",
+           (double)(bench_now_ns() - start) / 1000);
+
+    start = bench_now_ns();
+    for (int i = 0; i < iterations; i++)
+    {
+        k[0] ^= (UINT8)i;
+        ECC_BaseMult_Ct(x, y, k);
+    }
+    printf("%-10s %-24s %8.1f us/op\n", "ct", "public key",
+           (double)(bench_now_ns() - start) / iterations / 1000);
+
+    start = bench_now_ns();
+    for (int i = 0; i < iterations; i++)
+    {
+        k[0] ^= (UINT8)i;
+        ECC_PointMult_Ct(dhkey, y, peer_x, peer_y, k);
+    }
+    printf("%-10s %-24s %8.1f us/op\n", "ct", "DHKey",
+           (double)(bench_now_ns() - start) / iterations / 1000);
+
+    if (sizeof(DWORD) != 4)
+    {
+        printf("%-10s skipped, DWORD is not 32 bit on this target\n", "original");
+        return;
+    }
+
+    start = bench_now_ns();
+    for (int i = 0; i < iterations; i++)
+    {
+        k[0] ^= (UINT8)i;
+        bench_p256_old_mult(x, y, NULL, NULL, k);
+    }
+    printf("%-10s %-24s %8.1f us/op\n", "original", "public key",
+           (double)(bench_now_ns() - start) / iterations / 1000);
+
+    start = bench_now_ns();
+    for (int i = 0; i < iterations; i++)
+    {
+        k[0] ^= (UINT8)i;
+        bench_p256_old_mult(dhkey, y, peer_x, peer_y, k);
+    }
+    printf("%-10s %-24s %8.1f us/op\n", "original", "DHKey",
+           (double)(bench_now_ns() - start) / iterations / 1000);
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s kat\n", name);
+    printf("       %s aes [-n iterations]\n", name);
+    printf("       %s sign [-n iterations]\n", name);
+    printf("       %s p256 [-n iterations]\n", name);
+    printf("       %s rpa [-s] [-k num_irk] [-n num_reports] [-a num_advertisers] [-f replay_file]\n",
+           name);
+    printf("  -s  use the software AES implementation\n");
+}
+
+int main(int argc, char **argv)
+{
+    tBENCH_RPA bench;
+    int num_reports = BENCH_DEFAULT_REPORTS;
+    int num_adv = BENCH_DEFAULT_ADVERTISERS;
+    const char *path = NULL;
+    int opt;
+
+    if (argc < 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    srand(1);
+
+    if (!strcmp(argv[1], "kat"))
+        return bench_run_kat();
+
+    if (!strcmp(argv[1], "aes") || !strcmp(argv[1], "sign") || !strcmp(argv[1], "p256"))
+    {
+        int iterations = strcmp(argv[1], "p256") ? 100000 : 100;
+
+        optind = 2;
+        while ((opt = getopt(argc, argv, "n:")) != -1)
+        {
+            if (opt != 'n' || (iterations = atoi(optarg)) <= 0)
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        if (!strcmp(argv[1], "aes"))
+            bench_run_aes(iterations);
+        else if (!strcmp(argv[1], "sign"))
+            bench_run_sign(iterations);
+        else
+            bench_run_p256(iterations);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "rpa"))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    memset(&bench, 0, sizeof(bench));
+    bench.num_irk = BENCH_DEFAULT_IRKS;
+
+    optind = 2;
+    while ((opt = getopt(argc, argv, "sk:n:a:f:")) != -1)
+    {
+        switch (opt)
+        {
+            case 's': SMP_AesForceSoftware(TRUE); break;
+            case 'k': bench.num_irk = atoi(optarg); break;
+            case 'n': num_reports = atoi(optarg); break;
+            case 'a': num_adv = atoi(optarg); break;
+            case 'f': path = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (bench.num_irk <= 0 || num_reports <= 0 || num_adv <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bench.irk = osi_malloc(bench.num_irk * sizeof(BT_OCTET16));
+    bench.sched = osi_malloc(bench.num_irk * sizeof(tSMP_KEY_SCHED *));
+    for (int i = 0; i < bench.num_irk; i++)
+    {
+        bench_random(bench.irk[i], BT_OCTET16_LEN);
+        bench.sched[i] = SMP_KeySchedNew(bench.irk[i]);
+    }
+
+    if (path != NULL)
+    {
+        if (!bench_load_reports(&bench, path))
+        {
+            printf("no addresses in %s\n", path);
+            return 1;
+        }
+    }
+    else
+    {
+        bench_synth_reports(&bench, num_reports, num_adv);
+    }
+
+    printf("%d bonded IRKs, %d reports, %s AES\n", bench.num_irk, bench.num_reports,
+           SMP_AesBackend());
+    bench_run_rpa(&bench);
+
+    for (int i = 0; i < bench.num_irk; i++)
+        SMP_KeySchedFree(bench.sched[i]);
+    osi_free(bench.sched);
+    osi_free(bench.irk);
+    free(bench.report);
+
+    return 0;
+}